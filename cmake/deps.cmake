@@ -15,5 +15,8 @@ find_package(LibMagic REQUIRED)
 # LZMA is optional
 find_package(LibLZMA)
 
+# zstd is optional (faster decompression codec, requires LZMA)
+find_package(Zstd)
+
 # Freetype is optional (imgui has std_truetype)
 find_package(Freetype)
@@ -0,0 +1,58 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include "hydra_global.glsl"
+
+// FIXME: Cannot set a specific set number...
+hydra::descriptor_set(_, neam::hydra::shader_structs::mesh_manager_descriptor_set_t);
+
+/// \brief Return the mesh entry for a gpu mesh index (see mesh_manager::mesh_index_to_gpu_index)
+/// Index 0 (and out-of-bound indices) are an empty mesh
+mesh_entry_t mesh_manager_get_mesh(uint gpu_mesh_index)
+{
+  if (gpu_mesh_index >= mesh_manager_meshes.mesh_count) return mesh_manager_meshes.meshes[0];
+  return mesh_manager_meshes.meshes[gpu_mesh_index];
+}
+
+/// \brief Return the index in mesh.lods of the finest resident LOD that is not finer than lod_level
+/// (LOD level 0 being the finest LOD). Return ~0u if the mesh has no resident LOD.
+uint mesh_manager_select_lod(mesh_entry_t mesh, uint lod_level)
+{
+  if (mesh.resident_lod_count == 0) return ~0u;
+  const uint wanted = mesh.lod_count - min(lod_level, mesh.lod_count - 1) - 1;
+  return min(wanted, mesh.resident_lod_count - 1);
+}
+
+/// \brief Return the offset (in uint) in the arena of a vertex, given its vertex indirection entry
+uint mesh_manager_get_vertex_offset(mesh_entry_t mesh, uint vertex_indirection)
+{
+  const uint lod_index = vertex_indirection >> 24;
+  const uint vertex_index = vertex_indirection & 0xFFFFFF;
+  // vertex_data is: uvec4 position_tbn + u16vec4[4] data
+  return mesh.lods[lod_index].vertex_data_offset + vertex_index * 12;
+}
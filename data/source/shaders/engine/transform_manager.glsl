@@ -0,0 +1,47 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include "hydra_global.glsl"
+
+#include "std.glsl"
+
+// FIXME: Cannot set a specific set number...
+hydra::descriptor_set(_, neam::hydra::shader_structs::transform_manager_descriptor_set_t);
+
+/// \brief Return whether the slot (as returned by transform::get_world_transform_slot) is valid
+bool transform_manager_is_slot_valid(uint slot)
+{
+  return slot < transform_manager_transforms.transform_count;
+}
+
+/// \brief Return the (packed) world transform of a slot
+/// \warning Does not perform any check
+packed_transform_t transform_manager_get_transform(uint slot)
+{
+  return transform_manager_transforms.transforms[slot];
+}
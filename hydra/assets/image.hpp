@@ -36,19 +36,42 @@
 
 namespace neam::hydra::assets
 {
+  struct image_v0
+  {
+    glm::uvec3 size;
+    VkFormat format;
+
+    std::vector<id_t> mips;
+  };
+
   struct image : public resources::rle_data_asset<"image", image>
   {
     // handle versioning:
     static constexpr uint32_t min_supported_version = 0;
-    static constexpr uint32_t current_version = 0;
-    using version_list = ct::type_list< image >;
+    static constexpr uint32_t current_version = 1;
+    using version_list = ct::type_list< image_v0, image >;
 
     glm::uvec3 size;
     VkFormat format;
 
     std::vector<id_t> mips; // FIXME: is that necessary ?
+
+    // When true, the mips only contain the texels (no image_mip header), and can be read as raw resources directly into staging memory.
+    // The size of a mip is then max(1, size >> mip_level)
+    bool raw_mips = false;
+
+    static image migrate_from(image_v0&& v0)
+    {
+      return
+      {
+        .size = v0.size,
+        .format = v0.format,
+        .mips = std::move(v0.mips),
+      };
+    }
   };
 
+  /// \brief Mip of an image without raw_mips (images with raw_mips store the texels directly)
   struct image_mip : public resources::rle_data_asset<"mipmap", image_mip>
   {
     // handle versioning:
@@ -62,7 +85,7 @@ namespace neam::hydra::assets
   };
 }
 
-N_METADATA_STRUCT(neam::hydra::assets::image)
+N_METADATA_STRUCT(neam::hydra::assets::image_v0)
 {
   using member_list = neam::ct::type_list
   <
@@ -71,6 +94,16 @@ N_METADATA_STRUCT(neam::hydra::assets::image)
     N_MEMBER_DEF(mips)
   >;
 };
+N_METADATA_STRUCT(neam::hydra::assets::image)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(size),
+    N_MEMBER_DEF(format),
+    N_MEMBER_DEF(mips),
+    N_MEMBER_DEF(raw_mips)
+  >;
+};
 N_METADATA_STRUCT(neam::hydra::assets::image_mip)
 {
   using member_list = neam::ct::type_list
@@ -80,14 +80,37 @@ namespace neam::hydra::assets
 
   };
 
+  /// \brief Encoding of the buffers of a LOD
+  enum class static_mesh_lod_codec : uint32_t
+  {
+    // buffers are stored as-is
+    none,
+
+    // vertex_indirection_data is encoded with meshopt_encodeIndexSequence,
+    // vertex_data, meshlet_index_data, meshlet_data and meshlet_culling_data with meshopt_encodeVertexBuffer
+    // (using the size of their elements as the vertex size, 4 bytes for meshlet_index_data).
+    // lod_data is not encoded.
+    meshopt,
+  };
+
+  struct static_mesh_lod_v0
+  {
+    raw_data vertex_data;
+    raw_data vertex_indirection_data;
+    raw_data meshlet_index_data;
+    raw_data meshlet_data;
+    raw_data meshlet_culling_data;
+    raw_data lod_data;
+  };
+
   struct static_mesh_lod : public resources::rle_data_asset<"lod", static_mesh_lod>
   {
     // handle versioning:
     static constexpr uint32_t min_supported_version = 0;
-    static constexpr uint32_t current_version = 0;
-    using version_list = ct::type_list< static_mesh_lod >;
+    static constexpr uint32_t current_version = 1;
+    using version_list = ct::type_list< static_mesh_lod_v0, static_mesh_lod >;
 
-    // We only handle raw-data in this stage as it's way faster to decode (a single memcopy)
+    // We only handle raw-data in this stage as it's way faster to decode (a single memcopy, or a single meshopt decode)
     raw_data vertex_data;
     raw_data vertex_indirection_data;
     raw_data meshlet_index_data;
@@ -95,6 +118,27 @@ namespace neam::hydra::assets
     raw_data meshlet_culling_data;
     raw_data lod_data;
 
+    static_mesh_lod_codec codec = static_mesh_lod_codec::none;
+
+    // element count of the buffers (needed for decoding)
+    uint32_t vertex_count = 0;
+    uint32_t vertex_indirection_count = 0;
+    uint32_t meshlet_index_size = 0; // in bytes, always a multiple of 4
+    uint32_t meshlet_count = 0;
+
+    static static_mesh_lod migrate_from(static_mesh_lod_v0&& v0)
+    {
+      return
+      {
+        .vertex_data = std::move(v0.vertex_data),
+        .vertex_indirection_data = std::move(v0.vertex_indirection_data),
+        .meshlet_index_data = std::move(v0.meshlet_index_data),
+        .meshlet_data = std::move(v0.meshlet_data),
+        .meshlet_culling_data = std::move(v0.meshlet_culling_data),
+        .lod_data = std::move(v0.lod_data),
+      };
+    }
+
     /// \brief Return the total memory size (very close (~32bytes) to uncompressed asset size)
     size_t total_memory_size() const
     {
@@ -111,7 +155,10 @@ namespace neam::hydra::assets
     static constexpr uint32_t current_version = 0;
     using version_list = ct::type_list< static_mesh >;
 
-    std::vector<id_t> lods; // LOD resource ID
+    // LOD resource IDs, from the coarsest to the finest LOD.
+    // LODs only contain the vertices that are not in a coarser LOD, and reference them via the vertex indirection data
+    // (the top 8 bits of a vertex indirection entry being the index of the LOD in this vector)
+    std::vector<id_t> lods;
 
     glm::vec4 bounding_sphere; // xyz: center, w: radius
   };
@@ -121,9 +168,11 @@ N_METADATA_STRUCT(neam::hydra::assets::static_mesh)
 {
   using member_list = neam::ct::type_list
   <
+    N_MEMBER_DEF(lods),
+    N_MEMBER_DEF(bounding_sphere)
   >;
 };
-N_METADATA_STRUCT(neam::hydra::assets::static_mesh_lod)
+N_METADATA_STRUCT(neam::hydra::assets::static_mesh_lod_v0)
 {
   using member_list = neam::ct::type_list
   <
@@ -131,9 +180,27 @@ N_METADATA_STRUCT(neam::hydra::assets::static_mesh_lod)
     N_MEMBER_DEF(vertex_indirection_data),
     N_MEMBER_DEF(meshlet_index_data),
     N_MEMBER_DEF(meshlet_data),
+    N_MEMBER_DEF(meshlet_culling_data),
     N_MEMBER_DEF(lod_data)
   >;
 };
+N_METADATA_STRUCT(neam::hydra::assets::static_mesh_lod)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(vertex_data),
+    N_MEMBER_DEF(vertex_indirection_data),
+    N_MEMBER_DEF(meshlet_index_data),
+    N_MEMBER_DEF(meshlet_data),
+    N_MEMBER_DEF(meshlet_culling_data),
+    N_MEMBER_DEF(lod_data),
+    N_MEMBER_DEF(codec),
+    N_MEMBER_DEF(vertex_count),
+    N_MEMBER_DEF(vertex_indirection_count),
+    N_MEMBER_DEF(meshlet_index_size),
+    N_MEMBER_DEF(meshlet_count)
+  >;
+};
 N_METADATA_STRUCT(neam::hydra::assets::static_submesh)
 {
   using member_list = neam::ct::type_list
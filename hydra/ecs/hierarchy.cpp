@@ -47,8 +47,53 @@ namespace neam::hydra::ecs
       return nullptr;
     }
 
-    void hierarchy::update()
+    bool hierarchy::begin_update(bool incremental)
     {
+      // NOTE: the dirty flag must be cleared before the update, so that any change that happens
+      //       after this point will mark the entity for the next update
+      const bool is_subtree_dirty = dirty_subtree.exchange(false, std::memory_order_acq_rel);
+      if (!incremental)
+        return true;
+      return is_subtree_dirty || force_update;
+    }
+
+    hierarchy::~hierarchy()
+    {
+      // the parent might only hold a weak-ref to us: force it to be visited during the next incremental update
+      // so that the dead entry is removed from its children
+      mark_parents_subtree_dirty();
+    }
+
+    void hierarchy::mark_subtree_dirty()
+    {
+      // if the entity is already marked, its parents are also marked
+      if (dirty_subtree.exchange(true, std::memory_order_acq_rel))
+        return;
+      mark_parents_subtree_dirty();
+    }
+
+    void hierarchy::mark_parents_subtree_dirty()
+    {
+      // NOTE: can be called from any thread (concept providers are marked dirty during the tasked update):
+      //       parents are kept alive by a strong reference and are only accessed with their entity lock held
+      entity current = parent.generate_strong_reference();
+      while (current.is_valid())
+      {
+        entity next;
+        {
+          std::lock_guard _el(spinlock_shared_adapter::adapt(current.get_lock()));
+          hierarchy* const hc = current.get<hierarchy>();
+          if (hc == nullptr || hc->dirty_subtree.exchange(true, std::memory_order_acq_rel))
+            return;
+          next = hc->parent.generate_strong_reference();
+        }
+        current = std::move(next);
+      }
+    }
+
+    void hierarchy::update(bool incremental)
+    {
+      const bool is_forced = std::exchange(force_update, false);
       concepts::hierarchical* const hierarchical_con = get_unsafe<concepts::hierarchical>();
 
       // release any attached objects that are un-necessary anymore
@@ -107,8 +152,16 @@ namespace neam::hydra::ecs
       }
 
       // update the components
+      bool has_changed = !incremental;
       if (hierarchical_con)
-        hierarchical_con->update();
+        has_changed = hierarchical_con->update(incremental, is_forced) || has_changed;
+
+      // if anything changed, the whole subtree must be updated
+      if (incremental && (has_changed || is_forced))
+      {
+        for (hierarchy* it : children_hierarchy)
+          it->force_update = true;
+      }
 
       // lock any components that are remaining so that pointers are valid until next update
       if (hierarchical_con)
@@ -145,6 +198,11 @@ namespace neam::hydra::ecs
       update_children(update_queue, 0, children.size());
     }
 
+    void hierarchy::update_children(std::vector<components::hierarchy*>& update_queue)
+    {
+      update_queue.insert(update_queue.end(), children_hierarchy.begin(), children_hierarchy.end());
+    }
+
     bool hierarchy::update_children(std::deque<components::hierarchy*>& update_queue, uint32_t start, uint32_t count)
     {
       // queue children to the update queue:
@@ -197,6 +255,7 @@ namespace neam::hydra::ecs
           clear_child_for_removal(children[i]);
           children.erase(children.begin() + i);
           children_hierarchy.erase(children_hierarchy.begin() + i);
+          mark_subtree_dirty();
           return;
         }
       }
@@ -211,6 +270,7 @@ namespace neam::hydra::ecs
           clear_child_for_removal(children[i]);
           children.erase(children.begin() + i);
           children_hierarchy.erase(children_hierarchy.begin() + i);
+          mark_subtree_dirty();
           return;
         }
       }
@@ -242,6 +302,11 @@ namespace neam::hydra::ecs
         ptr->uni = uni;
         ptr->parent = create_entity_weak_reference_tracking();
         ptr->parent_id = self_id;
+
+        // the whole subtree of the new child must be updated:
+        ptr->force_update = true;
+        ptr->dirty_subtree.store(false, std::memory_order_release);
+        ptr->mark_subtree_dirty();
       }
       children_hierarchy.push_back(ptr);
       if (insert_weak_reference)
@@ -256,6 +321,7 @@ namespace neam::hydra::ecs
         clear_child_for_removal(children[i]);
       children.clear();
       children_hierarchy.clear();
+      mark_subtree_dirty();
     }
 
     void hierarchy::clear_child_for_removal(entity_storage_t& es)
@@ -323,6 +389,12 @@ namespace neam::hydra::ecs
       return false;
     }
 
+    void hierarchical::concept_logic::set_dirty()
+    {
+      last_update_token = 0;
+      get_concept().hierarchy_component.mark_subtree_dirty();
+    }
+
     void hierarchical::concept_logic::update_dirty_flag()
     {
       // update the parent (and overwrite the update token with the value from the parent)
@@ -355,20 +427,24 @@ namespace neam::hydra::ecs
       });
     }
 
-    void hierarchical::update()
+    bool hierarchical::update(bool incremental, bool forced)
     {
-      for_each_concept_provider([this](concept_logic& lg)
+      bool has_updated_any = false;
+      for_each_concept_provider([this, incremental, forced, &has_updated_any](concept_logic& lg)
       {
         lg.update_logic(hierarchy_component);
-        if (lg.is_dirty() || everything_is_dirty || true)
+        // NOTE: when not in incremental mode, everything is always updated
+        if (lg.is_dirty() || everything_is_dirty || forced || !incremental)
         {
           // must be first to allow the provider to set the dirty flag again in its update
           lg.update_dirty_flag();
 
           lg.update_provider();
+          has_updated_any = true;
         }
       });
       everything_is_dirty = false;
+      return has_updated_any;
     }
   }
 }
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <enfield/enfield.hpp>
 #include <enfield/concept/serializable.hpp>
 
@@ -87,6 +89,7 @@ namespace neam::hydra::ecs
       //          - optional: dispatch tasks to help with the update process (up-to a max number of update tasks)
       public:
         hierarchy(param_t p);
+        ~hierarchy();
 
         [[nodiscard]] entity_weak_ref create_parent_tracking_reference() const { return parent.duplicate_tracking_reference(); }
 
@@ -153,6 +156,22 @@ namespace neam::hydra::ecs
         bool is_universe_root() const { return uni != nullptr && !has_parent(); }
         bool is_orphaned() const { return uni == nullptr && !has_parent(); }
 
+        /// \brief Mark the entity (and all its parents) as having a dirty subtree
+        /// Needed for incremental updates (see universe::set_incremental_update) so that the entity is not skipped during the next update.
+        /// \note Automatically done when a hierarchical concept provider is dirty or when the hierarchy changes.
+        ///       Must be manually called after removing a hierarchical concept provider on an entity.
+        /// \note Thread-safe (each parent is locked while being marked), but the entity must not be re-parented concurrently
+        void mark_subtree_dirty();
+
+        /// \brief Return whether the entity or any of its children requires an update
+        bool has_dirty_subtree() const { return dirty_subtree.load(std::memory_order_acquire); }
+
+        /// \brief Return the position of the entity in the (breadth-first) update order
+        /// The index is the same for the single-threaded and the tasked update, and can be used to order operations
+        /// done by hierarchical concept providers running on different threads.
+        /// \note Only valid during (and after) the entity update
+        uint32_t get_update_index() const { return update_index; }
+
       private: // serialization
         void refresh_from_deserialization();
         internal::serialized_hierarchy get_data_to_serialize() const;
@@ -164,18 +183,27 @@ namespace neam::hydra::ecs
 
         const base_t* get_attached_object_in_parents(enfield::type_t type) const;
 
+        /// \brief Mark the parents of the entity (but not the entity itself) as having a dirty subtree
+        void mark_parents_subtree_dirty();
+
         static void clear_child_for_removal(entity_storage_t& es);
         static void clear_child_for_removal(entity& child);
 
+        /// \brief Return whether the entity needs to be updated (and clear its dirty state)
+        /// If false, the whole subtree can be skipped (update(), update_children() and end_update() must not be called)
+        /// \note Always returns true when not in incremental mode
+        bool begin_update(bool incremental);
+
         /// \brief Update the hierarchical components and perform some of the update process
         /// (does not perform any recusrion)
         /// \warning If called, children must be updated as well
-        void update();
+        void update(bool incremental = false);
 
         void update_children(universe::update_queue_t& update_queue);
         bool update_children(universe::update_queue_t& update_queue, uint32_t start, uint32_t count);
         void update_children(std::deque<components::hierarchy*>& update_queue);
         bool update_children(std::deque<components::hierarchy*>& update_queue, uint32_t start, uint32_t count);
+        void update_children(std::vector<components::hierarchy*>& update_queue);
 
         void end_update();
 
@@ -205,6 +233,14 @@ namespace neam::hydra::ecs
 
         std::mtc_vector<std::pair<enfield::type_t, base_t*>> attached_objects;
 
+        /// \brief Set if the entity or any of its children requires an update
+        std::atomic<bool> dirty_subtree = false;
+        /// \brief Set by the parent if it has changed during the current update (the whole subtree must be updated)
+        bool force_update = false;
+
+        /// \brief Position in the update order (see get_update_index())
+        uint32_t update_index = 0;
+
         friend serializable_t;
         friend universe;
         friend concepts::hierarchical;
@@ -225,7 +261,7 @@ namespace neam::hydra::ecs
         class concept_logic : public ecs_concept::base_concept_logic
         {
           protected:
-            concept_logic(typename ecs_concept::base_t& _base) : ecs_concept::base_concept_logic(_base) {}
+            concept_logic(typename ecs_concept::base_t& _base) : ecs_concept::base_concept_logic(_base) { set_dirty(); }
 
           public:
             /// \brief Return whether the component is dirty or not.
@@ -233,7 +269,7 @@ namespace neam::hydra::ecs
             ///       If false (the default), only check if the parent has a different state than this.
             bool is_dirty(bool recursive_check = false) const;
             /// \brief Force an update (and force an update of all children)
-            void set_dirty() { last_update_token = 0; }
+            void set_dirty();
 
           protected:
 
@@ -288,7 +324,7 @@ namespace neam::hydra::ecs
             {
               concept_logic* new_parent = hc.get<ConceptProvider>(false);
               if (parent != new_parent)
-                set_dirty();
+                last_update_token = 0;
               parent = new_parent;
             }
             void update_provider() final
@@ -325,8 +361,11 @@ namespace neam::hydra::ecs
       public:
         hierarchical(typename ecs_concept::param_t p) : ecs_concept(p) {}
 
-        void update();
-        void force_everything_dirty() { everything_is_dirty = true; }
+        /// \brief Update the concept providers
+        /// In incremental mode, only update the dirty providers (unless \param forced is true)
+        /// \return whether any concept provider was updated
+        bool update(bool incremental = false, bool forced = false);
+        void force_everything_dirty() { everything_is_dirty = true; hierarchy_component.mark_subtree_dirty(); }
 
         components::hierarchy& get_hierarchy_component() { return hierarchy_component; }
         const components::hierarchy& get_hierarchy_component() const { return hierarchy_component; }
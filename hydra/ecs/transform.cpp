@@ -95,15 +95,66 @@ namespace neam::hydra
 
   namespace ecs::components
   {
+    static bool has_changed(const hydra::transform& a, const hydra::transform& b)
+    {
+      return a.translation != b.translation || a.rotation != b.rotation || a.scale != b.scale;
+    }
+
     transform::transform(param_t p)
       : internal_component_t(p), serializable_t(*this), hierarchical_t(*this)
     {
     }
 
-    const hydra::transform& transform::get_world_to_parent_transform() const
+    transform::~transform()
+    {
+      release_store_entry();
+      release_listener_slot();
+    }
+
+    void transform::release_listener_slot()
+    {
+      if (listener != nullptr && listener_slot != world_transform_listener::k_invalid_slot)
+        listener->release_slot(listener_slot);
+      listener = nullptr;
+      listener_slot = world_transform_listener::k_invalid_slot;
+    }
+
+    bool transform::update_listener_slot(world_transform_listener* uni_listener)
+    {
+      if (listener == uni_listener && (listener == nullptr || listener_slot != world_transform_listener::k_invalid_slot))
+        return false;
+      release_listener_slot();
+      listener = uni_listener;
+      if (listener != nullptr)
+        listener_slot = listener->allocate_slot();
+      return true;
+    }
+
+    void transform::release_store_entry()
+    {
+      if (store != nullptr)
+        store->release(store_handle);
+      store = nullptr;
+    }
+
+    hydra::transform transform::get_local_to_world_transform() const
+    {
+      if (store != nullptr)
+        return store->get_world(store_handle);
+      return world_state;
+    }
+
+    hydra::transform transform::get_world_to_local_transform() const
+    {
+      if (store != nullptr)
+        return store->get_world_inverse(store_handle);
+      return world_state_inverse;
+    }
+
+    hydra::transform transform::get_world_to_parent_transform() const
     {
       if (const transform* parent = get_parent(); parent != nullptr)
-        return parent->world_state_inverse;
+        return parent->get_world_to_local_transform();
       return global_identity;
     }
 
@@ -111,12 +162,55 @@ namespace neam::hydra
     {
       local_state.rotation = glm::normalize(local_state.rotation);
 
+      universe* uni = get_universe();
+      const bool has_new_slot = update_listener_slot(uni != nullptr ? uni->get_world_transform_listener() : nullptr);
+      const bool has_slot = listener_slot != world_transform_listener::k_invalid_slot;
+
+      if (transform_store* uni_store = (uni != nullptr ? uni->get_transform_store() : nullptr); uni_store != nullptr)
+      {
+        // SoA path: the world transforms will be computed by the store at the end of the hierarchical update
+        const transform* parent = get_parent();
+        const transform_store::handle_t parent_handle = (parent != nullptr && parent->store == uni_store) ? parent->store_handle : transform_store::handle_t{};
+        const uint32_t depth = parent_handle.is_valid() ? parent_handle.depth + 1 : 0;
+        if (store != uni_store || store_handle.depth != depth)
+        {
+          release_store_entry();
+          store = uni_store;
+          store_handle = store->allocate(depth);
+        }
+        store->set_local(store_handle, local_state, parent_handle);
+        // the listener will only be notified if the world transform changed (once computed by the store)
+        if (has_slot)
+          uni->_queue_world_transform_notification(*this, has_new_slot);
+        return;
+      }
+      // the universe does not have a store (anymore):
+      release_store_entry();
+
+      const hydra::transform previous_world_state = world_state;
       if (transform* parent = get_parent(); parent != nullptr)
         world_state = hydra::transform::multiply(parent->world_state, local_state);
       else
         world_state = local_state;
 
       world_state_inverse = hydra::transform::compute_inverse(world_state);
+
+      // only notify the listener of actual changes:
+      if (has_slot && (has_new_slot || has_changed(previous_world_state, world_state)))
+        listener->on_world_transform_changed(listener_slot, world_state);
+    }
+
+    void transform::_send_world_transform_notification(bool force)
+    {
+      if (store == nullptr || listener == nullptr || listener_slot == world_transform_listener::k_invalid_slot)
+        return;
+
+      const hydra::transform new_world_state = store->get_world(store_handle);
+      if (force || has_changed(world_state, new_world_state))
+      {
+        world_state = new_world_state;
+        listener->on_world_transform_changed(listener_slot, world_state);
+      }
     }
   }
 }
@@ -28,6 +28,8 @@
 
 #include "types.hpp"
 #include "hierarchy.hpp"
+#include "transform_store.hpp"
+#include "world_transform_listener.hpp"
 
 #include <hydra_glm.hpp>
 
@@ -86,6 +88,14 @@ namespace neam::hydra::ecs::components
   /// \note positions are in double, rotations, scales are in float
   ///       packed positions are (uint+unorm16)[3], packed scales are float3, rotations are unorm8[3] + packed-signs (uint8)
   ///
+  /// \note If the universe has a transform store, world transforms are stored (and computed) there.
+  ///       They are computed a whole level at a time by universe::finish_transform_update(), at the end of the hierarchical update.
+  /// \warning With a transform store, world transforms are only valid after universe::finish_transform_update():
+  ///          during the hierarchical update (in any update_from_hierarchy()), the world transforms returned are the ones of the previous update.
+  ///
+  /// \note If the universe has a world_transform_listener, the component is given a slot in it
+  ///       and the listener is notified every time the world transform changes.
+  ///
   /// \note If the local-transform is identity, this component is not needed and should be removed.
   ///       Entitites without transforms simply use the transform of their parent
   ///       Do not require<> this component, rather, require< hierarchy > and call
@@ -96,6 +106,7 @@ namespace neam::hydra::ecs::components
   {
     public:
       transform(param_t p);
+      ~transform();
 
       hydra::transform& update_local_transform() { set_dirty(); return local_state; }
       const hydra::transform& get_local_transform() const { return local_state; }
@@ -103,15 +114,29 @@ namespace neam::hydra::ecs::components
       /// \note if a parent is dirty, will not accound for the upcoming change.
       void set_local_position_from_world_position(glm::dvec3 _world_position);
 
-      const hydra::transform& get_local_to_world_transform() const { return world_state; }
-      const hydra::transform& get_world_to_local_transform() const { return world_state_inverse; }
+      /// \warning With a transform store, only valid after universe::finish_transform_update() (see the class notes)
+      hydra::transform get_local_to_world_transform() const;
+      hydra::transform get_world_to_local_transform() const;
 
       /// \brief yield a world to parent-local transform
       /// Usefull for gizmo and other manipulator, as it's an inverse transform that excludes the local state
-      const hydra::transform& get_world_to_parent_transform() const;
+      hydra::transform get_world_to_parent_transform() const;
+
+      /// \brief Return the slot given by the world_transform_listener of the universe
+      /// (world_transform_listener::k_invalid_slot if none)
+      /// \note Only valid after the first hierarchical update
+      uint32_t get_world_transform_slot() const { return listener_slot; }
+
+      /// \brief (internal) Send the world transform of the store entry to the listener, if it changed since the last notification (or if forced)
+      /// \note Called by the universe once the store has computed the world transforms
+      void _send_world_transform_notification(bool force);
 
     private: // hierarchical
       void update_from_hierarchy();
+      void release_store_entry();
+      /// \brief return whether the slot has changed
+      bool update_listener_slot(world_transform_listener* uni_listener);
+      void release_listener_slot();
 
     private: // serialization
       void refresh_from_deserialization()
@@ -128,6 +153,14 @@ namespace neam::hydra::ecs::components
       hydra::transform world_state_inverse;
       // FIXME: Store the local-inverse?
 
+      // only used when the universe has a transform store
+      // (world_state is then the last world transform sent to the listener, and world_state_inverse is unused)
+      transform_store* store = nullptr;
+      transform_store::handle_t store_handle;
+
+      world_transform_listener* listener = nullptr;
+      uint32_t listener_slot = world_transform_listener::k_invalid_slot;
+
       friend serializable_t;
       friend hierarchical_t;
   };
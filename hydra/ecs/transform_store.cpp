@@ -0,0 +1,278 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <ntools/tracy.hpp>
+
+#include "transform_store.hpp"
+#include "transform.hpp"
+
+#if N_HYDRA_TRANSFORM_STORE_AVX2
+  #include "transform_store_avx2.hpp"
+#endif
+
+namespace neam::hydra::ecs
+{
+  void transform_store::soa_transforms::resize(uint32_t count)
+  {
+    tx.resize(count, 0.0);
+    ty.resize(count, 0.0);
+    tz.resize(count, 0.0);
+    qx.resize(count, 0.0f);
+    qy.resize(count, 0.0f);
+    qz.resize(count, 0.0f);
+    qw.resize(count, 1.0f);
+    scale.resize(count, 1.0f);
+  }
+
+  void transform_store::soa_transforms::set(uint32_t index, const hydra::transform& tr)
+  {
+    tx[index] = tr.translation.x;
+    ty[index] = tr.translation.y;
+    tz[index] = tr.translation.z;
+    qx[index] = tr.rotation.x;
+    qy[index] = tr.rotation.y;
+    qz[index] = tr.rotation.z;
+    qw[index] = tr.rotation.w;
+    scale[index] = tr.scale;
+  }
+
+  hydra::transform transform_store::soa_transforms::get(uint32_t index) const
+  {
+    return
+    {
+      { tx[index], ty[index], tz[index] },
+      { qw[index], qx[index], qy[index], qz[index] },
+      scale[index],
+    };
+  }
+
+  transform_store::level_t& transform_store::get_level(uint32_t depth)
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(levels_lock)};
+    return levels[depth];
+  }
+
+  const transform_store::level_t& transform_store::get_level(uint32_t depth) const
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(levels_lock)};
+    return levels[depth];
+  }
+
+  uint32_t transform_store::get_depth_count() const
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(levels_lock)};
+    return (uint32_t)levels.size();
+  }
+
+  transform_store::handle_t transform_store::allocate(uint32_t depth)
+  {
+    {
+      std::lock_guard _l {spinlock_exclusive_adapter::adapt(levels_lock)};
+      check::debug::n_assert(depth <= levels.size(), "transform_store::allocate: cannot skip a level (depth: {}, level count: {})", depth, levels.size());
+      while (levels.size() <= depth)
+        levels.emplace_back();
+    }
+
+    level_t& level = get_level(depth);
+    std::lock_guard _l {spinlock_exclusive_adapter::adapt(level.lock)};
+    if (level.free_list.empty())
+    {
+      // grow the level (always keep the size a multiple of the lane count)
+      const uint32_t new_size = std::max(k_lane_count, level.size * 2);
+      level.local.resize(new_size);
+      level.world.resize(new_size);
+      level.world_inverse.resize(new_size);
+      level.parent_index.resize(new_size, 0);
+      level.free_list.reserve(new_size);
+      for (uint32_t i = new_size; i > level.size; --i)
+        level.free_list.push_back(i - 1);
+      level.size = new_size;
+    }
+
+    const uint32_t index = level.free_list.back();
+    level.free_list.pop_back();
+    return { depth, index };
+  }
+
+  void transform_store::release(handle_t& handle)
+  {
+    if (!handle.is_valid())
+      return;
+
+    level_t& level = get_level(handle.depth);
+    {
+      std::lock_guard _l {spinlock_exclusive_adapter::adapt(level.lock)};
+      // reset the entry so that the batches never operate on garbage:
+      level.local.set(handle.index, hydra::transform::identity());
+      level.parent_index[handle.index] = 0;
+      level.free_list.push_back(handle.index);
+    }
+    handle = {};
+  }
+
+  void transform_store::set_local(handle_t handle, const hydra::transform& local, handle_t parent)
+  {
+    check::debug::n_assert(handle.is_valid(), "transform_store::set_local: invalid handle");
+    check::debug::n_assert(handle.depth == 0 ? !parent.is_valid() : (parent.is_valid() && parent.depth + 1 == handle.depth),
+                           "transform_store::set_local: parent is not in the previous level");
+
+    level_t& level = get_level(handle.depth);
+    // NOTE: entries are only resized with an exclusive lock, writing different entries is fine with a shared lock
+    std::lock_guard _l {spinlock_shared_adapter::adapt(level.lock)};
+    level.local.set(handle.index, local);
+    level.parent_index[handle.index] = parent.is_valid() ? parent.index : 0;
+    level.is_dirty.store(true, std::memory_order_release);
+  }
+
+  hydra::transform transform_store::get_local(handle_t handle) const
+  {
+    const level_t& level = get_level(handle.depth);
+    std::lock_guard _l {spinlock_shared_adapter::adapt(level.lock)};
+    return level.local.get(handle.index);
+  }
+
+  hydra::transform transform_store::get_world(handle_t handle) const
+  {
+    const level_t& level = get_level(handle.depth);
+    std::lock_guard _l {spinlock_shared_adapter::adapt(level.lock)};
+    return level.world.get(handle.index);
+  }
+
+  hydra::transform transform_store::get_world_inverse(handle_t handle) const
+  {
+    const level_t& level = get_level(handle.depth);
+    std::lock_guard _l {spinlock_shared_adapter::adapt(level.lock)};
+    return level.world_inverse.get(handle.index);
+  }
+
+  void transform_store::_mark_all_dirty()
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(levels_lock)};
+    if (!levels.empty())
+      levels.front().is_dirty.store(true, std::memory_order_release);
+  }
+
+  void transform_store::compute_world_transforms()
+  {
+    TRACY_SCOPED_ZONE;
+    // once a level is computed, all the following levels must be computed too
+    bool force_compute = false;
+    for (uint32_t i = 0; i < (uint32_t)levels.size(); ++i)
+    {
+      level_t& level = levels[i];
+      const bool is_dirty = level.is_dirty.exchange(false, std::memory_order_acq_rel);
+      if (!is_dirty && !force_compute)
+        continue;
+      force_compute = true;
+
+      if (i == 0)
+        compute_root_level(level);
+      else
+        compute_level(level, levels[i - 1]);
+    }
+  }
+
+  void transform_store::compute_root_level(level_t& level) const
+  {
+    // root level: world transform is the local transform
+    level.world.tx = level.local.tx;
+    level.world.ty = level.local.ty;
+    level.world.tz = level.local.tz;
+    level.world.qx = level.local.qx;
+    level.world.qy = level.local.qy;
+    level.world.qz = level.local.qz;
+    level.world.qw = level.local.qw;
+    level.world.scale = level.local.scale;
+
+    compute_inverse(level, 0);
+  }
+
+  bool transform_store::has_simd_path()
+  {
+#if N_HYDRA_TRANSFORM_STORE_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+  }
+
+#if N_HYDRA_TRANSFORM_STORE_AVX2
+  namespace
+  {
+    internal::avx2::soa_ref make_soa_ref(auto& soa)
+    {
+      return { soa.tx.data(), soa.ty.data(), soa.tz.data(), soa.qx.data(), soa.qy.data(), soa.qz.data(), soa.qw.data(), soa.scale.data() };
+    }
+    internal::avx2::soa_cref make_soa_cref(const auto& soa)
+    {
+      return { soa.tx.data(), soa.ty.data(), soa.tz.data(), soa.qx.data(), soa.qy.data(), soa.qz.data(), soa.qw.data(), soa.scale.data() };
+    }
+  }
+#endif
+
+  void transform_store::compute_level(level_t& level, const level_t& parent_level) const
+  {
+#if N_HYDRA_TRANSFORM_STORE_AVX2
+    if (!force_scalar && has_simd_path())
+    {
+      return internal::avx2::compute_level(make_soa_cref(parent_level.world), make_soa_cref(level.local),
+                                           make_soa_ref(level.world), make_soa_ref(level.world_inverse),
+                                           level.parent_index.data(), level.size);
+    }
+#endif
+    compute_level_scalar(level, parent_level);
+  }
+
+  void transform_store::compute_inverse(level_t& level, uint32_t start) const
+  {
+#if N_HYDRA_TRANSFORM_STORE_AVX2
+    if (!force_scalar && has_simd_path())
+      return internal::avx2::compute_inverse(make_soa_cref(level.world), make_soa_ref(level.world_inverse), start, level.size);
+#endif
+    compute_inverse_scalar(level, start);
+  }
+
+  void transform_store::compute_level_scalar(level_t& level, const level_t& parent_level)
+  {
+    for (uint32_t i = 0; i < level.size; ++i)
+    {
+      const hydra::transform parent = parent_level.world.get(level.parent_index[i]);
+      level.world.set(i, hydra::transform::multiply(parent, level.local.get(i)));
+    }
+
+    compute_inverse_scalar(level, 0);
+  }
+
+  void transform_store::compute_inverse_scalar(level_t& level, uint32_t start)
+  {
+    for (uint32_t i = start; i < level.size; ++i)
+      level.world_inverse.set(i, hydra::transform::compute_inverse(level.world.get(i)));
+  }
+
+}
+
@@ -0,0 +1,142 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include <ntools/spinlock.hpp>
+
+namespace neam::hydra
+{
+  class transform;
+}
+
+namespace neam::hydra::ecs
+{
+  /// \brief Structure-of-arrays storage for local/world/world-inverse transforms, grouped by depth
+  /// World transforms are computed a whole depth-level at a time
+  /// (using AVX2 when the CPU supports it, see transform_store_avx2.cpp which is the only file built with -mavx2)
+  ///
+  /// \note Entries of a level always reference an entry of the previous level as parent.
+  ///       Level 0 entries have no parent (their world transform is their local transform).
+  /// \note allocate/release/set_local can be called from multiple threads,
+  ///       compute_world_transforms must not be called at the same time as any other function.
+  class transform_store
+  {
+    public:
+      struct handle_t
+      {
+        uint32_t depth = ~0u;
+        uint32_t index = ~0u;
+
+        bool is_valid() const { return depth != ~0u && index != ~0u; }
+      };
+
+    public:
+      /// \brief Allocate a new entry at the given depth
+      /// \note depth must be 0 or have at least one entry in the previous level
+      [[nodiscard]] handle_t allocate(uint32_t depth);
+
+      /// \brief Release an entry. The handle becomes invalid.
+      void release(handle_t& handle);
+
+      /// \brief Set the local transform of an entry
+      /// \note parent must be an handle to the previous level (or invalid for level 0)
+      void set_local(handle_t handle, const hydra::transform& local, handle_t parent);
+
+      hydra::transform get_local(handle_t handle) const;
+      hydra::transform get_world(handle_t handle) const;
+      hydra::transform get_world_inverse(handle_t handle) const;
+
+      /// \brief Compute the world and world-inverse transforms of every level that have changed
+      /// (and of all the levels after them)
+      void compute_world_transforms();
+
+      uint32_t get_depth_count() const;
+
+      /// \brief Return whether the batched computation uses the AVX2 path
+      /// (the build has it -- x86 only -- and the CPU supports AVX2, checked at runtime)
+      static bool has_simd_path();
+
+    public: // advanced
+      /// \brief Force the scalar path (hydra::transform::multiply / compute_inverse), even when the AVX2 path is available
+      /// \note Used to check the parity of both paths
+      void _set_force_scalar(bool force) { force_scalar = force; }
+
+      /// \brief Make the next compute_world_transforms call recompute every level
+      void _mark_all_dirty();
+
+    private:
+      static constexpr uint32_t k_lane_count = 4;
+
+      struct soa_transforms
+      {
+        std::vector<double> tx, ty, tz;
+        std::vector<float> qx, qy, qz, qw;
+        std::vector<float> scale;
+
+        void resize(uint32_t count);
+        void set(uint32_t index, const hydra::transform& tr);
+        hydra::transform get(uint32_t index) const;
+      };
+
+      struct level_t
+      {
+        soa_transforms local;
+        soa_transforms world;
+        soa_transforms world_inverse;
+        std::vector<uint32_t> parent_index;
+
+        std::vector<uint32_t> free_list;
+        // always a multiple of k_lane_count:
+        uint32_t size = 0;
+        std::atomic<bool> is_dirty = false;
+
+        mutable shared_spinlock lock;
+      };
+
+      void compute_root_level(level_t& level) const;
+      void compute_level(level_t& level, const level_t& parent_level) const;
+      void compute_inverse(level_t& level, uint32_t start) const;
+
+      static void compute_level_scalar(level_t& level, const level_t& parent_level);
+      static void compute_inverse_scalar(level_t& level, uint32_t start);
+
+      level_t& get_level(uint32_t depth);
+      const level_t& get_level(uint32_t depth) const;
+
+    private:
+      std::deque<level_t> levels;
+      mutable shared_spinlock levels_lock;
+
+      bool force_scalar = false;
+  };
+}
+
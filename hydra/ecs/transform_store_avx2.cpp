@@ -0,0 +1,151 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <immintrin.h>
+
+#include "transform_store_avx2.hpp"
+
+// NOTE: this file is compiled with -mavx2 and must only be called when the CPU supports AVX2 (see transform_store::has_simd_path())
+
+namespace neam::hydra::ecs::internal::avx2
+{
+  namespace
+  {
+    /// \brief rotate v by q (as done by glm::dquat * glm::dvec3)
+    inline void rotate_pd(__m256d qx, __m256d qy, __m256d qz, __m256d qw, __m256d& vx, __m256d& vy, __m256d& vz)
+    {
+      // uv = cross(q.xyz, v)
+      const __m256d uvx = _mm256_sub_pd(_mm256_mul_pd(qy, vz), _mm256_mul_pd(qz, vy));
+      const __m256d uvy = _mm256_sub_pd(_mm256_mul_pd(qz, vx), _mm256_mul_pd(qx, vz));
+      const __m256d uvz = _mm256_sub_pd(_mm256_mul_pd(qx, vy), _mm256_mul_pd(qy, vx));
+      // uuv = cross(q.xyz, uv)
+      const __m256d uuvx = _mm256_sub_pd(_mm256_mul_pd(qy, uvz), _mm256_mul_pd(qz, uvy));
+      const __m256d uuvy = _mm256_sub_pd(_mm256_mul_pd(qz, uvx), _mm256_mul_pd(qx, uvz));
+      const __m256d uuvz = _mm256_sub_pd(_mm256_mul_pd(qx, uvy), _mm256_mul_pd(qy, uvx));
+      // v + ((uv * w) + uuv) * 2
+      const __m256d two = _mm256_set1_pd(2.0);
+      vx = _mm256_add_pd(vx, _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(uvx, qw), uuvx), two));
+      vy = _mm256_add_pd(vy, _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(uvy, qw), uuvy), two));
+      vz = _mm256_add_pd(vz, _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(uvz, qw), uuvz), two));
+    }
+  }
+
+  void compute_level(soa_cref pw, soa_cref lc, soa_ref wd, soa_ref inv, const uint32_t* parent_index, uint32_t size)
+  {
+    for (uint32_t i = 0; i < size; i += 4)
+    {
+      const __m128i pidx = _mm_loadu_si128((const __m128i*)(parent_index + i));
+
+      // parent world state:
+      const __m256d ptx = _mm256_i32gather_pd(pw.tx, pidx, 8);
+      const __m256d pty = _mm256_i32gather_pd(pw.ty, pidx, 8);
+      const __m256d ptz = _mm256_i32gather_pd(pw.tz, pidx, 8);
+      const __m128 pqx = _mm_i32gather_ps(pw.qx, pidx, 4);
+      const __m128 pqy = _mm_i32gather_ps(pw.qy, pidx, 4);
+      const __m128 pqz = _mm_i32gather_ps(pw.qz, pidx, 4);
+      const __m128 pqw = _mm_i32gather_ps(pw.qw, pidx, 4);
+      const __m128 ps = _mm_i32gather_ps(pw.scale, pidx, 4);
+
+      // local state:
+      const __m128 lqx = _mm_loadu_ps(lc.qx + i);
+      const __m128 lqy = _mm_loadu_ps(lc.qy + i);
+      const __m128 lqz = _mm_loadu_ps(lc.qz + i);
+      const __m128 lqw = _mm_loadu_ps(lc.qw + i);
+      const __m128 ls = _mm_loadu_ps(lc.scale + i);
+
+      // scale:
+      _mm_storeu_ps(wd.scale + i, _mm_mul_ps(ps, ls));
+
+      // rotation: normalize(parent * local)
+      {
+        const __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(pqw, lqw), _mm_mul_ps(pqx, lqx)), _mm_mul_ps(pqy, lqy)), _mm_mul_ps(pqz, lqz));
+        const __m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(pqw, lqx), _mm_mul_ps(pqx, lqw)), _mm_mul_ps(pqy, lqz)), _mm_mul_ps(pqz, lqy));
+        const __m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(pqw, lqy), _mm_mul_ps(pqy, lqw)), _mm_mul_ps(pqz, lqx)), _mm_mul_ps(pqx, lqz));
+        const __m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(pqw, lqz), _mm_mul_ps(pqz, lqw)), _mm_mul_ps(pqx, lqy)), _mm_mul_ps(pqy, lqx));
+
+        const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+        const __m128 valid = _mm_cmpgt_ps(len, _mm_setzero_ps());
+        const __m128 inv_len = _mm_div_ps(_mm_set1_ps(1.0f), len);
+        // glm::normalize returns identity for null quaternions
+        _mm_storeu_ps(wd.qx + i, _mm_and_ps(valid, _mm_mul_ps(x, inv_len)));
+        _mm_storeu_ps(wd.qy + i, _mm_and_ps(valid, _mm_mul_ps(y, inv_len)));
+        _mm_storeu_ps(wd.qz + i, _mm_and_ps(valid, _mm_mul_ps(z, inv_len)));
+        _mm_storeu_ps(wd.qw + i, _mm_blendv_ps(_mm_set1_ps(1.0f), _mm_mul_ps(w, inv_len), valid));
+      }
+
+      // translation: parent.translation + (dquat)parent.rotation * (local.translation * parent.scale)
+      {
+        const __m256d pscale = _mm256_cvtps_pd(ps);
+        __m256d tx = _mm256_mul_pd(_mm256_loadu_pd(lc.tx + i), pscale);
+        __m256d ty = _mm256_mul_pd(_mm256_loadu_pd(lc.ty + i), pscale);
+        __m256d tz = _mm256_mul_pd(_mm256_loadu_pd(lc.tz + i), pscale);
+        rotate_pd(_mm256_cvtps_pd(pqx), _mm256_cvtps_pd(pqy), _mm256_cvtps_pd(pqz), _mm256_cvtps_pd(pqw), tx, ty, tz);
+        _mm256_storeu_pd(wd.tx + i, _mm256_add_pd(tx, ptx));
+        _mm256_storeu_pd(wd.ty + i, _mm256_add_pd(ty, pty));
+        _mm256_storeu_pd(wd.tz + i, _mm256_add_pd(tz, ptz));
+      }
+    }
+
+    compute_inverse({wd.tx, wd.ty, wd.tz, wd.qx, wd.qy, wd.qz, wd.qw, wd.scale}, inv, 0, size);
+  }
+
+  void compute_inverse(soa_cref wd, soa_ref inv, uint32_t start, uint32_t size)
+  {
+    for (uint32_t i = start; i < size; i += 4)
+    {
+      // rotation: conjugate(q) / dot(q, q)
+      const __m128 qx = _mm_loadu_ps(wd.qx + i);
+      const __m128 qy = _mm_loadu_ps(wd.qy + i);
+      const __m128 qz = _mm_loadu_ps(wd.qz + i);
+      const __m128 qw = _mm_loadu_ps(wd.qw + i);
+      const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+      const __m128 neg_zero = _mm_set1_ps(-0.0f);
+      const __m128 iqx = _mm_div_ps(_mm_xor_ps(qx, neg_zero), dot);
+      const __m128 iqy = _mm_div_ps(_mm_xor_ps(qy, neg_zero), dot);
+      const __m128 iqz = _mm_div_ps(_mm_xor_ps(qz, neg_zero), dot);
+      const __m128 iqw = _mm_div_ps(qw, dot);
+      _mm_storeu_ps(inv.qx + i, iqx);
+      _mm_storeu_ps(inv.qy + i, iqy);
+      _mm_storeu_ps(inv.qz + i, iqz);
+      _mm_storeu_ps(inv.qw + i, iqw);
+
+      // scale:
+      const __m128 iscale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_loadu_ps(wd.scale + i));
+      _mm_storeu_ps(inv.scale + i, iscale);
+
+      // translation: (dquat)inverse.rotation * (-translation * inverse.scale)
+      const __m256d neg_iscale = _mm256_xor_pd(_mm256_cvtps_pd(iscale), _mm256_set1_pd(-0.0));
+      __m256d tx = _mm256_mul_pd(_mm256_loadu_pd(wd.tx + i), neg_iscale);
+      __m256d ty = _mm256_mul_pd(_mm256_loadu_pd(wd.ty + i), neg_iscale);
+      __m256d tz = _mm256_mul_pd(_mm256_loadu_pd(wd.tz + i), neg_iscale);
+      rotate_pd(_mm256_cvtps_pd(iqx), _mm256_cvtps_pd(iqy), _mm256_cvtps_pd(iqz), _mm256_cvtps_pd(iqw), tx, ty, tz);
+      _mm256_storeu_pd(inv.tx + i, tx);
+      _mm256_storeu_pd(inv.ty + i, ty);
+      _mm256_storeu_pd(inv.tz + i, tz);
+    }
+  }
+}
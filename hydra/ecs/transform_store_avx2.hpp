@@ -0,0 +1,62 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+
+// NOTE: this header is included by transform_store_avx2.cpp, which is compiled with -mavx2.
+//       It must stay free of anything that could generate inline/template code shared with the other TUs
+//       (the linker might keep the AVX2 version of those, which would then run on CPUs without AVX2)
+
+namespace neam::hydra::ecs::internal::avx2
+{
+  /// \brief Pointers to the arrays of a SoA transform storage
+  template<typename Double, typename Float>
+  struct soa_view
+  {
+    Double* tx;
+    Double* ty;
+    Double* tz;
+    Float* qx;
+    Float* qy;
+    Float* qz;
+    Float* qw;
+    Float* scale;
+  };
+
+  using soa_ref = soa_view<double, float>;
+  using soa_cref = soa_view<const double, const float>;
+
+  /// \brief world = parent_world[parent_index] * local, then compute the world inverse
+  /// \note size must be a multiple of 4
+  void compute_level(soa_cref parent_world, soa_cref local, soa_ref world, soa_ref world_inverse, const uint32_t* parent_index, uint32_t size);
+
+  /// \brief Compute world_inverse from world for the entries in [start, size)
+  /// \note start and size must be multiples of 4
+  void compute_inverse(soa_cref world, soa_ref world_inverse, uint32_t start, uint32_t size);
+}
@@ -26,6 +26,7 @@
 
 #include "universe.hpp"
 #include "hierarchy.hpp"
+#include "transform.hpp"
 
 #include "../engine/core_context.hpp"
 
@@ -41,6 +42,55 @@ namespace neam::hydra::ecs
     }
     roots_hierarchy[0]->self_id = entity_id_t::none; // main root id is always none
     roots_hierarchy[0]->uni = this;
+    roots_hierarchy[0]->mark_subtree_dirty();
+  }
+
+  void universe::enable_transform_store(bool enabled)
+  {
+    if (enabled == use_transform_store)
+      return;
+    // NOTE: the store is never destructed, as transform components might still reference it
+    //       (they will release their entries during the next update)
+    if (enabled && !tstore)
+      tstore = std::make_unique<transform_store>();
+    use_transform_store = enabled;
+
+    // every transform component must be updated
+    roots_hierarchy[0]->force_update = true;
+    roots_hierarchy[0]->mark_subtree_dirty();
+  }
+
+  void universe::set_world_transform_listener(world_transform_listener* listener)
+  {
+    if (listener == transform_listener)
+      return;
+    // NOTE: transform components keep a pointer to the listener that gave them their slot
+    //       (and will release it during the next update)
+    transform_listener = listener;
+
+    // every transform component must be updated
+    roots_hierarchy[0]->force_update = true;
+    roots_hierarchy[0]->mark_subtree_dirty();
+  }
+
+  void universe::_queue_world_transform_notification(components::transform& component, bool force)
+  {
+    std::lock_guard _l(pending_notifications_lock);
+    pending_notifications.emplace_back(&component, force);
+  }
+
+  void universe::finish_transform_update()
+  {
+    if (!use_transform_store)
+      return;
+    tstore->compute_world_transforms();
+
+    if (transform_listener != nullptr)
+    {
+      for (const auto& it : pending_notifications)
+        it.first->_send_world_transform_notification(it.second);
+    }
+    pending_notifications.clear();
   }
 
   uint32_t universe::hierarchical_update_single_thread()
@@ -58,248 +108,145 @@ namespace neam::hydra::ecs
 
     // update the universe:
     uint32_t count = 0;
+    uint32_t update_index = 0;
     while (!queue.empty())
     {
       components::hierarchy* ptr = queue.front();
       queue.pop_front();
-      ptr->update();
+      ptr->update_index = update_index++;
+      if (!ptr->begin_update(incremental_update))
+        continue;
+      ptr->update(incremental_update);
       ptr->update_children(queue);
       ptr->end_update();
       ++count;
     }
+
+    finish_transform_update();
     return count;
   }
 
   uint32_t universe::hierarchical_update_tasked(core_context& cctx, uint32_t max_helper_task_count, uint32_t entity_per_task)
   {
-    // FIXME:
-    return hierarchical_update_single_thread();
-    // for (uint64_t i = 0; i < 409114; ++i)
-    // {
-    //   update_queue.push_back((components::hierarchy*)(i+1));
-    // }
-    // while (!update_queue.empty())
-    // {
-    //   components::hierarchy* ptr;
-    //   update_queue.try_pop_front(ptr);
-    // }
-    // return 409114;
-
-//         // max_helper_task_count = 16;
-//     std::atomic<uint32_t> task_count = 1;
-//     std::atomic<uint32_t> ret = 0;
-//     const uint64_t depth_limit = 10;
-//     std::deque<uint64_t> uq;
-//     spinlock uqlock;
-//
-//     auto try_pop_front = [&uq, &uqlock](uint64_t& x)
-//     {
-//       std::lock_guard _lg(uqlock);
-//       if (uq.empty()) return false;
-//       x = uq.front();
-//       uq.pop_front();
-//       return true;
-//     };
-//     {
-//       // prime the queue:
-//       uq.push_back(1);
-//       ret.fetch_add(1, std::memory_order_release);
-//
-//       const auto task_function = [&]
-//       {
-//         while (!uq.empty())
-//         {
-//           uint64_t ptr;
-//           [[likely]] if (try_pop_front(ptr))
-//           {
-//             uint64_t depth = (uint64_t)ptr;
-//             if (depth < depth_limit)
-//             for (uint32_t i = 0; i < depth; ++i)
-//             {
-//               {
-//                 std::lock_guard _lg(uqlock);
-//                 uq.push_back((depth + 1));
-//               }
-//               ret.fetch_add(1, std::memory_order_release);
-//             }
-//           }
-//         }
-//         task_count.fetch_sub(1, std::memory_order_release);
-//       };
-//
-//       while (!uq.empty() || task_count.load(std::memory_order_acquire) > 1)
-//       {
-//         uint64_t ptr;
-//         [[likely]] if (try_pop_front(ptr))
-//         {
-//           uint64_t depth = (uint64_t)ptr;
-//           if (depth < depth_limit)
-//           for (uint32_t i = 0; i < depth; ++i)
-//           {
-//               {
-//                 std::lock_guard _lg(uqlock);
-//                 uq.push_back((depth + 1));
-//               }
-//             ret.fetch_add(1, std::memory_order_release);
-//           }
-//         }
-//
-//         // dispatch tasks:
-//         const uint32_t remaining_count = uq.size();
-//         const uint32_t expected_task_count = std::min(max_helper_task_count, remaining_count / entity_per_task);
-//         uint32_t actual_task_count = task_count.load(std::memory_order_acquire);
-//         while (actual_task_count < expected_task_count)
-//         {
-//           ++actual_task_count;
-//           task_count.fetch_add(1, std::memory_order_release);
-//           cctx.tm.get_task(task_function);
-//         }
-//       }
-//       task_count.fetch_sub(1, std::memory_order_release);
-//
-//       // spin (FIXME: Should not happen)
-//       check::debug::n_check(task_count == 0, "still has tasks");
-//       check::debug::n_assert(uq.empty(), "not empty :(");
-//     }
-//     return ret;
-#if 0
-    max_helper_task_count = 12;
-    std::atomic<uint32_t> task_count = 1;
-    std::atomic<uint32_t> ret = 0;
-    const uint64_t depth_limit = 10;
-
+    // we need to be called from a task (we dispatch in the current group)
+    const threading::group_t group = cctx.tm.get_current_group();
+    if (group == threading::k_invalid_task_group || max_helper_task_count == 0)
+      return hierarchical_update_single_thread();
+    TRACY_SCOPED_ZONE;
+
+    entity_per_task = std::max(entity_per_task, 1u);
+
+    // NOTE: The update is level-synchronous: every entry of a level is updated before any entry of the next level
+    //       This guarantees that parents are updated before their children, and that the order of the entities in a level
+    //       is the same as the one the single-threaded version would produce.
+    //       Each level is split in (at most) max_helper_task_count + 1 batches, the current thread processing the first batch.
+    //       end_update() is deferred until the children are updated so that no child can be released while being updated.
+    std::vector<components::hierarchy*> current_level;
+    std::vector<components::hierarchy*> previous_level;
+    std::vector<std::vector<components::hierarchy*>> batch_children;
+    std::vector<threading::task_wrapper> tasks;
+
+    // prime the first level:
+    for (auto& it : roots)
     {
-      // prime the queue:
-      update_queue.push_back((components::hierarchy*)1);
-      ret.fetch_add(1, std::memory_order_release);
+      std::lock_guard _el(spinlock_shared_adapter::adapt(it.get_lock()));
 
-      const auto task_function = [&]
-      {
-        while (!update_queue.empty())
-        {
-          components::hierarchy* ptr;
-          [[likely]] if (update_queue.try_pop_front(ptr))
-          {
-            uint64_t depth = (uint64_t)ptr;
-            if (depth < depth_limit)
-            for (uint32_t i = 0; i < depth; ++i)
-            {
-              update_queue.push_back((components::hierarchy*)(depth + 1));
-              ret.fetch_add(1, std::memory_order_release);
-            }
-          }
-        }
-        task_count.fetch_sub(1, std::memory_order_release);
-      };
+      components::hierarchy* ptr = it.get<components::hierarchy>();
+      check::debug::n_assert(ptr != nullptr, "universe::update-mt: universe root doesn't have a hierarchy component");
+      current_level.push_back(ptr);
+    }
 
-      while (!update_queue.empty() || task_count.load(std::memory_order_acquire) > 1)
+    // run function(begin, end, batch_index) over the entries of a level, dispatching helper tasks if the level is big enough
+    const auto dispatch_level = [&](std::vector<components::hierarchy*>& level, auto&& function)
+    {
+      const uint32_t entry_count = (uint32_t)level.size();
+      if (entry_count == 0)
+        return 0u;
+      const uint32_t max_batch_count = std::max(1u, std::min(max_helper_task_count + 1, entry_count / entity_per_task));
+      const uint32_t batch_size = (entry_count + max_batch_count - 1) / max_batch_count;
+      const uint32_t batch_count = (entry_count + batch_size - 1) / batch_size;
+
+      for (uint32_t i = 1; i < batch_count; ++i)
       {
-        components::hierarchy* ptr;
-        [[likely]] if (update_queue.try_pop_front(ptr))
-        {
-          uint64_t depth = (uint64_t)ptr;
-          if (depth < depth_limit)
-          for (uint32_t i = 0; i < depth; ++i)
-          {
-            update_queue.push_back((components::hierarchy*)(depth + 1));
-            ret.fetch_add(1, std::memory_order_release);
-          }
-        }
-
-        // dispatch tasks:
-        const uint32_t remaining_count = update_queue.size();
-        const uint32_t expected_task_count = std::min(max_helper_task_count, remaining_count / entity_per_task);
-        uint32_t actual_task_count = task_count.load(std::memory_order_acquire);
-        while (actual_task_count < expected_task_count)
+        tasks.push_back(cctx.tm.get_task(group, [&function, &level, i, batch_size, entry_count]
         {
-          ++actual_task_count;
-          task_count.fetch_add(1, std::memory_order_release);
-          cctx.tm.get_task(task_function);
-        }
+          TRACY_SCOPED_ZONE;
+          function(level.data() + i * batch_size, level.data() + std::min(entry_count, (i + 1) * batch_size), i);
+        }));
       }
-      task_count.fetch_sub(1, std::memory_order_release);
 
-      // spin (FIXME: Should not happen)
-      check::debug::n_check(task_count == 0, "still has tasks");
-      check::debug::n_assert(update_queue.empty(), "not empty :(");
-    }
-    return ret;
-#endif
-#if 0
-    // max_helper_task_count = 16;
-    std::atomic<uint32_t> task_count = 1;
+      // the current thread does the first batch:
+      function(level.data(), level.data() + std::min(entry_count, batch_size), 0u);
 
-    {
-      // prime the queue:
-      for (auto& it : roots)
-      {
-        components::hierarchy* ptr = it.get<components::hierarchy>();
-        check::debug::n_assert(ptr != nullptr, "universe::update-st: universe root doesn't have a hierarchy component");
-        update_queue.push_back(std::move(ptr));
-      }
+      for (auto& it : tasks)
+        cctx.tm.actively_wait_for(std::move(it), threading::task_selection_mode::only_current_task_group);
+      tasks.clear();
+      return batch_count;
+    };
 
-      const auto task_function = [&]
+    std::atomic<uint32_t> count = 0;
+    uint32_t level_start_index = 0;
+    while (!current_level.empty())
+    {
+      // update the current level and gather the next one:
+      batch_children.resize(std::min<size_t>(max_helper_task_count + 1, current_level.size()));
+      components::hierarchy* const* const level_data = current_level.data();
+      const uint32_t batch_count = dispatch_level(current_level, [this, &batch_children, &count, level_data, level_start_index](components::hierarchy** begin, components::hierarchy** end, uint32_t batch_index)
       {
-        while (!update_queue.empty())
+        std::vector<components::hierarchy*>& next = batch_children[batch_index];
+        uint32_t updated_count = 0;
+        for (; begin != end; ++begin)
         {
-          components::hierarchy* ptr;
-          [[likely]] if (update_queue.try_pop_front(ptr))
+          // same index as the one the single-threaded version would give:
+          (*begin)->update_index = level_start_index + (uint32_t)(begin - level_data);
+          if (!(*begin)->begin_update(incremental_update))
           {
-            ptr->update();
-            ptr->update_children(update_queue);
+            // skipped entities are not part of the previous level (no end_update)
+            *begin = nullptr;
+            continue;
           }
+          (*begin)->update(incremental_update);
+          (*begin)->update_children(next);
+          ++updated_count;
         }
-        task_count.fetch_sub(1, std::memory_order_release);
-      };
+        count.fetch_add(updated_count, std::memory_order_relaxed);
+      });
 
-      while (!update_queue.empty() && task_count.load(std::memory_order_relaxed) >= 1)
+      // the children of the previous level have been updated, we can end its update:
+      if (!previous_level.empty())
       {
-        components::hierarchy* ptr;
-        [[likely]] if (update_queue.try_pop_front(ptr))
+        dispatch_level(previous_level, [](components::hierarchy** begin, components::hierarchy** end, uint32_t)
         {
-          ptr->update();
-          constexpr uint32_t k_children_batch = 1024;
-          uint32_t index = 0;
-          for (index = 0; ptr->update_children(update_queue, index, k_children_batch); index += k_children_batch)
+          for (; begin != end; ++begin)
           {
-            // dispatch tasks:
-            const uint32_t remaining_count = update_queue.size();
-            const uint32_t expected_task_count = std::min(max_helper_task_count, remaining_count / entity_per_task);
-            uint32_t actual_task_count = task_count.load(std::memory_order_acquire);
-            while (actual_task_count < expected_task_count)
-            {
-              ++actual_task_count;
-              task_count.fetch_add(1, std::memory_order_release);
-              cctx.tm.get_task(task_function);
-            }
+            if (*begin != nullptr)
+              (*begin)->end_update();
           }
-        }
-
-        // dispatch tasks:
-        const uint32_t remaining_count = update_queue.size();
-        const uint32_t expected_task_count = std::min(max_helper_task_count, remaining_count / entity_per_task);
-        uint32_t actual_task_count = task_count.load(std::memory_order_acquire);
-        while (actual_task_count < expected_task_count)
-        {
-          ++actual_task_count;
-          task_count.fetch_add(1, std::memory_order_release);
-          cctx.tm.get_task(task_function);
-        }
+        });
       }
-      task_count.fetch_sub(1, std::memory_order_release);
 
-      // spin (FIXME: Should not happen)
-      while (task_count.load(std::memory_order_acquire))
+      // build the next level (in order):
+      level_start_index += (uint32_t)current_level.size();
+      previous_level = std::move(current_level);
+      current_level.clear();
+      for (uint32_t i = 0; i < batch_count; ++i)
       {
-        while (task_count.load(std::memory_order_relaxed)) {}
+        current_level.insert(current_level.end(), batch_children[i].begin(), batch_children[i].end());
+        batch_children[i].clear();
       }
-      while (!update_queue.empty())
+    }
+
+    // end the update of the last level:
+    dispatch_level(previous_level, [](components::hierarchy** begin, components::hierarchy** end, uint32_t)
+    {
+      for (; begin != end; ++begin)
       {
-        components::hierarchy* ptr;
-        update_queue.try_pop_front(ptr);
+        if (*begin != nullptr)
+          (*begin)->end_update();
       }
-    }
-#endif
+    });
+
+    finish_transform_update();
+    return count.load(std::memory_order_relaxed);
   }
 }
-
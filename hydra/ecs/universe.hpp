@@ -26,9 +26,12 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "types.hpp"
+#include "transform_store.hpp"
+#include "world_transform_listener.hpp"
 
 namespace neam::hydra
 {
@@ -39,6 +42,7 @@ namespace neam::hydra::ecs
   namespace components
   {
     class hierarchy;
+    class transform;
   }
 
   /// \brief Self-contained entity context
@@ -62,9 +66,37 @@ namespace neam::hydra::ecs
       uint32_t hierarchical_update_single_thread();
 
       /// \brief Perform hierarchical update on multiple threads
+      /// The update is done level by level (parents are always updated before their children),
+      /// each level being split in at most max_helper_task_count + 1 batches of at least entity_per_task entities.
       /// \note Does not return until the update is done
+      /// \note Must be called from a task. Will fallback to the single-threaded version otherwise.
       uint32_t hierarchical_update_tasked(core_context& cctx, uint32_t max_helper_task_count = 8, uint32_t entity_per_task = 32);
 
+      /// \brief Enable/disable incremental updates
+      /// When enabled, the hierarchical update skips any entity whose subtree has no dirty hierarchical concept provider
+      /// and no hierarchy change (see components::hierarchy::mark_subtree_dirty).
+      /// The results are the same as a full update, but only the changed entities (and their parents) are visited.
+      void set_incremental_update(bool enabled) { incremental_update = enabled; }
+      bool is_incremental_update() const { return incremental_update; }
+
+      /// \brief Enable/disable the SoA transform store
+      /// When enabled, transform components store their state in the store
+      /// and the world transforms are computed in batches at the end of the hierarchical update.
+      void enable_transform_store(bool enabled);
+      transform_store* get_transform_store() { return use_transform_store ? tstore.get() : nullptr; }
+      const transform_store* get_transform_store() const { return use_transform_store ? tstore.get() : nullptr; }
+
+      /// \brief Set the object that will receive the world transforms that changed during the hierarchical updates
+      /// (nullptr to remove it)
+      /// \note Changing the listener forces a full update of the transforms during the next hierarchical update
+      /// \warning The listener must outlive the universe (or at least all its transform components)
+      void set_world_transform_listener(world_transform_listener* listener);
+      world_transform_listener* get_world_transform_listener() const { return transform_listener; }
+
+      /// \brief (internal) Queue a notification to the listener for a transform component using the store,
+      /// to be sent once the store has computed the world transforms (and only if the world transform has changed, unless forced)
+      void _queue_world_transform_notification(components::transform& component, bool force);
+
       /// \brief Return the hierarchy component of the (main) universe root
       components::hierarchy& get_universe_root() { return *roots_hierarchy[0]; }
       const components::hierarchy& get_universe_root() const { return *roots_hierarchy[0]; }
@@ -74,6 +106,10 @@ namespace neam::hydra::ecs
       const entity& get_universe_root_entity() const { return roots[0]; }
 
 
+    private:
+      /// \brief Compute the world transforms of the store (if any) and send the pending notifications
+      void finish_transform_update();
+
     private:
       /// \brief universe roots (everything is held from there)
       /// \note the first entry is always guaranteed to exist and has id_t::none
@@ -82,7 +118,14 @@ namespace neam::hydra::ecs
 
       database& db;
 
-      update_queue_t update_queue;
+      bool incremental_update = false;
+
+      bool use_transform_store = false;
+      std::unique_ptr<transform_store> tstore;
+
+      world_transform_listener* transform_listener = nullptr;
+      spinlock pending_notifications_lock;
+      std::vector<std::pair<components::transform*, bool>> pending_notifications;
   };
 }
 
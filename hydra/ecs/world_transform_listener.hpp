@@ -0,0 +1,57 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace neam::hydra
+{
+  class transform;
+}
+
+namespace neam::hydra::ecs
+{
+  /// \brief Receive the world transforms of the transform components of a universe (see universe::set_world_transform_listener)
+  /// Each transform component is given a stable slot, allocated on its first update and released on its destruction.
+  ///
+  /// \note All the functions can be called from multiple threads at the same time
+  ///       (but on_world_transform_changed is never called concurrently for the same slot)
+  class world_transform_listener
+  {
+    public:
+      static constexpr uint32_t k_invalid_slot = ~0u;
+
+      virtual ~world_transform_listener() = default;
+
+      /// \brief Return a new slot, or k_invalid_slot if there isn't any available
+      [[nodiscard]] virtual uint32_t allocate_slot() = 0;
+      virtual void release_slot(uint32_t slot) = 0;
+
+      /// \brief Called during the hierarchical update when the world transform of a slot has changed
+      virtual void on_world_transform_changed(uint32_t slot, const hydra::transform& world) = 0;
+  };
+}
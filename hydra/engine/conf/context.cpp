@@ -110,15 +110,21 @@ namespace neam::hydra::conf
     // we do a task, as we may have synchronous FS operations (calls to stat())
     cctx.tm.get_long_duration_task([this, conf_id, state = ret.create_state()]() mutable
     {
-      const auto update_confs_map = [this, &conf_id](id_t fid, location_t loc, std::filesystem::file_time_type mtime)
+      const auto update_confs_map = [this, &conf_id](id_t fid, location_t loc, std::filesystem::file_time_type mtime, const std::filesystem::path& file = {})
       {
-        std::lock_guard _el(spinlock_shared_adapter::adapt(confs_lock));
-        if (auto it = confs.find(conf_id); it != confs.end())
+        bool need_watch = false;
         {
-          it->second.io_mapped_file = fid;
-          it->second.location = loc;
-          it->second.last_mtime = mtime;
+          std::lock_guard _el(spinlock_shared_adapter::adapt(confs_lock));
+          if (auto it = confs.find(conf_id); it != confs.end())
+          {
+            it->second.io_mapped_file = fid;
+            it->second.location = loc;
+            it->second.last_mtime = mtime;
+            need_watch = !file.empty() && file != it->second.watched_file;
+          }
         }
+        if (need_watch)
+          watch_conf_file(conf_id, file);
       };
       // first: check if file is in the file-map:
       {
@@ -158,7 +164,7 @@ namespace neam::hydra::conf
               if (std::filesystem::is_regular_file(fullpath))
               {
                 const id_t source_fid = cctx.io.map_unprefixed_file(fullpath);
-                update_confs_map(source_fid, location_t::index_program_local_dir, cctx.io.get_modified_or_created_time(source_fid));
+                update_confs_map(source_fid, location_t::index_program_local_dir, cctx.io.get_modified_or_created_time(source_fid), fullpath);
                 cctx.io.queue_read(source_fid, 0, io::context::whole_file).use_state(state);
                 return;
               }
@@ -169,7 +175,7 @@ namespace neam::hydra::conf
               if (std::filesystem::is_regular_file(fullpath))
               {
                 const id_t source_fid = cctx.io.map_unprefixed_file(fullpath);
-                update_confs_map(source_fid, location_t::index_local_dir, cctx.io.get_modified_or_created_time(source_fid));
+                update_confs_map(source_fid, location_t::index_local_dir, cctx.io.get_modified_or_created_time(source_fid), fullpath);
                 cctx.io.queue_read(source_fid, 0, io::context::whole_file).use_state(state);
                 return;
               }
@@ -183,7 +189,7 @@ namespace neam::hydra::conf
             if (std::filesystem::is_regular_file(fullpath))
             {
               const id_t source_fid = cctx.io.map_unprefixed_file(fullpath);
-              update_confs_map(source_fid, location_t::source_dir, cctx.io.get_modified_or_created_time(source_fid));
+              update_confs_map(source_fid, location_t::source_dir, cctx.io.get_modified_or_created_time(source_fid), fullpath);
               cctx.io.queue_read(source_fid, 0, io::context::whole_file).use_state(state);
               return;
             }
@@ -195,7 +201,7 @@ namespace neam::hydra::conf
             if (std::filesystem::is_regular_file(fullpath))
             {
               const id_t source_fid = cctx.io.map_file(file);
-              update_confs_map(source_fid, location_t::io_prefixed, cctx.io.get_modified_or_created_time(source_fid));
+              update_confs_map(source_fid, location_t::io_prefixed, cctx.io.get_modified_or_created_time(source_fid), fullpath);
               cctx.io.queue_read(source_fid, 0, io::context::whole_file).use_state(state);
               return;
             }
@@ -205,7 +211,7 @@ namespace neam::hydra::conf
           if (std::filesystem::is_regular_file(file))
           {
             const id_t local_fid = cctx.io.map_unprefixed_file(file);
-            update_confs_map(local_fid, location_t::cwd, cctx.io.get_modified_or_created_time(local_fid));
+            update_confs_map(local_fid, location_t::cwd, cctx.io.get_modified_or_created_time(local_fid), file);
             cctx.io.queue_read(local_fid, 0, io::context::whole_file).use_state(state);
             return;
           }
@@ -418,59 +424,136 @@ namespace neam::hydra::conf
     });
   }
 
+  void neam::hydra::conf::context::check_conf_file(string_id conf_id)
+  {
+    std::lock_guard _sl(spinlock_shared_adapter::adapt(confs_lock));
+    auto it = confs.find(conf_id);
+    if (it == confs.end())
+      return;
+    if (it->second.is_file_being_written)
+      return;
+    if (it->second.io_mapped_file == id_t::none)
+    {
+      // the conf is read from resources, but its source file (which we watch) has been re-created:
+      cr::out().debug("hconf: reloading {} as the source file has changed", it->second.source_file);
+      update_conf(it->first);
+      return;
+    }
+
+    if (!cctx.io.is_file_mapped(it->second.io_mapped_file))
+    {
+      cr::out().debug("hconf: reloading {} as it's missing from the io context", it->second.source_file);
+      update_conf(it->first);
+    }
+    else
+    {
+      const auto mtime = cctx.io.get_modified_or_created_time(it->second.io_mapped_file);
+      if (mtime > it->second.last_mtime)
+      {
+        it->second.last_mtime = mtime;
+        cr::out().debug("hconf: reloading {} as the source file is newer", it->second.source_file);
+        update_conf(it->first);
+      }
+    }
+  }
+
+  void neam::hydra::conf::context::watch_conf_file(string_id conf_id, const std::filesystem::path& file)
+  {
+    // NOTE: fs_watcher calls are done outside the locks, as remove_watch() waits for the callbacks to complete
+    id_t old_watch = id_t::invalid;
+    {
+      std::lock_guard _sl(spinlock_shared_adapter::adapt(confs_lock));
+      std::lock_guard _ul(flags_lock);
+      auto it = confs.find(conf_id);
+      if (it == confs.end())
+        return;
+      it->second.watched_file = file;
+      if (!is_watching_files)
+        return;
+      old_watch = std::exchange(it->second.file_watch, id_t::invalid);
+    }
+
+    cctx.fsw.remove_watch(old_watch);
+    const id_t new_watch = cctx.fsw.watch_file(file, [this, conf_id](std::vector<fs_watcher::event_t>&& /*events*/)
+    {
+      check_conf_file(conf_id);
+    });
+
+    {
+      std::lock_guard _sl(spinlock_shared_adapter::adapt(confs_lock));
+      std::lock_guard _ul(flags_lock);
+      auto it = confs.find(conf_id);
+      if (it != confs.end() && is_watching_files && it->second.file_watch == id_t::invalid && it->second.watched_file == file)
+      {
+        it->second.file_watch = new_watch;
+        return;
+      }
+    }
+    // we raced with another watch / a stop:
+    cctx.fsw.remove_watch(new_watch);
+  }
+
   void neam::hydra::conf::context::_watch_for_file_changes()
   {
     TRACY_SCOPED_ZONE;
+    std::vector<string_id> ids;
     {
       std::lock_guard _sl(spinlock_shared_adapter::adapt(confs_lock));
+      ids.reserve(confs.size());
       for (auto& it : confs)
       {
-        if (it.second.io_mapped_file != id_t::none && !it.second.is_file_being_written)
-        {
-          if (!cctx.io.is_file_mapped(it.second.io_mapped_file))
-          {
-            cr::out().debug("hconf: reloading {} as it's missing from the io context", it.second.source_file);
-            update_conf(it.first);
-          }
-          else
-          {
-            const auto mtime = cctx.io.get_modified_or_created_time(it.second.io_mapped_file);
-            if (mtime > it.second.last_mtime)
-            {
-              it.second.last_mtime = mtime;
-              cr::out().debug("hconf: reloading {} as the source file is newer", it.second.source_file);
-              update_conf(it.first);
-            }
-          }
-        }
+        if (it.second.io_mapped_file != id_t::none)
+          ids.push_back(it.first);
       }
     }
-
-    std::lock_guard _ul(flags_lock);
-    if (!should_watch_task_exit)
-      cctx.tm.get_delayed_task(std::chrono::seconds{1}, [this] { _watch_for_file_changes(); });
-    else
-      has_watch_task = false;
+    for (const string_id conf_id : ids)
+      check_conf_file(conf_id);
   }
 
   void neam::hydra::conf::context::register_watch_for_changes()
   {
-    std::lock_guard _ul(flags_lock);
     // register the callback for index change:
     on_index_loaded_tk = cctx.res.on_index_loaded.add(*this, &context::on_index_changed);
-    should_watch_task_exit = false;
-    if (!has_watch_task)
+
+    {
+      std::lock_guard _ul(flags_lock);
+      if (is_watching_files)
+        return;
+      is_watching_files = true;
+    }
+
+    // watch the files of the confs that have already been read:
+    std::vector<std::pair<string_id, std::filesystem::path>> files;
     {
-      has_watch_task = true;
-      cctx.tm.get_delayed_task(std::chrono::seconds{1}, [this] { _watch_for_file_changes(); });
+      std::lock_guard _sl(spinlock_shared_adapter::adapt(confs_lock));
+      for (auto& it : confs)
+      {
+        if (!it.second.watched_file.empty())
+          files.emplace_back(it.first, it.second.watched_file);
+      }
     }
+    for (const auto& it : files)
+      watch_conf_file(it.first, it.second);
   }
 
   void context::_stop_watching_for_file_changes()
   {
-    std::lock_guard _ul(flags_lock);
     on_index_loaded_tk.release();
-    should_watch_task_exit = true;
+
+    // remove the watches outside the locks, as remove_watch() waits for the callbacks to complete
+    std::vector<id_t> file_watches;
+    {
+      std::lock_guard _sl(spinlock_shared_adapter::adapt(confs_lock));
+      std::lock_guard _ul(flags_lock);
+      is_watching_files = false;
+      for (auto& it : confs)
+      {
+        file_watches.push_back(it.second.file_watch);
+        it.second.file_watch = id_t::invalid;
+      }
+    }
+    for (const id_t wid : file_watches)
+      cctx.fsw.remove_watch(wid);
   }
 }
 
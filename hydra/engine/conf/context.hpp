@@ -211,9 +211,8 @@ namespace neam::hydra::conf
         return update_conf(conf.hconf_source);
       }
 
-      /// \brief Asynchronous function that will reload/update still-alive confs objects and trigger events
-      /// \note the function will spawn a long-duration task that may spawn more tasks and may do some IO stuff.
-      ///       It's best to rate-limit this function. (once every second or more is good)
+      /// \brief Reload/update still-alive confs objects (and trigger events) when their source file changes
+      /// \note source files are watched using the fs_watcher of the core context
       /// \warning NOT INTENDED FOR PACKER USE
       void register_watch_for_changes();
 
@@ -224,6 +223,7 @@ namespace neam::hydra::conf
       static void _from_hconf(raw_data&& hconf_src, raw_data& data, raw_data& metadata);
 
       /// \brief Will go over all the files, check if there has been changes
+      /// \note Not necessary when register_watch_for_changes() has been called, as the files are watched
       void _watch_for_file_changes();
 
       void _stop_watching_for_file_changes();
@@ -238,6 +238,12 @@ namespace neam::hydra::conf
       /// \brief Callback for the on_index_loaded event
       void on_index_changed();
 
+      /// \brief Reload the conf if its source file is newer (or if it's missing from the io context)
+      void check_conf_file(string_id conf_id);
+
+      /// \brief (Re)watch the source file of a conf
+      void watch_conf_file(string_id conf_id, const std::filesystem::path& file);
+
     private:
       struct hconf_autowatch_entry
       {
@@ -250,6 +256,9 @@ namespace neam::hydra::conf
         id_t io_mapped_file = id_t::none; // if none, it means that it's a resource
         location_t location = location_t::none;
         std::string source_file = {};
+
+        std::filesystem::path watched_file = {}; // the file the conf was last read from (if any)
+        id_t file_watch = id_t::invalid;
       };
       template<typename T, ct::string_holder DefaultSource, location_t DefaultLocation>
       bool _register_for_autoupdate_unlocked(hconf<T, DefaultSource, DefaultLocation>& cnf)
@@ -310,8 +319,7 @@ namespace neam::hydra::conf
       cr::event_token_t on_index_loaded_tk;
 
       mutable spinlock flags_lock;
-      bool should_watch_task_exit = false;
-      bool has_watch_task = false;
+      bool is_watching_files = false;
   };
 }
 
@@ -31,6 +31,7 @@
 #include <ntools/sys_utils.hpp>
 
 #include <resources/context.hpp>
+#include <engine/fs_watcher.hpp>
 #include <engine/conf/context.hpp>
 
 namespace neam::hydra
@@ -64,6 +65,7 @@ namespace neam::hydra
     public:
       threading::task_manager tm;
       io::context io;
+      fs_watcher fsw;
       resources::context res = { io, *this };
       conf::context hconf = { *this };
 
@@ -76,12 +76,15 @@ namespace neam::hydra
   {
     cctx->res._prepare_engine_shutdown();
     cctx->hconf._stop_watching_for_file_changes();
+    cctx->fsw.remove_watch(index_directory_watch);
+    index_directory_watch = id_t::invalid;
   }
 
   void core_module::on_engine_boot_complete()
   {
     last_index_timestamp = cctx->res.get_index_modified_time();
     index_watcher_chrono.reset();
+    watch_index_directory();
     last_frame_timepoint = std::chrono::high_resolution_clock::now();
 
 
@@ -140,13 +143,42 @@ namespace neam::hydra
     need_index_reload = true;
   }
 
+  void core_module::watch_index_directory()
+  {
+    if (!cctx->res._has_prefix_directory())
+      return;
+    std::filesystem::path dir = cctx->res._get_prefix_directory();
+    if (dir.empty())
+      dir = ".";
+    if (index_directory_watch != id_t::invalid && dir == index_directory)
+      return;
+
+    cctx->fsw.remove_watch(index_directory_watch);
+    index_directory = std::move(dir);
+    index_directory_watch = cctx->fsw.watch_directory(index_directory, [this](std::vector<fs_watcher::event_t>&& /*events*/)
+    {
+      index_directory_changed = true;
+    });
+    // force a check, as we might have missed changes
+    index_directory_changed = true;
+  }
+
   void core_module::watch_for_index_change()
   {
     TRACY_SCOPED_ZONE;
-    // rate-limit the function:
-    if (index_watcher_chrono.get_accumulated_time() < 0.5)
-      return;
-    index_watcher_chrono.reset();
+    if (index_directory_watch != id_t::invalid)
+    {
+      // only check the index when something changed in its directory:
+      if (!index_directory_changed.exchange(false) && !need_index_reload)
+        return;
+    }
+    else
+    {
+      // fallback: rate-limit the function:
+      if (index_watcher_chrono.get_accumulated_time() < 0.5)
+        return;
+      index_watcher_chrono.reset();
+    }
 
     const std::filesystem::file_time_type index_mtime = cctx->res.get_index_modified_time();
     if (index_mtime > last_index_timestamp || need_index_reload)
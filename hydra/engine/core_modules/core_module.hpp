@@ -72,10 +72,16 @@ namespace neam::hydra
 
     private: // index watcher/auto-reload stuff:
       std::filesystem::file_time_type last_index_timestamp;
-      cr::chrono index_watcher_chrono; // throttle index watch
+      cr::chrono index_watcher_chrono; // throttle index watch (only when the fs-watch is not available)
+
+      // watch the index directory. The index is only stat-ed when something changed there.
+      std::filesystem::path index_directory;
+      id_t index_directory_watch = id_t::invalid;
+      std::atomic<bool> index_directory_changed = false;
 
       std::chrono::time_point<std::chrono::high_resolution_clock> last_frame_timepoint;
 
+      void watch_index_directory();
       void watch_for_index_change();
       void throttle_frame();
 
@@ -68,12 +68,23 @@ namespace neam::hydra
             else
               cctx->io.process();
           });
+
+          // file-system events (non-blocking when using inotify, might scan the disk for polled watches)
+          cctx->tm.get_long_duration_task([this]
+          {
+            cctx->fsw.update();
+          });
         });
       }
       void on_start_shutdown() override
       {
       }
 
+      void on_shutdown() override
+      {
+        cctx->fsw.remove_all_watches();
+      }
+
       friend class engine_t;
       friend engine_module<io_module>;
   };
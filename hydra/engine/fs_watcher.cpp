@@ -0,0 +1,562 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "fs_watcher.hpp"
+
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <ntools/tracy.hpp>
+#include <ntools/logger/logger.hpp>
+
+#ifndef N_HYDRA_FS_WATCHER_USE_INOTIFY
+  #if __has_include(<sys/inotify.h>)
+    #define N_HYDRA_FS_WATCHER_USE_INOTIFY true
+  #else
+    #define N_HYDRA_FS_WATCHER_USE_INOTIFY false
+  #endif
+#endif
+
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+  #include <sys/inotify.h>
+  #include <unistd.h>
+  #include <errno.h>
+  #include <string.h>
+#endif
+
+namespace neam::hydra
+{
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+  static constexpr uint32_t k_inotify_mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB
+                                           | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+  /// \brief return whether path is root or is inside root
+  static bool is_sub_path(const std::filesystem::path& path, const std::filesystem::path& root)
+  {
+    const auto root_it = std::mismatch(root.begin(), root.end(), path.begin(), path.end()).first;
+    // (handle the trailing empty element of paths ending with a /)
+    return root_it == root.end() || (root_it->empty() && std::next(root_it) == root.end());
+  }
+#endif
+
+  /// \brief return the more recent of either the modified time or the created time
+  static std::filesystem::file_time_type get_modified_or_created_time(const std::filesystem::path& p, bool& success)
+  {
+    struct stat st;
+    if (stat(p.c_str(), &st) != 0)
+    {
+      success = false;
+      return {};
+    }
+    success = true;
+    const auto to_fstime = [](struct timespec ts)
+    {
+      return std::filesystem::file_time_type
+      {
+        std::chrono::duration_cast<std::filesystem::file_time_type::duration>(std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec})
+      };
+    };
+    const std::filesystem::file_time_type m = to_fstime(st.st_mtim);
+    const std::filesystem::file_time_type c = to_fstime(st.st_ctim);
+    return c > m ? c : m;
+  }
+
+  fs_watcher::fs_watcher()
+  {
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+      cr::out().warn("fs_watcher: failed to initialize inotify ({}), falling back to polling", strerror(errno));
+#endif
+  }
+
+  fs_watcher::~fs_watcher()
+  {
+    remove_all_watches();
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+    if (inotify_fd >= 0)
+      close(inotify_fd);
+    inotify_fd = -1;
+#endif
+  }
+
+  id_t fs_watcher::watch_directory(const std::filesystem::path& dir, callback_t&& cb, bool recursive)
+  {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec))
+      return id_t::invalid;
+    std::filesystem::path root = std::filesystem::absolute(dir, ec).lexically_normal();
+    return add_watch(std::move(root), {}, recursive, std::move(cb));
+  }
+
+  id_t fs_watcher::watch_file(const std::filesystem::path& file, callback_t&& cb)
+  {
+    std::error_code ec;
+    std::filesystem::path abs_file = std::filesystem::absolute(file, ec).lexically_normal();
+    if (!abs_file.has_filename() || !std::filesystem::is_directory(abs_file.parent_path(), ec))
+      return id_t::invalid;
+    return add_watch(abs_file.parent_path(), abs_file.filename().string(), false, std::move(cb));
+  }
+
+  id_t fs_watcher::add_watch(std::filesystem::path&& root, std::string&& filename, bool recursive, callback_t&& cb)
+  {
+    TRACY_SCOPED_ZONE;
+    std::lock_guard _l(lock);
+    const id_t wid = (id_t)(++watch_counter);
+    watch_t& w = watches[wid];
+    w.root = std::move(root);
+    w.filename = std::move(filename);
+    w.recursive = recursive;
+    w.callback = std::move(cb);
+
+    bool success = false;
+    if (inotify_fd >= 0)
+    {
+      if (recursive)
+        success = add_recursive_unlocked(wid, w, w.root, false, clock::now());
+      else
+        success = add_directory_unlocked(wid, w.root);
+
+      if (!success)
+      {
+        cr::out().warn("fs_watcher: failed to watch {} with inotify, falling back to polling", w.root.c_str());
+        remove_directories_unlocked(wid, w.root);
+      }
+    }
+
+    if (!success)
+    {
+      w.use_polling = true;
+      w.snapshot = scan(w);
+    }
+    return wid;
+  }
+
+  void fs_watcher::remove_watch(id_t wid)
+  {
+    if (wid == id_t::invalid)
+      return;
+
+    // prevent removing a watch while its callback is being called (unless we are called from that callback)
+    const bool is_dispatching_thread = dispatching_thread.load(std::memory_order_acquire) == std::this_thread::get_id();
+    std::unique_lock<spinlock> _ul(update_lock, std::defer_lock);
+    if (!is_dispatching_thread)
+      _ul.lock();
+
+    std::lock_guard _l(lock);
+    auto it = watches.find(wid);
+    if (it == watches.end())
+      return;
+    if (!it->second.use_polling)
+      remove_directories_unlocked(wid, it->second.root);
+    watches.erase(it);
+  }
+
+  void fs_watcher::remove_all_watches()
+  {
+    std::vector<id_t> ids;
+    {
+      std::lock_guard _l(lock);
+      ids.reserve(watches.size());
+      for (const auto& it : watches)
+        ids.push_back(it.first);
+    }
+    for (const id_t wid : ids)
+      remove_watch(wid);
+  }
+
+  uint32_t fs_watcher::get_watch_count() const
+  {
+    std::lock_guard _l(lock);
+    return (uint32_t)watches.size();
+  }
+
+  void fs_watcher::push_event_unlocked(watch_t& w, std::filesystem::path&& path, event_type type, bool is_directory, clock::time_point now)
+  {
+    if (w.pending.empty())
+      w.first_event = now;
+    w.last_event = now;
+
+    auto [it, inserted] = w.pending.try_emplace(path, event_t{ path, type, is_directory });
+    if (inserted)
+      return;
+
+    // coalesce with the previous event for the same path:
+    event_t& ev = it->second;
+    if (ev.type == event_type::created && type == event_type::removed)
+    {
+      // created then removed: nothing happened
+      w.pending.erase(it);
+      return;
+    }
+    if (ev.type == event_type::created && type == event_type::modified)
+      return; // stays created
+    if (ev.type == event_type::removed && type == event_type::created)
+      ev.type = event_type::modified; // replaced
+    else
+      ev.type = type;
+    ev.is_directory = is_directory;
+  }
+
+  void fs_watcher::update()
+  {
+    // only one update at a time, and there's no need to wait: the other update will do the work
+    if (!update_lock.try_lock())
+      return;
+    std::lock_guard _ul(update_lock, std::adopt_lock);
+
+    TRACY_SCOPED_ZONE;
+
+    read_inotify_events();
+
+    if (clock::now() - last_poll >= poll_interval)
+    {
+      poll_watches();
+      last_poll = clock::now();
+    }
+
+    // dispatch the batches that are ready:
+    std::vector<std::pair<id_t, std::vector<event_t>>> to_dispatch;
+    {
+      std::lock_guard _l(lock);
+      const clock::time_point now = clock::now();
+      for (auto& it : watches)
+      {
+        watch_t& w = it.second;
+        if (w.pending.empty())
+          continue;
+        if (now - w.last_event < coalesce_delay && now - w.first_event < max_coalesce_delay)
+          continue;
+
+        std::vector<event_t> events;
+        events.reserve(w.pending.size());
+        for (auto& ev : w.pending)
+          events.push_back(std::move(ev.second));
+        w.pending.clear();
+        to_dispatch.emplace_back(it.first, std::move(events));
+      }
+    }
+
+    if (to_dispatch.empty())
+      return;
+
+    dispatching_thread.store(std::this_thread::get_id(), std::memory_order_release);
+    for (auto& it : to_dispatch)
+    {
+      // callbacks are allowed to remove watches, so the callback is copied and the watch checked before each call
+      callback_t cb;
+      {
+        std::lock_guard _l(lock);
+        auto wit = watches.find(it.first);
+        if (wit == watches.end())
+          continue;
+        cb = wit->second.callback;
+      }
+      if (cb)
+        cb(std::move(it.second));
+    }
+    dispatching_thread.store({}, std::memory_order_release);
+  }
+
+  bool fs_watcher::add_directory_unlocked([[maybe_unused]] id_t wid, [[maybe_unused]] const std::filesystem::path& dir)
+  {
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+    const int wd = inotify_add_watch(inotify_fd, dir.c_str(), k_inotify_mask);
+    if (wd < 0)
+    {
+      if (errno == ENOSPC)
+        cr::out().warn("fs_watcher: inotify watch limit reached (see /proc/sys/fs/inotify/max_user_watches)");
+      return false;
+    }
+    // inotify returns the same wd for the same inode, so the entry is shared between watches:
+    wd_entry_t& entry = wds[wd];
+    entry.dir = dir;
+    if (std::find(entry.watches.begin(), entry.watches.end(), wid) == entry.watches.end())
+      entry.watches.push_back(wid);
+    dir_to_wd[dir] = wd;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool fs_watcher::add_recursive_unlocked(id_t wid, watch_t& w, const std::filesystem::path& dir, bool emit_files, clock::time_point now)
+  {
+    if (!add_directory_unlocked(wid, dir))
+      return false;
+
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+      if (ec) continue;
+      if (it->is_directory(ec) && !it->is_symlink(ec))
+      {
+        if (!add_directory_unlocked(wid, it->path()))
+          return false;
+      }
+      else if (emit_files)
+      {
+        // files created before the watch on the directory was added: (as we cannot know, report them all)
+        push_event_unlocked(w, it->path().lexically_relative(w.root), event_type::created, false, now);
+      }
+    }
+    return true;
+  }
+
+  void fs_watcher::remove_directories_unlocked([[maybe_unused]] id_t wid, [[maybe_unused]] const std::filesystem::path& dir)
+  {
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+    for (auto it = dir_to_wd.lower_bound(dir); it != dir_to_wd.end();)
+    {
+      if (!is_sub_path(it->first, dir))
+        break;
+
+      const int wd = it->second;
+      auto wd_it = wds.find(wd);
+      if (wd_it == wds.end() || wd_it->second.dir != it->first)
+      {
+        // stale entry
+        it = dir_to_wd.erase(it);
+        continue;
+      }
+      std::erase(wd_it->second.watches, wid);
+      if (wd_it->second.watches.empty())
+      {
+        inotify_rm_watch(inotify_fd, wd);
+        wds.erase(wd_it);
+        it = dir_to_wd.erase(it);
+        continue;
+      }
+      ++it;
+    }
+#endif
+  }
+
+  void fs_watcher::read_inotify_events()
+  {
+#if N_HYDRA_FS_WATCHER_USE_INOTIFY
+    if (inotify_fd < 0)
+      return;
+
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    while (true)
+    {
+      const ssize_t len = read(inotify_fd, buffer, sizeof(buffer));
+      if (len <= 0)
+      {
+        if (len < 0 && errno != EAGAIN && errno != EINTR)
+          cr::out().warn("fs_watcher: failed to read inotify events: {}", strerror(errno));
+        return;
+      }
+
+      TRACY_SCOPED_ZONE;
+      std::lock_guard _l(lock);
+      const clock::time_point now = clock::now();
+
+      // new directories are only watched after the batch has been processed
+      std::vector<std::pair<id_t, std::filesystem::path>> new_directories;
+
+      for (ssize_t offset = 0; offset < len;)
+      {
+        const struct inotify_event* ev = (const struct inotify_event*)(buffer + offset);
+        offset += sizeof(struct inotify_event) + ev->len;
+
+        if ((ev->mask & IN_Q_OVERFLOW) != 0)
+        {
+          cr::out().warn("fs_watcher: inotify queue overflow, events have been lost");
+          for (auto& it : watches)
+          {
+            if (!it.second.use_polling)
+              push_event_unlocked(it.second, {}, event_type::overflow, true, now);
+          }
+          continue;
+        }
+
+        auto wd_it = wds.find(ev->wd);
+        if (wd_it == wds.end())
+          continue;
+
+        if ((ev->mask & IN_IGNORED) != 0)
+        {
+          // the directory has been removed (or the watch removed)
+          if (auto dit = dir_to_wd.find(wd_it->second.dir); dit != dir_to_wd.end() && dit->second == ev->wd)
+            dir_to_wd.erase(dit);
+          wds.erase(wd_it);
+          continue;
+        }
+
+        // we only care about the directory content:
+        if (ev->len == 0)
+          continue;
+
+        const std::filesystem::path full_path = wd_it->second.dir / ev->name;
+        const bool is_directory = (ev->mask & IN_ISDIR) != 0;
+
+        event_type type = event_type::modified;
+        if ((ev->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+          type = event_type::created;
+        else if ((ev->mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
+          type = event_type::removed;
+
+        for (const id_t wid : wd_it->second.watches)
+        {
+          auto wit = watches.find(wid);
+          if (wit == watches.end())
+            continue;
+          watch_t& w = wit->second;
+
+          if (!w.filename.empty())
+          {
+            if (is_directory || w.filename != ev->name)
+              continue;
+            push_event_unlocked(w, w.filename, type, false, now);
+            continue;
+          }
+
+          push_event_unlocked(w, full_path.lexically_relative(w.root), type, is_directory, now);
+
+          if (is_directory && w.recursive)
+          {
+            if (type == event_type::created)
+              new_directories.emplace_back(wid, full_path);
+            else if (type == event_type::removed && (ev->mask & IN_MOVED_FROM) != 0)
+              remove_directories_unlocked(wid, full_path); // moved away: the watches on the sub-directories are now invalid
+          }
+        }
+      }
+
+      for (const auto& it : new_directories)
+      {
+        auto wit = watches.find(it.first);
+        if (wit == watches.end())
+          continue;
+        if (!add_recursive_unlocked(it.first, wit->second, it.second, true, now))
+        {
+          // we can't track the change in that directory anymore, consider everything dirty
+          cr::out().warn("fs_watcher: failed to watch new directory {}", it.second.c_str());
+          push_event_unlocked(wit->second, {}, event_type::overflow, true, now);
+        }
+      }
+    }
+#endif
+  }
+
+  std::map<std::filesystem::path, std::filesystem::file_time_type> fs_watcher::scan(const watch_t& w) const
+  {
+    TRACY_SCOPED_ZONE;
+    std::map<std::filesystem::path, std::filesystem::file_time_type> ret;
+    bool success;
+    if (!w.filename.empty())
+    {
+      const std::filesystem::file_time_type t = get_modified_or_created_time(w.root / w.filename, success);
+      if (success)
+        ret.emplace(w.filename, t);
+      return ret;
+    }
+
+    const auto add_entry = [&](const std::filesystem::directory_entry& e)
+    {
+      std::error_code ec;
+      if (!e.is_regular_file(ec) && !e.is_symlink(ec))
+        return;
+      const std::filesystem::file_time_type t = get_modified_or_created_time(e.path(), success);
+      if (success)
+        ret.emplace(e.path().lexically_relative(w.root), t);
+    };
+
+    std::error_code ec;
+    constexpr auto options = std::filesystem::directory_options::follow_directory_symlink | std::filesystem::directory_options::skip_permission_denied;
+    if (w.recursive)
+    {
+      for (auto it = std::filesystem::recursive_directory_iterator(w.root, options, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+      {
+        if (ec) continue;
+        add_entry(*it);
+      }
+    }
+    else
+    {
+      for (auto it = std::filesystem::directory_iterator(w.root, options, ec); it != std::filesystem::directory_iterator(); it.increment(ec))
+      {
+        if (ec) continue;
+        add_entry(*it);
+      }
+    }
+    return ret;
+  }
+
+  void fs_watcher::poll_watches()
+  {
+    // copy the watches so the scan is done outside the lock:
+    std::vector<std::pair<id_t, watch_t>> to_scan;
+    {
+      std::lock_guard _l(lock);
+      for (const auto& it : watches)
+      {
+        if (!it.second.use_polling)
+          continue;
+        watch_t& w = to_scan.emplace_back(it.first, watch_t{}).second;
+        w.root = it.second.root;
+        w.filename = it.second.filename;
+        w.recursive = it.second.recursive;
+      }
+    }
+    if (to_scan.empty())
+      return;
+
+    TRACY_SCOPED_ZONE;
+    for (auto& it : to_scan)
+    {
+      std::map<std::filesystem::path, std::filesystem::file_time_type> current = scan(it.second);
+
+      std::lock_guard _l(lock);
+      auto wit = watches.find(it.first);
+      if (wit == watches.end())
+        continue;
+      watch_t& w = wit->second;
+      const clock::time_point now = clock::now();
+
+      for (const auto& entry : current)
+      {
+        auto sit = w.snapshot.find(entry.first);
+        if (sit == w.snapshot.end())
+          push_event_unlocked(w, std::filesystem::path(entry.first), event_type::created, false, now);
+        else if (sit->second != entry.second)
+          push_event_unlocked(w, std::filesystem::path(entry.first), event_type::modified, false, now);
+      }
+      for (const auto& entry : w.snapshot)
+      {
+        if (!current.contains(entry.first))
+          push_event_unlocked(w, std::filesystem::path(entry.first), event_type::removed, false, now);
+      }
+      w.snapshot = std::move(current);
+    }
+  }
+}
+
@@ -0,0 +1,163 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <ntools/id/id.hpp>
+#include <ntools/mt_check/map.hpp>
+#include <ntools/spinlock.hpp>
+
+namespace neam::hydra
+{
+  /// \brief Shared file-system watch service
+  /// Backed by inotify on linux (events are coalesced and dispatched in update(), no filesystem scan is done),
+  /// falls back to stat-polling when inotify is not available (or when the inotify watch limit is reached)
+  ///
+  /// \note update() is called by the io module every frame. Callbacks are called from update().
+  class fs_watcher
+  {
+    public:
+      enum class event_type : uint8_t
+      {
+        modified,
+        created,
+        removed,
+
+        // events were lost (inotify queue overflow, ...): everything under the watch should be considered dirty
+        overflow,
+      };
+
+      struct event_t
+      {
+        // relative to the watched directory (for file watches, the filename)
+        std::filesystem::path path;
+        event_type type;
+        bool is_directory = false;
+      };
+
+      /// \brief Called with a batch of coalesced events (a given path is present at most once)
+      using callback_t = std::function<void(std::vector<event_t>&& /*events*/)>;
+
+    public: // settings
+      // events are dispatched once there hasn't been any new event for the watch for this duration
+      std::chrono::milliseconds coalesce_delay { 100 };
+      // ... or when the first event of the batch is older than this
+      std::chrono::milliseconds max_coalesce_delay { 1000 };
+      // time between two scans for polled watches
+      std::chrono::milliseconds poll_interval { 1000 };
+
+    public:
+      fs_watcher();
+      ~fs_watcher();
+
+      /// \brief Watch a directory (and optionally all its sub-directories) for changes
+      /// \return id_t::invalid if the directory does not exist
+      [[nodiscard]] id_t watch_directory(const std::filesystem::path& dir, callback_t&& cb, bool recursive = false);
+
+      /// \brief Watch a single file for changes
+      /// \note The parent directory is watched, so the watch survives the file being replaced (write to tmp + rename)
+      /// \return id_t::invalid if the parent directory does not exist
+      [[nodiscard]] id_t watch_file(const std::filesystem::path& file, callback_t&& cb);
+
+      /// \brief Remove a watch. No callback for this watch will be called once the function returns
+      /// \note Can be called from inside a callback
+      void remove_watch(id_t wid);
+
+      /// \brief Remove all the watches
+      void remove_all_watches();
+
+      /// \brief Read the pending inotify events / scan the polled watches and dispatch the coalesced events
+      /// \note Non-blocking, but polled watches will do a (rate-limited) filesystem scan
+      void update();
+
+      /// \brief Return whether the inotify backend is in use (false: every watch is polled)
+      [[nodiscard]] bool is_using_inotify() const { return inotify_fd >= 0; }
+
+      [[nodiscard]] uint32_t get_watch_count() const;
+
+    private:
+      using clock = std::chrono::steady_clock;
+
+      struct watch_t
+      {
+        std::filesystem::path root; // directory
+        std::string filename; // non-empty for file watches
+        bool recursive = false;
+        bool use_polling = false;
+        callback_t callback;
+
+        // coalescing:
+        std::map<std::filesystem::path, event_t> pending;
+        clock::time_point first_event;
+        clock::time_point last_event;
+
+        // polling:
+        std::map<std::filesystem::path, std::filesystem::file_time_type> snapshot;
+      };
+
+      struct wd_entry_t
+      {
+        std::filesystem::path dir;
+        std::vector<id_t> watches;
+      };
+
+      id_t add_watch(std::filesystem::path&& root, std::string&& filename, bool recursive, callback_t&& cb);
+
+      void push_event_unlocked(watch_t& w, std::filesystem::path&& path, event_type type, bool is_directory, clock::time_point now);
+
+      // inotify:
+      bool add_directory_unlocked(id_t wid, const std::filesystem::path& dir);
+      bool add_recursive_unlocked(id_t wid, watch_t& w, const std::filesystem::path& dir, bool emit_files, clock::time_point now);
+      void remove_directories_unlocked(id_t wid, const std::filesystem::path& dir);
+      void read_inotify_events();
+
+      // polling:
+      std::map<std::filesystem::path, std::filesystem::file_time_type> scan(const watch_t& w) const;
+      void poll_watches();
+
+    private:
+      int inotify_fd = -1;
+
+      mutable spinlock lock;
+      std::mtc_map<id_t, watch_t> watches;
+      std::mtc_map<int, wd_entry_t> wds;
+      std::mtc_map<std::filesystem::path, int> dir_to_wd;
+      uint64_t watch_counter = 0;
+
+      spinlock update_lock;
+      std::atomic<std::thread::id> dispatching_thread;
+      clock::time_point last_poll;
+  };
+}
+
@@ -33,6 +33,8 @@
 
 #include <hydra/utilities/memory_allocator.hpp>
 #include <hydra/utilities/deferred_fence_execution.hpp>
+#include <hydra/utilities/staging_ring.hpp>
+#include <hydra/utilities/gpu_profiler.hpp>
 #include <hydra/utilities/shader_manager.hpp>
 #include <hydra/utilities/pipeline_manager.hpp>
 #include <hydra/utilities/command_pool_manager.hpp>
@@ -40,6 +42,8 @@
 #include <hydra/utilities/descriptor_allocator.hpp>
 #include <hydra/renderer/renderer.hpp>
 #include <hydra/renderer/resources/texture_manager.hpp>
+#include <hydra/renderer/resources/transform_manager.hpp>
+#include <hydra/renderer/resources/mesh_manager.hpp>
 
 #include <hydra/ecs/ecs.hpp>
 
@@ -54,6 +58,8 @@ namespace neam::hydra
 
     // rendering stuff:
     memory_allocator allocator = { device };
+    staging_ring staging { *this }; // must outlive the dfe
+    gpu_profiler gpu_prof { *this }; // must outlive the dfe
     deferred_fence_execution dfe { *this };
     shader_manager shmgr = { device, res };
     pipeline_manager ppmgr = { *this, device };
@@ -66,6 +72,8 @@ namespace neam::hydra
     descriptor_allocator da { *this };
 
     texture_manager textures { *this };
+    transform_manager transforms { *this };
+    mesh_manager meshes { *this };
 
     using vk_context::vk_context;
 
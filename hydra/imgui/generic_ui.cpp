@@ -28,7 +28,10 @@
 #include <fmt/format.h>
 #include <ntools/rle/walker.hpp>
 #include <ntools/hash/hash.hpp>
+#include <ntools/hash/fnv1a.hpp>
 #include <ntools/sys_utils.hpp>
+#include <ntools/spinlock.hpp>
+#include <ntools/tracy.hpp>
 
 #include "imgui.hpp"
 #include "generic_ui.hpp"
@@ -246,6 +249,20 @@ namespace neam::hydra::imgui
     memcpy(payload.ec.allocate(sizeof(T)), addr, sizeof(T));
   }
 
+  static void unknown_raw_type_helper(const rle::serialization_metadata& md, const rle::type_metadata& type, helpers::payload_arg_t payload, const uint8_t* addr, size_t size)
+  {
+    if (generic_ui::BeginEntryTable(payload))
+    {
+      ImGui::TableNextRow();
+      ImGui::TableSetColumnIndex(0);
+      generic_ui::member_name_ui(payload, type);
+      ImGui::TableSetColumnIndex(1);
+      ImGui::Text("unknown %u byte data", (uint32_t)size);
+    }
+    generic_ui::EndEntryTable(payload);
+    memcpy(payload.ec.allocate(size), addr, size);
+  }
+
 #define N_GUI_RAW_TYPE_BASE(Type, VectType, IGDT) \
   {rle::serialization_metadata::hash_of<Type>(), &raw_type_helper<Type, VectType, ImGuiDataType_##IGDT>}
 
@@ -327,6 +344,53 @@ namespace neam::hydra::imgui
     raw_type_helpers().erase(target_type);
   }
 
+  /// \brief Flat list of the widgets of a type with a fixed layout, with their offset in the serialized data
+  /// Avoids walking the metadata (and re-serializing the data) every frame.
+  struct helpers::ui_plan_t
+  {
+    enum class op_type : uint8_t
+    {
+      raw,
+      tuple_pre,
+      tuple_post,
+    };
+
+    struct op_t
+    {
+      op_type type;
+      bool initial = false;
+      uint32_t count = 0;
+
+      size_t offset = 0;
+      size_t size = 0;
+      on_type_raw_fnc_t on_type_raw = nullptr;
+
+      const rle::type_metadata* type_md = nullptr;
+      const rle::type_reference* ref = nullptr;
+      std::string member_name;
+    };
+
+    rle::serialization_metadata md;
+    uint64_t metadata_hash = 0; // hash of the serialized md, the root alone does not identify the version of the type
+    std::vector<op_t> ops;
+
+    const uint8_t* compiled_data = nullptr; // only valid during the compilation
+    size_t data_size = 0;
+    size_t raw_size = 0; // sum of the size of the raw ops
+    bool fixed_layout = true;
+
+    void add_op(op_type type, const rle::type_metadata& type_md, payload_arg_t payload)
+    {
+      ops.push_back({ .type = type, .type_md = &type_md, .ref = payload.ref, .member_name = payload.member_name });
+    }
+  };
+
+  void helpers::mark_dynamic_layout(payload_arg_t payload)
+  {
+    if (payload.plan != nullptr)
+      payload.plan->fixed_layout = false;
+  }
+
   struct generic_ui_walker : public rle::empty_walker<helpers::payload_arg_t>
   {
     struct encoder_swap_t
@@ -343,41 +407,48 @@ namespace neam::hydra::imgui
     static uint32_t get_type_helper_count() { return (uint32_t)type_helpers().size(); }
     static helpers::type_helper_t* get_type_helper(uint32_t index) { return &type_helpers()[index]; }
 
-    static void on_type_raw(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload, const uint8_t* addr, size_t size)
+    static helpers::on_type_raw_fnc_t get_raw_type_helper(const rle::type_metadata& type, size_t size)
     {
       if (const auto it = raw_type_helpers().find(type.hash); it != raw_type_helpers().end())
-      {
-        it->second(md, type, payload, addr, size);
-        return;
-      }
+        return it->second;
 
       // not found: generic output:
       switch (size)
       {
-        case 1: raw_type_helper<uint8_t, uint8_t, ImGuiDataType_U8, 1, "%02X">(md, type, payload, addr, size); break;
-        case 2: raw_type_helper<uint16_t, uint16_t, ImGuiDataType_U16, 1, "%04X">(md, type, payload, addr, size); break;
-        case 4: raw_type_helper<uint32_t, uint32_t, ImGuiDataType_U32, 1, "%08X">(md, type, payload, addr, size); break;
-        case 8: raw_type_helper<uint64_t, uint64_t, ImGuiDataType_U64, 1, "%016lX">(md, type, payload, addr, size); break;
-        default:
+        case 1: return &raw_type_helper<uint8_t, uint8_t, ImGuiDataType_U8, 1, "%02X">;
+        case 2: return &raw_type_helper<uint16_t, uint16_t, ImGuiDataType_U16, 1, "%04X">;
+        case 4: return &raw_type_helper<uint32_t, uint32_t, ImGuiDataType_U32, 1, "%08X">;
+        case 8: return &raw_type_helper<uint64_t, uint64_t, ImGuiDataType_U64, 1, "%016lX">;
+        default: return &unknown_raw_type_helper;
+      }
+    }
+
+    static void on_type_raw(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload, const uint8_t* addr, size_t size)
+    {
+      const helpers::on_type_raw_fnc_t on_type_raw_fnc = get_raw_type_helper(type, size);
+      if (payload.plan != nullptr)
+      {
+        helpers::ui_plan_t& plan = *payload.plan;
+        if (addr < plan.compiled_data || addr + size > plan.compiled_data + plan.data_size)
         {
-          if (generic_ui::BeginEntryTable(payload))
-          {
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0);
-            generic_ui::member_name_ui(payload, type);
-            ImGui::TableSetColumnIndex(1);
-            ImGui::Text("unknown %u byte data", (uint32_t)size);
-            memcpy(payload.ec.allocate(type.size), addr, size);
-          }
-          generic_ui::EndEntryTable(payload);
+          plan.fixed_layout = false;
+        }
+        else
+        {
+          plan.add_op(helpers::ui_plan_t::op_type::raw, type, payload);
+          plan.ops.back().offset = addr - plan.compiled_data;
+          plan.ops.back().size = size;
+          plan.ops.back().on_type_raw = on_type_raw_fnc;
+          plan.raw_size += size;
         }
-        break;
       }
+      on_type_raw_fnc(md, type, payload, addr, size);
     }
 
     static container_edit_t on_type_container_pre(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload,
                                       uint32_t count, const rle::type_metadata& sub_type)
     {
+      helpers::mark_dynamic_layout(payload);
       const bool payload_was_enabled = payload.enabled;
       const bool is_colapsible_open = (generic_ui::BeginCollapsingHeader(payload, ("##otc"+payload.member_name).c_str()));
       if (payload_was_enabled)
@@ -457,6 +528,16 @@ namespace neam::hydra::imgui
     static bool on_type_tuple_pre(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload, uint32_t count)
     {
       bool initial = payload.id == 0;
+      if (payload.plan != nullptr)
+      {
+        payload.plan->add_op(helpers::ui_plan_t::op_type::tuple_pre, type, payload);
+        payload.plan->ops.back().initial = initial;
+        payload.plan->ops.back().count = count;
+      }
+      return tuple_pre(type, payload, count, initial);
+    }
+    static bool tuple_pre(const rle::type_metadata& type, payload_arg_t payload, uint32_t count, bool initial)
+    {
       if (count == 0) return initial;
       if (!payload.enabled) return initial;
 
@@ -467,6 +548,16 @@ namespace neam::hydra::imgui
       return initial;
     }
     static void on_type_tuple_post(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload, uint32_t count, bool initial)
+    {
+      if (payload.plan != nullptr)
+      {
+        payload.plan->add_op(helpers::ui_plan_t::op_type::tuple_post, type, payload);
+        payload.plan->ops.back().initial = initial;
+        payload.plan->ops.back().count = count;
+      }
+      tuple_post(payload, count, initial);
+    }
+    static void tuple_post(payload_arg_t payload, uint32_t count, bool initial)
     {
       if (count == 0) return;
       if (!payload.enabled) return;
@@ -488,6 +579,7 @@ namespace neam::hydra::imgui
 
     static void on_type_variant_empty(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload)
     {
+      helpers::mark_dynamic_layout(payload);
 
       if (generic_ui::BeginEntryTable(payload))
       {
@@ -525,6 +617,7 @@ namespace neam::hydra::imgui
     static encoder_swap_t on_type_variant_pre_entry(const rle::serialization_metadata& md, const rle::type_metadata& type, payload_arg_t payload,
         uint32_t index, const rle::type_metadata& sub_type)
     {
+      helpers::mark_dynamic_layout(payload);
       encoder_swap_t es;
       bool encoded = false;
       if (generic_ui::BeginEntryTable(payload))
@@ -588,15 +681,231 @@ namespace neam::hydra::imgui
     return rle::walker<generic_ui_walker>::walk_type_generic(md, type, dc, payload);
   }
 
-  raw_data generate_ui(const raw_data& rd, const rle::serialization_metadata& md)
+  struct cached_metadata_t
+  {
+    std::shared_ptr<rle::serialization_metadata> md;
+    uint64_t hash; // hash of the re-serialized metadata
+  };
+
+  struct ui_plan_cache_t
+  {
+    spinlock lock;
+    std::map<rle::type_hash_t, std::shared_ptr<helpers::ui_plan_t>> plans;
+    std::map<uint64_t, cached_metadata_t> metadata;
+    std::atomic<bool> use_ui_plans = true;
+  };
+
+  static ui_plan_cache_t& get_ui_plan_cache()
+  {
+    static ui_plan_cache_t cache;
+    return cache;
+  }
+
+  static raw_data walk_ui(const raw_data& rd, const rle::serialization_metadata& md, helpers::ui_plan_t* plan)
   {
     cr::memory_allocator ma;
     helpers::payload_t payload
     {
       .ec = {ma},
+      .plan = plan,
     };
     rle::walker<generic_ui_walker>::walk(rd, md, payload);
     return payload.ec.to_raw_data();
   }
-}
 
+  static uint64_t hash_metadata(const rle::serialization_metadata& md)
+  {
+    TRACY_SCOPED_ZONE;
+    const raw_data serialized_md = rle::serialize(md);
+    return ct::hash::fnv1a<64>((const uint8_t*)serialized_md.get(), serialized_md.size);
+  }
+
+  /// \brief Compile the plan for the type of \p md while generating the UI
+  static raw_data compile_ui_plan(const raw_data& rd, const rle::serialization_metadata& md, uint64_t md_hash)
+  {
+    TRACY_SCOPED_ZONE;
+    std::shared_ptr<helpers::ui_plan_t> plan = std::make_shared<helpers::ui_plan_t>();
+    plan->md = md;
+    plan->metadata_hash = md_hash;
+    plan->compiled_data = (const uint8_t*)rd.get();
+    plan->data_size = rd.size;
+
+    raw_data ret = walk_ui(rd, plan->md, plan.get());
+
+    plan->compiled_data = nullptr;
+    // the walker might have patched the data (versioning, ...), in which case the layout of rd cannot be trusted:
+    if (ret.size != rd.size)
+      plan->fixed_layout = false;
+    if (!plan->fixed_layout)
+    {
+      plan->ops.clear();
+      plan->ops.shrink_to_fit();
+    }
+
+    ui_plan_cache_t& cache = get_ui_plan_cache();
+    std::lock_guard _l(cache.lock);
+    cache.plans.insert_or_assign(md.root, std::move(plan));
+    return ret;
+  }
+
+  /// \brief Run the plan directly over \p rd, patching the modified values in place
+  /// \return whether the data was modified
+  static bool run_ui_plan(raw_data& rd, helpers::ui_plan_t& plan)
+  {
+    TRACY_SCOPED_ZONE;
+    using op_type = helpers::ui_plan_t::op_type;
+
+    uint8_t* const data = (uint8_t*)rd.get();
+    cr::memory_allocator ma;
+    helpers::payload_t payload
+    {
+      .ec = {ma},
+    };
+
+    // generate the UI, the raw helpers output their values (in order) in the encoder:
+    for (const helpers::ui_plan_t::op_t& op : plan.ops)
+    {
+      payload.member_name = op.member_name;
+      payload.ref = op.ref;
+      switch (op.type)
+      {
+        case op_type::raw:
+          op.on_type_raw(plan.md, *op.type_md, payload, data + op.offset, op.size);
+          break;
+        case op_type::tuple_pre:
+          generic_ui_walker::tuple_pre(*op.type_md, payload, op.count, op.initial);
+          break;
+        case op_type::tuple_post:
+          generic_ui_walker::tuple_post(payload, op.count, op.initial);
+          break;
+      }
+      payload.ref = nullptr;
+    }
+
+    const raw_data values = payload.ec.to_raw_data();
+    if (!check::debug::n_check(values.size == plan.raw_size, "generic_ui: raw helpers output {} bytes, expected {} bytes", values.size, plan.raw_size))
+    {
+      // don't use the plan anymore and fallback to the walker:
+      plan.fixed_layout = false;
+      return false;
+    }
+
+    // patch the modified values:
+    bool changed = false;
+    const uint8_t* it = (const uint8_t*)values.get();
+    for (const helpers::ui_plan_t::op_t& op : plan.ops)
+    {
+      if (op.type != op_type::raw)
+        continue;
+      if (memcmp(data + op.offset, it, op.size) != 0)
+      {
+        memcpy(data + op.offset, it, op.size);
+        changed = true;
+      }
+      it += op.size;
+    }
+    return changed;
+  }
+
+  static std::shared_ptr<helpers::ui_plan_t> get_ui_plan(const rle::serialization_metadata& md)
+  {
+    ui_plan_cache_t& cache = get_ui_plan_cache();
+    if (!cache.use_ui_plans.load(std::memory_order_relaxed))
+      return {};
+    std::lock_guard _l(cache.lock);
+    if (auto it = cache.plans.find(md.root); it != cache.plans.end())
+      return it->second;
+    return {};
+  }
+
+  static cached_metadata_t get_metadata(const raw_data& md)
+  {
+    const uint64_t raw_hash = ct::hash::fnv1a<64>((const uint8_t*)md.get(), md.size);
+    ui_plan_cache_t& cache = get_ui_plan_cache();
+    {
+      std::lock_guard _l(cache.lock);
+      if (auto it = cache.metadata.find(raw_hash); it != cache.metadata.end())
+        return it->second;
+    }
+    std::shared_ptr<rle::serialization_metadata> ret = std::make_shared<rle::serialization_metadata>(rle::deserialize<rle::serialization_metadata>(md));
+    // hash the re-serialized metadata, so the hash matches the one of the rle::serialization_metadata overloads:
+    const uint64_t md_hash = hash_metadata(*ret);
+    std::lock_guard _l(cache.lock);
+    cache.metadata.insert_or_assign(raw_hash, cached_metadata_t{ ret, md_hash });
+    return { std::move(ret), md_hash };
+  }
+  static raw_data walk_or_compile_ui_plan(const raw_data& rd, const rle::serialization_metadata& md, uint64_t md_hash, const std::shared_ptr<helpers::ui_plan_t>& plan)
+  {
+    if (!get_ui_plan_cache().use_ui_plans.load(std::memory_order_relaxed))
+      return walk_ui(rd, md, nullptr);
+    // no plan, or the plan is for another version of the type:
+    if (!plan || plan->fixed_layout || plan->metadata_hash != md_hash)
+      return compile_ui_plan(rd, md, md_hash);
+    return walk_ui(rd, md, nullptr);
+  }
+
+  static bool can_run_ui_plan(const raw_data& rd, uint64_t md_hash, const std::shared_ptr<helpers::ui_plan_t>& plan)
+  {
+    return plan && plan->fixed_layout && plan->metadata_hash == md_hash && plan->data_size == rd.size;
+  }
+
+  static bool generate_ui_in_place(raw_data& rd, const rle::serialization_metadata& md, uint64_t md_hash)
+  {
+    std::shared_ptr<helpers::ui_plan_t> plan = get_ui_plan(md);
+    if (can_run_ui_plan(rd, md_hash, plan))
+      return run_ui_plan(rd, *plan);
+
+    raw_data ret = walk_or_compile_ui_plan(rd, md, md_hash, plan);
+    if (raw_data::is_same(rd, ret))
+      return false;
+    rd = std::move(ret);
+    return true;
+  }
+
+  static raw_data generate_ui(const raw_data& rd, const rle::serialization_metadata& md, uint64_t md_hash)
+  {
+    std::shared_ptr<helpers::ui_plan_t> plan = get_ui_plan(md);
+    if (can_run_ui_plan(rd, md_hash, plan))
+    {
+      raw_data ret = rd.duplicate();
+      run_ui_plan(ret, *plan);
+      return ret;
+    }
+    return walk_or_compile_ui_plan(rd, md, md_hash, plan);
+  }
+
+  bool generate_ui_in_place(raw_data& rd, const rle::serialization_metadata& md)
+  {
+    return generate_ui_in_place(rd, md, hash_metadata(md));
+  }
+
+  bool generate_ui_in_place(raw_data& rd, const raw_data& md)
+  {
+    const cached_metadata_t metadata = get_metadata(md);
+    return generate_ui_in_place(rd, *metadata.md, metadata.hash);
+  }
+
+  raw_data generate_ui(const raw_data& rd, const rle::serialization_metadata& md)
+  {
+    return generate_ui(rd, md, hash_metadata(md));
+  }
+
+  raw_data generate_ui(const raw_data& rd, const raw_data& md)
+  {
+    const cached_metadata_t metadata = get_metadata(md);
+    return generate_ui(rd, *metadata.md, metadata.hash);
+  }
+
+  void _set_use_ui_plans(bool enabled)
+  {
+    get_ui_plan_cache().use_ui_plans.store(enabled, std::memory_order_relaxed);
+  }
+
+  void _clear_ui_plan_cache()
+  {
+    ui_plan_cache_t& cache = get_ui_plan_cache();
+    std::lock_guard _l(cache.lock);
+    cache.plans.clear();
+    cache.metadata.clear();
+  }
+}
@@ -36,10 +36,22 @@ namespace neam::hydra::imgui
   /// (that type might not necessarily be in the current executable, as long as the metadata is availlable)
   raw_data generate_ui(const raw_data& rd, const rle::serialization_metadata& md);
 
-  inline raw_data generate_ui(const raw_data& rd, const raw_data& md)
-  {
-    return generate_ui(rd, rle::deserialize<rle::serialization_metadata>(md));
-  }
+  /// \brief Generate an imgui UI for a given type (serialized metadata version)
+  /// \note The deserialized metadata is cached (keyed by the hash of \p md)
+  raw_data generate_ui(const raw_data& rd, const raw_data& md);
+
+  /// \brief Generate an imgui UI for a given type, editing \p rd in place
+  /// \return whether \p rd was modified
+  /// \note Types with a fixed layout (no containers, variants or type-helpers) use a cached UI plan
+  ///       and are patched in place instead of being re-serialized every frame.
+  bool generate_ui_in_place(raw_data& rd, const rle::serialization_metadata& md);
+  bool generate_ui_in_place(raw_data& rd, const raw_data& md);
+
+  /// \brief If false, the UI plans are neither compiled nor used (everything goes through the walker)
+  /// \note For benchmarks and debug
+  void _set_use_ui_plans(bool enabled);
+  /// \brief Drop the cached UI plans and deserialized metadata
+  void _clear_ui_plan_cache();
 
   // helpers:
   template<typename Type>
@@ -56,6 +68,8 @@ namespace neam::hydra::imgui
 
   namespace helpers
   {
+    struct ui_plan_t;
+
     struct payload_t
     {
       rle::encoder ec;
@@ -68,6 +82,9 @@ namespace neam::hydra::imgui
       const rle::type_reference* ref = nullptr;
 
       uint32_t id = 0;
+
+      // set when compiling a UI plan:
+      ui_plan_t* plan = nullptr;
     };
     using payload_arg_t = payload_t&;
 
@@ -99,6 +116,10 @@ namespace neam::hydra::imgui
       on_type_raw_fnc_t on_type_raw = nullptr;
     };
 
+    /// \brief Indicate that the layout of the serialized data depends on its content (the UI plan being compiled cannot be used)
+    /// \note Called for all the type-helpers
+    void mark_dynamic_layout(payload_arg_t payload);
+
     /// \brief Add a new helper.
     void add_generic_ui_type_helper(const type_helper_t& h);
     void remove_generic_ui_type_helper(walk_type_fnc_t fnc);
@@ -126,13 +147,18 @@ namespace neam::hydra::imgui
             {
               Child::get_type_metadata(),
               Child::get_custom_helper_id(),
-              &Child::walk_type,
+              &walk_type_thunk,
               Child::get_type_name,
             });
         }
         static void unregister_child()
         {
-          remove_generic_ui_type_helper(&Child::walk_type);
+          remove_generic_ui_type_helper(&walk_type_thunk);
+        }
+        static void walk_type_thunk(const rle::serialization_metadata& md, const rle::type_metadata& type, rle::decoder& dc, payload_arg_t payload)
+        {
+          mark_dynamic_layout(payload);
+          Child::walk_type(md, type, dc, payload);
         }
         static inline struct raii_register
         {
@@ -0,0 +1,129 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <cstring>
+
+#include <hydra/engine/hydra_context.hpp>
+#include <ntools/tracy.hpp>
+
+#include "imgui_geometry_ring.hpp"
+
+namespace neam::hydra::imgui
+{
+  geometry_ring::allocation geometry_ring::write(const ImDrawData& draw_data)
+  {
+    TRACY_SCOPED_ZONE;
+    const size_t vertex_size = draw_data.TotalVtxCount * sizeof(ImDrawVert);
+    const size_t index_size = draw_data.TotalIdxCount * sizeof(ImDrawIdx);
+    const size_t index_offset = align(vertex_size);
+
+    const uint32_t region = acquire_region(index_offset + index_size);
+    const size_t region_offset = region * current->region_size;
+    {
+      ImDrawVert* it_vtx_dst = (ImDrawVert*)(current->memory + region_offset);
+      ImDrawIdx* it_idx_dst = (ImDrawIdx*)(current->memory + region_offset + index_offset);
+
+      for (int n = 0; n < draw_data.CmdListsCount; n++)
+      {
+        const ImDrawList* cmd_list = draw_data.CmdLists[n];
+        memcpy(it_vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        memcpy(it_idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        it_vtx_dst += cmd_list->VtxBuffer.Size;
+        it_idx_dst += cmd_list->IdxBuffer.Size;
+      }
+    }
+
+    allocation ret;
+    ret.storage = current;
+    ret.region = region;
+    ret.vertex_offset = region_offset;
+    ret.index_offset = region_offset + index_offset;
+    return ret;
+  }
+
+  void geometry_ring::release(uint32_t queue_mask, allocation&& alloc)
+  {
+    if (!alloc.is_valid())
+      return;
+    hctx.dfe.defer(queue_mask, [storage = std::move(alloc.storage), region = alloc.region]
+    {
+      storage->region_in_use[region].store(false, std::memory_order_release);
+    });
+  }
+
+  void geometry_ring::release(allocation&& alloc)
+  {
+    if (!alloc.is_valid())
+      return;
+    alloc.storage->region_in_use[alloc.region].store(false, std::memory_order_release);
+    alloc.storage.reset();
+  }
+
+  uint32_t geometry_ring::acquire_region(size_t size)
+  {
+    TRACY_SCOPED_ZONE;
+    if (current && size <= current->region_size)
+    {
+      for (uint32_t i = 0; i < k_region_count; ++i)
+      {
+        const uint32_t region = (current->next_region + i) % k_region_count;
+        if (!current->region_in_use[region].exchange(true, std::memory_order_acquire))
+        {
+          current->next_region = (region + 1) % k_region_count;
+          return region;
+        }
+      }
+    }
+
+    // Either the frame overflows the regions or all of them are still in use by the gpu:
+    // create a new ring. The previous one is kept alive by the frames still using it.
+    size_t region_size = current ? current->region_size : k_min_region_size;
+    while (region_size < size)
+      region_size *= 2;
+
+    std::shared_ptr<storage_t> storage = std::make_shared<storage_t>();
+    vk::buffer buffer { hctx.device, region_size * k_region_count, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT };
+    buffer._set_debug_name("imgui::geometry-ring");
+    memory_allocation alloc = hctx.allocator.allocate_memory
+    (
+      buffer.get_memory_requirements(),
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      allocation_type::persistent | allocation_type::mapped_memory
+    );
+    buffer.bind_memory(*alloc.mem(), alloc.offset());
+    storage->memory = (uint8_t*)alloc.mem()->map_memory(alloc.offset());
+    storage->buffer.emplace(std::move(alloc), std::move(buffer));
+    storage->region_size = region_size;
+    storage->next_region = 1;
+    storage->region_in_use[0].store(true, std::memory_order_relaxed);
+
+    cr::out().debug("imgui: created a geometry ring of {} KiB per frame", region_size / 1024);
+    current = std::move(storage);
+    ++growth_count;
+    return 0;
+  }
+}
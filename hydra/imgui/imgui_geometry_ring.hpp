@@ -0,0 +1,123 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include <imgui.h>
+
+#include <hydra/utilities/holders.hpp>
+
+namespace neam::hydra
+{
+  struct hydra_context;
+}
+
+namespace neam::hydra::imgui
+{
+  /// \brief Persistently mapped, host-visible buffer holding the vertices/indices of the last frames
+  /// Split in k_region_count regions, one per frame in flight. The draw lists are written directly in a free region,
+  /// which is released once the gpu is done with it.
+  /// The ring only grows (doubling the region size) when a frame does not fit or when every region is still in use.
+  class geometry_ring
+  {
+    public:
+      /// \brief Number of regions in the ring. A region is in use from write() until release().
+      static constexpr uint32_t k_region_count = 3;
+      static constexpr size_t k_min_region_size = 256 * 1024;
+      static constexpr size_t k_alignment = 256;
+
+    private:
+      /// \brief Reference-counted so that in-flight frames keep it alive after the ring has grown.
+      struct storage_t
+      {
+        std::optional<buffer_holder> buffer;
+        uint8_t* memory = nullptr;
+        size_t region_size = 0;
+        uint32_t next_region = 0;
+        std::atomic<bool> region_in_use[k_region_count] = {};
+      };
+
+    public:
+      /// \brief A region of the ring holding the geometry of a frame
+      class allocation
+      {
+        public:
+          allocation() = default;
+          allocation(allocation&&) = default;
+          allocation& operator = (allocation&&) = default;
+
+          bool is_valid() const { return storage != nullptr; }
+
+          const vk::buffer& get_buffer() const { return storage->buffer->buffer; }
+          size_t get_vertex_offset() const { return vertex_offset; }
+          size_t get_index_offset() const { return index_offset; }
+
+        private:
+          std::shared_ptr<storage_t> storage;
+          uint32_t region = 0;
+          size_t vertex_offset = 0;
+          size_t index_offset = 0;
+
+          friend geometry_ring;
+      };
+
+    public:
+      geometry_ring(hydra_context& _hctx) : hctx(_hctx) {}
+
+      /// \brief Copy the vertices and indices of the draw lists in a free region of the ring (growing the ring if necessary)
+      allocation write(const ImDrawData& draw_data);
+
+      /// \brief Release the region once the gpu is done with the queues of \p queue_mask
+      void release(uint32_t queue_mask, allocation&& alloc);
+
+      /// \brief Immediately release the region. The gpu must not be using it.
+      static void release(allocation&& alloc);
+
+      /// \brief Size of a region of the current ring (0 if the ring has not been created yet)
+      size_t get_region_size() const { return current ? current->region_size : 0; }
+      /// \brief Number of time the ring has been created / grown
+      uint32_t get_growth_count() const { return growth_count; }
+
+    private:
+      static size_t align(size_t size)
+      {
+        return (size + k_alignment - 1) & ~(k_alignment - 1);
+      }
+
+      /// \brief Return a free region of the ring that can hold at least \p size bytes, growing the ring if necessary
+      uint32_t acquire_region(size_t size);
+
+    private:
+      hydra_context& hctx;
+      std::shared_ptr<storage_t> current;
+      uint32_t growth_count = 0;
+  };
+}
@@ -27,12 +27,14 @@
 #pragma once
 
 #include <hydra/renderer/generic_shaders/blur.hpp>
+#include <hydra/renderer/render_graph.hpp>
 #include <hydra/engine/hydra_context.hpp>
 #include <hydra/utilities/holders.hpp>
 
 #include "imgui_context.hpp"
 #include "shader_structs.hpp"
 #include "imgui_drawdata.hpp"
+#include "imgui_geometry_ring.hpp"
 #include "imgui_engine_module.hpp"
 #include "imgui_setup_pass.hpp"
 #include <ntools/container_utils.hpp>
@@ -54,14 +56,16 @@ namespace neam::hydra::imgui::components
       {}
 
     private:
+      // imgui draw lists are usually one per window, and are recorded in parallel by batches of this size
+      static constexpr uint32_t k_draw_lists_per_batch = 4;
+
       struct prepare_state_t
       {
-        buffer_holder vertex_buffer;
-        buffer_holder index_buffer;
-
-        renderer::exported_image backbuffer;
+        // heap allocated, as the render graph pass references it
+        std::unique_ptr<geometry_ring::allocation> geometry;
 
-        std::map<ImTextureID, vk::descriptor_set> textures_ds_cache;
+        // the graph handles the transition of the backbuffer (and the write-back of its state for the following passes)
+        std::unique_ptr<renderer::render_graph> graph;
       };
 
     private:
@@ -128,60 +132,42 @@ namespace neam::hydra::imgui::components
 
         const ImDrawData* draw_data = &(((draw_data_t*)imgui_viewport->RendererUserData)->draw_data);
 
-        // Create or resize the vertex/index buffers
-        const size_t vertex_size = draw_data->TotalVtxCount * sizeof(ImDrawVert);
-        const size_t index_size = draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+        // Write the geometry directly to a free region of the ring (growing it if the frame does not fit)
+        auto geometry = std::make_unique<geometry_ring::allocation>(geometry_buffer.write(*draw_data));
 
-        buffer_holder vertex_buffer(hctx.allocator, vk::buffer(hctx.device, vertex_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT), hydra::allocation_type::short_lived);
-        vertex_buffer.buffer._set_debug_name("imgui::vertex-buffer");
-
-        buffer_holder index_buffer(hctx.allocator, vk::buffer(hctx.device, index_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT), hydra::allocation_type::short_lived);
-        index_buffer.buffer._set_debug_name("imgui::index-buffer");
-
-        // Upload data to the buffers:
+        auto graph = std::make_unique<renderer::render_graph>(hctx, "imgui::render_graph");
+        const renderer::rg_resource backbuffer = import_image(*graph, renderer::k_context_final_output);
+        graph->add_pass("imgui", hctx.gqueue, [this, backbuffer, geometry = geometry.get()](vk::command_buffer_recorder& cbr, renderer::render_graph& rg)
         {
-          raw_data vtx_dst = raw_data::allocate(vertex_size);
-          raw_data idx_dst = raw_data::allocate(index_size);
-          {
-            ImDrawVert* it_vtx_dst = (ImDrawVert*)vtx_dst.get();
-            ImDrawIdx* it_idx_dst = (ImDrawIdx*)idx_dst.get();
-
-            for (int n = 0; n < draw_data->CmdListsCount; n++)
-            {
-              const ImDrawList* cmd_list = draw_data->CmdLists[n];
-              memcpy(it_vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-              memcpy(it_idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-              it_vtx_dst += cmd_list->VtxBuffer.Size;
-              it_idx_dst += cmd_list->IdxBuffer.Size;
-            }
-          }
-
-          gtctx.transfers.transfer(vertex_buffer.buffer, std::move(vtx_dst));
-          gtctx.transfers.release(vertex_buffer.buffer, hctx.gqueue);
-
-          gtctx.transfers.transfer(index_buffer.buffer, std::move(idx_dst));
-          gtctx.transfers.release(index_buffer.buffer, hctx.gqueue);
-        }
+          record_draw_data(cbr, rg.get_exported_image(backbuffer), *geometry);
+        })
+        // the pass loads the previous content of the backbuffer, so it reads it too:
+        .write(backbuffer, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+               VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        graph->compile();
 
         return
         {
-          .vertex_buffer = std::move(vertex_buffer),
-          .index_buffer = std::move(index_buffer),
-
-          .backbuffer = import_image(renderer::k_context_final_output, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+          .geometry = std::move(geometry),
+          .graph = std::move(graph),
         };
       }
 
       void submit(renderer::gpu_task_context& gtctx, vk::submit_info& si, prepare_state_t& ps)
+      {
+        ps.graph->submit(si);
+
+        // the region can be reused once the gpu is done with it:
+        geometry_buffer.release(hctx.dfe.queue_mask(hctx.gqueue), std::move(*ps.geometry));
+      }
+
+      void record_draw_data(vk::command_buffer_recorder& cbr, const renderer::exported_image& backbuffer, const geometry_ring::allocation& geometry)
       {
         const ImDrawData* draw_data = &(((draw_data_t*)imgui_viewport->RendererUserData)->draw_data);
 
         const int fb_width = (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
         const int fb_height = (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
 
-        vk::command_buffer cmd_buf = hctx.gcpm.get_pool().create_command_buffer();
-        cmd_buf._set_debug_name("imgui::command_buffer");
-        neam::hydra::vk::command_buffer_recorder cbr = cmd_buf.begin_recording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
         {
           neam::hydra::vk::cbr_debug_marker _dm(cbr, "imgui");
 
@@ -242,86 +228,104 @@ namespace neam::hydra::imgui::components
 
           // Render command lists
           // (Because we merged all buffers into a single one, we maintain our own offset into them)
-          int global_vtx_offset = 0;
-          int global_idx_offset = 0;
-
-          uint32_t im_texture_index = 0;
-          pipeline_barrier(cbr, ps.backbuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
-          begin_rendering(cbr, ps.backbuffer, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE);
-          for (int n = 0; n < draw_data->CmdListsCount; n++)
+          // The offsets are computed upfront, as the draw lists are recorded in parallel
+          struct draw_list_offsets_t
+          {
+            int global_vtx_offset;
+            int global_idx_offset;
+            uint32_t im_texture_index;
+          };
+          std::vector<draw_list_offsets_t> draw_list_offsets;
+          draw_list_offsets.reserve(draw_data->CmdListsCount);
           {
-            const ImDrawList* cmd_list = draw_data->CmdLists[n];
-            for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+            draw_list_offsets_t offsets { 0, 0, 0 };
+            for (int n = 0; n < draw_data->CmdListsCount; n++)
             {
-              uint32_t texture_index = im_texture_index;
-              ++im_texture_index;
+              const ImDrawList* cmd_list = draw_data->CmdLists[n];
+              draw_list_offsets.push_back(offsets);
+              offsets.global_idx_offset += cmd_list->IdxBuffer.Size;
+              offsets.global_vtx_offset += cmd_list->VtxBuffer.Size;
+              offsets.im_texture_index += cmd_list->CmdBuffer.Size;
+            }
+          }
 
-              if (auto it = im_to_tm_index.find(texture_index); it != im_to_tm_index.end())
-              {
-                texture_index = it->second | 0x80000000; // marker that the resource is from the texture manager
-              }
+          parallel_rendering(cbr, { backbuffer }, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE,
+                             (uint32_t)draw_data->CmdListsCount, k_draw_lists_per_batch,
+                             [&](vk::command_buffer_recorder& batch_cbr, uint32_t begin, uint32_t end)
+          {
+            for (uint32_t n = begin; n < end; n++)
+            {
+              const ImDrawList* cmd_list = draw_data->CmdLists[n];
+              const int global_vtx_offset = draw_list_offsets[n].global_vtx_offset;
+              const int global_idx_offset = draw_list_offsets[n].global_idx_offset;
+              uint32_t im_texture_index = draw_list_offsets[n].im_texture_index;
+              for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
               {
-                const glm::vec2 scale = glm::vec2(2.0f / draw_data->DisplaySize.x, 2.0f / draw_data->DisplaySize.y);
-                setup_renderstate(cbr, ps, scale, -1.0f - glm::vec2(draw_data->DisplayPos.x, draw_data->DisplayPos.y) * scale, {fb_width, fb_height}, cmd_i == 0, texture_index);
-              }
+                uint32_t texture_index = im_texture_index;
+                ++im_texture_index;
 
-              const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
-              if (pcmd->UserCallback != NULL)
-              {
-                // User callback, registered via ImDrawList::AddCallback()
-                // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
-                if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                if (auto it = im_to_tm_index.find(texture_index); it != im_to_tm_index.end())
+                {
+                  texture_index = it->second | 0x80000000; // marker that the resource is from the texture manager
+                }
                 {
                   const glm::vec2 scale = glm::vec2(2.0f / draw_data->DisplaySize.x, 2.0f / draw_data->DisplaySize.y);
-                  setup_renderstate(cbr, ps, scale, -1.0f - glm::vec2(draw_data->DisplayPos.x, draw_data->DisplayPos.y) * scale, {fb_width, fb_height}, cmd_i == 0, texture_index);
-                  // last_texture_id = nullptr;
+                  setup_renderstate(batch_cbr, geometry, scale, -1.0f - glm::vec2(draw_data->DisplayPos.x, draw_data->DisplayPos.y) * scale, {fb_width, fb_height}, cmd_i == 0, texture_index);
+                }
+
+                const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+                if (pcmd->UserCallback != NULL)
+                {
+                  // User callback, registered via ImDrawList::AddCallback()
+                  // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
+                  // NOTE: callbacks are called from the recording thread of their draw list
+                  if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                  {
+                    const glm::vec2 scale = glm::vec2(2.0f / draw_data->DisplaySize.x, 2.0f / draw_data->DisplaySize.y);
+                    setup_renderstate(batch_cbr, geometry, scale, -1.0f - glm::vec2(draw_data->DisplayPos.x, draw_data->DisplayPos.y) * scale, {fb_width, fb_height}, cmd_i == 0, texture_index);
+                    // last_texture_id = nullptr;
+                  }
+                  else
+                  {
+                    pcmd->UserCallback(cmd_list, pcmd);
+                  }
                 }
                 else
                 {
-                  pcmd->UserCallback(cmd_list, pcmd);
+                  // Project scissor/clipping rectangles into framebuffer space
+                  ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
+                  ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+
+                  // Clamp to viewport as vkCmdSetScissor() won't accept values that are off bounds
+                  if (clip_min.x < 0.0f) { clip_min.x = 0.0f; }
+                  if (clip_min.y < 0.0f) { clip_min.y = 0.0f; }
+                  if (clip_max.x > fb_width) { clip_max.x = (float)fb_width; }
+                  if (clip_max.y > fb_height) { clip_max.y = (float)fb_height; }
+                  if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+                    continue;
+
+                  VkRect2D scissor;
+                  scissor.offset.x = (int32_t)(clip_min.x);
+                  scissor.offset.y = (int32_t)(clip_min.y);
+                  scissor.extent.width = (uint32_t)(clip_max.x - clip_min.x);
+                  scissor.extent.height = (uint32_t)(clip_max.y - clip_min.y);
+
+
+                  batch_cbr.bind_descriptor_set(hctx, imgui_descriptor_set);
+                  batch_cbr.bind_descriptor_set(hctx, hctx.textures.get_descriptor_set());
+
+                  batch_cbr.set_scissor(scissor);
+                  batch_cbr.draw_indexed(pcmd->ElemCount, 1, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset, 0);
                 }
               }
-              else
-              {
-                // Project scissor/clipping rectangles into framebuffer space
-                ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
-                ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
-
-                // Clamp to viewport as vkCmdSetScissor() won't accept values that are off bounds
-                if (clip_min.x < 0.0f) { clip_min.x = 0.0f; }
-                if (clip_min.y < 0.0f) { clip_min.y = 0.0f; }
-                if (clip_max.x > fb_width) { clip_max.x = (float)fb_width; }
-                if (clip_max.y > fb_height) { clip_max.y = (float)fb_height; }
-                if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
-                  continue;
-
-                VkRect2D scissor;
-                scissor.offset.x = (int32_t)(clip_min.x);
-                scissor.offset.y = (int32_t)(clip_min.y);
-                scissor.extent.width = (uint32_t)(clip_max.x - clip_min.x);
-                scissor.extent.height = (uint32_t)(clip_max.y - clip_min.y);
-
-
-                cbr.bind_descriptor_set(hctx, imgui_descriptor_set);
-                cbr.bind_descriptor_set(hctx, hctx.textures.get_descriptor_set());
-
-                cbr.set_scissor(scissor);
-                cbr.draw_indexed(pcmd->ElemCount, 1, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset, 0);
-              }
             }
-            global_idx_offset += cmd_list->IdxBuffer.Size;
-            global_vtx_offset += cmd_list->VtxBuffer.Size;
-          }
-          cbr.end_rendering();
+          });
 
           hctx.dfe.defer_destruction(hctx.dfe.queue_mask(hctx.gqueue), std::move(imgui_descriptor_set.reset()));
         }
-        cmd_buf.end_recording();
-
-        si.on(hctx.gqueue).execute(cmd_buf);
-        hctx.dfe.defer_destruction(hctx.dfe.queue_mask(hctx.gqueue), std::move(cmd_buf));
       }
-      void setup_renderstate(vk::command_buffer_recorder& cbr, prepare_state_t& ps, glm::vec2 scale, glm::vec2 translate, glm::ivec2 fb_size, bool do_sample_back, uint32_t texture_index)
+
+      void setup_renderstate(vk::command_buffer_recorder& cbr, const geometry_ring::allocation& geometry, glm::vec2 scale, glm::vec2 translate, glm::ivec2 fb_size, bool do_sample_back, uint32_t texture_index)
       {
         TRACY_SCOPED_ZONE;
         cbr.bind_graphics_pipeline(hctx.ppmgr, "imgui::pipeline"_rid, vk::specialization
@@ -347,8 +351,8 @@ namespace neam::hydra::imgui::components
           viewport.maxDepth = 1.0f;
           cbr.set_viewport({viewport}, 0, 1);
         }
-        cbr.bind_vertex_buffer(ps.vertex_buffer.buffer, 0);
-        cbr.bind_index_buffer(ps.index_buffer.buffer, sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+        cbr.bind_vertex_buffer(geometry.get_buffer(), 0, geometry.get_vertex_offset());
+        cbr.bind_index_buffer(geometry.get_buffer(), sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32, geometry.get_index_offset());
 
         cbr.push_constants(pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT|VK_SHADER_STAGE_FRAGMENT_BIT, 0, imgui_push_constants
         {
@@ -361,6 +365,8 @@ namespace neam::hydra::imgui::components
       imgui_context& related_context;
       ImGuiViewport* imgui_viewport = nullptr;
 
+      geometry_ring geometry_buffer { hctx };
+
       friend gpu_task_producer_provider_t;
   };
 }
@@ -0,0 +1,121 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <imgui.h>
+#include <implot.h>
+
+#include "../../utilities/gpu_profiler.hpp"
+
+namespace neam
+{
+  /// \brief Simple window displaying the gpu_profiler history (frame times + zones of the last frame)
+  class imgui_gpu_profiler_window
+  {
+    public:
+      imgui_gpu_profiler_window(hydra::gpu_profiler& _profiler) : profiler(_profiler) {}
+
+      void show_gpu_profiler_window()
+      {
+        if (ImGui::Begin("GPU Profiler"))
+        {
+          bool enabled = profiler.is_enabled();
+          if (ImGui::Checkbox("Enabled", &enabled))
+            profiler.set_enabled(enabled);
+
+          const hydra::gpu_profiler::stats_t stats = profiler.get_stats();
+          ImGui::SameLine();
+          ImGui::Text("frames: %lu | zones: %lu | overflowed: %lu | dropped: %lu",
+                      (unsigned long)stats.resolved_frame_count, (unsigned long)stats.resolved_zone_count,
+                      (unsigned long)stats.overflowed_zone_count, (unsigned long)stats.dropped_zone_count);
+
+          const std::vector<hydra::gpu_profiler::frame_stats_t> history = profiler.get_history();
+          frame_times.clear();
+          frame_times.reserve(history.size());
+          for (const auto& it : history)
+            frame_times.push_back(it.gpu_time_ms);
+
+          if (ImPlot::BeginPlot("##gpu_frame_times", ImVec2(-1, 150), ImPlotFlags_NoMenus | ImPlotFlags_NoLegend))
+          {
+            ImPlot::SetupAxes(nullptr, "ms", ImPlotAxisFlags_NoTickLabels, ImPlotAxisFlags_AutoFit);
+            ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)frame_times.size(), ImPlotCond_Always);
+            ImPlot::PlotLines("gpu time", frame_times.data(), (int)frame_times.size());
+            ImPlot::EndPlot();
+          }
+
+          if (!history.empty() && ImGui::BeginTable("##gpu_zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable))
+          {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Queue");
+            ImGui::TableSetupColumn("Start (ms)");
+            ImGui::TableSetupColumn("Duration (ms)", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+            ImGui::TableHeadersRow();
+
+            std::vector<hydra::gpu_profiler::zone_stats_t> zones = history.back().zones;
+            if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs(); specs != nullptr && specs->SpecsCount > 0)
+            {
+              const ImGuiTableColumnSortSpecs& spec = specs->Specs[0];
+              const bool ascending = spec.SortDirection == ImGuiSortDirection_Ascending;
+              std::stable_sort(zones.begin(), zones.end(), [&spec, ascending](const auto& x, const auto& y)
+              {
+                const auto& a = ascending ? x : y;
+                const auto& b = ascending ? y : x;
+                switch (spec.ColumnIndex)
+                {
+                  case 0: return a.name < b.name;
+                  case 1: return a.queue_name < b.queue_name;
+                  case 2: return a.begin_ms < b.begin_ms;
+                  default: return a.duration_ms < b.duration_ms;
+                }
+              });
+            }
+
+            for (const auto& it : zones)
+            {
+              ImGui::TableNextRow();
+              ImGui::TableNextColumn();
+              ImGui::TextUnformatted(it.name.data(), it.name.data() + it.name.size());
+              ImGui::TableNextColumn();
+              ImGui::TextUnformatted(it.queue_name.data(), it.queue_name.data() + it.queue_name.size());
+              ImGui::TableNextColumn();
+              ImGui::Text("%.3f", it.begin_ms);
+              ImGui::TableNextColumn();
+              ImGui::Text("%.3f", it.duration_ms);
+            }
+            ImGui::EndTable();
+          }
+        }
+        ImGui::End();
+      }
+
+    private:
+      hydra::gpu_profiler& profiler;
+      std::vector<float> frame_times;
+  };
+}
+
@@ -27,6 +27,9 @@
 #include "gpu_task_producer.hpp"
 #include "gpu_tasks_order.hpp"
 
+#include <algorithm>
+#include <optional>
+
 namespace neam::hydra::renderer::concepts
 {
   void gpu_task_producer::concept_logic::export_resource(id_t id, exported_image image, export_mode mode)
@@ -59,6 +62,19 @@ namespace neam::hydra::renderer::concepts
     return get_concept().import_buffer(id, version);
   }
 
+  rg_resource gpu_task_producer::concept_logic::import_image(render_graph& rg, id_t id, uint32_t version) const
+  {
+    const exported_resource_data& erd = get_concept().import_resource(id, version);
+    const exported_image* cptr = std::get_if<exported_image>(&erd.resource);
+    check::debug::n_assert(cptr != nullptr, "gpu_task_producer::import_image({}): entry does not hold an image", id);
+    return rg.import_image(fmt::format("{}", id), *const_cast<exported_image*>(cptr), hctx.gqueue);
+  }
+
+  rg_resource gpu_task_producer::concept_logic::import_buffer(render_graph& rg, id_t id, uint32_t version) const
+  {
+    return rg.import_buffer(fmt::format("{}", id), get_concept().import_buffer(id, version), hctx.gqueue);
+  }
+
   bool gpu_task_producer::concept_logic::has_viewport_context() const
   {
     return get_concept().has_viewport_context();
@@ -79,7 +95,7 @@ namespace neam::hydra::renderer::concepts
     begin_rendering(cbr, std::vector{img}, load_op, store_op);
   }
 
-  void gpu_task_producer::concept_logic::begin_rendering(vk::command_buffer_recorder& cbr, const std::vector<exported_image>& imgs, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op)
+  static vk::rendering_info make_rendering_info(const viewport_context& vpc, const std::vector<exported_image>& imgs, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op, VkRenderingFlags flags)
   {
     std::vector<vk::rendering_attachment_info> rai;
     rai.reserve(imgs.size());
@@ -91,10 +107,78 @@ namespace neam::hydra::renderer::concepts
           load_op, store_op
       });
     }
-    cbr.begin_rendering
-    ({
-      get_viewport_context().viewport_rect, rai,
-    });
+    return { flags, vpc.viewport_rect, std::move(rai) };
+  }
+
+  void gpu_task_producer::concept_logic::begin_rendering(vk::command_buffer_recorder& cbr, const std::vector<exported_image>& imgs, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op)
+  {
+    cbr.begin_rendering(make_rendering_info(get_viewport_context(), imgs, load_op, store_op, 0));
+  }
+
+  void gpu_task_producer::concept_logic::parallel_rendering(vk::command_buffer_recorder& cbr, const std::vector<exported_image>& imgs, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op,
+                                                            uint32_t item_count, uint32_t items_per_batch,
+                                                            cr::function<void(vk::command_buffer_recorder& cbr, uint32_t begin, uint32_t end)>&& record)
+  {
+    TRACY_SCOPED_ZONE;
+    // more batches than that only adds overhead (both cpu-side and in the secondary command buffer execution)
+    constexpr uint32_t k_max_batch_count = 16;
+
+    const vk::rendering_info info = make_rendering_info(get_viewport_context(), imgs, load_op, store_op, VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+
+    items_per_batch = std::max(1u, items_per_batch);
+    const uint32_t batch_count = std::clamp((item_count + items_per_batch - 1) / items_per_batch, 1u, k_max_batch_count);
+    const uint32_t batch_size = (item_count + batch_count - 1) / batch_count;
+
+    // secondary command buffers are indexed by batch, so the execution order does not depend on the task scheduling
+    std::vector<std::optional<vk::command_buffer>> secondaries(batch_count);
+    const auto record_batch = [&, this](uint32_t batch)
+    {
+      TRACY_SCOPED_ZONE;
+      // get_pool() returns the pool of the current thread, so no synchronization is needed
+      vk::command_buffer& cb = secondaries[batch].emplace(hctx.gcpm.get_pool().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+      cb._set_debug_name(fmt::format("{}: batch {}", get_debug_name(), batch));
+      {
+        vk::command_buffer_recorder secondary_cbr = cb.begin_recording(info);
+        record(secondary_cbr, std::min(item_count, batch * batch_size), std::min(item_count, (batch + 1) * batch_size));
+      }
+      cb.end_recording();
+    };
+
+    // we need to be called from a task to dispatch helpers (we dispatch in the current group)
+    const threading::group_t group = hctx.tm.get_current_group();
+    const bool can_dispatch = group != threading::k_invalid_task_group;
+    std::vector<threading::task_wrapper> tasks;
+    for (uint32_t i = 1; can_dispatch && i < batch_count; ++i)
+    {
+      tasks.push_back(hctx.tm.get_task(group, [&record_batch, i]
+      {
+        record_batch(i);
+      }));
+    }
+
+    record_batch(0);
+    for (uint32_t i = 1; !can_dispatch && i < batch_count; ++i)
+      record_batch(i);
+
+    for (auto& it : tasks)
+      hctx.tm.actively_wait_for(std::move(it), threading::task_selection_mode::only_current_task_group);
+
+    std::vector<vk::command_buffer> command_buffers;
+    std::vector<const vk::command_buffer*> command_buffer_ptrs;
+    command_buffers.reserve(batch_count);
+    command_buffer_ptrs.reserve(batch_count);
+    for (auto& it : secondaries)
+    {
+      command_buffers.emplace_back(std::move(*it));
+      command_buffer_ptrs.push_back(&command_buffers.back());
+    }
+
+    cbr.begin_rendering(info);
+    cbr.execute_commands(command_buffer_ptrs);
+    cbr.end_rendering();
+
+    // the secondary command buffers must outlive the primary one
+    hctx.dfe.defer_destruction(hctx.dfe.queue_mask(hctx.gqueue), std::move(command_buffers));
   }
 
   void gpu_task_producer::concept_logic::pipeline_barrier(vk::command_buffer_recorder& cbr, exported_image& img, VkImageLayout new_layout, VkAccessFlags dst_access, VkPipelineStageFlags dst_stage)
@@ -360,17 +444,18 @@ namespace neam::hydra::renderer::concepts
 
     // prepare our place in the final submission array
     async::chain<std::vector<vk::submit_info>>::state si_state;
-    task_order->push_pass_data(si_state.create_chain());
+    task_order->push_pass_data(get_hierarchy().get_update_index(), si_state.create_chain());
 
     {
-      // FIXME: Do we need a scoped hierarchy instead?
-      allocator::scope gpu_alloc_scope = hctx.allocator.push_scope();
+      // the hierarchical update is tasked: we might be on any thread, and other producers might be prepared concurrently.
+      // each prepare gets its own root scope (root scopes do not alias), and a child scope for the allocations.
+      allocator::scope task_alloc_scope = hctx.allocator.push_root_scope();
+      allocator::scope gpu_alloc_scope = task_alloc_scope.push_scope();
       prepare(gtc);
     }
 
-    // the hierarchical update use the single threaded version
-    // (we could probably do with the multi-threaded version but that would complexify a bit the things)
-    // so to avoid taking too much time on a single thread, we dispatch a task (that will then dispatch more tasks)
+    // the recording of the passes can take a while, so we dispatch a task (that will then dispatch more tasks)
+    // so as to not hold the hierarchical update
     hctx.tm.get_task([this, si_state = std::move(si_state)] mutable
     {
       TRACY_SCOPED_ZONE;
@@ -383,15 +468,18 @@ namespace neam::hydra::renderer::concepts
         vsi.emplace_back(hctx);
         vk::submit_info& si = vsi.back();
 
-        gtc.transfers.build(si);
-        sorted_for_each_entries([this, &si](concept_logic& it)
         {
-          if (!it.is_concept_provider_enabled())
-            return;
+          gpu_profiler::submission_scope _ps { hctx.gpu_prof, gtc.transfers.debug_context };
+          gtc.transfers.build(si);
+          sorted_for_each_entries([this, &si](concept_logic& it)
+          {
+            if (!it.is_concept_provider_enabled())
+              return;
 
-          TRACY_SCOPED_ZONE;
-          it.do_submit(gtc, si);
-        });
+            TRACY_SCOPED_ZONE;
+            it.do_submit(gtc, si);
+          });
+        }
 
         si_state.complete(std::move(vsi));
 
@@ -409,7 +497,10 @@ namespace neam::hydra::renderer::concepts
         {
           TRACY_SCOPED_ZONE;
           vk::submit_info si(hctx);
-          gtc.transfers.build(si);
+          {
+            gpu_profiler::submission_scope _ps { hctx.gpu_prof, fmt::format("{}: transfers", gtc.transfers.debug_context) };
+            gtc.transfers.build(si);
+          }
           tx_si_state.complete(std::move(si));
         });
 
@@ -423,7 +514,10 @@ namespace neam::hydra::renderer::concepts
           {
             TRACY_SCOPED_ZONE;
             vk::submit_info si(hctx);
-            it.do_submit(gtc, si);
+            {
+              gpu_profiler::submission_scope _ps { hctx.gpu_prof, it.get_debug_name() };
+              it.do_submit(gtc, si);
+            }
             state.complete(std::move(si));
           });
         });
@@ -29,6 +29,7 @@
 #include "ecs.hpp"
 #include "../../ecs/hierarchy.hpp"
 #include "../../engine/hydra_context.hpp"
+#include "../render_graph.hpp"
 
 #include <ntools/ref.hpp>
 #include <ntools/function.hpp>
@@ -135,6 +136,14 @@ namespace neam::hydra::renderer::concepts
           /// \brief returns the buffer at specified id and version (optional)
           [[nodiscard]] vk::buffer& import_buffer(id_t id, uint32_t version = ~0u) const;
 
+          /// \brief imports the image at specified id and version (optional) in a render-graph
+          /// \note the exported entry is updated with the final state of the image when the graph is compiled,
+          ///       so the graph must be compiled before any following producer imports the image
+          [[nodiscard]] rg_resource import_image(render_graph& rg, id_t id, uint32_t version = ~0u) const;
+
+          /// \brief imports the buffer at specified id and version (optional) in a render-graph
+          [[nodiscard]] rg_resource import_buffer(render_graph& rg, id_t id, uint32_t version = ~0u) const;
+
         protected: // here be the viewport-related API
           /// \brief Return whether a viewport context has been set
           [[nodiscard]] bool has_viewport_context() const;
@@ -154,6 +163,15 @@ namespace neam::hydra::renderer::concepts
           /// \brief Helper for a generic begin rendering
           void begin_rendering(vk::command_buffer_recorder& cbr, const std::vector<exported_image>& imgs, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op);
 
+          /// \brief Record the content of a dynamic-rendering scope in parallel, using secondary command buffers
+          /// \p record(cbr, begin, end) is called for every batch of [0, item_count[, on task-manager workers (the calling thread records the first batch).
+          /// Each batch is recorded in its own secondary command buffer, allocated from the command pool of the worker thread,
+          /// and the secondary command buffers are then executed in batch order inside a single rendering scope.
+          /// \note \p record is called concurrently. Dynamic state (viewport, scissor, ...) is not inherited and must be set in every batch.
+          void parallel_rendering(vk::command_buffer_recorder& cbr, const std::vector<exported_image>& imgs, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op,
+                                  uint32_t item_count, uint32_t items_per_batch,
+                                  cr::function<void(vk::command_buffer_recorder& cbr, uint32_t begin, uint32_t end)>&& record);
+
           void pipeline_barrier(vk::command_buffer_recorder& cbr, exported_image& img,
                           VkImageLayout new_layout,
                           VkAccessFlags dst_access,
@@ -192,6 +210,8 @@ namespace neam::hydra::renderer::concepts
 
         protected: // a more internal part of the API:
           virtual order_mode get_order_mode() const = 0;
+          /// \brief Name used by the gpu profiler / debug tools
+          virtual std::string_view get_debug_name() const = 0;
 
         protected:
           hydra_context& hctx;
@@ -448,6 +468,11 @@ namespace neam::hydra::renderer::concepts
             return ConceptProvider::order;
           }
 
+          std::string_view get_debug_name() const final
+          {
+            return ct::type_name<ConceptProvider>.view();
+          }
+
         private:
           cr::raw_ptr<void*> setup_state_ptr;
           cr::raw_ptr<void*> prepare_state_ptr;
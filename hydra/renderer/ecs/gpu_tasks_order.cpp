@@ -24,6 +24,8 @@
 // SOFTWARE.
 //
 
+#include <algorithm>
+
 #include "gpu_tasks_order.hpp"
 #include "../../vulkan/submit_info.hpp"
 #include "../../ecs/hierarchy.hpp"
@@ -46,8 +48,14 @@ namespace neam::hydra::renderer::internals
         // push allocation scope (the root scope, most likely)
         allocator::scope gpu_alloc_scope = hctx.allocator.push_scope();
 
-        // perform single-threaded hierarchical update
-        hc->get_universe()->hierarchical_update_single_thread();
+        // perform the hierarchical update (the gpu task producers are prepared on the task manager threads)
+        hc->get_universe()->hierarchical_update_tasked(hctx, hctx.get_thread_count());
+      }
+      {
+        // upload the world transforms that changed during the update (before anything using them is submit)
+        vk::submit_info si { hctx };
+        hctx.transforms.upload_changes(si);
+        si.deferred_submit();
       }
       // once the update is done, wait for all launched task to be completed and submit the data to the gpu
       prepare_submissions(hctx);
@@ -61,6 +69,9 @@ namespace neam::hydra::renderer::internals
 
     vvsi.resize(pass_data.size());
 
+    // restore the order of the hierarchy (producers might have been updated in any order)
+    std::stable_sort(pass_data.begin(), pass_data.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
 #if N_ENABLE_MT_CHECK
     // force a non-scoped write section on both pass_data and vvsi.
     // we assume that no-one will write or destruct this component, so we enforce that assumption here
@@ -112,7 +123,7 @@ namespace neam::hydra::renderer::internals
     // call on_completion on the chain completion
     for (uint32_t i = 0; i < pass_data.size(); ++i)
     {
-      pass_data[i].then([this, i, on_completion](std::vector<vk::submit_info>&& vsi) { on_completion(i, std::move(vsi)); });
+      pass_data[i].second.then([this, i, on_completion](std::vector<vk::submit_info>&& vsi) { on_completion(i, std::move(vsi)); });
     }
   }
 }
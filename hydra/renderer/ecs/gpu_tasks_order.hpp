@@ -27,6 +27,7 @@
 #pragma once
 
 #include <ntools/async/chain.hpp>
+#include <ntools/spinlock.hpp>
 #include "../../vulkan/submit_info.hpp"
 #include "ecs.hpp"
 
@@ -52,9 +53,13 @@ namespace neam::hydra::renderer::internals
       void prepare_and_dispatch_gpu_tasks(hydra_context& hctx);
 
     private:
-      void push_pass_data(async::chain<std::vector<vk::submit_info>>&& chain)
+      /// \brief Add the submissions of a gpu task producer
+      /// \param order_key the position of the producer in the hierarchy update (the submission order is the order of the keys)
+      /// \note Thread-safe, as producers are updated by the tasked hierarchical update
+      void push_pass_data(uint32_t order_key, async::chain<std::vector<vk::submit_info>>&& chain)
       {
-        pass_data.emplace_back(std::move(chain));
+        std::lock_guard _lg(pass_data_lock);
+        pass_data.emplace_back(order_key, std::move(chain));
       }
 
       /// \brief prepare the submission process so that once all the render tasks are complete,
@@ -64,7 +69,8 @@ namespace neam::hydra::renderer::internals
       void prepare_submissions(hydra_context& hctx);
 
     private:
-      std::mtc_deque<async::chain<std::vector<vk::submit_info>>> pass_data;
+      spinlock pass_data_lock;
+      std::mtc_deque<std::pair<uint32_t, async::chain<std::vector<vk::submit_info>>>> pass_data;
       std::mtc_vector<std::vector<vk::submit_info>> vvsi;
 
       std::atomic<uint32_t> remaining_tasks;
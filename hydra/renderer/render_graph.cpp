@@ -0,0 +1,513 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "render_graph.hpp"
+#include "ecs/gpu_task_producer.hpp"
+
+#include <algorithm>
+
+namespace neam::hydra::renderer
+{
+  static constexpr VkAccessFlags2 k_write_access_mask = render_graph_compiler::k_write_access_mask;
+
+  static VkImageAspectFlags get_aspect_mask(VkFormat format)
+  {
+    switch (format)
+    {
+      case VK_FORMAT_D16_UNORM:
+      case VK_FORMAT_X8_D24_UNORM_PACK32:
+      case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+      case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+      case VK_FORMAT_D16_UNORM_S8_UINT:
+      case VK_FORMAT_D24_UNORM_S8_UINT:
+      case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+      default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+  }
+
+  /// \brief exported_image still uses the synchronization1 flags. (the lower 32 bits are shared between both versions)
+  static VkPipelineStageFlags to_sync1_stage(VkPipelineStageFlags2 stage)
+  {
+    constexpr VkPipelineStageFlags2 k_transfer_stages = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT
+                                                      | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    constexpr VkPipelineStageFlags2 k_vertex_input_stages = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+    constexpr VkPipelineStageFlags2 k_sync1_stages = 0xFFFFFFFFull;
+
+    VkPipelineStageFlags ret = (VkPipelineStageFlags)(stage & k_sync1_stages);
+    if ((stage & k_transfer_stages) != 0)
+      ret |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if ((stage & k_vertex_input_stages) != 0)
+      ret |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    if ((stage & ~(k_sync1_stages | k_transfer_stages | k_vertex_input_stages)) != 0)
+      ret |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    return ret == 0 ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : ret;
+  }
+
+  static VkAccessFlags to_sync1_access(VkAccessFlags2 access)
+  {
+    constexpr VkAccessFlags2 k_shader_read = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+    constexpr VkAccessFlags2 k_shader_write = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    constexpr VkAccessFlags2 k_sync1_access = 0xFFFFFFFFull;
+
+    VkAccessFlags ret = (VkAccessFlags)(access & k_sync1_access);
+    if ((access & k_shader_read) != 0)
+      ret |= VK_ACCESS_SHADER_READ_BIT;
+    if ((access & k_shader_write) != 0)
+      ret |= VK_ACCESS_SHADER_WRITE_BIT;
+    if ((access & ~(k_sync1_access | k_shader_read | k_shader_write)) != 0)
+      ret |= ((access & k_write_access_mask) != 0 ? VK_ACCESS_MEMORY_WRITE_BIT : VK_ACCESS_MEMORY_READ_BIT);
+    return ret;
+  }
+
+  // pass builder //
+
+  rg_pass_builder& rg_pass_builder::read(rg_resource res, VkPipelineStageFlags2 stage, VkAccessFlags2 access, VkImageLayout layout)
+  {
+    rg.compiler.add_access(pass, res, { stage, access, layout }, false);
+    return *this;
+  }
+
+  rg_pass_builder& rg_pass_builder::write(rg_resource res, VkPipelineStageFlags2 stage, VkAccessFlags2 access, VkImageLayout layout)
+  {
+    rg.compiler.add_access(pass, res, { stage, access, layout }, true);
+    return *this;
+  }
+
+  rg_pass_builder& rg_pass_builder::has_side_effects()
+  {
+    rg.compiler.set_has_side_effects(pass);
+    return *this;
+  }
+
+  // render graph //
+
+  render_graph::~render_graph()
+  {
+    // the gpu might still be using the transient resources
+    std::vector<vk::image_view> views;
+    std::vector<vk::image> images;
+    std::vector<vk::buffer> buffers;
+    for (auto& it : resources)
+    {
+      if (it.view) views.emplace_back(std::move(*it.view));
+      if (it.image) images.emplace_back(std::move(*it.image));
+      if (it.buffer) buffers.emplace_back(std::move(*it.buffer));
+    }
+    if (!views.empty())
+      hctx.dfe.defer_destruction(std::move(views));
+    if (!images.empty() || !buffers.empty())
+      hctx.dfe.defer_destruction(std::move(images), std::move(buffers), std::move(image_memory), std::move(buffer_memory), std::move(fallback_allocations));
+  }
+
+  uint32_t render_graph::get_queue_index(vk::queue& queue)
+  {
+    for (uint32_t i = 0; i < queues.size(); ++i)
+    {
+      if (queues[i] == &queue)
+        return i;
+    }
+    queues.push_back(&queue);
+    return compiler.add_queue(queue.get_queue_familly_index());
+  }
+
+  rg_resource render_graph::import_image(std::string name, exported_image& image, vk::queue& owner)
+  {
+    check::debug::n_assert(!is_compiled, "render_graph::import_image({}): cannot add resources to a compiled graph", name);
+    const vk::image& img = image.image;
+
+    const rg_resource res = compiler.add_imported_resource(std::move(name), true, img.get_sharing_mode() == VK_SHARING_MODE_EXCLUSIVE,
+                                                           get_queue_index(owner), { image.stage, image.access, image.layout });
+    resources.push_back({ .imported_image = &image });
+    return res;
+  }
+
+  rg_resource render_graph::import_buffer(std::string name, vk::buffer& buffer, vk::queue& owner)
+  {
+    check::debug::n_assert(!is_compiled, "render_graph::import_buffer({}): cannot add resources to a compiled graph", name);
+
+    // exported buffers do not carry any synchronization information, so assume the worst
+    const rg_resource res = compiler.add_imported_resource(std::move(name), false, buffer.get_sharing_mode() == VK_SHARING_MODE_EXCLUSIVE,
+                                                           get_queue_index(owner), { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT });
+    resources.push_back({ .imported_buffer = &buffer });
+    return res;
+  }
+
+  rg_resource render_graph::create_transient_image(std::string name, const transient_image_desc& desc)
+  {
+    check::debug::n_assert(!is_compiled, "render_graph::create_transient_image({}): cannot add resources to a compiled graph", name);
+    const rg_resource res = compiler.add_transient_resource(std::move(name), true);
+    resources.push_back({ .image_desc = desc });
+    return res;
+  }
+
+  rg_resource render_graph::create_transient_buffer(std::string name, const transient_buffer_desc& desc)
+  {
+    check::debug::n_assert(!is_compiled, "render_graph::create_transient_buffer({}): cannot add resources to a compiled graph", name);
+    const rg_resource res = compiler.add_transient_resource(std::move(name), false);
+    resources.push_back({ .buffer_desc = desc });
+    return res;
+  }
+
+  void render_graph::mark_output(rg_resource res)
+  {
+    compiler.mark_output(res);
+  }
+
+  rg_pass_builder render_graph::add_pass(std::string name, vk::queue& queue, execute_function_t&& execute)
+  {
+    check::debug::n_assert(!is_compiled, "render_graph::add_pass({}): cannot add passes to a compiled graph", name);
+    const uint32_t pass = compiler.add_pass(std::move(name), get_queue_index(queue));
+    pass_functions.push_back(std::move(execute));
+    return { *this, pass };
+  }
+
+  void render_graph::compile()
+  {
+    TRACY_SCOPED_ZONE;
+    check::debug::n_assert(!is_compiled, "render_graph::compile: graph {} is already compiled", debug_name);
+    is_compiled = true;
+
+    compiler.cull_passes();
+    allocate_transients();
+    compiler.generate_barriers();
+    compiler.return_imported_resources();
+    write_back_imported_resources();
+  }
+
+  void render_graph::allocate_transients()
+  {
+    std::vector<rg_resource> images;
+    std::vector<rg_resource> buffers;
+    for (uint32_t i = 0; i < resources.size(); ++i)
+    {
+      const render_graph_compiler::resource_t& cres = compiler.get_resource(i);
+      if (!cres.is_transient || !cres.is_used())
+        continue; // imported or unused
+
+      resource_t& res = resources[i];
+      if (cres.is_image)
+      {
+        res.image.emplace(vk::image::create_image_arg
+        (
+          hctx.device,
+          vk::image_2d
+          (
+            res.image_desc.size, res.image_desc.format, VK_IMAGE_TILING_OPTIMAL,
+            res.image_desc.usage, 1, VK_IMAGE_LAYOUT_UNDEFINED
+          )
+        ));
+        res.image->_set_debug_name(fmt::format("{}: {}", debug_name, cres.name));
+        compiler.set_memory_requirements(i, res.image->get_memory_requirements());
+        images.push_back(i);
+      }
+      else
+      {
+        res.buffer.emplace(hctx.device, res.buffer_desc.size, res.buffer_desc.usage);
+        res.buffer->_set_debug_name(fmt::format("{}: {}", debug_name, cres.name));
+        compiler.set_memory_requirements(i, res.buffer->get_memory_requirements());
+        buffers.push_back(i);
+      }
+    }
+
+    place_transients(images, allocation_type::short_lived_optimal_image, image_memory);
+    place_transients(buffers, allocation_type::short_lived, buffer_memory);
+
+    // views can only be created once the memory is bound
+    for (rg_resource i : images)
+    {
+      resource_t& res = resources[i];
+      res.view.emplace(hctx.device, *res.image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_MAX_ENUM, vk::rgba_swizzle(),
+                       vk::image_subresource_range(get_aspect_mask(res.image_desc.format)));
+      res.view->_set_debug_name(fmt::format("{}: {}", debug_name, compiler.get_resource(i).name));
+    }
+  }
+
+  void render_graph::place_transients(const std::vector<rg_resource>& list, allocation_type at, std::optional<memory_allocation>& memory)
+  {
+    const render_graph_compiler::transient_heap_t heap = compiler.place_transients(list);
+
+    const auto bind_memory = [this](rg_resource i, const vk::device_memory& mem, size_t offset)
+    {
+      resource_t& res = resources[i];
+      if (res.image) res.image->bind_memory(mem, offset);
+      else res.buffer->bind_memory(mem, offset);
+    };
+
+    for (rg_resource i : heap.dedicated_resources)
+    {
+      memory_allocation& alloc = fallback_allocations.emplace_back(hctx.allocator.allocate_memory(compiler.get_resource(i).requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, at));
+      bind_memory(i, *alloc.mem(), alloc.offset());
+    }
+
+    if (heap.resources.empty())
+      return;
+
+    const uint32_t mti = vk::device_memory::get_memory_type_index(hctx.device, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, heap.memory_type_bits);
+    check::on_vulkan_error::n_assert(mti != ~0u, "render_graph::compile: could not find a suitable memory type for the transient resources of {}", debug_name);
+    memory.emplace(hctx.allocator.allocate_memory(heap.size, (uint32_t)heap.alignment, mti, at));
+
+    for (rg_resource i : heap.resources)
+      bind_memory(i, *memory->mem(), memory->offset() + compiler.get_resource(i).memory_offset);
+  }
+
+  void render_graph::write_back_imported_resources()
+  {
+    // write back the state for the following users of the exported image
+    for (uint32_t i = 0; i < resources.size(); ++i)
+    {
+      exported_image* image = resources[i].imported_image;
+      if (image == nullptr)
+        continue;
+      const render_graph_compiler::resource_t& res = compiler.get_resource(i);
+      image->layout = res.layout;
+      image->stage = to_sync1_stage(res.last_write.stage | res.read_stages);
+      image->access = to_sync1_access(res.last_write.access & k_write_access_mask);
+    }
+  }
+
+  void render_graph::record_barriers(vk::command_buffer_recorder& cbr, const render_graph_compiler::barrier_list_t& list) const
+  {
+    if (list.empty())
+      return;
+
+    std::vector<VkImageMemoryBarrier2> image_barriers;
+    image_barriers.reserve(list.images.size());
+    for (const render_graph_compiler::barrier_t& it : list.images)
+    {
+      const resource_t& res = resources[it.res];
+      const vk::image& img = res.image ? *res.image : (const vk::image&)res.imported_image->image;
+      image_barriers.push_back(VkImageMemoryBarrier2
+      {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = it.src.stage,
+        .srcAccessMask = it.src.access,
+        .dstStageMask = it.dst.stage,
+        .dstAccessMask = it.dst.access,
+        .oldLayout = it.old_layout,
+        .newLayout = it.new_layout,
+        .srcQueueFamilyIndex = it.src_family,
+        .dstQueueFamilyIndex = it.dst_family,
+        .image = img.get_vk_image(),
+        .subresourceRange = { get_aspect_mask(img.get_image_format()), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS },
+      });
+    }
+
+    std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+    buffer_barriers.reserve(list.buffers.size());
+    for (const render_graph_compiler::barrier_t& it : list.buffers)
+    {
+      const resource_t& res = resources[it.res];
+      const vk::buffer& buf = res.buffer ? *res.buffer : *res.imported_buffer;
+      buffer_barriers.push_back(VkBufferMemoryBarrier2
+      {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = it.src.stage,
+        .srcAccessMask = it.src.access,
+        .dstStageMask = it.dst.stage,
+        .dstAccessMask = it.dst.access,
+        .srcQueueFamilyIndex = it.src_family,
+        .dstQueueFamilyIndex = it.dst_family,
+        .buffer = buf._get_vk_buffer(),
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+      });
+    }
+
+    const VkDependencyInfo dependency_info
+    {
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .pNext = nullptr,
+      .dependencyFlags = 0,
+      .memoryBarrierCount = 0,
+      .pMemoryBarriers = nullptr,
+      .bufferMemoryBarrierCount = (uint32_t)buffer_barriers.size(),
+      .pBufferMemoryBarriers = buffer_barriers.data(),
+      .imageMemoryBarrierCount = (uint32_t)image_barriers.size(),
+      .pImageMemoryBarriers = image_barriers.data(),
+    };
+    cbr.pipeline_barrier(dependency_info);
+  }
+
+  void render_graph::submit(vk::submit_info& si)
+  {
+    TRACY_SCOPED_ZONE;
+    check::debug::n_assert(is_compiled, "render_graph::submit: graph {} must be compiled first", debug_name);
+    check::debug::n_assert(!is_submitted, "render_graph::submit: graph {} is already submitted", debug_name);
+    is_submitted = true;
+
+    // split the graph in segments of consecutive passes on the same queue
+    struct segment_t
+    {
+      uint32_t queue;
+      const render_graph_compiler::barrier_list_t* barriers = nullptr; // prologues / epilogues
+      std::vector<uint32_t> passes = {};
+      std::vector<uint32_t> waits = {};
+    };
+    std::vector<segment_t> segments;
+    std::map<uint32_t, uint32_t> prologue_segments;
+    std::vector<uint32_t> pass_segments(compiler.get_pass_count(), ~0u);
+
+    const auto add_wait = [&segments](uint32_t segment, uint32_t wait_segment)
+    {
+      std::vector<uint32_t>& waits = segments[segment].waits;
+      if (segments[segment].queue != segments[wait_segment].queue && std::find(waits.begin(), waits.end(), wait_segment) == waits.end())
+        waits.push_back(wait_segment);
+    };
+
+    for (const auto& it : compiler.get_prologues())
+    {
+      prologue_segments.emplace(it.first, (uint32_t)segments.size());
+      segments.push_back({ it.first, &it.second });
+    }
+    for (uint32_t i = 0; i < compiler.get_pass_count(); ++i)
+    {
+      const render_graph_compiler::pass_t& pass = compiler.get_pass(i);
+      if (pass.culled)
+        continue;
+      if (segments.empty() || segments.back().barriers != nullptr || segments.back().queue != pass.queue)
+        segments.push_back({ pass.queue });
+      const uint32_t segment = (uint32_t)segments.size() - 1;
+      segments.back().passes.push_back(i);
+      pass_segments[i] = segment;
+
+      for (uint32_t p : pass.wait_passes)
+        add_wait(segment, pass_segments[p]);
+      for (uint32_t q : pass.wait_prologues)
+        add_wait(segment, prologue_segments.at(q));
+    }
+    for (const auto& it : compiler.get_epilogues())
+    {
+      segments.push_back({ it.first, &it.second.barriers });
+      for (uint32_t p : it.second.wait_passes)
+        add_wait((uint32_t)segments.size() - 1, pass_segments[p]);
+    }
+
+    // one semaphore per cross-queue dependency
+    std::vector<vk::semaphore> semaphores;
+    std::vector<std::vector<uint32_t>> signals(segments.size());
+    std::vector<std::vector<uint32_t>> waits(segments.size());
+    for (uint32_t i = 0; i < segments.size(); ++i)
+    {
+      for (uint32_t w : segments[i].waits)
+      {
+        semaphores.emplace_back(hctx.device, fmt::format("{}: segment {} -> segment {}", debug_name, w, i));
+        signals[w].push_back((uint32_t)semaphores.size() - 1);
+        waits[i].push_back((uint32_t)semaphores.size() - 1);
+      }
+    }
+    compiler.get_stats().semaphore_count = (uint32_t)semaphores.size();
+
+    for (uint32_t i = 0; i < segments.size(); ++i)
+    {
+      segment_t& segment = segments[i];
+      vk::queue& queue = *queues[segment.queue];
+      vk::command_buffer cb = hctx.get_cpm(queue).get_pool().create_command_buffer();
+      cb._set_debug_name(fmt::format("{}: segment {}", debug_name, i));
+      {
+        vk::command_buffer_recorder cbr = cb.begin_recording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        if (segment.barriers != nullptr)
+        {
+          vk::cbr_debug_marker _dm(cbr, fmt::format("{}: queue ownership transfers", debug_name));
+          record_barriers(cbr, *segment.barriers);
+        }
+        for (uint32_t p : segment.passes)
+        {
+          const render_graph_compiler::pass_t& pass = compiler.get_pass(p);
+          vk::cbr_debug_marker _dm(cbr, pass.name);
+          record_barriers(cbr, pass.barriers);
+          if (pass_functions[p])
+            pass_functions[p](cbr, *this);
+          record_barriers(cbr, pass.release_barriers);
+        }
+        cb.end_recording();
+      }
+
+      si.on(queue);
+      for (uint32_t s : waits[i])
+        si.wait(semaphores[s], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+      si.execute(cb);
+      for (uint32_t s : signals[i])
+        si.signal(semaphores[s]);
+      // waits on binary semaphores must be submit after their signal
+      if (!signals[i].empty())
+        si.sync();
+
+      hctx.dfe.defer_destruction(hctx.dfe.queue_mask(queue), std::move(cb));
+    }
+    if (!semaphores.empty())
+      hctx.dfe.defer_destruction(std::move(semaphores));
+  }
+
+  vk::image& render_graph::get_image(rg_resource res)
+  {
+    check::debug::n_assert(res < resources.size() && compiler.get_resource(res).is_image, "render_graph::get_image: resource is not an image");
+    check::debug::n_assert(!compiler.get_resource(res).is_transient || resources[res].image, "render_graph::get_image({}): transient resource is not allocated (not compiled or unused)", compiler.get_resource(res).name);
+    if (compiler.get_resource(res).is_transient)
+      return *resources[res].image;
+    return resources[res].imported_image->image;
+  }
+
+  vk::image_view& render_graph::get_image_view(rg_resource res)
+  {
+    check::debug::n_assert(res < resources.size() && compiler.get_resource(res).is_image, "render_graph::get_image_view: resource is not an image");
+    check::debug::n_assert(!compiler.get_resource(res).is_transient || resources[res].view, "render_graph::get_image_view({}): transient resource is not allocated (not compiled or unused)", compiler.get_resource(res).name);
+    if (compiler.get_resource(res).is_transient)
+      return *resources[res].view;
+    return resources[res].imported_image->view;
+  }
+
+  vk::buffer& render_graph::get_buffer(rg_resource res)
+  {
+    check::debug::n_assert(res < resources.size() && !compiler.get_resource(res).is_image, "render_graph::get_buffer: resource is not a buffer");
+    check::debug::n_assert(!compiler.get_resource(res).is_transient || resources[res].buffer, "render_graph::get_buffer({}): transient resource is not allocated (not compiled or unused)", compiler.get_resource(res).name);
+    if (compiler.get_resource(res).is_transient)
+      return *resources[res].buffer;
+    return *resources[res].imported_buffer;
+  }
+
+  exported_image render_graph::get_exported_image(rg_resource res)
+  {
+    check::debug::n_assert(is_compiled, "render_graph::get_exported_image: graph {} must be compiled first", debug_name);
+    if (!compiler.get_resource(res).is_transient)
+      return *resources[res].imported_image;
+
+    const render_graph_compiler::resource_t& rt = compiler.get_resource(res);
+    return exported_image
+    {
+      get_image(res), get_image_view(res),
+      rt.layout,
+      to_sync1_access(rt.last_write.access & k_write_access_mask),
+      to_sync1_stage(rt.last_write.stage | rt.read_stages),
+    };
+  }
+}
@@ -0,0 +1,195 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <map>
+#include <functional>
+
+#include "../engine/hydra_context.hpp"
+#include "render_graph_compiler.hpp"
+
+namespace neam::hydra::renderer
+{
+  class render_graph;
+  struct exported_image; // see gpu_task_producer.hpp
+
+  /// \brief Description of an image whose lifetime is handled by the render-graph
+  /// \note Transient images are only valid for the frame, and may share memory with other transient images
+  struct transient_image_desc
+  {
+    glm::uvec2 size;
+    VkFormat format;
+    VkImageUsageFlags usage;
+  };
+
+  /// \brief Description of a buffer whose lifetime is handled by the render-graph
+  struct transient_buffer_desc
+  {
+    size_t size;
+    VkBufferUsageFlags usage;
+  };
+
+  /// \brief Declare the resource usages of a render-graph pass
+  class rg_pass_builder
+  {
+    public:
+      /// \brief The pass reads the resource
+      /// \note for images, \p layout is the layout the image must be in during the pass
+      rg_pass_builder& read(rg_resource res, VkPipelineStageFlags2 stage, VkAccessFlags2 access, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+      /// \brief The pass writes to the resource
+      rg_pass_builder& write(rg_resource res, VkPipelineStageFlags2 stage, VkAccessFlags2 access, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+      /// \brief Prevent the pass from being culled, even if nothing consumes what it writes
+      rg_pass_builder& has_side_effects();
+
+    private:
+      rg_pass_builder(render_graph& _rg, uint32_t _pass) : rg(_rg), pass(_pass) {}
+
+      render_graph& rg;
+      uint32_t pass;
+
+      friend class render_graph;
+  };
+
+  /// \brief Frame-graph built on top of the export/import model of gpu_task_producer
+  ///
+  /// Passes declare how they access resources (stage, access, layout) instead of recording barriers themselves.
+  /// compile() then (see render_graph_compiler for the device-independent part):
+  ///  - culls the passes whose results are not consumed (by a kept pass, an imported resource or a marked output)
+  ///  - generates the minimal set of synchronization2 barriers (batched, one vkCmdPipelineBarrier2 per pass at most)
+  ///  - generates queue family ownership transfers and semaphores when consecutive accesses are on different queues
+  ///  - places the transient resources with disjoint lifetimes at the same place in a single memory allocation
+  ///
+  /// \note A render graph is meant to be built, compiled and submitted once (typically inside a gpu_task_producer prepare/submit)
+  /// \note Imported resources are expected to stay alive until the work is completed on the gpu,
+  ///       and the work that produced them to be already synchronized with the queues used by the graph.
+  class render_graph
+  {
+    public:
+      using execute_function_t = std::function<void(vk::command_buffer_recorder& cbr, render_graph& rg)>;
+
+      explicit render_graph(hydra_context& _hctx, std::string _debug_name = "render-graph") : hctx(_hctx), debug_name(std::move(_debug_name)) {}
+      ~render_graph();
+
+      render_graph(const render_graph&) = delete;
+      render_graph& operator = (const render_graph&) = delete;
+
+    public: // resources
+      /// \brief Import an image in the graph.
+      /// \note Once the graph is compiled, layout/access/stage of \p image are updated to the state the graph leaves the image in
+      /// \param owner The queue that currently owns the image (only used for exclusive images)
+      rg_resource import_image(std::string name, exported_image& image, vk::queue& owner);
+      /// \brief Import a buffer in the graph.
+      /// \param owner The queue that currently owns the buffer (only used for exclusive buffers)
+      rg_resource import_buffer(std::string name, vk::buffer& buffer, vk::queue& owner);
+
+      /// \brief Create an image that only lives for the duration of the graph
+      rg_resource create_transient_image(std::string name, const transient_image_desc& desc);
+      /// \brief Create a buffer that only lives for the duration of the graph
+      rg_resource create_transient_buffer(std::string name, const transient_buffer_desc& desc);
+
+      /// \brief Mark a resource as being consumed outside of the graph (prevent the passes writing to it from being culled)
+      /// \note imported resources are always considered as outputs
+      void mark_output(rg_resource res);
+
+    public: // passes
+      /// \brief Add a pass to the graph. Passes are executed in the order they are added.
+      /// \note \p execute is called during submit(), the image/buffer getters are valid there.
+      rg_pass_builder add_pass(std::string name, vk::queue& queue, execute_function_t&& execute);
+
+    public:
+      /// \brief Cull the passes, generate the barriers and allocate the transient resources
+      /// \note No resource or pass can be added after this call
+      void compile();
+
+      /// \brief Record the command buffers and add them to the submit info
+      /// \note must be called after compile(). Transient resources are freed once the gpu is done with them.
+      void submit(vk::submit_info& si);
+
+    public: // getters (valid after compile)
+      [[nodiscard]] vk::image& get_image(rg_resource res);
+      [[nodiscard]] vk::image_view& get_image_view(rg_resource res);
+      [[nodiscard]] vk::buffer& get_buffer(rg_resource res);
+
+      /// \brief Return the image with the state the graph will leave it in (can be passed to export_resource)
+      [[nodiscard]] exported_image get_exported_image(rg_resource res);
+
+      /// \brief Return whether the pass was kept by compile()
+      [[nodiscard]] bool is_pass_culled(uint32_t pass) const { return compiler.get_pass(pass).culled; }
+
+      [[nodiscard]] const render_graph_stats& get_stats() const { return compiler.get_stats(); }
+
+    private:
+      struct resource_t
+      {
+        // imported:
+        exported_image* imported_image = nullptr;
+        vk::buffer* imported_buffer = nullptr;
+
+        // transient:
+        transient_image_desc image_desc {};
+        transient_buffer_desc buffer_desc {};
+        std::optional<vk::image> image;
+        std::optional<vk::image_view> view;
+        std::optional<vk::buffer> buffer;
+      };
+
+    private:
+      uint32_t get_queue_index(vk::queue& queue);
+
+      void allocate_transients();
+      void place_transients(const std::vector<rg_resource>& list, allocation_type at, std::optional<memory_allocation>& memory);
+      void write_back_imported_resources();
+
+      void record_barriers(vk::command_buffer_recorder& cbr, const render_graph_compiler::barrier_list_t& list) const;
+
+    private:
+      hydra_context& hctx;
+      std::string debug_name;
+
+      render_graph_compiler compiler;
+
+      // indexed like the queues / resources / passes of the compiler
+      std::vector<vk::queue*> queues;
+      std::vector<resource_t> resources;
+      std::vector<execute_function_t> pass_functions;
+
+      std::optional<memory_allocation> image_memory;
+      std::optional<memory_allocation> buffer_memory;
+      std::vector<memory_allocation> fallback_allocations;
+
+      bool is_compiled = false;
+      bool is_submitted = false;
+
+      friend class rg_pass_builder;
+  };
+}
+
@@ -0,0 +1,440 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "render_graph_compiler.hpp"
+
+#include <algorithm>
+
+#include <ntools/tracy.hpp>
+
+#include "../hydra_debug.hpp"
+
+namespace neam::hydra::renderer
+{
+  static size_t align_up(size_t value, size_t alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  uint32_t render_graph_compiler::add_queue(uint32_t family_index)
+  {
+    queue_families.push_back(family_index);
+    return (uint32_t)(queue_families.size() - 1);
+  }
+
+  rg_resource render_graph_compiler::add_imported_resource(std::string name, bool is_image, bool is_exclusive, uint32_t owner, const usage_t& state)
+  {
+    check::debug::n_assert(owner < queue_families.size(), "render_graph: imported resource {}: invalid owner queue", name);
+    resource_t& res = resources.emplace_back(resource_t
+    {
+      .name = std::move(name),
+      .is_image = is_image,
+      .is_transient = false,
+      .is_output = true,
+      .is_exclusive = is_exclusive,
+      .owner = owner,
+    });
+    res.last_write = state;
+    res.layout = state.layout;
+    res.queue = owner;
+    return (rg_resource)(resources.size() - 1);
+  }
+
+  rg_resource render_graph_compiler::add_transient_resource(std::string name, bool is_image)
+  {
+    resources.emplace_back(resource_t
+    {
+      .name = std::move(name),
+      .is_image = is_image,
+      .is_transient = true,
+      .is_output = false,
+      .is_exclusive = true,
+    });
+    return (rg_resource)(resources.size() - 1);
+  }
+
+  void render_graph_compiler::mark_output(rg_resource res)
+  {
+    check::debug::n_assert(res < resources.size(), "render_graph::mark_output: invalid resource");
+    resources[res].is_output = true;
+  }
+
+  uint32_t render_graph_compiler::add_pass(std::string name, uint32_t queue)
+  {
+    check::debug::n_assert(queue < queue_families.size(), "render_graph: pass {}: invalid queue", name);
+    passes.push_back(pass_t
+    {
+      .name = std::move(name),
+      .queue = queue,
+    });
+    return (uint32_t)(passes.size() - 1);
+  }
+
+  void render_graph_compiler::set_has_side_effects(uint32_t pass)
+  {
+    passes[pass].has_side_effects = true;
+  }
+
+  void render_graph_compiler::add_access(uint32_t pass, rg_resource res, const usage_t& usage, bool write)
+  {
+    check::debug::n_assert(res < resources.size(), "render_graph: pass {}: invalid resource", passes[pass].name);
+
+    // merge multiple accesses to the same resource
+    for (access_t& it : passes[pass].accesses)
+    {
+      if (it.res != res)
+        continue;
+      check::debug::n_assert(!resources[res].is_image || usage.layout == it.usage.layout || usage.layout == VK_IMAGE_LAYOUT_UNDEFINED,
+                             "render_graph: pass {}: image {} is used with two different layouts", passes[pass].name, resources[res].name);
+      it.usage.stage |= usage.stage;
+      it.usage.access |= usage.access;
+      it.read = it.read || !write;
+      it.write = it.write || write;
+      return;
+    }
+    passes[pass].accesses.push_back({ res, usage, !write, write });
+  }
+
+  void render_graph_compiler::add_dependency(uint32_t pass, uint32_t prev_pass)
+  {
+    if (prev_pass == ~0u || passes[prev_pass].queue == passes[pass].queue)
+      return; // same-queue ordering is handled by the barriers
+    std::vector<uint32_t>& waits = passes[pass].wait_passes;
+    if (std::find(waits.begin(), waits.end(), prev_pass) == waits.end())
+      waits.push_back(prev_pass);
+  }
+
+  void render_graph_compiler::cull_passes()
+  {
+    TRACY_SCOPED_ZONE;
+    stats = {};
+    stats.pass_count = (uint32_t)passes.size();
+
+    // a pass is kept if it writes to something that is needed (read by a kept pass, or an output)
+    // walking backward, a kept pass makes what it reads needed.
+    std::vector<bool> needed(resources.size());
+    for (uint32_t i = 0; i < resources.size(); ++i)
+      needed[i] = resources[i].is_output;
+
+    for (uint32_t i = (uint32_t)passes.size(); i-- > 0;)
+    {
+      pass_t& pass = passes[i];
+      bool keep = pass.has_side_effects;
+      for (const access_t& it : pass.accesses)
+        keep = keep || (it.write && needed[it.res]);
+
+      pass.culled = !keep;
+      if (!keep)
+      {
+        ++stats.culled_pass_count;
+        continue;
+      }
+      for (const access_t& it : pass.accesses)
+      {
+        if (it.read)
+          needed[it.res] = true;
+      }
+    }
+
+    compute_lifetimes();
+  }
+
+  void render_graph_compiler::compute_lifetimes()
+  {
+    for (uint32_t i = 0; i < passes.size(); ++i)
+    {
+      if (passes[i].culled)
+        continue;
+      for (const access_t& it : passes[i].accesses)
+      {
+        resource_t& res = resources[it.res];
+        res.first_pass = std::min(res.first_pass, i);
+        res.last_pass = std::max(res.last_pass, i);
+      }
+    }
+  }
+
+  void render_graph_compiler::set_memory_requirements(rg_resource res, const VkMemoryRequirements& requirements)
+  {
+    check::debug::n_assert(resources[res].is_transient, "render_graph: {}: only transient resources have memory requirements", resources[res].name);
+    resources[res].requirements = requirements;
+  }
+
+  render_graph_compiler::transient_heap_t render_graph_compiler::place_transients(const std::vector<rg_resource>& list)
+  {
+    TRACY_SCOPED_ZONE;
+    // biggest first, place each resource at the lowest offset that does not overlap a resource with an overlapping lifetime
+    std::vector<rg_resource> sorted = list;
+    std::sort(sorted.begin(), sorted.end(), [this](rg_resource a, rg_resource b)
+    {
+      return resources[a].requirements.size > resources[b].requirements.size;
+    });
+
+    transient_heap_t heap;
+    std::vector<std::pair<size_t, size_t>> intervals;
+    for (rg_resource i : sorted)
+    {
+      resource_t& res = resources[i];
+      stats.unaliased_transient_memory_size += res.requirements.size;
+
+      if ((heap.memory_type_bits & res.requirements.memoryTypeBits) == 0)
+      {
+        // incompatible with the shared allocation, give it its own memory
+        heap.dedicated_resources.push_back(i);
+        stats.transient_memory_size += res.requirements.size;
+        continue;
+      }
+      heap.memory_type_bits &= res.requirements.memoryTypeBits;
+      heap.alignment = std::max<size_t>(heap.alignment, res.requirements.alignment);
+
+      intervals.clear();
+      for (rg_resource o : heap.resources)
+      {
+        const resource_t& other = resources[o];
+        if (other.first_pass <= res.last_pass && res.first_pass <= other.last_pass)
+          intervals.emplace_back(other.memory_offset, other.memory_offset + other.requirements.size);
+      }
+      std::sort(intervals.begin(), intervals.end());
+
+      size_t offset = 0;
+      for (const auto& it : intervals)
+      {
+        if (align_up(offset, res.requirements.alignment) + res.requirements.size <= it.first)
+          break;
+        offset = std::max(offset, it.second);
+      }
+      res.memory_offset = align_up(offset, res.requirements.alignment);
+      heap.size = std::max(heap.size, res.memory_offset + res.requirements.size);
+
+      // remember the previous occupants of the memory, as the first use of the resource has to wait for them
+      for (rg_resource o : heap.resources)
+      {
+        const resource_t& other = resources[o];
+        if (other.last_pass < res.first_pass
+            && other.memory_offset < res.memory_offset + res.requirements.size
+            && res.memory_offset < other.memory_offset + other.requirements.size)
+          res.aliased_resources.push_back(o);
+      }
+      for (rg_resource o : heap.resources)
+      {
+        resource_t& other = resources[o];
+        if (res.last_pass < other.first_pass
+            && other.memory_offset < res.memory_offset + res.requirements.size
+            && res.memory_offset < other.memory_offset + other.requirements.size)
+          other.aliased_resources.push_back(i);
+      }
+      heap.resources.push_back(i);
+    }
+
+    stats.transient_memory_size += heap.size;
+    return heap;
+  }
+
+  void render_graph_compiler::add_barrier(barrier_list_t& list, rg_resource res, const usage_t& src, const usage_t& dst,
+                                          VkImageLayout old_layout, VkImageLayout new_layout, uint32_t src_family, uint32_t dst_family)
+  {
+    const barrier_t barrier
+    {
+      .res = res,
+      .src = src,
+      .dst = dst,
+      .old_layout = old_layout,
+      .new_layout = new_layout,
+      .src_family = src_family,
+      .dst_family = dst_family,
+    };
+    if (resources[res].is_image)
+    {
+      list.images.push_back(barrier);
+      ++stats.image_barrier_count;
+    }
+    else
+    {
+      list.buffers.push_back(barrier);
+      ++stats.buffer_barrier_count;
+    }
+  }
+
+  void render_graph_compiler::generate_barriers()
+  {
+    TRACY_SCOPED_ZONE;
+    for (uint32_t i = 0; i < passes.size(); ++i)
+    {
+      pass_t& pass = passes[i];
+      if (pass.culled)
+        continue;
+
+      for (const access_t& it : pass.accesses)
+      {
+        resource_t& res = resources[it.res];
+        const VkImageLayout dst_layout = (res.is_image && it.usage.layout != VK_IMAGE_LAYOUT_UNDEFINED) ? it.usage.layout : res.layout;
+        // layout transitions and ownership transfers behave like writes
+        bool is_transition = false;
+
+        if (res.is_transient && res.first_pass == i)
+        {
+          check::debug::n_assert(!res.is_image || dst_layout != VK_IMAGE_LAYOUT_UNDEFINED, "render_graph: pass {}: first use of image {} must specify a layout", pass.name, res.name);
+          is_transition = res.is_image;
+
+          // first use: content is undefined, only wait for the previous users of the memory
+          usage_t src;
+          for (rg_resource o : res.aliased_resources)
+          {
+            const resource_t& other = resources[o];
+            src.stage |= other.last_write.stage | other.read_stages;
+            src.access |= other.last_write.access & k_write_access_mask;
+            add_dependency(i, other.last_write_pass);
+            for (uint32_t p : other.reader_passes)
+              add_dependency(i, p);
+          }
+          if (res.is_image || src.stage != VK_PIPELINE_STAGE_2_NONE)
+            add_barrier(pass.barriers, it.res, src, it.usage, VK_IMAGE_LAYOUT_UNDEFINED, dst_layout);
+        }
+        else
+        {
+          const bool has_previous_access = res.last_access_pass != ~0u;
+          const bool queue_change = res.queue != pass.queue;
+          const uint32_t src_family = queue_families[res.queue];
+          const uint32_t dst_family = queue_families[pass.queue];
+          const bool family_change = res.is_exclusive && src_family != dst_family;
+          const bool layout_change = res.is_image && dst_layout != res.layout;
+
+          // cross-queue dependencies (the semaphores also make the memory available and visible)
+          if (queue_change)
+          {
+            add_dependency(i, res.last_write_pass);
+            if (it.write || layout_change || family_change)
+            {
+              for (uint32_t p : res.reader_passes)
+                add_dependency(i, p);
+            }
+            if (family_change && !has_previous_access)
+            {
+              if (std::find(pass.wait_prologues.begin(), pass.wait_prologues.end(), res.owner) == pass.wait_prologues.end())
+                pass.wait_prologues.push_back(res.owner);
+            }
+          }
+
+          usage_t src;
+          bool need_barrier = false;
+          if (it.write || layout_change || family_change)
+          {
+            // WAW / layout transition: wait for every previous access. WAR: only needs an execution dependency
+            src.stage = res.last_write.stage | res.read_stages;
+            src.access = res.last_write.access & k_write_access_mask;
+            need_barrier = layout_change || family_change || (!queue_change && src.stage != VK_PIPELINE_STAGE_2_NONE);
+          }
+          else if (!queue_change && res.last_write.stage != VK_PIPELINE_STAGE_2_NONE)
+          {
+            // RAW: only needed if the previous barriers have not already made the write visible to this stage / access
+            const bool already_visible = (it.usage.stage & ~res.read_stages) == 0 && (it.usage.access & ~res.read_access) == 0;
+            src.stage = res.last_write.stage;
+            src.access = res.last_write.access & k_write_access_mask;
+            need_barrier = !already_visible;
+          }
+
+          if (family_change)
+          {
+            // queue family ownership transfer: release after the last access, acquire before this pass
+            barrier_list_t& release_list = has_previous_access ? passes[res.last_access_pass].release_barriers : prologues[res.owner];
+            add_barrier(release_list, it.res, src, {}, res.layout, dst_layout, src_family, dst_family);
+            add_barrier(pass.barriers, it.res, {}, it.usage, res.layout, dst_layout, src_family, dst_family);
+            ++stats.queue_ownership_transfer_count;
+          }
+          else if (need_barrier)
+          {
+            add_barrier(pass.barriers, it.res, src, it.usage, res.layout, dst_layout);
+          }
+          else
+          {
+            ++stats.elided_barrier_count;
+          }
+          is_transition = layout_change || family_change;
+        }
+
+        // update the tracked state
+        if (!it.write && is_transition)
+        {
+          // the following accesses have to wait for the transition, which already made the memory visible for this pass
+          res.last_write = { it.usage.stage, VK_ACCESS_2_NONE };
+          res.last_write_pass = i;
+          res.read_stages = it.usage.stage;
+          res.read_access = it.usage.access;
+          res.reader_passes = { i };
+        }
+        else if (it.write)
+        {
+          res.last_write = it.usage;
+          res.last_write_pass = i;
+          res.read_stages = VK_PIPELINE_STAGE_2_NONE;
+          res.read_access = VK_ACCESS_2_NONE;
+          res.reader_passes.clear();
+        }
+        else
+        {
+          res.read_stages |= it.usage.stage;
+          res.read_access |= it.usage.access;
+          if (std::find(res.reader_passes.begin(), res.reader_passes.end(), i) == res.reader_passes.end())
+            res.reader_passes.push_back(i);
+        }
+        res.layout = dst_layout;
+        res.queue = pass.queue;
+        res.last_access_pass = i;
+      }
+    }
+  }
+
+  void render_graph_compiler::return_imported_resources()
+  {
+    for (uint32_t i = 0; i < resources.size(); ++i)
+    {
+      resource_t& res = resources[i];
+      if (res.is_transient)
+        continue;
+
+      // give back exclusive resources to their owner
+      if (res.is_exclusive && res.last_access_pass != ~0u && queue_families[res.queue] != queue_families[res.owner])
+      {
+        const usage_t src = { res.last_write.stage | res.read_stages, res.last_write.access & k_write_access_mask };
+        const usage_t dst = { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT };
+        const uint32_t src_family = queue_families[res.queue];
+        const uint32_t dst_family = queue_families[res.owner];
+        epilogue_t& epilogue = epilogues[res.owner];
+
+        add_barrier(passes[res.last_access_pass].release_barriers, i, src, {}, res.layout, res.layout, src_family, dst_family);
+        add_barrier(epilogue.barriers, i, {}, dst, res.layout, res.layout, src_family, dst_family);
+        if (std::find(epilogue.wait_passes.begin(), epilogue.wait_passes.end(), res.last_access_pass) == epilogue.wait_passes.end())
+          epilogue.wait_passes.push_back(res.last_access_pass);
+        ++stats.queue_ownership_transfer_count;
+
+        res.last_write = { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT };
+        res.read_stages = VK_PIPELINE_STAGE_2_NONE;
+        res.queue = res.owner;
+      }
+    }
+  }
+}
@@ -0,0 +1,245 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace neam::hydra::renderer
+{
+  /// \brief Handle to a resource (image or buffer) of a render_graph
+  using rg_resource = uint32_t;
+  static constexpr rg_resource k_invalid_rg_resource = ~0u;
+
+  /// \brief Various counters of the last compilation (for debug / profiling)
+  struct render_graph_stats
+  {
+    uint32_t pass_count = 0;
+    uint32_t culled_pass_count = 0;
+
+    uint32_t image_barrier_count = 0;
+    uint32_t buffer_barrier_count = 0;
+    // accesses that did not require a barrier as the previous ones already made the memory visible
+    uint32_t elided_barrier_count = 0;
+    uint32_t queue_ownership_transfer_count = 0;
+    uint32_t semaphore_count = 0;
+
+    // memory needed by the transient resources with / without aliasing
+    size_t transient_memory_size = 0;
+    size_t unaliased_transient_memory_size = 0;
+  };
+
+  /// \brief Device-independent part of the render_graph: pass culling, resource lifetimes,
+  /// transient placement (aliasing) and barrier / queue-ownership-transfer synthesis.
+  ///
+  /// Queues are identified by their index in the compiler (see add_queue), barriers reference resources by their rg_resource.
+  /// render_graph creates the vulkan objects and records what the compiler outputs.
+  /// \note Does not need a vulkan device, so it can be used to validate synthetic graphs.
+  class render_graph_compiler
+  {
+    public:
+      static constexpr VkAccessFlags2 k_write_access_mask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+                                                          | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                                          | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+      struct usage_t
+      {
+        VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+      };
+
+      struct barrier_t
+      {
+        rg_resource res;
+        usage_t src;
+        usage_t dst;
+        VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t src_family = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dst_family = VK_QUEUE_FAMILY_IGNORED;
+      };
+
+      struct barrier_list_t
+      {
+        std::vector<barrier_t> images;
+        std::vector<barrier_t> buffers;
+
+        bool empty() const { return images.empty() && buffers.empty(); }
+      };
+
+      struct epilogue_t
+      {
+        barrier_list_t barriers;
+        std::vector<uint32_t> wait_passes;
+      };
+
+      struct access_t
+      {
+        rg_resource res;
+        usage_t usage;
+        bool read;
+        bool write;
+      };
+
+      struct resource_t
+      {
+        std::string name;
+        bool is_image;
+        bool is_transient;
+        bool is_output;
+        bool is_exclusive;
+
+        // queue that owns the resource (imported resources)
+        uint32_t owner = ~0u;
+
+        // transient:
+        VkMemoryRequirements requirements {};
+        size_t memory_offset = 0;
+
+        // lifetime (only accounting for the kept passes)
+        uint32_t first_pass = ~0u;
+        uint32_t last_pass = 0;
+        // transient resources that previously used the same memory
+        std::vector<rg_resource> aliased_resources;
+
+        // state tracking during compilation
+        usage_t last_write; // also used for the last layout transition
+        VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 read_access = VK_ACCESS_2_NONE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t queue = ~0u; // queue of the last access
+        uint32_t last_write_pass = ~0u;
+        uint32_t last_access_pass = ~0u;
+        std::vector<uint32_t> reader_passes; // passes that read since the last write
+
+        bool is_used() const { return first_pass != ~0u; }
+      };
+
+      struct pass_t
+      {
+        std::string name;
+        uint32_t queue;
+        std::vector<access_t> accesses;
+        bool has_side_effects = false;
+        bool culled = false;
+
+        barrier_list_t barriers;
+        // queue ownership releases, recorded after the pass
+        barrier_list_t release_barriers;
+
+        // cross-queue dependencies (passes / prologues that must be completed before this one starts)
+        std::vector<uint32_t> wait_passes;
+        std::vector<uint32_t> wait_prologues;
+      };
+
+      /// \brief Placement of a set of transient resources in a single allocation
+      struct transient_heap_t
+      {
+        size_t size = 0;
+        size_t alignment = 1;
+        uint32_t memory_type_bits = ~0u;
+
+        // resources placed in the heap (at their memory_offset)
+        std::vector<rg_resource> resources;
+        // resources whose memory types are incompatible with the heap (they need their own allocation)
+        std::vector<rg_resource> dedicated_resources;
+      };
+
+    public: // building
+      /// \brief Add a queue, return its index
+      uint32_t add_queue(uint32_t family_index);
+
+      /// \brief Add a resource whose content / state comes from outside of the graph (always an output)
+      /// \param state the last write (stage / access) and the current layout of the resource
+      rg_resource add_imported_resource(std::string name, bool is_image, bool is_exclusive, uint32_t owner, const usage_t& state);
+      /// \brief Add a resource that only lives for the duration of the graph
+      rg_resource add_transient_resource(std::string name, bool is_image);
+
+      void mark_output(rg_resource res);
+
+      uint32_t add_pass(std::string name, uint32_t queue);
+      void add_access(uint32_t pass, rg_resource res, const usage_t& usage, bool write);
+      void set_has_side_effects(uint32_t pass);
+
+    public: // compilation, in that order
+      /// \brief Cull the passes and compute the lifetime of the resources (reset the stats)
+      void cull_passes();
+
+      /// \brief Set the memory requirements of a used transient resource (must be done before place_transients)
+      void set_memory_requirements(rg_resource res, const VkMemoryRequirements& requirements);
+
+      /// \brief Place the transient resources of \p list in a single allocation.
+      /// Resources with disjoint lifetimes can share the same memory.
+      transient_heap_t place_transients(const std::vector<rg_resource>& list);
+
+      /// \brief Generate the barriers, the queue ownership transfers and the cross-queue dependencies of the kept passes
+      void generate_barriers();
+
+      /// \brief Give the exclusive imported resources back to their owner queue family
+      void return_imported_resources();
+
+    public: // results
+      [[nodiscard]] uint32_t get_resource_count() const { return (uint32_t)resources.size(); }
+      [[nodiscard]] const resource_t& get_resource(rg_resource res) const { return resources[res]; }
+
+      [[nodiscard]] uint32_t get_pass_count() const { return (uint32_t)passes.size(); }
+      [[nodiscard]] const pass_t& get_pass(uint32_t pass) const { return passes[pass]; }
+
+      [[nodiscard]] uint32_t get_queue_family(uint32_t queue) const { return queue_families[queue]; }
+
+      /// \brief queue ownership acquisitions of the imported resources, recorded on their owner queue before anything else
+      [[nodiscard]] const std::map<uint32_t, barrier_list_t>& get_prologues() const { return prologues; }
+      /// \brief queue ownership releases of the imported resources (back to their owner queue), recorded after everything else
+      [[nodiscard]] const std::map<uint32_t, epilogue_t>& get_epilogues() const { return epilogues; }
+
+      [[nodiscard]] const render_graph_stats& get_stats() const { return stats; }
+      [[nodiscard]] render_graph_stats& get_stats() { return stats; }
+
+    private:
+      void compute_lifetimes();
+      void add_barrier(barrier_list_t& list, rg_resource res, const usage_t& src, const usage_t& dst,
+                       VkImageLayout old_layout, VkImageLayout new_layout,
+                       uint32_t src_family = VK_QUEUE_FAMILY_IGNORED, uint32_t dst_family = VK_QUEUE_FAMILY_IGNORED);
+      void add_dependency(uint32_t pass, uint32_t prev_pass);
+
+    private:
+      std::vector<uint32_t> queue_families;
+      std::vector<resource_t> resources;
+      std::vector<pass_t> passes;
+
+      std::map<uint32_t, barrier_list_t> prologues;
+      std::map<uint32_t, epilogue_t> epilogues;
+
+      render_graph_stats stats;
+  };
+}
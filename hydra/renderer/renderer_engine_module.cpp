@@ -47,6 +47,7 @@ namespace neam::hydra
     gfr.gpu_features.get_device_features().shaderInt64 = true;
     gfr.gpu_features.get_device_features().shaderInt16 = true;
     gfr.gpu_features.get_device_features().multiDrawIndirect = true;
+    gfr.gpu_features.get_device_features().textureCompressionBC = true;
     gfr.gpu_features.get_device_features().sparseBinding = true;
 
     gfr.gpu_features.get_device_features().sparseResidencyImage2D = true;
@@ -75,6 +76,8 @@ namespace neam::hydra
 
     // we require dynamic rendering
     gfr.gpu_features.get<VkPhysicalDeviceVulkan13Features>().dynamicRendering = true;
+    // the render-graph emits synchronization2 barriers
+    gfr.gpu_features.get<VkPhysicalDeviceVulkan13Features>().synchronization2 = true;
     VkPhysicalDeviceFeatures& vkdevfeatures = gfr.gpu_features.get_device_features();
     vkdevfeatures.imageCubeArray = true;
 
@@ -95,6 +98,10 @@ namespace neam::hydra
     vk12features.drawIndirectCount = true;
     vk12features.bufferDeviceAddress = true;
     vk12features.descriptorIndexing = true;
+    // queues progress is tracked with timeline semaphores
+    vk12features.timelineSemaphore = true;
+    // the gpu profiler resets its timestamp queries on the host
+    vk12features.hostQueryReset = true;
 
     // vk12features.shaderInputAttachmentArrayDynamicIndexing;
     vk12features.shaderUniformTexelBufferArrayDynamicIndexing = true;
@@ -164,11 +171,12 @@ namespace neam::hydra
     vk::submit_info si { *hctx };
 
     hctx->textures.process_start_of_frame(si);
+    hctx->meshes.process_start_of_frame(si);
 
     si.deferred_submit();
 
     if (hctx->ppmgr.should_refresh())
-      hctx->ppmgr.refresh();
+      hctx->ppmgr.refresh_reloaded_shaders();
   }
 
   void renderer_module::on_context_set()
@@ -182,6 +190,7 @@ namespace neam::hydra
     }
     // create the universe / task-order:
     universe = std::make_unique<ecs::universe>(hctx->db);
+    universe->set_world_transform_listener(&hctx->transforms);
     {
       auto& root = universe->get_universe_root_entity();
       std::lock_guard _el(spinlock_exclusive_adapter::adapt(root.get_lock()));
@@ -289,33 +298,11 @@ namespace neam::hydra
         hctx->allocator.flush_empty_allocations();
       });
 
-      // force a sync
-      {
-        std::lock_guard _l { hctx->dqe.lock };
-        hctx->dqe.defer_sync_unlocked();
-      }
+      hctx->gpu_prof.end_frame();
 
-      // add the main queue fences:
-      vk::fence gqf { hctx->device };
-      vk::fence cqf { hctx->device };
-      vk::fence tqf { hctx->device };
-      vk::fence slow_tqf { hctx->device };
-
-      vk::submit_info si { *vctx };
-      si.on(hctx->gqueue).signal(gqf);
-      si.on(hctx->cqueue).signal(cqf);
-      si.on(hctx->tqueue).signal(tqf);
-      si.on(hctx->slow_tqueue).signal(slow_tqf);
-
-      si.deferred_submit();
-
-      hctx->dfe.set_end_frame_fences(
-      cr::construct<std::vector>(
-        std::pair<uint32_t, vk::fence>{hctx->dfe.queue_mask(hctx->gqueue), std::move(gqf)},
-        std::pair<uint32_t, vk::fence>{hctx->dfe.queue_mask(hctx->cqueue), std::move(cqf)},
-        std::pair<uint32_t, vk::fence>{hctx->dfe.queue_mask(hctx->tqueue), std::move(tqf)},
-        std::pair<uint32_t, vk::fence>{hctx->dfe.queue_mask(hctx->slow_tqueue), std::move(slow_tqf)}
-      ));
+      // end the frame on the queues timelines:
+      // (every submission signals its queue timeline, so there's no need for end-of-frame fences / submissions)
+      hctx->dfe.set_end_frame_timelines(hctx->gqueue, hctx->cqueue, hctx->tqueue, hctx->slow_tqueue);
 
       hctx->gcpm.flip();
       hctx->tcpm.flip();
@@ -327,6 +314,11 @@ namespace neam::hydra
   void renderer_module::on_start_shutdown()
   {
     hctx->textures.begin_engine_shutdown();
+    hctx->transforms.begin_engine_shutdown();
+    hctx->meshes.begin_engine_shutdown();
+
+    // persist the pipelines compiled during this session:
+    hctx->ppmgr.save_pipeline_cache();
   }
 
   void renderer_module::on_shutdown_post_idle_gpu()
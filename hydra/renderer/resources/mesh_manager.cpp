@@ -26,7 +26,628 @@
 
 #include "mesh_manager.hpp"
 
+#include "resource_array.tpl.hpp"
+
+#include <array>
+#include <cstring>
+#include <span>
+
+#include <hydra/engine/hydra_context.hpp>
+#include <meshoptimizer/src/meshoptimizer.h>
+
 namespace neam::hydra
 {
-}
+  static uint64_t align_arena_size(uint64_t size, uint64_t alignment)
+  {
+    return (size + alignment - 1) & ~(alignment - 1);
+  }
+
+  /// \brief Size of the LOD buffers once decoded, in the order they are placed in the arena
+  static std::array<uint64_t, 5> get_decoded_lod_sizes(const assets::static_mesh_lod& lod)
+  {
+    if (lod.codec == assets::static_mesh_lod_codec::none)
+    {
+      return
+      {
+        lod.vertex_data.size, lod.vertex_indirection_data.size, lod.meshlet_index_data.size,
+        lod.meshlet_data.size, lod.meshlet_culling_data.size,
+      };
+    }
+    return
+    {
+      (uint64_t)lod.vertex_count * sizeof(assets::packed_data::vertex_data),
+      (uint64_t)lod.vertex_indirection_count * sizeof(uint32_t),
+      lod.meshlet_index_size,
+      (uint64_t)lod.meshlet_count * sizeof(assets::packed_data::meshlet_data),
+      (uint64_t)lod.meshlet_count * sizeof(assets::packed_data::meshlet_culling_data),
+    };
+  }
+
+  /// \brief Decode (or copy, for LODs that are not encoded) the LOD buffers in \p out, placed one after the other (aligned on \p alignment).
+  /// Return false on failure.
+  /// \note out is staging memory: the decoded data is never written anywhere else
+  static bool decode_lod(const assets::static_mesh_lod& lod, const std::array<uint64_t, 5>& sizes, uint64_t alignment, std::span<uint8_t> out)
+  {
+    const raw_data* buffers[] = { &lod.vertex_data, &lod.vertex_indirection_data, &lod.meshlet_index_data, &lod.meshlet_data, &lod.meshlet_culling_data };
+    const size_t element_sizes[] = { sizeof(assets::packed_data::vertex_data), sizeof(uint32_t), 4, sizeof(assets::packed_data::meshlet_data), sizeof(assets::packed_data::meshlet_culling_data) };
+
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < sizes.size(); ++i)
+    {
+      const raw_data& in = *buffers[i];
+      const std::span<uint8_t> dst = out.subspan(offset, sizes[i]);
+      offset += align_arena_size(sizes[i], alignment);
+      if (sizes[i] == 0)
+        continue;
+
+      if (lod.codec == assets::static_mesh_lod_codec::none)
+      {
+        memcpy(dst.data(), in.data.get(), dst.size());
+        continue;
+      }
+
+      const size_t element_count = dst.size() / element_sizes[i];
+      // the vertex indirection is an index sequence, the other buffers are vertex buffers:
+      const int ret = i == 1 ? meshopt_decodeIndexSequence((uint32_t*)dst.data(), element_count, sizeof(uint32_t), (const uint8_t*)in.data.get(), in.size)
+                             : meshopt_decodeVertexBuffer(dst.data(), element_count, element_sizes[i], (const uint8_t*)in.data.get(), in.size);
+      if (ret != 0)
+        return false;
+    }
+    return true;
+  }
+
+  mesh_manager::mesh_manager(hydra_context& _hctx)
+    : hctx(_hctx)
+  {
+    on_index_loaded_tk = hctx.res.on_index_loaded.add(*this, &mesh_manager::force_full_reload);
+
+    txctx.debug_context = "mesh_manager::txctx";
+  }
+
+  mesh_index_t mesh_manager::request_mesh_index(string_id mesh_rid)
+  {
+    {
+      std::lock_guard _l {spinlock_shared_adapter::adapt(mesh_id_map_lock)};
+      if (auto it = mesh_id_map.find(mesh_rid); it != mesh_id_map.end())
+        return it->second;
+    }
+
+    mesh_index_t index = k_invalid_mesh_index;
+    {
+      std::lock_guard _l {spinlock_exclusive_adapter::adapt(mesh_id_map_lock)};
+      // first, check that someone didn't add it from under us:
+      if (auto it = mesh_id_map.find(mesh_rid); it != mesh_id_map.end())
+        return it->second;
+      const size_t old_size = res.entries.size();
+      index = res.find_or_create_new_entry(configuration.max_entries, configuration.entries_to_allocate_at_once, configuration.evict_no_question_asked);
+
+      if (index == k_invalid_mesh_index)
+      {
+        cr::out().warn("mesh-manager: failed to allocate space for `{}`: reached max number of in-use meshes ({})", mesh_rid, configuration.max_entries);
+        return index;
+      }
+      if (old_size != res.entries.size())
+      {
+        cr::out().debug("mesh-manager: resized resource array to {} entries", res.entries.size());
+      }
+
+      mesh_id_map.emplace(mesh_rid, index);
+      // remove the previous entry, if we were re-using an existing entry
+      if (res.entries[index].asset_rid != id_t::none)
+        mesh_id_map.erase(res.entries[index].asset_rid);
+    }
+
+    // reset the entry to a pre-init state:
+    {
+      std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+      std::lock_guard _lg {spinlock_exclusive_adapter::adapt(res.entries[index].lock)};
+
+      evict_lods_unlocked(res.entries[index], 0);
+
+      utilities::resource_array_entry_base_t base_save = res.entries[index];
+      const uint32_t residency_generation = res.entries[index].residency_generation;
+      res.entries[index] = mesh_entry { .residency_generation = residency_generation + 1, .asset_rid = mesh_rid };
+      *(utilities::resource_array_entry_base_t*)(&res.entries[index]) = base_save;
+      res.entries[index].last_frame_with_usage = res.frame_counter;
+    }
+    has_changed.store(true, std::memory_order_release);
+
+    cr::out().debug("mesh-manager: loading `{}`...", mesh_rid);
+
+    // load the mesh data
+    load_mesh_data_unlocked(index, mesh_rid);
+
+    return index;
+  }
+
+  void mesh_manager::indicate_mesh_usage(mesh_index_t mid, uint32_t targetted_lod_level)
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+    if (mid == k_invalid_mesh_index || mid >= (uint32_t)res.entries.size()) [[unlikely]]
+      return;
+
+    auto& entry = res.entries[mid];
+    const uint8_t lod_level = (uint8_t)std::min<uint32_t>(targetted_lod_level, k_invalid_lod - 1);
+    // keep the finest LOD requested during the frame:
+    if (entry.last_frame_with_usage != res.frame_counter || lod_level < entry.requested_lod_level)
+      entry.requested_lod_level = lod_level;
+    entry.last_frame_with_usage = res.frame_counter;
+  }
+
+  void mesh_manager::clear()
+  {
+    {
+      std::lock_guard _l {spinlock_exclusive_adapter::adapt(mesh_id_map_lock)};
+      mesh_id_map.clear();
+      {
+        std::lock_guard _pl(pending_uploads_lock);
+        pending_uploads.clear();
+      }
+
+      // the whole arena goes away, so any deferred free is now meaningless
+      arena_generation.fetch_add(1, std::memory_order_acq_rel);
+      arena_allocator.reset(0);
+      memory_pending_free.store(0, std::memory_order_release);
+
+      txctx.clear();
+      hctx.dfe.defer_destruction(std::move(gpu_state), (res.clear()));
+      gpu_state.arena_buffer.reset();
+      gpu_state.table_buffer.reset();
+    }
+
+    has_changed.store(true, std::memory_order_release);
+
+    // end by triggering the event (with no lock held)
+    on_mesh_pool_cleared.call();
+  }
+
+  void mesh_manager::force_full_reload()
+  {
+    cr::out().warn("mesh-manager: reloading all meshes from disk");
+    {
+      std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+
+      for (uint32_t i = 0; i < (uint32_t)res.entries.size(); ++i)
+      {
+        auto& it = res.entries[i];
+        if (it.asset_rid != id_t::none)
+        {
+          {
+            std::lock_guard _gl { spinlock_exclusive_adapter::adapt(it.lock) };
+            evict_lods_unlocked(it, 0);
+            it.invalid_resource = true;
+          }
+          load_mesh_data_unlocked(i, it.asset_rid);
+        }
+      }
+    }
+    hctx.hconf.read_or_create_conf(configuration);
+  }
+
+  assets::static_mesh mesh_manager::get_mesh_asset(mesh_index_t index) const
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+    if (index >= (uint32_t)res.entries.size())
+      return {};
+    std::lock_guard _gl { spinlock_shared_adapter::adapt(res.entries[index].lock) };
+    if (res.entries[index].invalid_resource)
+      return {};
+    return res.entries[index].mesh_information;
+  }
+
+  void mesh_manager::load_mesh_data_unlocked(mesh_index_t mid, string_id rid)
+  {
+    hctx.res.read_resource<assets::static_mesh>(rid).then(&hctx.tm, threading::k_non_transient_task_group, [this, mid, rid](assets::static_mesh&& mesh_res, resources::status st)
+    {
+      TRACY_SCOPED_ZONE;
+      if (st == resources::status::failure) [[unlikely]]
+      {
+        cr::out().error("mesh_manager: failed to load mesh `{}` (invalid resource or resource type).\n"
+                        "              This will consume a mesh slot until the mesh is evicted.", rid);
+        return;
+      }
+
+      // we need the shared lock to prevent anyone from resizing the array from under us
+      std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+      if (res.entries.size() <= mid)
+        return;
+
+      auto& entry = res.entries[mid];
+      if (entry.asset_rid != rid)
+        return;
+      if (mesh_res.lods.empty())
+      {
+        cr::out().warn("mesh_manager: loaded mesh data for `{}`, but mesh has no LOD.", rid);
+        return;
+      }
+      if (mesh_res.lods.size() > shader_structs::k_max_mesh_lod_count)
+      {
+        // LODs are stored from the coarsest to the finest, and finer LODs only reference coarser ones
+        cr::out().warn("mesh_manager: mesh `{}` has {} LODs, only the {} coarsest ones will be used", rid, mesh_res.lods.size(), shader_structs::k_max_mesh_lod_count);
+        mesh_res.lods.resize(shader_structs::k_max_mesh_lod_count);
+      }
+
+      {
+        std::lock_guard _gl { spinlock_exclusive_adapter::adapt(entry.lock) };
+        if (entry.invalid_resource == false)
+        {
+          cr::out().error("mesh_manager: load_mesh_data_unlocked for `{}`: data was already loaded, overwriting it", rid);
+          evict_lods_unlocked(entry, 0);
+        }
+
+        entry.mesh_information = std::move(mesh_res);
+        entry.lod_count = (uint8_t)entry.mesh_information.lods.size();
+        entry.invalid_resource = false;
+      }
+      has_changed.store(true, std::memory_order_release);
+    });
+  }
+
+  void mesh_manager::load_lod_data_unlocked(mesh_entry& entry, mesh_index_t mid)
+  {
+    TRACY_SCOPED_ZONE_COLOR(0x7FFF00);
+
+    std::vector<std::pair<uint32_t, id_t>> lods_to_load;
+    uint32_t residency_generation;
+    string_id rid;
+    {
+      std::lock_guard _gl { spinlock_exclusive_adapter::adapt(entry.lock) };
+
+      if (entry.invalid_resource || entry.lod_count == 0 || entry.requested_lod_level == k_invalid_lod)
+        return;
+
+      // LOD level 0 is the finest LOD, which is the last entry of the LOD array
+      const uint32_t target_lod_count = entry.lod_count - std::min<uint32_t>(entry.requested_lod_level, entry.lod_count - 1);
+      if (target_lod_count <= entry.streamed_lod_count)
+        return;
+
+      // stream from the coarsest to the finest, skipping what is already there/in-flight
+      for (uint32_t i = entry.streamed_lod_count; i < target_lod_count; ++i)
+      {
+        if (entry.lods[i].arena_offset == utilities::range_allocator::k_invalid_offset)
+          lods_to_load.emplace_back(i, entry.mesh_information.lods[i]);
+      }
+      entry.streamed_lod_count = (uint8_t)target_lod_count; // assign now to prevent streaming data in-loop
+      residency_generation = entry.residency_generation;
+      rid = entry.asset_rid;
+    }
+
+    for (const auto& [lod_position, lod_rid] : lods_to_load)
+    {
+      hctx.res.read_resource<assets::static_mesh_lod>(lod_rid)
+      .then(&hctx.tm, threading::k_non_transient_task_group, [this, mid, rid, residency_generation, lod_position](assets::static_mesh_lod&& lod, resources::status st)
+      {
+        TRACY_SCOPED_ZONE_COLOR(0x8FFF00);
 
+        // Either assign the arena range to the entry, or give the LOD back so that it can be streamed again later.
+        // Return false if the entry changed (or the LOD got evicted) in the meantime.
+        const auto update_entry = [&, this](uint64_t arena_offset, uint64_t arena_size)
+        {
+          std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+          if (res.entries.size() <= mid)
+            return false;
+          auto& entry = res.entries[mid];
+          std::lock_guard _gl { spinlock_exclusive_adapter::adapt(entry.lock) };
+          if (entry.asset_rid != rid || entry.residency_generation != residency_generation)
+            return false;
+          if (arena_offset == utilities::range_allocator::k_invalid_offset || entry.lods[lod_position].arena_offset != utilities::range_allocator::k_invalid_offset)
+          {
+            entry.streamed_lod_count = std::min<uint8_t>(entry.streamed_lod_count, lod_position);
+            return false;
+          }
+          entry.lods[lod_position].arena_offset = arena_offset;
+          entry.lods[lod_position].arena_size = arena_size;
+          entry.lods[lod_position].uploaded = false;
+          return true;
+        };
+
+        if (st != resources::status::success)
+        {
+          // NOTE: the LOD is not given back, as that would lead to an endless stream of failures
+          cr::out().error("mesh_manager: failed to load LOD {} of mesh `{}`.", lod_position, rid);
+          return;
+        }
+        if (lod.codec != assets::static_mesh_lod_codec::none && lod.codec != assets::static_mesh_lod_codec::meshopt)
+        {
+          cr::out().error("mesh_manager: failed to decode LOD {} of mesh `{}`: unknown codec.", lod_position, rid);
+          return;
+        }
+
+        const std::array<uint64_t, 5> sizes = get_decoded_lod_sizes(lod);
+        uint64_t arena_size = 0;
+        for (const uint64_t size : sizes)
+          arena_size += align_arena_size(size, k_arena_alignment);
+
+        // the LOD is decoded directly in staging memory, with the layout it has in the arena, so it is uploaded with a single copy
+        transfer_context::staging_memory data;
+        if (arena_size > 0)
+        {
+          data = txctx.allocate_staging(arena_size);
+          if (!decode_lod(lod, sizes, k_arena_alignment, data.data()))
+          {
+            cr::out().error("mesh_manager: failed to decode LOD {} of mesh `{}`.", lod_position, rid);
+            return;
+          }
+        }
+
+        uint64_t arena_offset = arena_allocator.allocate(arena_size, k_arena_alignment);
+        if (arena_offset == utilities::range_allocator::k_invalid_offset)
+        {
+          // try to make some space. (the memory will only be available in a few frames)
+          memory_budget_fit(true);
+          update_entry(utilities::range_allocator::k_invalid_offset, 0);
+          return;
+        }
+        if (!update_entry(arena_offset, arena_size))
+        {
+          // the range was never referenced by anything, no need to defer its release
+          arena_allocator.free(arena_offset, arena_size, k_arena_alignment);
+          return;
+        }
+
+        std::lock_guard _pl(pending_uploads_lock);
+        pending_uploads.push_back(
+        {
+          .mid = mid,
+          .rid = rid,
+          .residency_generation = residency_generation,
+          .lod_position = lod_position,
+          .arena_offset = arena_offset,
+          .arena_size = arena_size,
+          .buffer_sizes = sizes,
+          .meshlet_count = lod.lod_data.size >= sizeof(assets::packed_data::lod_data) ? lod.lod_data.get_as<assets::packed_data::lod_data>()->meshlet_count : 0,
+          .data = std::move(data),
+        });
+      });
+    }
+  }
+
+  void mesh_manager::evict_lods_unlocked(mesh_entry& entry, uint32_t first_lod_position)
+  {
+    const uint8_t kept_lod_count = std::min<uint8_t>(entry.resident_lod_count, first_lod_position);
+    bool has_evicted_anything = entry.streamed_lod_count > kept_lod_count;
+    for (uint32_t i = 0; i < entry.lods.size(); ++i)
+    {
+      // in-flight LODs (allocated but not uploaded) will be discarded, so they must be freed too
+      if (i < first_lod_position && entry.lods[i].uploaded)
+        continue;
+      if (entry.lods[i].arena_offset != utilities::range_allocator::k_invalid_offset)
+      {
+        deferred_arena_free(entry.lods[i].arena_offset, entry.lods[i].arena_size);
+        has_evicted_anything = true;
+      }
+      entry.lods[i] = {};
+    }
+
+    if (!has_evicted_anything)
+      return;
+
+    entry.resident_lod_count = kept_lod_count;
+    entry.streamed_lod_count = kept_lod_count;
+    entry.residency_generation += 1;
+    has_changed.store(true, std::memory_order_release);
+  }
+
+  void mesh_manager::deferred_arena_free(uint64_t offset, uint64_t size)
+  {
+    memory_pending_free.fetch_add(align_arena_size(size, k_arena_alignment), std::memory_order_relaxed);
+    hctx.dfe.defer([this, offset, size, generation = arena_generation.load(std::memory_order_acquire)]
+    {
+      // the arena has been destroyed in the meantime
+      if (generation != arena_generation.load(std::memory_order_acquire))
+        return;
+      arena_allocator.free(offset, size, k_arena_alignment);
+      memory_pending_free.fetch_sub(align_arena_size(size, k_arena_alignment), std::memory_order_relaxed);
+    });
+  }
+
+  void mesh_manager::upload_pending_lods()
+  {
+    TRACY_SCOPED_ZONE;
+    std::mtc_vector<pending_upload_t> uploads;
+    {
+      std::lock_guard _pl(pending_uploads_lock);
+      uploads.swap(pending_uploads);
+    }
+    if (uploads.empty() || !gpu_state.arena_buffer)
+      return;
+
+    vk::buffer& arena = gpu_state.arena_buffer->buffer;
+    txctx.acquire(arena, hctx.gqueue);
+    {
+      std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+      for (auto& it : uploads)
+      {
+        if (res.entries.size() <= it.mid)
+          continue;
+        auto& entry = res.entries[it.mid];
+        std::lock_guard _gl { spinlock_exclusive_adapter::adapt(entry.lock) };
+        // the LOD was evicted (and its range freed) in the meantime:
+        if (entry.asset_rid != it.rid || entry.residency_generation != it.residency_generation)
+          continue;
+
+        if (it.data.is_valid())
+          txctx.transfer(arena, std::move(it.data), it.arena_offset);
+
+        // the buffers are placed one after the other, with the same layout as the staging memory:
+        uint64_t offset = it.arena_offset;
+        const auto next_buffer_offset = [&](uint64_t size) -> uint32_t
+        {
+          const uint32_t uint_offset = (uint32_t)(offset / sizeof(uint32_t));
+          offset += align_arena_size(size, k_arena_alignment);
+          return uint_offset;
+        };
+
+        lod_residency_t& lod = entry.lods[it.lod_position];
+        lod.gpu_lod.meshlet_count = it.meshlet_count;
+        lod.gpu_lod.vertex_data_offset = next_buffer_offset(it.buffer_sizes[0]);
+        lod.gpu_lod.vertex_indirection_offset = next_buffer_offset(it.buffer_sizes[1]);
+        lod.gpu_lod.meshlet_index_offset = next_buffer_offset(it.buffer_sizes[2]);
+        lod.gpu_lod.meshlet_data_offset = next_buffer_offset(it.buffer_sizes[3]);
+        lod.gpu_lod.meshlet_culling_data_offset = next_buffer_offset(it.buffer_sizes[4]);
+        lod.uploaded = true;
+
+        // LODs are only usable if all the coarser ones are there:
+        while (entry.resident_lod_count < entry.lod_count && entry.lods[entry.resident_lod_count].uploaded)
+          ++entry.resident_lod_count;
+      }
+    }
+    txctx.release(arena, hctx.gqueue);
+
+    has_changed.store(true, std::memory_order_release);
+  }
+
+  void mesh_manager::begin_engine_shutdown()
+  {
+    cr::out().debug("mesh-manager: clearing for engine shutdown");
+    clear();
+  }
+
+  void mesh_manager::process_start_of_frame(vk::submit_info& si)
+  {
+    TRACY_SCOPED_ZONE;
+
+    // (re-)create the arena:
+    if (!gpu_state.arena_buffer)
+    {
+      gpu_state.arena_buffer.emplace
+      (
+        hctx.allocator,
+        vk::buffer
+        (
+          hctx.device,
+          configuration.arena_size,
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        ),
+        hydra::allocation_type::persistent
+      );
+      gpu_state.arena_buffer->buffer._set_debug_name("mesh_manager::arena");
+      arena_allocator.reset(configuration.arena_size);
+      has_changed.store(true, std::memory_order_release);
+    }
+
+    res.start_frame([this](auto& it, uint32_t i)
+    {
+      load_lod_data_unlocked(it, i);
+    });
+
+    memory_budget_fit();
+
+    upload_pending_lods();
+
+    if (has_changed.exchange(false, std::memory_order_acq_rel))
+    {
+      raw_data table_raw_data;
+      {
+        std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+
+        // index 0 is the empty mesh
+        const uint32_t mesh_count = (uint32_t)res.entries.size() + 1;
+        const size_t table_size = sizeof(uint32_t) + mesh_count * sizeof(shader_structs::mesh_entry_t);
+
+        // resize the table buffer if necessary:
+        if (!gpu_state.table_buffer || gpu_state.table_buffer->buffer.size() < table_size)
+        {
+          hctx.dfe.defer_destruction(std::move(gpu_state.table_buffer));
+
+          gpu_state.table_buffer.emplace
+          (
+            hctx.allocator,
+            vk::buffer
+            (
+              hctx.device,
+              table_size,
+              VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            ),
+            hydra::allocation_type::persistent
+          );
+          gpu_state.table_buffer->buffer._set_debug_name("mesh_manager::table");
+
+          hctx.dfe.defer_destruction(gpu_state.descriptor_set.reset());
+          gpu_state.descriptor_set.mesh_manager_meshes = gpu_state.table_buffer->buffer;
+          gpu_state.descriptor_set.mesh_manager_arena = gpu_state.arena_buffer->buffer;
+          gpu_state.descriptor_set.update_descriptor_set(hctx);
+        }
+
+        table_raw_data = raw_data::allocate(table_size);
+        memset(table_raw_data.get(), 0, table_size);
+        auto* data = table_raw_data.get_as<shader_structs::mesh_table_t>();
+        data->mesh_count = mesh_count;
+
+        for (uint32_t i = 0; i < (uint32_t)res.entries.size(); ++i)
+        {
+          auto& it = res.entries[i];
+          if (it.entry_state == utilities::resource_array_entry_state_t::free)
+            continue;
+
+          std::lock_guard _gl { spinlock_shared_adapter::adapt(it.lock) };
+          if (it.invalid_resource)
+            continue;
+
+          shader_structs::mesh_entry_t& gpu_entry = data->meshes[mesh_index_to_gpu_index(i)];
+          gpu_entry.bounding_sphere = it.mesh_information.bounding_sphere;
+          gpu_entry.lod_count = it.lod_count;
+          gpu_entry.resident_lod_count = it.resident_lod_count;
+          for (uint32_t j = 0; j < it.resident_lod_count; ++j)
+            gpu_entry.lods[j] = it.lods[j].gpu_lod;
+        }
+      }
+
+      // operations to be done without any lock held:
+      txctx.acquire(gpu_state.table_buffer->buffer, hctx.gqueue);
+      txctx.transfer(gpu_state.table_buffer->buffer, std::move(table_raw_data));
+      txctx.release(gpu_state.table_buffer->buffer, hctx.gqueue);
+    }
+
+    txctx.build(si);
+  }
+
+  void mesh_manager::memory_budget_fit(bool aggressive)
+  {
+    // check if there's anything to do:
+    if (!aggressive && get_total_gpu_memory() < configuration.max_pool_memory)
+      return;
+
+    std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+    {
+      std::lock_guard _lh(res.list_header_lock);
+
+      // iterate over the unused resources, and evict those that are old until we fit in budget
+      // NOTE: the entries are kept (they are cheap), only their GPU data goes away
+      bool done = false;
+      res.for_each_unused_entries_unlocked([this, &done](auto& entry, uint32_t /*index*/)
+      {
+        if (done || entry.invalid_resource)
+          return;
+        if (get_total_gpu_memory() < configuration.max_pool_memory)
+        {
+          done = true;
+          return;
+        }
+
+        std::lock_guard _gl { spinlock_exclusive_adapter::adapt(entry.lock) };
+        evict_lods_unlocked(entry, 0);
+      });
+    }
+
+    if (!aggressive || get_total_gpu_memory() < configuration.max_pool_memory)
+      return;
+
+    // still not enough: evict the LODs that are finer than what is currently requested
+    for (auto& entry : res.entries)
+    {
+      if (get_total_gpu_memory() < configuration.max_pool_memory)
+        return;
+      if (entry.entry_state == utilities::resource_array_entry_state_t::free)
+        continue;
+
+      std::lock_guard _gl { spinlock_exclusive_adapter::adapt(entry.lock) };
+      if (entry.invalid_resource || entry.lod_count == 0)
+        continue;
+      const uint32_t needed_lod_count = entry.requested_lod_level == k_invalid_lod ? 1
+                                        : entry.lod_count - std::min<uint32_t>(entry.requested_lod_level, entry.lod_count - 1);
+      if (entry.streamed_lod_count > needed_lod_count)
+        evict_lods_unlocked(entry, needed_lod_count);
+    }
+  }
+}
@@ -30,15 +30,65 @@
 #include <ntools/id/string_id.hpp>
 #include <ntools/event.hpp>
 #include <ntools/type_utilities.hpp>
+#include <ntools/mt_check/unordered_map.hpp>
+#include <ntools/mt_check/vector.hpp>
 
+#include <hydra/engine/conf/conf.hpp>
 #include <hydra/utilities/holders.hpp>
 #include <hydra/utilities/transfer_context.hpp>
 
 #include <hydra/assets/static_mesh.hpp>
 
 #include "resource_array.hpp"
+#include "range_allocator.hpp"
 #include "mesh_manager_shader_structs.hpp"
 
+namespace neam::hydra
+{
+  struct mesh_manager_configuration : hydra::conf::hconf<mesh_manager_configuration, "configuration/mesh_manager.hcnf", conf::location_t::index_program_local_dir>
+  {
+    uint32_t entries_to_allocate_at_once = 64;
+    uint32_t max_entries = 8192;
+    uint64_t evict_no_question_asked = 7200; // FIXME: maybe time based? (number of ms?)
+    uint64_t arena_size = 256ull * 1024 * 1024;
+    uint64_t max_pool_memory = 192ull * 1024 * 1024;
+  };
+}
+
+N_METADATA_STRUCT(neam::hydra::mesh_manager_configuration)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(entries_to_allocate_at_once, neam::metadata::info{.description = c_string_t
+    <
+      "By how much new entries the array of resource grows everytimes it needs to grow.\n"
+      "A bigger number mean bigger updates in case of high contention, for the cost of more unused entries"
+    >}),
+    N_MEMBER_DEF(max_entries, neam::metadata::info{.description = c_string_t
+    <
+      "Max number of entries in the array of resource. No extra entry will be held that this amount.\n"
+      "If that number is too low, requested resources will not be loaded or will be unloaded as soon as they are not used, leading to extra IO operations"
+    >}),
+    N_MEMBER_DEF(evict_no_question_asked, neam::metadata::info{.description = c_string_t
+    <
+      "Past this time (in frame for now), the resource will be evicted if a new resource need to be loaded.\n"
+      "A low number might leed to extra turnaround, while a too high number will lead the manager to keep all resource loaded until max_entries is reached.\n"
+      "This value is ignored when max_entries is reached (this value can be seen as a chance to avoid growing the resource array).\n"
+    >}),
+    N_MEMBER_DEF(arena_size, neam::metadata::info{.description = c_string_t
+    <
+      "Size (in bytes) of the GPU buffer all the mesh data (vertices, meshlets, culling data) is sub-allocated from.\n"
+      "This is a hard limit, and is only read when the arena is created (first frame or after a clear)."
+    >}),
+    N_MEMBER_DEF(max_pool_memory, neam::metadata::info{.description = c_string_t
+    <
+      "Max GPU memory (in bytes) that the meshes will use\n"
+      "Past this limit, unused meshes are evicted (and then the finest LODs of the meshes that don't need them).\n"
+      "Should be lower than arena_size, to leave some space to fragmentation."
+    >})
+  >;
+};
+
 namespace neam::hydra
 {
   struct hydra_context;
@@ -47,12 +97,18 @@ namespace neam::hydra
   static constexpr mesh_index_t k_invalid_mesh_index = ~0u;
 
   /// \brief Handle mesh stream-in/stream-out and resource management
-  /// \todo Stream-out based on usage (need gpu->cpu transfers)
+  /// All the mesh data is sub-allocated from a single GPU buffer (the arena), and is described by a table of mesh_entry_t.
+  /// LODs are streamed from the coarsest to the finest, and are only considered resident if all the coarser LODs are.
+  /// \note LOD levels are like mip levels: 0 is the finest LOD
   class mesh_manager
   {
     public:
       explicit mesh_manager(hydra_context& _hctx);
 
+      /// \brief Return the GPU memory currently used by the meshes (in the arena)
+      /// \note Memory that is waiting for the GPU to be done with it before being freed is not accounted for
+      uint64_t get_total_gpu_memory() const { return arena_allocator.get_used_size() - memory_pending_free.load(std::memory_order_relaxed); }
+
       /// \brief Ask for that mesh to be considered for streamed-in, return a unique index for that mesh
       /// \note That function can be called multiple time for the same resource, and will always return the same value
       /// \note The returned index is valid until the next call to clear()
@@ -61,16 +117,14 @@ namespace neam::hydra
       ///          (+ an error will be logged)
       [[nodiscard]] mesh_index_t request_mesh_index(string_id mesh_rid);
 
-      /// \brief Indicate, cpu-side, that the specified texture is being used at a specified mip-level
-      ///        Will trigger stream-in of the texture or prevent it from being streamed-out
-      /// \note There is a mechanism to perform this operation directly/automatically in the shaders reading the texture
-      /// \todo that mechanism
+      /// \brief Indicate, cpu-side, that the specified mesh is being used at a specified LOD level
+      ///        Will trigger stream-in of the LOD (and all the coarser ones) or prevent it from being streamed-out
       void indicate_mesh_usage(mesh_index_t mid, uint32_t targetted_lod_level);
 
       constexpr uint32_t mesh_index_to_gpu_index(mesh_index_t mid) const { return mid + 1; }
 
-      /// \brief Fully clear all textures, invalidating all the texture indices
-      /// \note trigger on_texture_pool_cleared
+      /// \brief Fully clear all meshes, invalidating all the mesh indices
+      /// \note trigger on_mesh_pool_cleared
       /// \note the answer to an index reload is not a clear of the pool, but a reload of it
       /// \warning Should prooobably be called outside rendering operations / when no rendering context is active
       void clear();
@@ -83,64 +137,119 @@ namespace neam::hydra
 
       shader_structs::mesh_manager_descriptor_set_t& get_descriptor_set() { return gpu_state.descriptor_set; }
       const shader_structs::mesh_manager_descriptor_set_t& get_descriptor_set() const { return gpu_state.descriptor_set; }
+
+      /// \brief Allows to query the bounding sphere / LOD count / ...
+      /// \note If the mesh hasn't been loaded yet, a default object will be returned (with no LODs)
+      assets::static_mesh get_mesh_asset(mesh_index_t index) const;
+
     public: // management:
       void process_start_of_frame(vk::submit_info& si);
 
-    private:
-      static constexpr uint32_t k_invalid_index = ~0u;
-      static constexpr uint32_t k_invalid_lod = 0xFF;
+      void begin_engine_shutdown();
 
-      static constexpr uint32_t k_entries_to_allocate_at_once = 32; // fixme: maybe a bigger number?
-      static constexpr uint32_t k_max_entries = 8192; // fixme: more?
-      static constexpr uint64_t k_evict_no_question_asked = 7200; // fixme: maybe time based?
+      /// \brief Evict unused meshes (then, if aggressive, the LODs that are finer than the requested ones) until we fit the budget
+      void memory_budget_fit(bool aggressive = false);
 
+    private:
+      static constexpr uint32_t k_invalid_index = ~0u;
+      static constexpr uint8_t k_invalid_lod = 0xFF;
+      static constexpr uint64_t k_arena_alignment = 16;
 
-      struct mesh_gpu_data
+      struct lod_residency_t
       {
-        std::optional<buffer_holder> buffer;
+        uint64_t arena_offset = utilities::range_allocator::k_invalid_offset;
+        uint64_t arena_size = 0;
+        bool uploaded = false;
 
-        mutable skip_copy<shared_spinlock> lock;
+        shader_structs::mesh_lod_t gpu_lod = {};
       };
+
       struct mesh_entry : utilities::resource_array_entry_base_t
       {
         uint8_t requested_lod_level = k_invalid_lod;
-        uint8_t streamed_lod_level = k_invalid_lod;
+        uint8_t lod_count = 0;
+        uint8_t streamed_lod_count = 0; // number of LODs (coarsest first) that have been requested to be streamed
+        uint8_t resident_lod_count = 0; // number of LODs (coarsest first) that are uploaded
 
         bool invalid_resource = true;
 
+        // incremented every time LODs are evicted, so that in-flight loads are discarded
+        uint32_t residency_generation = 0;
+
         string_id asset_rid;
-        // assets::image image_information;
+        assets::static_mesh mesh_information;
+
+        std::array<lod_residency_t, shader_structs::k_max_mesh_lod_count> lods;
+
+        mutable skip_copy<shared_spinlock> lock;
+      };
+
+      /// \brief LOD data waiting to be uploaded in the arena
+      struct pending_upload_t
+      {
+        mesh_index_t mid;
+        string_id rid;
+        uint32_t residency_generation;
+        uint32_t lod_position;
+
+        uint64_t arena_offset;
+        uint64_t arena_size;
+
+        // size of the decoded buffers (vertex, vertex indirection, meshlet index, meshlet, meshlet culling)
+        std::array<uint64_t, 5> buffer_sizes;
+        uint32_t meshlet_count;
 
-        mesh_gpu_data gpu_data;
+        // the decoded buffers, with the arena layout
+        transfer_context::staging_memory data;
       };
+
       struct gpu_state_t
       {
-        // buffer of type: shader_structs::texture_indirection_t
-        std::optional<buffer_holder> indirection_buffer;
+        // buffer of type: shader_structs::mesh_arena_t
+        std::optional<buffer_holder> arena_buffer;
+        // buffer of type: shader_structs::mesh_table_t
+        std::optional<buffer_holder> table_buffer;
 
         // the descriptor set:
         shader_structs::mesh_manager_descriptor_set_t descriptor_set;
       };
 
     private:
-      void load_texture_data_unlocked(mesh_index_t tid, string_id rid);
-      void load_mip_data_unlocked(mesh_entry& entry, mesh_index_t tid);
+      void load_mesh_data_unlocked(mesh_index_t mid, string_id rid);
+      void load_lod_data_unlocked(mesh_entry& entry, mesh_index_t mid);
+
+      /// \brief Free the arena ranges of LODs [first_lod_position, lod_count) and reset the streaming state accordingly
+      /// \note entry.lock must be held exclusively
+      void evict_lods_unlocked(mesh_entry& entry, uint32_t first_lod_position);
+
+      /// \brief Free an arena range once the GPU is done with it
+      void deferred_arena_free(uint64_t offset, uint64_t size);
+
+      void upload_pending_lods();
 
     private:
       hydra_context& hctx;
 
       cr::event_token_t on_index_loaded_tk;
 
-      shared_spinlock texture_id_map_lock;
-      std::unordered_map<id_t, uint32_t> texture_id_map;
+      shared_spinlock mesh_id_map_lock;
+      std::mtc_unordered_map<id_t, uint32_t> mesh_id_map;
 
       utilities::resource_array<mesh_entry> res;
 
+      spinlock pending_uploads_lock;
+      std::mtc_vector<pending_upload_t> pending_uploads;
+
       // gpu resources:
-      shared_spinlock gpu_state_lock;
+      utilities::range_allocator arena_allocator;
+      std::atomic<uint64_t> memory_pending_free { 0 };
+      std::atomic<uint32_t> arena_generation { 0 }; // incremented when the arena is destroyed
       gpu_state_t gpu_state;
 
       transfer_context txctx { hctx };
+
+      std::atomic<bool> has_changed { true };
+
+      mesh_manager_configuration configuration;
   };
 }
-
@@ -26,38 +26,104 @@
 
 #pragma once
 
+#include <array>
+
 #include <hydra/utilities/shader_gen/block.hpp>
 #include <hydra/utilities/shader_gen/descriptor_sets.hpp>
 
 namespace neam::hydra::shader_structs
 {
-  struct mesh_indirection_t : hydra::shaders::block_struct<mesh_indirection_t>
+  static constexpr uint32_t k_max_mesh_lod_count = 16;
+
+  /// \brief Location of the data of a LOD in the mesh arena
+  /// \note offsets are in uint (4 bytes) units
+  struct mesh_lod_t : hydra::shaders::block_struct<mesh_lod_t>
+  {
+    shaders::uint32_t meshlet_count;
+    shaders::uint32_t vertex_data_offset;
+    shaders::uint32_t vertex_indirection_offset;
+    shaders::uint32_t meshlet_index_offset;
+    shaders::uint32_t meshlet_data_offset;
+    shaders::uint32_t meshlet_culling_data_offset;
+
+    static constexpr neam::ct::string glsl_type_name = "mesh_lod_t";
+  };
+
+  struct mesh_entry_t : hydra::shaders::block_struct<mesh_entry_t>
+  {
+    shaders::vec4 bounding_sphere;
+    shaders::uint32_t lod_count;
+    // LODs are always resident from the coarsest one (lods[0]) to lods[resident_lod_count - 1]
+    shaders::uint32_t resident_lod_count;
+    std::array<mesh_lod_t, k_max_mesh_lod_count> lods;
+
+    static constexpr neam::ct::string glsl_type_name = "mesh_entry_t";
+  };
+
+  struct mesh_table_t : hydra::shaders::block_struct<mesh_table_t>
   {
     shaders::uint32_t mesh_count;
-    shaders::unbound_array<uint32_t> indirection;
+    shaders::unbound_array<mesh_entry_t> meshes;
 
-    static constexpr neam::ct::string glsl_type_name = "mesh_indirection_t";
+    static constexpr neam::ct::string glsl_type_name = "mesh_table_t";
+  };
+
+  struct mesh_arena_t : hydra::shaders::block_struct<mesh_arena_t>
+  {
+    shaders::unbound_array<uint32_t> data;
+
+    static constexpr neam::ct::string glsl_type_name = "mesh_arena_t";
   };
 
   struct mesh_manager_descriptor_set_t : hydra::shaders::descriptor_set_struct<mesh_manager_descriptor_set_t>
   {
-    // remaining entries goes after the vectors
-    shaders::buffer<mesh_indirection_t, shaders::readonly> mesh_manager_indirection;
+    shaders::buffer<mesh_table_t, shaders::readonly> mesh_manager_meshes;
+    shaders::buffer<mesh_arena_t, shaders::readonly> mesh_manager_arena;
   };
 }
 
-N_METADATA_STRUCT(neam::hydra::shader_structs::mesh_indirection_t)
+N_METADATA_STRUCT(neam::hydra::shader_structs::mesh_lod_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(meshlet_count),
+    N_MEMBER_DEF(vertex_data_offset),
+    N_MEMBER_DEF(vertex_indirection_offset),
+    N_MEMBER_DEF(meshlet_index_offset),
+    N_MEMBER_DEF(meshlet_data_offset),
+    N_MEMBER_DEF(meshlet_culling_data_offset)
+  >;
+};
+N_METADATA_STRUCT(neam::hydra::shader_structs::mesh_entry_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(bounding_sphere),
+    N_MEMBER_DEF(lod_count),
+    N_MEMBER_DEF(resident_lod_count),
+    N_MEMBER_DEF(lods)
+  >;
+};
+N_METADATA_STRUCT(neam::hydra::shader_structs::mesh_table_t)
 {
   using member_list = neam::ct::type_list
   <
     N_MEMBER_DEF(mesh_count),
-    N_MEMBER_DEF(indirection)
+    N_MEMBER_DEF(meshes)
+  >;
+};
+N_METADATA_STRUCT(neam::hydra::shader_structs::mesh_arena_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(data)
   >;
 };
 N_METADATA_STRUCT(neam::hydra::shader_structs::mesh_manager_descriptor_set_t)
 {
   using member_list = neam::ct::type_list
   <
-    N_MEMBER_DEF(mesh_manager_indirection)
+    N_MEMBER_DEF(mesh_manager_meshes),
+    N_MEMBER_DEF(mesh_manager_arena)
   >;
 };
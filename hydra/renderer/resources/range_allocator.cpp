@@ -0,0 +1,110 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "range_allocator.hpp"
+
+#include <mutex>
+
+#include <hydra/hydra_debug.hpp>
+
+namespace neam::hydra::utilities
+{
+  static uint64_t align_up(uint64_t value, uint64_t alignment)
+  {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  void range_allocator::reset(uint64_t size)
+  {
+    std::lock_guard _l(lock);
+    free_ranges.clear();
+    if (size > 0)
+      free_ranges.emplace(0, size);
+    total_size = size;
+    used_size = 0;
+  }
+
+  uint64_t range_allocator::allocate(uint64_t size, uint64_t alignment)
+  {
+    if (size == 0)
+      return k_invalid_offset;
+    size = align_up(size, alignment);
+
+    std::lock_guard _l(lock);
+    for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it)
+    {
+      const uint64_t offset = align_up(it->first, alignment);
+      const uint64_t padding = offset - it->first;
+      if (it->second < size + padding)
+        continue;
+
+      const uint64_t range_offset = it->first;
+      const uint64_t range_size = it->second;
+      free_ranges.erase(it);
+
+      // put back what remains before/after the allocation:
+      if (padding > 0)
+        free_ranges.emplace(range_offset, padding);
+      if (range_size > size + padding)
+        free_ranges.emplace(offset + size, range_size - size - padding);
+
+      used_size += size;
+      return offset;
+    }
+    return k_invalid_offset;
+  }
+
+  void range_allocator::free(uint64_t offset, uint64_t size, uint64_t alignment)
+  {
+    if (offset == k_invalid_offset || size == 0)
+      return;
+    size = align_up(size, alignment);
+
+    std::lock_guard _l(lock);
+    check::debug::n_assert(offset + size <= total_size, "range_allocator::free: range [{}, {}) is outside the allocator", offset, offset + size);
+    used_size -= size;
+
+    // coalesce with the next range:
+    auto next = free_ranges.lower_bound(offset);
+    if (next != free_ranges.end() && next->first == offset + size)
+    {
+      size += next->second;
+      next = free_ranges.erase(next);
+    }
+    // coalesce with the previous range:
+    if (next != free_ranges.begin())
+    {
+      auto prev = std::prev(next);
+      check::debug::n_assert(prev->first + prev->second <= offset, "range_allocator::free: double free of range [{}, {})", offset, offset + size);
+      if (prev->first + prev->second == offset)
+      {
+        prev->second += size;
+        return;
+      }
+    }
+    free_ranges.emplace_hint(next, offset, size);
+  }
+}
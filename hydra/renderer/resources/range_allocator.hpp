@@ -0,0 +1,66 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+#include <ntools/spinlock.hpp>
+
+namespace neam::hydra::utilities
+{
+  /// \brief First-fit allocator of ranges in a fixed-size area (typically a gpu buffer)
+  /// Only manages offsets, the memory is owned by the user.
+  /// \note Freed ranges are coalesced with their neighbors
+  /// \note thread-safe
+  class range_allocator
+  {
+    public:
+      static constexpr uint64_t k_invalid_offset = ~uint64_t(0);
+
+      /// \brief Reset the allocator, making the whole [0, size) range free
+      void reset(uint64_t size);
+
+      /// \brief Allocate a range. Return k_invalid_offset if there isn't enough contiguous space.
+      /// \note alignment must be a power of two
+      [[nodiscard]] uint64_t allocate(uint64_t size, uint64_t alignment = 16);
+
+      /// \brief Free a range, previously returned by allocate
+      void free(uint64_t offset, uint64_t size, uint64_t alignment = 16);
+
+      uint64_t get_total_size() const { return total_size; }
+      uint64_t get_used_size() const { return used_size; }
+
+    private:
+      mutable spinlock lock;
+      // offset -> size
+      std::map<uint64_t, uint64_t> free_ranges;
+
+      uint64_t total_size = 0;
+      uint64_t used_size = 0;
+  };
+}
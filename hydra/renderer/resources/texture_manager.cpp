@@ -48,25 +48,94 @@
 //
 // The main problematic point is ot destroying a resource that has operations in-flight or soon-to-be-in-flight.
 //
-// TODO: sparse textures.
-// With sparse textures, only the mip-chain is/are allocated, and mips in the mip-chain that are
-// immediately accessible (in cache or in the index) are automatically streamed-in
-// (as the operation become simply a gpu upload with no IO interraction)
-// Mip-chains don't count toward the memory pool budget.
+// Sparse textures:
+// When supported (and enabled in the configuration), textures are created as sparse-resident images.
+// Only the mip-tail is bound on creation, and the memory for the other mips is allocated and bound when they are streamed-in.
+// Bind/unbind operations are queued and submitted on spqueue at the start of the frame, before the transfers that use them.
+// When the pool goes above its budget (after the unused textures have been evicted), mips that are finer than the requested
+// mip level are released (the view is shrunk, the memory is unbound then freed) without recreating the image.
+// Mips are only released when no streaming is in progress for the texture.
 //
-// When a not-already loaded mip is requested, it first look to see if we can allocate it without going above the pool limit (and if the mip itself can fit in a empty pool, if not, it fails).
-// If we can't, it first tries to unload mip levels from unused textures until there's enough space to fit the requested mip (and all previous mips),
-// then, if there's still not enough space, unload mips from referenced resources whose mip are not used.
-// If there's still not enough space and the pool is set to have a fixed size, the mip fails to be loaded.
+// When sparse residency is not available, the full mip-chain is allocated on creation, and only full eviction is possible.
 //
 
 
 
 namespace neam::hydra
 {
+  /// \brief Size (in bytes) of a 4x4 block for block-compressed formats, 0 for other formats
+  static uint32_t get_block_size(VkFormat format)
+  {
+    switch (format)
+    {
+      case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+      case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+      case VK_FORMAT_BC4_UNORM_BLOCK: case VK_FORMAT_BC4_SNORM_BLOCK:
+        return 8;
+      case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK:
+      case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+      case VK_FORMAT_BC5_UNORM_BLOCK: case VK_FORMAT_BC5_SNORM_BLOCK:
+      case VK_FORMAT_BC6H_UFLOAT_BLOCK: case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+      case VK_FORMAT_BC7_UNORM_BLOCK: case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+      default:
+        return 0;
+    }
+  }
+
+  /// \brief Size (in bytes) of the data of a mip. Non block-compressed formats are estimated at 4 bytes per texel.
+  static uint64_t get_mip_data_size(VkFormat format, glm::uvec3 extent)
+  {
+    const uint32_t block_size = get_block_size(format);
+    if (block_size == 0)
+      return (uint64_t)extent.x * extent.y * extent.z * 4;
+    const glm::uvec3 block_count = glm::uvec3((extent.x + 3) / 4, (extent.y + 3) / 4, extent.z);
+    return (uint64_t)block_count.x * block_count.y * block_count.z * block_size;
+  }
+
+  static uint32_t get_resident_base_mip(uint64_t loaded_mip_mask, uint32_t mip_count)
+  {
+    // the resident mips are the continuous mip chain that ends at the last mip
+    uint32_t base_mip = mip_count;
+    while (base_mip > 0 && (loaded_mip_mask & (uint64_t(1) << (base_mip - 1))) != 0)
+      --base_mip;
+    return base_mip;
+  }
+
+  static glm::uvec3 get_mip_extent(glm::uvec3 size, uint32_t mip_level)
+  {
+    return glm::max(glm::uvec3(1, 1, 1), size >> mip_level);
+  }
+
   void texture_manager::image_gpu_data::immediate_resource_release()
   {
-    if (image)
+    if (owner)
+      owner->release_in_flight_bytes(*this, ~0ull);
+
+    if (image && sparse)
+    {
+      uint64_t size = 0;
+      {
+        std::lock_guard _sl { sparse_lock };
+        if (mip_tail_allocation.is_valid())
+        {
+          size += mip_tail_allocation.size();
+          mip_tail_allocation.free();
+        }
+        for (auto& it : mip_allocations)
+        {
+          if (!it.is_valid())
+            continue;
+          size += it.size();
+          it.free();
+        }
+      }
+      if (owner)
+      {
+        owner->total_memory.fetch_sub(size, std::memory_order_release);
+      }
+    }
+    else if (image)
     {
       const uint64_t size = image->allocation.size();
       image->allocation.free();
@@ -122,6 +191,7 @@ namespace neam::hydra
       // NOTE: we cannot simply destroy the image and everything as there might be operations queued but not yet submit
       entry.gpu_data->evicted = true;
       entry.gpu_data->upload_chain.cancel();
+      release_in_flight_bytes(*entry.gpu_data, ~0ull);
       txctx.remove_operations_for(entry.gpu_data->image->image);
       image_data_txctx.remove_operations_for(entry.gpu_data->image->image);
 
@@ -260,6 +330,15 @@ namespace neam::hydra
           cr::out().warn("texture_manager: loaded texture data for `{}`, but texture has no mip level.", rid);
           return;
         }
+        {
+          VkFormatProperties format_properties;
+          vkGetPhysicalDeviceFormatProperties(hctx.device.get_physical_device()._get_vk_physical_device(), img_res.format, &format_properties);
+          if ((format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+          {
+            cr::out().error("texture_manager: texture `{}` uses format {}, which cannot be sampled on this device. Skipping texture.", rid, (uint32_t)img_res.format);
+            return;
+          }
+        }
         if (entry.invalid_resource == false)
         {
           cr::out().error("texture_manager: load_texture_data_unlocked for `{}`: data was already loaded, overwriting it, but this might do bad things", rid);
@@ -281,8 +360,9 @@ namespace neam::hydra
           entry.gpu_data->sampler.emplace(vk::sampler{hctx.device, VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_SAMPLER_MIPMAP_MODE_LINEAR, 0, -1000, 1000});
           entry.gpu_data->sampler->_set_debug_name(fmt::format("texture-asset:sampler[{}]", rid));
 
-          // Create the image (FIXME: create a sparse resource)
+          // Create the image (sparse if possible, with the full mip-chain allocated if not)
           glm::uvec2 size = glm::max(glm::uvec2(1, 1), entry.image_information.size.xy());
+          if (!can_use_sparse_residency(entry.image_information.format) || !create_sparse_image_unlocked(entry, size, rid))
           {
             vk::image image = vk::image::create_image_arg
             (
@@ -318,6 +398,8 @@ namespace neam::hydra
           entry.gpu_data->loaded_mip_mask.store(0, std::memory_order_release);
 
           txctx.acquire_custom_layout_transition(entry.gpu_data->image->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+          entry.gpu_data->general_layout_mip_begin = 0;
+          entry.gpu_data->general_layout_mip_end = (uint32_t)entry.image_information.mips.size();
 
           entry.invalid_resource = false; // we are now a valid resource, just with no data
         }
@@ -339,7 +421,7 @@ namespace neam::hydra
           {
             const uint8_t actual_mip_to_load = entry.requested_mip_level;
             entry.requested_mip_level = entry.min_immediate_mip_level;
-            load_mip_data_unlocked(entry, tid); // guaranteed to be immediate
+            load_mip_data_unlocked(entry, tid, entry.min_immediate_mip_level, 0); // guaranteed to be immediate
             entry.requested_mip_level = actual_mip_to_load;
             cr::out().debug("texture_manager: finished seting-up texture `{}` (loaded mip {} which is the highest immediate mip)", rid, entry.min_immediate_mip_level);
           }
@@ -348,7 +430,111 @@ namespace neam::hydra
     });
   }
 
-  void texture_manager::load_mip_data_unlocked(texture_entry& entry, texture_index_t tid)
+  bool texture_manager::is_entry_still_valid(texture_index_t tid, string_id rid) const
+  {
+    std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+    if (res.entries.size() <= tid)
+      return false;
+    const auto& entry = res.entries[tid];
+    std::lock_guard _gl { spinlock_shared_adapter::adapt(entry.lock) };
+    return entry.asset_rid == rid;
+  }
+
+  async::continuation_chain texture_manager::upload_mip(image_gpu_data& gpu_data, uint32_t mip_level, glm::uvec3 mip_size, transfer_context::staging_memory&& texels)
+  {
+    // for small transfers, we use immediate transfers + the "fast tx queue".
+    // this usually means that lower mip-levels have priority and will be availlable immediately
+    // TODO: Add a condition to avoid spamming the immediate transfer stuff
+    if (texels.size() < 128)
+    {
+      txctx.transfer(gpu_data.image->image, std::move(texels), mip_size, {0, 0, 0}, vk::image_subresource_layers{VK_IMAGE_ASPECT_COLOR_BIT, mip_level}, VK_IMAGE_LAYOUT_GENERAL);
+      return async::continuation_chain::create_and_complete();
+    }
+    // for anything bigger, we use an async transfer. This means higher latency for completion (we wait for slow_tqueue to be done)
+    // but we don't lock anything related to the current frame.
+    return image_data_txctx.async_transfer(gpu_data.image->image, std::move(texels), mip_size, {0, 0, 0}, vk::image_subresource_layers{VK_IMAGE_ASPECT_COLOR_BIT, mip_level}, VK_IMAGE_LAYOUT_GENERAL);
+  }
+
+  async::continuation_chain texture_manager::stream_mip_unlocked(const texture_entry& entry, texture_index_t tid, string_id rid, uint32_t mip_level, const dfe_refcount_pooled_ptr<image_gpu_data>& gpu_data)
+  {
+    const VkFormat format = entry.image_information.format;
+    const id_t mip_rid = entry.image_information.mips[mip_level];
+
+    if (!entry.image_information.raw_mips)
+    {
+      // legacy format: the texels are in an image_mip, which has to be decoded before being copied to staging memory
+      return hctx.res.read_resource<assets::image_mip>(mip_rid)
+      .then([mip_level, rid, tid, this, format, gpu_data = gpu_data.duplicate()](assets::image_mip&& mip, resources::status st)
+      {
+        TRACY_SCOPED_ZONE_COLOR(0x8FFF00);
+        // prevent some of the work if there's an early eviction
+        if (gpu_data->evicted || async::is_current_chain_canceled())
+          return async::continuation_chain::create_and_complete();
+
+        // one error cause can be cancellation/eviction. So before reporting the error, we make sure the chain/gpu-data are still valid
+        if (st != resources::status::success)
+        {
+          cr::out().error("texture_manager: failed to load mip level {} for texture `{}`. Marking the texture as invalid.", mip_level, rid);
+          return async::continuation_chain::create_and_complete();
+        }
+
+        if (!is_entry_still_valid(tid, rid))
+          return async::continuation_chain::create_and_complete();
+
+        const glm::uvec3 mip_size = glm::max(glm::uvec3(1, 1, 1), mip.size);
+        // block-compressed data cannot be partially uploaded, make sure we have the exact amount of data
+        if (mip.texels.size == 0 || (get_block_size(format) != 0 && mip.texels.size != get_mip_data_size(format, mip_size)))
+        {
+          cr::out().error("texture_manager: mip level {} for texture `{}` has {} bytes of data, expected {} bytes. Skipping mip.",
+                          mip_level, rid, mip.texels.size, get_mip_data_size(format, mip_size));
+          return async::continuation_chain::create_and_complete();
+        }
+
+        transfer_context::staging_memory texels = image_data_txctx.allocate_staging(mip.texels.size);
+        memcpy(texels.data().data(), mip.texels.data.get(), mip.texels.size);
+        return upload_mip(*gpu_data, mip_level, mip.size, std::move(texels));
+      });
+    }
+
+    // raw mips: the resource is read (and uncompressed) straight into staging memory
+    const glm::uvec3 mip_size = get_mip_extent(entry.image_information.size, mip_level);
+    // block-compressed data cannot be partially uploaded, make sure we have the exact amount of data
+    const uint64_t expected_size = get_block_size(format) != 0 ? get_mip_data_size(format, mip_size) : 0;
+
+    // NOTE: the staging memory is allocated by the read (from the compressor task), but owned by the chain
+    auto texels = std::make_unique<transfer_context::staging_memory>();
+    return hctx.res.read_raw_resource_into(mip_rid, [this, mip_level, rid, expected_size, texels = texels.get()](size_t size) -> std::span<uint8_t>
+    {
+      if (size == 0 || (expected_size != 0 && size != expected_size))
+      {
+        cr::out().error("texture_manager: mip level {} for texture `{}` has {} bytes of data, expected {} bytes. Skipping mip.",
+                        mip_level, rid, size, expected_size);
+        return {};
+      }
+      *texels = image_data_txctx.allocate_staging(size);
+      return texels->data();
+    })
+    .then([mip_level, mip_size, rid, tid, this, texels = std::move(texels), gpu_data = gpu_data.duplicate()](resources::status st)
+    {
+      TRACY_SCOPED_ZONE_COLOR(0x8FFF00);
+      // prevent some of the work if there's an early eviction
+      if (gpu_data->evicted || async::is_current_chain_canceled())
+        return async::continuation_chain::create_and_complete();
+
+      if (st != resources::status::success || !texels->is_valid())
+      {
+        cr::out().error("texture_manager: failed to load mip level {} for texture `{}`. Marking the texture as invalid.", mip_level, rid);
+        return async::continuation_chain::create_and_complete();
+      }
+
+      if (!is_entry_still_valid(tid, rid))
+        return async::continuation_chain::create_and_complete();
+
+      return upload_mip(*gpu_data, mip_level, mip_size, std::move(*texels));
+    });
+  }
+
+  void texture_manager::load_mip_data_unlocked(texture_entry& entry, texture_index_t tid, uint32_t target_mip_level, uint64_t estimated_bytes)
   {
     TRACY_SCOPED_ZONE_COLOR(0x7FFF00);
 
@@ -356,6 +542,7 @@ namespace neam::hydra
 
     uint8_t mip_to_stream;
     uint8_t previous_streamed_mip_level;
+    uint32_t total_mip_count;
     string_id rid;
 
     {
@@ -366,10 +553,13 @@ namespace neam::hydra
       // skip the resource if no mip level have been requested or the requested mip is already loaded
       if (entry.requested_mip_level == k_invalid_mip || entry.requested_mip_level >= entry.streamed_mip_level)
         return;
+      if (target_mip_level >= entry.streamed_mip_level)
+        return;
       gpu_data = entry.gpu_data.duplicate();
 
-      const uint8_t max_mip_level = (uint8_t)entry.image_information.mips.size() - 1;
-      mip_to_stream = std::min(max_mip_level, entry.requested_mip_level);
+      total_mip_count = (uint32_t)entry.image_information.mips.size();
+      const uint8_t max_mip_level = (uint8_t)total_mip_count - 1;
+      mip_to_stream = (uint8_t)std::min<uint32_t>(max_mip_level, target_mip_level);
 
       previous_streamed_mip_level = std::min<uint8_t>(max_mip_level + 1, entry.streamed_mip_level);
       entry.streamed_mip_level = mip_to_stream; // assign now to prevent streaming data in-loop
@@ -383,56 +573,63 @@ namespace neam::hydra
     // mip to streams, from previous_streamed_mip_level to mip_to_stream
     const uint32_t mip_count = previous_streamed_mip_level - mip_to_stream;
 
+    // sparse images: the memory for the mips we are about to stream has to be bound first
+    if (gpu_data->sparse)
+    {
+      allocate_sparse_mips(gpu_data, mip_to_stream, previous_streamed_mip_level);
+      memory_budget_fit();
+    }
+
+    // transition the mips we are about to stream that a previous streaming pass has transitioned for shaders back for the copies.
+    // only those mips are transitioned, as shaders might be reading the already loaded ones.
+    {
+      std::lock_guard _vl { spinlock_exclusive_adapter::adapt(gpu_data->view_lock) };
+      uint32_t& general_begin = gpu_data->general_layout_mip_begin;
+      uint32_t& general_end = gpu_data->general_layout_mip_end;
+      const auto acquire_mips = [&](uint32_t begin, uint32_t end)
+      {
+        if (begin >= end)
+          return;
+        txctx.acquire_custom_layout_transition(gpu_data->image->image,
+                                               vk::image_subresource_range{VK_IMAGE_ASPECT_COLOR_BIT, glm::uvec2{begin, end - begin}},
+                                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+      };
+      if (general_begin == general_end)
+      {
+        acquire_mips(mip_to_stream, previous_streamed_mip_level);
+        general_begin = mip_to_stream;
+        general_end = previous_streamed_mip_level;
+      }
+      else
+      {
+        // passes stream contiguous mip ranges, so the GENERAL range stays contiguous
+        check::debug::n_assert(mip_to_stream <= general_end && previous_streamed_mip_level >= general_begin,
+                               "texture_manager: non-contiguous mip range to stream: [{}, {}) (mips [{}, {}) are already being streamed)",
+                               mip_to_stream, previous_streamed_mip_level, general_begin, general_end);
+        acquire_mips(mip_to_stream, std::min<uint32_t>(previous_streamed_mip_level, general_begin));
+        acquire_mips(std::max<uint32_t>(mip_to_stream, general_end), previous_streamed_mip_level);
+        general_begin = std::min<uint32_t>(general_begin, mip_to_stream);
+        general_end = std::max<uint32_t>(general_end, previous_streamed_mip_level);
+      }
+    }
+
     // update the changed flag:
     has_changed.store(true, std::memory_order_release);
 
+    gpu_data->in_flight_bytes.fetch_add(estimated_bytes, std::memory_order_acq_rel);
+    bytes_in_flight.fetch_add(estimated_bytes, std::memory_order_acq_rel);
+
     std::vector<async::continuation_chain> chains;
     chains.reserve(mip_count);
     for (uint32_t i = 0; i < mip_count; ++i)
     {
+      const uint32_t mip_level = mip_to_stream + i;
       chains.push_back
       (
-        // stream the mip:
-        hctx.res.read_resource<assets::image_mip>(entry.image_information.mips[mip_to_stream + i])
-        // copy it to gpu
-        .then([i, rid, mip_to_stream, tid, this, gpu_data = gpu_data.duplicate()](assets::image_mip&& mip, resources::status st)
-        {
-          TRACY_SCOPED_ZONE_COLOR(0x8FFF00);
-          // prevent some of the work if there's an early eviction
-          if (gpu_data->evicted || async::is_current_chain_canceled())
-            return async::continuation_chain::create_and_complete();
-
-          // one error cause can be cancellation/eviction. So before reporting the error, we make sure the chain/gpu-data are still valid
-          if (st != resources::status::success)
-          {
-            cr::out().error("texture_manager: failed to load mip level {} for texture `{}`. Marking the texture as invalid.", mip_to_stream + i, rid);
-            return async::continuation_chain::create_and_complete();
-          }
-
-          {
-            std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
-            if (res.entries.size() <= tid)
-              return async::continuation_chain::create_and_complete();
-            auto& entry = res.entries[tid];
-            std::lock_guard _gl { spinlock_shared_adapter::adapt(entry.lock) };
-            if (entry.asset_rid != rid)
-              return async::continuation_chain::create_and_complete();
-          }
-
-          // for small transfers, we use immediate transfers + the "fast tx queue".
-          // this usually means that lower mip-levels have priority and will be availlable immediately
-          // TODO: Add a condition to avoid spamming the immediate transfer stuff
-          if (mip.texels.size < 128)
-          {
-            txctx.transfer(gpu_data->image->image, std::move(mip.texels), mip.size, vk::image_subresource_layers{VK_IMAGE_ASPECT_COLOR_BIT, i}, VK_IMAGE_LAYOUT_GENERAL);
-            return async::continuation_chain::create_and_complete();
-          }
-          // for anything bigger, we use an async transfer. This means higher latency for completion (we wait for slow_tqueue to be done)
-          // but we don't lock anything related to the current frame.
-          return image_data_txctx.async_transfer(gpu_data->image->image, std::move(mip.texels), mip.size, vk::image_subresource_layers{VK_IMAGE_ASPECT_COLOR_BIT, i}, VK_IMAGE_LAYOUT_GENERAL);
-        })
+        // stream the mip and copy it to gpu:
+        stream_mip_unlocked(entry, tid, rid, mip_level, gpu_data)
         // update the CPU data to reflect that the mip has been copied to gpu:
-        .then([i, rid, mip_to_stream, tid, this, mip_count, gpu_data = gpu_data.duplicate()]()
+        .then([mip_level, rid, tid, this, total_mip_count, gpu_data = gpu_data.duplicate()]()
         {
           TRACY_SCOPED_ZONE_COLOR(0x9FFF00);
 
@@ -451,21 +648,20 @@ namespace neam::hydra
                 return;
             }
           }
-          const uint32_t bit_index = (mip_count - (mip_to_stream + i) - 1);
-          uint64_t loaded_mips = gpu_data->loaded_mip_mask.fetch_or(uint64_t(1) << bit_index, std::memory_order_acq_rel) | (uint64_t(1) << bit_index);
+          uint64_t loaded_mips = gpu_data->loaded_mip_mask.fetch_or(uint64_t(1) << mip_level, std::memory_order_acq_rel) | (uint64_t(1) << mip_level);
 
-          const uint32_t ffs = __builtin_ffsl(~loaded_mips) - 1;
-          // cr::out().debug("texture-manager: loaded mip level {} of `{}` (ffs: {} | {:X}, {})", mip_to_stream + i, rid, ffs, loaded_mips, mip_count);
+          const uint32_t base_mip = get_resident_base_mip(loaded_mips, total_mip_count);
+          // cr::out().debug("texture-manager: loaded mip level {} of `{}` (base: {} | {:X}, {})", mip_level, rid, base_mip, loaded_mips, total_mip_count);
 
-          // we have a new mip, and our mip generated a continuous mip chain
-          if ((ffs > 0) && (ffs >= mip_to_stream))
+          // we have a new mip, and our mip extended the continuous mip chain
+          if (base_mip <= mip_level)
           {
             std::lock_guard _gl { spinlock_exclusive_adapter::adapt(gpu_data->view_lock) };
 
             loaded_mips = gpu_data->loaded_mip_mask.load(std::memory_order_acquire);
-            const uint32_t new_ffs = __builtin_ffsl(~loaded_mips) - 1;
+            const uint32_t new_base_mip = get_resident_base_mip(loaded_mips, total_mip_count);
             // check that no-one pre-empted us:
-            if (new_ffs == ffs && !gpu_data->evicted)
+            if (new_base_mip == base_mip && !gpu_data->evicted)
             {
               // cr::out().debug("texture-manager: `{}`: created new gpu-data ({} mips)", rid, loaded_mips);
 
@@ -476,10 +672,10 @@ namespace neam::hydra
                 hctx.device, gpu_data->image->image, VK_IMAGE_VIEW_TYPE_MAX_ENUM, VK_FORMAT_MAX_ENUM, vk::rgba_swizzle(),
                 vk::image_subresource_range
                 {
-                  VK_IMAGE_ASPECT_COLOR_BIT, glm::uvec2{mip_count - ffs, ffs}
+                  VK_IMAGE_ASPECT_COLOR_BIT, glm::uvec2{base_mip, total_mip_count - base_mip}
                 }
               );
-              gpu_data->image->view._set_debug_name(fmt::format("texture-asset:view[{}]<{}, {}>", rid, (float)(mip_count - ffs), (float)mip_count));
+              gpu_data->image->view._set_debug_name(fmt::format("texture-asset:view[{}]<{}, {}>", rid, base_mip, total_mip_count));
 
               // we have some valid data:
               gpu_data->valid = true;
@@ -493,15 +689,17 @@ namespace neam::hydra
     }
 
     gpu_data->upload_chain = async::multi_chain(std::move(chains))
-    .then([rid, mip_to_stream, tid, this, mip_count, gpu_data = gpu_data.duplicate()]
+    .then([rid, mip_to_stream, tid, this, estimated_bytes, gpu_data = gpu_data.duplicate()]
     {
       TRACY_SCOPED_ZONE_COLOR(0xAFFF00);
 
+      release_in_flight_bytes(*gpu_data, estimated_bytes);
+
       // prevent some of the work if there's an early eviction
       if (gpu_data->evicted || async::is_current_chain_canceled())
         return;
 
-      uint8_t last_streamed_mip_level;
+      bool is_last_pass = false;
       {
         std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
         if (res.entries.size() <= tid)
@@ -510,14 +708,27 @@ namespace neam::hydra
         std::lock_guard _gl { spinlock_shared_adapter::adapt(entry.lock) };
         if (entry.asset_rid != rid)
           return;
-        last_streamed_mip_level = entry.streamed_mip_level;
+
+        // NOTE: view_lock makes the check + transition atomic with the transition back in load_mip_data_unlocked
+        std::lock_guard _vl { spinlock_exclusive_adapter::adapt(gpu_data->view_lock) };
+        if (entry.streamed_mip_level == mip_to_stream)
+        {
+          // transition every mip that has been transitioned for the copies (which can span multiple passes) back for the shaders
+          const uint32_t general_begin = std::exchange(gpu_data->general_layout_mip_begin, 0);
+          const uint32_t general_end = std::exchange(gpu_data->general_layout_mip_end, 0);
+          if (general_begin < general_end)
+          {
+            txctx.release_custom_layout_transition(gpu_data->image->image,
+                                                   vk::image_subresource_range{VK_IMAGE_ASPECT_COLOR_BIT, glm::uvec2{general_begin, general_end - general_begin}},
+                                                   VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+          }
+          is_last_pass = true;
+        }
       }
 
-      if (last_streamed_mip_level == mip_to_stream)
+      if (is_last_pass)
       {
-        txctx.release_custom_layout_transition(gpu_data->image->image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
         // cr::out().debug("texture-manager: fully loaded up-to mip level {} of `{}`", mip_to_stream, rid);
-
         gpu_data->upload_chain.reset();
       }
     });
@@ -581,10 +792,35 @@ namespace neam::hydra
       txctx.release(default_texture.image, hctx.gqueue, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
 
-    res.start_frame([this](auto& it, uint32_t i)
+    // gather the stream requests, and start them in priority order:
+    std::vector<stream_request_t> stream_requests;
+    res.start_frame([&stream_requests](auto& it, uint32_t i)
     {
-      load_mip_data_unlocked(it, i);
+      std::lock_guard _gl { spinlock_shared_adapter::adapt(it.lock) };
+      if (it.invalid_resource || !it.gpu_data || it.requested_mip_level == k_invalid_mip)
+        return;
+      const uint8_t mip_count = (uint8_t)it.image_information.mips.size();
+      const uint8_t streamed_mip_level = std::min(mip_count, it.streamed_mip_level);
+      const uint8_t requested_mip_level = std::min<uint8_t>(mip_count - 1, it.requested_mip_level);
+      if (requested_mip_level >= streamed_mip_level)
+        return;
+      stream_requests.push_back
+      ({
+        .tid = i,
+        .rid = it.asset_rid,
+        .requested_mip_level = requested_mip_level,
+        .streamed_mip_level = streamed_mip_level,
+        .last_frame_with_usage = it.last_frame_with_usage,
+      });
     });
+    {
+      streaming_stats_t stats = schedule_streaming(stream_requests);
+      stats.dropped_mips = frame_dropped_mips.exchange(0, std::memory_order_acq_rel);
+      stats.evicted_textures = frame_evicted_textures.exchange(0, std::memory_order_acq_rel);
+
+      std::lock_guard _l { stats_lock };
+      last_frame_stats = stats;
+    }
 
     // softly try to resize the resource array down:
     if (res.entries.size() > 0 && false)
@@ -675,9 +911,10 @@ namespace neam::hydra
             if (it.entry_state != utilities::resource_array_entry_state_t::free && it.gpu_data && it.gpu_data->valid && !it.invalid_resource && it.gpu_data->image)
             {
               const uint64_t loaded_mips = it.gpu_data->loaded_mip_mask.load(std::memory_order_acquire);
+              const uint32_t mip_count = (uint32_t)it.image_information.mips.size();
 
               std::lock_guard _gl { spinlock_shared_adapter::adapt(it.gpu_data->view_lock) };
-              if ((loaded_mips & 1) != 0 || !it.gpu_data->image->view.get_vk_image_view())
+              if (get_resident_base_mip(loaded_mips, mip_count) < mip_count || !it.gpu_data->image->view.get_vk_image_view())
                 gpu_state.descriptor_set.texture_manager_texture_float_1d[i] = {it.gpu_data->image->view, *it.gpu_data->sampler};
               else
                 gpu_state.descriptor_set.texture_manager_texture_float_1d[i] = {default_texture.view, default_sampler};
@@ -701,6 +938,9 @@ namespace neam::hydra
       gpu_state.descriptor_set.update_descriptor_set(hctx);
     }
 
+    // bind/unbind sparse memory (must be done before the transfers):
+    flush_sparse_operations(si);
+
     // upload data to textures:
     txctx.build(si);
     {
@@ -723,11 +963,39 @@ namespace neam::hydra
     std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
     std::lock_guard _lh(res.list_header_lock);
 
-    // TODO: per-mip memory residency to save a bit of memory
+    const auto try_drop_mips = [this](texture_entry& entry, uint32_t new_base_mip)
+    {
+      if (get_total_gpu_memory() < configuration.max_pool_memory)
+        return;
+      if (entry.entry_state == utilities::resource_array_entry_state_t::free || !entry.gpu_data || entry.invalid_resource || !entry.gpu_data->sparse)
+        return;
 
-    // iterate over the unused resources, and evict those that are old until we fit in budget
+      // NOTE: the caller might be holding the lock of an entry, so we skip the entries we cannot lock
+      if (!entry.lock.try_lock())
+        return;
+      frame_dropped_mips.fetch_add(drop_sparse_mips_unlocked(entry, new_base_mip), std::memory_order_relaxed);
+      entry.lock.unlock();
+    };
+
+    // first, release the high mips of unused sparse textures (down to the mip-tail).
+    // They can be streamed back without having to recreate the texture.
+    res.for_each_unused_entries_unlocked([&try_drop_mips](auto& entry, uint32_t /*index*/)
+    {
+      try_drop_mips(entry, k_invalid_mip);
+    });
+
+    // then, release the mips of sparse textures that are finer than the requested ones
+    for (auto& entry : res.entries)
+    {
+      if (get_total_gpu_memory() < configuration.max_pool_memory)
+        break;
+      if (entry.requested_mip_level != k_invalid_mip)
+        try_drop_mips(entry, entry.requested_mip_level);
+    }
+
+    // last resort: iterate over the unused resources, and evict those that are old until we fit in budget
     bool done = false;
-    res.for_each_unused_entries_unlocked([this, aggressive, &done](auto& entry, uint32_t index)
+    res.for_each_unused_entries_unlocked([this, &done](auto& entry, uint32_t index)
     {
       if (done || !entry.gpu_data || entry.invalid_resource)
         return;
@@ -741,14 +1009,367 @@ namespace neam::hydra
       // NOTE: we cannot simply destroy the image and everything as there might be operations queued but not yet submit
       entry.gpu_data->evicted = true;
       entry.gpu_data->upload_chain.cancel();
+      release_in_flight_bytes(*entry.gpu_data, ~0ull);
       txctx.remove_operations_for(entry.gpu_data->image->image);
       image_data_txctx.remove_operations_for(entry.gpu_data->image->image);
       entry.gpu_data.release();
+      frame_evicted_textures.fetch_add(1, std::memory_order_relaxed);
 
       // remove entry from the free list and add it to the free-list
       res.remove_entry_from_unused_list_unlocked(entry);
       res.add_entry_to_free_list_unlocked(entry, index);
     });
   }
+
+  texture_manager::streaming_stats_t texture_manager::get_streaming_stats() const
+  {
+    std::lock_guard _l { stats_lock };
+    return last_frame_stats;
+  }
+
+  texture_manager::streaming_stats_t texture_manager::schedule_streaming(std::vector<stream_request_t>& requests)
+  {
+    TRACY_SCOPED_ZONE;
+
+    // most missing mips first, then the most detailed request, then the most recently used
+    std::sort(requests.begin(), requests.end(), [](const stream_request_t& a, const stream_request_t& b)
+    {
+      const uint32_t a_distance = a.streamed_mip_level - a.requested_mip_level;
+      const uint32_t b_distance = b.streamed_mip_level - b.requested_mip_level;
+      if (a_distance != b_distance)
+        return a_distance > b_distance;
+      if (a.requested_mip_level != b.requested_mip_level)
+        return a.requested_mip_level < b.requested_mip_level;
+      return a.last_frame_with_usage > b.last_frame_with_usage;
+    });
+
+    streaming_stats_t stats;
+
+    std::lock_guard _l {spinlock_shared_adapter::adapt(res.entries_lock)};
+    for (const stream_request_t& request : requests)
+    {
+      if (request.tid >= (uint32_t)res.entries.size())
+        continue;
+      auto& entry = res.entries[request.tid];
+
+      // stream from the coarsest missing mip toward the requested one, as far as the limits allow
+      uint32_t target_mip_level = request.streamed_mip_level;
+      uint64_t pass_bytes = 0;
+      {
+        std::lock_guard _gl { spinlock_shared_adapter::adapt(entry.lock) };
+        if (entry.asset_rid != request.rid)
+          continue;
+
+        const uint64_t in_flight = bytes_in_flight.load(std::memory_order_acquire);
+        while (target_mip_level > request.requested_mip_level)
+        {
+          const uint64_t mip_bytes = estimate_mip_size_unlocked(entry, target_mip_level - 1);
+          const bool fits = stats.started_bytes + pass_bytes + mip_bytes <= configuration.max_stream_bytes_per_frame
+                            && in_flight + pass_bytes + mip_bytes <= configuration.max_in_flight_stream_bytes;
+          // a single mip can always be streamed when nothing else is, so mips bigger than the limits are not starved
+          const bool is_alone = stats.started_bytes == 0 && in_flight == 0 && pass_bytes == 0;
+          if (!fits && !is_alone)
+            break;
+          pass_bytes += mip_bytes;
+          --target_mip_level;
+        }
+      }
+
+      if (target_mip_level > request.requested_mip_level)
+        ++stats.queue_depth;
+      if (target_mip_level == request.streamed_mip_level)
+        continue;
+
+      load_mip_data_unlocked(entry, request.tid, target_mip_level, pass_bytes);
+      stats.started_mips += request.streamed_mip_level - target_mip_level;
+      stats.started_bytes += pass_bytes;
+    }
+
+    stats.bytes_in_flight = bytes_in_flight.load(std::memory_order_acquire);
+    return stats;
+  }
+
+  uint64_t texture_manager::estimate_mip_size_unlocked(const texture_entry& entry, uint32_t mip_level) const
+  {
+    const glm::uvec3 size = glm::max(glm::uvec3(1, 1, 1), entry.image_information.size);
+    uint64_t total_texels = 0;
+    uint64_t total_data_size = 0;
+    uint64_t mip_texels = 0;
+    for (uint32_t i = 0; i < (uint32_t)entry.image_information.mips.size(); ++i)
+    {
+      const glm::uvec3 extent = get_mip_extent(size, i);
+      const uint64_t texels = (uint64_t)extent.x * extent.y * extent.z;
+      total_texels += texels;
+      total_data_size += get_mip_data_size(entry.image_information.format, extent);
+      if (i == mip_level)
+        mip_texels = texels;
+    }
+    if (total_texels == 0)
+      return 0;
+
+    // use the size of the data when there's no image to get the memory cost from
+    const uint64_t image_size = (entry.gpu_data && entry.gpu_data->image) ? entry.gpu_data->image->image.get_memory_requirements().size : total_data_size;
+    return std::max<uint64_t>(1, image_size * mip_texels / total_texels);
+  }
+
+  void texture_manager::release_in_flight_bytes(image_gpu_data& gpu_data, uint64_t bytes)
+  {
+    // eviction may have already released the bytes of the texture, so we only release what's left
+    uint64_t current = gpu_data.in_flight_bytes.load(std::memory_order_acquire);
+    uint64_t released;
+    do
+    {
+      released = std::min(current, bytes);
+    }
+    while (!gpu_data.in_flight_bytes.compare_exchange_weak(current, current - released, std::memory_order_acq_rel));
+    if (released > 0)
+      bytes_in_flight.fetch_sub(released, std::memory_order_acq_rel);
+  }
+
+  bool texture_manager::can_use_sparse_residency(VkFormat format) const
+  {
+    if (!configuration.use_sparse_residency)
+      return false;
+
+    const vk::physical_device& gpu = hctx.device.get_physical_device();
+    if (!gpu.get_features().get_device_features().sparseResidencyImage2D)
+      return false;
+
+    uint32_t count = 0;
+    vkGetPhysicalDeviceSparseImageFormatProperties
+    (
+      gpu._get_vk_physical_device(), format, VK_IMAGE_TYPE_2D, VK_SAMPLE_COUNT_1_BIT,
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_TILING_OPTIMAL,
+      &count, nullptr
+    );
+    return count > 0;
+  }
+
+  bool texture_manager::create_sparse_image_unlocked(texture_entry& entry, glm::uvec2 size, string_id rid)
+  {
+    const uint32_t mip_count = (uint32_t)entry.image_information.mips.size();
+    vk::image image = vk::image::create_image_arg
+    (
+      hctx.device,
+      vk::image_2d
+      (
+        size, entry.image_information.format, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        mip_count, VK_IMAGE_LAYOUT_UNDEFINED
+      ),
+      vk::image_concurrent
+      {{
+        hctx.gqueue, hctx.cqueue, hctx.tqueue,
+      }},
+      vk::image_sparse{}
+    );
+
+    // We only handle the color aspect. Formats that require metadata use the non-sparse path.
+    const VkSparseImageMemoryRequirements* color_reqs = nullptr;
+    for (const auto& it : image.get_sparse_memory_requirements())
+    {
+      if ((it.formatProperties.aspectMask & VK_IMAGE_ASPECT_METADATA_BIT) != 0)
+        return false;
+      if ((it.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0)
+        color_reqs = &it;
+    }
+    if (color_reqs == nullptr)
+    {
+      cr::out().warn("texture_manager: `{}`: no sparse memory requirements for the color aspect, using a non-sparse image", rid);
+      return false;
+    }
+
+    image_gpu_data& gpu_data = *entry.gpu_data;
+    gpu_data.sparse = true;
+    gpu_data.sparse_granularity = { color_reqs->formatProperties.imageGranularity.width, color_reqs->formatProperties.imageGranularity.height, color_reqs->formatProperties.imageGranularity.depth };
+    gpu_data.mip_tail_first_lod = std::min(color_reqs->imageMipTailFirstLod, mip_count);
+    gpu_data.mip_tail_offset = color_reqs->imageMipTailOffset;
+    gpu_data.mip_allocations.resize(gpu_data.mip_tail_first_lod);
+
+    // the mip-tail is always resident:
+    const bool has_mip_tail = gpu_data.mip_tail_first_lod < mip_count && color_reqs->imageMipTailSize > 0;
+    if (has_mip_tail)
+    {
+      VkMemoryRequirements reqs = image.get_memory_requirements();
+      reqs.size = color_reqs->imageMipTailSize;
+
+      // prevent a spike, check if the min requirements can fit in the budget
+      total_memory.fetch_add(reqs.size, std::memory_order_release);
+      memory_budget_fit();
+
+      gpu_data.mip_tail_allocation = hctx.allocator.allocate_memory(reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocation_type::persistent_optimal_image);
+      total_memory.fetch_add(gpu_data.mip_tail_allocation.size() - reqs.size, std::memory_order_release);
+    }
+
+    gpu_data.image.emplace(image_holder{hctx.device, std::move(image)});
+
+    if (has_mip_tail)
+    {
+      std::lock_guard _l { pending_sparse_ops_lock };
+      pending_sparse_ops.push_back({ .gpu_data = entry.gpu_data.duplicate(), .mip_level = k_mip_tail });
+    }
+    return true;
+  }
+
+  void texture_manager::allocate_sparse_mips(const dfe_refcount_pooled_ptr<image_gpu_data>& gpu_data, uint32_t first_mip, uint32_t end_mip)
+  {
+    TRACY_SCOPED_ZONE;
+    end_mip = std::min(end_mip, gpu_data->mip_tail_first_lod);
+    if (first_mip >= end_mip)
+      return;
+
+    const VkMemoryRequirements& image_reqs = gpu_data->image->image.get_memory_requirements();
+    const glm::uvec3 image_size = gpu_data->image->image.get_size();
+    const glm::uvec3 granularity = gpu_data->sparse_granularity;
+
+    uint64_t allocated_size = 0;
+    uint64_t allocated_mips = 0;
+    {
+      std::lock_guard _sl { gpu_data->sparse_lock };
+      for (uint32_t mip = first_mip; mip < end_mip; ++mip)
+      {
+        if (gpu_data->mip_allocations[mip].is_valid())
+          continue;
+
+        // sparse blocks are of size alignment:
+        const glm::uvec3 block_count = (get_mip_extent(image_size, mip) + granularity - 1u) / granularity;
+        VkMemoryRequirements reqs = image_reqs;
+        reqs.size = (VkDeviceSize)block_count.x * block_count.y * block_count.z * image_reqs.alignment;
+
+        gpu_data->mip_allocations[mip] = hctx.allocator.allocate_memory(reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocation_type::persistent_optimal_image);
+        allocated_size += gpu_data->mip_allocations[mip].size();
+        allocated_mips |= uint64_t(1) << mip;
+      }
+    }
+    total_memory.fetch_add(allocated_size, std::memory_order_release);
+
+    if (allocated_mips == 0)
+      return;
+
+    std::lock_guard _l { pending_sparse_ops_lock };
+    // an unbind operation might still be pending for those mips, in which case it is now useless
+    for (uint32_t i = 0; i < (uint32_t)pending_sparse_ops.size();)
+    {
+      pending_sparse_op_t& op = pending_sparse_ops[i];
+      if (op.unbind && op.gpu_data.get() == gpu_data.get() && (allocated_mips & (uint64_t(1) << op.mip_level)) != 0)
+      {
+        hctx.dfe.defer_destruction(std::move(op.released_allocation));
+        pending_sparse_ops.erase(pending_sparse_ops.begin() + i);
+        continue;
+      }
+      ++i;
+    }
+    for (uint32_t mip = first_mip; mip < end_mip; ++mip)
+    {
+      if ((allocated_mips & (uint64_t(1) << mip)) != 0)
+        pending_sparse_ops.push_back({ .gpu_data = gpu_data.duplicate(), .mip_level = mip });
+    }
+  }
+
+  uint32_t texture_manager::drop_sparse_mips_unlocked(texture_entry& entry, uint32_t new_base_mip)
+  {
+    image_gpu_data& gpu_data = *entry.gpu_data;
+    if (!gpu_data.sparse || gpu_data.evicted || !gpu_data.image)
+      return 0;
+
+    const uint32_t mip_count = (uint32_t)entry.image_information.mips.size();
+    // mips in the mip-tail cannot be released
+    new_base_mip = std::min({ new_base_mip, gpu_data.mip_tail_first_lod, mip_count - 1 });
+
+    std::lock_guard _vl { spinlock_exclusive_adapter::adapt(gpu_data.view_lock) };
+    const uint64_t loaded_mips = gpu_data.loaded_mip_mask.load(std::memory_order_acquire);
+    const uint32_t base_mip = get_resident_base_mip(loaded_mips, mip_count);
+
+    // only release mips when there's no streaming in progress for the texture
+    if (base_mip != entry.streamed_mip_level || base_mip >= new_base_mip)
+      return 0;
+
+    const uint64_t dropped_mips = ((uint64_t(1) << new_base_mip) - 1) & ~((uint64_t(1) << base_mip) - 1);
+    gpu_data.loaded_mip_mask.fetch_and(~dropped_mips, std::memory_order_acq_rel);
+
+    // shrink the view, the memory is unbound then freed at the next frame (after the descriptor set no longer references the old view)
+    hctx.dfe.defer_destruction(std::move(gpu_data.image->view));
+    gpu_data.image->view = vk::image_view
+    (
+      hctx.device, gpu_data.image->image, VK_IMAGE_VIEW_TYPE_MAX_ENUM, VK_FORMAT_MAX_ENUM, vk::rgba_swizzle(),
+      vk::image_subresource_range
+      {
+        VK_IMAGE_ASPECT_COLOR_BIT, glm::uvec2{new_base_mip, mip_count - new_base_mip}
+      }
+    );
+    gpu_data.image->view._set_debug_name(fmt::format("texture-asset:view[{}]<{}, {}>", entry.asset_rid, new_base_mip, mip_count));
+
+    uint64_t released_size = 0;
+    {
+      std::lock_guard _l { pending_sparse_ops_lock };
+      std::lock_guard _sl { gpu_data.sparse_lock };
+      for (uint32_t mip = base_mip; mip < new_base_mip; ++mip)
+      {
+        if (!gpu_data.mip_allocations[mip].is_valid())
+          continue;
+        released_size += gpu_data.mip_allocations[mip].size();
+        pending_sparse_ops.push_back
+        ({
+          .gpu_data = entry.gpu_data.duplicate(),
+          .mip_level = mip,
+          .unbind = true,
+          .released_allocation = std::move(gpu_data.mip_allocations[mip]),
+        });
+      }
+    }
+    total_memory.fetch_sub(released_size, std::memory_order_release);
+
+    entry.streamed_mip_level = (uint8_t)new_base_mip;
+    has_changed.store(true, std::memory_order_release);
+    return new_base_mip - base_mip;
+  }
+
+  void texture_manager::flush_sparse_operations(vk::submit_info& si)
+  {
+    std::mtc_vector<pending_sparse_op_t> ops;
+    {
+      std::lock_guard _l { pending_sparse_ops_lock };
+      if (pending_sparse_ops.empty())
+        return;
+      ops.swap(pending_sparse_ops);
+    }
+
+    TRACY_SCOPED_ZONE;
+    si.sparse_bind_on(hctx.spqueue);
+    for (auto& op : ops)
+    {
+      // evicted textures don't need their memory to be bound / unbound
+      if (op.gpu_data->evicted || !op.gpu_data->image)
+        continue;
+
+      const vk::image& image = op.gpu_data->image->image;
+      std::lock_guard _sl { op.gpu_data->sparse_lock };
+      if (op.mip_level == k_mip_tail)
+      {
+        if (op.gpu_data->mip_tail_allocation.is_valid())
+          si.bind_mip_tail(image, op.gpu_data->mip_tail_allocation, op.gpu_data->mip_tail_offset);
+        continue;
+      }
+
+      const vk::image_subresource subres { VK_IMAGE_ASPECT_COLOR_BIT, op.mip_level };
+      const glm::uvec3 extent = get_mip_extent(image.get_size(), op.mip_level);
+      if (op.unbind)
+        si.unbind(image, {0, 0, 0}, extent, subres);
+      else if (op.gpu_data->mip_allocations[op.mip_level].is_valid())
+        si.bind(image, op.gpu_data->mip_allocations[op.mip_level], {0, 0, 0}, extent, subres);
+    }
+
+    // transfers to the bound memory happen on both tqueue and slow_tqueue, so both have to wait for the bind operations
+    vk::semaphore tqueue_sem { hctx.device };
+    vk::semaphore slow_tqueue_sem { hctx.device };
+    si.signal(tqueue_sem).signal(slow_tqueue_sem);
+    si.sync();
+    si.on(hctx.tqueue).wait(tqueue_sem, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    si.on(hctx.slow_tqueue).wait(slow_tqueue_sem, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    hctx.dfe.defer_destruction(std::move(tqueue_sem), std::move(slow_tqueue_sem));
+
+    // keep the gpu-data and the unbound memory alive until the operations are done:
+    hctx.dfe.defer_destruction(std::move(ops));
+  }
 }
 
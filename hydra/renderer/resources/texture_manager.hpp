@@ -31,6 +31,7 @@
 #include <ntools/event.hpp>
 #include <ntools/type_utilities.hpp>
 #include <ntools/mt_check/unordered_map.hpp>
+#include <ntools/mt_check/vector.hpp>
 
 #include <ntools/memory_pool.hpp>
 #include <ntools/refcount_ptr.hpp>
@@ -52,6 +53,9 @@ namespace neam::hydra
     uint32_t max_entries = 8192;
     uint64_t evict_no_question_asked = 7200; // FIXME: maybe time based? (number of ms?)
     uint64_t max_pool_memory = 2ull * 1024 * 1024 * 1024;
+    bool use_sparse_residency = true;
+    uint64_t max_in_flight_stream_bytes = 128ull * 1024 * 1024;
+    uint64_t max_stream_bytes_per_frame = 32ull * 1024 * 1024;
   };
 }
 
@@ -80,6 +84,25 @@ N_METADATA_STRUCT(neam::hydra::texture_manager_configuration)
       "Max GPU memory (in bytes) that the textures will use\n"
       "Note that by default the manager will not go above this limit but will try to keep close to it\n"
       "The amount is calculated from the true memory cost of allocations, not the (usually lower) actual required memory for a texture\n"
+    >}),
+    N_MEMBER_DEF(use_sparse_residency, neam::metadata::info{.description = c_string_t
+    <
+      "If supported by the device and the texture format, create textures as sparse-resident images.\n"
+      "Sparse textures only have memory bound for the mips that are streamed-in, and the mips finer than the requested ones\n"
+      "can be released when the pool goes above max_pool_memory without having to recreate the image.\n"
+      "If disabled (or not supported), the full mip-chain is allocated when the texture is created."
+    >}),
+    N_MEMBER_DEF(max_in_flight_stream_bytes, neam::metadata::info{.description = c_string_t
+    <
+      "Max amount of (estimated) mip data, in bytes, being read from disk or uploaded to the GPU at any given time.\n"
+      "A single mip can go above this limit if nothing else is being streamed (so mips bigger than the limit are not starved).\n"
+      "A low value reduces IO/transfer contention (and hitches), for the cost of a slower stream-in of textures."
+    >}),
+    N_MEMBER_DEF(max_stream_bytes_per_frame, neam::metadata::info{.description = c_string_t
+    <
+      "Max amount of (estimated) mip data, in bytes, whose streaming can be started in a single frame.\n"
+      "Streaming requests are ranked (most missing mips first, then most detailed request, then most recently used)\n"
+      "and are started in that order until this limit or max_in_flight_stream_bytes is reached."
     >})
   >;
 };
@@ -128,6 +151,20 @@ namespace neam::hydra
 
       cr::event<> on_texture_pool_cleared;
 
+      /// \brief Streaming statistics, updated at the start of each frame
+      struct streaming_stats_t
+      {
+        uint64_t bytes_in_flight = 0; // (estimated) bytes of mips being read or uploaded
+        uint32_t queue_depth = 0; // textures still waiting for mips after the scheduler ran
+        uint32_t started_mips = 0; // mips whose streaming started this frame
+        uint64_t started_bytes = 0; // (estimated) bytes of the mips whose streaming started this frame
+        uint32_t dropped_mips = 0; // mips released to fit in the memory budget
+        uint32_t evicted_textures = 0; // textures fully evicted to fit in the memory budget
+      };
+
+      /// \brief Return the streaming statistics of the last frame
+      streaming_stats_t get_streaming_stats() const;
+
       shader_structs::texture_manager_descriptor_set_t& get_descriptor_set() { return gpu_state.descriptor_set; }
       const shader_structs::texture_manager_descriptor_set_t& get_descriptor_set() const { return gpu_state.descriptor_set; }
 
@@ -148,6 +185,7 @@ namespace neam::hydra
     private:
       static constexpr uint32_t k_invalid_index = ~0u;
       static constexpr uint32_t k_invalid_mip = 0xFF;
+      static constexpr uint32_t k_mip_tail = ~0u;
 
       struct image_gpu_data : public cr::refcounted_t
       {
@@ -155,12 +193,28 @@ namespace neam::hydra
         std::optional<image_holder> image;
         std::optional<vk::sampler> sampler;
 
+        // bit N is set when mip level N is loaded
         skip_copy<std::atomic<uint64_t>> loaded_mip_mask;
+        skip_copy<std::atomic<uint64_t>> in_flight_bytes; // (estimated) bytes of mips being streamed for this texture
 
         async::continuation_chain upload_chain;
 
         bool valid = false;
         bool evicted = false;
+        // mips in [general_layout_mip_begin, general_layout_mip_end) are in the GENERAL layout (used by the copies),
+        // the other ones are in SHADER_READ_ONLY_OPTIMAL. Protected by view_lock
+        uint32_t general_layout_mip_begin = 0;
+        uint32_t general_layout_mip_end = 0;
+
+        // sparse residency (only used when sparse is true):
+        bool sparse = false;
+        uint32_t mip_tail_first_lod = 0; // mips at and after this level are in the mip-tail and are always resident
+        VkDeviceSize mip_tail_offset = 0;
+        glm::uvec3 sparse_granularity { 1, 1, 1 };
+
+        mutable skip_copy<spinlock> sparse_lock; // protects the allocations
+        memory_allocation mip_tail_allocation;
+        std::vector<memory_allocation> mip_allocations; // indexed by mip level, only levels before mip_tail_first_lod are used
 
         texture_manager* owner = nullptr;
 
@@ -194,9 +248,55 @@ namespace neam::hydra
         shader_structs::texture_manager_descriptor_set_t descriptor_set;
       };
 
+      /// \brief Pending sparse bind/unbind operation, to be submitted at the start of the next frame
+      struct pending_sparse_op_t
+      {
+        dfe_refcount_pooled_ptr<image_gpu_data> gpu_data;
+        uint32_t mip_level; // k_mip_tail for the mip-tail
+        bool unbind = false;
+
+        // unbind only: the allocation that was bound, freed once the unbind operation is done
+        memory_allocation released_allocation;
+      };
+
+      struct stream_request_t
+      {
+        texture_index_t tid;
+        string_id rid;
+        uint8_t requested_mip_level;
+        uint8_t streamed_mip_level;
+        uint64_t last_frame_with_usage;
+      };
+
     private:
       void load_texture_data_unlocked(texture_index_t tid, string_id rid);
-      void load_mip_data_unlocked(texture_entry& entry, texture_index_t tid);
+      /// \brief Stream the mips from target_mip_level to the currently streamed mip
+      /// \param estimated_bytes is accounted as in-flight until the streaming is done
+      void load_mip_data_unlocked(texture_entry& entry, texture_index_t tid, uint32_t target_mip_level, uint64_t estimated_bytes);
+      /// \brief Read a mip (directly into staging memory when the image has raw mips) and queue its upload
+      /// \return a chain completed once the mip is uploaded (or on failure)
+      async::continuation_chain stream_mip_unlocked(const texture_entry& entry, texture_index_t tid, string_id rid, uint32_t mip_level, const dfe_refcount_pooled_ptr<image_gpu_data>& gpu_data);
+      async::continuation_chain upload_mip(image_gpu_data& gpu_data, uint32_t mip_level, glm::uvec3 mip_size, transfer_context::staging_memory&& texels);
+      /// \brief Return whether the texture at tid is still the resource rid
+      bool is_entry_still_valid(texture_index_t tid, string_id rid) const;
+
+      /// \brief Rank the stream requests and start them until the configured limits are reached
+      streaming_stats_t schedule_streaming(std::vector<stream_request_t>& requests);
+      /// \brief Estimate the memory cost of a mip (the format is not known, so it's derived from the cost of the full image)
+      uint64_t estimate_mip_size_unlocked(const texture_entry& entry, uint32_t mip_level) const;
+      void release_in_flight_bytes(image_gpu_data& gpu_data, uint64_t bytes);
+
+      bool can_use_sparse_residency(VkFormat format) const;
+      /// \brief Create a sparse image for the entry. Return false if the image cannot be sparse (the caller should then use the non-sparse path)
+      bool create_sparse_image_unlocked(texture_entry& entry, glm::uvec2 size, string_id rid);
+      /// \brief Allocate and queue the binding of the memory for the mips in [first_mip, end_mip)
+      void allocate_sparse_mips(const dfe_refcount_pooled_ptr<image_gpu_data>& gpu_data, uint32_t first_mip, uint32_t end_mip);
+      /// \brief Release the memory of the mips before new_base_mip (the image view is shrunk accordingly)
+      /// \note Does nothing if there's streaming operations in progress for the texture
+      /// \return the number of mips that were released
+      uint32_t drop_sparse_mips_unlocked(texture_entry& entry, uint32_t new_base_mip);
+      /// \brief Submit the pending sparse bind/unbind operations
+      void flush_sparse_operations(vk::submit_info& si);
 
     private:
       hydra_context& hctx;
@@ -221,6 +321,15 @@ namespace neam::hydra
       std::atomic<bool> has_changed { true };
       std::atomic<uint64_t> total_memory { 0 };
 
+      std::atomic<uint64_t> bytes_in_flight { 0 };
+      std::atomic<uint32_t> frame_dropped_mips { 0 };
+      std::atomic<uint32_t> frame_evicted_textures { 0 };
+      mutable spinlock stats_lock;
+      streaming_stats_t last_frame_stats;
+
+      spinlock pending_sparse_ops_lock;
+      std::mtc_vector<pending_sparse_op_t> pending_sparse_ops;
+
       texture_manager_configuration configuration;
   };
 }
@@ -0,0 +1,203 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "transform_manager.hpp"
+
+#include <algorithm>
+
+#include <hydra/engine/hydra_context.hpp>
+
+namespace neam::hydra
+{
+  static_assert(sizeof(packed_transform) == 28, "packed_transform must match packed_transform_t (scalar layout)");
+
+  // ranges separated by less than this amount of slots are merged into a single transfer
+  static constexpr uint32_t k_max_range_gap = 16;
+
+  transform_manager::transform_manager(hydra_context& _hctx)
+    : hctx(_hctx)
+  {
+    on_index_loaded_tk = hctx.res.on_index_loaded.add([this]
+    {
+      hctx.hconf.read_or_create_conf(configuration);
+    });
+
+    txctx.debug_context = "transform_manager::txctx";
+  }
+
+  uint32_t transform_manager::allocate_slot()
+  {
+    {
+      std::lock_guard _l(free_slots_lock);
+      if (!free_slots.empty())
+      {
+        const uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        used_slot_count.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+      }
+    }
+
+    uint32_t slot;
+    {
+      std::lock_guard _l(spinlock_exclusive_adapter::adapt(transforms_lock));
+      if (transforms.size() >= configuration.max_slots)
+      {
+        cr::out().warn("transform-manager: failed to allocate a slot: reached max number of slots ({})", configuration.max_slots);
+        return k_invalid_slot;
+      }
+      slot = (uint32_t)transforms.size();
+      transforms.emplace_back();
+    }
+    used_slot_count.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+  }
+
+  void transform_manager::release_slot(uint32_t slot)
+  {
+    if (!check::debug::n_check(slot != k_invalid_slot, "transform-manager: trying to release an invalid slot"))
+      return;
+
+    used_slot_count.fetch_sub(1, std::memory_order_relaxed);
+
+    // the slot might still be referenced by in-flight frames:
+    hctx.dfe.defer([this, slot]
+    {
+      std::lock_guard _l(free_slots_lock);
+      free_slots.push_back(slot);
+    });
+  }
+
+  void transform_manager::on_world_transform_changed(uint32_t slot, const hydra::transform& world)
+  {
+    const packed_transform pt = world.pack();
+    {
+      // NOTE: slots are never updated concurrently, so a shared lock is enough
+      std::lock_guard _l(spinlock_shared_adapter::adapt(transforms_lock));
+      transforms[slot] = pt;
+    }
+    std::lock_guard _l(dirty_slots_lock);
+    dirty_slots.push_back(slot);
+  }
+
+  void transform_manager::upload_changes(vk::submit_info& si)
+  {
+    TRACY_SCOPED_ZONE;
+
+    std::mtc_vector<uint32_t> slots;
+    {
+      std::lock_guard _l(dirty_slots_lock);
+      slots.swap(dirty_slots);
+    }
+
+    std::lock_guard _l(spinlock_shared_adapter::adapt(transforms_lock));
+    const uint32_t slot_count = (uint32_t)transforms.size();
+    if (slot_count == 0)
+      return;
+
+    // resize the transform buffer if necessary (which requires a full upload):
+    bool full_upload = false;
+    if (!gpu_state.transform_buffer || gpu_state.capacity < slot_count)
+    {
+      const uint32_t granularity = std::max(configuration.slots_to_allocate_at_once, 1u);
+      gpu_state.capacity = ((slot_count + granularity - 1) / granularity) * granularity;
+
+      hctx.dfe.defer_destruction(std::move(gpu_state.transform_buffer));
+      gpu_state.transform_buffer.emplace
+      (
+        hctx.allocator,
+        vk::buffer
+        (
+          hctx.device,
+          k_header_size + gpu_state.capacity * sizeof(packed_transform),
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        ),
+        hydra::allocation_type::persistent
+      );
+      gpu_state.transform_buffer->buffer._set_debug_name("transform_manager::transform_buffer");
+
+      hctx.dfe.defer_destruction(gpu_state.descriptor_set.reset());
+      gpu_state.descriptor_set.transform_manager_transforms = gpu_state.transform_buffer->buffer;
+      gpu_state.descriptor_set.update_descriptor_set(hctx);
+
+      full_upload = true;
+    }
+
+    const bool count_changed = gpu_state.uploaded_slot_count != slot_count;
+    if (!full_upload && !count_changed && slots.empty())
+      return;
+
+    vk::buffer& buffer = gpu_state.transform_buffer->buffer;
+    txctx.acquire(buffer, hctx.gqueue);
+    if (full_upload)
+    {
+      // write directly in staging memory (avoids an intermediate raw_data + copy task):
+      transfer_context::staging_memory data = txctx.allocate_staging(k_header_size + slot_count * sizeof(packed_transform));
+      memcpy(data.data().data(), &slot_count, sizeof(slot_count));
+      memcpy(data.data().data() + k_header_size, transforms.data(), slot_count * sizeof(packed_transform));
+      txctx.transfer(buffer, std::move(data));
+    }
+    else
+    {
+      if (count_changed)
+        txctx.transfer(buffer, raw_data::duplicate(slot_count));
+
+      // upload contiguous ranges of changed transforms:
+      std::sort(slots.begin(), slots.end());
+      slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+      for (uint32_t i = 0; i < (uint32_t)slots.size();)
+      {
+        const uint32_t first = slots[i];
+        uint32_t last = first;
+        for (++i; i < (uint32_t)slots.size() && slots[i] - last <= k_max_range_gap; ++i)
+          last = slots[i];
+
+        const uint32_t count = last - first + 1;
+        transfer_context::staging_memory data = txctx.allocate_staging(count * sizeof(packed_transform));
+        memcpy(data.data().data(), transforms.data() + first, count * sizeof(packed_transform));
+        txctx.transfer(buffer, std::move(data), k_header_size + first * sizeof(packed_transform));
+      }
+    }
+    txctx.release(buffer, hctx.gqueue);
+    gpu_state.uploaded_slot_count = slot_count;
+
+    txctx.build(si);
+  }
+
+  void transform_manager::begin_engine_shutdown()
+  {
+    cr::out().debug("transform-manager: clearing for engine shutdown");
+    {
+      std::lock_guard _l(dirty_slots_lock);
+      dirty_slots.clear();
+    }
+    hctx.dfe.defer_destruction(gpu_state.descriptor_set.reset());
+    hctx.dfe.defer_destruction(std::move(gpu_state.transform_buffer));
+    gpu_state.transform_buffer.reset();
+    gpu_state.capacity = 0;
+    gpu_state.uploaded_slot_count = 0;
+  }
+}
@@ -0,0 +1,136 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <vector>
+
+#include <ntools/event.hpp>
+#include <ntools/spinlock.hpp>
+#include <ntools/mt_check/vector.hpp>
+
+#include <hydra/ecs/transform.hpp>
+#include <hydra/ecs/world_transform_listener.hpp>
+#include <hydra/engine/conf/conf.hpp>
+#include <hydra/utilities/holders.hpp>
+#include <hydra/utilities/transfer_context.hpp>
+
+#include "transform_manager_shader_structs.hpp"
+
+namespace neam::hydra
+{
+  struct transform_manager_configuration : hydra::conf::hconf<transform_manager_configuration, "configuration/transform_manager.hcnf", conf::location_t::index_program_local_dir>
+  {
+    uint32_t slots_to_allocate_at_once = 4096;
+    uint32_t max_slots = 1024 * 1024;
+  };
+}
+
+N_METADATA_STRUCT(neam::hydra::transform_manager_configuration)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(slots_to_allocate_at_once, neam::metadata::info{.description = c_string_t
+    <
+      "By how much slots the transform buffer grows everytimes it needs to grow.\n"
+      "Growing the buffer means re-uploading all the transforms, so a bigger number means less full uploads"
+    >}),
+    N_MEMBER_DEF(max_slots, neam::metadata::info{.description = c_string_t
+    <
+      "Max number of transforms in the GPU buffer. Transform components past that limit will not have a slot."
+    >})
+  >;
+};
+
+namespace neam::hydra
+{
+  struct hydra_context;
+
+  /// \brief Stream the world transforms of the renderer universe to a persistent GPU buffer (of packed_transform_t)
+  /// Every transform component is given a stable slot (index in the buffer), see ecs::components::transform::get_world_transform_slot.
+  /// Only the transforms that changed are uploaded (as contiguous ranges).
+  ///
+  /// \note Released slots are only re-used once the GPU is done with the frames that might have referenced them
+  class transform_manager : public ecs::world_transform_listener
+  {
+    public:
+      explicit transform_manager(hydra_context& _hctx);
+
+      shader_structs::transform_manager_descriptor_set_t& get_descriptor_set() { return gpu_state.descriptor_set; }
+      const shader_structs::transform_manager_descriptor_set_t& get_descriptor_set() const { return gpu_state.descriptor_set; }
+
+      /// \brief Return the number of slots currently in use
+      uint32_t get_used_slot_count() const { return used_slot_count.load(std::memory_order_relaxed); }
+
+    public: // world_transform_listener:
+      [[nodiscard]] uint32_t allocate_slot() override;
+      void release_slot(uint32_t slot) override;
+      void on_world_transform_changed(uint32_t slot, const hydra::transform& world) override;
+
+    public: // management:
+      /// \brief Upload the transforms that changed since the last call
+      /// \note must be called after the hierarchical update and before the submission of anything reading the transforms
+      void upload_changes(vk::submit_info& si);
+
+      void begin_engine_shutdown();
+
+    private:
+      struct gpu_state_t
+      {
+        // buffer of type: shader_structs::transform_manager_transforms_t
+        std::optional<buffer_holder> transform_buffer;
+        uint32_t capacity = 0;
+        uint32_t uploaded_slot_count = 0;
+
+        shader_structs::transform_manager_descriptor_set_t descriptor_set;
+      };
+
+      static constexpr size_t k_header_size = sizeof(uint32_t);
+
+    private:
+      hydra_context& hctx;
+
+      cr::event_token_t on_index_loaded_tk;
+
+      // cpu-side copy of the buffer (slot allocation grows it, protected by transforms_lock)
+      // NOTE: not a mtc_vector, as different entries are written concurrently under the shared lock
+      shared_spinlock transforms_lock;
+      std::vector<packed_transform> transforms;
+
+      spinlock free_slots_lock;
+      std::mtc_vector<uint32_t> free_slots;
+
+      spinlock dirty_slots_lock;
+      std::mtc_vector<uint32_t> dirty_slots;
+
+      std::atomic<uint32_t> used_slot_count { 0 };
+
+      gpu_state_t gpu_state;
+      transfer_context txctx { hctx };
+
+      transform_manager_configuration configuration;
+  };
+}
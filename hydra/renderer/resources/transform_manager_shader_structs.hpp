@@ -0,0 +1,64 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <hydra/utilities/shader_gen/block.hpp>
+#include <hydra/utilities/shader_gen/descriptor_sets.hpp>
+
+#include <hydra/renderer/shader_structs.hpp>
+
+namespace neam::hydra::shader_structs
+{
+  struct transform_manager_transforms_t : hydra::shaders::block_struct<transform_manager_transforms_t>
+  {
+    shaders::uint32_t transform_count;
+    shaders::unbound_array<packed_transform_t> transforms;
+
+    static constexpr neam::ct::string glsl_type_name = "transform_manager_transforms_t";
+  };
+
+  struct transform_manager_descriptor_set_t : hydra::shaders::descriptor_set_struct<transform_manager_descriptor_set_t>
+  {
+    shaders::buffer<transform_manager_transforms_t, shaders::readonly> transform_manager_transforms;
+  };
+}
+
+N_METADATA_STRUCT(neam::hydra::shader_structs::transform_manager_transforms_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(transform_count),
+    N_MEMBER_DEF(transforms)
+  >;
+};
+N_METADATA_STRUCT(neam::hydra::shader_structs::transform_manager_descriptor_set_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(transform_manager_transforms)
+  >;
+};
@@ -0,0 +1,269 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <bit>
+#include <cstring>
+
+#include <fmt/format.h>
+#include <ntools/hash/fnv1a.hpp>
+#include <ntools/logger/logger.hpp>
+
+#include "build_cache.hpp"
+
+#include <unistd.h>
+
+namespace neam::resources
+{
+  static constexpr uint64_t k_word_hash_seed = 0x9E3779B97F4A7C15ull;
+  static constexpr uint64_t k_word_hash_mul_0 = 0x87C37B91114253D5ull;
+  static constexpr uint64_t k_word_hash_mul_1 = 0x4CF5AD432745937Full;
+
+  static uint64_t word_hash_mix(uint64_t k)
+  {
+    k *= k_word_hash_mul_0;
+    k = std::rotl(k, 31);
+    return k * k_word_hash_mul_1;
+  }
+
+  /// \brief Multiply-rotate hash over 8 byte words (murmur3 style)
+  /// Works on words instead of bytes, so that it is independent from fnv1a (the other half of build_cache::hash_t)
+  static uint64_t word_hash(uint64_t h, const uint8_t* data, size_t size)
+  {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+      uint64_t k;
+      memcpy(&k, data + i, sizeof(k));
+      h ^= word_hash_mix(k);
+      h = std::rotl(h, 27) * 5 + 0x52DCE729;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    h ^= word_hash_mix(tail);
+    h ^= (uint64_t)size;
+
+    // final avalanche:
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static build_cache::hash_t hash_128(const uint8_t* data, size_t size)
+  {
+    return { .low = ct::hash::fnv1a<64>(data, size), .high = word_hash(k_word_hash_seed, data, size) };
+  }
+
+  std::string build_cache::key_t::to_string() const
+  {
+    return fmt::format("{:016X}{:016X}", hash.high, hash.low);
+  }
+
+  void build_cache::set_directory(std::filesystem::path dir)
+  {
+    if (!dir.empty())
+    {
+      std::error_code ec;
+      std::filesystem::create_directories(dir / "tmp", ec);
+      if (ec)
+      {
+        cr::out().warn("build_cache: cannot use {} as the build cache directory: {}. The build cache is disabled.", dir.c_str(), ec.message());
+        dir.clear();
+      }
+    }
+    directory = std::move(dir);
+  }
+
+  std::filesystem::path build_cache::get_entry_path(const key_t& key) const
+  {
+    // two level hierarchy, to avoid having too many files in a single directory
+    return directory / fmt::format("{:02X}", key.hash.high >> 56) / fmt::format("{}{}", key.to_string(), k_entry_extension);
+  }
+
+  build_cache::lookup_chain build_cache::lookup(const key_t& key)
+  {
+    if (!is_enabled())
+    {
+      ++miss_count;
+      return lookup_chain::create_and_complete({}, false);
+    }
+
+    const id_t fid = io.map_unprefixed_file(get_entry_path(key));
+    return io.queue_read(fid, 0, io::context::whole_file).then([this, fid, key](raw_data&& data, bool success, size_t)
+    {
+      io.unmap_file(fid);
+
+      entry_header_t header;
+      if (!success || data.size < sizeof(header))
+      {
+        ++miss_count;
+        return lookup_chain::create_and_complete({}, false);
+      }
+      memcpy(&header, data.data.get(), sizeof(header));
+      const size_t ids_size = key.ids.size() * sizeof(id_t);
+      const size_t inputs_size = key.inputs.size() * sizeof(input_t);
+      const size_t entry_offset = sizeof(header) + ids_size + inputs_size;
+      if (header.magic != k_magic || header.version != k_version || header.key != key.hash
+          || header.id_count != key.ids.size() || header.input_count != key.inputs.size()
+          || data.size < entry_offset || header.size != data.size - entry_offset)
+      {
+        cr::out().debug("build_cache: entry {} is invalid (or from a different version), ignoring it", key.to_string());
+        ++miss_count;
+        return lookup_chain::create_and_complete({}, false);
+      }
+      // the 128 bit hash matched, but the ids / inputs (hash and size) of the entry must also be the same:
+      const uint8_t* const ids = (const uint8_t*)data.data.get() + sizeof(header);
+      const uint8_t* const inputs = ids + ids_size;
+      if (memcmp(ids, key.ids.data(), ids_size) != 0 || memcmp(inputs, key.inputs.data(), inputs_size) != 0)
+      {
+        cr::out().warn("build_cache: entry {} was made from different inputs (hash collision), ignoring it", key.to_string());
+        ++miss_count;
+        return lookup_chain::create_and_complete({}, false);
+      }
+
+      ++hit_count;
+      read_bytes += data.size;
+      saved_time_us += (uint64_t)(header.duration * 1e6);
+
+      raw_data entry = raw_data::allocate(header.size);
+      memcpy(entry.data.get(), (const uint8_t*)data.data.get() + entry_offset, header.size);
+      return lookup_chain::create_and_complete(std::move(entry), true);
+    });
+  }
+
+  void build_cache::store(const key_t& key, raw_data&& entry, double duration)
+  {
+    if (!is_enabled())
+      return;
+
+    const entry_header_t header
+    {
+      .magic = k_magic,
+      .version = k_version,
+      .key = key.hash,
+      .duration = duration,
+      .id_count = (uint32_t)key.ids.size(),
+      .input_count = (uint32_t)key.inputs.size(),
+      .size = entry.size,
+    };
+    const size_t ids_size = key.ids.size() * sizeof(id_t);
+    const size_t inputs_size = key.inputs.size() * sizeof(input_t);
+    raw_data data = raw_data::allocate(sizeof(header) + ids_size + inputs_size + entry.size);
+    uint8_t* it = (uint8_t*)data.data.get();
+    memcpy(it, &header, sizeof(header));
+    it += sizeof(header);
+    memcpy(it, key.ids.data(), ids_size);
+    it += ids_size;
+    memcpy(it, key.inputs.data(), inputs_size);
+    it += inputs_size;
+    memcpy(it, entry.data.get(), entry.size);
+
+    // the entry is first written in the tmp directory, then renamed.
+    // (renames are atomic, so other processes / machines never see partial entries)
+    std::filesystem::path final_path = get_entry_path(key);
+    std::filesystem::path tmp_path = directory / "tmp" / fmt::format("{}-{}-{}", key.to_string(), getpid(), tmp_counter++);
+
+    std::error_code ec;
+    std::filesystem::create_directories(final_path.parent_path(), ec);
+
+    const id_t fid = io.map_unprefixed_file(tmp_path);
+    io.queue_write(fid, io::context::truncate, std::move(data))
+    .then([this, fid, key_name = key.to_string(), tmp_path = std::move(tmp_path), final_path = std::move(final_path)](raw_data&& data, bool success, size_t write_size)
+    {
+      io.unmap_file(fid);
+      std::error_code ec;
+      if (!success || write_size != data.size)
+      {
+        cr::out().warn("build_cache: failed to write entry {}", key_name);
+        std::filesystem::remove(tmp_path, ec);
+        return;
+      }
+      std::filesystem::rename(tmp_path, final_path, ec);
+      if (ec)
+      {
+        std::filesystem::remove(tmp_path, ec);
+        return;
+      }
+      ++store_count;
+      written_bytes += data.size;
+    });
+  }
+
+  build_cache::stats_t build_cache::get_stats() const
+  {
+    return
+    {
+      .hit_count = hit_count.load(std::memory_order_relaxed),
+      .miss_count = miss_count.load(std::memory_order_relaxed),
+      .store_count = store_count.load(std::memory_order_relaxed),
+      .read_bytes = read_bytes.load(std::memory_order_relaxed),
+      .written_bytes = written_bytes.load(std::memory_order_relaxed),
+      .saved_time = (double)saved_time_us.load(std::memory_order_relaxed) * 1e-6,
+    };
+  }
+
+  void build_cache::reset_stats()
+  {
+    hit_count = 0;
+    miss_count = 0;
+    store_count = 0;
+    read_bytes = 0;
+    written_bytes = 0;
+    saved_time_us = 0;
+  }
+
+  build_cache::input_t build_cache::hash(const raw_data& data)
+  {
+    return hash(data.data.get(), data.size);
+  }
+
+  build_cache::input_t build_cache::hash(const void* data, size_t size)
+  {
+    if (data == nullptr || size == 0)
+      return {};
+    return { .hash = hash_128((const uint8_t*)data, size), .size = size };
+  }
+
+  build_cache::key_t build_cache::make_key(std::initializer_list<id_t> ids, std::initializer_list<input_t> inputs)
+  {
+    key_t key { .ids = ids, .inputs = inputs };
+
+    const uint32_t counts[] = { k_version, (uint32_t)key.ids.size(), (uint32_t)key.inputs.size() };
+    std::vector<uint8_t> buffer;
+    buffer.resize(sizeof(counts) + key.ids.size() * sizeof(id_t) + key.inputs.size() * sizeof(input_t));
+    uint8_t* it = buffer.data();
+    memcpy(it, counts, sizeof(counts));
+    it += sizeof(counts);
+    memcpy(it, key.ids.data(), key.ids.size() * sizeof(id_t));
+    it += key.ids.size() * sizeof(id_t);
+    memcpy(it, key.inputs.data(), key.inputs.size() * sizeof(input_t));
+
+    key.hash = hash_128(buffer.data(), buffer.size());
+    return key;
+  }
+}
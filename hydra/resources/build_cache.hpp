@@ -0,0 +1,165 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <ntools/id/id.hpp>
+#include <ntools/raw_data.hpp>
+#include <ntools/async/chain.hpp>
+#include <ntools/io/context.hpp>
+
+namespace neam::resources
+{
+  /// \brief Content-addressed cache for the processor / packer invocations
+  /// Entries are keyed on a 128 bit hash of everything the invocation depends on (input data, metadata, processor/packer version, ...)
+  /// and are stored as individual files in a directory, so the cache can be shared between runs and machines.
+  /// The ids and the inputs (hash and size) the key was made of are stored in the entry and are checked on lookup:
+  /// a hit requires the 128 bit hash, the ids, and the hash and size of every input to match.
+  ///
+  /// The cache does not know about the content of the entries. (see context::run_processor / context::run_packer)
+  /// \note entries are never evicted. Removing the directory (or some of its content) is always safe.
+  class build_cache
+  {
+    public:
+      static constexpr uint32_t k_magic = 0x43424848; // HHBC
+      static constexpr uint32_t k_version = 2;
+      static constexpr const char* k_entry_extension = ".hbc";
+
+      struct stats_t
+      {
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+        uint64_t store_count = 0;
+
+        uint64_t read_bytes = 0;
+        uint64_t written_bytes = 0;
+
+        // time the cached invocations took when they were stored in the cache (in seconds)
+        double saved_time = 0;
+
+        float hit_ratio() const
+        {
+          const uint64_t total = hit_count + miss_count;
+          return total > 0 ? (float)hit_count / (float)total : 0.0f;
+        }
+      };
+
+      /// \brief 128 bit hash, made of two independent 64 bit hashes
+      struct hash_t
+      {
+        uint64_t low = 0;
+        uint64_t high = 0;
+
+        bool operator == (const hash_t&) const = default;
+      };
+
+      /// \brief Hash and size of an input of an invocation (file data, serialized metadata, ...)
+      struct input_t
+      {
+        hash_t hash;
+        uint64_t size = 0;
+
+        bool operator == (const input_t&) const = default;
+      };
+
+      /// \brief Everything an invocation depends on
+      struct key_t
+      {
+        hash_t hash; // hash of the ids and inputs, names the entry
+        std::vector<id_t> ids;
+        std::vector<input_t> inputs;
+
+        std::string to_string() const;
+      };
+
+      using lookup_chain = async::chain<raw_data&& /*entry*/, bool /*hit*/>;
+
+    public:
+      explicit build_cache(io::context& _io) : io(_io) {}
+
+      /// \brief Set the directory of the cache. An empty path disables the cache.
+      void set_directory(std::filesystem::path dir);
+      const std::filesystem::path& get_directory() const { return directory; }
+
+      bool is_enabled() const { return !directory.empty(); }
+
+      /// \brief Asynchronously retrieve an entry
+      /// \note a missing / invalid entry is a miss
+      lookup_chain lookup(const key_t& key);
+
+      /// \brief Asynchronously store an entry
+      /// \param duration the time the invocation took (in seconds), used to compute the time saved by hits
+      void store(const key_t& key, raw_data&& entry, double duration);
+
+      stats_t get_stats() const;
+      void reset_stats();
+
+    public: // key helpers
+      /// \brief Hash the content of a buffer
+      static input_t hash(const raw_data& data);
+      static input_t hash(const void* data, size_t size);
+
+      /// \brief Make the key of an invocation
+      /// \param ids identify the invocation (processor / packer, file, resource, ...)
+      /// \param inputs the content the invocation depends on (see hash())
+      static key_t make_key(std::initializer_list<id_t> ids, std::initializer_list<input_t> inputs);
+
+    private:
+      std::filesystem::path get_entry_path(const key_t& key) const;
+
+      /// \brief Followed by the ids, the inputs, then the entry
+      struct entry_header_t
+      {
+        uint32_t magic;
+        uint32_t version;
+        hash_t key;
+        double duration;
+        uint32_t id_count;
+        uint32_t input_count;
+        uint64_t size;
+      };
+
+    private:
+      io::context& io;
+      std::filesystem::path directory;
+
+      std::atomic<uint64_t> hit_count = 0;
+      std::atomic<uint64_t> miss_count = 0;
+      std::atomic<uint64_t> store_count = 0;
+      std::atomic<uint64_t> read_bytes = 0;
+      std::atomic<uint64_t> written_bytes = 0;
+      std::atomic<uint64_t> saved_time_us = 0;
+
+      std::atomic<uint32_t> tmp_counter = 0;
+  };
+}
+
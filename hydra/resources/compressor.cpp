@@ -25,11 +25,17 @@
 //
 
 
+#include <algorithm>
+#include <cstring>
+
 #include "compressor.hpp"
 
 #if N_RES_LZMA_COMPRESSION
   #include <lzma.h>
 #endif
+#if N_RES_ZSTD_COMPRESSION
+  #include <zstd.h>
+#endif
 
 namespace neam::resources
 {
@@ -37,11 +43,53 @@ namespace neam::resources
   constexpr unsigned int k_header[] = { 0x587a37fd, 0x0000005a, };
   constexpr uint64_t k_size_header = 0xFF00FF0000000000;
   constexpr uint64_t k_size_header_mask = 0x000000FFFFFFFFFF;
+  // the codec is stored in the spare byte of the size header (lzma being 0, older data is still valid)
+  constexpr uint64_t k_codec_header_mask = 0x00FF000000000000;
+  constexpr uint64_t k_codec_header_shift = 48;
 
-  raw_data compress(raw_data&& in)
+  // zstd is used for its decoding speed, so we can afford a slow compression
+  [[maybe_unused]] constexpr int k_zstd_compression_level = 19;
+
+  bool is_codec_supported(codec c)
   {
+    switch (c)
+    {
+      case codec::lzma: return N_RES_LZMA_COMPRESSION;
+#if N_RES_ZSTD_COMPRESSION
+      case codec::zstd: return N_RES_LZMA_COMPRESSION;
+#endif
+      default: return false;
+    }
+  }
+
+  codec get_codec_from_name(std::string_view name, codec fallback)
+  {
+    codec ret = fallback;
+    if (name == "lzma")
+      ret = codec::lzma;
+    else if (name == "zstd")
+      ret = codec::zstd;
+    else if (!name.empty())
+      cr::out().warn("resources: unknown compression codec: {} (using {} instead)", name, get_codec_name(fallback));
+
+    if (!is_codec_supported(ret))
+      return fallback;
+    return ret;
+  }
+
+  std::string_view get_codec_name(codec c)
+  {
+    switch (c)
+    {
+      case codec::lzma: return "lzma";
+      case codec::zstd: return "zstd";
+    }
+    return "unknown";
+  }
+
 #if N_RES_LZMA_COMPRESSION
-    TRACY_SCOPED_ZONE;
+  static raw_data compress_lzma(raw_data&& in)
+  {
     raw_data out = raw_data::allocate(lzma_stream_buffer_bound(in.size));
 
     size_t real_size = 0;
@@ -62,60 +110,174 @@ namespace neam::resources
                           ((uint32_t*)out.data.get())[1], k_header[1]);
 
     // write the original size over the header (the uncompress restore the header):
-    *(uint64_t*)out.data.get() = k_size_header | in.size;
+    *(uint64_t*)out.data.get() = k_size_header | ((uint64_t)codec::lzma << k_codec_header_shift) | in.size;
+    return out;
+  }
+
+  static bool uncompress_lzma(raw_data&& in, std::span<uint8_t> out)
+  {
+    // write-back the header
+    ((uint32_t*)in.data.get())[0] = k_header[0];
+    ((uint32_t*)in.data.get())[1] = k_header[1];
+
+    size_t memlimit = UINT64_MAX;
+    size_t in_end_pos = 0;
+    size_t out_end_pos = 0;
+    lzma_ret ret = lzma_stream_buffer_decode(&memlimit, LZMA_IGNORE_CHECK, nullptr,
+                                             (const uint8_t*)in.data.get(), &in_end_pos, in.size,
+                                             out.data(), &out_end_pos, out.size());
+
+    if (ret != LZMA_OK)
+    {
+      cr::out().error("resources::uncompress: lzma decoder failed (code: {})", std::to_underlying(ret));
+      return false;
+    }
+
+    if (out_end_pos != out.size())
+    {
+      cr::out().error("resources::uncompress: uncompressed size is different from the expected size");
+      return false;
+    }
+
+    return true;
+  }
+#endif
+
+#if N_RES_ZSTD_COMPRESSION
+  static raw_data compress_zstd(raw_data&& in)
+  {
+    // zstd has no header to remove, so the size header is simply prepended
+    raw_data out = raw_data::allocate(sizeof(uint64_t) + ZSTD_compressBound(in.size));
+
+    const size_t real_size = ZSTD_compress((uint8_t*)out.data.get() + sizeof(uint64_t), out.size - sizeof(uint64_t),
+                                           in.data.get(), in.size, k_zstd_compression_level);
+    if (ZSTD_isError(real_size))
+    {
+      cr::out().error("resources::compress: zstd encoder failed ({})", ZSTD_getErrorName(real_size));
+      return {};
+    }
+    out.size = sizeof(uint64_t) + real_size;
+
+    *(uint64_t*)out.data.get() = k_size_header | ((uint64_t)codec::zstd << k_codec_header_shift) | in.size;
+    return out;
+  }
+
+  static bool uncompress_zstd(raw_data&& in, std::span<uint8_t> out)
+  {
+    const size_t out_size = ZSTD_decompress(out.data(), out.size(), (const uint8_t*)in.data.get() + sizeof(uint64_t), in.size - sizeof(uint64_t));
+    if (ZSTD_isError(out_size))
+    {
+      cr::out().error("resources::uncompress: zstd decoder failed ({})", ZSTD_getErrorName(out_size));
+      return false;
+    }
+
+    if (out_size != out.size())
+    {
+      cr::out().error("resources::uncompress: uncompressed size is different from the expected size");
+      return false;
+    }
+
+    return true;
+  }
+#endif
 
-    cr::out().debug("resources::compress: compressed {} bytes into {} bytes (output is {}% of input)", in.size, out.size, out.size * 100 / in.size);
+  raw_data compress(raw_data&& in, codec c)
+  {
+#if N_RES_LZMA_COMPRESSION
+    TRACY_SCOPED_ZONE;
+    if (!is_codec_supported(c))
+      c = codec::lzma;
+
+    const size_t in_size = in.size;
+    raw_data out;
+    switch (c)
+    {
+#if N_RES_ZSTD_COMPRESSION
+      case codec::zstd: out = compress_zstd(std::move(in)); break;
+#endif
+      default: out = compress_lzma(std::move(in)); break;
+    }
+
+    if (out.size > 0)
+    {
+      cr::out().debug("resources::compress: compressed {} bytes into {} bytes using {} (output is {}% of input)",
+                      in_size, out.size, get_codec_name(c), out.size * 100 / std::max<size_t>(1, in_size));
+    }
     return out;
 #else
+    (void)c;
     return std::move(in);
 #endif
   }
 
-  raw_data uncompress(raw_data&& in)
+  uint64_t get_uncompressed_size(const raw_data& in)
+  {
+#if N_RES_LZMA_COMPRESSION
+    if (in.size < sizeof(uint64_t))
+      return 0;
+
+    const uint64_t header_size = *(const uint64_t*)in.data.get();
+    const uint64_t header_check = header_size & ~(k_size_header_mask | k_codec_header_mask);
+    if (header_check != k_size_header)
+      return 0;
+    return header_size & k_size_header_mask;
+#else
+    return in.size;
+#endif
+  }
+
+  bool uncompress_into(raw_data&& in, std::span<uint8_t> out)
   {
 #if N_RES_LZMA_COMPRESSION
     TRACY_SCOPED_ZONE;
     if (in.size < sizeof(uint64_t))
     {
       cr::out().error("resources::uncompress: cannot uncompress a data smaller than the minimal header (got {} bytes)", in.size);
-      return {};
+      return false;
     }
 
-    // grab the original size:
+    // grab the original size and the codec:
     const uint64_t header_size = *(const uint64_t*)in.data.get();
     const uint64_t size = header_size & k_size_header_mask;
-    const uint64_t header_check = header_size & ~k_size_header_mask;
+    const codec c = (codec)((header_size & k_codec_header_mask) >> k_codec_header_shift);
+    const uint64_t header_check = header_size & ~(k_size_header_mask | k_codec_header_mask);
     if (header_check != k_size_header)
     {
       cr::out().error("resources::uncompress: invalid header. Corrupted data?", in.size);
-      return {};
+      return false;
     }
-
-    // write-back the header
-    ((uint32_t*)in.data.get())[0] = k_header[0];
-    ((uint32_t*)in.data.get())[1] = k_header[1];
-
-    raw_data out = raw_data::allocate(size);
-
-    size_t memlimit = UINT64_MAX;
-    size_t in_end_pos = 0;
-    size_t out_end_pos = 0;
-    lzma_ret ret = lzma_stream_buffer_decode(&memlimit, LZMA_IGNORE_CHECK, nullptr,
-                                             (const uint8_t*)in.data.get(), &in_end_pos, in.size,
-                                             (uint8_t*)out.data.get(), &out_end_pos, out.size);
-
-    if (ret != LZMA_OK)
+    if (size != out.size())
     {
-      cr::out().error("resources::uncompress: lzma decoder failed (code: {})", std::to_underlying(ret));
-      return {};
+      cr::out().error("resources::uncompress: output memory is {} bytes, but the data uncompresses to {} bytes", out.size(), size);
+      return false;
     }
 
-    if (out_end_pos != out.size)
+    switch (c)
     {
-      cr::out().error("resources::uncompress: uncompressed size is different from the expected size");
-      return {};
+      case codec::lzma: return uncompress_lzma(std::move(in), out);
+#if N_RES_ZSTD_COMPRESSION
+      case codec::zstd: return uncompress_zstd(std::move(in), out);
+#endif
+      default:
+        cr::out().error("resources::uncompress: data uses the {} codec (id: {}), which is not supported by this build",
+                        get_codec_name(c), std::to_underlying(c));
+        return false;
     }
+#else
+    if (in.size != out.size())
+      return false;
+    memcpy(out.data(), in.data.get(), in.size);
+    return true;
+#endif
+  }
 
+  raw_data uncompress(raw_data&& in)
+  {
+#if N_RES_LZMA_COMPRESSION
+    // NOTE: errors (invalid header, ...) are reported by uncompress_into
+    raw_data out = raw_data::allocate(get_uncompressed_size(in));
+    if (!uncompress_into(std::move(in), { (uint8_t*)out.data.get(), out.size }))
+      return {};
     return out;
 #else
     return std::move(in);
@@ -123,7 +285,7 @@ namespace neam::resources
   }
 
   // from https://stackoverflow.com/a/2174323
-  static size_t get_uncompressed_size(const raw_data& data)
+  static size_t get_xz_uncompressed_size(const raw_data& data)
   {
     // Invalid data, so we can avoid doing anything with it
     if (data.size <= LZMA_STREAM_HEADER_SIZE)
@@ -168,7 +330,7 @@ namespace neam::resources
     }
 
     // grab the original size:
-    const uint64_t size = get_uncompressed_size(in);
+    const uint64_t size = get_xz_uncompressed_size(in);
     if (size == 0)
     {
       cr::out().error("resources::uncompress_raw_xz: data does not seem to be a valid XZ stream");
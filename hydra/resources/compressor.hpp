@@ -31,16 +31,49 @@
 #include <ntools/threading/task_manager.hpp>
 #include <ntools/threading/utilities/rate_limit.hpp>
 
+#include <span>
+#include <string_view>
+
 namespace neam::resources
 {
+  /// \brief Codec used to compress the data. The codec is stored in the header of the compressed data.
+  /// \note values are serialized: never change the value of an existing codec
+  enum class codec : uint8_t
+  {
+    // best ratio, slow decoding
+    lzma = 0,
+    // good ratio, very fast decoding (only if the build has zstd support)
+    zstd = 1,
+  };
+
+  /// \brief Return whether the build supports compressing/uncompressing using this codec
+  bool is_codec_supported(codec c);
+
+  /// \brief Return the codec corresponding to name ("lzma", "zstd").
+  /// If the name is empty, unknown or refers to an unsupported codec, fallback is returned
+  codec get_codec_from_name(std::string_view name, codec fallback);
+
+  std::string_view get_codec_name(codec c);
+
   /// \brief Compress a raw_data into a something that uncompress can inflate
   /// \note the result is not a valid XZ stream, but instead can only be decoded with uncompress
-  raw_data compress(raw_data&& in);
+  /// \note if the codec is not supported, lzma is used instead
+  raw_data compress(raw_data&& in, codec c = codec::lzma);
 
   /// \brief uncompress data that were produced by compress
   /// \note the input must not be a valid XZ stream, but instead something that compress produced
+  /// \note the codec is retrieved from the data
   raw_data uncompress(raw_data&& in);
 
+  /// \brief Return the size of the data uncompress will produce (0 if the data does not come from compress)
+  uint64_t get_uncompressed_size(const raw_data& in);
+
+  /// \brief uncompress data that were produced by compress into some already allocated memory
+  /// Allows the uncompressed data to be directly written to its final destination (like staging memory)
+  /// \note out must be exactly get_uncompressed_size(in) bytes
+  /// \return whether the operation succeeded
+  bool uncompress_into(raw_data&& in, std::span<uint8_t> out);
+
   /// \brief uncompress data
   /// \note this version only takes valid XZ data stream
   raw_data uncompress_raw_xz(raw_data&& in);
@@ -48,12 +81,12 @@ namespace neam::resources
 
   // versions using a task manager:
 
-  inline async::chain<raw_data> compress(raw_data&& in, threading::task_manager& tm, threading::group_t group)
+  inline async::chain<raw_data> compress(raw_data&& in, threading::task_manager& tm, threading::group_t group, codec c = codec::lzma)
   {
     async::chain<raw_data> ret;
-    tm.get_task(group, [in = std::move(in), state = ret.create_state()] () mutable
+    tm.get_task(group, [in = std::move(in), c, state = ret.create_state()] () mutable
     {
-      state.complete(compress(std::move(in)));
+      state.complete(compress(std::move(in), c));
     });
     return ret;
   }
@@ -78,12 +111,12 @@ namespace neam::resources
 
   // versions using a rate limiter:
 
-  inline async::chain<raw_data> compress(raw_data&& in, threading::rate_limiter& rl, threading::group_t group, bool high_priority = false)
+  inline async::chain<raw_data> compress(raw_data&& in, threading::rate_limiter& rl, threading::group_t group, bool high_priority = false, codec c = codec::lzma)
   {
     async::chain<raw_data> ret;
-    rl.dispatch(group, [in = std::move(in), state = ret.create_state()] () mutable
+    rl.dispatch(group, [in = std::move(in), c, state = ret.create_state()] () mutable
     {
-      state.complete(compress(std::move(in)));
+      state.complete(compress(std::move(in), c));
     }, high_priority);
     return ret;
   }
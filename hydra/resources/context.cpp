@@ -32,15 +32,167 @@
 #include "compressor.hpp"
 #include "mimetype/mimetype.hpp"
 
-#include "network/connection.hpp"
+#include "network/client.hpp"
 
 #include <hydra/engine/core_context.hpp>
 #include <ntools/struct_metadata/fmt_support.hpp>
 #include <filesystem>
+#include <map>
+
+#include <ntools/chrono.hpp>
+
+namespace neam::resources::internal
+{
+  // build-cache entries (see context::run_processor / context::run_packer)
+  // metadata are stored serialized (so without their file-id), has_source_metadata_file indicates that it was the metadata of the source file
+
+  struct cached_processor_output_t
+  {
+    struct to_pack_t
+    {
+      id_t resource_id;
+      std::string resource_name;
+      id_t resource_type;
+      raw_data data;
+      raw_data metadata;
+      bool has_source_metadata_file;
+    };
+    struct to_process_t
+    {
+      std::string file;
+      raw_data file_data;
+      raw_data metadata;
+      bool has_source_metadata_file;
+    };
+
+    std::vector<to_pack_t> to_pack;
+    std::vector<to_process_t> to_process;
+    status st;
+  };
+
+  struct cached_packer_output_t
+  {
+    struct entry_t
+    {
+      id_t id;
+      std::string resource_name;
+      raw_data data;
+      raw_data metadata;
+      bool has_source_metadata_file;
+
+      id_t simlink_to_id;
+      packer::mode_t mode;
+    };
+
+    std::vector<entry_t> entries;
+    id_t pack_id;
+    std::string pack_name;
+    status st;
+  };
+}
+
+N_METADATA_STRUCT(neam::resources::internal::cached_processor_output_t::to_pack_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(resource_id),
+    N_MEMBER_DEF(resource_name),
+    N_MEMBER_DEF(resource_type),
+    N_MEMBER_DEF(data),
+    N_MEMBER_DEF(metadata),
+    N_MEMBER_DEF(has_source_metadata_file)
+  >;
+};
+N_METADATA_STRUCT(neam::resources::internal::cached_processor_output_t::to_process_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(file),
+    N_MEMBER_DEF(file_data),
+    N_MEMBER_DEF(metadata),
+    N_MEMBER_DEF(has_source_metadata_file)
+  >;
+};
+N_METADATA_STRUCT(neam::resources::internal::cached_processor_output_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(to_pack),
+    N_MEMBER_DEF(to_process),
+    N_MEMBER_DEF(st)
+  >;
+};
+N_METADATA_STRUCT(neam::resources::internal::cached_packer_output_t::entry_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(id),
+    N_MEMBER_DEF(resource_name),
+    N_MEMBER_DEF(data),
+    N_MEMBER_DEF(metadata),
+    N_MEMBER_DEF(has_source_metadata_file),
+    N_MEMBER_DEF(simlink_to_id),
+    N_MEMBER_DEF(mode)
+  >;
+};
+N_METADATA_STRUCT(neam::resources::internal::cached_packer_output_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(entries),
+    N_MEMBER_DEF(pack_id),
+    N_MEMBER_DEF(pack_name),
+    N_MEMBER_DEF(st)
+  >;
+};
 
 namespace neam::resources
 {
-  context::context(io::context& io, hydra::core_context& _ctx) : io_context(io), ctx(_ctx), compressor_dispatcher{ctx.tm} {}
+  context::context(io::context& io, hydra::core_context& _ctx) : io_context(io), ctx(_ctx), compressor_dispatcher{ctx.tm}, cache{io} {}
+
+  context::~context()
+  {
+    disconnect();
+  }
+
+  context::status_chain context::connect(const std::string& host, uint32_t port)
+  {
+    disconnect();
+
+    remote = std::make_unique<network::client>(io_context);
+    return remote->connect(host, (uint16_t)port).then([this, host, port](status st)
+    {
+      if (st == status::failure)
+      {
+        cr::out().error("connect: failed to connect to resource server {}:{}", host, port);
+        return st;
+      }
+
+      cr::out().log("connect: connected to resource server {}:{}", host, port);
+
+      // the server index changed: act as if the index got reloaded
+      on_remote_index_reloaded_tk = remote->on_index_reloaded.add([this]
+      {
+        ctx.tm.get_task([this]() { on_index_loaded(); });
+      });
+      ctx.tm.get_task([this]() { on_index_loaded(); });
+      return st;
+    });
+  }
+
+  void context::disconnect()
+  {
+    if (!remote)
+      return;
+    on_remote_index_reloaded_tk.release();
+    remote->disconnect();
+    remote.reset();
+  }
+
+  bool context::is_connected() const
+  {
+    return remote && remote->is_connected();
+  }
 
   std::string context::get_prefix_from_filename(const std::string& name)
   {
@@ -119,6 +271,15 @@ namespace neam::resources
               }
               cr::out().debug("setting max (de)compression task to be dispatch at the same time to: {}", max_dispatch);
               compressor_dispatcher.set_max_in_flight_tasks(max_dispatch);
+
+              std::filesystem::path cache_directory = configuration.build_cache_directory;
+              if (!cache_directory.empty() && cache_directory.is_relative())
+                cache_directory = std::filesystem::path(prefix) / cache_directory;
+              if (cache_directory != cache.get_directory())
+              {
+                cr::out().debug("using build cache directory: {}", cache_directory.c_str());
+                cache.set_directory(std::move(cache_directory));
+              }
             });
 
             // call the on-conf changed events:
@@ -390,6 +551,21 @@ namespace neam::resources
   context::status_chain context::add_index(id_t index_id, id_t index_fid)
   {
     check::debug::n_assert(has_index, "Trying to combines indexes while no index has been ever loaded. Are you loading and combining right away?");
+
+    // mapped indexes are used in-place from a mapping of the file (entries and embedded data are only paged-in when used)
+    if (std::string path = get_io_file_path(index_fid); !path.empty() && index::is_mapped_index_file(path))
+    {
+      status_chain chn;
+      ctx.tm.get_long_duration_task([this, index_id, index_fid, path = std::move(path), state = chn.create_state()] mutable
+      {
+        bool has_rejected_entries = false;
+        root.add_index(index::map_index_file(index_id, path, &has_rejected_entries));
+        neam::cr::out().debug("Additively loaded (mapped) index: {} [combined index contains {} entries]", io_context.get_string_for_id(index_fid), root.entry_count());
+        state.complete(has_rejected_entries ? status::partial_success : status::success);
+      });
+      return chn;
+    }
+
     return io_context.queue_read(index_fid, 0, io::context::whole_file)
            .then([=, this](raw_data&& data, bool success, size_t)
     {
@@ -397,7 +573,7 @@ namespace neam::resources
           return status::failure;
 
       bool has_rejected_entries = false;
-      root.add_index(index::read_index(index_id, data, &has_rejected_entries));
+      root.add_index(index::read_index(index_id, std::move(data), &has_rejected_entries));
       neam::cr::out().debug("Additively loaded index: {} [combined index contains {} entries]", io_context.get_string_for_id(index_fid), root.entry_count());
       return has_rejected_entries ? status::partial_success : status::success;
     });
@@ -449,6 +625,8 @@ namespace neam::resources
 
   async::chain<bool> context::has_resource(id_t rid) const
   {
+    if (is_connected())
+      return remote->has_resource(rid);
     return async::chain<bool>::create_and_complete(is_index_loaded() && root.has_entry(rid));
   }
 
@@ -468,7 +646,8 @@ namespace neam::resources
 
   context::status_chain context::write_index(id_t file_id, const index& idx) const
   {
-    return io_context.queue_write(file_id, io::context::truncate, idx.serialize_index())
+    const index_format format = configuration.use_mapped_index_format ? index_format::mapped : index_format::xored;
+    return io_context.queue_write(file_id, io::context::truncate, idx.serialize_index(format))
       .then([](raw_data&& data, bool success, size_t write_size) { return success && write_size == data.size ? status::success : status::failure; });
   }
 
@@ -511,6 +690,9 @@ namespace neam::resources
 
   bool context::is_resource_immediatly_available(id_t rid) const
   {
+    if (is_connected())
+      return false;
+
     std::lock_guard _l { spinlock_shared_adapter::adapt(root._get_lock()) };
     const index::entry entry = root.get_entry(rid);
     if (!root.has_entry(rid) || !entry.is_valid())
@@ -526,36 +708,117 @@ namespace neam::resources
     return false;
   }
 
-  io::context::read_chain context::read_raw_resource(id_t rid) const
+  bool context::get_data_entry(id_t rid, index::entry& entry) const
   {
-    std::lock_guard _l { spinlock_shared_adapter::adapt(root._get_lock()) };
-    const index::entry entry = root.get_entry(rid);
+    entry = root.get_entry(rid);
     if (!root.has_entry(rid) || !entry.is_valid())
     {
       cr::out().warn("failed to load resource: {}: resource does not exist", resource_name(rid));
-      return io::context::read_chain::create_and_complete({}, false, 0);
+      return false;
     }
     if (((entry.flags & flags::type_mask) != flags::type_data))
     {
       cr::out().warn("failed to load resource: {}: resource exists but is not a data resource", resource_name(rid));
+      return false;
+    }
+    return true;
+  }
+
+  io::context::read_chain context::read_remote_resource(id_t rid) const
+  {
+    return remote->read_raw_resource(rid).then([this, rid](raw_data&& data, bool is_compressed, bool success)
+    {
+      if (!success || async::is_current_chain_canceled())
+      {
+        if (!success)
+          cr::out().warn("failed to load resource: {} (remote read failed)", resource_name(rid));
+        return io::context::read_chain::create_and_complete({}, false, 0);
+      }
+
+      if (!is_compressed)
+      {
+        cr::out().debug("loaded resource: {} [size: {}b] (from resource server)", resource_name(rid), data.size);
+        const uint32_t size = (uint32_t)data.size;
+        return io::context::read_chain::create_and_complete(std::move(data), true, size);
+      }
+#if N_RES_LZMA_COMPRESSION
+      return uncompress(std::move(data), compressor_dispatcher, threading::k_non_transient_task_group, true /* high prio */)
+             .then([rid, this](raw_data&& data)
+      {
+        cr::out().debug("loaded resource: {} [size: {}b] (uncompressed, from resource server)", resource_name(rid), data.size);
+        const uint32_t size = (uint32_t)data.size;
+        return io::context::read_chain::create_and_complete(std::move(data), true, size);
+      });
+#else
+      neam::cr::out().error("read_raw_resource: trying to read a compressed resource without LZMA support");
+      return io::context::read_chain::create_and_complete({}, false, 0);
+#endif // N_RES_LZMA_COMPRESSION
+    });
+  }
+
+  io::context::read_chain context::_read_stored_resource(id_t rid, bool& is_compressed) const
+  {
+    is_compressed = false;
+
+    std::lock_guard _l { spinlock_shared_adapter::adapt(root._get_lock()) };
+    index::entry entry;
+    if (!get_data_entry(rid, entry))
+      return io::context::read_chain::create_and_complete({}, false, 0);
+
+    is_compressed = ((entry.flags & flags::compressed) != flags::none);
+
+    if ((entry.flags & flags::embedded_data) != flags::none)
+    {
+      if (const auto view = root.get_embedded_data_view(rid); view)
+      {
+        raw_data embedded = raw_data::allocate(view->size());
+        memcpy(embedded.data.get(), view->data(), view->size());
+        const uint32_t size = (uint32_t)embedded.size;
+        return io::context::read_chain::create_and_complete(std::move(embedded), true, size);
+      }
+      cr::out().warn("failed to load resource: {}: was marked as embedded data but no embedded data found", resource_name(rid));
+      return io::context::read_chain::create_and_complete({}, false, 0);
+    }
+
+    if (!io_context.is_file_mapped(entry.pack_file))
+    {
+      cr::out().warn("failed to load resource: {}: pack file is not in the file-map", resource_name(rid));
       return io::context::read_chain::create_and_complete({}, false, 0);
     }
 
+    return io_context.queue_read(entry.pack_file, entry.offset,
+                                 (entry.flags & flags::standalone_file) != flags::none ? io::context::whole_file : entry.size);
+  }
+
+  io::context::read_chain context::read_raw_resource(id_t rid) const
+  {
+    if (is_connected())
+      return read_remote_resource(rid);
+
+    std::lock_guard _l { spinlock_shared_adapter::adapt(root._get_lock()) };
+    index::entry entry;
+    if (!get_data_entry(rid, entry))
+      return io::context::read_chain::create_and_complete({}, false, 0);
+
     const bool is_compressed = ((entry.flags & flags::compressed) != flags::none);
 
     // check for embedded data, as it's data already in memory
     if ((entry.flags & flags::embedded_data) != flags::none)
     {
-      if (const raw_data* data = root.get_embedded_data(rid); data != nullptr)
+      if (const auto view = root.get_embedded_data_view(rid); view)
       {
-        // duplicate and return the data
+        // copy the data (it can live in a mapped index, so we avoid materializing a raw_data in the index)
+        raw_data embedded = raw_data::allocate(view->size());
+        memcpy(embedded.data.get(), view->data(), view->size());
+
         if (!is_compressed)
         {
-          cr::out().debug("loaded resource: {} [size: {}b] (from embedded data)", resource_name(rid), data->size);
-          return io::context::read_chain::create_and_complete(raw_data::duplicate(*data), true, data->size);
+          cr::out().debug("loaded resource: {} [size: {}b] (from embedded data)", resource_name(rid), embedded.size);
+          const size_t size = embedded.size;
+          return io::context::read_chain::create_and_complete(std::move(embedded), true, size);
         }
 #if N_RES_LZMA_COMPRESSION
-        return uncompress(data->duplicate(), compressor_dispatcher, threading::k_non_transient_task_group)
+        return uncompress(std::move(embedded), compressor_dispatcher, threading::k_non_transient_task_group)
                .then([rid, this](raw_data && data)
         {
           cr::out().debug("loaded resource: {} [size: {}b] (uncompressed, from embedded data)", resource_name(rid), data.size);
@@ -634,6 +897,64 @@ namespace neam::resources
     }
   }
 
+  context::status_chain context::read_raw_resource_into(id_t rid, destination_allocator_t&& allocate_destination) const
+  {
+    // NOTE: remote resources are always uncompressed by read_remote_resource
+    bool is_compressed = false;
+    io::context::read_chain chn = is_connected() ? read_remote_resource(rid) : _read_stored_resource(rid, is_compressed);
+
+    return chn.then([this, rid, is_compressed, allocate_destination = std::move(allocate_destination)](raw_data&& data, bool success, uint32_t) mutable
+    {
+      // NOTE: failures are already reported by the read functions
+      if (!success || async::is_current_chain_canceled())
+        return status_chain::create_and_complete(status::failure);
+
+      if (!is_compressed)
+      {
+        const std::span<uint8_t> destination = allocate_destination(data.size);
+        if (destination.size() < data.size)
+        {
+          cr::out().warn("failed to load resource: {}: could not allocate {} bytes of destination memory", resource_name(rid), data.size);
+          return status_chain::create_and_complete(status::failure);
+        }
+        memcpy(destination.data(), data.data.get(), data.size);
+        cr::out().debug("loaded resource: {} [size: {}b]", resource_name(rid), data.size);
+        return status_chain::create_and_complete(status::success);
+      }
+
+#if N_RES_LZMA_COMPRESSION
+      status_chain ret;
+      compressor_dispatcher.dispatch(threading::k_non_transient_task_group,
+                                     [this, rid, data = std::move(data), allocate_destination = std::move(allocate_destination), state = ret.create_state()]() mutable
+      {
+        if (state.is_canceled())
+          return;
+
+        const uint64_t size = get_uncompressed_size(data);
+        const std::span<uint8_t> destination = allocate_destination(size);
+        if (destination.size() < size)
+        {
+          cr::out().warn("failed to load resource: {}: could not allocate {} bytes of destination memory", resource_name(rid), size);
+          state.complete(status::failure);
+          return;
+        }
+        if (!uncompress_into(std::move(data), destination.first(size)))
+        {
+          cr::out().warn("failed to load resource: {} (failed to uncompress)", resource_name(rid));
+          state.complete(status::failure);
+          return;
+        }
+        cr::out().debug("loaded resource: {} [size: {}b] (uncompressed)", resource_name(rid), size);
+        state.complete(status::success);
+      }, true /* high prio */);
+      return ret;
+#else
+      neam::cr::out().error("read_raw_resource_into: trying to read a compressed resource without LZMA support");
+      return status_chain::create_and_complete(status::failure);
+#endif // N_RES_LZMA_COMPRESSION
+    });
+  }
+
   context::status_chain context::write_raw_resource(id_t rid, raw_data&& data)
   {
     std::lock_guard _l { spinlock_shared_adapter::adapt(root._get_lock()) };
@@ -665,7 +986,7 @@ namespace neam::resources
       else
       {
 #if N_RES_LZMA_COMPRESSION
-        return compress(std::move(data), compressor_dispatcher, threading::k_non_transient_task_group)
+        return compress(std::move(data), compressor_dispatcher, threading::k_non_transient_task_group, false, get_default_codec())
         .then([this, rid](raw_data&& data)
         {
           return io_context.queue_write(rid, io::context::truncate, std::move(data)).then([](raw_data&& data, bool success, size_t write_size)
@@ -694,6 +1015,20 @@ namespace neam::resources
 
   context::status_chain context::reload_index(id_t index_id, id_t fid)
   {
+    // mapped indexes are used in-place from a mapping of the file (entries and embedded data are only paged-in when used)
+    if (std::string path = get_io_file_path(fid); !path.empty() && index::is_mapped_index_file(path))
+    {
+      status_chain chn;
+      ctx.tm.get_long_duration_task([this, index_id, fid, path = std::move(path), state = chn.create_state()] mutable
+      {
+        bool has_rejected_entries = false;
+        root = index::map_index_file(index_id, path, &has_rejected_entries);
+        neam::cr::out().debug("loaded (mapped) index: {} [contains {} entries]", io_context.get_string_for_id(fid), root.entry_count());
+        finish_reload_index(fid, has_rejected_entries).use_state(state);
+      });
+      return chn;
+    }
+
     return io_context.queue_read(fid, 0, io::context::whole_file)
            .then([=, this](raw_data&& data, bool success, size_t)
     {
@@ -704,27 +1039,50 @@ namespace neam::resources
       }
 
       bool has_rejected_entries = false;
-      {
-        root = index::read_index(index_id, data, &has_rejected_entries);
-        neam::cr::out().debug("loaded index: {} [contains {} entries]", io_context.get_string_for_id(fid), root.entry_count());
-        has_index = true;
-        index_file_id = fid;
-      }
+      // mapped indexes that could not be mapped from the file take ownership of the data and use it in-place
+      root = index::read_index(index_id, std::move(data), &has_rejected_entries);
+      neam::cr::out().debug("loaded index: {} [contains {} entries]", io_context.get_string_for_id(fid), root.entry_count());
+      return finish_reload_index(fid, has_rejected_entries);
+    });
+  }
 
-      // grab the embedded file-map, if any:
-      return load_file_map(k_boot_file_map)
-      .then([has_rejected_entries](status fm_st)
-      {
-        if (fm_st == status::success)
-          cr::out().debug("Loaded index file-map successfuly");
-        else
-          cr::out().log("Could not apply index file-map");
+  context::status_chain context::finish_reload_index(id_t fid, bool has_rejected_entries)
+  {
+    has_index = true;
+    index_file_id = fid;
 
-        return (has_rejected_entries || fm_st != status::success) ? status::partial_success : status::success;
-      });
+    // grab the embedded file-map, if any:
+    return load_file_map(k_boot_file_map)
+    .then([has_rejected_entries](status fm_st)
+    {
+      if (fm_st == status::success)
+        cr::out().debug("Loaded index file-map successfuly");
+      else
+        cr::out().log("Could not apply index file-map");
+
+      return (has_rejected_entries || fm_st != status::success) ? status::partial_success : status::success;
     });
   }
 
+  std::string context::get_io_file_path(id_t fid) const
+  {
+    // the file can have been mapped with or without the prefix: use the first path that exists
+    const std::filesystem::path name = io_context.get_string_for_id(fid);
+    if (name.empty())
+      return {};
+
+    std::error_code ec;
+    if (const std::string& io_prefix = io_context.get_prefix_directory(); !io_prefix.empty() && name.is_relative())
+    {
+      const std::filesystem::path prefixed = std::filesystem::path(io_prefix) / name;
+      if (std::filesystem::is_regular_file(prefixed, ec))
+        return prefixed.string();
+    }
+    if (std::filesystem::is_regular_file(name, ec))
+      return name.string();
+    return {};
+  }
+
   void context::apply_file_map(const file_map& fm, bool additive)
   {
     std::lock_guard _l(file_map_lock);
@@ -960,12 +1318,12 @@ namespace neam::resources
         return;
       }
 
-      db.set_processor_for_file(resource, processor::get_processor_hash(data, resource));
-      proc(ctx, {resource, std::move(data), std::move(metadata), db}).use_state(state);
+      const id_t processor_hash = processor::get_processor_hash(data, resource);
+      db.set_processor_for_file(resource, processor_hash);
+      run_processor(proc, processor_hash, {resource, std::move(data), std::move(metadata), db}).use_state(state);
     });
     return chn.then([=, this](processor::processed_data&& pd, status s)
     {
-      // FIXME: should handle caching results to avoid re-processing data
       cr::out()./*debug*/log("import: processed resource {} (with {} entries to pack and {} to further process)", resource.c_str(), pd.to_pack.size(), pd.to_process.size());
 
       // maintain the db state, even in case of import failure
@@ -1022,9 +1380,9 @@ namespace neam::resources
     cr::out().debug("pack_resource: resource {}: type: {}", resource_name(proc_data.resource_id), proc_data.resource_type);
 
     packer::chain chain;
-    ctx.tm.get_long_duration_task([pack, this, proc_data = std::move(proc_data), state = chain.create_state()]() mutable
+    ctx.tm.get_long_duration_task([pack, packer_hash, this, proc_data = std::move(proc_data), state = chain.create_state()]() mutable
     {
-      pack(ctx, std::move(proc_data)).use_state(state);
+      run_packer(pack, packer_hash, std::move(proc_data)).use_state(state);
     });
     struct post_compression_data
     {
@@ -1066,7 +1424,7 @@ namespace neam::resources
             && (v[i].mode == packer::mode_t::data) && !resource_metadata.skip_compression)
         {
           // compress
-          compress_chains.push_back(compress(std::move(v[i].data), compressor_dispatcher, threading::k_non_transient_task_group)
+          compress_chains.push_back(compress(std::move(v[i].data), compressor_dispatcher, threading::k_non_transient_task_group, false, get_resource_codec(resource_metadata))
           .then([i, d = std::move(v[i])](raw_data&& data) mutable
           {
             d.data = std::move(data);
@@ -1307,6 +1665,184 @@ namespace neam::resources
     });
   }
 
+  processor::chain context::run_processor(processor::function proc, id_t processor_hash, processor::input_data&& input)
+  {
+    if (!cache.is_enabled())
+      return proc(ctx, std::move(input));
+
+    const std::string file = input.file;
+    build_cache::key_t key = build_cache::make_key(
+    {
+      "processor"_rid, processor_hash,
+      string_id::_runtime_build_from_string(file.c_str(), file.size()),
+    },
+    {
+      build_cache::hash(input.file_data),
+      build_cache::hash(rle::serialize(input.metadata)),
+    });
+
+    return cache.lookup(key).then([this, proc, key = std::move(key), file, input = std::move(input)](raw_data&& entry, bool hit) mutable
+    {
+      internal::cached_processor_output_t cached;
+      if (hit && rle::in_place_deserialize(entry, cached) == rle::status::success)
+      {
+        cr::out().debug("import_resource: resource {}: using build cache entry {}", file, key.to_string());
+
+        processor::processed_data pd;
+        pd.to_pack.reserve(cached.to_pack.size());
+        pd.to_process.reserve(cached.to_process.size());
+        const auto restore_metadata = [&input](const raw_data& rd, bool has_source_metadata_file)
+        {
+          metadata_t metadata = metadata_t::deserialize(rd);
+          if (has_source_metadata_file)
+          {
+            metadata.file_id = input.metadata.file_id;
+            metadata.initial_hash = input.metadata.initial_hash;
+          }
+          return metadata;
+        };
+        for (auto& it : cached.to_pack)
+        {
+          db.resource_name(it.resource_id, std::move(it.resource_name));
+          pd.to_pack.push_back(
+          {
+            .resource_id = string_id::_from_id_t(it.resource_id),
+            .resource_type = string_id::_from_id_t(it.resource_type),
+            .data = std::move(it.data),
+            .metadata = restore_metadata(it.metadata, it.has_source_metadata_file),
+            .db = db,
+          });
+        }
+        for (auto& it : cached.to_process)
+          pd.to_process.push_back({ it.file, std::move(it.file_data), restore_metadata(it.metadata, it.has_source_metadata_file), db });
+        return processor::chain::create_and_complete(std::move(pd), cached.st);
+      }
+
+      // the lookup completes on the io thread, the processor has to run in a long-duration task
+      processor::chain chn;
+      ctx.tm.get_long_duration_task([this, proc, key = std::move(key), file, input = std::move(input), state = chn.create_state()]() mutable
+      {
+        const id_t source_metadata_file = input.metadata.file_id;
+        cr::chrono chrono;
+        proc(ctx, std::move(input)).then([this, key = std::move(key), file, source_metadata_file, chrono, state = std::move(state)](processor::processed_data&& pd, status s) mutable
+        {
+          // failures are never cached, and processors that read other files cannot be keyed only on their input
+          if (s != status::failure && !db.has_file_dependencies(file))
+          {
+            internal::cached_processor_output_t cached { .st = s };
+            cached.to_pack.reserve(pd.to_pack.size());
+            cached.to_process.reserve(pd.to_process.size());
+            for (const auto& it : pd.to_pack)
+            {
+              cached.to_pack.push_back(
+              {
+                .resource_id = it.resource_id,
+                .resource_name = db.resource_name(it.resource_id),
+                .resource_type = it.resource_type,
+                .data = it.data.duplicate(),
+                .metadata = rle::serialize(it.metadata),
+                .has_source_metadata_file = source_metadata_file != id_t::invalid && it.metadata.file_id == source_metadata_file,
+              });
+            }
+            for (const auto& it : pd.to_process)
+            {
+              cached.to_process.push_back(
+              {
+                .file = it.file,
+                .file_data = it.file_data.duplicate(),
+                .metadata = rle::serialize(it.metadata),
+                .has_source_metadata_file = source_metadata_file != id_t::invalid && it.metadata.file_id == source_metadata_file,
+              });
+            }
+            cache.store(key, rle::serialize(cached), chrono.get_accumulated_time());
+          }
+          state.complete(std::move(pd), s);
+        });
+      });
+      return chn;
+    });
+  }
+
+  packer::chain context::run_packer(packer::function pack, id_t packer_hash, processor::data&& proc_data)
+  {
+    if (!cache.is_enabled())
+      return pack(ctx, std::move(proc_data));
+
+    build_cache::key_t key = build_cache::make_key(
+    {
+      "packer"_rid, packer_hash,
+      proc_data.resource_type, proc_data.resource_id,
+    },
+    {
+      build_cache::hash(proc_data.data),
+      build_cache::hash(rle::serialize(proc_data.metadata)),
+    });
+
+    return cache.lookup(key).then([this, pack, key = std::move(key), proc_data = std::move(proc_data)](raw_data&& entry, bool hit) mutable
+    {
+      internal::cached_packer_output_t cached;
+      if (hit && rle::in_place_deserialize(entry, cached) == rle::status::success)
+      {
+        cr::out().debug("pack_resource: resource {}: using build cache entry {}", resource_name(proc_data.resource_id), key.to_string());
+
+        db.resource_name(cached.pack_id, std::move(cached.pack_name));
+        std::vector<packer::data> v;
+        v.reserve(cached.entries.size());
+        for (auto& it : cached.entries)
+        {
+          db.resource_name(it.id, std::move(it.resource_name));
+          metadata_t metadata = metadata_t::deserialize(it.metadata);
+          if (it.has_source_metadata_file)
+          {
+            metadata.file_id = proc_data.metadata.file_id;
+            metadata.initial_hash = proc_data.metadata.initial_hash;
+          }
+          v.push_back(
+          {
+            .id = it.id,
+            .data = std::move(it.data),
+            .metadata = std::move(metadata),
+            .simlink_to_id = it.simlink_to_id,
+            .mode = it.mode,
+          });
+        }
+        return packer::chain::create_and_complete(std::move(v), cached.pack_id, cached.st);
+      }
+
+      // the lookup completes on the io thread, the packer has to run in a long-duration task
+      packer::chain chn;
+      ctx.tm.get_long_duration_task([this, pack, key = std::move(key), proc_data = std::move(proc_data), state = chn.create_state()]() mutable
+      {
+        const id_t source_metadata_file = proc_data.metadata.file_id;
+        cr::chrono chrono;
+        pack(ctx, std::move(proc_data)).then([this, key = std::move(key), source_metadata_file, chrono, state = std::move(state)](std::vector<packer::data>&& v, id_t pack_id, status s) mutable
+        {
+          if (s != status::failure)
+          {
+            internal::cached_packer_output_t cached { .pack_id = pack_id, .pack_name = db.resource_name(pack_id), .st = s };
+            cached.entries.reserve(v.size());
+            for (const auto& it : v)
+            {
+              cached.entries.push_back(
+              {
+                .id = it.id,
+                .resource_name = db.resource_name(it.id),
+                .data = it.data.duplicate(),
+                .metadata = rle::serialize(it.metadata),
+                .has_source_metadata_file = source_metadata_file != id_t::invalid && it.metadata.file_id == source_metadata_file,
+                .simlink_to_id = it.simlink_to_id,
+                .mode = it.mode,
+              });
+            }
+            cache.store(key, rle::serialize(cached), chrono.get_accumulated_time());
+          }
+          state.complete(std::move(v), pack_id, s);
+        });
+      });
+      return chn;
+    });
+  }
+
   async::continuation_chain context::on_source_file_removed(const std::filesystem::path& file, bool reimport)
   {
     check::debug::n_assert(has_rel_db, "cannot handle a removed source file without a rel db present");
@@ -1335,6 +1871,290 @@ namespace neam::resources
     });
   }
 
+  codec context::get_default_codec() const
+  {
+    return get_codec_from_name(configuration.default_codec, codec::lzma);
+  }
+
+  codec context::get_resource_codec(const default_resource_metadata_t& resource_metadata) const
+  {
+    return get_codec_from_name(resource_metadata.compression_codec, get_default_codec());
+  }
+
+  bool context::is_entry_compressible(const index::entry& e) const
+  {
+#if N_RES_LZMA_COMPRESSION
+    if ((e.flags & (flags::compressed | flags::incompressible | flags::embedded_data | flags::standalone_file)) != flags::none)
+      return false;
+    return e.size >= configuration.min_size_to_compress;
+#else
+    (void)e;
+    return false;
+#endif
+  }
+
+  bool context::pack_file_needs_repack(const std::vector<index::entry>& entries) const
+  {
+    // metadata are never compressed (see _pack_resource)
+    std::set<id_t> metadata_ids;
+    for (const auto& e : entries)
+      metadata_ids.insert(specialize(e.id, "metadata"));
+
+    uint64_t used_size = 0;
+    uint64_t end_offset = 0;
+    for (const auto& e : entries)
+    {
+      if (!metadata_ids.contains(e.id) && is_entry_compressible(e))
+        return true;
+      used_size += e.size;
+      end_offset = std::max(end_offset, e.offset + e.size);
+    }
+
+    // holes (or overlapping entries, which should not happen):
+    // (holes at the end of the file are not detected, but they cost nothing more than disk space)
+    return used_size != end_offset;
+  }
+
+  context::status_chain context::repack_data(uint32_t max_pack_files)
+  {
+    check::debug::n_assert(has_index, "Trying to repack while no index has been ever loaded.");
+    if (repack_in_progress.exchange(true))
+    {
+      cr::out().warn("repack_data: a repack operation is already in progress");
+      return status_chain::create_and_complete(status::failure);
+    }
+    repack_cancel_requested = false;
+
+    // gather the pack files with their live entries:
+    std::map<id_t, std::vector<index::entry>> pack_files;
+    root.for_each_entry([&pack_files](const index::entry& e)
+    {
+      if ((e.flags & flags::type_mask) != flags::type_data)
+        return;
+      if ((e.flags & (flags::standalone_file | flags::embedded_data)) != flags::none)
+        return;
+      if (e.pack_file == id_t::none || e.pack_file == id_t::invalid)
+        return;
+      pack_files[e.pack_file].push_back(e);
+    });
+
+    std::vector<repack_pack_file_t> to_repack;
+    for (auto& it : pack_files)
+    {
+      if (max_pack_files > 0 && to_repack.size() >= max_pack_files)
+        break;
+      if (!io_context.is_file_mapped(it.first) || !pack_file_needs_repack(it.second))
+        continue;
+      to_repack.push_back({ .pack_file = it.first, .entries = std::move(it.second) });
+    }
+
+    cr::out().log("repack_data: {} pack-files to repack (out of {} pack-files)", to_repack.size(), pack_files.size());
+    if (to_repack.empty())
+    {
+      repack_in_progress = false;
+      return status_chain::create_and_complete(status::success);
+    }
+
+    return repack_next_pack_file(std::move(to_repack), 0, status::success);
+  }
+
+  context::status_chain context::repack_next_pack_file(std::vector<repack_pack_file_t>&& pack_files, size_t pack_index, status st)
+  {
+    if (pack_index >= pack_files.size() || repack_cancel_requested)
+    {
+      if (pack_index < pack_files.size())
+        cr::out().log("repack_data: cancelled after {} pack-files (out of {})", pack_index, pack_files.size());
+
+      // save the progress, even when cancelled:
+      return save_index().then([this, st, pack_index](status save_st)
+      {
+        repack_in_progress = false;
+        cr::out().log("repack_data: repacked {} pack-files", pack_index);
+        return worst(st, save_st);
+      });
+    }
+
+    const id_t pack_file = pack_files[pack_index].pack_file;
+    std::vector<index::entry> entries = std::move(pack_files[pack_index].entries);
+    return repack_pack_file(pack_file, std::move(entries))
+    .then([this, pack_files = std::move(pack_files), pack_index, st](status pack_st) mutable
+    {
+      return repack_next_pack_file(std::move(pack_files), pack_index + 1, worst(st, pack_st));
+    });
+  }
+
+  context::status_chain context::repack_pack_file(id_t pack_file, std::vector<index::entry>&& entries)
+  {
+    // keep the file order (metadata are at the end of the file)
+    std::sort(entries.begin(), entries.end(), [](const index::entry& a, const index::entry& b) { return a.offset < b.offset; });
+
+    // pack-files are named after their pack-id, and the new one must not collide with the old one
+    const std::string new_filename = fmt::format("res-{:X}{}", std::to_underlying(specialize(pack_file, "repack")), k_pack_extension);
+
+    return io_context.queue_read(pack_file, 0, io::context::whole_file)
+    .then([=, this, entries = std::move(entries)](raw_data&& pack_data, bool success, size_t) mutable
+    {
+      if (!success)
+      {
+        cr::out().error("repack_data: failed to read pack-file {}", io_context.get_string_for_id(pack_file));
+        return status_chain::create_and_complete(status::failure);
+      }
+
+      struct repack_entry_t
+      {
+        index::entry original;
+        raw_data data;
+        bool is_compressed = false;
+        bool is_incompressible = false;
+      };
+
+      std::vector<repack_entry_t> repacked;
+      std::map<id_t, uint32_t> entry_indices;
+      std::set<id_t> metadata_ids;
+      repacked.reserve(entries.size());
+      for (const auto& e : entries)
+      {
+        if (e.offset + e.size > pack_data.size)
+        {
+          cr::out().warn("repack_data: removing resource {}: resource data is out of the bounds of its pack-file", resource_name(e.id));
+          root.remove_entry(e.id);
+          continue;
+        }
+        raw_data data = raw_data::allocate(e.size);
+        memcpy(data.data.get(), (const uint8_t*)pack_data.data.get() + e.offset, e.size);
+        entry_indices.emplace(e.id, (uint32_t)repacked.size());
+        metadata_ids.insert(specialize(e.id, "metadata"));
+        repacked.push_back({ .original = e, .data = std::move(data) });
+      }
+
+      // launch compression tasks for what can be compressed
+      std::vector<async::chain<raw_data, uint32_t>> compress_chains;
+#if N_RES_LZMA_COMPRESSION
+      for (uint32_t i = 0; i < repacked.size(); ++i)
+      {
+        const index::entry& e = repacked[i].original;
+        // metadata are never compressed (see _pack_resource)
+        if (metadata_ids.contains(e.id) || !is_entry_compressible(e))
+          continue;
+
+        default_resource_metadata_t resource_metadata;
+        if (const auto md_it = entry_indices.find(specialize(e.id, "metadata")); md_it != entry_indices.end())
+          metadata_t::deserialize(repacked[md_it->second].data).try_get<default_resource_metadata_t>(resource_metadata);
+        if (resource_metadata.skip_compression)
+        {
+          repacked[i].is_incompressible = true;
+          continue;
+        }
+
+        compress_chains.push_back(compress(raw_data::duplicate(repacked[i].data), compressor_dispatcher, threading::k_non_transient_task_group, false, get_resource_codec(resource_metadata))
+        .then([i](raw_data&& data)
+        {
+          return async::chain<raw_data, uint32_t>::create_and_complete(std::move(data), i);
+        }));
+      }
+#endif // N_RES_LZMA_COMPRESSION
+
+      return async::multi_chain(std::move(repacked), std::move(compress_chains), [](auto& state, raw_data&& data, uint32_t index)
+      {
+        // only keep the compressed data if it's worth it:
+        if (data.size > 0 && data.size < state[index].data.size)
+        {
+          state[index].data = std::move(data);
+          state[index].is_compressed = true;
+        }
+        else
+        {
+          state[index].is_incompressible = true;
+        }
+      })
+      .then([=, this](std::vector<repack_entry_t>&& repacked)
+      {
+        // build the new pack-file:
+        uint64_t new_size = 0;
+        for (const auto& it : repacked)
+          new_size += it.data.size;
+
+        raw_data new_pack_data = raw_data::allocate(new_size);
+        std::vector<std::pair<index::entry, index::entry>> entry_updates; // original, updated
+        entry_updates.reserve(repacked.size());
+
+        const id_t new_pack_file = io_context.map_file(new_filename);
+        uint64_t offset = 0;
+        for (const auto& it : repacked)
+        {
+          memcpy((uint8_t*)new_pack_data.data.get() + offset, it.data.data.get(), it.data.size);
+          index::entry updated = it.original;
+          updated.pack_file = new_pack_file;
+          updated.offset = offset;
+          updated.size = it.data.size;
+          if (it.is_compressed)
+            updated.flags |= flags::compressed;
+          if (it.is_incompressible)
+            updated.flags |= flags::incompressible;
+          entry_updates.emplace_back(it.original, updated);
+          offset += it.data.size;
+        }
+
+        return io_context.queue_write(new_pack_file, io::context::truncate, std::move(new_pack_data))
+        .then([=, this, entry_updates = std::move(entry_updates)](raw_data&& data, bool success, size_t write_size)
+        {
+          if (!success || write_size != data.size)
+          {
+            cr::out().error("repack_data: failed to write pack-file: {}", new_filename);
+            io_context.unmap_file(new_pack_file);
+            return status_chain::create_and_complete(status::failure);
+          }
+
+          // switch the index entries to the new pack-file. Entries that changed while we were repacking are left untouched.
+          index updated_entries(root.get_index_id());
+          uint32_t skipped_count = 0;
+          uint64_t old_size = 0;
+          for (const auto& it : entry_updates)
+          {
+            const index::entry current = root.get_raw_entry(it.first.id);
+            if (current.pack_file != it.first.pack_file || current.offset != it.first.offset
+                || current.size != it.first.size || current.flags != it.first.flags)
+            {
+              ++skipped_count;
+              continue;
+            }
+            old_size += it.first.size;
+            updated_entries.add_entry(it.second);
+          }
+
+          if (updated_entries.entry_count() == 0)
+          {
+            // everything changed (re-import / removal), the new pack-file is useless
+            cr::out().debug("repack_data: pack-file {} changed while being repacked, skipping it", io_context.get_string_for_id(pack_file));
+            return io_context.queue_deferred_remove(new_pack_file).then([this, new_pack_file](bool)
+            {
+              io_context.unmap_file(new_pack_file);
+              return status::success;
+            });
+          }
+
+          root.add_index(std::move(updated_entries));
+          if (has_rel_db)
+            db.replace_pack_file(pack_file, new_pack_file);
+          add_to_file_map(new_filename);
+
+          cr::out().debug("repack_data: repacked {} into {}: {} -> {} bytes{}", io_context.get_string_for_id(pack_file), new_filename,
+                          old_size, data.size, skipped_count > 0 ? " (some entries changed while repacking, the pack-file still contains holes)" : "");
+
+          if (skipped_count > 0)
+            return status_chain::create_and_complete(status::partial_success);
+
+          // no entry references the old pack-file anymore, remove it:
+          return io_context.queue_deferred_remove(pack_file).then([this, pack_file](bool)
+          {
+            remove_from_file_map({ pack_file });
+            return status::success;
+          });
+        });
+      });
+    });
+  }
+
   std::set<std::filesystem::path> context::get_sources_needing_reimport() const
   {
     check::debug::n_assert(has_rel_db, "cannot return sources needing reimport without a rel db present");
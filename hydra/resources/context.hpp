@@ -34,14 +34,23 @@
 #include <ntools/macro.hpp>
 #include <ntools/threading/utilities/rate_limit.hpp>
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <span>
+
 #include <hydra/engine/conf/conf.hpp>
 
 #include "enums.hpp"
+#include "compressor.hpp"
 #include "asset.hpp"
 #include "index.hpp"
 #include "concepts.hpp"
 #include "file_map.hpp"
 #include "rel_db.hpp"
+#include "processor.hpp"
+#include "packer.hpp"
+#include "build_cache.hpp"
 
 namespace neam::hydra { class core_context; }
 
@@ -56,6 +65,11 @@ namespace neam::resources
     uint32_t max_size_to_embed = 64;
     uint32_t min_size_to_compress = 256;
     bool enable_background_compression = true;
+    std::string default_codec = "lzma";
+
+    bool use_mapped_index_format = true;
+
+    std::string build_cache_directory = "local/build-cache";
   };
 }
 
@@ -109,6 +123,26 @@ N_METADATA_STRUCT(neam::resources::resource_configuration)
        "A list of resources needing compression can then be generated and the context has the capability to repack and compress those resources\n"
        "\n"
        "If false, imported resources will wait to go through compression before being writen to disk (which can be slow)\n"
+      >}),
+    N_MEMBER_DEF(default_codec, neam::metadata::info{.description = c_string_t
+      <
+       "Codec used to compress resources that don't specify one in their metadata.\n"
+       "Possible values: `lzma` (best ratio, slow decompression) and `zstd` (slightly worse ratio, much faster decompression).\n"
+       "Codecs that are not supported by the build fallback to `lzma`. Changing the codec only affects newly compressed resources."
+      >}),
+    N_MEMBER_DEF(use_mapped_index_format, neam::metadata::info{.description = c_string_t
+      <
+       "If true (the default), indexes will be saved in the mapped format, which is mmap-ed and used in-place when loaded (no decoding of the whole index on boot)\n"
+       "If false, indexes are saved in the legacy xored format\n"
+       "Blocks are obfuscated only if the build has obfuscation enabled, and are then decoded on first access\n"
+       "Both formats can always be loaded, independently of this setting"
+      >}),
+    N_MEMBER_DEF(build_cache_directory, neam::metadata::info{.description = c_string_t
+      <
+       "Directory of the content-addressed build cache (relative to the index directory, or absolute). Empty to disable the cache.\n"
+       "Processor and packer outputs are stored there, keyed on their input data, metadata and version,\n"
+       "so identical sources are never processed twice, even after a checkout or a touch.\n"
+       "The directory can be shared between machines (entries are immutable and written atomically) and can safely be deleted."
       >})
 
   >;
@@ -125,6 +159,7 @@ namespace neam::resources
     bool strip_from_final_build = false;
     bool embed_in_index = false;
     bool skip_compression = false;
+    std::string compression_codec = {};
   };
 }
 
@@ -152,15 +187,21 @@ N_METADATA_STRUCT(neam::resources::default_resource_metadata_t)
       "NOTE: LZMA compression disabled, flag will not do anything as everything will skip compression.\n"
       "Flag will be saved an honored when compression is enabled in the build.\n"
 #endif
+      >}),
+    N_MEMBER_DEF(compression_codec, neam::metadata::info{.description = c_string_t
+      <
+      "Codec to use to compress this resource (`lzma` or `zstd`).\n"
+      "If empty, the `default_codec` of the resource configuration is used.\n"
+      "`zstd` decompresses much faster than `lzma` and should be prefered for resources that are streamed in."
       >})
   >;
 };
 
 namespace neam::resources
 {
-  namespace processor
+  namespace network
   {
-    struct data;
+    class client;
   }
 
   /// \brief The comination of io::context and resources::index
@@ -185,6 +226,7 @@ namespace neam::resources
 
     public:
       context(io::context& io, hydra::core_context& _ctx);
+      ~context();
 
       /// \brief Returns the IO context.
       /// \note Unless trying to access non-resource files directly, please use the resources:: facilities,
@@ -222,6 +264,15 @@ namespace neam::resources
       /// \note any rel-db operations are not possible. No index is loaded in memory
       [[nodiscard]] status_chain connect(const std::string& host, uint32_t port);
 
+      /// \brief Close the connection to the resource server (if any)
+      void disconnect();
+
+      /// \brief Return whether resources are fetched from a resource server (see connect())
+      [[nodiscard]] bool is_connected() const;
+
+      /// \brief Return the client used to connect to the resource server (nullptr if not connected)
+      [[nodiscard]] network::client* _get_client() { return remote.get(); }
+
       /// \brief Create base_index_path.index / base_index_path.pack so that they are self-bootable
       /// \note this will not override any loaded index but will alter the mapped files to contain the index / pack / file-map
       /// \see make_chain_boot
@@ -335,13 +386,25 @@ namespace neam::resources
       void remove_from_file_map(const std::set<id_t>& rid);
 
     public:
-      /// \brief Go over all the resources located in the index and repack them. Will remove invalid resources (those that cannot be found).
-      /// \note the operation is mostly asynchronous. Data change occuring during the process may lead to corrupted data
-      /// \note It will also generate a map-file
-      /// \warning it (currently) create pack files based on size (going over all the resources, placing them in a packfile until
-      ///           a size limit is reached then creating a new pack file and continuing the process with it)
+      /// \brief Go over the pack files referenced in the index and repack those that need it:
+      ///  - uncompressed data entries that are eligible get compressed (if compression is supported)
+      ///  - pack files are rewritten without the holes left by removed/re-imported resources
+      /// Will remove invalid resources (those that cannot be found in their pack file).
+      /// Each pack file is rewritten as a new file. Its index entries are only switched to it (all at once) when the write is done,
+      /// and the old file is then removed. The index is saved at the end of the operation.
+      /// \param max_pack_files Maximum number of pack files to process during this call (0 for no limit).
+      ///        As repacked entries are not considered anymore, calling this function repeatedly will progressively repack everything.
+      /// \note the operation is asynchronous. Resources being imported while the repack is in progress will be skipped
+      /// \note It will also update the boot file-map
       /// \todo A better approach, probably based on access patterns to better use the iovec capabilities of io::context
-      void repack_data();
+      [[nodiscard]] status_chain repack_data(uint32_t max_pack_files = 0);
+
+      /// \brief Stop the repack operation in progress after the pack file currently being processed.
+      /// \note The chain returned by repack_data() will still complete (and the index will still be saved)
+      void cancel_repack() { repack_cancel_requested = true; }
+
+      /// \brief Whether a repack operation is in progress
+      [[nodiscard]] bool is_repacking() const { return repack_in_progress; }
 
     public: // queries:
       [[nodiscard]] std::string resource_name(id_t rid) const;
@@ -403,6 +466,21 @@ namespace neam::resources
       /// \note only resources with flags::type_data can be read this way
       [[nodiscard]] io::context::read_chain read_raw_resource(id_t rid) const;
 
+      /// \brief reads a raw resource as it is stored in the index / pack file (compressed resources are not decompressed)
+      /// \param is_compressed set to whether the returned data is compressed (valid when the function returns)
+      /// \note Used by the resource server, which leaves decompression to the client
+      [[nodiscard]] io::context::read_chain _read_stored_resource(id_t rid, bool& is_compressed) const;
+
+      /// \brief Return the memory where a resource of \p size bytes will be written. Returning less than \p size bytes fails the read.
+      /// \note Called at most once per read, from any thread
+      using destination_allocator_t = std::function<std::span<uint8_t>(size_t size)>;
+
+      /// \brief reads a raw resource into memory provided by \p allocate_destination (like staging memory)
+      /// Compressed resources are uncompressed directly into that memory, skipping the intermediate raw_data.
+      /// \note asynchronous
+      /// \note only resources with flags::type_data can be read this way
+      [[nodiscard]] status_chain read_raw_resource_into(id_t rid, destination_allocator_t&& allocate_destination) const;
+
       /// \brief return whether a call to read*_resource will immediatly resolve and not be async
       /// \note the only intended use case is to allow a specific "immediate" path when some resource (or part of a resource) is immediatly available
       /// \note if the resource doesn't exist/is not data, returns true as well, as the result will be immediate
@@ -437,6 +515,11 @@ namespace neam::resources
       /// \brief Helper for packing processed resources.
       [[nodiscard]] status_chain _pack_resource(processor::data&& proc_data);
 
+      /// \brief Return the build cache used when importing/packing resources
+      /// \see resource_configuration::build_cache_directory
+      [[nodiscard]] build_cache& get_build_cache() { return cache; }
+      [[nodiscard]] const build_cache& get_build_cache() const { return cache; }
+
       /// \brief Where the source folder is
       std::filesystem::path source_folder;
 
@@ -496,15 +579,45 @@ namespace neam::resources
 
     private:
       [[nodiscard]] status_chain reload_index(id_t index_id, id_t fid);
+      /// \brief Second part of reload_index, once root has been loaded
+      [[nodiscard]] status_chain finish_reload_index(id_t fid, bool has_rejected_entries);
+
+      /// \brief Return the path of a file mapped in the io context (empty if it cannot be found)
+      /// \note Used to mmap mapped indexes (see index::map_index_file)
+      std::string get_io_file_path(id_t fid) const;
 
       [[nodiscard]] status_chain write_index(id_t file_id, const index& idx) const;
 
+      /// \brief Return the index entry of a data resource (log and return false if the resource is not a valid data resource)
+      [[nodiscard]] bool get_data_entry(id_t rid, index::entry& entry) const;
+
+      [[nodiscard]] io::context::read_chain read_remote_resource(id_t rid) const;
+
       /// \brief apply the map-file to the current state:
       /// Map files contains a line-encoded data with the following format:
       /// First line:  base-path prefix. ('./' for "no" prefix). Must be either empty or end with a /
       /// Other lines: files to map (relatives to the prefix directory)
       void apply_file_map(const file_map& fm, bool additive = false);
 
+      struct repack_pack_file_t
+      {
+        id_t pack_file;
+        std::vector<index::entry> entries;
+      };
+
+      /// \brief return whether the entries of a pack file have holes or can be compressed
+      [[nodiscard]] bool pack_file_needs_repack(const std::vector<index::entry>& entries) const;
+      [[nodiscard]] bool is_entry_compressible(const index::entry& e) const;
+      [[nodiscard]] codec get_default_codec() const;
+      [[nodiscard]] codec get_resource_codec(const default_resource_metadata_t& resource_metadata) const;
+      [[nodiscard]] status_chain repack_next_pack_file(std::vector<repack_pack_file_t>&& pack_files, size_t pack_index, status st);
+      [[nodiscard]] status_chain repack_pack_file(id_t pack_file, std::vector<index::entry>&& entries);
+
+      /// \brief Run a processor, going through the build cache if it is enabled
+      [[nodiscard]] processor::chain run_processor(processor::function proc, id_t processor_hash, processor::input_data&& input);
+      /// \brief Run a packer, going through the build cache if it is enabled
+      [[nodiscard]] packer::chain run_packer(packer::function pack, id_t packer_hash, processor::data&& proc_data);
+
     private:
       static std::string get_prefix_from_filename(const std::string& name);
 
@@ -526,7 +639,16 @@ namespace neam::resources
 
       mutable threading::rate_limiter compressor_dispatcher;
 
+      build_cache cache;
+
+      std::atomic<bool> repack_in_progress = false;
+      std::atomic<bool> repack_cancel_requested = false;
+
       resource_configuration configuration;
       cr::event_token_t on_configuration_changed_tk;
+
+      // connection to a resource server, see connect()
+      std::unique_ptr<network::client> remote;
+      cr::event_token_t on_remote_index_reloaded_tk;
   };
 }
@@ -24,10 +24,37 @@
 // SOFTWARE.
 //
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include <ntools/tracy.hpp>
+
 #include "index.hpp"
 
 namespace neam::resources
 {
+  static_assert(sizeof(index::entry) == 40, "index::entry size changed: the mapped index format must be updated");
+
+  namespace
+  {
+    constexpr uint64_t align_mapped_offset(uint64_t offset) { return (offset + 7) & ~7ull; }
+
+    /// \brief xor a u32 stream (same scheme as the xored format, but without key changes)
+    void xor_u32_stream(const void* src, void* dst, size_t u32_count, uint64_t key)
+    {
+      const uint32_t* const u32_src = reinterpret_cast<const uint32_t*>(src);
+      uint32_t* const u32_dst = reinterpret_cast<uint32_t*>(dst);
+      for (size_t i = 0; i < u32_count; ++i)
+      {
+        key = neam::ct::invwk_rnd(key);
+        u32_dst[i] = u32_src[i] ^ (uint32_t)(key >> 32);
+      }
+    }
+  }
+
   bool index::add_entry(id_t id, const entry& e, raw_data _data)
   {
     if (!check_entry_consistency(id, e))
@@ -52,28 +79,164 @@ namespace neam::resources
     }
 
     db.insert_or_assign(id, e);
+    // the overlay entry hides the mapped one, no need to keep it masked
+    masked_mapped_entries.erase(id);
     return true;
   }
 
+  void index::remove_entry(id_t id)
+  {
+    std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
+    db.erase(id);
+    embedded_data.erase(id);
+    if (find_mapped_entry_unlocked(id) != nullptr)
+    {
+      masked_mapped_entries.insert(id);
+      std::lock_guard _cl(mapped_embedded_data_lock);
+      mapped_embedded_data.erase(id);
+    }
+  }
+
   index::entry index::get_entry(id_t id, unsigned max_depth) const
   {
     std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
-    if (const auto it = db.find(id); it != db.end())
+    const entry e = find_entry_unlocked(id);
+    if ((e.flags & flags::type_mask) != flags::type_simlink)
+      return e;
+
+    if (max_depth == 0)
+      return {};
+
+    // pack_file contains the resource id to target
+    return get_entry(e.pack_file, max_depth - 1);
+  }
+
+  raw_data* index::get_embedded_data(id_t id)
+  {
+    return const_cast<raw_data*>(static_cast<const index*>(this)->get_embedded_data(id));
+  }
+
+  const raw_data* index::get_embedded_data(id_t id) const
+  {
+    std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
+    if (auto it = embedded_data.find(id); it != embedded_data.end())
+      return &it->second;
+
+    uint32_t block_index;
+    const mapped_entry_t* me = find_visible_mapped_entry_unlocked(id, &block_index);
+    if (me == nullptr || (me->e.flags & flags::embedded_data) == flags::none)
+      return nullptr;
+
+    // materialize the embedded data (done only once per resource, as the returned pointer must stay valid)
+    std::lock_guard _cl(mapped_embedded_data_lock);
+    if (auto it = mapped_embedded_data.find(id); it != mapped_embedded_data.end())
+      return &it->second;
+    return &mapped_embedded_data.emplace(id, decode_mapped_embedded_data(*me, block_index)).first->second;
+  }
+
+  std::optional<std::span<const uint8_t>> index::get_embedded_data_view(id_t id) const
+  {
+    std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
+    return get_embedded_data_view_unlocked(id);
+  }
+
+  std::optional<std::span<const uint8_t>> index::get_embedded_data_view_unlocked(id_t id) const
+  {
+    if (auto it = embedded_data.find(id); it != embedded_data.end())
+      return std::span<const uint8_t>{ reinterpret_cast<const uint8_t*>(it->second.data.get()), it->second.size };
+
+    uint32_t block_index;
+    const mapped_entry_t* me = find_visible_mapped_entry_unlocked(id, &block_index);
+    if (me == nullptr || (me->e.flags & flags::embedded_data) == flags::none)
+      return {};
+
+    // in-place data:
+    if ((mapped->blocks[block_index].flags & mapped_flags::obfuscated) == mapped_flags::none)
+      return std::span<const uint8_t>{ mapped->base + mapped->header.data_offset + me->data_offset, me->data_size };
+
+    std::lock_guard _cl(mapped_embedded_data_lock);
+    auto it = mapped_embedded_data.find(id);
+    if (it == mapped_embedded_data.end())
+      it = mapped_embedded_data.emplace(id, decode_mapped_embedded_data(*me, block_index)).first;
+    return std::span<const uint8_t>{ reinterpret_cast<const uint8_t*>(it->second.data.get()), it->second.size };
+  }
+
+  bool index::set_embedded_data(id_t id, raw_data&& rd)
+  {
+    std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
+    if (auto it = embedded_data.find(id); it != embedded_data.end())
     {
-      if ((it->second.flags & flags::type_mask) != flags::type_simlink)
-      {
-        return it->second;
-      }
-      else
+      it->second = std::move(rd);
+      return true;
+    }
+
+    // promote the mapped entry to the overlay:
+    const mapped_entry_t* me = find_visible_mapped_entry_unlocked(id);
+    if (me == nullptr || (me->e.flags & flags::embedded_data) == flags::none)
+      return false;
+    db.insert_or_assign(id, me->e);
+    embedded_data.emplace(id, std::move(rd));
+    std::lock_guard _cl(mapped_embedded_data_lock);
+    mapped_embedded_data.erase(id);
+    return true;
+  }
+
+  bool index::has_embedded_data(id_t id) const
+  {
+    std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
+    if (embedded_data.contains(id))
+      return true;
+    const mapped_entry_t* me = find_visible_mapped_entry_unlocked(id);
+    return me != nullptr && (me->e.flags & flags::embedded_data) != flags::none;
+  }
+
+  size_t index::entry_count() const
+  {
+    std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
+    if (!mapped)
+      return db.size();
+
+    // masked entries are never in the overlay (see add_entry), but overriden ones are
+    size_t overriden_count = 0;
+    for (const auto& it : db)
+    {
+      if (find_mapped_entry_unlocked(it.first) != nullptr)
+        ++overriden_count;
+    }
+    return db.size() + mapped->header.entry_count - masked_mapped_entries.size() - overriden_count;
+  }
+
+  void index::unmap()
+  {
+    std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
+    if (!mapped)
+      return;
+
+    TRACY_SCOPED_ZONE;
+    db.reserve(db.size() + mapped->header.entry_count);
+    for (uint32_t i = 0; i < (uint32_t)mapped->blocks.size(); ++i)
+    {
+      const mapped_entry_t* entries = get_block_entries(i);
+      for (uint32_t j = 0; j < mapped->blocks[i].entry_count; ++j)
       {
-        if (max_depth == 0)
-          return {};
+        const mapped_entry_t& me = entries[j];
+        if (db.contains(me.e.id) || masked_mapped_entries.contains(me.e.id))
+          continue;
 
-        // pack_file contains the resource id to target
-        return get_entry(it->second.pack_file, max_depth - 1);
+        db.emplace(me.e.id, me.e);
+        if ((me.e.flags & flags::embedded_data) != flags::none)
+        {
+          if (auto it = mapped_embedded_data.find(me.e.id); it != mapped_embedded_data.end())
+            embedded_data.emplace(me.e.id, std::move(it->second));
+          else
+            embedded_data.emplace(me.e.id, decode_mapped_embedded_data(me, i));
+        }
       }
     }
-    return {};
+
+    mapped.reset();
+    masked_mapped_entries.clear();
+    mapped_embedded_data.clear();
   }
 
   bool index::check_entry_consistency(const id_t id, const entry& e)
@@ -278,6 +441,11 @@ namespace neam::resources
     {
       sorted_db.emplace_back(it);
     }
+    for_each_mapped_entry_unlocked([this, &sorted_db](const entry& e)
+    {
+      if (!db.contains(e.id) && !masked_mapped_entries.contains(e.id))
+        sorted_db.emplace_back(e.id, e);
+    });
     std::sort(sorted_db.begin(), sorted_db.end(), [](const auto& a, const auto& b)
     {
       return a.first < b.first;
@@ -352,24 +520,28 @@ namespace neam::resources
         for (size_t i = 0; i < u32_data_for_key_change; ++i)
           data.push_back(encode(entry.u32[i]));
 
-        auto data_it = embedded_data.find(entry.current.id);
-        if (data_it != embedded_data.end() && data_it->second.size > 0)
+        const auto data_view = get_embedded_data_view_unlocked(entry.current.id);
+        if (data_view && data_view->size() > 0)
         {
-          data.push_back(encode((uint32_t)data_it->second.size));
+          data.push_back(encode((uint32_t)data_view->size()));
 
-          const uint32_t* embedded_data_ptr = (const uint32_t*)data_it->second.data.get();
-          const size_t embedded_data_size = (data_it->second.size) / 4;
-          const size_t rem_data_size = (data_it->second.size) % 4;
+          const size_t embedded_data_size = (data_view->size()) / 4;
+          const size_t rem_data_size = (data_view->size()) % 4;
 
           data.reserve(embedded_data_size + 1);
 
+          // the view might not be aligned (in-place mapped data is, but better be safe)
           for (size_t j = 0; j < embedded_data_size; ++j)
-            data.push_back(encode(embedded_data_ptr[j]));
+          {
+            uint32_t x;
+            memcpy(&x, data_view->data() + j * 4, sizeof(x));
+            data.push_back(encode(x));
+          }
           if (rem_data_size > 0)
           {
             // Avoid writing garbage on the out-of-bound data
-            // (accessing up to 3 byte on a 8 byte aligned memory is _fine_, we just have to make sure to never use that memory)
-            const uint32_t extra_data = embedded_data_ptr[embedded_data_size] & ((~0u) >> (32 - rem_data_size * 8));
+            uint32_t extra_data = 0;
+            memcpy(&extra_data, data_view->data() + embedded_data_size * 4, rem_data_size);
             data.push_back(encode(extra_data));
           }
         }
@@ -389,5 +561,408 @@ namespace neam::resources
 
     return data;
   }
-}
 
+  // Mapped format:
+
+  index::mapped_data_t::~mapped_data_t()
+  {
+    if (mapping != nullptr)
+      munmap(mapping, mapping_size);
+  }
+
+  uint64_t index::get_block_key(uint32_t block_index) const
+  {
+    return neam::ct::invwk_rnd((uint64_t)index_id + (uint64_t)(block_index + 1) * 0x9E3779B97F4A7C15ull);
+  }
+
+  uint64_t index::get_embedded_data_key(id_t id) const
+  {
+    return neam::ct::invwk_rnd((uint64_t)index_id ^ (uint64_t)id);
+  }
+
+  bool index::is_mapped_index_data(const void* raw_data_ptr, size_t size)
+  {
+    if (raw_data_ptr == nullptr || size < sizeof(mapped_header_t))
+      return false;
+    uint32_t magic;
+    memcpy(&magic, raw_data_ptr, sizeof(magic));
+    return magic == k_mapped_magic;
+  }
+
+  bool index::is_mapped_index_file(const std::string& path)
+  {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    mapped_header_t hdr;
+    const ssize_t read_size = pread(fd, &hdr, sizeof(hdr), 0);
+    close(fd);
+    return read_size == (ssize_t)sizeof(hdr) && is_mapped_index_data(&hdr, sizeof(hdr));
+  }
+
+  index index::read_index(id_t index_id, const void* raw_data_ptr, size_t size, bool* has_rejected_entries)
+  {
+    if (is_mapped_index_data(raw_data_ptr, size))
+    {
+      // we don't own the memory, so we have to copy it
+      raw_data rd = raw_data::allocate(size);
+      memcpy(rd.data.get(), raw_data_ptr, size);
+      return read_index(index_id, std::move(rd), has_rejected_entries);
+    }
+
+    index idx(index_id);
+    idx.xor_and_load(raw_data_ptr, size, has_rejected_entries);
+    return idx;
+  }
+
+  index index::read_index(id_t index_id, raw_data&& data, bool* has_rejected_entries)
+  {
+    index idx(index_id);
+    if (!is_mapped_index_data(data.data.get(), data.size))
+    {
+      idx.xor_and_load(data.data.get(), data.size, has_rejected_entries);
+      return idx;
+    }
+
+    std::unique_ptr<mapped_data_t> md = std::make_unique<mapped_data_t>();
+    md->base = reinterpret_cast<const uint8_t*>(data.data.get());
+    md->size = data.size;
+    md->owned_data = std::move(data);
+    idx.load_mapped(std::move(md), has_rejected_entries);
+    return idx;
+  }
+
+  index index::map_index_file(id_t index_id, const std::string& path, bool* has_rejected_entries)
+  {
+    index idx(index_id);
+    if (has_rejected_entries != nullptr)
+      *has_rejected_entries = false;
+
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      neam::cr::out().error("resources::index::map_index_file(): failed to open {}", path);
+      if (has_rejected_entries != nullptr)
+        *has_rejected_entries = true;
+      return idx;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+      close(fd);
+      return idx;
+    }
+
+    void* const mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+      neam::cr::out().error("resources::index::map_index_file(): failed to map {}", path);
+      if (has_rejected_entries != nullptr)
+        *has_rejected_entries = true;
+      return idx;
+    }
+
+    std::unique_ptr<mapped_data_t> md = std::make_unique<mapped_data_t>();
+    md->mapping = mem;
+    md->mapping_size = (size_t)st.st_size;
+    md->base = reinterpret_cast<const uint8_t*>(mem);
+    md->size = (size_t)st.st_size;
+
+    if (!is_mapped_index_data(md->base, md->size))
+    {
+      // legacy format: decode it, then unmap the file (done by the destructor of md)
+      idx.xor_and_load(md->base, md->size, has_rejected_entries);
+      return idx;
+    }
+
+    madvise(mem, md->mapping_size, MADV_RANDOM);
+    idx.load_mapped(std::move(md), has_rejected_entries);
+    return idx;
+  }
+
+  bool index::load_mapped(std::unique_ptr<mapped_data_t>&& md, bool* has_rejected_entries)
+  {
+    TRACY_SCOPED_ZONE;
+    if (has_rejected_entries != nullptr)
+      *has_rejected_entries = false;
+
+    const auto reject = [&](const char* reason)
+    {
+#if !N_HYDRA_RESOURCES_STRIP_DEBUG
+      neam::cr::out().error("resources::index::load_mapped(): rejecting index {:X}: {}", std::to_underlying(index_id), reason);
+#else
+      (void)reason;
+#endif
+      if (has_rejected_entries != nullptr)
+        *has_rejected_entries = true;
+      return false;
+    };
+
+    if (md->size < sizeof(mapped_header_t))
+      return reject("data is too small");
+    if (((uintptr_t)md->base % alignof(mapped_entry_t)) != 0)
+      return reject("data is not aligned");
+
+    memcpy(&md->header, md->base, sizeof(mapped_header_t));
+    const mapped_header_t& hdr = md->header;
+    if (hdr.magic != k_mapped_magic)
+      return reject("invalid magic");
+    if (hdr.version != k_mapped_version)
+      return reject("unsupported version");
+
+    // bound checks: (all done on u64, with sizes well under what would overflow)
+    const uint64_t block_table_end = sizeof(mapped_header_t) + (uint64_t)hdr.block_count * sizeof(mapped_block_t);
+    if (block_table_end > md->size || hdr.entry_count > md->size / sizeof(mapped_entry_t))
+      return reject("block table or entry count is out of bounds");
+    if (hdr.entry_table_offset < block_table_end || hdr.entry_table_offset % alignof(mapped_entry_t) != 0
+        || hdr.entry_table_offset + hdr.entry_count * sizeof(mapped_entry_t) > md->size)
+      return reject("entry table is out of bounds");
+    if (hdr.data_offset < hdr.entry_table_offset + hdr.entry_count * sizeof(mapped_entry_t)
+        || hdr.data_offset > md->size || hdr.data_size > md->size - hdr.data_offset)
+      return reject("embedded data section is out of bounds");
+
+    // decode the block table: (small, always done on load)
+    md->blocks.resize(hdr.block_count);
+    if ((hdr.flags & mapped_flags::obfuscated) != mapped_flags::none)
+    {
+      xor_u32_stream(md->base + sizeof(mapped_header_t), md->blocks.data(), hdr.block_count * sizeof(mapped_block_t) / sizeof(uint32_t),
+                     neam::ct::invwk_rnd((uint64_t)index_id ^ k_mapped_magic));
+    }
+    else
+    {
+      memcpy(md->blocks.data(), md->base + sizeof(mapped_header_t), hdr.block_count * sizeof(mapped_block_t));
+    }
+
+    uint64_t next_entry = 0;
+    for (uint32_t i = 0; i < hdr.block_count; ++i)
+    {
+      const mapped_block_t& block = md->blocks[i];
+      if (block.first_entry != next_entry || block.entry_count == 0 || block.first_entry + (uint64_t)block.entry_count > hdr.entry_count)
+        return reject("block table is inconsistent (wrong index id?)");
+      if (i > 0 && block.first_id <= md->blocks[i - 1].first_id)
+        return reject("block table is not sorted (wrong index id?)");
+      next_entry += block.entry_count;
+    }
+    if (next_entry != hdr.entry_count)
+      return reject("block table does not cover all the entries");
+
+    md->block_states = std::make_unique<mapped_block_state_t[]>(hdr.block_count);
+
+    std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
+    mapped = std::move(md);
+    return true;
+  }
+
+  const index::mapped_entry_t* index::get_block_entries(uint32_t block_index) const
+  {
+    const mapped_block_t& block = mapped->blocks[block_index];
+    const mapped_entry_t* const in_place = reinterpret_cast<const mapped_entry_t*>(mapped->base + mapped->header.entry_table_offset) + block.first_entry;
+    if ((block.flags & mapped_flags::obfuscated) == mapped_flags::none)
+      return in_place;
+
+    // lazy decode of the block:
+    mapped_block_state_t& state = mapped->block_states[block_index];
+    if (state.decoded.load(std::memory_order_acquire))
+      return state.entries.get();
+
+    std::lock_guard _l(state.decode_lock);
+    if (!state.decoded.load(std::memory_order_acquire))
+    {
+      state.entries = std::make_unique<mapped_entry_t[]>(block.entry_count);
+      xor_u32_stream(in_place, state.entries.get(), block.entry_count * sizeof(mapped_entry_t) / sizeof(uint32_t), get_block_key(block_index));
+      state.decoded.store(true, std::memory_order_release);
+    }
+    return state.entries.get();
+  }
+
+  const index::mapped_entry_t* index::find_mapped_entry_unlocked(id_t id, uint32_t* block_index) const
+  {
+    if (!mapped || mapped->blocks.empty())
+      return nullptr;
+
+    // find the block: (last block with first_id <= id)
+    const auto block_it = std::upper_bound(mapped->blocks.begin(), mapped->blocks.end(), id, [](id_t v, const mapped_block_t& b)
+    {
+      return v < b.first_id;
+    });
+    if (block_it == mapped->blocks.begin())
+      return nullptr;
+    const uint32_t bi = (uint32_t)(block_it - mapped->blocks.begin() - 1);
+
+    // find the entry in the block:
+    const mapped_entry_t* const entries = get_block_entries(bi);
+    const mapped_entry_t* const end = entries + mapped->blocks[bi].entry_count;
+    const mapped_entry_t* const it = std::lower_bound(entries, end, id, [](const mapped_entry_t& me, id_t v)
+    {
+      return me.e.id < v;
+    });
+    if (it == end || it->e.id != id)
+      return nullptr;
+    if (block_index != nullptr)
+      *block_index = bi;
+    return it;
+  }
+
+  const index::mapped_entry_t* index::find_visible_mapped_entry_unlocked(id_t id, uint32_t* block_index) const
+  {
+    if (!mapped || db.contains(id) || masked_mapped_entries.contains(id))
+      return nullptr;
+    return find_mapped_entry_unlocked(id, block_index);
+  }
+
+  index::entry index::find_entry_unlocked(id_t id) const
+  {
+    if (const auto it = db.find(id); it != db.end())
+      return it->second;
+    if (const mapped_entry_t* me = find_visible_mapped_entry_unlocked(id); me != nullptr)
+      return me->e;
+    return {};
+  }
+
+  raw_data index::decode_mapped_embedded_data(const mapped_entry_t& me, uint32_t block_index) const
+  {
+    if (me.data_size == 0)
+      return {};
+    if (me.data_offset > mapped->header.data_size || me.data_size > mapped->header.data_size - me.data_offset)
+    {
+#if !N_HYDRA_RESOURCES_STRIP_DEBUG
+      neam::cr::out().warn("resources::index: embedded data of resource {:X} is out of bounds", std::to_underlying(me.e.id));
+#endif
+      return {};
+    }
+
+    const uint8_t* const src = mapped->base + mapped->header.data_offset + me.data_offset;
+    if ((mapped->blocks[block_index].flags & mapped_flags::obfuscated) == mapped_flags::none)
+    {
+      raw_data rd = raw_data::allocate(me.data_size);
+      memcpy(rd.data.get(), src, me.data_size);
+      return rd;
+    }
+
+    // blobs are padded to 8 bytes, so decoding whole u32s is fine
+    const size_t u32_size = (me.data_size + 3) / 4;
+    raw_data rd = raw_data::allocate(u32_size * 4);
+    xor_u32_stream(src, rd.data.get(), u32_size, get_embedded_data_key(me.e.id));
+    rd.size = me.data_size;
+    return rd;
+  }
+
+  raw_data index::save_mapped(bool obfuscate) const
+  {
+    static_assert(sizeof(mapped_header_t) == 48 && sizeof(mapped_block_t) == 24 && sizeof(mapped_entry_t) == 56, "mapped index structures changed: bump k_mapped_version");
+    static_assert(sizeof(mapped_block_t) % sizeof(uint32_t) == 0 && sizeof(mapped_entry_t) % sizeof(uint32_t) == 0);
+    TRACY_SCOPED_ZONE;
+
+    // merged, sorted view of the index:
+    std::vector<entry> sorted_entries;
+    sorted_entries.reserve(db.size() + (mapped ? mapped->header.entry_count : 0));
+    for (const auto& it : db)
+    {
+      if (!check_entry_consistency(it.first, it.second))
+      {
+#if !N_HYDRA_RESOURCES_STRIP_DEBUG
+        neam::cr::out().warn("resources::index: skipping resource {:X}: resource is not consistent", std::to_underlying(it.first));
+#endif
+        continue;
+      }
+      sorted_entries.push_back(it.second);
+    }
+    for_each_mapped_entry_unlocked([this, &sorted_entries](const entry& e)
+    {
+      if (!db.contains(e.id) && !masked_mapped_entries.contains(e.id))
+        sorted_entries.push_back(e);
+    });
+    std::sort(sorted_entries.begin(), sorted_entries.end(), [](const entry& a, const entry& b)
+    {
+      return a.id < b.id;
+    });
+
+    // compute the layout:
+    const uint32_t block_count = (uint32_t)((sorted_entries.size() + k_entries_per_block - 1) / k_entries_per_block);
+    mapped_header_t hdr
+    {
+      .magic = k_mapped_magic,
+      .version = k_mapped_version,
+      .entry_count = sorted_entries.size(),
+      .block_count = block_count,
+      .flags = obfuscate ? mapped_flags::obfuscated : mapped_flags::none,
+      .entry_table_offset = align_mapped_offset(sizeof(mapped_header_t) + block_count * sizeof(mapped_block_t)),
+      .data_offset = 0,
+      .data_size = 0,
+    };
+    hdr.data_offset = align_mapped_offset(hdr.entry_table_offset + sorted_entries.size() * sizeof(mapped_entry_t));
+
+    std::vector<mapped_entry_t> mapped_entries;
+    std::vector<std::span<const uint8_t>> data_views;
+    mapped_entries.reserve(sorted_entries.size());
+    data_views.reserve(sorted_entries.size());
+    for (const entry& e : sorted_entries)
+    {
+      mapped_entry_t& me = mapped_entries.emplace_back(mapped_entry_t{ .e = e, .data_offset = 0, .data_size = 0 });
+      std::span<const uint8_t> view;
+      if ((e.flags & flags::embedded_data) != flags::none)
+      {
+        if (const auto data_view = get_embedded_data_view_unlocked(e.id); data_view)
+          view = *data_view;
+      }
+      me.data_offset = hdr.data_size;
+      me.data_size = view.size();
+      hdr.data_size = align_mapped_offset(hdr.data_size + view.size());
+      data_views.push_back(view);
+    }
+
+    raw_data ret = raw_data::allocate(hdr.data_offset + hdr.data_size);
+    uint8_t* const base = reinterpret_cast<uint8_t*>(ret.data.get());
+    memset(base, 0, ret.size);
+
+    // header:
+    memcpy(base, &hdr, sizeof(hdr));
+
+    // block table:
+    std::vector<mapped_block_t> blocks;
+    blocks.reserve(block_count);
+    for (uint32_t i = 0; i < block_count; ++i)
+    {
+      const uint32_t first_entry = i * k_entries_per_block;
+      blocks.push_back(
+      {
+        .first_id = sorted_entries[first_entry].id,
+        .first_entry = first_entry,
+        .entry_count = std::min<uint32_t>(k_entries_per_block, (uint32_t)sorted_entries.size() - first_entry),
+        .flags = obfuscate ? mapped_flags::obfuscated : mapped_flags::none,
+        ._padding = 0,
+      });
+    }
+    uint8_t* const block_table = base + sizeof(mapped_header_t);
+    if (obfuscate)
+      xor_u32_stream(blocks.data(), block_table, block_count * sizeof(mapped_block_t) / sizeof(uint32_t), neam::ct::invwk_rnd((uint64_t)index_id ^ k_mapped_magic));
+    else
+      memcpy(block_table, blocks.data(), block_count * sizeof(mapped_block_t));
+
+    // entries and embedded data, per block:
+    mapped_entry_t* const entry_table = reinterpret_cast<mapped_entry_t*>(base + hdr.entry_table_offset);
+    uint8_t* const data_section = base + hdr.data_offset;
+    for (uint32_t i = 0; i < block_count; ++i)
+    {
+      const mapped_block_t& block = blocks[i];
+      for (uint32_t j = block.first_entry; j < block.first_entry + block.entry_count; ++j)
+      {
+        if (data_views[j].empty())
+          continue;
+        uint8_t* const dst = data_section + mapped_entries[j].data_offset;
+        memcpy(dst, data_views[j].data(), data_views[j].size());
+        if (obfuscate)
+          xor_u32_stream(dst, dst, (data_views[j].size() + 3) / 4, get_embedded_data_key(mapped_entries[j].e.id));
+      }
+
+      if (obfuscate)
+        xor_u32_stream(mapped_entries.data() + block.first_entry, entry_table + block.first_entry, block.entry_count * sizeof(mapped_entry_t) / sizeof(uint32_t), get_block_key(i));
+      else
+        memcpy(entry_table + block.first_entry, mapped_entries.data() + block.first_entry, block.entry_count * sizeof(mapped_entry_t));
+    }
+
+    return ret;
+  }
+}
@@ -29,7 +29,12 @@
 #include <cstdint>
 #include <utility>
 #include <ntools/mt_check/unordered_map.hpp>
+#include <ntools/mt_check/set.hpp>
 #include <random>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <span>
 
 #include <ntools/logger/logger.hpp>
 #include <ntools/rng.hpp>
@@ -87,6 +92,11 @@ namespace neam::resources
     // the entry _must_ have data (cannot be a virtual entry)
     compressed = 1 << 11,
 
+    // the entry has been considered for compression during a repack, but compression did not reduce its size
+    // (or the resource asked to skip compression). Repacks will not try to compress it again.
+    // The flag is cleared when the resource is re-imported.
+    incompressible = 1 << 12,
+
     // mask used to store random data in this field
     // NOTE: Modifying the crap-mask means a full rebuild of all indexes (as previously random bits become meaningful)
     crap_mask = 0xFFFFFFFFFFFF0000,
@@ -96,9 +106,31 @@ namespace neam::resources
   N_ENUM_BINARY_OPERATOR(flags, |)
   N_ENUM_BINARY_OPERATOR(flags, &)
 
+  /// \brief On-disk format of an index
+  enum class index_format : uint8_t
+  {
+    // the whole index is a single xored stream, decoded and inserted entry by entry on load
+    xored = 0,
+
+    // the index is used in place (from memory or from a mmap): sorted entry table, with embedded data referenced by offset.
+    // obfuscation is optional and done per block, blocks are decoded lazily on access
+    mapped = 1,
+  };
+
+  /// \brief Flags for the blocks of mapped indexes
+  enum class mapped_flags : uint32_t
+  {
+    none = 0,
+    obfuscated = 1 << 0,
+  };
+  N_ENUM_BINARY_OPERATOR(mapped_flags, |)
+  N_ENUM_BINARY_OPERATOR(mapped_flags, &)
+
   /// \brief Simple repository of res id -> pack file hash | offset | size
   /// \note the index can be split into multiple chunks and additively loaded
   /// \note the index does not handle pack files / resource files. It simple manages the index.
+  /// \note When loaded from a mapped index, entries are read in-place from the mapped data.
+  ///       Any modification goes in an overlay that takes priority over the mapped entries.
   class index
   {
     public:
@@ -118,7 +150,11 @@ namespace neam::resources
       explicit index(id_t id) : index_id(id) {}
       index() = default;
       ~index() = default;
-      index(index&& o) : index_id(o.index_id), db(std::move(o.db)), embedded_data(std::move(o.embedded_data)) {}
+      index(index&& o)
+        : index_id(o.index_id), db(std::move(o.db)), embedded_data(std::move(o.embedded_data))
+        , mapped(std::move(o.mapped)), masked_mapped_entries(std::move(o.masked_mapped_entries))
+        , mapped_embedded_data(std::move(o.mapped_embedded_data))
+      {}
 //       index(const index& o) : index_id(o.index_id), db(o.db), embedded_data(o.embedded_data) {}
       index& operator = (index&& o)
       {
@@ -127,6 +163,9 @@ namespace neam::resources
         index_id = (o.index_id);
         db = (std::move(o.db));
         embedded_data = (std::move(o.embedded_data));
+        mapped = std::move(o.mapped);
+        masked_mapped_entries = std::move(o.masked_mapped_entries);
+        mapped_embedded_data = std::move(o.mapped_embedded_data);
         return *this;
       }
 //       index& operator = (const index& o)
@@ -152,66 +191,42 @@ namespace neam::resources
 
       bool add_entry(id_t id, const entry& e, raw_data _data = {});
 
-      void remove_entry(id_t id)
-      {
-        std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
-        db.erase(id);
-        embedded_data.erase(id);
-      }
+      void remove_entry(id_t id);
 
       bool has_entry(id_t id) const
       {
         std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
-        return db.contains(id);
+        return db.contains(id) || find_visible_mapped_entry_unlocked(id) != nullptr;
       }
 
       entry get_raw_entry(id_t id) const
       {
         std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
-        if (const auto it = db.find(id); it != db.end())
-        {
-          return it->second;
-        }
-        return {};
+        return find_entry_unlocked(id);
       }
 
       entry get_entry(id_t id, unsigned max_depth = 5) const;
 
-      raw_data* get_embedded_data(id_t id)
-      {
-        std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
-        if (auto it = embedded_data.find(id); it != embedded_data.end())
-          return &it->second;
-        return nullptr;
-      }
-      const raw_data* get_embedded_data(id_t id) const
-      {
-        std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
-        if (auto it = embedded_data.find(id); it != embedded_data.end())
-          return &it->second;
-        return nullptr;
-      }
+      /// \note For mapped indexes, this copies (and decodes) the embedded data on the first call for a given resource.
+      ///       Prefer get_embedded_data_view() which does not copy when possible.
+      raw_data* get_embedded_data(id_t id);
+      const raw_data* get_embedded_data(id_t id) const;
 
-      bool set_embedded_data(id_t id, raw_data&& rd)
-      {
-        std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
-        if (auto it = embedded_data.find(id); it != embedded_data.end())
-        {
-          it->second = std::move(rd);
-          return true;
-        }
-        return false;
-      }
+      /// \brief Return a view on the embedded data, without copying it if possible.
+      /// \note The view is valid until the entry is modified/removed or the index is destroyed.
+      std::optional<std::span<const uint8_t>> get_embedded_data_view(id_t id) const;
 
-      bool has_embedded_data(id_t id) const
-      {
-        std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
-        return (embedded_data.find(id) != embedded_data.end());
-      }
+      bool set_embedded_data(id_t id, raw_data&& rd);
+
+      bool has_embedded_data(id_t id) const;
 
       void add_index(index&& o)
       {
+        // the entries of a mapped index are brought into the overlay, as they take priority over ours
+        o.unmap();
         std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
+        for (const auto& it : o.db)
+          masked_mapped_entries.erase(it.first);
         auto temp_db = std::move(db);
         db = std::move(o.db);
         // FIXME: this may be slower than a loop over o.db if the size of the db is big
@@ -224,11 +239,14 @@ namespace neam::resources
         std::lock_guard _oel(spinlock_exclusive_adapter::adapt(o.lock));
         auto temp_db = std::move(db);
         db = o.db;
+        o.for_each_mapped_entry_unlocked([this](const entry& e) { db.emplace(e.id, e); });
+        for (const auto& it : db)
+          masked_mapped_entries.erase(it.first);
         // FIXME: this may be slower than a loop over o.db if the size of the db is big
         db.merge(temp_db);
       }
 
-      size_t entry_count() const { return db.size(); }
+      size_t entry_count() const;
 
       template<typename Fnc>
       void for_each_entry(Fnc&& fnc) const
@@ -238,8 +256,19 @@ namespace neam::resources
         {
           fnc(it.second);
         }
+        for_each_mapped_entry_unlocked([this, &fnc](const entry& e)
+        {
+          if (!db.contains(e.id) && !masked_mapped_entries.contains(e.id))
+            fnc(e);
+        });
       }
 
+      /// \brief Whether the index entries are read in-place from a mapped index
+      bool is_mapped() const { return mapped != nullptr; }
+
+      /// \brief Copy all the mapped entries (and their embedded data) to the overlay, and release the mapped data
+      void unmap();
+
       static bool check_entry_consistency(const entry& e)
       {
         return check_entry_consistency(e.id, e);
@@ -254,24 +283,36 @@ namespace neam::resources
       /// \brief Create and populate an index from a set of data
       /// \note There is no failure, as there is no data check. You'll get a corrupted index
       ///       if the data are not correct / the index_id is not correct
-      static index read_index(id_t index_id, const void* raw_data, size_t size, bool* has_rejected_entries = nullptr)
-      {
-        index idx(index_id);
-        // FIXME: add header / version check here ?
-        idx.xor_and_load(raw_data, size, has_rejected_entries);
-        return idx;
-      }
+      /// \note The format is automatically detected. Mapped indexes are copied, as the memory is not owned by the index.
+      static index read_index(id_t index_id, const void* raw_data, size_t size, bool* has_rejected_entries = nullptr);
 
       static index read_index(id_t index_id, const raw_data& data, bool* has_rejected_entries = nullptr)
       {
         return read_index(index_id, data.data.get(), data.size, has_rejected_entries);
       }
 
+      /// \brief Same as above, but mapped indexes take ownership of the data (and are used in-place, without any copy)
+      static index read_index(id_t index_id, raw_data&& data, bool* has_rejected_entries = nullptr);
+
+      /// \brief Map the index file in memory. Mapped indexes are used in-place from the mapping.
+      /// \note Other formats are loaded as usual, and the file is unmapped afterward
+      static index map_index_file(id_t index_id, const std::string& path, bool* has_rejected_entries = nullptr);
+
+      /// \brief Return whether the data is a mapped index
+      static bool is_mapped_index_data(const void* raw_data, size_t size);
+
+      /// \brief Return whether the file is a mapped index (only reads the header)
+      static bool is_mapped_index_file(const std::string& path);
+
       /// \brief serialize the data contained in the index
-      raw_data serialize_index() const
+      /// \param obfuscate (mapped format only) whether to obfuscate the blocks (the xored format is always obfuscated if enabled in the build)
+      raw_data serialize_index(index_format format = index_format::xored, bool obfuscate = N_HYDRA_RESOURCES_OBFUSCATE) const
       {
         std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
 
+        if (format == index_format::mapped)
+          return save_mapped(obfuscate);
+
         std::vector<uint32_t> data = xor_and_save();
         raw_data ret = raw_data::allocate(data.size() * sizeof(uint32_t));
         memcpy(ret.data.get(), data.data(), ret.size);
@@ -287,11 +328,108 @@ namespace neam::resources
 
       std::vector<uint32_t> xor_and_save() const;
 
+      // mapped format:
+      // [header] [block table] [entry table: entries sorted by id, grouped in blocks] [embedded data, referenced by offset]
+      // The block table is (optionally) obfuscated as a whole and decoded on load.
+      // Each block of entries (and the embedded data of the entries of that block) is optionally obfuscated with its own key,
+      //  and decoded on first access. Non-obfuscated blocks are used in-place.
+      static constexpr uint32_t k_mapped_magic = 0x58444948; // HIDX
+      static constexpr uint32_t k_mapped_version = 1;
+      static constexpr uint32_t k_entries_per_block = 1024;
+
+      struct mapped_header_t
+      {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t entry_count;
+        uint32_t block_count;
+        mapped_flags flags; // flags of the block table
+        uint64_t entry_table_offset;
+        uint64_t data_offset;
+        uint64_t data_size;
+      };
+
+      struct mapped_block_t
+      {
+        id_t first_id;
+        uint32_t first_entry;
+        uint32_t entry_count;
+        mapped_flags flags;
+        uint32_t _padding;
+      };
+
+      struct mapped_entry_t
+      {
+        entry e;
+        // embedded data, relative to the start of the embedded data section
+        uint64_t data_offset;
+        uint64_t data_size;
+      };
+
+      struct mapped_block_state_t
+      {
+        std::atomic<bool> decoded = false;
+        spinlock decode_lock;
+        std::unique_ptr<mapped_entry_t[]> entries;
+      };
+
+      struct mapped_data_t
+      {
+        // owned memory (either a buffer or a mmap):
+        raw_data owned_data;
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+
+        const uint8_t* base = nullptr;
+        size_t size = 0;
+
+        mapped_header_t header;
+        std::vector<mapped_block_t> blocks;
+        std::unique_ptr<mapped_block_state_t[]> block_states;
+
+        ~mapped_data_t();
+      };
+
+      /// \brief Setup the index to use the memory in-place. The memory must be owned by mapped
+      bool load_mapped(std::unique_ptr<mapped_data_t>&& data, bool* has_rejected_entries);
+      raw_data save_mapped(bool obfuscate) const;
+
+      uint64_t get_block_key(uint32_t block_index) const;
+      uint64_t get_embedded_data_key(id_t id) const;
+
+      const mapped_entry_t* get_block_entries(uint32_t block_index) const;
+      const mapped_entry_t* find_mapped_entry_unlocked(id_t id, uint32_t* block_index = nullptr) const;
+      /// \brief Same as above, but ignore the entries masked/overriden by the overlay
+      const mapped_entry_t* find_visible_mapped_entry_unlocked(id_t id, uint32_t* block_index = nullptr) const;
+      entry find_entry_unlocked(id_t id) const;
+      std::optional<std::span<const uint8_t>> get_embedded_data_view_unlocked(id_t id) const;
+      raw_data decode_mapped_embedded_data(const mapped_entry_t& me, uint32_t block_index) const;
+
+      template<typename Fnc>
+      void for_each_mapped_entry_unlocked(Fnc&& fnc) const
+      {
+        if (!mapped)
+          return;
+        for (uint32_t i = 0; i < (uint32_t)mapped->blocks.size(); ++i)
+        {
+          const mapped_entry_t* entries = get_block_entries(i);
+          for (uint32_t j = 0; j < mapped->blocks[i].entry_count; ++j)
+            fnc(entries[j].e);
+        }
+      }
+
     private:
       id_t index_id = id_t::invalid;
       std::mtc_unordered_map<id_t, entry> db;
       std::mtc_unordered_map<id_t, raw_data> embedded_data;
 
+      // mapped index: (the overlay above takes priority)
+      std::unique_ptr<mapped_data_t> mapped;
+      std::mtc_set<id_t> masked_mapped_entries; // mapped entries that have been removed
+      // decoded/copied embedded data of the mapped entries (protected by mapped_embedded_data_lock, not lock)
+      mutable std::mtc_unordered_map<id_t, raw_data> mapped_embedded_data;
+      mutable spinlock mapped_embedded_data_lock;
+
       mutable shared_spinlock lock;
   };
 }
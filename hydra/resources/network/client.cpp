@@ -0,0 +1,208 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "client.hpp"
+
+namespace neam::resources::network
+{
+  client::~client()
+  {
+    disconnect();
+  }
+
+  client::status_chain client::connect(const std::string& host, uint16_t port)
+  {
+    disconnect();
+
+    const id_t socket = io.create_connection_socket(host.c_str(), port);
+    if (socket == id_t::invalid)
+    {
+      cr::out().error("resource client: failed to connect to {}:{}", host, port);
+      return status_chain::create_and_complete(status::failure);
+    }
+
+    connection = std::make_shared<connection_t>();
+    connection->event_handler = [this](connection_t&, const packet_header_t& ph)
+    {
+      if (ph.command == command_t::index_reloaded_event)
+        on_index_reloaded();
+    };
+    connection->setup(io, socket);
+
+    connection_t::pending_request_t rq = connection->send_request<command_t::hello>();
+    return rq.chain.then([this](packet_header_t ph, raw_data&& data)
+    {
+      if (on_response_error(ph, data))
+        return status::failure;
+      connected = true;
+      return status::success;
+    });
+  }
+
+  void client::disconnect()
+  {
+    if (!connection)
+      return;
+
+    connected = false;
+    connection->close();
+    connection->fail_pending_requests();
+    connection.reset();
+
+    std::lock_guard _lg { in_flight_reads_lock };
+    in_flight_reads.clear();
+  }
+
+  bool client::on_response_error(const packet_header_t& ph, const raw_data& data)
+  {
+    const error_code_t error = connection_t::get_error(ph, data);
+    if (error == error_code_t::none)
+      return false;
+
+    if (error == error_code_t::canceled)
+      ++canceled_request_count;
+    else
+      ++failed_request_count;
+    return true;
+  }
+
+  async::chain<bool> client::has_resource(id_t rid)
+  {
+    if (!connected)
+      return async::chain<bool>::create_and_complete(false);
+
+    ++request_count;
+    connection_t::pending_request_t rq = connection->send_request<command_t::has_resource>({ .resource = rid });
+    return rq.chain.then([this](packet_header_t ph, raw_data&& data)
+    {
+      if (on_response_error(ph, data))
+        return false;
+      const auto* res = connection_t::get_response<command_t::has_resource>(ph, data);
+      return res != nullptr && res->has_resource;
+    });
+  }
+
+  client::read_chain client::read_raw_resource(id_t rid)
+  {
+    if (!connected)
+      return read_chain::create_and_complete({}, false, false);
+
+    ++request_count;
+    connection_t::pending_request_t rq = connection->send_request<command_t::read_raw_resource>({ .resource = rid });
+    {
+      std::lock_guard _lg { in_flight_reads_lock };
+      in_flight_reads.emplace(rq.command_id, rid);
+    }
+    return rq.chain.then([this, command_id = rq.command_id](packet_header_t ph, raw_data&& data)
+    {
+      {
+        std::lock_guard _lg { in_flight_reads_lock };
+        in_flight_reads.erase(command_id);
+      }
+
+      if (on_response_error(ph, data))
+        return read_chain::create_and_complete({}, false, false);
+
+      const auto* res = connection_t::get_response<command_t::read_raw_resource>(ph, data);
+      if (res == nullptr)
+      {
+        ++failed_request_count;
+        return read_chain::create_and_complete({}, false, false);
+      }
+
+      const std::span<const uint8_t> resource_data = connection_t::get_response_extra_data<command_t::read_raw_resource>(ph, data);
+      received_bytes += resource_data.size();
+      raw_data ret = raw_data::allocate(resource_data.size());
+      memcpy(ret.get(), resource_data.data(), resource_data.size());
+      return read_chain::create_and_complete(std::move(ret), res->is_compressed, true);
+    });
+  }
+
+  client::data_chain client::send_data_request(connection_t::pending_request_t&& rq)
+  {
+    return rq.chain.then([this](packet_header_t ph, raw_data&& data)
+    {
+      if (on_response_error(ph, data))
+        return data_chain::create_and_complete({}, false);
+
+      // both read_source_file and get_reldb have an empty response struct
+      const std::span<const uint8_t> extra_data = connection_t::get_response_extra_data<command_t::get_reldb>(ph, data);
+      received_bytes += extra_data.size();
+      raw_data ret = raw_data::allocate(extra_data.size());
+      memcpy(ret.get(), extra_data.data(), extra_data.size());
+      return data_chain::create_and_complete(std::move(ret), true);
+    });
+  }
+
+  client::data_chain client::read_source_file(id_t file)
+  {
+    if (!connected)
+      return data_chain::create_and_complete({}, false);
+
+    ++request_count;
+    return send_data_request(connection->send_request<command_t::read_source_file>({ .file = file }));
+  }
+
+  client::data_chain client::get_reldb()
+  {
+    if (!connected)
+      return data_chain::create_and_complete({}, false);
+
+    ++request_count;
+    return send_data_request(connection->send_request<command_t::get_reldb>());
+  }
+
+  void client::cancel_read(id_t rid)
+  {
+    if (!connection)
+      return;
+
+    std::vector<uint16_t> to_cancel;
+    {
+      std::lock_guard _lg { in_flight_reads_lock };
+      for (const auto& it : in_flight_reads)
+      {
+        if (it.second == rid)
+          to_cancel.push_back(it.first);
+      }
+    }
+    // the chains will be completed with a canceled error (which will remove the in-flight entries)
+    for (const uint16_t command_id : to_cancel)
+      connection->cancel_request(command_id);
+  }
+
+  client::stats_t client::get_stats() const
+  {
+    return
+    {
+      .request_count = request_count,
+      .failed_request_count = failed_request_count,
+      .canceled_request_count = canceled_request_count,
+      .received_bytes = received_bytes,
+    };
+  }
+}
+
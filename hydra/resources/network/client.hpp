@@ -22,11 +22,88 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
-//
 
 #pragma once
 
+#include <memory>
+#include <unordered_map>
+
+#include <ntools/async/chain.hpp>
+#include <ntools/event.hpp>
+#include <ntools/spinlock.hpp>
+
+#include "../enums.hpp"
+#include "connection.hpp"
+
 namespace neam::resources::network
 {
+  /// \brief Client side of the resource server (see server)
+  /// Requests are pipelined: there's no limit on the number of requests in flight, the server queues them
+  /// \note Resources are returned as they are stored on the server (decompression is left to the caller)
+  class client
+  {
+    public:
+      using status_chain = async::chain<status>;
+      using read_chain = async::chain<raw_data&& /* data */, bool /* is_compressed */, bool /* success */>;
+      using data_chain = async::chain<raw_data&& /* data */, bool /* success */>;
+
+      struct stats_t
+      {
+        uint64_t request_count = 0;
+        uint64_t failed_request_count = 0;
+        uint64_t canceled_request_count = 0;
+        uint64_t received_bytes = 0; // payload only
+      };
+
+    public:
+      client(io::context& _io) : io(_io) {}
+      ~client();
+
+      /// \brief Connect to a server and perform the handshake
+      [[nodiscard]] status_chain connect(const std::string& host, uint16_t port);
+
+      /// \brief Close the connection. All the requests in flight are failed.
+      void disconnect();
+
+      bool is_connected() const { return connected; }
+
+      [[nodiscard]] async::chain<bool> has_resource(id_t rid);
+
+      /// \brief Read a resource as stored on the server
+      [[nodiscard]] read_chain read_raw_resource(id_t rid);
+
+      /// \brief Read a file in the source folder of the server
+      /// \note file is the id of the path of the file, relative to the source folder
+      [[nodiscard]] data_chain read_source_file(id_t file);
+
+      /// \brief Return the serialized rel-db of the server
+      [[nodiscard]] data_chain get_reldb();
+
+      /// \brief Cancel all the reads in flight for a resource. Their chains are completed with a failure.
+      void cancel_read(id_t rid);
+
+      stats_t get_stats() const;
+
+    public:
+      /// \brief Called (from the io thread) when the server index has been reloaded
+      cr::event<> on_index_reloaded;
+
+    private:
+      [[nodiscard]] data_chain send_data_request(connection_t::pending_request_t&& rq);
+      bool on_response_error(const packet_header_t& ph, const raw_data& data);
+
+    private:
+      io::context& io;
+      std::shared_ptr<connection_t> connection;
+      std::atomic<bool> connected = false;
+
+      spinlock in_flight_reads_lock;
+      std::unordered_map<uint16_t, id_t> in_flight_reads;
+
+      std::atomic<uint64_t> request_count = 0;
+      std::atomic<uint64_t> failed_request_count = 0;
+      std::atomic<uint64_t> canceled_request_count = 0;
+      std::atomic<uint64_t> received_bytes = 0;
+  };
 }
 
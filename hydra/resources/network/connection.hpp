@@ -22,10 +22,17 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
-//
 
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "protocol.hpp"
 
 #include <ntools/io/network_helper.hpp>
@@ -34,7 +41,12 @@
 namespace neam::resources::network
 {
   /// \brief The connection contains the state
-  struct connection_t : public io::network::header_connection_t<connection_t, 3u * 1024 * 1024 * 1024 /* limit the data to 3gib */>
+  /// Both ends use the same connection type:
+  ///  - requests can be pipelined (they are identified by their command id, responses can arrive in any order)
+  ///  - requests can be canceled (see cancel_request())
+  ///  - big responses are streamed in k_stream_chunk_size packets (see send_response() / pump_streams())
+  struct connection_t : public io::network::header_connection_t<connection_t, 3u * 1024 * 1024 * 1024 /* limit the data to 3gib */>,
+                        public std::enable_shared_from_this<connection_t>
   {
     using packet_header_t = network::packet_header_t;
 
@@ -43,6 +55,7 @@ namespace neam::resources::network
     uint32_t max_queued_request_count = k_max_queued_request_count;
     static constexpr uint32_t k_max_active_request_count = 64;
     uint32_t max_active_request_count = k_max_active_request_count;
+    static constexpr uint64_t k_max_stream_size = 3ull * 1024 * 1024 * 1024;
 
     uint32_t activity_timeout_seconds = 2; // kill the connection after this number of seconds
 
@@ -52,11 +65,48 @@ namespace neam::resources::network
       packet_header_t header;
       raw_data data;
     };
+
+    struct pending_request_t
+    {
+      uint16_t command_id;
+      response_chain_t chain;
+    };
+
+    /// \brief Called when a request can be processed. The handler must (eventually) call send_response() for the request.
+    /// \note Can be called from any thread (including the io thread), so it should not stall
+    std::function<void(connection_t&, queued_request_t&&)> request_handler;
+
+    /// \brief Called for requests that don't need a response (like index_reloaded_event)
+    std::function<void(connection_t&, const packet_header_t&)> event_handler;
+
+    // client side:
+    spinlock responses_lock;
     std::unordered_map<uint16_t, response_chain_t::state> requests_awaiting_response;
+    struct partial_response_t
+    {
+      packet_header_t header;
+      std::vector<raw_data> parts;
+      uint64_t size = 0;
+    };
+    std::unordered_map<uint16_t, partial_response_t> partial_responses;
+    uint16_t next_command_id = 0;
 
+    // server side:
     spinlock received_requests_lock;
     std::unordered_map<uint16_t, queued_request_t> received_requests;
-    // cr::queue_ts<cr::queue_ts_wrapper<queued_request_t>> received_requests;
+    std::deque<uint16_t> received_requests_order; // so requests are processed in order
+    std::unordered_set<uint16_t> active_requests;
+    std::unordered_set<uint16_t> canceled_active_requests;
+
+    struct outgoing_stream_t
+    {
+      command_t command;
+      uint16_t command_id;
+      raw_data data; // whole packet (including the header of the first packet)
+      uint64_t offset;
+    };
+    spinlock streams_lock;
+    std::deque<outgoing_stream_t> outgoing_streams;
 
     void on_error(std::string&& message) const
     {
@@ -99,12 +149,7 @@ namespace neam::resources::network
       // Handle responses asap:
       if ((ph.code & code_t::rr_mask) == code_t::response)
       {
-        if (auto it = requests_awaiting_response.find(ph.command_id); it != requests_awaiting_response.end())
-        {
-          if (!it->second.is_canceled())
-            it->second(ph, std::move(packet_data));
-          requests_awaiting_response.erase(it);
-        }
+        on_response(ph, std::move(packet_data));
       }
       else // otherwise: queue requests
       {
@@ -116,10 +161,17 @@ namespace neam::resources::network
           {
             const uint16_t command_id = packet_data.get_as<commands::req_cancel_request_t>()->request_id;
 
-            std::lock_guard _lg{received_requests_lock};
             {
+              std::lock_guard _lg{received_requests_lock};
               received_requests.erase(command_id);
-              // FIXME: cancel in-flight requests (only read requests, only if possible)
+              // in-flight requests: their response will be dropped
+              if (active_requests.contains(command_id))
+                canceled_active_requests.emplace(command_id);
+            }
+            {
+              // streams in progress are stopped
+              std::lock_guard _lg{streams_lock};
+              std::erase_if(outgoing_streams, [command_id](const outgoing_stream_t& it) { return it.command_id == command_id; });
             }
           }
           else
@@ -129,42 +181,304 @@ namespace neam::resources::network
             return;
           }
         }
+        else if (ph.command == command_t::index_reloaded_event)
+        {
+          // events don't need a response nor an id
+          if (event_handler)
+            event_handler(*this, ph);
+        }
         else
         {
-          std::lock_guard _lg{received_requests_lock};
-          if (received_requests.contains(ph.command_id))
           {
-            // non recoverable error, as those requests are now indistinguishable
-            on_error("malformed request: duplicate command id found");
-            close();
-            return;
-          }
-          if (received_requests.size() > max_queued_request_count || received_requests.size() > k_max_queued_request_count)
-          {
-            // non recoverable error, too many requests
-            on_error("received_requests size is above the set maximum");
-            close();
-            return;
-          }
+            std::lock_guard _lg{received_requests_lock};
+            if (received_requests.contains(ph.command_id) || active_requests.contains(ph.command_id))
+            {
+              // non recoverable error, as those requests are now indistinguishable
+              on_error("malformed request: duplicate command id found");
+              close();
+              return;
+            }
+            if (received_requests.size() > max_queued_request_count || received_requests.size() > k_max_queued_request_count)
+            {
+              // non recoverable error, too many requests
+              on_error("received_requests size is above the set maximum");
+              close();
+              return;
+            }
 
-          received_requests.emplace(ph.command_id, queued_request_t{ph, std::move(packet_data)});
+            received_requests.emplace(ph.command_id, queued_request_t{ph, std::move(packet_data)});
+            received_requests_order.push_back(ph.command_id);
+          }
+          process_requests();
         }
       }
     }
 
-    void process_single_request()
+    /// \brief Process as many requests as possible (depends on max_active_request_count)
+    void process_requests()
+    {
+      while (process_single_request()) {}
+    }
+
+    /// \brief Process a single request (if there's one and if the number of active requests allows it)
+    /// \return whether a request was processed
+    bool process_single_request()
     {
       queued_request_t rq;
       {
         std::lock_guard _lg{received_requests_lock};
-        if (received_requests.empty()) return;
+        if (active_requests.size() >= std::min(max_active_request_count, k_max_active_request_count))
+          return false;
+
+        // skip canceled requests
+        while (!received_requests_order.empty() && !received_requests.contains(received_requests_order.front()))
+          received_requests_order.pop_front();
+        if (received_requests_order.empty())
+          return false;
+
+        auto it = received_requests.find(received_requests_order.front());
+        received_requests_order.pop_front();
+        rq = std::move(it->second);
+        received_requests.erase(it);
+        active_requests.emplace(rq.header.command_id);
+      }
+
+      if (request_handler)
+        request_handler(*this, std::move(rq));
+      else
+        send_response(rq.header.command_id, form_error_packet(rq.header.command, rq.header.command_id, error_code_t::not_supported));
+      return true;
+    }
+
+    /// \brief Send the response for a request (given to the request_handler)
+    /// Big responses are split in multiple packets (the first one is sent immediately, the others are sent by pump_streams())
+    void send_response(uint16_t command_id, raw_data&& packet)
+    {
+      bool is_canceled = false;
+      {
+        std::lock_guard _lg{received_requests_lock};
+        active_requests.erase(command_id);
+        is_canceled = canceled_active_requests.erase(command_id) > 0;
+      }
 
-        rq = std::move(received_requests.begin()->second);
-        received_requests.erase(received_requests.begin());
+      if (!is_canceled)
+      {
+        if (packet.size <= sizeof(packet_header_t) + k_stream_chunk_size)
+        {
+          send(std::move(packet));
+        }
+        else
+        {
+          const packet_header_t ph = *packet.get_as<packet_header_t>();
+          raw_data first = raw_data::allocate(sizeof(packet_header_t) + k_stream_chunk_size);
+          memcpy(first.get(), packet.get(), first.size);
+          first.get_as<packet_header_t>()->size = k_stream_chunk_size;
+          first.get_as<packet_header_t>()->code = ph.code | code_t::has_more;
+          send(std::move(first));
+
+          std::lock_guard _lg{streams_lock};
+          outgoing_streams.push_back({ph.command, command_id, std::move(packet), sizeof(packet_header_t) + k_stream_chunk_size});
+        }
       }
 
-      // FIXME: do the thing
+      // a slot is now free:
+      process_requests();
     }
+
+    /// \brief Send the next packet of every stream in progress (round-robin, so that big responses don't block the other ones)
+    /// \return whether there are still streams in progress
+    bool pump_streams()
+    {
+      std::vector<raw_data> packets;
+      bool has_streams = false;
+      {
+        std::lock_guard _lg{streams_lock};
+        packets.reserve(outgoing_streams.size());
+        for (auto& it : outgoing_streams)
+        {
+          const uint32_t size = (uint32_t)std::min<uint64_t>(k_stream_chunk_size, it.data.size - it.offset);
+          const bool has_more = it.offset + size < it.data.size;
+          packets.push_back(form_continuation_packet(it.command, it.command_id, it.data.get_as<uint8_t>() + it.offset, size, has_more));
+          it.offset += size;
+        }
+        std::erase_if(outgoing_streams, [](const outgoing_stream_t& it) { return it.offset >= it.data.size; });
+        has_streams = !outgoing_streams.empty();
+      }
+
+      for (auto& it : packets)
+        send(std::move(it));
+      return has_streams;
+    }
+
+    /// \brief Send a request. The returned chain is completed with the response (which can be an error)
+    template<command_t Command>
+    pending_request_t send_request(const commands::request_t<Command>& request = {}, raw_data&& extra_data = {})
+    {
+      pending_request_t ret;
+      {
+        std::lock_guard _lg{responses_lock};
+        check::debug::n_assert(requests_awaiting_response.size() < 0xFFFF, "connection::send_request: too many requests in-flight");
+        do
+        {
+          ret.command_id = next_command_id++;
+        }
+        while (requests_awaiting_response.contains(ret.command_id));
+        requests_awaiting_response.emplace(ret.command_id, ret.chain.create_state());
+      }
+      send(form_request_packet<Command>(ret.command_id, request, std::move(extra_data)));
+      return ret;
+    }
+
+    /// \brief Cancel a request. The chain for that request is completed with a canceled error.
+    /// \note The server may still send a response (which will be ignored)
+    void cancel_request(uint16_t command_id)
+    {
+      std::optional<response_chain_t::state> state;
+      {
+        std::lock_guard _lg{responses_lock};
+        if (auto it = requests_awaiting_response.find(command_id); it != requests_awaiting_response.end())
+        {
+          state.emplace(std::move(it->second));
+          requests_awaiting_response.erase(it);
+        }
+        partial_responses.erase(command_id);
+      }
+      if (!state)
+        return;
+
+      send(form_request_packet<command_t::cancel_request>(0, { .request_id = command_id }));
+      complete_with_error(*state, command_id, error_code_t::canceled);
+    }
+
+    /// \brief Complete all the requests awaiting a response with a canceled error (to be called when the connection is closed)
+    void fail_pending_requests()
+    {
+      std::unordered_map<uint16_t, response_chain_t::state> to_fail;
+      {
+        std::lock_guard _lg{responses_lock};
+        std::swap(to_fail, requests_awaiting_response);
+        partial_responses.clear();
+      }
+      for (auto& it : to_fail)
+        complete_with_error(it.second, it.first, error_code_t::canceled);
+    }
+
+    /// \brief Return the error code of a response (none if the response does not contain an error)
+    static error_code_t get_error(const packet_header_t& ph, const raw_data& packet_data)
+    {
+      if ((ph.code & code_t::has_error) == code_t::none)
+        return error_code_t::none;
+      if (packet_data.size < sizeof(error_response_t))
+        return error_code_t::failed;
+      return packet_data.get_as<error_response_t>()->error_code;
+    }
+
+    /// \brief Return the response data (skipping the error)
+    template<command_t Command>
+    static const commands::response_t<Command>* get_response(const packet_header_t& ph, const raw_data& packet_data)
+    {
+      if ((ph.code & code_t::has_data) == code_t::none)
+        return nullptr;
+      const size_t offset = (ph.code & code_t::has_error) == code_t::has_error ? sizeof(error_response_t) : 0;
+      if (packet_data.size < offset + sizeof(commands::response_t<Command>))
+        return nullptr;
+      return (const commands::response_t<Command>*)(packet_data.get_as<uint8_t>() + offset);
+    }
+
+    /// \brief Return the extra data of the response (after the error and the response struct)
+    template<command_t Command>
+    static std::span<const uint8_t> get_response_extra_data(const packet_header_t& ph, const raw_data& packet_data)
+    {
+      using response_t = commands::response_t<Command>;
+      if ((ph.code & code_t::has_data) == code_t::none)
+        return {};
+      size_t offset = (ph.code & code_t::has_error) == code_t::has_error ? sizeof(error_response_t) : 0;
+      if constexpr (!std::is_same_v<response_t, internal::empty_t>)
+        offset += sizeof(response_t);
+      if (packet_data.size < offset)
+        return {};
+      return { packet_data.get_as<uint8_t>() + offset, packet_data.size - offset };
+    }
+
+    private:
+      static void complete_with_error(response_chain_t::state& state, uint16_t command_id, error_code_t error)
+      {
+        const packet_header_t ph
+        {
+          .magic = packet_header_t::k_magic ^ packet_header_t::k_version,
+          .size = (uint32_t)sizeof(error_response_t),
+          .command = command_t::cancel_request,
+          .code = code_t::response | code_t::has_error,
+          .command_id = command_id,
+        };
+        raw_data data = raw_data::allocate(sizeof(error_response_t));
+        data.get_as<error_response_t>()->error_code = error;
+        state.complete(ph, std::move(data));
+      }
+
+      void on_response(const packet_header_t& ph, raw_data&& packet_data)
+      {
+        const bool is_continuation = (ph.code & code_t::continuation) == code_t::continuation;
+        const bool has_more = (ph.code & code_t::has_more) == code_t::has_more;
+
+        std::optional<response_chain_t::state> state;
+        packet_header_t final_header = ph;
+        raw_data final_data;
+        {
+          std::lock_guard _lg{responses_lock};
+          auto it = requests_awaiting_response.find(ph.command_id);
+          if (it == requests_awaiting_response.end())
+            return; // canceled request, or a response that arrived too late
+
+          if (!is_continuation && !has_more)
+          {
+            final_data = std::move(packet_data);
+          }
+          else
+          {
+            auto pit = partial_responses.find(ph.command_id);
+            if (is_continuation == (pit == partial_responses.end()))
+            {
+              on_error(is_continuation ? "malformed response: continuation without a stream" : "malformed response: stream started twice");
+              close();
+              return;
+            }
+            if (!is_continuation)
+              pit = partial_responses.emplace(ph.command_id, partial_response_t{ .header = ph }).first;
+
+            partial_response_t& partial = pit->second;
+            partial.size += packet_data.size;
+            if (partial.size > k_max_stream_size)
+            {
+              on_error("malformed response: stream is too big");
+              close();
+              return;
+            }
+            partial.parts.push_back(std::move(packet_data));
+            if (has_more)
+              return;
+
+            // last packet of the stream: assemble the response
+            final_header = partial.header;
+            final_header.code = final_header.code & ~code_t::has_more;
+            final_header.size = (uint32_t)partial.size;
+            final_data = raw_data::allocate(partial.size);
+            uint64_t offset = 0;
+            for (const raw_data& part : partial.parts)
+            {
+              memcpy(final_data.get_as<uint8_t>() + offset, part.get(), part.size);
+              offset += part.size;
+            }
+            partial_responses.erase(pit);
+          }
+
+          state.emplace(std::move(it->second));
+          requests_awaiting_response.erase(it);
+        }
+
+        if (!state->is_canceled())
+          state->complete(final_header, std::move(final_data));
+      }
   };
 }
 
@@ -74,6 +74,12 @@ namespace neam::resources::network
 
     has_error = 1 << 4, // if the reply contains an error packet
     has_data = 1 << 5, // if the reply contains a data packet
+
+    // streaming: responses bigger than k_stream_chunk_size are sent as multiple packets with the same command id
+    // The first packet is a normal response (with has_more set), the following ones only contain raw data (and have continuation set)
+    // The last packet of the stream does not have has_more set. The packets of different streams can be interleaved.
+    has_more = 1 << 6, // if more packets follow this one (for the same command id)
+    continuation = 1 << 7, // if the packet is the continuation of a previous one (raw data, no response struct)
   };
   N_ENUM_FLAG(code_t)
 
@@ -81,12 +87,18 @@ namespace neam::resources::network
   {
     none,
     not_found,
+    not_supported, // the server cannot handle the request (no source folder, no rel-db, ...)
+    failed, // the server failed to process the request
+    canceled, // only generated locally, when a request is canceled / the connection is closed
   };
 
+  /// \brief Maximum size of a packet in a stream. Anything bigger will be split.
+  static constexpr uint32_t k_stream_chunk_size = 1024 * 1024;
+
   struct packet_header_t
   {
     static constexpr uint32_t k_magic = 0x4F5A3B00;
-    static constexpr uint32_t k_version = 0x01;
+    static constexpr uint32_t k_version = 0x02;
 
     uint32_t magic;
     uint32_t size;
@@ -122,7 +134,8 @@ namespace neam::resources::network
     template<command_t C> using request_t = typename rr_command_types_t<C>::request_t;
     template<command_t C> using response_t = typename rr_command_types_t<C>::response_t;
 
-    template<> struct rr_command_types_t<command_t::hello> : public internal::rr_pait_t<internal::empty_t, void> {};
+    // the server acknowledges the hello (empty response), so the client knows the connection is usable
+    template<> struct rr_command_types_t<command_t::hello> : public internal::rr_pait_t<internal::empty_t, internal::empty_t> {};
     template<> struct rr_command_types_t<command_t::index_reloaded_event> : public internal::rr_pait_t<internal::empty_t, void> {};
 
     struct req_has_resource_t
@@ -166,6 +179,8 @@ namespace neam::resources::network
   template<command_t Command> constexpr size_t packet_size(code_t code)
   {
     size_t ret = sizeof(packet_header_t);
+    if ((code & code_t::continuation) == code_t::continuation)
+      return ret;
     if ((code & code_t::has_data) == code_t::has_data)
     {
       if ((code & code_t::rr_mask) == code_t::request)
@@ -202,6 +217,17 @@ namespace neam::resources::network
 
   template<command_t Command> constexpr size_t is_command_valid(code_t code)
   {
+    // only responses can be streamed:
+    if ((code & (code_t::has_more | code_t::continuation)) != code_t::none)
+    {
+      if ((code & code_t::rr_mask) != code_t::response)
+        return false;
+      if constexpr(std::is_same_v<commands::response_t<Command>, void>)
+        return false;
+      if ((code & code_t::continuation) == code_t::continuation)
+        return true;
+    }
+
     if ((code & code_t::has_data) == code_t::has_data)
     {
       if ((code & code_t::rr_mask) == code_t::request)
@@ -300,6 +326,74 @@ namespace neam::resources::network
     memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t) + sizeof(error) + sizeof(response), extra_data.get(), extra_data.size);
     return rd;
   }
-}
 
+  /// \brief Form a request packet. Handle requests without data (empty_t)
+  template<command_t Command>
+  [[nodiscard]] raw_data form_request_packet(uint16_t command_id, const commands::request_t<Command>& request = {}, raw_data&& extra_data = {})
+  {
+    using request_t = commands::request_t<Command>;
+    static_assert(!std::is_same_v<request_t, void>, "Command cannot be sent as a request");
+    static_assert(std::is_standard_layout_v<request_t>, "Only standard layout types are supported here");
+
+    constexpr size_t request_size = std::is_same_v<request_t, internal::empty_t> ? 0 : sizeof(request_t);
+    raw_data rd = form_packet<Command, code_t::request | code_t::has_data>(command_id, (uint32_t)extra_data.size);
+    if constexpr (request_size > 0)
+      memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t), &request, request_size);
+    if (extra_data.size > 0)
+      memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t) + request_size, extra_data.get(), extra_data.size);
+    return rd;
+  }
+
+  /// \brief Form a response packet. Handle responses without data (empty_t)
+  template<command_t Command>
+  [[nodiscard]] raw_data form_response_packet(uint16_t command_id, const commands::response_t<Command>& response = {}, raw_data&& extra_data = {})
+  {
+    using response_t = commands::response_t<Command>;
+    static_assert(!std::is_same_v<response_t, void>, "Command does not have a response");
+    static_assert(std::is_standard_layout_v<response_t>, "Only standard layout types are supported here");
+
+    constexpr size_t response_size = std::is_same_v<response_t, internal::empty_t> ? 0 : sizeof(response_t);
+    raw_data rd = form_packet<Command, code_t::response | code_t::has_data>(command_id, (uint32_t)extra_data.size);
+    if constexpr (response_size > 0)
+      memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t), &response, response_size);
+    if (extra_data.size > 0)
+      memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t) + response_size, extra_data.get(), extra_data.size);
+    return rd;
+  }
+
+  /// \brief Form an error response (without data)
+  [[nodiscard]] inline raw_data form_error_packet(command_t command, uint16_t command_id, error_code_t error)
+  {
+    raw_data rd = raw_data::allocate(sizeof(packet_header_t) + sizeof(error_response_t));
+    packet_header_t* ph = rd.get_as<packet_header_t>();
+    *ph =
+    {
+      .magic = packet_header_t::k_magic ^ packet_header_t::k_version,
+      .size = (uint32_t)sizeof(error_response_t),
+      .command = command,
+      .code = code_t::response | code_t::has_error,
+      .command_id = command_id,
+    };
+    const error_response_t err { error };
+    memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t), &err, sizeof(err));
+    return rd;
+  }
+
+  /// \brief Create the continuation packet of a stream
+  [[nodiscard]] inline raw_data form_continuation_packet(command_t command, uint16_t command_id, const uint8_t* data, uint32_t size, bool has_more)
+  {
+    raw_data rd = raw_data::allocate(sizeof(packet_header_t) + size);
+    packet_header_t* ph = rd.get_as<packet_header_t>();
+    *ph =
+    {
+      .magic = packet_header_t::k_magic ^ packet_header_t::k_version,
+      .size = size,
+      .command = command,
+      .code = code_t::response | code_t::continuation | (has_more ? code_t::has_more : code_t::none),
+      .command_id = command_id,
+    };
+    memcpy(rd.get_as<uint8_t>() + sizeof(packet_header_t), data, size);
+    return rd;
+  }
+}
 
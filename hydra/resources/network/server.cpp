@@ -0,0 +1,248 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <filesystem>
+
+#include "server.hpp"
+#include "../context.hpp"
+
+namespace neam::resources::network
+{
+  server::server(context& _res_ctx) : res_ctx(_res_ctx) {}
+
+  server::~server()
+  {
+    stop();
+  }
+
+  bool server::listen(uint16_t port, const std::string& host)
+  {
+    stop();
+
+    listen_socket = res_ctx.get_io_context().create_listening_socket(host.c_str(), port);
+    if (listen_socket == id_t::invalid)
+    {
+      cr::out().error("resource server: failed to listen on {}:{}", host, port);
+      return false;
+    }
+
+    cr::out().log("resource server: listening on {}:{}", host, port);
+    on_index_loaded_tk = res_ctx.on_index_loaded.add([this]
+    {
+      broadcast_index_reloaded();
+    });
+
+    accept_next();
+    return true;
+  }
+
+  void server::stop()
+  {
+    on_index_loaded_tk.release();
+
+    if (listen_socket != id_t::invalid)
+    {
+      res_ctx.get_io_context().close(listen_socket);
+      listen_socket = id_t::invalid;
+    }
+
+    std::vector<std::shared_ptr<connection_t>> to_close;
+    {
+      std::lock_guard _lg { connections_lock };
+      std::swap(to_close, connections);
+    }
+    for (auto& it : to_close)
+    {
+      it->request_handler = {};
+      it->close();
+    }
+  }
+
+  void server::accept_next()
+  {
+    res_ctx.get_io_context().queue_accept(listen_socket).then([this](id_t socket)
+    {
+      if (socket == id_t::invalid || !is_listening())
+        return;
+
+      std::shared_ptr<connection_t> conn = std::make_shared<connection_t>();
+      conn->request_handler = [this](connection_t& c, connection_t::queued_request_t&& rq)
+      {
+        on_request(c, std::move(rq));
+      };
+      {
+        std::lock_guard _lg { connections_lock };
+        connections.push_back(conn);
+      }
+      ++connection_count;
+      cr::out().debug("resource server: new connection (socket: {})", socket);
+      conn->setup(res_ctx.get_io_context(), socket);
+
+      accept_next();
+    });
+  }
+
+  void server::update()
+  {
+    std::vector<std::shared_ptr<connection_t>> conns;
+    {
+      std::lock_guard _lg { connections_lock };
+      std::erase_if(connections, [](const std::shared_ptr<connection_t>& it) { return it->is_closed(); });
+      conns = connections;
+    }
+
+    for (auto& it : conns)
+      it->pump_streams();
+  }
+
+  void server::broadcast_index_reloaded()
+  {
+    std::lock_guard _lg { connections_lock };
+    for (auto& it : connections)
+    {
+      if (!it->is_closed())
+        it->send(form_packet<command_t::index_reloaded_event, code_t::request | code_t::has_data>(0));
+    }
+  }
+
+  uint32_t server::get_connection_count() const
+  {
+    std::lock_guard _lg { connections_lock };
+    return (uint32_t)connections.size();
+  }
+
+  server::stats_t server::get_stats() const
+  {
+    return
+    {
+      .connection_count = connection_count,
+      .request_count = request_count,
+      .failed_request_count = failed_request_count,
+      .sent_bytes = sent_bytes,
+    };
+  }
+
+  void server::send_error(connection_t& conn, command_t command, uint16_t command_id, error_code_t error)
+  {
+    ++failed_request_count;
+    conn.send_response(command_id, form_error_packet(command, command_id, error));
+  }
+
+  void server::on_request(connection_t& conn, connection_t::queued_request_t&& rq)
+  {
+    ++request_count;
+
+    const uint16_t command_id = rq.header.command_id;
+    if ((rq.header.code & code_t::has_data) == code_t::none)
+      return send_error(conn, rq.header.command, command_id, error_code_t::failed);
+
+    switch (rq.header.command)
+    {
+      case command_t::hello:
+        conn.send_response(command_id, form_response_packet<command_t::hello>(command_id));
+        return;
+      case command_t::has_resource: return handle_has_resource(conn, rq);
+      case command_t::read_raw_resource: return handle_read_raw_resource(conn, rq);
+      case command_t::read_source_file: return handle_read_source_file(conn, rq);
+      case command_t::get_reldb: return handle_get_reldb(conn, rq);
+      default:
+        return send_error(conn, rq.header.command, command_id, error_code_t::not_supported);
+    }
+  }
+
+  void server::handle_has_resource(connection_t& conn, const connection_t::queued_request_t& rq)
+  {
+    const uint16_t command_id = rq.header.command_id;
+    const id_t rid = rq.data.get_as<commands::req_has_resource_t>()->resource;
+    res_ctx.has_resource(rid).then([conn = conn.shared_from_this(), command_id](bool has_resource)
+    {
+      conn->send_response(command_id, form_response_packet<command_t::has_resource>(command_id, { .has_resource = has_resource }));
+    });
+  }
+
+  void server::handle_read_raw_resource(connection_t& conn, const connection_t::queued_request_t& rq)
+  {
+    const uint16_t command_id = rq.header.command_id;
+    const id_t rid = rq.data.get_as<commands::req_read_raw_resource_t>()->resource;
+    if (!res_ctx.get_index().has_entry(rid))
+      return send_error(conn, command_t::read_raw_resource, command_id, error_code_t::not_found);
+
+    // compressed resources are sent as-is, the client does the decompression
+    bool is_compressed = false;
+    res_ctx._read_stored_resource(rid, is_compressed)
+    .then([this, conn = conn.shared_from_this(), command_id, is_compressed](raw_data&& data, bool success, uint32_t)
+    {
+      if (!success)
+        return send_error(*conn, command_t::read_raw_resource, command_id, error_code_t::failed);
+
+      sent_bytes += data.size;
+      conn->send_response(command_id, form_response_packet<command_t::read_raw_resource>(command_id, { .is_compressed = is_compressed }, std::move(data)));
+    });
+  }
+
+  void server::handle_read_source_file(connection_t& conn, const connection_t::queued_request_t& rq)
+  {
+    const uint16_t command_id = rq.header.command_id;
+    if (res_ctx.source_folder.empty() || !res_ctx.has_db())
+      return send_error(conn, command_t::read_source_file, command_id, error_code_t::not_supported);
+
+    // the file id is the id of the path, relative to the source folder. Only the files the rel-db knows about can be read.
+    const id_t file = rq.data.get_as<commands::req_read_source_file_t>()->file;
+    const std::filesystem::path relative_path = std::filesystem::path(res_ctx.get_db().resource_name(file)).lexically_normal();
+    if (relative_path.empty() || relative_path.is_absolute() || *relative_path.begin() == "..")
+      return send_error(conn, command_t::read_source_file, command_id, error_code_t::not_found);
+
+    const std::filesystem::path path = res_ctx.source_folder / relative_path;
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec))
+      return send_error(conn, command_t::read_source_file, command_id, error_code_t::not_found);
+
+    io::context& io = res_ctx.get_io_context();
+    const id_t fid = io.map_unprefixed_file(path);
+    io.queue_read(fid, 0, io::context::whole_file)
+    .then([this, &io, fid, conn = conn.shared_from_this(), command_id](raw_data&& data, bool success, size_t)
+    {
+      io.unmap_file(fid);
+      if (!success)
+        return send_error(*conn, command_t::read_source_file, command_id, error_code_t::failed);
+
+      sent_bytes += data.size;
+      conn->send_response(command_id, form_response_packet<command_t::read_source_file>(command_id, {}, std::move(data)));
+    });
+  }
+
+  void server::handle_get_reldb(connection_t& conn, const connection_t::queued_request_t& rq)
+  {
+    const uint16_t command_id = rq.header.command_id;
+    if (!res_ctx.has_db())
+      return send_error(conn, command_t::get_reldb, command_id, error_code_t::not_supported);
+
+    raw_data data = res_ctx._get_serialized_reldb();
+    sent_bytes += data.size;
+    conn.send_response(command_id, form_response_packet<command_t::get_reldb>(command_id, {}, std::move(data)));
+  }
+}
+
@@ -22,11 +22,86 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
-//
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include <ntools/event.hpp>
+#include <ntools/spinlock.hpp>
+
+#include "connection.hpp"
+
+namespace neam::resources
+{
+  class context;
+}
+
 namespace neam::resources::network
 {
+  /// \brief Serve the resources of a resources::context over the network (see client)
+  /// Requests of a connection are pipelined (up to connection_t::max_active_request_count are processed at the same time)
+  /// Resources are sent as they are stored (compressed resources stay compressed, decompression is done by the client)
+  ///
+  /// \note update() must be called regularly (once per frame is fine): it sends the pending parts of the streamed responses
+  class server
+  {
+    public:
+      struct stats_t
+      {
+        uint64_t connection_count = 0; // total number of accepted connections
+        uint64_t request_count = 0;
+        uint64_t failed_request_count = 0;
+        uint64_t sent_bytes = 0; // payload only
+      };
+
+    public:
+      server(context& _res_ctx);
+      ~server();
+
+      /// \brief Start accepting connections
+      /// \return false if the server could not listen on the port
+      bool listen(uint16_t port, const std::string& host = "0.0.0.0");
+
+      /// \brief Close all the connections and stop listening
+      void stop();
+
+      /// \brief Send the pending stream packets and cleanup closed connections
+      void update();
+
+      /// \brief Notify all the connected clients that the index has changed
+      void broadcast_index_reloaded();
+
+      bool is_listening() const { return listen_socket != id_t::invalid; }
+      uint32_t get_connection_count() const;
+      stats_t get_stats() const;
+
+    private:
+      void accept_next();
+      void on_request(connection_t& conn, connection_t::queued_request_t&& rq);
+
+      void handle_has_resource(connection_t& conn, const connection_t::queued_request_t& rq);
+      void handle_read_raw_resource(connection_t& conn, const connection_t::queued_request_t& rq);
+      void handle_read_source_file(connection_t& conn, const connection_t::queued_request_t& rq);
+      void handle_get_reldb(connection_t& conn, const connection_t::queued_request_t& rq);
+
+      void send_error(connection_t& conn, command_t command, uint16_t command_id, error_code_t error);
+
+    private:
+      context& res_ctx;
+
+      id_t listen_socket = id_t::invalid;
+
+      mutable spinlock connections_lock;
+      std::vector<std::shared_ptr<connection_t>> connections;
+
+      std::atomic<uint64_t> connection_count = 0;
+      std::atomic<uint64_t> request_count = 0;
+      std::atomic<uint64_t> failed_request_count = 0;
+      std::atomic<uint64_t> sent_bytes = 0;
+
+      cr::event_token_t on_index_loaded_tk;
+  };
 }
 
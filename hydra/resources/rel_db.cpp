@@ -113,6 +113,14 @@ namespace neam::resources
     get_dependent_files_unlocked(file, ret);
   }
 
+  bool rel_db::has_file_dependencies(const std::string& file) const
+  {
+    std::lock_guard _sl(spinlock_shared_adapter::adapt(lock));
+    if (auto it = files_resources.find(file); it != files_resources.end())
+      return !it->second.depend_on.empty();
+    return false;
+  }
+
   void rel_db::get_dependent_files_unlocked(const std::filesystem::path& file, std::set<std::filesystem::path>& ret) const
   {
     if (auto it = files_resources.find(file); it != files_resources.end())
@@ -290,6 +298,16 @@ namespace neam::resources
     root_resources[root_resource].pack_file = pack_file_id;
   }
 
+  void rel_db::replace_pack_file(id_t old_pack_file, id_t new_pack_file)
+  {
+    std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
+    for (auto& it : root_resources)
+    {
+      if (it.second.pack_file == old_pack_file)
+        it.second.pack_file = new_pack_file;
+    }
+  }
+
   void rel_db::set_packer_for_resource(id_t root_resource, id_t packer_hash)
   {
     std::lock_guard _el(spinlock_exclusive_adapter::adapt(lock));
@@ -81,6 +81,9 @@ namespace neam::resources
       /// \brief insert all the files that \e directly \e and \e indirectly depend on the given file
       void get_dependent_files(const std::filesystem::path& file, std::set<std::filesystem::path>& ret) const;
 
+      /// \brief return whether the file depends on other files (see add_file_to_file_dependency)
+      bool has_file_dependencies(const std::string& file) const;
+
       /// \brief add to file_list all the files that have \e direct \e and \e indirect dependencies to them
       void consolidate_files_with_dependencies(std::set<std::filesystem::path>& file_list) const;
 
@@ -162,6 +165,8 @@ namespace neam::resources
       void add_resource(const std::string& parent_file, id_t root_resource);
       void add_resource(id_t root_resource, id_t child_resource);
       void set_pack_file(id_t root_resource, id_t pack_file_id);
+      /// \brief Change the pack file of all the root resources using old_pack_file (used when repacking)
+      void replace_pack_file(id_t old_pack_file, id_t new_pack_file);
       void set_packer_for_resource(id_t root_resource, id_t packer_hash);
 
       void remove_file(const std::string& file);
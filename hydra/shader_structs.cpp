@@ -30,4 +30,6 @@
 #include "renderer/shader_structs.hpp"
 #include "renderer/generic_shaders/shader_structs.hpp"
 #include "renderer/resources/texture_manager_shader_structs.hpp"
+#include "renderer/resources/transform_manager_shader_structs.hpp"
+#include "renderer/resources/mesh_manager_shader_structs.hpp"
 #include "imgui/shader_structs.hpp"
@@ -45,7 +45,12 @@ namespace neam::hydra::allocator
         return memory_allocation(block._get_memory_type_index(), nullptr, vk::device_memory::allocate(device, size, block._get_memory_type_index()));
       }
       case allocation_type::persistent:
-        [[fallthrough]]; // FIXME!
+      {
+        // big allocations are better served by the block allocator directly:
+        if (size <= persistent_pool::k_max_allocation_size)
+          return persistent.allocate(size, alignment);
+        [[fallthrough]];
+      }
       case allocation_type::block_level:
       {
         return block.block_level_allocation((size + block_allocator::k_block_size - 1) / block_allocator::k_block_size);
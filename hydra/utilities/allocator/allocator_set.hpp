@@ -29,15 +29,25 @@
 #include "block_allocator.hpp"
 #include "scoped_pool.hpp"
 #include "transient_pool.hpp"
+#include "persistent_pool.hpp"
 
 namespace neam::hydra::allocator
 {
   class pool_set
   {
     public:
-      pool_set(vk::device& dev, uint32_t memory_type_index, bool map_memory = false)
+      struct stats_t
+      {
+        uint64_t allocated_memory = 0; // memory allocated from the driver
+        persistent_pool::stats_t persistent;
+      };
+
+    public:
+      /// \param buffer_image_granularity should be 1 if the pool will never hold both linear and non-linear resources
+      pool_set(vk::device& dev, uint32_t memory_type_index, bool map_memory = false, uint32_t buffer_image_granularity = 1)
         : device(dev)
         , block(device, memory_type_index)
+        , persistent(block, buffer_image_granularity)
       {
         block._should_map_memory(map_memory);
       }
@@ -48,12 +58,19 @@ namespace neam::hydra::allocator
 
       uint64_t get_allocated_memory() const { return block.get_allocated_memory(); }
 
+      stats_t get_stats() const { return { block.get_allocated_memory(), persistent.get_stats() }; }
+
+      uint32_t _get_memory_type_index() const { return block._get_memory_type_index(); }
+
+      void _check_consistency() const { persistent._check_consistency(); }
+
     private:
       vk::device& device;
 
       block_allocator block;
       scoped_pool scoped { block };
       transient_pool transient { block };
+      persistent_pool persistent;
   };
 }
 
@@ -37,6 +37,8 @@ namespace neam::hydra::allocator
     check::debug::n_assert(block_count > 0, "block_level_allocation: cannot allocate 0 blocks (block count must be > 0)");
     const uint64_t mask = (~uint64_t(0)) >> (64 - block_count);
 
+    std::lock_guard _lg(lock);
+
     // go over allocations:
     for (auto& alloc : allocations)
     {
@@ -129,6 +131,7 @@ namespace neam::hydra::allocator
     const uint64_t shifted_additional_mask = additional_mask << end_shift;
 
     raw_allocation& alloc = *(raw_allocation*)(mem.mem());
+    std::lock_guard _lg(lock);
     if ((alloc.free_mask & shifted_additional_mask) == shifted_additional_mask)
     {
       alloc.free_mask &= ~shifted_additional_mask;
@@ -148,6 +151,7 @@ namespace neam::hydra::allocator
     const uint64_t mask = (~uint64_t(0)) >> (64 - block_count);
 
     raw_allocation& alloc = *(raw_allocation*)(mem.mem());
+    std::lock_guard _lg(lock);
     alloc.free_mask |= mask << shift;
   }
 }
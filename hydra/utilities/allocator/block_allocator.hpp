@@ -27,6 +27,7 @@
 #pragma once
 
 #include <ntools/mt_check/deque.hpp>
+#include <ntools/spinlock.hpp>
 
 #include "../memory_allocation.hpp"
 #include "allocator.hpp"
@@ -39,6 +40,7 @@ namespace neam::hydra::allocator
   /// Allocations bigger than k_max_raw_allocation_size cannot be handled by the block-allocator.
   ///
   /// Deallocation is extremely fast, allocations can be slow if fragmentation is high
+  /// All operations are thread-safe (the pools using the block allocator can be used from different threads)
   class block_allocator final : allocator_interface
   {
     public:
@@ -82,6 +84,7 @@ namespace neam::hydra::allocator
 
       vk::device& device;
 
+      spinlock lock;
       std::mtc_deque<raw_allocation> allocations;
 
       // min number of block to allocate at once in a raw allocation. Can be changed, and will increase WRT the number of raw allocations currently alive
@@ -0,0 +1,405 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <ntools/tracy.hpp>
+
+#include "persistent_pool.hpp"
+#include "block_allocator.hpp"
+
+namespace neam::hydra::allocator
+{
+  static constexpr uint32_t align(uint32_t value, uint32_t alignment)
+  {
+    return (value - 1u + alignment) & -alignment;
+  }
+
+  static_assert(persistent_pool::k_max_allocation_size < block_allocator::k_block_size);
+
+  persistent_pool::~persistent_pool()
+  {
+    std::lock_guard _lg(lock);
+    check::debug::n_assert(allocation_count == 0, "persistent_pool: destructing a pool which still has {} allocations", allocation_count);
+
+    for (chunk_t* chunk : chunks)
+    {
+      node_t* it = chunk->first;
+      while (it != nullptr)
+      {
+        node_t* next = it->next_phys;
+        delete it;
+        it = next;
+      }
+      delete chunk;
+    }
+    chunks.clear();
+
+    while (node_pool != nullptr)
+    {
+      node_t* next = node_pool->next_free;
+      delete node_pool;
+      node_pool = next;
+    }
+  }
+
+  memory_allocation persistent_pool::allocate(uint32_t size, uint32_t alignment)
+  {
+    TRACY_SCOPED_ZONE;
+    std::lock_guard _lg(lock);
+    check::debug::n_assert(size > 0, "allocate: cannot perform an allocation of size 0");
+
+    // everything in the pool is a multiple of unit (offsets and sizes)
+    const uint32_t unit = std::max(k_min_alignment, granularity);
+    alignment = std::max(alignment, unit);
+    const uint32_t aligned_size = align(size, unit);
+
+    check::debug::n_assert(aligned_size <= k_max_allocation_size, "persistent_pool::allocate: allocation of {} bytes is too big for the pool (max is {})",
+                           size, k_max_allocation_size);
+
+    // worst case padding for the alignment:
+    const uint32_t search_size = aligned_size + (alignment - unit);
+
+    node_t* node = find_free_node(search_size);
+    if (node == nullptr)
+    {
+      add_chunk();
+      node = find_free_node(search_size);
+      check::debug::n_assert(node != nullptr, "persistent_pool::allocate: failed to find a free range in a new block (size: {}, alignment: {})", size, alignment);
+    }
+    remove_free_node(node);
+
+    // handle the alignment: the padding before the allocation goes back in the free-lists
+    const uint32_t aligned_offset = align(node->offset, alignment);
+    if (aligned_offset > node->offset)
+    {
+      node_t* front = node;
+      node = split(front, aligned_offset - front->offset);
+      insert_free_node(front);
+    }
+
+    // give back what we don't use:
+    if (node->size > aligned_size)
+      insert_free_node(split(node, aligned_size));
+
+    chunk_t& chunk = *node->chunk;
+    if (&chunk == empty_chunk)
+      empty_chunk = nullptr;
+    chunk.used += node->size;
+    used_memory += node->size;
+    ++allocation_count;
+
+    return {allocator._get_memory_type_index(), allocation_type::persistent, chunk.allocation.offset() + node->offset, size, chunk.allocation.mem(), this, node};
+  }
+
+  void persistent_pool::free_allocation(const memory_allocation& mem)
+  {
+    std::lock_guard _lg(lock);
+    check::debug::n_assert(mem.allocator() == this, "free_allocation: wrong allocator for memory allocation");
+    check::debug::n_assert(mem._get_payload() != nullptr, "free_allocation: invalid allocation payload");
+
+    node_t* node = (node_t*)mem._get_payload();
+    check::debug::n_assert(!node->is_free, "persistent_pool::free_allocation: double free detected");
+
+    chunk_t* chunk = node->chunk;
+    chunk->used -= node->size;
+    used_memory -= node->size;
+    --allocation_count;
+
+    // merge with the free neighbours:
+    if (node->next_phys != nullptr && node->next_phys->is_free)
+    {
+      remove_free_node(node->next_phys);
+      merge_with_next(node);
+    }
+    if (node->prev_phys != nullptr && node->prev_phys->is_free)
+    {
+      node_t* prev = node->prev_phys;
+      remove_free_node(prev);
+      merge_with_next(prev);
+      node = prev;
+    }
+
+    if (chunk->used == 0)
+    {
+      if (empty_chunk != nullptr && empty_chunk != chunk)
+      {
+        release_chunk(chunk);
+        return;
+      }
+      empty_chunk = chunk;
+    }
+
+    insert_free_node(node);
+  }
+
+  persistent_pool::stats_t persistent_pool::get_stats() const
+  {
+    std::lock_guard _lg(lock);
+    stats_t ret;
+    ret.used_memory = used_memory;
+    ret.block_count = (uint32_t)chunks.size();
+    ret.allocation_count = allocation_count;
+    for (const chunk_t* chunk : chunks)
+      ret.free_memory += chunk->allocation.size();
+    ret.free_memory -= used_memory;
+
+    for (uint32_t fl = 0; fl < k_fl_count; ++fl)
+    {
+      for (uint32_t sl = 0; sl < k_sl_count; ++sl)
+      {
+        for (const node_t* it = free_lists[fl][sl]; it != nullptr; it = it->next_free)
+        {
+          ret.largest_free_range = std::max<uint64_t>(ret.largest_free_range, it->size);
+          ++ret.free_range_count;
+        }
+      }
+    }
+    return ret;
+  }
+
+  void persistent_pool::_check_consistency() const
+  {
+    std::lock_guard _lg(lock);
+    uint64_t total_used = 0;
+    uint32_t total_allocations = 0;
+    uint32_t total_free_nodes = 0;
+    for (const chunk_t* chunk : chunks)
+    {
+      uint32_t offset = 0;
+      uint32_t chunk_used = 0;
+      const node_t* prev = nullptr;
+      for (const node_t* it = chunk->first; it != nullptr; prev = it, it = it->next_phys)
+      {
+        check::debug::n_assert(it->chunk == chunk, "persistent_pool: node is in the wrong chunk");
+        check::debug::n_assert(it->prev_phys == prev, "persistent_pool: broken physical list");
+        check::debug::n_assert(it->offset == offset, "persistent_pool: hole or overlap between two ranges (expected offset {}, got {})", offset, it->offset);
+        check::debug::n_assert(it->size > 0, "persistent_pool: empty range");
+        check::debug::n_assert(!(it->is_free && prev != nullptr && prev->is_free), "persistent_pool: two adjacent free ranges were not merged");
+        offset += it->size;
+        if (it->is_free)
+        {
+          uint32_t fl, sl;
+          mapping(it->size, fl, sl);
+          bool found = false;
+          for (const node_t* fit = free_lists[fl][sl]; fit != nullptr && !found; fit = fit->next_free)
+            found = fit == it;
+          check::debug::n_assert(found, "persistent_pool: free range is not in its free-list");
+          ++total_free_nodes;
+        }
+        else
+        {
+          chunk_used += it->size;
+          ++total_allocations;
+        }
+      }
+      check::debug::n_assert(offset == chunk->allocation.size(), "persistent_pool: ranges do not cover the whole block ({} / {} bytes)", offset, chunk->allocation.size());
+      check::debug::n_assert(chunk_used == chunk->used, "persistent_pool: invalid used memory for block");
+      total_used += chunk_used;
+    }
+    check::debug::n_assert(total_used == used_memory, "persistent_pool: invalid used memory");
+    check::debug::n_assert(total_allocations == allocation_count, "persistent_pool: invalid allocation count");
+
+    uint32_t listed_free_nodes = 0;
+    for (uint32_t fl = 0; fl < k_fl_count; ++fl)
+    {
+      check::debug::n_assert(((fl_bitmap >> fl) & 1) == (sl_bitmap[fl] != 0 ? 1 : 0), "persistent_pool: invalid first-level bitmap");
+      for (uint32_t sl = 0; sl < k_sl_count; ++sl)
+      {
+        check::debug::n_assert(((sl_bitmap[fl] >> sl) & 1) == (free_lists[fl][sl] != nullptr ? 1 : 0), "persistent_pool: invalid second-level bitmap");
+        for (const node_t* it = free_lists[fl][sl]; it != nullptr; it = it->next_free)
+        {
+          check::debug::n_assert(it->is_free, "persistent_pool: allocated range in a free-list");
+          ++listed_free_nodes;
+        }
+      }
+    }
+    check::debug::n_assert(listed_free_nodes == total_free_nodes, "persistent_pool: free-lists contains ranges not in any block");
+  }
+
+  void persistent_pool::mapping(uint32_t size, uint32_t& fl, uint32_t& sl)
+  {
+    if (size < k_small_size)
+    {
+      fl = 0;
+      sl = size >> k_align_shift;
+      return;
+    }
+    const uint32_t fl_raw = 31 - __builtin_clz(size);
+    sl = (size >> (fl_raw - k_sl_bits)) ^ k_sl_count;
+    fl = fl_raw - k_fl_shift + 1;
+  }
+
+  void persistent_pool::mapping_search(uint32_t size, uint32_t& fl, uint32_t& sl)
+  {
+    // round-up to the next size class so that any range in the found list is big enough
+    if (size >= k_small_size)
+    {
+      const uint32_t fl_raw = 31 - __builtin_clz(size);
+      size += (1u << (fl_raw - k_sl_bits)) - 1;
+    }
+    mapping(size, fl, sl);
+  }
+
+  persistent_pool::node_t* persistent_pool::find_free_node(uint32_t size)
+  {
+    uint32_t fl, sl;
+    mapping_search(size, fl, sl);
+    if (fl >= k_fl_count)
+      return nullptr;
+
+    uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0)
+    {
+      const uint32_t fl_map = fl_bitmap & (~0u << (fl + 1));
+      if (fl_map == 0)
+        return nullptr;
+      fl = __builtin_ctz(fl_map);
+      sl_map = sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(sl_map);
+    return free_lists[fl][sl];
+  }
+
+  void persistent_pool::insert_free_node(node_t* node)
+  {
+    uint32_t fl, sl;
+    mapping(node->size, fl, sl);
+
+    node->is_free = true;
+    node->prev_free = nullptr;
+    node->next_free = free_lists[fl][sl];
+    if (node->next_free != nullptr)
+      node->next_free->prev_free = node;
+    free_lists[fl][sl] = node;
+
+    fl_bitmap |= 1u << fl;
+    sl_bitmap[fl] |= 1u << sl;
+  }
+
+  void persistent_pool::remove_free_node(node_t* node)
+  {
+    uint32_t fl, sl;
+    mapping(node->size, fl, sl);
+
+    if (node->prev_free != nullptr)
+      node->prev_free->next_free = node->next_free;
+    if (node->next_free != nullptr)
+      node->next_free->prev_free = node->prev_free;
+    if (free_lists[fl][sl] == node)
+    {
+      free_lists[fl][sl] = node->next_free;
+      if (free_lists[fl][sl] == nullptr)
+      {
+        sl_bitmap[fl] &= ~(1u << sl);
+        if (sl_bitmap[fl] == 0)
+          fl_bitmap &= ~(1u << fl);
+      }
+    }
+
+    node->is_free = false;
+    node->prev_free = nullptr;
+    node->next_free = nullptr;
+  }
+
+  persistent_pool::node_t* persistent_pool::split(node_t* node, uint32_t size)
+  {
+    check::debug::n_assert(node->size > size, "persistent_pool::split: invalid split size");
+
+    node_t* rest = new_node();
+    rest->offset = node->offset + size;
+    rest->size = node->size - size;
+    rest->chunk = node->chunk;
+    rest->prev_phys = node;
+    rest->next_phys = node->next_phys;
+    if (rest->next_phys != nullptr)
+      rest->next_phys->prev_phys = rest;
+
+    node->next_phys = rest;
+    node->size = size;
+    return rest;
+  }
+
+  void persistent_pool::merge_with_next(node_t* node)
+  {
+    node_t* next = node->next_phys;
+    node->size += next->size;
+    node->next_phys = next->next_phys;
+    if (node->next_phys != nullptr)
+      node->next_phys->prev_phys = node;
+    delete_node(next);
+  }
+
+  persistent_pool::chunk_t* persistent_pool::add_chunk()
+  {
+    TRACY_SCOPED_ZONE;
+    chunk_t* chunk = new chunk_t { allocator.block_level_allocation(1) };
+
+    node_t* node = new_node();
+    node->offset = 0;
+    node->size = chunk->allocation.size();
+    node->chunk = chunk;
+    chunk->first = node;
+
+    chunks.push_back(chunk);
+    insert_free_node(node);
+    return chunk;
+  }
+
+  void persistent_pool::release_chunk(chunk_t* chunk)
+  {
+    TRACY_SCOPED_ZONE;
+    check::debug::n_assert(chunk->used == 0 && chunk->first->next_phys == nullptr, "persistent_pool::release_chunk: block still has allocations");
+
+    delete_node(chunk->first);
+    for (auto& it : chunks)
+    {
+      if (it == chunk)
+      {
+        it = chunks.back();
+        chunks.pop_back();
+        break;
+      }
+    }
+    delete chunk;
+  }
+
+  persistent_pool::node_t* persistent_pool::new_node()
+  {
+    if (node_pool == nullptr)
+      return new node_t;
+
+    node_t* node = node_pool;
+    node_pool = node->next_free;
+    *node = {};
+    return node;
+  }
+
+  void persistent_pool::delete_node(node_t* node)
+  {
+    node->next_free = node_pool;
+    node_pool = node;
+  }
+}
+
@@ -0,0 +1,156 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ntools/mt_check/vector.hpp>
+#include <ntools/spinlock.hpp>
+
+#include "allocator.hpp"
+#include "../memory_allocation.hpp"
+
+namespace neam::hydra::allocator
+{
+  class block_allocator;
+
+  /// \brief Handle \e persistent allocations (UBOs, meshes, transform buffers, ... anything that lives for an unknown amount of time)
+  /// Sub-allocates from block-level allocations (k_block_size) using a TLSF (two-level segregated fit) allocator:
+  /// allocation and deallocation are O(1), free neighbours are merged on deallocation, so fragmentation is kept low.
+  ///
+  /// Allocations bigger than k_max_allocation_size should go through the block allocator directly.
+  ///
+  /// \note If the pool can hold both linear and non-linear resources, all allocations (offset and size)
+  ///       are rounded to bufferImageGranularity so that two resources of different kind never share a page.
+  class persistent_pool final : allocator_interface
+  {
+    public:
+      static constexpr uint32_t k_min_alignment = 16;
+      static constexpr uint32_t k_max_allocation_size = 4 * 1024 * 1024; // half a block
+
+      struct stats_t
+      {
+        uint64_t used_memory = 0; // memory used by allocations (including alignment padding)
+        uint64_t free_memory = 0; // free memory in the blocks owned by the pool
+        uint64_t largest_free_range = 0;
+        uint32_t block_count = 0;
+        uint32_t allocation_count = 0;
+        uint32_t free_range_count = 0;
+
+        /// \brief 0: no fragmentation (all the free memory is contiguous), 1: fully fragmented
+        float fragmentation() const { return free_memory == 0 ? 0.0f : 1.0f - float(largest_free_range) / float(free_memory); }
+      };
+
+    public:
+      persistent_pool(block_allocator& _allocator, uint32_t _granularity = 1) : allocator(_allocator), granularity(_granularity) {}
+      ~persistent_pool();
+
+      memory_allocation allocate(uint32_t size, uint32_t alignment);
+
+      void free_allocation(const memory_allocation& mem) override;
+
+      stats_t get_stats() const;
+
+      /// \brief Check that the internal structures are consistent (no overlap, no hole, merged free ranges, correct free-lists)
+      /// \note Slow, only for debug purpose
+      void _check_consistency() const;
+
+    private:
+      static constexpr uint32_t k_sl_bits = 4;
+      static constexpr uint32_t k_sl_count = 1 << k_sl_bits;
+      static constexpr uint32_t k_align_shift = 4; // log2(k_min_alignment)
+      static constexpr uint32_t k_fl_shift = k_sl_bits + k_align_shift;
+      static constexpr uint32_t k_small_size = 1 << k_fl_shift;
+      static constexpr uint32_t k_fl_count = 23 /*log2(k_block_size)*/ - k_fl_shift + 2;
+
+      static_assert((1u << k_align_shift) == k_min_alignment);
+
+      struct chunk_t;
+
+      struct node_t
+      {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        chunk_t* chunk = nullptr;
+
+        // physical neighbours (in the chunk)
+        node_t* prev_phys = nullptr;
+        node_t* next_phys = nullptr;
+
+        // free-list (only when is_free is true, also used for the node-pool)
+        node_t* prev_free = nullptr;
+        node_t* next_free = nullptr;
+
+        bool is_free = false;
+      };
+
+      struct chunk_t
+      {
+        memory_allocation allocation;
+        uint32_t used = 0;
+        node_t* first = nullptr;
+      };
+
+    private:
+      static void mapping(uint32_t size, uint32_t& fl, uint32_t& sl);
+      static void mapping_search(uint32_t size, uint32_t& fl, uint32_t& sl);
+
+      node_t* find_free_node(uint32_t size);
+      void insert_free_node(node_t* node);
+      void remove_free_node(node_t* node);
+
+      /// \brief Split \p node so that it has exactly \p size bytes. Return the remaining part (or nullptr if there's none)
+      node_t* split(node_t* node, uint32_t size);
+      void merge_with_next(node_t* node);
+
+      chunk_t* add_chunk();
+      void release_chunk(chunk_t* chunk);
+
+      node_t* new_node();
+      void delete_node(node_t* node);
+
+    private:
+      mutable spinlock lock;
+
+      block_allocator& allocator;
+      const uint32_t granularity;
+
+      uint32_t fl_bitmap = 0;
+      uint32_t sl_bitmap[k_fl_count] = {0};
+      node_t* free_lists[k_fl_count][k_sl_count] = {{nullptr}};
+
+      std::mtc_vector<chunk_t*> chunks;
+      // keep a single empty chunk around to avoid trashing the block allocator
+      chunk_t* empty_chunk = nullptr;
+
+      node_t* node_pool = nullptr;
+
+      uint64_t used_memory = 0;
+      uint32_t allocation_count = 0;
+  };
+}
+
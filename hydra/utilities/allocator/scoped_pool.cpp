@@ -45,20 +45,20 @@ namespace neam::hydra::allocator
     check::debug::n_assert(parent != nullptr, "allocate: cannot perform scoped allocation in the root scope");
 
     const uint32_t aligned_offset = align(current_offset, alignment);
-    if (current_alloc < pool.allocations.size() && (aligned_offset + size) <= pool.allocations[current_alloc].size())
+    if (current_alloc < chain->allocations.size() && (aligned_offset + size) <= chain->allocations[current_alloc].size())
     {
       current_offset = aligned_offset + size;
-      auto& allocation = pool.allocations[current_alloc];
+      auto& allocation = chain->allocations[current_alloc];
       return {pool.allocator._get_memory_type_index(), allocation_type::scoped, allocation.offset() + aligned_offset, size, allocation.mem(), &pool, nullptr};
     }
-    else if (current_alloc < pool.allocations.size())
+    else if (current_alloc < chain->allocations.size())
     {
       // first, try to grow the current allocation
       const uint32_t block_count = (size + block_allocator::k_block_size - 1u) / block_allocator::k_block_size;
-      if (pool.allocator.try_grow_allocation(pool.allocations[current_alloc], block_count))
+      if (pool.allocator.try_grow_allocation(chain->allocations[current_alloc], block_count))
       {
         current_offset = aligned_offset + size;
-        auto& allocation = pool.allocations[current_alloc];
+        auto& allocation = chain->allocations[current_alloc];
         return {pool.allocator._get_memory_type_index(), allocation_type::scoped, allocation.offset() + aligned_offset, size, allocation.mem(), &pool, nullptr};
       }
 
@@ -70,9 +70,9 @@ namespace neam::hydra::allocator
     }
     else
     {
-      pool.do_allocate_block(size);
+      pool.do_allocate_block(*chain, size);
       current_offset = size;
-      auto& allocation = pool.allocations.back();
+      auto& allocation = chain->allocations.back();
       return {pool.allocator._get_memory_type_index(), allocation_type::scoped, allocation.offset(), size, allocation.mem(), &pool, nullptr};
     }
 
@@ -90,6 +90,8 @@ namespace neam::hydra::allocator
   scoped_pool::scope::scope(scoped_pool& _pool, scope* _parent, uint32_t _offset, uint32_t _alloc)
     : pool(_pool)
     , parent(_parent)
+    , previous(_pool.current_scope())
+    , chain(_parent != nullptr ? _parent->chain : _pool.acquire_chain())
     , current_offset(_offset)
     , current_alloc(_alloc)
   {
@@ -99,6 +101,8 @@ namespace neam::hydra::allocator
   scoped_pool::scope::scope(scope&& o)
    : pool(o.pool)
    , parent(o.parent)
+   , previous(o.previous)
+   , chain(o.chain)
    , current_offset(o.current_offset)
    , current_alloc(o.current_alloc)
    , has_child_scope(o.has_child_scope)
@@ -125,8 +129,12 @@ namespace neam::hydra::allocator
       check::debug::n_assert(parent->has_child_scope == true, "~scope: parent scope does not have childs, but the current instance has it as a parent");
       parent->has_child_scope = false;
     }
+    else
+    {
+      pool.release_chain(chain);
+    }
 
-    pool.current_scope() = parent;
+    pool.current_scope() = previous;
   }
 
   scoped_pool::scope scoped_pool::push_scope()
@@ -140,11 +148,27 @@ namespace neam::hydra::allocator
     return current_scope()->allocate(size, alignment);
   }
 
-  void scoped_pool::do_allocate_block(size_t size)
+  void scoped_pool::do_allocate_block(allocation_chain& chain, size_t size)
   {
     const uint32_t block_count = std::max<uint32_t>(2u, (size + block_allocator::k_block_size - 1u) / block_allocator::k_block_size);
 
-    allocations.push_back(allocator.block_level_allocation(block_count));
+    chain.allocations.push_back(allocator.block_level_allocation(block_count));
+  }
+
+  scoped_pool::allocation_chain* scoped_pool::acquire_chain()
+  {
+    std::lock_guard _l(chains_lock);
+    if (free_chains.empty())
+      return &chains.emplace_back();
+    allocation_chain* chain = free_chains.back();
+    free_chains.pop_back();
+    return chain;
+  }
+
+  void scoped_pool::release_chain(allocation_chain* chain)
+  {
+    std::lock_guard _l(chains_lock);
+    free_chains.push_back(chain);
   }
 }
 
@@ -28,7 +28,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <vector>
 #include <ntools/mt_check/vector.hpp>
+#include <ntools/spinlock.hpp>
 #include "allocator.hpp"
 
 namespace neam::hydra::allocator
@@ -37,9 +40,16 @@ namespace neam::hydra::allocator
 
   /// \brief Handle scoped allocations (pass-local and stuff like that)
   /// Made to be super fast and aggressive memory re-use.
-  /// \todo Thread safety ?
+  /// Each root scope owns a chain of blocks (re-used once the root scope is destroyed), so root scopes living on different threads do not alias.
+  /// A scope (and its children) must only be used from a single thread.
   class scoped_pool final : allocator_interface
   {
+    private:
+      struct allocation_chain
+      {
+        std::vector<memory_allocation> allocations;
+      };
+
     public:
       class scope
       {
@@ -59,6 +69,8 @@ namespace neam::hydra::allocator
         private:
           scoped_pool& pool;
           scope* parent = nullptr;
+          scope* previous = nullptr;
+          allocation_chain* chain = nullptr;
           uint32_t current_offset = 0;
           uint32_t current_alloc = 0;
           bool has_child_scope = false;
@@ -72,8 +84,9 @@ namespace neam::hydra::allocator
       scoped_pool(block_allocator& _alloc) : allocator(_alloc) {}
 
       /// \brief Push a new root scope for the allocations
-      /// \warning All root scopes will overlap their allocations (the system is made so that independent render-contexts can run independently on multiple threads)
-      ///          It is incorrect to use scoped allocations with anything that has its usage scope outside the scope it's been allocated on
+      /// \note Root scopes alive at the same time use different chains of blocks (so independent render-contexts can run on multiple threads)
+      ///        A root scope re-uses the blocks of the root scopes that were destroyed before it.
+      /// \warning It is incorrect to use scoped allocations with anything that has its usage scope outside the scope it's been allocated on
       ///          (like transfer destinations/sources, ...)
       scope push_scope();
 
@@ -83,7 +96,10 @@ namespace neam::hydra::allocator
       void free_allocation(const memory_allocation& mem) override {} // do nothing
 
     private:
-      void do_allocate_block(size_t size);
+      void do_allocate_block(allocation_chain& chain, size_t size);
+
+      allocation_chain* acquire_chain();
+      void release_chain(allocation_chain* chain);
 
       static scope*& current_scope()
       {
@@ -93,6 +109,8 @@ namespace neam::hydra::allocator
     private:
       block_allocator& allocator;
 
-      std::mtc_vector<memory_allocation> allocations;
+      spinlock chains_lock;
+      std::deque<allocation_chain> chains;
+      std::vector<allocation_chain*> free_chains;
   };
 }
@@ -32,7 +32,23 @@ namespace neam::hydra
 {
   void deferred_fence_execution::defer(uint32_t mask, threading::function_t&& function)
   {
-    this_frame_entries.allocate<frame_entry_t>(/*mask*/~0u, std::move(function));
+    this_frame_entries.allocate<frame_entry_t>(mask, std::move(function));
+  }
+
+  void deferred_fence_execution::defer_on_timeline(const vk::queue& queue, uint64_t value, threading::function_t&& function)
+  {
+    queue_timeline_entries_t& qte = timeline_entries[queue_index(queue)];
+    std::lock_guard _lg { qte.lock };
+
+    // values are almost always increasing, so the insertion is almost always at the end
+    if (qte.entries.empty() || qte.entries.back().value <= value)
+    {
+      [[likely]];
+      qte.entries.push_back({ value, std::move(function) });
+      return;
+    }
+    auto it = std::upper_bound(qte.entries.begin(), qte.entries.end(), value, [](uint64_t v, const timeline_entry_t& e) { return v < e.value; });
+    qte.entries.insert(it, { value, std::move(function) });
   }
 
   void deferred_fence_execution::call_on_fence_completion(vk::fence&& fence, threading::function_t function)
@@ -41,6 +57,24 @@ namespace neam::hydra
   }
 
   void deferred_fence_execution::set_end_frame_fences(std::vector<std::pair<uint32_t, vk::fence>>&& queue_fences)
+  {
+    end_frame(std::move(queue_fences), {});
+  }
+
+  void deferred_fence_execution::set_end_frame_timeline_values(std::vector<std::pair<uint32_t, uint64_t>>&& queue_values)
+  {
+    // remove the values that are already completed (avoids waiting for the next poll for nothing)
+    {
+      std::lock_guard _lg { spinlock_shared_adapter::adapt(queue_list_lock) };
+      queue_values.erase(std::remove_if(queue_values.begin(), queue_values.end(), [this](const auto& it)
+      {
+        return queues[it.first]->is_timeline_value_completed(it.second);
+      }), queue_values.end());
+    }
+    end_frame({}, std::move(queue_values));
+  }
+
+  void deferred_fence_execution::end_frame(std::vector<std::pair<uint32_t, vk::fence>>&& queue_fences, std::vector<std::pair<uint32_t, uint64_t>>&& queue_values)
   {
     TRACY_SCOPED_ZONE;
 
@@ -53,6 +87,8 @@ namespace neam::hydra
     // compute a mask where missing queues are treated as "completed"
     uint32_t initial_queue_mask = k_full_mask;
     for (auto&& it : queue_fences)
+      initial_queue_mask &= ~it.first;
+    for (auto&& it : queue_values)
       initial_queue_mask &= ~(1u << it.first);
 
     {
@@ -76,13 +112,18 @@ namespace neam::hydra
         current_entry.is_submit = false;
         current_entry.completed_queues_mask = initial_queue_mask;
         current_entry.queue_fences = std::move(queue_fences);
+        current_entry.queue_timeline_values = std::move(queue_values);
         if (frame_entries_state.size() > 0)
           current_entry.raw_frame_entries = std::move(frame_entries_state);
         if (single_fence_state.size() > 0)
           current_entry.raw_single_fence_entries = std::move(single_fence_state);
 
-        if (!current_entry.has_remaining_entries() || !current_entry.queue_fences.size())
+        if (!current_entry.has_remaining_entries() || (current_entry.queue_fences.empty() && current_entry.queue_timeline_values.empty()))
+        {
+          // nothing to wait on:
+          current_entry.is_submit = true;
           return;
+        }
       }
       // we are at the very end of the rendering frame, after all the rendering operations,
       // so we can insert a callback to mark the current_entry as submit using DQE:
@@ -100,6 +141,15 @@ namespace neam::hydra
 
   void deferred_fence_execution::_assume_vulkan_device_is_idle()
   {
+    // move the timeline entries to the current frame, as everything is assumed to be completed
+    for (uint32_t i = 0; i < k_max_queue_count; ++i)
+    {
+      std::lock_guard _lg { timeline_entries[i].lock };
+      for (auto& it : timeline_entries[i].entries)
+        this_frame_entries.allocate<frame_entry_t>(0u, std::move(it.function));
+      timeline_entries[i].entries.clear();
+    }
+
     set_end_frame_fences({});
 
     std::lock_guard _lg { spinlock_shared_adapter::adapt(frame_entries_lock) };
@@ -107,6 +157,7 @@ namespace neam::hydra
     {
       std::lock_guard _fal { it.lock };
       it.queue_fences.clear();
+      it.queue_timeline_values.clear();
       it.completed_queues_mask = ~0u;
       it.is_submit = true;
     }
@@ -114,6 +165,13 @@ namespace neam::hydra
 
   bool deferred_fence_execution::has_any_pending_entries() const
   {
+    for (const auto& it : timeline_entries)
+    {
+      std::lock_guard _lg { it.lock };
+      if (!it.entries.empty())
+        return true;
+    }
+
     std::lock_guard _lg { spinlock_exclusive_adapter::adapt(frame_entries_lock) };
     for (const auto& it : frame_entries)
     {
@@ -123,9 +181,68 @@ namespace neam::hydra
     return false;
   }
 
+  void deferred_fence_execution::process_timelines(bool use_tasks)
+  {
+    TRACY_SCOPED_ZONE;
+    std::mtc_vector<threading::function_t> entries_to_run;
+    {
+      std::lock_guard _lg { spinlock_shared_adapter::adapt(queue_list_lock) };
+      for (uint32_t i = 0; i < queue_count; ++i)
+      {
+        queue_timeline_entries_t& qte = timeline_entries[i];
+        std::lock_guard _qlg { qte.lock };
+        if (qte.entries.empty() || !queues[i]->is_timeline_value_completed(qte.entries.front().value))
+          continue;
+
+        // single query to the device, then pop everything that is completed:
+        const uint64_t completed_value = queues[i]->get_completed_timeline_value();
+        while (!qte.entries.empty() && qte.entries.front().value <= completed_value)
+        {
+          entries_to_run.push_back(std::move(qte.entries.front().function));
+          qte.entries.pop_front();
+        }
+      }
+    }
+
+    if (entries_to_run.empty())
+      return;
+
+    // run the functions:
+    if (use_tasks)
+    {
+      [[likely]];
+      constexpr size_t k_entry_per_dispatch = 8;
+      threading::for_each(hctx.tm, hctx.tm.get_current_group(), entries_to_run, [](auto& it, size_t /*index*/)
+      {
+        TRACY_SCOPED_ZONE;
+        it();
+      }, k_entry_per_dispatch);
+    }
+    else
+    {
+      for (auto& it : entries_to_run)
+      {
+        it();
+      }
+    }
+  }
+
   void deferred_fence_execution::do_poll(bool use_tasks)
   {
     TRACY_SCOPED_ZONE;
+    if (use_tasks)
+    {
+      [[likely]];
+      hctx.tm.get_task([this]
+      {
+        process_timelines(true);
+      });
+    }
+    else
+    {
+      process_timelines(false);
+    }
+
     {
       // start by removing empty / completed entries at the front:
       std::lock_guard _lg { spinlock_exclusive_adapter::adapt(frame_entries_lock) };
@@ -294,23 +411,36 @@ namespace neam::hydra
 
       // compute mask change, return if nothing changed:
       {
-        uint32_t completed_fences = 0;
+        uint32_t completed_queues = 0;
         for (auto&& it : fa.queue_fences)
         {
           if (it.second.is_signaled())
-            completed_fences |= 1u << it.first;
+            completed_queues |= it.first;
+        }
+        if (!fa.queue_timeline_values.empty())
+        {
+          std::lock_guard _qlg { spinlock_shared_adapter::adapt(queue_list_lock) };
+          for (auto&& it : fa.queue_timeline_values)
+          {
+            if (queues[it.first]->is_timeline_value_completed(it.second))
+              completed_queues |= 1u << it.first;
+          }
         }
-        if (completed_fences == 0 && !fa.queue_fences.empty())
+        if (completed_queues == 0 && (!fa.queue_fences.empty() || !fa.queue_timeline_values.empty()))
           return; // no changes, nothing to do
 
-        // remove fences that matches completed fences
-        fa.queue_fences.erase(std::remove_if(fa.queue_fences.begin(), fa.queue_fences.end(), [completed_fences](const auto& it)
+        // remove fences / values that matches completed queues
+        fa.queue_fences.erase(std::remove_if(fa.queue_fences.begin(), fa.queue_fences.end(), [completed_queues](const auto& it)
         {
-          return ((1u << it.first) & completed_fences) != 0;
+          return (it.first & completed_queues) != 0;
         }), fa.queue_fences.end());
+        fa.queue_timeline_values.erase(std::remove_if(fa.queue_timeline_values.begin(), fa.queue_timeline_values.end(), [completed_queues](const auto& it)
+        {
+          return ((1u << it.first) & completed_queues) != 0;
+        }), fa.queue_timeline_values.end());
 
         // add it to the completed mask
-        fa.completed_queues_mask |= completed_fences;
+        fa.completed_queues_mask |= completed_queues;
       }
 
       // iterate over the entries, and put the entries to run in the corresponding vector:
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <tuple>
 
 #include <ntools/id/string_id.hpp>
@@ -44,6 +45,8 @@ namespace neam::hydra
 
   /// \brief Defer execution (or destruction) to after a fence/fences being signaled
   /// \note Also tracks generic progress across all the queues to avoid spamming fences for every resource waiting to be destructed
+  /// \note Progress is tracked using the queues timeline semaphores (see vk::queue::get_last_submitted_timeline_value()).
+  ///       Entries can be either keyed on the end of the frame (defer()) or on a specific (queue, timeline value) pair (defer_on_timeline())
   class deferred_fence_execution
   {
     private:
@@ -67,6 +70,16 @@ namespace neam::hydra
       /// \brief Defer the destruction to when all the queues have completed the current frame
       template<typename... Args> void defer_destruction(Args&& ...objs) { return defer_destruction(k_full_mask, std::move(objs)...); }
 
+      /// \brief Defer the call to when the timeline of \p queue has reached \p value
+      /// \note Use vk::submit_info::get_timeline_value() to get the value of a given submission
+      void defer_on_timeline(const vk::queue& queue, uint64_t value, threading::function_t&& function);
+
+      /// \brief Defer the destruction to when the timeline of \p queue has reached \p value
+      template<typename... Args> void defer_destruction_on_timeline(const vk::queue& queue, uint64_t value, Args&& ...objs)
+      {
+        return defer_on_timeline(queue, value, [...objs = std::move(objs)]{});
+      }
+
       /// \brief Call the function when the fence has been completed
       /// \note Destroy the fence afterward
       /// \note In most cases, defer() is preferrable to this (defer is faster)
@@ -84,9 +97,27 @@ namespace neam::hydra
 
       /// \brief Set the end frame fences for all the queues (or all the queues that had something this frame)
       /// This effectively ends the frame. Anything deferred after the return of this function will go to the next frame.
+      /// \param queue_fences pairs of queue_mask() / fence
       /// \warning Must be called after poll() has returned (and must be called after a call to poll has been made)
+      /// \note Prefer set_end_frame_timelines(), which does not require any fence nor submission
       void set_end_frame_fences(std::vector<std::pair<uint32_t, vk::fence>>&& queue_fences);
 
+      /// \brief End the frame using the current timeline value of the queues
+      /// (the frame is completed when all the queues have reached their last submitted timeline value)
+      /// This effectively ends the frame. Anything deferred after the return of this function will go to the next frame.
+      /// \warning Must be called after poll() has returned (and must be called after a call to poll has been made)
+      template<typename... Queues>
+      void set_end_frame_timelines(const Queues& ...queues)
+      {
+        std::vector<std::pair<uint32_t, uint64_t>> queue_values;
+        queue_values.reserve(sizeof...(Queues));
+        (queue_values.emplace_back(queue_index(queues), queues.get_last_submitted_timeline_value()), ...);
+        set_end_frame_timeline_values(std::move(queue_values));
+      }
+
+      /// \brief End the frame using the provided (queue index, timeline value) pairs
+      void set_end_frame_timeline_values(std::vector<std::pair<uint32_t, uint64_t>>&& queue_values);
+
       /// \brief Return whether the current instance has any deferred entries that are pending execution
       bool has_any_pending_entries() const;
 
@@ -111,6 +142,19 @@ namespace neam::hydra
         uint32_t queue_mask;
         threading::function_t function;
       };
+
+      struct timeline_entry_t
+      {
+        uint64_t value;
+        threading::function_t function;
+      };
+
+      struct queue_timeline_entries_t
+      {
+        mutable spinlock lock;
+        // sorted by value
+        std::mtc_deque<timeline_entry_t> entries;
+      };
       using frame_entry_frame_alloc_t = cr::frame_allocator<1, true, alignof(frame_entry_t)>;
 
       struct single_fence_entry_t
@@ -127,6 +171,7 @@ namespace neam::hydra
         uint32_t completed_queues_mask = 0;
 
         std::mtc_vector<std::pair<uint32_t, vk::fence>> queue_fences;
+        std::mtc_vector<std::pair<uint32_t, uint64_t>> queue_timeline_values;
 
         std::optional<typename frame_entry_frame_alloc_t::allocator_state> raw_frame_entries;
         std::mtc_vector<frame_entry_t> remaining_frame_entries;
@@ -138,7 +183,7 @@ namespace neam::hydra
 
         bool has_remaining_entries() const
         {
-          return !queue_fences.empty()
+          return !queue_fences.empty() || !queue_timeline_values.empty()
               ||!!raw_frame_entries || !remaining_frame_entries.empty()
               || !!raw_single_fence_entries || !remaining_single_fence_entries.empty();
         }
@@ -147,6 +192,12 @@ namespace neam::hydra
     private:
       void do_poll(bool use_tasks);
 
+      /// \brief Set the end frame data (fences and/or timeline values)
+      void end_frame(std::vector<std::pair<uint32_t, vk::fence>>&& queue_fences, std::vector<std::pair<uint32_t, uint64_t>>&& queue_values);
+
+      /// \brief Dispatch the timeline entries that are completed
+      void process_timelines(bool use_tasks);
+
       /// \brief Process a frame data, usually called in a task
       void process_frame(bool use_tasks, uint32_t frame_alloc_index);
       void process_single_fence_frame(bool use_tasks, uint32_t frame_alloc_index);
@@ -159,6 +210,8 @@ namespace neam::hydra
       const vk::queue* queues[k_max_queue_count];
       uint32_t queue_count = 0;
 
+      queue_timeline_entries_t timeline_entries[k_max_queue_count];
+
       frame_entry_frame_alloc_t this_frame_entries;
       single_fence_frame_alloc_t this_frame_single_fences;
 
@@ -0,0 +1,484 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "gpu_profiler.hpp"
+#include <hydra/engine/hydra_context.hpp>
+
+#if TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#include <client/TracyProfiler.hpp>
+#endif
+
+namespace neam::hydra
+{
+  static constexpr uint32_t k_zone_index_bits = 20;
+  static constexpr uint32_t k_zone_index_mask = (1u << k_zone_index_bits) - 1;
+  // the tag of the frame never reaches (~0u >> k_zone_index_bits), so a zone id is never k_invalid_marker
+  static constexpr uint32_t k_frame_tag_count = (~0u >> k_zone_index_bits);
+
+  static uint32_t make_zone_id(uint64_t frame_index, uint32_t zone_index)
+  {
+    return (uint32_t(frame_index % k_frame_tag_count) << k_zone_index_bits) | zone_index;
+  }
+
+  // innermost submission scope of the thread
+  static thread_local gpu_profiler::submission_scope* t_current_scope = nullptr;
+
+  gpu_profiler::submission_scope::submission_scope(gpu_profiler& _profiler, std::string_view _name)
+    : profiler(_profiler), previous_scope(t_current_scope)
+  {
+    if (profiler.is_enabled())
+      name = _name;
+    t_current_scope = this;
+  }
+
+  gpu_profiler::submission_scope::~submission_scope()
+  {
+    t_current_scope = previous_scope;
+  }
+
+  gpu_profiler::gpu_profiler(hydra_context& _hctx)
+    : hctx(_hctx)
+  {
+    on_index_loaded_tk = hctx.res.on_index_loaded.add([this]
+    {
+      hctx.hconf.read_or_create_conf(configuration);
+    });
+
+    timestamp_period_ns = hctx.device.get_physical_device().get_limits().timestampPeriod;
+    refresh_queues();
+    current_frame = get_frame_data();
+
+    hctx.device._marker_listener = this;
+  }
+
+  gpu_profiler::~gpu_profiler()
+  {
+    if (hctx.device._marker_listener == this)
+      hctx.device._marker_listener = nullptr;
+  }
+
+  void gpu_profiler::refresh_queues()
+  {
+    const vk::physical_device& phys_dev = hctx.device.get_physical_device();
+    auto add_queue = [&, this](vk::queue& q)
+    {
+      const uint32_t valid_bits = phys_dev.get_queue_properties(q.get_queue_familly_index()).timestampValidBits;
+      if (valid_bits == 0)
+        return;
+      queues.push_back(
+      {
+        .queue = &q,
+        .name = hctx.get_queue_name(q),
+        .valid_bits_mask = valid_bits >= 64 ? ~0ull : ((1ull << valid_bits) - 1),
+      });
+    };
+    add_queue(hctx.gqueue);
+    add_queue(hctx.cqueue);
+    add_queue(hctx.tqueue);
+    add_queue(hctx.slow_tqueue);
+  }
+
+  uint32_t gpu_profiler::get_queue_index(VkQueue q) const
+  {
+    for (uint32_t i = 0; i < (uint32_t)queues.size(); ++i)
+    {
+      if (queues[i].queue->_get_vk_queue() == q)
+        return i;
+    }
+    return ~0u;
+  }
+
+  std::unique_ptr<gpu_profiler::frame_data_t> gpu_profiler::get_frame_data()
+  {
+    const uint32_t query_count = std::min(configuration.max_zones_per_frame, k_zone_index_mask) * 2;
+    {
+      std::lock_guard _l(free_frames_lock);
+      while (!free_frames.empty())
+      {
+        std::unique_ptr<frame_data_t> frame = std::move(free_frames.back());
+        free_frames.pop_back();
+        // discard frames created with a different configuration
+        if (frame->pool.size() == query_count)
+          return frame;
+      }
+    }
+    std::unique_ptr<frame_data_t> frame = std::make_unique<frame_data_t>(hctx.device, query_count);
+    frame->pool._set_debug_name("gpu_profiler::frame_data::pool");
+    return frame;
+  }
+
+  void gpu_profiler::recycle(std::unique_ptr<frame_data_t>&& frame)
+  {
+    frame->pool.reset();
+    frame->next_query.store(0, std::memory_order_release);
+    frame->resolve_attempts = 0;
+    frame->zones.clear();
+
+    std::lock_guard _l(free_frames_lock);
+    free_frames.push_back(std::move(frame));
+  }
+
+  uint32_t gpu_profiler::allocate_zone(std::string_view name, uint32_t queue_index, uint32_t& first_query, uint32_t group)
+  {
+    // NOTE: frame_lock must be held (shared)
+    if (!current_frame)
+      return k_invalid_marker;
+
+    first_query = current_frame->next_query.fetch_add(2, std::memory_order_acq_rel);
+    if (first_query + 2 > current_frame->pool.size())
+    {
+      overflowed_zone_count.fetch_add(1, std::memory_order_relaxed);
+      return k_invalid_marker;
+    }
+
+    std::lock_guard _l(current_frame->zones_lock);
+    const uint32_t zone_index = (uint32_t)current_frame->zones.size();
+    current_frame->zones.push_back(
+    {
+      .name = std::string(name),
+      .first_query = first_query,
+      .queue_index = queue_index,
+      .group = group,
+#if TRACY_ENABLE
+      .cpu_begin_time = tracy::Profiler::GetTime(),
+      .thread = tracy::GetThreadHandle(),
+#endif
+    });
+    return make_zone_id(current_frame->frame_index, zone_index);
+  }
+
+  uint32_t gpu_profiler::begin_zone(vk::command_buffer& cmd_buf, std::string_view name, VkPipelineStageFlagBits stage)
+  {
+    if (!configuration.enabled)
+      return k_invalid_marker;
+
+    const uint32_t queue_index = get_queue_index(cmd_buf._get_vk_queue());
+    if (queue_index == ~0u)
+      return k_invalid_marker;
+
+    std::lock_guard _l { spinlock_shared_adapter::adapt(frame_lock) };
+    return begin_zone_locked(cmd_buf, name, queue_index, stage);
+  }
+
+  uint32_t gpu_profiler::begin_zone_locked(vk::command_buffer& cmd_buf, std::string_view name, uint32_t queue_index, VkPipelineStageFlagBits stage, uint32_t group)
+  {
+    // NOTE: frame_lock must be held (shared)
+    uint32_t first_query;
+    const uint32_t zone = allocate_zone(name, queue_index, first_query, group);
+    if (zone == k_invalid_marker)
+      return k_invalid_marker;
+
+    vk::command_buffer_recorder cbr { hctx.device, cmd_buf };
+    cbr.write_timestamp(stage, current_frame->pool, first_query);
+    return zone;
+  }
+
+  void gpu_profiler::end_zone(vk::command_buffer& cmd_buf, uint32_t zone, VkPipelineStageFlagBits stage)
+  {
+    if (zone == k_invalid_marker)
+      return;
+
+    std::lock_guard _l { spinlock_shared_adapter::adapt(frame_lock) };
+    // the frame ended between the begin and the end of the zone: the zone is lost
+    if (!current_frame || make_zone_id(current_frame->frame_index, zone & k_zone_index_mask) != zone)
+      return;
+
+    uint32_t first_query;
+    {
+      std::lock_guard _zl(current_frame->zones_lock);
+      if ((zone & k_zone_index_mask) >= current_frame->zones.size())
+        return;
+      zone_t& z = current_frame->zones[zone & k_zone_index_mask];
+      z.has_end = true;
+#if TRACY_ENABLE
+      z.cpu_end_time = tracy::Profiler::GetTime();
+#endif
+      first_query = z.first_query;
+    }
+    vk::command_buffer_recorder cbr { hctx.device, cmd_buf };
+    cbr.write_timestamp(stage, current_frame->pool, first_query + 1);
+  }
+
+  uint32_t gpu_profiler::on_begin_marker(vk::command_buffer& cmd_buf, std::string_view name)
+  {
+    return begin_zone(cmd_buf, name);
+  }
+
+  void gpu_profiler::on_end_marker(vk::command_buffer& cmd_buf, uint32_t marker)
+  {
+    end_zone(cmd_buf, marker);
+  }
+
+  uint32_t gpu_profiler::on_begin_recording(vk::command_buffer& cmd_buf)
+  {
+    submission_scope* scope = t_current_scope;
+    if (scope == nullptr || &scope->profiler != this || !configuration.enabled)
+      return k_invalid_marker;
+
+    const uint32_t queue_index = get_queue_index(cmd_buf._get_vk_queue());
+    if (queue_index == ~0u)
+      return k_invalid_marker;
+
+    std::lock_guard _l { spinlock_shared_adapter::adapt(frame_lock) };
+    if (!current_frame)
+      return k_invalid_marker;
+
+    if (scope->queue_zones.size() <= queue_index)
+      scope->queue_zones.resize(queues.size(), k_invalid_marker);
+
+    // merge with the first command buffer of the scope on that queue (if it is from the same frame)
+    uint32_t& queue_zone = scope->queue_zones[queue_index];
+    const bool has_group = queue_zone != k_invalid_marker
+                           && make_zone_id(current_frame->frame_index, queue_zone & k_zone_index_mask) == queue_zone;
+    const uint32_t zone = begin_zone_locked(cmd_buf, scope->name, queue_index, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                            has_group ? (queue_zone & k_zone_index_mask) : ~0u);
+    if (!has_group)
+      queue_zone = zone;
+    return zone;
+  }
+
+  void gpu_profiler::on_end_recording(vk::command_buffer& cmd_buf, uint32_t marker)
+  {
+    end_zone(cmd_buf, marker, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+  }
+
+  void gpu_profiler::end_frame()
+  {
+    TRACY_SCOPED_ZONE;
+    std::unique_ptr<frame_data_t> frame;
+    {
+      std::lock_guard _l { spinlock_exclusive_adapter::adapt(frame_lock) };
+      frame = std::move(current_frame);
+      ++frame_index;
+      if (configuration.enabled)
+      {
+        current_frame = get_frame_data();
+        current_frame->frame_index = frame_index;
+      }
+    }
+
+    if (!frame)
+      return;
+    if (frame->zones.empty())
+    {
+      recycle(std::move(frame));
+      return;
+    }
+
+    hctx.dfe.defer([this, frame = std::move(frame)] mutable
+    {
+      resolve(std::move(frame));
+    });
+  }
+
+  void gpu_profiler::resolve(std::unique_ptr<frame_data_t>&& frame)
+  {
+    TRACY_SCOPED_ZONE;
+    const uint32_t query_count = std::min(frame->next_query.load(std::memory_order_acquire), frame->pool.size());
+
+    // (value, availability) pairs
+    std::vector<uint64_t> results;
+    results.resize(query_count * 2);
+    const bool all_available = frame->pool.get_results(0, query_count, results, VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    // some command buffers might have been submit after the end of the frame, retry later
+    if (!all_available && frame->resolve_attempts < k_max_resolve_attempts)
+    {
+      frame->resolve_attempts += 1;
+      hctx.dfe.defer([this, frame = std::move(frame)] mutable
+      {
+        resolve(std::move(frame));
+      });
+      return;
+    }
+
+    frame_stats_t frame_stats;
+    frame_stats.frame_index = frame->frame_index;
+    frame_stats.zones.reserve(frame->zones.size());
+
+    uint64_t frame_begin = ~0ull;
+    uint64_t frame_end = 0;
+    uint64_t dropped_zones = 0;
+    std::vector<std::optional<std::pair<uint64_t, uint64_t>>> zone_times;
+    zone_times.resize(frame->zones.size());
+    for (uint32_t i = 0; i < (uint32_t)frame->zones.size(); ++i)
+    {
+      const zone_t& zone = frame->zones[i];
+      const uint32_t q = zone.first_query;
+      if (!zone.has_end || q + 1 >= query_count || results[q * 2 + 1] == 0 || results[(q + 1) * 2 + 1] == 0)
+      {
+        ++dropped_zones;
+        continue;
+      }
+      const uint64_t mask = queues[zone.queue_index].valid_bits_mask;
+      const uint64_t begin = results[q * 2] & mask;
+      const uint64_t end = std::max(results[(q + 1) * 2] & mask, begin);
+      zone_times[i] = { begin, end };
+      frame_begin = std::min(frame_begin, begin);
+      frame_end = std::max(frame_end, end);
+    }
+
+    // merge the zones of the command buffers of the submission scopes (first begin to last end)
+    for (uint32_t i = 0; i < (uint32_t)frame->zones.size(); ++i)
+    {
+      const uint32_t group = frame->zones[i].group;
+      if (group == ~0u || !zone_times[i])
+        continue;
+      const auto [begin, end] = *zone_times[i];
+      if (zone_times[group])
+        zone_times[group] = { std::min(zone_times[group]->first, begin), std::max(zone_times[group]->second, end) };
+      else
+        zone_times[group] = { begin, end };
+      frame->zones[group].cpu_end_time = std::max(frame->zones[group].cpu_end_time, frame->zones[i].cpu_end_time);
+    }
+
+    const double to_ms = timestamp_period_ns / 1'000'000.0;
+    std::lock_guard _tl(tracy_lock);
+    for (uint32_t i = 0; i < (uint32_t)frame->zones.size(); ++i)
+    {
+      if (!zone_times[i] || frame->zones[i].group != ~0u)
+        continue;
+      const auto [begin, end] = *zone_times[i];
+      const zone_t& zone = frame->zones[i];
+      frame_stats.zones.push_back(
+      {
+        .name = zone.name,
+        .queue_name = queues[zone.queue_index].name,
+        .begin_ms = (float)((begin - frame_begin) * to_ms),
+        .duration_ms = (float)((end - begin) * to_ms),
+      });
+      emit_tracy_zone(queues[zone.queue_index], zone, begin, end);
+    }
+    if (frame_end > frame_begin)
+      frame_stats.gpu_time_ms = (float)((frame_end - frame_begin) * to_ms);
+
+    {
+      std::lock_guard _l(history_lock);
+      stats.resolved_frame_count += 1;
+      stats.resolved_zone_count += frame_stats.zones.size();
+      stats.dropped_zone_count += dropped_zones;
+
+      history.push_back(std::move(frame_stats));
+      while (history.size() > configuration.history_size)
+        history.pop_front();
+    }
+
+    recycle(std::move(frame));
+  }
+
+  void gpu_profiler::emit_tracy_zone([[maybe_unused]] profiled_queue_t& pq, [[maybe_unused]] const zone_t& zone, [[maybe_unused]] uint64_t begin, [[maybe_unused]] uint64_t end)
+  {
+#if TRACY_ENABLE
+    // NOTE: tracy_lock is held
+    if (pq.tracy_context == 0xFF)
+    {
+      // create the context, using the first zone as the calibration point
+      pq.tracy_context = tracy::GetGpuCtxCounter().fetch_add(1, std::memory_order_relaxed);
+
+      auto* item = tracy::Profiler::QueueSerial();
+      tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuNewContext);
+      tracy::MemWrite(&item->gpuNewContext.cpuTime, zone.cpu_begin_time);
+      tracy::MemWrite(&item->gpuNewContext.gpuTime, (int64_t)begin);
+      memset(&item->gpuNewContext.thread, 0, sizeof(item->gpuNewContext.thread));
+      tracy::MemWrite(&item->gpuNewContext.period, (float)timestamp_period_ns);
+      tracy::MemWrite(&item->gpuNewContext.context, pq.tracy_context);
+      tracy::MemWrite(&item->gpuNewContext.flags, uint8_t(0));
+      tracy::MemWrite(&item->gpuNewContext.type, tracy::GpuContextType::Vulkan);
+      tracy::Profiler::QueueSerialFinish();
+
+      const std::string ctx_name = fmt::format("hydra: {}", pq.name);
+      char* name_ptr = (char*)tracy::tracy_malloc(ctx_name.size());
+      memcpy(name_ptr, ctx_name.data(), ctx_name.size());
+      item = tracy::Profiler::QueueSerial();
+      tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuContextName);
+      tracy::MemWrite(&item->gpuContextNameFat.context, pq.tracy_context);
+      tracy::MemWrite(&item->gpuContextNameFat.ptr, (uint64_t)name_ptr);
+      tracy::MemWrite(&item->gpuContextNameFat.size, (uint16_t)ctx_name.size());
+      tracy::Profiler::QueueSerialFinish();
+    }
+
+    const uint16_t begin_query_id = pq.tracy_next_query_id++;
+    const uint16_t end_query_id = pq.tracy_next_query_id++;
+
+    static constexpr std::string_view k_file = "gpu_profiler.cpp";
+    static constexpr std::string_view k_function = "gpu_profiler::resolve";
+    const uint64_t srcloc = tracy::Profiler::AllocSourceLocation(__LINE__, k_file.data(), k_file.size(), k_function.data(), k_function.size(), zone.name.data(), zone.name.size());
+
+    auto* item = tracy::Profiler::QueueSerial();
+    tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuZoneBeginAllocSrcLocSerial);
+    tracy::MemWrite(&item->gpuZoneBegin.cpuTime, zone.cpu_begin_time);
+    tracy::MemWrite(&item->gpuZoneBegin.srcloc, srcloc);
+    tracy::MemWrite(&item->gpuZoneBegin.thread, zone.thread);
+    tracy::MemWrite(&item->gpuZoneBegin.queryId, begin_query_id);
+    tracy::MemWrite(&item->gpuZoneBegin.context, pq.tracy_context);
+    tracy::Profiler::QueueSerialFinish();
+
+    item = tracy::Profiler::QueueSerial();
+    tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuZoneEndSerial);
+    tracy::MemWrite(&item->gpuZoneEnd.cpuTime, zone.cpu_end_time);
+    tracy::MemWrite(&item->gpuZoneEnd.thread, zone.thread);
+    tracy::MemWrite(&item->gpuZoneEnd.queryId, end_query_id);
+    tracy::MemWrite(&item->gpuZoneEnd.context, pq.tracy_context);
+    tracy::Profiler::QueueSerialFinish();
+
+    auto emit_time = [&pq](uint16_t query_id, uint64_t time)
+    {
+      auto* item = tracy::Profiler::QueueSerial();
+      tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuTime);
+      tracy::MemWrite(&item->gpuTime.gpuTime, (int64_t)time);
+      tracy::MemWrite(&item->gpuTime.queryId, query_id);
+      tracy::MemWrite(&item->gpuTime.context, pq.tracy_context);
+      tracy::Profiler::QueueSerialFinish();
+    };
+    emit_time(begin_query_id, begin);
+    emit_time(end_query_id, end);
+#endif
+  }
+
+  std::vector<gpu_profiler::frame_stats_t> gpu_profiler::get_history() const
+  {
+    std::lock_guard _l(history_lock);
+    return { history.begin(), history.end() };
+  }
+
+  gpu_profiler::frame_stats_t gpu_profiler::get_last_frame() const
+  {
+    std::lock_guard _l(history_lock);
+    if (history.empty())
+      return {};
+    return history.back();
+  }
+
+  gpu_profiler::stats_t gpu_profiler::get_stats() const
+  {
+    std::lock_guard _l(history_lock);
+    stats_t ret = stats;
+    ret.overflowed_zone_count = overflowed_zone_count.load(std::memory_order_relaxed);
+    return ret;
+  }
+}
+
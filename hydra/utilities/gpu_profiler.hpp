@@ -0,0 +1,261 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <ntools/mt_check/deque.hpp>
+#include <ntools/mt_check/vector.hpp>
+#include <ntools/spinlock.hpp>
+#include <ntools/event.hpp>
+
+#include <hydra/engine/conf/conf.hpp>
+
+#include "../vulkan/vulkan.hpp"
+#include "../vulkan/submit_info.hpp"
+
+namespace neam::hydra
+{
+  struct gpu_profiler_configuration : hydra::conf::hconf<gpu_profiler_configuration, "configuration/gpu_profiler.hcnf", conf::location_t::index_program_local_dir>
+  {
+    bool enabled = true;
+    uint32_t max_zones_per_frame = 2048;
+    uint32_t history_size = 256;
+  };
+}
+
+N_METADATA_STRUCT(neam::hydra::gpu_profiler_configuration)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(enabled, neam::metadata::info{.description = c_string_t
+    <
+      "Whether GPU timestamps are recorded around gpu-task-producer submissions and command-buffer debug markers.\n"
+      "Results are read back a few frames later, without stalling the CPU."
+    >}),
+    N_MEMBER_DEF(max_zones_per_frame, neam::metadata::info{.description = c_string_t
+    <
+      "Maximum number of profiled zones in a frame (each zone uses two timestamp queries).\n"
+      "Zones past that limit are not recorded."
+    >}),
+    N_MEMBER_DEF(history_size, neam::metadata::info{.description = c_string_t
+    <
+      "Number of resolved frames kept in the stats history (see gpu_profiler::get_history())."
+    >})
+  >;
+};
+
+namespace neam::hydra
+{
+  struct hydra_context;
+
+  /// \brief GPU timestamp profiler
+  ///
+  /// Brackets the gpu-task-producer submissions (see submission_scope) and the command-buffer debug markers
+  /// (via the device marker listener) with timestamp queries.
+  /// Queries of a frame are resolved once the frame is done on the GPU (via the dfe, so without stalling the CPU)
+  /// and are emitted as Tracy GPU zones (when Tracy is enabled) and in the stats history.
+  ///
+  /// \note Queues whose family does not support timestamps are silently ignored
+  class gpu_profiler final : public vk::command_buffer_marker_listener
+  {
+    public:
+      struct zone_stats_t
+      {
+        std::string name;
+        std::string queue_name;
+
+        // relative to the first timestamp of the frame
+        float begin_ms;
+        float duration_ms;
+      };
+
+      struct frame_stats_t
+      {
+        uint64_t frame_index = 0;
+
+        // time between the first and the last timestamp of the frame
+        float gpu_time_ms = 0;
+        std::vector<zone_stats_t> zones;
+      };
+
+      struct stats_t
+      {
+        uint64_t resolved_frame_count = 0;
+        uint64_t resolved_zone_count = 0;
+        // zones that were not recorded because max_zones_per_frame was reached
+        uint64_t overflowed_zone_count = 0;
+        // zones whose results were never available
+        uint64_t dropped_zone_count = 0;
+      };
+
+    public:
+      gpu_profiler(hydra_context& _hctx);
+      ~gpu_profiler();
+
+      /// \brief Return whether the profiler records timestamps
+      bool is_enabled() const { return configuration.enabled; }
+
+      /// \brief Enable / disable the profiler (takes effect the next frame)
+      void set_enabled(bool enabled) { configuration.enabled = enabled; }
+
+      /// \brief Profile every primary command buffer recorded on the current thread while the scope is alive
+      /// The timestamps are written at the start and at the end of the command buffers themselves,
+      /// and all the command buffers of a queue are reported as a single zone (first begin to last end).
+      /// \note Scopes can be nested (the innermost one is used)
+      class submission_scope
+      {
+        public:
+          submission_scope(gpu_profiler& _profiler, std::string_view _name);
+          ~submission_scope();
+
+          submission_scope(const submission_scope&) = delete;
+          submission_scope& operator = (const submission_scope&) = delete;
+
+        private:
+          gpu_profiler& profiler;
+          std::string name;
+          submission_scope* previous_scope;
+
+          // zone id of the first zone of the scope, per queue
+          std::vector<uint32_t> queue_zones;
+
+          friend gpu_profiler;
+      };
+
+      /// \brief Begin a zone in a command buffer
+      /// \return the zone id to pass to end_zone (k_invalid_marker if the zone is not recorded)
+      uint32_t begin_zone(vk::command_buffer& cmd_buf, std::string_view name, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+      /// \brief End a zone previously started with begin_zone
+      void end_zone(vk::command_buffer& cmd_buf, uint32_t zone, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+      /// \brief End the current frame. Its zones will be resolved once the frame is done on the GPU.
+      /// \note Must be called before the dfe end-frame call
+      void end_frame();
+
+      /// \brief Return the last resolved frames (oldest first)
+      std::vector<frame_stats_t> get_history() const;
+
+      /// \brief Return the last resolved frame
+      frame_stats_t get_last_frame() const;
+
+      stats_t get_stats() const;
+
+    public: // command_buffer_marker_listener
+      uint32_t on_begin_marker(vk::command_buffer& cmd_buf, std::string_view name) override;
+      void on_end_marker(vk::command_buffer& cmd_buf, uint32_t marker) override;
+      uint32_t on_begin_recording(vk::command_buffer& cmd_buf) override;
+      void on_end_recording(vk::command_buffer& cmd_buf, uint32_t marker) override;
+
+    private:
+      static constexpr uint32_t k_max_resolve_attempts = 8;
+
+      struct zone_t
+      {
+        std::string name;
+        uint32_t first_query;
+        uint32_t queue_index;
+        bool has_end = false;
+
+        // index of the zone this one is merged into (~0u: none)
+        uint32_t group = ~0u;
+
+        // tracy stuff:
+        int64_t cpu_begin_time = 0;
+        int64_t cpu_end_time = 0;
+        uint32_t thread = 0;
+      };
+
+      struct frame_data_t
+      {
+        frame_data_t(vk::device& dev, uint32_t query_count) : pool(dev, VK_QUERY_TYPE_TIMESTAMP, query_count) { pool.reset(); }
+
+        vk::query_pool pool;
+        uint64_t frame_index = 0;
+        uint32_t resolve_attempts = 0;
+
+        std::atomic<uint32_t> next_query = 0;
+
+        spinlock zones_lock;
+        std::mtc_vector<zone_t> zones;
+      };
+
+      struct profiled_queue_t
+      {
+        vk::queue* queue;
+        std::string name;
+        uint64_t valid_bits_mask;
+
+        // tracy gpu context (0xFF: not created yet)
+        uint8_t tracy_context = 0xFF;
+        uint16_t tracy_next_query_id = 0;
+      };
+
+    private:
+      void refresh_queues();
+      uint32_t get_queue_index(VkQueue q) const;
+
+      uint32_t allocate_zone(std::string_view name, uint32_t queue_index, uint32_t& first_query, uint32_t group = ~0u);
+      uint32_t begin_zone_locked(vk::command_buffer& cmd_buf, std::string_view name, uint32_t queue_index, VkPipelineStageFlagBits stage, uint32_t group = ~0u);
+
+      std::unique_ptr<frame_data_t> get_frame_data();
+      void resolve(std::unique_ptr<frame_data_t>&& frame);
+      void recycle(std::unique_ptr<frame_data_t>&& frame);
+
+      void emit_tracy_zone(profiled_queue_t& pq, const zone_t& zone, uint64_t begin, uint64_t end);
+
+    private:
+      hydra_context& hctx;
+
+      gpu_profiler_configuration configuration;
+      cr::event_token_t on_index_loaded_tk;
+
+      double timestamp_period_ns = 1;
+      std::mtc_vector<profiled_queue_t> queues;
+      // protect the tracy state of the queues
+      spinlock tracy_lock;
+
+      // current frame (shared: recording, exclusive: swapping frames)
+      mutable shared_spinlock frame_lock;
+      std::unique_ptr<frame_data_t> current_frame;
+      uint64_t frame_index = 0;
+
+      spinlock free_frames_lock;
+      std::mtc_vector<std::unique_ptr<frame_data_t>> free_frames;
+
+      mutable spinlock history_lock;
+      std::mtc_deque<frame_stats_t> history;
+      stats_t stats;
+      std::atomic<uint64_t> overflowed_zone_count = 0;
+  };
+}
+
@@ -65,6 +65,12 @@ namespace neam::hydra
       , view(dev, image, view_type)
     {
     }
+    /// \brief Sparse images: no memory is allocated, memory has to be bound with sparse-bind operations
+    image_holder(vk::device& dev, vk::image&& _image, VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D)
+      : image(std::move(_image))
+      , view(dev, image, view_type)
+    {
+    }
     image_holder(image_holder&&) = default;
     image_holder& operator = (image_holder&&) = default;
 
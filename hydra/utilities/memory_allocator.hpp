@@ -122,19 +122,21 @@ namespace neam
             if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0 && (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0)
               is_unified_memory_system = true;
 
+            // when buffers and images share the same heaps, the persistent pools have to respect the granularity
+            const uint32_t granularity = separate_buffer_image_allocations ? 1 : buffer_image_granularity;
             for (uint32_t optimal_image = 0; optimal_image < 2; ++optimal_image)
             {
               // normal:
               {
                 const uint64_t allocator_key = ((uint64_t)memory_type_index) << 32 | (optimal_image) | (/*is_maped_memory*/ 0);
-                heaps.emplace(std::piecewise_construct, std::tuple{allocator_key}, std::tuple<vk::device&, uint32_t, bool>{dev, memory_type_index, false});
+                heaps.emplace(std::piecewise_construct, std::tuple{allocator_key}, std::tuple<vk::device&, uint32_t, bool, uint32_t>{dev, memory_type_index, false, granularity});
               }
 
               // mapped (only create an entry for host-visible stuff):
               if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
               {
                 const uint64_t allocator_key = ((uint64_t)memory_type_index) << 32 | (optimal_image) | (/*is_maped_memory*/ 2);
-                heaps.emplace(std::piecewise_construct, std::tuple{allocator_key}, std::tuple<vk::device&, uint32_t, bool>{dev, memory_type_index, true});
+                heaps.emplace(std::piecewise_construct, std::tuple{allocator_key}, std::tuple<vk::device&, uint32_t, bool, uint32_t>{dev, memory_type_index, true, granularity});
               }
 
               if (!separate_buffer_image_allocations)
@@ -517,7 +519,43 @@ namespace neam
 
         size_t get_allocation_count() const
         {
-          return 0;//allocation_count + frame_allocation_count;
+          size_t count = 0;
+          for (auto&& it : heaps)
+            count += it.second.get_stats().persistent.allocation_count;
+          return count;
+        }
+
+        struct heap_stats_t
+        {
+          uint32_t memory_type_index;
+          bool optimal_image;
+          bool mapped_memory;
+          allocator::pool_set::stats_t stats;
+        };
+
+        /// \brief Return the per-heap statistics (used / free memory, fragmentation and block count of the persistent pools, ...)
+        std::vector<heap_stats_t> get_heap_stats() const
+        {
+          std::vector<heap_stats_t> ret;
+          ret.reserve(heaps.size());
+          for (auto&& it : heaps)
+          {
+            ret.push_back(
+            {
+              (uint32_t)(it.first >> 32),
+              (it.first & 1) != 0,
+              (it.first & 2) != 0,
+              it.second.get_stats(),
+            });
+          }
+          return ret;
+        }
+
+        /// \brief Check the consistency of all the persistent pools (slow, debug only)
+        void _check_consistency() const
+        {
+          for (auto&& it : heaps)
+            it.second._check_consistency();
         }
 
         /// \brief print memory stats for the different kind of pools
@@ -531,6 +569,16 @@ namespace neam
                         (get_reserved_memory() / (1024.f * 1024.f)),
                         get_allocation_count(),
                         (get_free_block_count() * allocation_block_size / (1024.f * 1024.f)));
+          for (const auto& it : get_heap_stats())
+          {
+            if (it.stats.allocated_memory == 0)
+              continue;
+            cr::out().log("  heap {:2} (image: {}, mapped: {}): reserved: {:.2f} Mio | persistent: used: {:.2f} Mio, free: {:.2f} Mio, blocks: {}, allocations: {}, fragmentation: {:.1f}%",
+                          it.memory_type_index, it.optimal_image, it.mapped_memory,
+                          it.stats.allocated_memory / (1024.f * 1024.f),
+                          it.stats.persistent.used_memory / (1024.f * 1024.f), it.stats.persistent.free_memory / (1024.f * 1024.f),
+                          it.stats.persistent.block_count, it.stats.persistent.allocation_count, it.stats.persistent.fragmentation() * 100.0f);
+          }
         }
 
       private:
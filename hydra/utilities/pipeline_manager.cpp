@@ -1,24 +1,278 @@
 
 #include "pipeline_manager.hpp"
 
+#include <filesystem>
+
 #include <hydra/engine/hydra_context.hpp>
 
 namespace neam::hydra
 {
+  namespace
+  {
+    /// \brief Header of the on-disk pipeline cache, followed by the vulkan pipeline cache data
+    /// \note The vulkan cache data has its own header, but drivers are not always good at validating it
+    struct pipeline_cache_file_header_t
+    {
+      static constexpr uint32_t k_magic = 0x43505948; // HYPC
+      static constexpr uint32_t k_version = 1;
+
+      uint32_t magic = k_magic;
+      uint32_t version = k_version;
+      uint32_t vendor_id = 0;
+      uint32_t device_id = 0;
+      uint32_t driver_version = 0;
+      uint32_t _padding = 0;
+      uint8_t cache_uuid[VK_UUID_SIZE] = {};
+      uint64_t data_size = 0;
+      id_t data_hash = id_t::none;
+    };
+
+    pipeline_cache_file_header_t make_pipeline_cache_header(const vk::physical_device& pd)
+    {
+      pipeline_cache_file_header_t header;
+      header.vendor_id = pd.get_vendor_id();
+      header.device_id = pd.get_device_id();
+      header.driver_version = pd.get_driver_version();
+      memcpy(header.cache_uuid, pd.get_pipeline_cache_uuid(), VK_UUID_SIZE);
+      return header;
+    }
+  }
+
+  pipeline_manager::pipeline_manager(hydra_context& _hctx, vk::device& _dev)
+    : hctx(_hctx), dev(_dev)
+  {
+    on_index_loaded_tk = hctx.res.on_index_loaded.add([this]
+    {
+      hctx.hconf.read_or_create_conf(configuration).then([this](bool)
+      {
+        load_pipeline_cache();
+      });
+    });
+  }
+
+  void pipeline_manager::set_fallback_pipeline(string_id id, string_id fallback_id)
+  {
+    check::debug::n_assert(id != fallback_id, "pipeline_manager: pipeline {} cannot be its own fallback", id);
+    std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
+    if (fallback_id == id_t::none)
+      fallback_pipelines.erase(id);
+    else
+      fallback_pipelines.insert_or_assign(id, fallback_id);
+  }
+
+  bool pipeline_manager::has_pending_compilations() const
+  {
+    std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+    for (auto& it : pipelines_map)
+    {
+      if (it.second.has_pending_compilations())
+        return true;
+    }
+    return false;
+  }
+
+  pipeline_manager::stats_t pipeline_manager::get_stats() const
+  {
+    std::lock_guard _l(stats_lock);
+    return stats;
+  }
+
+  void pipeline_manager::report_fallback_use(bool has_fallback)
+  {
+    std::lock_guard _l(stats_lock);
+    if (has_fallback)
+      ++stats.fallback_uses;
+    else
+      ++stats.not_ready_uses;
+  }
+
+  template<typename Creator>
+  vk::pipeline pipeline_manager::create_pipeline(Creator& pcr, string_id id, bool is_async)
+  {
+    TRACY_SCOPED_ZONE;
+    VkPipelineCreationFeedback feedback { .flags = 0, .duration = 0 };
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    vk::pipeline p = [&]
+    {
+      if (!configuration.use_pipeline_cache)
+        return pcr.create_pipeline(nullptr, &feedback);
+      std::lock_guard _l { spinlock_shared_adapter::adapt(cache_lock) };
+      return pcr.create_pipeline(&cache, &feedback);
+    }();
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+    if (!p.is_valid())
+      return p;
+
+    const bool has_feedback = (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0;
+    const bool cache_hit = (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+    {
+      std::lock_guard _l(stats_lock);
+      ++stats.compiled_pipelines;
+      if (is_async)
+        ++stats.async_compilations;
+      if (has_feedback && cache_hit)
+        ++stats.cache_hits;
+      else if (has_feedback)
+        ++stats.cache_misses;
+      stats.total_compile_time += duration;
+      stats.max_compile_time = std::max(stats.max_compile_time, duration);
+    }
+
+    cr::out().debug("pipeline {}: compiled in {}us{}{}", id, duration.count(), is_async ? " [async]" : "", !has_feedback ? "" : (cache_hit ? " [cache hit]" : " [cache miss]"));
+    return p;
+  }
+
+  vk::pipeline pipeline_manager::_create_pipeline(vk::graphics_pipeline_creator& gpcr, string_id id, bool is_async)
+  {
+    return create_pipeline(gpcr, id, is_async);
+  }
+
+  vk::pipeline pipeline_manager::_create_pipeline(vk::compute_pipeline_creator& cpcr, string_id id, bool is_async)
+  {
+    return create_pipeline(cpcr, id, is_async);
+  }
+
+  std::string pipeline_manager::get_pipeline_cache_path() const
+  {
+    if (!hctx.res._has_prefix_directory())
+      return {};
+
+    const vk::physical_device& pd = dev.get_physical_device();
+    std::string uuid;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+      uuid += fmt::format("{:02x}", pd.get_pipeline_cache_uuid()[i]);
+
+    const std::filesystem::path path = (std::filesystem::path)hctx.res._get_prefix_directory() / "local" / hctx.program_name
+                                       / fmt::format("pipeline-cache-{}-{:x}.hpc", uuid, pd.get_driver_version());
+    return path.string();
+  }
+
+  async::chain<bool> pipeline_manager::load_pipeline_cache()
+  {
+    if (!configuration.use_pipeline_cache)
+      return async::chain<bool>::create_and_complete(false);
+
+    const std::string path = get_pipeline_cache_path();
+    if (path.empty() || !std::filesystem::exists(path))
+    {
+      cr::out().debug("pipeline_manager: no pipeline cache to load for the current device/driver");
+      return async::chain<bool>::create_and_complete(false);
+    }
+
+    const id_t fid = hctx.io.map_unprefixed_file(path);
+    return hctx.io.queue_read(fid, 0, io::context::whole_file).then([this, path](raw_data&& data, bool success, size_t)
+    {
+      if (!success || data.size < sizeof(pipeline_cache_file_header_t))
+      {
+        cr::out().warn("pipeline_manager: failed to read the pipeline cache file {}", path);
+        return false;
+      }
+
+      pipeline_cache_file_header_t header;
+      memcpy(&header, data.get(), sizeof(header));
+      const pipeline_cache_file_header_t expected = make_pipeline_cache_header(dev.get_physical_device());
+      const uint8_t* cache_data = (const uint8_t*)data.get() + sizeof(header);
+      if (header.magic != expected.magic || header.version != expected.version
+          || header.vendor_id != expected.vendor_id || header.device_id != expected.device_id
+          || header.driver_version != expected.driver_version
+          || memcmp(header.cache_uuid, expected.cache_uuid, VK_UUID_SIZE) != 0
+          || header.data_size != data.size - sizeof(header)
+          || header.data_hash != (id_t)string_id::_runtime_build_from_string((const char*)cache_data, header.data_size))
+      {
+        cr::out().warn("pipeline_manager: ignoring pipeline cache file {}: device/driver mismatch or corrupted file", path);
+        return false;
+      }
+
+      vk::pipeline_cache loaded_cache { dev, cache_data, header.data_size };
+      {
+        std::lock_guard _l { spinlock_exclusive_adapter::adapt(cache_lock) };
+        cache.merge_with(loaded_cache);
+      }
+      cr::out().debug("pipeline_manager: loaded pipeline cache ({} bytes) from {}", header.data_size, path);
+      return true;
+    });
+  }
+
+  async::chain<bool> pipeline_manager::save_pipeline_cache()
+  {
+    if (!configuration.use_pipeline_cache)
+      return async::chain<bool>::create_and_complete(false);
+
+    const std::string path = get_pipeline_cache_path();
+    if (path.empty())
+    {
+      cr::out().debug("pipeline_manager: not saving the pipeline cache: index has no prefix directory");
+      return async::chain<bool>::create_and_complete(false);
+    }
+
+    vk::pipeline_cache_data cache_data = [this]
+    {
+      std::lock_guard _l { spinlock_shared_adapter::adapt(cache_lock) };
+      return cache.get_cache_data();
+    }();
+
+    pipeline_cache_file_header_t header = make_pipeline_cache_header(dev.get_physical_device());
+    header.data_size = cache_data.size();
+    header.data_hash = string_id::_runtime_build_from_string((const char*)cache_data.data(), cache_data.size());
+
+    raw_data file = raw_data::allocate(sizeof(header) + cache_data.size());
+    memcpy(file.get(), &header, sizeof(header));
+    memcpy((uint8_t*)file.get() + sizeof(header), cache_data.data(), cache_data.size());
+
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+    const id_t fid = hctx.io.map_unprefixed_file(path);
+    return hctx.io.queue_write(fid, io::context::truncate, std::move(file)).then([path, size = cache_data.size()](raw_data&& /*data*/, bool success, size_t /*write_size*/)
+    {
+      if (success)
+        cr::out().debug("pipeline_manager: saved pipeline cache ({} bytes) to {}", size, path);
+      else
+        cr::out().warn("pipeline_manager: failed to save the pipeline cache to {}", path);
+      return success;
+    });
+  }
+
   void pipeline_manager::register_shader_reload_event(hydra_context& hctx, bool use_graphic_queue)
   {
-    on_shaders_reloaded = hctx.shmgr.on_shaders_reloaded.add([this, &hctx, use_graphic_queue]()
+    on_shaders_reloaded = hctx.shmgr.on_shaders_reloaded.add([this](const std::set<const vk::shader_module*>& modules)
     {
-      cr::out().warn("pipeline_manager: recreating all the pipelines (caused by shader reload)");
+      cr::out().debug("pipeline_manager: {} shader modules were reloaded, pipelines using them will be recreated", modules.size());
+      {
+        std::lock_guard _l { refresh_lock };
+        modules_to_refresh.insert(modules.begin(), modules.end());
+      }
       need_refresh = true;
-      // vk::queue& queue = (use_graphic_queue ? hctx.gqueue : hctx.cqueue);
-      //
-      // refresh(vrd, queue);
-      //
-      // vk::fence fence { hctx.device };
-      // queue.submit(hctx.dqe, fence);
-      // vrd.postpone_destruction_inclusive(queue, std::move(fence));
-      // hctx.vrd.append(std::move(vrd));
     });
   }
+
+  void pipeline_manager::refresh_reloaded_shaders()
+  {
+    TRACY_SCOPED_ZONE;
+    std::set<const vk::shader_module*> modules;
+    {
+      std::lock_guard _l { refresh_lock };
+      need_refresh = false;
+      std::swap(modules, modules_to_refresh);
+    }
+    if (modules.empty())
+      return;
+
+    uint32_t invalidated_pipelines = 0;
+    size_t pipeline_count = 0;
+    {
+      std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+      pipeline_count = pipelines_map.size();
+      for (auto& it : pipelines_map)
+      {
+        if (!it.second.uses_any_shader_module(modules))
+          continue;
+        it.second.invalidate_pipelines();
+        ++invalidated_pipelines;
+      }
+    }
+
+    cr::out().log("pipeline_manager: shader reload: {} modules changed, recreating {} pipelines (out of {})", modules.size(), invalidated_pipelines, pipeline_count);
+    on_shader_hot_reload((uint32_t)modules.size(), invalidated_pipelines);
+  }
 }
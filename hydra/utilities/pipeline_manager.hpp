@@ -32,17 +32,49 @@
 
 #include <ntools/mt_check/map.hpp>
 #include <string>
+#include <set>
+#include <chrono>
 
 #include <ntools/id/string_id.hpp>
 #include <ntools/id/id.hpp>
 #include <ntools/event.hpp>
+#include <ntools/async/async.hpp>
 #include "../hydra_debug.hpp"
 
 #include "../vulkan/device.hpp"
 #include "../vulkan/pipeline.hpp"
+#include "../vulkan/pipeline_cache.hpp"
+#include "../engine/conf/conf.hpp"
 
 #include "pipeline_render_state.hpp"
 
+namespace neam::hydra
+{
+  struct pipeline_manager_configuration : hydra::conf::hconf<pipeline_manager_configuration, "configuration/pipeline_manager.hcnf", conf::location_t::index_program_local_dir>
+  {
+    bool async_compilation = true;
+    bool use_pipeline_cache = true;
+  };
+}
+
+N_METADATA_STRUCT(neam::hydra::pipeline_manager_configuration)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(async_compilation, neam::metadata::info{.description = c_string_t
+    <
+      "If true, pipeline variants are compiled on worker threads the first time they are requested.\n"
+      "Until a variant is ready, the fallback pipeline (if any) is returned instead, or an invalid pipeline (draws/dispatches using it are skipped).\n"
+      "Variants that depend on a render-pass or on a mesh vertex description are always compiled synchronously."
+    >}),
+    N_MEMBER_DEF(use_pipeline_cache, neam::metadata::info{.description = c_string_t
+    <
+      "If true, a vulkan pipeline cache is used when compiling pipelines, and is saved / loaded from the local folder next to the index.\n"
+      "The cache file is specific to the device and driver version (a driver update will start from an empty cache)."
+    >})
+  >;
+};
+
 namespace neam
 {
   namespace hydra
@@ -56,12 +88,29 @@ namespace neam
     /// \note Unlike shader_manager, pipelines need to be created before being used
     ///       but one created they can be quickly modified / refreshed
     ///
-    /// \todo handle transparently pipeline caches
+    /// \note Pipelines are created with a pipeline cache that is persisted on disk (see pipeline_manager_configuration)
     class pipeline_manager
     {
       public:
-        pipeline_manager(hydra_context& _hctx, vk::device &_dev) : hctx(_hctx), dev(_dev) {}
-        pipeline_manager(pipeline_manager &&o) : hctx(o.hctx), dev(o.dev), pipelines_map(std::move(o.pipelines_map)) {}
+        /// \brief Pipeline compilation statistics (since the creation of the manager)
+        struct stats_t
+        {
+          uint64_t compiled_pipelines = 0;
+          uint64_t async_compilations = 0;
+
+          // only counted when the driver provides the information (VK_EXT_pipeline_creation_feedback / vulkan 1.3):
+          uint64_t cache_hits = 0;
+          uint64_t cache_misses = 0;
+
+          std::chrono::microseconds total_compile_time { 0 };
+          std::chrono::microseconds max_compile_time { 0 };
+
+          uint64_t fallback_uses = 0; // number of get_pipeline calls that returned the fallback pipeline
+          uint64_t not_ready_uses = 0; // number of get_pipeline calls that returned an invalid pipeline (no fallback)
+        };
+
+      public:
+        pipeline_manager(hydra_context& _hctx, vk::device &_dev);
 
         template<typename Fnc>
         void add_pipeline(const string_id id, Fnc&& fnc)
@@ -104,13 +153,27 @@ namespace neam
         }
 
         /// \brief Return the pipeline named name
+        /// \note If the pipeline is not ready (shader loading, asynchronous compilation) the fallback pipeline is returned, if any
+        ///       Otherwise an invalid pipeline is returned.
         template<typename... Args>
         const vk::pipeline& get_pipeline(const string_id id, Args&&... args)
         {
           auto& prs = find_pipeline(id)->second;
-          if (!prs.can_make_valid_pipelines())
-            return invalid_pipeline;
-          return prs.get_pipeline(std::forward<Args>(args)...);
+          if (prs.can_make_valid_pipelines())
+          {
+            const vk::pipeline& p = prs.get_pipeline(args...);
+            if (p.is_valid())
+              return p;
+          }
+
+          const string_id fallback_id = get_fallback_pipeline(id);
+          if (fallback_id != id_t::none)
+          {
+            report_fallback_use(true);
+            return get_pipeline(fallback_id, std::forward<Args>(args)...);
+          }
+          report_fallback_use(false);
+          return invalid_pipeline;
         }
         template<typename Type, typename... Args>
         const vk::pipeline& get_pipeline(Args&&... args)
@@ -150,6 +213,10 @@ namespace neam
         /// \brief Recreate all the pipelines
         void refresh()
         {
+          {
+            std::lock_guard _l { refresh_lock };
+            modules_to_refresh.clear();
+          }
           std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
           need_refresh = false;
           cr::out().debug("pipeline manager: invalidating all pipelines");
@@ -164,11 +231,67 @@ namespace neam
           return pipelines_map.size();
         }
 
+        /// \brief Set the pipeline to use when \p id is not ready (being compiled, shaders loading, ...)
+        /// \note The fallback is requested with the same parameters as the original pipeline.
+        ///       The fallback is expected to be a simpler, always ready pipeline (compiled upfront, ...).
+        ///       Set \p fallback_id to none to remove the fallback.
+        void set_fallback_pipeline(string_id id, string_id fallback_id);
+        template<typename Type, typename FallbackType>
+        void set_fallback_pipeline()
+        {
+          set_fallback_pipeline(Type::pipeline_id, FallbackType::pipeline_id);
+        }
+
+        string_id get_fallback_pipeline(string_id id) const
+        {
+          std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+          if (auto it = fallback_pipelines.find(id); it != fallback_pipelines.end())
+            return it->second;
+          return {};
+        }
+
+        /// \brief Return whether any pipeline is still being compiled asynchronously
+        bool has_pending_compilations() const;
+
+        bool is_async_compilation_enabled() const { return configuration.async_compilation; }
+
+        stats_t get_stats() const;
+
+        /// \brief Load the pipeline cache from disk and merge it in the current cache
+        /// \note Automatically done when the index is loaded
+        async::chain<bool> load_pipeline_cache();
+
+        /// \brief Save the pipeline cache to disk
+        /// \note Should be done before shutdown, when a lot of pipelines have been compiled
+        async::chain<bool> save_pipeline_cache();
+
       public:
         void register_shader_reload_event(hydra_context& hctx, bool use_graphic_queue = true);
 
         bool should_refresh() const { return need_refresh; }
 
+        /// \brief Recreate the pipelines using the shader modules that were reloaded since the last call
+        void refresh_reloaded_shaders();
+
+      public:
+        /// \brief Called by refresh_reloaded_shaders() after the pipelines have been invalidated
+        cr::event<uint32_t /* reloaded modules */, uint32_t /* invalidated pipelines */> on_shader_hot_reload;
+
+      public: // advanced
+        /// \brief Create a pipeline (using the pipeline cache), and update the stats
+        /// \note Called by pipeline_render_state, with the creator lock held
+        vk::pipeline _create_pipeline(vk::graphics_pipeline_creator& gpcr, string_id id, bool is_async);
+        vk::pipeline _create_pipeline(vk::compute_pipeline_creator& cpcr, string_id id, bool is_async);
+
+      private:
+        template<typename Creator>
+        vk::pipeline create_pipeline(Creator& pcr, string_id id, bool is_async);
+
+        void report_fallback_use(bool has_fallback);
+
+        /// \brief Return the path of the cache file for the current device / driver. Returns an empty string if there is none.
+        std::string get_pipeline_cache_path() const;
+
       private:
         hydra_context& hctx;
         vk::device &dev;
@@ -176,9 +299,22 @@ namespace neam
         vk::pipeline invalid_pipeline { dev, nullptr, VK_PIPELINE_BIND_POINT_GRAPHICS };
         vk::pipeline_layout invalid_pipeline_layout { dev, nullptr };
         std::mtc_map<string_id, pipeline_render_state> pipelines_map;
+        std::mtc_map<string_id, string_id> fallback_pipelines;
+
+        pipeline_manager_configuration configuration;
+        cr::event_token_t on_index_loaded_tk;
+
+        // vkCreate*Pipelines are internally synchronized on the cache, but merges are not:
+        mutable shared_spinlock cache_lock;
+        vk::pipeline_cache cache { dev };
+
+        mutable spinlock stats_lock;
+        stats_t stats;
 
         cr::event_token_t on_shaders_reloaded;
         bool need_refresh = false;
+        spinlock refresh_lock;
+        std::set<const vk::shader_module*> modules_to_refresh;
 
       private:
         auto find_pipeline(string_id id) const -> decltype(pipelines_map.find(id))
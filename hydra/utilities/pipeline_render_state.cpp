@@ -39,7 +39,11 @@ namespace neam::hydra
 
     {
       std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
-      std::swap(pipelines, temp_pipelines);
+      {
+        std::lock_guard _pl { spinlock_exclusive_adapter::adapt(pipelines_lock) };
+        std::swap(pipelines, temp_pipelines);
+        generation.fetch_add(1, std::memory_order_acq_rel);
+      }
       std::swap(pipeline_layout, temp_layout);
       std::swap(ds_layouts, temp_ds_layouts);
     }
@@ -64,6 +68,9 @@ namespace neam::hydra
           xpcr.set_dirty(false);
         }
         std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
+        // another thread (async compilation) might have been faster:
+        if (!ds_layouts.empty())
+          return;
         descriptor_set_map.clear();
         const std::string debug_name = fmt::format("{}", pipeline_id);
         cr::out().debug("building ref data for {}", debug_name);
@@ -103,6 +110,98 @@ namespace neam::hydra
     }, pcr);
   }
 
+  const vk::pipeline& pipeline_render_state::insert_pipeline(id_t hash, vk::pipeline&& p)
+  {
+    std::lock_guard _l { spinlock_exclusive_adapter::adapt(pipelines_lock) };
+    return insert_pipeline_unlocked(hash, std::move(p));
+  }
+
+  const vk::pipeline& pipeline_render_state::insert_pipeline_unlocked(id_t hash, vk::pipeline&& p)
+  {
+    auto [it, inserted] = pipelines.try_emplace(hash, std::move(p));
+    if (!inserted)
+    {
+      // someone was faster than us, discard our version
+      hctx.dfe.defer_destruction(std::move(p));
+      return it->second;
+    }
+    it->second._set_debug_name(fmt::format("{} spec. hash: {} ", pipeline_id, hash));
+    it->second._set_cpp_struct_to_set(descriptor_set_map);
+    it->second._set_pipeline_id(pipeline_id);
+    return it->second;
+  }
+
+  vk::pipeline pipeline_render_state::create_pipeline_unlocked(vk::graphics_pipeline_creator& gpcr, bool is_async)
+  {
+    return hctx.ppmgr._create_pipeline(gpcr, pipeline_id, is_async);
+  }
+
+  vk::pipeline pipeline_render_state::create_pipeline_unlocked(vk::compute_pipeline_creator& cpcr, bool is_async)
+  {
+    return hctx.ppmgr._create_pipeline(cpcr, pipeline_id, is_async);
+  }
+
+  bool pipeline_render_state::should_compile_asynchronously() const
+  {
+    return hctx.ppmgr.is_async_compilation_enabled();
+  }
+
+  const vk::pipeline& pipeline_render_state::queue_async_compilation(async_compilation_request_t&& request)
+  {
+    {
+      std::lock_guard _l { spinlock_exclusive_adapter::adapt(pipelines_lock) };
+      // already being compiled:
+      if (!pending_compilations.emplace(request.hash).second)
+        return not_ready_pipeline;
+    }
+
+    const uint32_t request_generation = generation.load(std::memory_order_acquire);
+    hctx.tm.get_long_duration_task([this, request = std::move(request), request_generation] mutable
+    {
+      TRACY_SCOPED_ZONE;
+      const id_t hash = request.hash;
+
+      build_data_from_reflection_if_needed();
+
+      std::optional<vk::pipeline> p;
+      {
+        std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
+        if (generation.load(std::memory_order_acquire) == request_generation && can_make_valid_pipelines())
+        {
+          log_pipeline_compilation(hash);
+          std::visit([&](auto& xpcr)
+          {
+            if constexpr (std::is_same_v<std::monostate&, decltype(xpcr)>) __builtin_unreachable();
+            else
+            {
+              if constexpr (std::is_same_v<vk::graphics_pipeline_creator&, decltype(xpcr)>)
+              {
+                xpcr.clear_render_pass();
+                if (request.prci)
+                  xpcr.set_pipeline_create_info(*request.prci);
+              }
+              xpcr.get_pipeline_shader_stage().specialize(request.spec);
+              p.emplace(create_pipeline_unlocked(xpcr, true));
+            }
+          }, pcr);
+        }
+      }
+
+      std::lock_guard _l { spinlock_exclusive_adapter::adapt(pipelines_lock) };
+      pending_compilations.erase(hash);
+      if (!p)
+        return;
+      // the pipelines have been invalidated while we were compiling, the result is outdated:
+      if (generation.load(std::memory_order_acquire) != request_generation)
+      {
+        hctx.dfe.defer_destruction(std::move(*p));
+        return;
+      }
+      insert_pipeline_unlocked(hash, std::move(*p));
+    });
+    return not_ready_pipeline;
+  }
+
   hydra::vk::compute_pipeline_creator& pipeline_render_state::create_simple_compute(hydra_context& context, string_id shader)
   {
     hydra::vk::compute_pipeline_creator& pcr = get_compute_pipeline_creator();
@@ -26,6 +26,10 @@
 
 #pragma once
 
+#include <optional>
+#include <set>
+#include <atomic>
+
 #include <hydra/vulkan/pipeline.hpp>
 #include <hydra/vulkan/render_pass.hpp>
 #include <hydra/vulkan/descriptor_set_layout.hpp>
@@ -36,6 +40,7 @@
 #include <ntools/mt_check/vector.hpp>
 #include <ntools/mt_check/unordered_map.hpp>
 #include <ntools/mt_check/map.hpp>
+#include <ntools/mt_check/set.hpp>
 
 namespace neam::hydra
 {
@@ -95,6 +100,7 @@ namespace neam::hydra
       hydra::vk::compute_pipeline_creator& create_simple_compute(hydra_context& context, string_id shader);
 
       /// \brief Create or retrieve a pipeline that does not require a render-pass
+      /// \note If asynchronous compilation is enabled, an invalid pipeline is returned until the pipeline is ready
       const vk::pipeline& get_pipeline(const vk::specialization& spec = {})
       {
         if (std::holds_alternative<std::monostate>(pcr))
@@ -114,10 +120,11 @@ namespace neam::hydra
             }
           }
         }, pcr);
-        if (auto it = pipelines.find(hash); it != pipelines.end())
-        {
-          return it->second;
-        }
+        if (const vk::pipeline* p = find_existing_pipeline(hash); p != nullptr)
+          return *p;
+
+        if (should_compile_asynchronously())
+          return queue_async_compilation({ .hash = hash, .spec = spec.duplicate() });
 
         if (std::holds_alternative<vk::graphics_pipeline_creator>(pcr))
           std::get<vk::graphics_pipeline_creator>(pcr).clear_render_pass();
@@ -133,16 +140,13 @@ namespace neam::hydra
 
             std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
             xpcr.get_pipeline_shader_stage().specialize(spec);
-            auto [it, inserted] = pipelines.emplace(hash, xpcr.create_pipeline());
-            it->second._set_debug_name(fmt::format("{} spec. hash: {} ", pipeline_id, hash));
-            it->second._set_cpp_struct_to_set(descriptor_set_map);
-            it->second._set_pipeline_id(pipeline_id);
-            return it->second;
+            return insert_pipeline(hash, create_pipeline_unlocked(xpcr, false));
           }
         }, pcr);
       }
 
       /// \brief Create or retrieve a pipeline for a given pipeline_rendering_create_info
+      /// \note If asynchronous compilation is enabled, an invalid pipeline is returned until the pipeline is ready
       const vk::pipeline& get_pipeline(const vk::pipeline_rendering_create_info& prci, const vk::specialization& spec = {})
       {
         if (!std::holds_alternative<vk::graphics_pipeline_creator>(pcr))
@@ -157,10 +161,11 @@ namespace neam::hydra
           invalidate_pipelines();
           gpcr.set_dirty(false);
         }
-        if (auto it = pipelines.find(hash); it != pipelines.end())
-        {
-          return it->second;
-        }
+        if (const vk::pipeline* p = find_existing_pipeline(hash); p != nullptr)
+          return *p;
+
+        if (should_compile_asynchronously())
+          return queue_async_compilation({ .hash = hash, .prci = prci, .spec = spec.duplicate() });
 
         build_data_from_reflection_if_needed();
 
@@ -169,14 +174,11 @@ namespace neam::hydra
         std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
         gpcr.set_pipeline_create_info(prci);
         gpcr.get_pipeline_shader_stage().specialize(spec);
-        auto [it, inserted] = pipelines.emplace(hash, gpcr.create_pipeline());
-        it->second._set_debug_name(fmt::format("{} spec. hash: {} ", pipeline_id, hash));
-        it->second._set_cpp_struct_to_set(descriptor_set_map);
-        it->second._set_pipeline_id(pipeline_id);
-        return it->second;
+        return insert_pipeline(hash, create_pipeline_unlocked(gpcr, false));
       }
 
       /// \brief Create or retrieve a pipeline for a given create info/mesh
+      /// \note Always compiled synchronously
       const vk::pipeline& get_pipeline(const vk::pipeline_rendering_create_info& prci, hydra::mesh& m /*TODO*/,
                                        const vk::specialization& spec = {})
       {
@@ -191,10 +193,8 @@ namespace neam::hydra
           invalidate_pipelines();
           gpcr.set_dirty(false);
         }
-        if (auto it = pipelines.find(hash); it != pipelines.end())
-        {
-          return it->second;
-        }
+        if (const vk::pipeline* p = find_existing_pipeline(hash); p != nullptr)
+          return *p;
 
         build_data_from_reflection_if_needed();
 
@@ -204,14 +204,11 @@ namespace neam::hydra
         gpcr.set_pipeline_create_info(prci);
         gpcr.get_pipeline_shader_stage().specialize(spec);
         m.setup_vertex_description(gpcr);
-        auto [it, inserted] = pipelines.emplace(hash, gpcr.create_pipeline());
-        it->second._set_debug_name(fmt::format("{} spec. hash: {} ", pipeline_id, hash));
-        it->second._set_cpp_struct_to_set(descriptor_set_map);
-        it->second._set_pipeline_id(pipeline_id);
-        return it->second;
+        return insert_pipeline(hash, create_pipeline_unlocked(gpcr, false));
       }
 
       /// \brief Create or retrieve a pipeline for a given render-pass/mesh
+      /// \note Always compiled synchronously
       const vk::pipeline& get_pipeline(const vk::render_pass& pass, uint32_t subpass, hydra::mesh& m /*TODO*/,
                                        const vk::specialization& spec = {})
       {
@@ -226,10 +223,8 @@ namespace neam::hydra
           invalidate_pipelines();
           gpcr.set_dirty(false);
         }
-        if (auto it = pipelines.find(hash); it != pipelines.end())
-        {
-          return it->second;
-        }
+        if (const vk::pipeline* p = find_existing_pipeline(hash); p != nullptr)
+          return *p;
 
         build_data_from_reflection_if_needed();
 
@@ -240,15 +235,13 @@ namespace neam::hydra
         gpcr.set_subpass_index(subpass);
         gpcr.get_pipeline_shader_stage().specialize(spec);
         m.setup_vertex_description(gpcr);
-        auto [it, inserted] = pipelines.emplace(hash, gpcr.create_pipeline());
+        vk::pipeline p = create_pipeline_unlocked(gpcr, false);
         gpcr.clear_render_pass();
-        it->second._set_debug_name(fmt::format("{} spec. hash: {} ", pipeline_id, hash));
-        it->second._set_cpp_struct_to_set(descriptor_set_map);
-        it->second._set_pipeline_id(pipeline_id);
-        return it->second;
+        return insert_pipeline(hash, std::move(p));
       }
 
       /// \brief Create or retrieve a pipeline for a given render-pass
+      /// \note Always compiled synchronously
       const vk::pipeline& get_pipeline(const vk::render_pass& pass, uint32_t subpass, const vk::specialization& spec = {})
       {
         if (!std::holds_alternative<vk::graphics_pipeline_creator>(pcr))
@@ -263,10 +256,8 @@ namespace neam::hydra
           invalidate_pipelines();
           gpcr.set_dirty(false);
         }
-        if (auto it = pipelines.find(hash); it != pipelines.end())
-        {
-          return it->second;
-        }
+        if (const vk::pipeline* p = find_existing_pipeline(hash); p != nullptr)
+          return *p;
 
         build_data_from_reflection_if_needed();
 
@@ -276,12 +267,16 @@ namespace neam::hydra
         gpcr.set_render_pass(pass);
         gpcr.set_subpass_index(subpass);
         gpcr.get_pipeline_shader_stage().specialize(spec);
-        auto [it, inserted] = pipelines.emplace(hash, gpcr.create_pipeline());
+        vk::pipeline p = create_pipeline_unlocked(gpcr, false);
         gpcr.clear_render_pass();
-        it->second._set_debug_name(fmt::format("{} spec. hash: {} ", pipeline_id, hash));
-        it->second._set_cpp_struct_to_set(descriptor_set_map);
-        it->second._set_pipeline_id(pipeline_id);
-        return it->second;
+        return insert_pipeline(hash, std::move(p));
+      }
+
+      /// \brief Return whether an asynchronous compilation is in progress for this pipeline
+      bool has_pending_compilations() const
+      {
+        std::lock_guard _l { spinlock_shared_adapter::adapt(pipelines_lock) };
+        return !pending_compilations.empty();
       }
 
       /// \brief Returns false is no valid pipeline can be made at this time
@@ -296,6 +291,18 @@ namespace neam::hydra
         }, pcr);
       }
 
+      /// \brief Return whether the pipeline uses any of the shader modules in \p modules
+      bool uses_any_shader_module(const std::set<const vk::shader_module*>& modules) const
+      {
+        std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+        return std::visit([&modules](const auto& xpcr) -> bool
+        {
+          if constexpr (std::is_same_v<const std::monostate&, decltype(xpcr)>) return false;
+          else
+            return xpcr.get_pipeline_shader_stage().uses_any_shader_module(modules);
+        }, pcr);
+      }
+
       VkPipelineBindPoint get_pipeline_bind_point() const
       {
         if (std::holds_alternative<vk::graphics_pipeline_creator>(pcr))
@@ -306,8 +313,41 @@ namespace neam::hydra
       }
 
     private:
+      /// \brief What is needed to compile a pipeline variant outside of the get_pipeline call
+      struct async_compilation_request_t
+      {
+        id_t hash;
+        std::optional<vk::pipeline_rendering_create_info> prci = {};
+        vk::specialization spec;
+      };
+
       void build_data_from_reflection_if_needed();
 
+      const vk::pipeline* find_existing_pipeline(id_t hash) const
+      {
+        std::lock_guard _l { spinlock_shared_adapter::adapt(pipelines_lock) };
+        if (auto it = pipelines.find(hash); it != pipelines.end())
+          return &it->second;
+        return nullptr;
+      }
+
+      /// \brief Add a pipeline to the pipeline map (set its debug name, ...) and return a reference to it
+      /// \note If a pipeline is already present for the hash (another thread was faster), \p p is discarded
+      const vk::pipeline& insert_pipeline(id_t hash, vk::pipeline&& p);
+      /// \note pipelines_lock must be held (exclusive)
+      const vk::pipeline& insert_pipeline_unlocked(id_t hash, vk::pipeline&& p);
+
+      /// \note lock must be held
+      vk::pipeline create_pipeline_unlocked(vk::graphics_pipeline_creator& gpcr, bool is_async);
+      /// \note lock must be held
+      vk::pipeline create_pipeline_unlocked(vk::compute_pipeline_creator& cpcr, bool is_async);
+
+      bool should_compile_asynchronously() const;
+
+      /// \brief Queue the compilation of a pipeline variant on a worker thread
+      /// \return the (invalid) not-ready pipeline
+      const vk::pipeline& queue_async_compilation(async_compilation_request_t&& request);
+
     private:
       void log_pipeline_compilation(id_t hash) const
       {
@@ -325,7 +365,13 @@ namespace neam::hydra
       std::mtc_unordered_map<id_t, uint32_t> descriptor_set_map;
 
       // specializations:
+      // (pipelines_lock protects pipelines and pending_compilations, lock protects the creator and layouts.
+      //  Lookups never wait for a compilation to be done)
+      mutable shared_spinlock pipelines_lock;
       std::mtc_map<id_t, vk::pipeline> pipelines;
+      std::mtc_set<id_t> pending_compilations;
+      std::atomic<uint32_t> generation = 0; // incremented at each invalidation, to discard outdated async compilations
+      vk::pipeline not_ready_pipeline { dev, nullptr, VK_PIPELINE_BIND_POINT_GRAPHICS };
 
       std::mtc_map<id_t, vk::descriptor_set_entries> id_to_descriptor_set_entry;
       std::mtc_map<id_t, vk::push_constant_entry> id_to_push_constant_entry;
@@ -30,7 +30,9 @@
 #pragma once
 
 #include <string>
+#include <set>
 #include <ntools/mt_check/map.hpp>
+#include <ntools/hash/fnv1a.hpp>
 
 #include "../vulkan/shader_module.hpp"
 
@@ -49,6 +51,8 @@ namespace neam::hydra
   /// to retrieve shader modules does not really matter
   ///
   /// \note Only the spirv loaded is currently handled
+  /// \note On index reload, only the modules whose index entry changed are re-fetched,
+  ///       and only the modules whose content changed are recreated (see on_shaders_reloaded)
   class shader_manager
   {
     public:
@@ -57,7 +61,7 @@ namespace neam::hydra
       {
         register_index_reload_event();
       }
-      shader_manager(shader_manager &&o) : dev(o.dev), res_context(o.res_context), module_map(std::move(o.module_map))
+      shader_manager(shader_manager &&o) : dev(o.dev), res_context(o.res_context), module_map(std::move(o.module_map)), module_states(std::move(o.module_states))
       {
         register_index_reload_event();
         o.on_index_loaded.release();
@@ -99,8 +103,9 @@ namespace neam::hydra
         }
 
         // query the index for the module:
+        const uint64_t entry_hash = get_entry_hash(rid);
         return res_context.read_resource<assets::spirv_variation>(rid)
-        .then([rid, this, force_reload](assets::spirv_variation&& mod, resources::status st)
+        .then([rid, this, force_reload, entry_hash](assets::spirv_variation&& mod, resources::status st)
         {
           if (st == resources::status::failure)
           {
@@ -114,10 +119,28 @@ namespace neam::hydra
 
             vk::shader_module vkmod { dev, nullptr, 0, "" };
             auto ret = module_map.insert_or_assign(rid, std::move(vkmod));
+            module_state_t& state = module_states[rid];
+            state = { .entry_hash = entry_hash, .revision = state.revision + 1 };
 
             return async::chain<vk::shader_module&>::create_and_complete(ret.first->second);
           }
 
+          const uint64_t content_hash = ct::hash::fnv1a<64>((const uint8_t*)mod.module.data.get(), mod.module.size);
+          const uint64_t root_entry_hash = get_entry_hash(mod.root);
+          if (force_reload)
+          {
+            std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
+            auto it = module_map.find(rid);
+            auto sit = module_states.find(rid);
+            // the index entry changed, but not the module: no need to recreate it
+            if (it != module_map.end() && sit != module_states.end()
+                && sit->second.content_hash == content_hash && sit->second.root_entry_hash == root_entry_hash)
+            {
+              sit->second.entry_hash = entry_hash;
+              return async::chain<vk::shader_module&>::create_and_complete(it->second);
+            }
+          }
+
           vk::shader_module vkmod { dev, (const uint32_t*)mod.module.data.get(), mod.module.size, mod.stage, mod.entry_point };
           vkmod._set_debug_name(res_context.resource_name(rid));
 
@@ -125,7 +148,7 @@ namespace neam::hydra
           vkmod.get_descriptor_sets() = std::move(mod.descriptor_set);
 
           return res_context.read_resource<assets::spirv_shader>(mod.root)
-          .then([this, rid, root_id = mod.root, vkmod = std::move(vkmod), force_reload]
+          .then([this, rid, root_id = mod.root, vkmod = std::move(vkmod), force_reload, entry_hash, root_entry_hash, content_hash]
                        (assets::spirv_shader&& shader_info, resources::status st) mutable -> vk::shader_module &
           {
             if (st == resources::status::failure)
@@ -140,16 +163,24 @@ namespace neam::hydra
             if (auto it = module_map.find(rid); it != module_map.end() && !force_reload)
               return it->second;
             auto ret = module_map.insert_or_assign(rid, std::move(vkmod));
+            module_state_t& state = module_states[rid];
+            state =
+            {
+              .root = root_id,
+              .entry_hash = entry_hash,
+              .root_entry_hash = root_entry_hash,
+              .content_hash = content_hash,
+              .revision = state.revision + 1,
+            };
             return ret.first->second;
           });
         });
       }
 
       /// \brief Reload all shaders from the disk
+      /// \note Modules with the same content are not recreated
       async::continuation_chain refresh()
       {
-        std::vector<async::continuation_chain> chains;
-
         cr::out().warn("shader manager: reloading all loaded shaders");
         std::vector<id_t> ids;
         {
@@ -157,14 +188,31 @@ namespace neam::hydra
           for (auto& it : module_map)
             ids.push_back(it.first);
         }
+        return reload_modules(std::move(ids));
+      }
 
-        for (id_t it : ids)
-          chains.push_back(load_shader(it, true).to_continuation());
-
-        return async::multi_chain(std::move(chains)).then([this]()
+      /// \brief Reload the shaders whose index entry (or the one of their root shader) changed
+      async::continuation_chain refresh_modified()
+      {
+        std::vector<id_t> ids;
+        size_t module_count = 0;
         {
-          on_shaders_reloaded();
-        });
+          std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+          module_count = module_map.size();
+          for (auto& it : module_map)
+          {
+            const module_state_t* state = nullptr;
+            if (auto sit = module_states.find(it.first); sit != module_states.end())
+              state = &sit->second;
+            if (state == nullptr || state->entry_hash != get_entry_hash(it.first)
+                || (state->root != id_t::none && state->root_entry_hash != get_entry_hash(state->root)))
+            {
+              ids.push_back(it.first);
+            }
+          }
+        }
+        cr::out().debug("shader manager: {} modified shaders (out of {} loaded shaders)", ids.size(), module_count);
+        return reload_modules(std::move(ids));
       }
 
       /// \brief Remove all modules
@@ -172,6 +220,7 @@ namespace neam::hydra
       {
         std::lock_guard _l { spinlock_exclusive_adapter::adapt(lock) };
         module_map.clear();
+        module_states.clear();
       }
 
       size_t get_shader_count() const
@@ -181,12 +230,75 @@ namespace neam::hydra
       }
 
     public:
-      cr::event<> on_shaders_reloaded;
+      /// \brief Called after a refresh, with the modules that were recreated
+      /// \note Not called if no module was recreated
+      cr::event<const std::set<const vk::shader_module*>& /* reloaded modules */> on_shaders_reloaded;
 
     private:
+      /// \brief What is needed to know if a module changed
+      struct module_state_t
+      {
+        id_t root = id_t::none;
+        uint64_t entry_hash = 0;
+        uint64_t root_entry_hash = 0;
+        uint64_t content_hash = 0; // hash of the spirv
+        uint32_t revision = 0; // incremented each time the module is recreated
+      };
+
       void register_index_reload_event()
       {
-        on_index_loaded = res_context.on_index_loaded.add([this]() { refresh(); });
+        on_index_loaded = res_context.on_index_loaded.add([this]() { refresh_modified(); });
+      }
+
+      /// \brief Return a hash of the index entry of a resource, which changes when the resource is repacked
+      uint64_t get_entry_hash(id_t rid) const
+      {
+        const resources::index& index = res_context.get_index();
+        const resources::index::entry entry = index.get_entry(rid);
+        const uint64_t fields[] = { (uint64_t)entry.flags, (uint64_t)entry.pack_file, entry.offset, entry.size };
+        uint64_t hash = ct::hash::fnv1a<64>((const uint8_t*)fields, sizeof(fields));
+        if (const auto view = index.get_embedded_data_view(rid); view)
+          hash = ct::hash::fnv1a_continue<64>(hash, view->data(), view->size());
+        return hash;
+      }
+
+      uint32_t get_revision_unlocked(id_t rid) const
+      {
+        if (auto it = module_states.find(rid); it != module_states.end())
+          return it->second.revision;
+        return 0;
+      }
+
+      async::continuation_chain reload_modules(std::vector<id_t>&& ids)
+      {
+        std::vector<async::continuation_chain> chains;
+        std::vector<uint32_t> revisions;
+        {
+          std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+          for (id_t it : ids)
+            revisions.push_back(get_revision_unlocked(it));
+        }
+
+        for (id_t it : ids)
+          chains.push_back(load_shader(it, true).to_continuation());
+
+        return async::multi_chain(std::move(chains)).then([this, ids = std::move(ids), revisions = std::move(revisions)]()
+        {
+          std::set<const vk::shader_module*> reloaded;
+          {
+            std::lock_guard _l { spinlock_shared_adapter::adapt(lock) };
+            for (uint32_t i = 0; i < ids.size(); ++i)
+            {
+              if (get_revision_unlocked(ids[i]) == revisions[i])
+                continue;
+              if (auto it = module_map.find(ids[i]); it != module_map.end())
+                reloaded.insert(&it->second);
+            }
+          }
+          cr::out().debug("shader manager: re-fetched {} shaders, {} of them changed", ids.size(), reloaded.size());
+          if (!reloaded.empty())
+            on_shaders_reloaded(reloaded);
+        });
       }
 
     private:
@@ -194,6 +306,7 @@ namespace neam::hydra
       resources::context& res_context;
       mutable shared_spinlock lock;
       std::mtc_map<id_t, vk::shader_module> module_map;
+      std::mtc_map<id_t, module_state_t> module_states;
       // std::map<id_t, assets::spirv_shader> shader_info_map;
 
       cr::event_token_t on_index_loaded;
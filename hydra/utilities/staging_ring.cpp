@@ -0,0 +1,214 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "staging_ring.hpp"
+
+#include <hydra/engine/hydra_context.hpp>
+
+namespace neam::hydra
+{
+  VkBuffer staging_ring::allocation::get_vk_buffer() const
+  {
+    check::debug::n_assert(ring != nullptr, "staging_ring::allocation::get_vk_buffer: invalid allocation");
+    return ring->ring_buffer->buffer._get_vk_buffer();
+  }
+
+  void staging_ring::allocation::free()
+  {
+    if (ring == nullptr)
+      return;
+    ring->free_allocation(id);
+    ring = nullptr;
+    memory = {};
+  }
+
+  staging_ring::staging_ring(hydra_context& _hctx)
+    : hctx(_hctx)
+  {
+    on_index_loaded_tk = hctx.res.on_index_loaded.add([this]
+    {
+      hctx.hconf.read_or_create_conf(configuration);
+    });
+  }
+
+  staging_ring::~staging_ring()
+  {
+    std::lock_guard _l(lock);
+    check::debug::n_check(records.empty(), "staging_ring: destructing the ring with {} allocations still alive", records.size());
+  }
+
+  void staging_ring::create_ring_unlocked()
+  {
+    TRACY_SCOPED_ZONE;
+    // NOTE: only called when there is no live allocation, so the previous buffer is not in use anymore
+    ring_memory = nullptr;
+    ring_buffer.reset();
+    ring_size = configuration.ring_size;
+    head = 0;
+    tail = 0;
+
+    if (ring_size == 0)
+      return;
+
+    vk::buffer buffer { hctx.device, ring_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT };
+    buffer._set_debug_name("staging_ring::ring_buffer");
+    memory_allocation alloc = hctx.allocator.allocate_memory
+    (
+      buffer.get_memory_requirements(),
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      allocation_type::persistent | allocation_type::mapped_memory
+    );
+    buffer.bind_memory(*alloc.mem(), alloc.offset());
+    ring_memory = (uint8_t*)alloc.mem()->map_memory(alloc.offset());
+    ring_buffer.emplace(std::move(alloc), std::move(buffer));
+
+    stats.ring_size = ring_size;
+    cr::out().debug("staging_ring: created a staging ring of {} MiB", ring_size / (1024 * 1024));
+  }
+
+  bool staging_ring::can_hold(size_t size) const
+  {
+    return size > 0 && size <= configuration.max_allocation_size && size <= configuration.ring_size;
+  }
+
+  staging_ring::allocation staging_ring::allocate(size_t size)
+  {
+    TRACY_SCOPED_ZONE;
+    std::lock_guard _l(lock);
+
+    if (size == 0)
+      return {};
+    if (!can_hold(size))
+    {
+      ++stats.oversized_count;
+      return {};
+    }
+
+    // (re-)create the ring if needed. Size changes can only be applied when the ring is empty.
+    if (records.empty() && (!ring_buffer || ring_size != configuration.ring_size))
+      create_ring_unlocked();
+    if (!ring_buffer || size > ring_size)
+    {
+      ++stats.oversized_count;
+      return {};
+    }
+
+    const auto align = [](size_t v) { return (v + k_alignment - 1) & ~size_t(k_alignment - 1); };
+
+    size_t offset = 0;
+    size_t consumed = 0;
+    if (records.empty())
+    {
+      head = 0;
+      tail = 0;
+      offset = 0;
+      consumed = size;
+    }
+    else if (head > tail)
+    {
+      // free space is [head, ring_size) and [0, tail)
+      const size_t aligned_head = align(head);
+      if (aligned_head + size <= ring_size)
+      {
+        offset = aligned_head;
+        consumed = aligned_head + size - head;
+      }
+      else if (size <= tail)
+      {
+        // wrap around. The end of the ring is consumed by the allocation.
+        offset = 0;
+        consumed = ring_size - head + size;
+      }
+      else
+      {
+        ++stats.stall_count;
+        return {};
+      }
+    }
+    else
+    {
+      // head <= tail (and the ring is not empty): free space is [head, tail)
+      const size_t aligned_head = align(head);
+      if (aligned_head + size <= tail)
+      {
+        offset = aligned_head;
+        consumed = aligned_head + size - head;
+      }
+      else
+      {
+        ++stats.stall_count;
+        return {};
+      }
+    }
+
+    head = offset + size;
+    const uint64_t id = first_record_id + records.size();
+    records.push_back({ .end = head, .consumed = consumed });
+
+    stats.used_bytes += consumed;
+    stats.peak_used_bytes = std::max(stats.peak_used_bytes, stats.used_bytes);
+    stats.live_allocations = (uint32_t)records.size();
+    ++stats.allocation_count;
+    stats.allocated_bytes += size;
+
+    return { *this, id, offset, { ring_memory + offset, size } };
+  }
+
+  void staging_ring::free_allocation(uint64_t id)
+  {
+    std::lock_guard _l(lock);
+    check::debug::n_assert(id >= first_record_id && id < first_record_id + records.size(), "staging_ring: freeing an allocation not in the ring (id: {})", id);
+
+    records[id - first_record_id].freed = true;
+
+    // reclaim space from the oldest allocations:
+    while (!records.empty() && records.front().freed)
+    {
+      tail = records.front().end;
+      stats.used_bytes -= records.front().consumed;
+      records.pop_front();
+      ++first_record_id;
+    }
+    if (records.empty())
+    {
+      head = 0;
+      tail = 0;
+    }
+    stats.live_allocations = (uint32_t)records.size();
+  }
+
+  staging_ring::stats_t staging_ring::get_stats() const
+  {
+    std::lock_guard _l(lock);
+    return stats;
+  }
+
+  void staging_ring::reset_peak()
+  {
+    std::lock_guard _l(lock);
+    stats.peak_used_bytes = stats.used_bytes;
+  }
+}
@@ -0,0 +1,194 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <optional>
+
+#include <ntools/mt_check/deque.hpp>
+#include <ntools/spinlock.hpp>
+#include <ntools/event.hpp>
+
+#include <hydra/engine/conf/conf.hpp>
+
+#include "../vulkan/vulkan.hpp"
+#include "holders.hpp"
+
+namespace neam::hydra
+{
+  struct staging_ring_configuration : hydra::conf::hconf<staging_ring_configuration, "configuration/staging_ring.hcnf", conf::location_t::index_program_local_dir>
+  {
+    uint64_t ring_size = 64ull * 1024 * 1024;
+    uint64_t max_allocation_size = 16ull * 1024 * 1024;
+  };
+}
+
+N_METADATA_STRUCT(neam::hydra::staging_ring_configuration)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(ring_size, neam::metadata::info{.description = c_string_t
+    <
+      "Size, in bytes, of the persistent staging ring used by transfer contexts.\n"
+      "The ring is a single host-visible buffer that is mapped once. Space is reclaimed once the transfers using it are done on the GPU.\n"
+      "A ring too small for the per-frame upload volume will stall (and transfers will fallback to dedicated staging buffers).\n"
+      "(changes are applied once the ring is empty)"
+    >}),
+    N_MEMBER_DEF(max_allocation_size, neam::metadata::info{.description = c_string_t
+    <
+      "Transfers bigger than this size (in bytes) do not use the ring and get a dedicated staging buffer.\n"
+      "This avoids a single big upload holding the whole ring for the duration of a frame."
+    >})
+  >;
+};
+
+namespace neam::hydra
+{
+  struct hydra_context;
+
+  /// \brief Persistent, persistently mapped staging memory for cpu -> gpu transfers
+  ///
+  /// Allocations are linear in a single buffer (wrapping around at the end) and can be freed in any order.
+  /// Space is reclaimed (from the oldest allocation) once the allocations are destructed,
+  /// which is normally done via the dfe once the transfer using them is done.
+  class staging_ring
+  {
+    public:
+      /// \brief Alignment of all the allocations. Is enough for buffer->image copies of block-compressed formats and formats with power-of-two texel sizes.
+      static constexpr uint32_t k_alignment = 16;
+
+      /// \brief A (movable) region of the ring. Frees itself on destruction.
+      class allocation
+      {
+        public:
+          allocation() = default;
+          allocation(allocation&& o)
+            : ring(o.ring), id(o.id), offset(o.offset), memory(o.memory)
+          {
+            o.ring = nullptr;
+          }
+          allocation& operator = (allocation&& o)
+          {
+            if (&o == this) return *this;
+            free();
+            ring = o.ring;
+            id = o.id;
+            offset = o.offset;
+            memory = o.memory;
+            o.ring = nullptr;
+            return *this;
+          }
+          ~allocation() { free(); }
+
+          bool is_valid() const { return ring != nullptr; }
+          explicit operator bool() const { return is_valid(); }
+
+          /// \brief Writable memory of the allocation
+          /// \note The memory is host-coherent. No flush is needed.
+          std::span<uint8_t> data() const { return memory; }
+          size_t size() const { return memory.size(); }
+
+          /// \brief Offset of the allocation in the ring buffer (to be used as the source offset of copy operations)
+          size_t get_offset() const { return offset; }
+          VkBuffer get_vk_buffer() const;
+
+          /// \brief Release the allocation. The memory must not be in use anymore.
+          void free();
+
+        private:
+          allocation(staging_ring& _ring, uint64_t _id, size_t _offset, std::span<uint8_t> _memory)
+            : ring(&_ring), id(_id), offset(_offset), memory(_memory)
+          {}
+
+        private:
+          staging_ring* ring = nullptr;
+          uint64_t id = 0;
+          size_t offset = 0;
+          std::span<uint8_t> memory;
+
+          friend staging_ring;
+      };
+
+      struct stats_t
+      {
+        uint64_t ring_size = 0;
+        uint64_t used_bytes = 0; // current occupancy, including the padding / wasted space at the end of the ring
+        uint64_t peak_used_bytes = 0;
+        uint32_t live_allocations = 0;
+        uint64_t allocation_count = 0; // number of successful allocations since the creation of the ring
+        uint64_t allocated_bytes = 0; // number of allocated bytes since the creation of the ring
+        uint64_t stall_count = 0; // number of allocations that failed because the ring was full
+        uint64_t oversized_count = 0; // number of allocations that were bigger than max_allocation_size
+      };
+
+    public:
+      staging_ring(hydra_context& _hctx);
+      ~staging_ring();
+
+      /// \brief Allocate \p size bytes in the ring
+      /// \note Never blocks. If the ring is full (or the allocation too big) an invalid allocation is returned
+      ///       and the caller is expected to fallback to a dedicated staging buffer.
+      [[nodiscard]] allocation allocate(size_t size);
+
+      /// \brief Return whether the ring can be used for an allocation of \p size
+      bool can_hold(size_t size) const;
+
+      stats_t get_stats() const;
+
+      /// \brief Reset the peak occupancy stat
+      void reset_peak();
+
+    private:
+      struct record_t
+      {
+        size_t end; // head after the allocation
+        size_t consumed; // bytes consumed by the allocation (including padding / skipped space)
+        bool freed = false;
+      };
+
+      void free_allocation(uint64_t id);
+      void create_ring_unlocked();
+
+    private:
+      hydra_context& hctx;
+      staging_ring_configuration configuration;
+      cr::event_token_t on_index_loaded_tk;
+
+      mutable spinlock lock;
+      std::optional<buffer_holder> ring_buffer;
+      uint8_t* ring_memory = nullptr;
+      size_t ring_size = 0;
+
+      size_t head = 0;
+      size_t tail = 0;
+      uint64_t first_record_id = 0;
+      std::mtc_deque<record_t> records;
+
+      stats_t stats;
+  };
+}
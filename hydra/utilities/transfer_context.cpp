@@ -92,6 +92,19 @@ namespace neam::hydra
     });
   }
 
+  void transfer_context::acquire_custom_layout_transition(vk::image& img, const vk::image_subresource_range& isr, VkImageLayout source_layout, VkImageLayout copy_layout, vk::semaphore* wait_semaphore)
+  {
+    std::lock_guard _lg(lock);
+    acquisitions.try_emplace(&tqueue).first->second.images.push_back
+    ({
+      .image = img.get_vk_image(),
+      .semaphore = wait_semaphore ? wait_semaphore->_get_vk_semaphore() : VK_NULL_HANDLE,
+      .layout = source_layout,
+      .layout_for_copy = copy_layout,
+      .range = isr,
+    });
+  }
+
   void transfer_context::release(vk::buffer& buf, vk::queue& dst_queue, vk::semaphore* signal_semaphore)
   {
     // no release necessary when the buffer source queue is the transfer queue
@@ -134,6 +147,19 @@ namespace neam::hydra
     });
   }
 
+  void transfer_context::release_custom_layout_transition(vk::image& img, const vk::image_subresource_range& isr, VkImageLayout copy_layout, VkImageLayout dst_layout, vk::semaphore* signal_semaphore)
+  {
+    std::lock_guard _lg(lock);
+    releases.try_emplace(&tqueue).first->second.images.push_back
+    ({
+      .image = img.get_vk_image(),
+      .semaphore = signal_semaphore ? signal_semaphore->_get_vk_semaphore() : VK_NULL_HANDLE,
+      .layout = dst_layout,
+      .layout_for_copy = copy_layout,
+      .range = isr,
+    });
+  }
+
   void transfer_context::transfer(vk::buffer& buf, raw_data&& data, size_t buf_offset)
   {
     std::lock_guard _lg(lock);
@@ -141,7 +167,7 @@ namespace neam::hydra
     auto& ref = buffer_copies.emplace_back(buffer_copy_t
     {
       .dst_buffer = buf._get_vk_buffer(),
-      .src_buffer = std::make_unique<std::optional<buffer_holder>>(),
+      .src_buffer = std::make_unique<staging_memory>(),
       .offset = buf_offset,
       .size = data.size,
     });
@@ -149,6 +175,20 @@ namespace neam::hydra
     dispatch_copy_task(std::move(data), *ref.src_buffer);
   }
 
+  void transfer_context::transfer(vk::buffer& buf, staging_memory&& data, size_t buf_offset)
+  {
+    check::debug::n_assert(data.is_valid(), "transfer_context::transfer: invalid staging memory");
+    std::lock_guard _lg(lock);
+    const size_t size = data.size();
+    buffer_copies.emplace_back(buffer_copy_t
+    {
+      .dst_buffer = buf._get_vk_buffer(),
+      .src_buffer = std::make_unique<staging_memory>(std::move(data)),
+      .offset = buf_offset,
+      .size = size,
+    });
+  }
+
   async::continuation_chain transfer_context::async_transfer(vk::buffer& buf, raw_data&& data, size_t buf_offset)
   {
     async::continuation_chain chain;
@@ -159,8 +199,8 @@ namespace neam::hydra
         return;
 
       TRACY_SCOPED_ZONE_COLOR(0x110FFF);
-      std::optional<buffer_holder> temp_holder;
-      inner_copy_task(std::move(data), [&]-> std::optional<buffer_holder>& { return temp_holder; });
+      staging_memory temp_holder;
+      inner_copy_task(std::move(data), [&]-> staging_memory& { return temp_holder; });
 
       // we got canceled after the memcopy and buffer creation. They will be destructed, but we lost time making them :(
       if (state.is_canceled())
@@ -172,7 +212,7 @@ namespace neam::hydra
         buffer_copies.emplace_back(buffer_copy_t
         {
           .dst_buffer = buf._get_vk_buffer(),
-          .src_buffer = std::make_unique<std::optional<buffer_holder>>(std::move(temp_holder)),
+          .src_buffer = std::make_unique<staging_memory>(std::move(temp_holder)),
           .offset = buf_offset,
           .size = data.size,
           .completion_state = std::move(state),
@@ -189,7 +229,7 @@ namespace neam::hydra
     auto& ref = image_copies.emplace_back(image_copy_t
     {
       .dst_image = img.get_vk_image(),
-      .src_buffer = std::make_unique<std::optional<buffer_holder>>(),
+      .src_buffer = std::make_unique<staging_memory>(),
       .offset = offset,
       .size = size,
       .isl = isl,
@@ -199,6 +239,21 @@ namespace neam::hydra
     dispatch_copy_task(std::move(data), *ref.src_buffer);
   }
 
+  void transfer_context::transfer(vk::image& img, staging_memory&& data, const glm::uvec3& size, const glm::ivec3& offset, vk::image_subresource_layers isl, VkImageLayout current_layout)
+  {
+    check::debug::n_assert(data.is_valid(), "transfer_context::transfer: invalid staging memory");
+    std::lock_guard _lg(lock);
+    image_copies.emplace_back(image_copy_t
+    {
+      .dst_image = img.get_vk_image(),
+      .src_buffer = std::make_unique<staging_memory>(std::move(data)),
+      .offset = offset,
+      .size = size,
+      .isl = isl,
+      .layout = current_layout,
+    });
+  }
+
   async::continuation_chain transfer_context::async_transfer(vk::image& img, raw_data&& data, const glm::uvec3& size, const glm::ivec3& offset, vk::image_subresource_layers isl, VkImageLayout current_layout)
   {
     async::continuation_chain chain;
@@ -209,8 +264,8 @@ namespace neam::hydra
         return;
 
       TRACY_SCOPED_ZONE_COLOR(0x110FFF);
-      std::optional<buffer_holder> temp_holder;
-      inner_copy_task(std::move(data), [&]-> std::optional<buffer_holder>& { return temp_holder; });
+      staging_memory temp_holder;
+      inner_copy_task(std::move(data), [&]-> staging_memory& { return temp_holder; });
 
       // we got canceled after the memcopy and buffer creation. They will be destructed, but we lost time making them :(
       if (state.is_canceled())
@@ -222,7 +277,7 @@ namespace neam::hydra
         image_copies.emplace_back(image_copy_t
         {
           .dst_image = img.get_vk_image(),
-          .src_buffer = std::make_unique<std::optional<buffer_holder>>(std::move(temp_holder)),
+          .src_buffer = std::make_unique<staging_memory>(std::move(temp_holder)),
           .offset = offset,
           .size = size,
           .isl = isl,
@@ -234,23 +289,52 @@ namespace neam::hydra
     return chain;
   }
 
-  void transfer_context::dispatch_copy_task(raw_data&& data, std::optional<buffer_holder>& holder)
+  async::continuation_chain transfer_context::async_transfer(vk::image& img, staging_memory&& data, const glm::uvec3& size, const glm::ivec3& offset, vk::image_subresource_layers isl, VkImageLayout current_layout)
+  {
+    check::debug::n_assert(data.is_valid(), "transfer_context::async_transfer: invalid staging memory");
+    async::continuation_chain chain;
+    std::lock_guard _lg(lock);
+    image_copies.emplace_back(image_copy_t
+    {
+      .dst_image = img.get_vk_image(),
+      .src_buffer = std::make_unique<staging_memory>(std::move(data)),
+      .offset = offset,
+      .size = size,
+      .isl = isl,
+      .layout = current_layout,
+      .completion_state = chain.create_state(),
+    });
+    return chain;
+  }
+
+  void transfer_context::dispatch_copy_task(raw_data&& data, staging_memory& holder)
   {
     // Dispatch a task for copy
     tasks.emplace_back(hctx.tm.get_task([this, &holder, data = std::move(data)] mutable
     {
       TRACY_SCOPED_ZONE_COLOR(0x115FAA);
-      inner_copy_task(std::move(data), [&holder] -> std::optional<buffer_holder>& { return holder; });
+      inner_copy_task(std::move(data), [&holder] -> staging_memory& { return holder; });
     }));
   }
 
-  template<typename GetHolderFnc>
-  void transfer_context::inner_copy_task(raw_data&& data, GetHolderFnc get_holder)
+  transfer_context::staging_memory transfer_context::allocate_staging(size_t size)
   {
     TRACY_SCOPED_ZONE_COLOR(0x117FFF);
+    staging_memory ret;
+
+    // try the staging ring first (no allocation, already mapped):
+    if (use_staging_ring)
+    {
+      ret.ring_allocation = hctx.staging.allocate(size);
+      if (ret.ring_allocation.is_valid())
+      {
+        ret.memory = ret.ring_allocation.data();
+        return ret;
+      }
+    }
 
-    // create the stating buffer and allocate the memory:
-    vk::buffer staging_buffer { hctx.device, data.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT };
+    // fallback: create the stating buffer and allocate the memory:
+    vk::buffer staging_buffer { hctx.device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT };
     staging_buffer._set_debug_name(fmt::format("transfer_context::staging_buffer|{}", debug_context));
     memory_allocation alloc = hctx.allocator.allocate_memory
     (
@@ -259,15 +343,27 @@ namespace neam::hydra
       allocation_type::short_lived | allocation_type::mapped_memory
     );
 
-    // copy&flush the memory:
     staging_buffer.bind_memory(*alloc.mem(), alloc.offset());
-    int8_t* memory = (int8_t*)alloc.mem()->map_memory(alloc.offset());
-    memcpy(memory, data.get(), data.size);
-    alloc.mem()->flush(memory, staging_buffer.size());
+    uint8_t* memory = (uint8_t*)alloc.mem()->map_memory(alloc.offset());
+    ret.memory = { memory, size };
+    ret.buffer.emplace(std::move(alloc), std::move(staging_buffer));
+    return ret;
+  }
+
+  template<typename GetHolderFnc>
+  void transfer_context::inner_copy_task(raw_data&& data, GetHolderFnc get_holder)
+  {
+    TRACY_SCOPED_ZONE_COLOR(0x117FFF);
+
+    staging_memory staging = allocate_staging(data.size);
+
+    // copy&flush the memory:
+    memcpy(staging.data().data(), data.get(), data.size);
+    if (!staging.is_in_staging_ring())
+      staging.buffer->allocation.mem()->flush(staging.data().data(), staging.buffer->buffer.size());
 
     // Update the ref:
-    std::optional<buffer_holder>& holder = get_holder();
-    holder.emplace(std::move(alloc), std::move(staging_buffer));
+    get_holder() = std::move(staging);
   }
 
   bool transfer_context::has_any_operation_still_in_progress() const
@@ -436,7 +532,7 @@ namespace neam::hydra
               iit.layout,
               iit.layout_for_copy,
               /*iit.*/access, VK_ACCESS_TRANSFER_WRITE_BIT
-            ));
+            ).set_subresource_range(iit.range));
           }
 
           vk::command_buffer cb = hctx.get_cpm(*it.first).get_pool().create_command_buffer();
@@ -504,7 +600,7 @@ namespace neam::hydra
                 iit.layout,
                 iit.layout_for_copy,
                 /*iit.*/access, VK_ACCESS_TRANSFER_WRITE_BIT
-              ));
+              ).set_subresource_range(iit.range));
             }
           }
           cbr.pipeline_barrier(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, {}, bmb, imb);
@@ -532,7 +628,7 @@ namespace neam::hydra
           {
             if (!it.completion_state || !it.completion_state.is_canceled())
             {
-              cbr.copy_buffer((**it.src_buffer).buffer._get_vk_buffer(), it.dst_buffer, {{ 0, it.offset, it.size }});
+              cbr.copy_buffer(it.src_buffer->get_vk_buffer(), it.dst_buffer, {{ it.src_buffer->get_offset(), it.offset, it.size }});
             }
 
             hctx.dfe.defer_destruction(hctx.dfe.queue_mask(tqueue), std::move(it.src_buffer));
@@ -550,7 +646,7 @@ namespace neam::hydra
           {
             if (!it.completion_state || !it.completion_state.is_canceled())
             {
-              cbr.copy_buffer_to_image((**it.src_buffer).buffer._get_vk_buffer(), it.dst_image, it.layout, { 0, it.offset, it.size, it.isl });
+              cbr.copy_buffer_to_image(it.src_buffer->get_vk_buffer(), it.dst_image, it.layout, { it.src_buffer->get_offset(), it.offset, it.size, it.isl });
             }
 
             hctx.dfe.defer_destruction(hctx.dfe.queue_mask(tqueue), std::move(it.src_buffer));
@@ -596,7 +692,7 @@ namespace neam::hydra
                 iit.layout_for_copy,
                 iit.layout,
                 VK_ACCESS_TRANSFER_WRITE_BIT, /*iit.*/access
-              ));
+              ).set_subresource_range(iit.range));
             }
 
             if (!ignore_queue)
@@ -654,7 +750,7 @@ namespace neam::hydra
               iit.layout_for_copy,
               iit.layout,
               VK_ACCESS_TRANSFER_WRITE_BIT, /*iit.*/access
-            ));
+            ).set_subresource_range(iit.range));
           }
 
           vk::command_buffer cb = hctx.get_cpm(*it.first).get_pool().create_command_buffer();
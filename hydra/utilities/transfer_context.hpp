@@ -45,6 +45,7 @@
 
 #include "memory_allocator.hpp"
 #include "holders.hpp"
+#include "staging_ring.hpp"
 
 namespace neam::hydra
 {
@@ -54,6 +55,34 @@ namespace neam::hydra
   /// \note this class is simply a helper to perform the necessary memcpy, acquisition, submission, release
   class transfer_context
   {
+    public:
+      /// \brief Host-visible memory to be used as the source of a transfer
+      /// Is either a region of the staging ring or (if the ring cannot hold the data) a dedicated staging buffer.
+      class staging_memory
+      {
+        public:
+          staging_memory() = default;
+          staging_memory(staging_memory&&) = default;
+          staging_memory& operator = (staging_memory&&) = default;
+
+          bool is_valid() const { return ring_allocation.is_valid() || buffer.has_value(); }
+          bool is_in_staging_ring() const { return ring_allocation.is_valid(); }
+
+          /// \brief Writable memory. Can be directly written to (by a decompressor, an io read, ...)
+          std::span<uint8_t> data() const { return memory; }
+          size_t size() const { return memory.size(); }
+
+          VkBuffer get_vk_buffer() const { return is_in_staging_ring() ? ring_allocation.get_vk_buffer() : buffer->buffer._get_vk_buffer(); }
+          size_t get_offset() const { return is_in_staging_ring() ? ring_allocation.get_offset() : 0; }
+
+        private:
+          staging_ring::allocation ring_allocation;
+          std::optional<buffer_holder> buffer;
+          std::span<uint8_t> memory;
+
+          friend transfer_context;
+      };
+
     public:
       transfer_context(hydra_context &_hctx, vk::queue& _tqueue) : hctx(_hctx), tqueue(_tqueue) {}
       explicit transfer_context(hydra_context &_hctx);
@@ -81,6 +110,10 @@ namespace neam::hydra
       /// \brief Acquire an image that require a layout transition, using a custom layout for the copy operation
       void acquire_custom_layout_transition(vk::image& img, VkImageLayout source_layout, VkImageLayout copy_layout, vk::semaphore* wait_semaphore = nullptr);
 
+      /// \brief Acquire part of an image that require a layout transition, using a custom layout for the copy operation
+      /// \note Only the subresources in isr are transitioned (the others can still be used while the transfers are in progress)
+      void acquire_custom_layout_transition(vk::image& img, const vk::image_subresource_range& isr, VkImageLayout source_layout, VkImageLayout copy_layout, vk::semaphore* wait_semaphore = nullptr);
+
       /// \brief Indicate that the resource should be released to a specific queue
       /// \note Release operations are done after the transfers, independently of the order of function calls
       void release(vk::buffer& buf, vk::queue& dst_queue, vk::semaphore* signal_semaphore = nullptr);
@@ -92,11 +125,26 @@ namespace neam::hydra
       /// \brief Layout change on release (after the transfers)
       void release_custom_layout_transition(vk::image& img, VkImageLayout copy_layout, VkImageLayout dst_layout, vk::semaphore* signal_semaphore = nullptr);
 
+      /// \brief Layout change on release (after the transfers) of part of an image
+      void release_custom_layout_transition(vk::image& img, const vk::image_subresource_range& isr, VkImageLayout copy_layout, VkImageLayout dst_layout, vk::semaphore* signal_semaphore = nullptr);
+
+
+      /// \brief Allocate some staging memory, preferably in the staging ring
+      /// The returned memory can be written to directly (avoiding the extra memcpy of the raw_data overloads),
+      /// then passed to one of the transfer(..., staging_memory&&, ...) function.
+      /// \note Never blocks on the ring: if it is full a dedicated staging buffer is created instead
+      [[nodiscard]] staging_memory allocate_staging(size_t size);
+
+      /// \brief (debug / benchmarks) When disabled, every staging allocation gets a dedicated staging buffer (the path used before the staging ring)
+      void _set_use_staging_ring(bool enabled) { use_staging_ring = enabled; }
 
       /// \brief Add a buffer to be filled with some data
       /// \note The cost of this function is constant (a task creation)
       void transfer(vk::buffer& buf, raw_data&& data, size_t buf_offset = 0);
 
+      /// \brief Add a buffer to be filled with the content of some staging memory (no copy or task involved)
+      void transfer(vk::buffer& buf, staging_memory&& data, size_t buf_offset = 0);
+
       /// \brief Similar to transfer, but will only add the transfer once the copy task is done, potentially spanning multiple frames.
       /// This function is aimed at cpu to gpu transfer where the cost of memcpy is big and the result isn't necessary for the current frame (large data stream-in is a good use-case for this)
       /// \warning release operation should be called in the then of the async, while remembering that the completion will be called in another thread
@@ -109,6 +157,9 @@ namespace neam::hydra
       /// \note The cost of this function is constant (a task creation)
       void transfer(vk::image& img, raw_data&& data, const glm::uvec3& size, const glm::ivec3& offset = {0, 0, 0}, vk::image_subresource_layers isl = {}, VkImageLayout current_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
+      /// \brief Add a subregion of an image to be filled with the content of some staging memory (no copy or task involved)
+      void transfer(vk::image& img, staging_memory&& data, const glm::uvec3& size, const glm::ivec3& offset = {0, 0, 0}, vk::image_subresource_layers isl = {}, VkImageLayout current_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
       /// \brief Similar to transfer, but will only add the transfer once the copy task is done, potentially spanning multiple frames.
       /// This function is aimed at cpu to gpu transfer where the cost of memcpy is big and the result isn't necessary for the current frame (large data stream-in is a good use-case for this)
       /// \warning release operation should be called in the then of the async, while remembering that the completion will be called in another thread
@@ -117,6 +168,11 @@ namespace neam::hydra
       /// \note The cost of this function is constant (a task creation)
       [[nodiscard]] async::continuation_chain async_transfer(vk::image& img, raw_data&& data, const glm::uvec3& size, const glm::ivec3& offset = {0, 0, 0}, vk::image_subresource_layers isl = {}, VkImageLayout current_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
+      /// \brief Similar to transfer, but the returned chain is completed when the gpu transfer is actually completed
+      /// (the content of the staging memory is expected to be already written, so there is no copy task)
+      /// \note Can be cancelled
+      [[nodiscard]] async::continuation_chain async_transfer(vk::image& img, staging_memory&& data, const glm::uvec3& size, const glm::ivec3& offset = {0, 0, 0}, vk::image_subresource_layers isl = {}, VkImageLayout current_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
       /// \brief Add an image to be filled with some data
       /// \note The cost of this function is constant (a task creation)
       void transfer(vk::image& img, raw_data&& data)
@@ -174,7 +230,7 @@ namespace neam::hydra
       std::string debug_context;
 
     private:
-      void dispatch_copy_task(raw_data&& data, std::optional<buffer_holder>& holder);
+      void dispatch_copy_task(raw_data&& data, staging_memory& holder);
 
       template<typename GetHolderFnc>
       void inner_copy_task(raw_data&& data, GetHolderFnc get_holder);
@@ -191,8 +247,7 @@ namespace neam::hydra
       {
         VkBuffer dst_buffer;
 
-        // vk::buffer src_buffer;
-        std::unique_ptr<std::optional<buffer_holder>> src_buffer;
+        std::unique_ptr<staging_memory> src_buffer;
         size_t offset;
         size_t size;
 
@@ -207,13 +262,14 @@ namespace neam::hydra
         VkImageLayout layout;
         VkImageLayout layout_for_copy;
         VkAccessFlags access;
+
+        VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
       };
 
       struct image_copy_t
       {
         VkImage dst_image;
-        // vk::buffer src_buffer;
-        std::unique_ptr<std::optional<buffer_holder>> src_buffer;
+        std::unique_ptr<staging_memory> src_buffer;
         glm::uvec3 offset;
         glm::uvec3 size;
         vk::image_subresource_layers isl;
@@ -232,6 +288,7 @@ namespace neam::hydra
       vk::queue& tqueue;
       vk::semaphore* wait_sema = nullptr;
       vk::fence* sig_fence = nullptr;
+      bool use_staging_ring = true;
 
       mutable spinlock lock;
       std::mtc_map<vk::queue*, acqrel_t> acquisitions;
@@ -50,7 +50,7 @@ namespace neam
         public: // advanced
           /// \brief Create from the create info vulkan structure
           buffer(device &_dev, const VkBufferCreateInfo &create_info)
-            : dev(_dev), buffer_size(create_info.size)
+            : dev(_dev), buffer_size(create_info.size), sharing_mode(create_info.sharingMode)
           {
             check::on_vulkan_error::n_assert_success(dev._vkCreateBuffer(&create_info, nullptr, &vk_buffer));
           }
@@ -76,7 +76,7 @@ namespace neam
             VK_SHARING_MODE_CONCURRENT, (uint32_t)queue_family_indices.size(), queue_family_indices.data()
           }) {}
 
-          buffer(buffer &&o) : dev(o.dev), vk_buffer(o.vk_buffer), buffer_size(o.buffer_size) { o.vk_buffer = nullptr; }
+          buffer(buffer &&o) : dev(o.dev), vk_buffer(o.vk_buffer), buffer_size(o.buffer_size), sharing_mode(o.sharing_mode) { o.vk_buffer = nullptr; }
           buffer &operator = (buffer &&o)
           {
             if (&o == this)
@@ -89,6 +89,7 @@ namespace neam
             vk_buffer = o.vk_buffer;
             o.vk_buffer = nullptr;
             buffer_size = o.buffer_size;
+            sharing_mode = o.sharing_mode;
             return *this;
           }
 
@@ -107,6 +108,10 @@ namespace neam
           /// \brief Return the buffer size (in byte)
           size_t size() const { return buffer_size; }
 
+          /// \brief Return the sharing mode of the buffer
+          /// \note Buffers created from an existing vulkan object are considered exclusive
+          VkSharingMode get_sharing_mode() const { return sharing_mode; }
+
           /// \brief Return the memory requirements of the buffer
           VkMemoryRequirements get_memory_requirements() const
           {
@@ -128,6 +133,7 @@ namespace neam
           device &dev;
           VkBuffer vk_buffer;
           size_t buffer_size;
+          VkSharingMode sharing_mode = VK_SHARING_MODE_EXCLUSIVE;
       };
     } // namespace vk
   } // namespace hydra
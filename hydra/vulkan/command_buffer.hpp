@@ -36,6 +36,7 @@
 
 #include "device.hpp"
 #include "command_pool.hpp"
+#include "command_buffer_marker_listener.hpp"
 
 namespace neam
 {
@@ -46,6 +47,7 @@ namespace neam
       class command_buffer_recorder;
       class render_pass;
       class framebuffer;
+      class rendering_info;
 
       class command_buffer : public cr::mt_checked<command_buffer>
       {
@@ -63,9 +65,9 @@ namespace neam
           {
             o.cmd_buf = nullptr;
             o.pool = nullptr;
-#if !N_DISABLE_CHECKS
             queue = o.queue;
-#endif
+            recording_marker = o.recording_marker;
+            o.recording_marker = command_buffer_marker_listener::k_invalid_marker;
           }
 
           ~command_buffer()
@@ -117,16 +119,35 @@ namespace neam
                                                   bool occlusion_query_enable = false, VkQueryControlFlags query_flags = 0, VkQueryPipelineStatisticFlags stat_flags = 0,
                                                   VkCommandBufferUsageFlagBits flags = (VkCommandBufferUsageFlagBits)0);
 
+          /// \brief Start the recording of the command buffer, which will be executed inside a dynamic-rendering scope
+          /// \note the recording job is done by the command_buffer_recorder instance
+          /// \note This is to be used only for secondary command buffers. The formats of the attachments are taken from \p info,
+          ///       which must be the same (minus the VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT flag) as the one used by the primary.
+          /// Implemented in command_buffer_recorder.hpp
+          command_buffer_recorder begin_recording(const rendering_info& info, VkCommandBufferUsageFlagBits flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
           /// \brief Reset the command buffer
           void reset(VkCommandBufferResetFlags flags = 0) { check::on_vulkan_error::n_assert_success(dev._vkResetCommandBuffer(cmd_buf, flags)); }
 
           /// \brief End the recording of the command buffer
-          void end_recording() { check::on_vulkan_error::n_assert_success(dev._vkEndCommandBuffer(cmd_buf)); }
+          void end_recording()
+          {
+            if (recording_marker != command_buffer_marker_listener::k_invalid_marker)
+            {
+              const uint32_t marker = recording_marker;
+              recording_marker = command_buffer_marker_listener::k_invalid_marker;
+              if (dev._marker_listener != nullptr)
+                dev._marker_listener->on_end_recording(*this, marker);
+            }
+            check::on_vulkan_error::n_assert_success(dev._vkEndCommandBuffer(cmd_buf));
+          }
 
         public: // advanced
           /// \brief Return the vulkan command buffer
           VkCommandBuffer _get_vk_command_buffer() const { return cmd_buf; }
           device& _get_device() { return dev; }
+          /// \brief Return the vulkan queue the command buffer pool has been created for
+          VkQueue _get_vk_queue() const { return queue; }
 
           void _set_debug_name(const std::string& name)
           {
@@ -137,11 +158,11 @@ namespace neam
           device& dev;
           command_pool* pool = nullptr;
           VkCommandBuffer cmd_buf;
-#if !N_DISABLE_CHECKS
           VkQueue queue = nullptr;
+          // value returned by the marker listener on_begin_recording call
+          uint32_t recording_marker = command_buffer_marker_listener::k_invalid_marker;
           friend class command_pool;
           friend class submit_info;
-#endif
       };
 
 
@@ -167,9 +188,7 @@ namespace neam
         check::on_vulkan_error::n_assert_success(dev._vkAllocateCommandBuffers(&cmd_cr, &cmd_buf));
 
         command_buffer ret(dev, *this, cmd_buf);
-#if !N_DISABLE_CHECKS
         ret.queue = queue;
-#endif
         return ret;
       }
 
@@ -194,9 +213,7 @@ namespace neam
         for (VkCommandBuffer it : vk_cmd_bufs)
         {
           cmd_bufs.emplace_back(dev, *this, it);
-#if !N_DISABLE_CHECKS
           cmd_bufs.back().queue = queue;
-#endif
         }
 
         return cmd_bufs;
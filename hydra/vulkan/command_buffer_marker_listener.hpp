@@ -0,0 +1,60 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace neam::hydra::vk
+{
+  class command_buffer;
+
+  /// \brief Interface notified of the command_buffer_recorder begin_marker / end_marker calls
+  /// and of the recording of primary command buffers (see device::_marker_listener)
+  class command_buffer_marker_listener
+  {
+    public:
+      static constexpr uint32_t k_invalid_marker = ~0u;
+
+      virtual ~command_buffer_marker_listener() = default;
+
+      /// \brief Called when a marker begins. The returned value will be passed to the matching on_end_marker call.
+      /// \note Can return k_invalid_marker to ignore the marker (on_end_marker will not be called)
+      virtual uint32_t on_begin_marker(command_buffer& cmd_buf, std::string_view name) = 0;
+
+      /// \brief Called when a marker ends
+      virtual void on_end_marker(command_buffer& cmd_buf, uint32_t marker) = 0;
+
+      /// \brief Called right after a primary command buffer begins recording. The returned value will be passed to the matching on_end_recording call.
+      /// \note Can return k_invalid_marker to ignore the command buffer (on_end_recording will not be called)
+      virtual uint32_t on_begin_recording(command_buffer& /*cmd_buf*/) { return k_invalid_marker; }
+
+      /// \brief Called right before a primary command buffer ends recording
+      virtual void on_end_recording(command_buffer& /*cmd_buf*/, uint32_t /*marker*/) {}
+  };
+}
+
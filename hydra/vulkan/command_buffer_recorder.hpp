@@ -45,6 +45,8 @@
 #include "image_copy_area.hpp"
 #include "image_blit_area.hpp"
 #include "event.hpp"
+#include "query_pool.hpp"
+#include "command_buffer_marker_listener.hpp"
 #include "clear_value.hpp"
 #include "buffer.hpp"
 #include "memory_barrier.hpp"
@@ -53,6 +55,7 @@
 #include "descriptor_set.hpp"
 #include "pipeline_layout.hpp"
 #include "rendering_attachment_info.hpp"
+#include "rendering_info.hpp"
 
 #ifndef N_VK_CBR_STATE_TRACKING
 #define N_VK_CBR_STATE_TRACKING true
@@ -69,6 +72,15 @@ namespace neam
       {
         public: // advanced
           command_buffer_recorder(device& _dev, command_buffer& _cmd_buff) : dev(_dev), cmd_buff(_cmd_buff) {}
+          /// \brief Recorder of a secondary command buffer that continues a dynamic-rendering scope
+          command_buffer_recorder(device& _dev, command_buffer& _cmd_buff, const rendering_info& inherited_rendering_info)
+            : dev(_dev), cmd_buff(_cmd_buff)
+          {
+#if N_VK_CBR_STATE_TRACKING
+            last_dyn_rendering_state = inherited_rendering_info;
+            has_dyn_rendering_state = true;
+#endif
+          }
           command_buffer_recorder(const command_buffer_recorder &o) : dev(o.dev), cmd_buff(o.cmd_buff) {}
 
         public:
@@ -597,6 +609,13 @@ namespace neam
                                          imb.size(), (VkImageMemoryBarrier*)imb.data());
           }
 
+          /// \brief Insert a set of execution and memory barriers (synchronization2 version)
+          /// <a href="https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdPipelineBarrier2.html">vulkan khr doc</a>
+          void pipeline_barrier(const VkDependencyInfo& dependency_info)
+          {
+            dev._vkCmdPipelineBarrier2(cmd_buff._get_vk_command_buffer(), &dependency_info);
+          }
+
           /// \brief Copy data from a buffer into an image
           /// <a href="https://www.khronos.org/registry/vulkan/specs/1.0/man/html/vkCmdCopyBufferToImage.html">vulkan khr doc</a>
           void copy_buffer_to_image(const buffer &src, const image &dst, VkImageLayout dst_layout, const std::vector<buffer_image_copy> &bic_vct)
@@ -700,6 +719,9 @@ namespace neam
 
           void begin_marker(std::string_view name, glm::vec4 color = {1, 1, 1, 1})
           {
+            if (dev._marker_listener != nullptr)
+              marker_stack.push_back(dev._marker_listener->on_begin_marker(cmd_buff, name));
+
             if (!dev._has_vkCmdBeginDebugUtilsLabel()) return;
             VkDebugUtilsLabelEXT marker
             {
@@ -713,6 +735,14 @@ namespace neam
 
           void end_marker()
           {
+            if (dev._marker_listener != nullptr && !marker_stack.empty())
+            {
+              const uint32_t marker = marker_stack.back();
+              marker_stack.pop_back();
+              if (marker != command_buffer_marker_listener::k_invalid_marker)
+                dev._marker_listener->on_end_marker(cmd_buff, marker);
+            }
+
             if (!dev._has_vkCmdEndDebugUtilsLabel()) return;
             dev._vkCmdEndDebugUtilsLabel(cmd_buff._get_vk_command_buffer());
           }
@@ -736,18 +766,49 @@ namespace neam
 //           {
 //             dev._vkCmd(cmd_buff._get_vk_command_buffer());
 //           }
+          /// \brief Reset a range of queries
+          /// <a href="https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdResetQueryPool.html">vulkan khr doc</a>
+          void reset_query_pool(const query_pool& pool, uint32_t first_query, uint32_t query_count)
+          {
+            dev._vkCmdResetQueryPool(cmd_buff._get_vk_command_buffer(), pool._get_vk_query_pool(), first_query, query_count);
+          }
+
+          /// \brief Begin a query
+          /// <a href="https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdBeginQuery.html">vulkan khr doc</a>
+          void begin_query(const query_pool& pool, uint32_t query, VkQueryControlFlags flags = 0)
+          {
+            dev._vkCmdBeginQuery(cmd_buff._get_vk_command_buffer(), pool._get_vk_query_pool(), query, flags);
+          }
+
+          /// \brief End a query
+          /// <a href="https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdEndQuery.html">vulkan khr doc</a>
+          void end_query(const query_pool& pool, uint32_t query)
+          {
+            dev._vkCmdEndQuery(cmd_buff._get_vk_command_buffer(), pool._get_vk_query_pool(), query);
+          }
+
+          /// \brief Write a timestamp
+          /// <a href="https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdWriteTimestamp.html">vulkan khr doc</a>
+          void write_timestamp(VkPipelineStageFlagBits stage, const query_pool& pool, uint32_t query)
+          {
+            dev._vkCmdWriteTimestamp(cmd_buff._get_vk_command_buffer(), stage, pool._get_vk_query_pool(), query);
+          }
+
+          /// \brief Copy the results of queries to a buffer
+          /// <a href="https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdCopyQueryPoolResults.html">vulkan khr doc</a>
+          void copy_query_pool_results(const query_pool& pool, uint32_t first_query, uint32_t query_count,
+                                       const buffer& dst, size_t offset, size_t stride, VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT)
+          {
+            dev._vkCmdCopyQueryPoolResults(cmd_buff._get_vk_command_buffer(), pool._get_vk_query_pool(), first_query, query_count,
+                                           dst._get_vk_buffer(), offset, stride, flags);
+          }
+
 #define TODO_FNC(x)
           // TODO
           TODO_FNC(vkCmdWaitEvents);        // NOTE: This could be done now
           TODO_FNC(vkCmdCopyImageToBuffer); // NOTE: This could be done now
           TODO_FNC(vkCmdClearAttachments);  // NOTE: may be done now (missing: wrapper for VkClearRect)
           TODO_FNC(vkCmdResolveImage);      // NOTE: may be done now (missing: wrapper for VkImageResolve)
-
-          TODO_FNC(vkCmdBeginQuery);
-          TODO_FNC(vkCmdEndQuery);
-          TODO_FNC(vkCmdResetQueryPool);
-          TODO_FNC(vkCmdWriteTimestamp);
-          TODO_FNC(vkCmdCopyQueryPoolResults);
 #undef TODO_FNC
 
         private:
@@ -757,6 +818,9 @@ namespace neam
           // state information
           const pipeline* last_bound_pipeline = nullptr;
 
+          // values returned by the marker listener for the currently opened markers
+          std::vector<uint32_t> marker_stack;
+
 #if N_VK_CBR_STATE_TRACKING
           const vk::render_pass* last_rp = nullptr;
           uint32_t last_rp_subpass = 0u;
@@ -781,6 +845,9 @@ namespace neam
 
         check::on_vulkan_error::n_assert_success(dev._vkBeginCommandBuffer(cmd_buf, &vk_cbbi));
 
+        if (dev._marker_listener != nullptr)
+          recording_marker = dev._marker_listener->on_begin_recording(*this);
+
         return command_buffer_recorder(dev, *this);
       }
 
@@ -871,6 +938,43 @@ namespace neam
         return command_buffer_recorder(dev, *this);
       }
 
+      inline command_buffer_recorder command_buffer::begin_recording(const rendering_info& info, VkCommandBufferUsageFlagBits flags)
+      {
+        std::vector<VkFormat> color_formats;
+        color_formats.reserve(info._get_view_count());
+        for (uint32_t i = 0; i < info._get_view_count(); ++i)
+          color_formats.push_back(info._get_view_format(i));
+
+        VkCommandBufferInheritanceRenderingInfo vk_cbiri
+        {
+          .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+          .pNext = nullptr,
+          .flags = info._get_vk_info().flags & ~VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT,
+          .viewMask = info._get_vk_info().viewMask,
+          .colorAttachmentCount = (uint32_t)color_formats.size(),
+          .pColorAttachmentFormats = color_formats.data(),
+          .depthAttachmentFormat = info._get_depth_view_format(),
+          .stencilAttachmentFormat = info._get_stencil_view_format(),
+          .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        };
+        VkCommandBufferInheritanceInfo vk_cbii
+        {
+          VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO, &vk_cbiri,
+          nullptr, 0, /* render pass */
+          nullptr,    /* framebuffer */
+          VK_FALSE, 0, 0
+        };
+        VkCommandBufferBeginInfo vk_cbbi
+        {
+          VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+          (VkCommandBufferUsageFlags)(flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT), &vk_cbii
+        };
+
+        check::on_vulkan_error::n_assert_success(dev._vkBeginCommandBuffer(cmd_buf, &vk_cbbi));
+
+        return command_buffer_recorder(dev, *this, info);
+      }
+
       using cbr_debug_marker = debug_marker<command_buffer_recorder>;
     } // namespace vk
   } // namespace hydra
@@ -61,9 +61,7 @@ namespace neam
           {
             check::debug::n_assert(o.get_allocated_buffer_count() == 0, "command_buffer_pool: moving a pool that is still tracked by command buffers");
             o.cmd_pool = nullptr;
-#if !N_DISABLE_CHECKS
             queue = o.queue;
-#endif
           }
 
           ~command_pool()
@@ -122,10 +120,8 @@ namespace neam
         private:
           device &dev;
           VkCommandPool cmd_pool;
-#if !N_DISABLE_CHECKS
           VkQueue queue = nullptr;
           friend class queue;
-#endif
           std::atomic<uint32_t> allocated_buffer_counter;
       };
     } // namespace vk
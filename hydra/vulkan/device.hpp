@@ -49,6 +49,7 @@ namespace neam
     namespace vk
     {
       class command_pool;
+      class command_buffer_marker_listener;
 
       /// \brief Wraps a vulkan logical device
       class device
@@ -69,7 +70,8 @@ namespace neam
             : vk_instance(o.vk_instance),
               vk_device(o.vk_device),
               phys_dev(std::move(o.phys_dev)),
-              id_to_familly_queue(std::move(o.id_to_familly_queue))
+              id_to_familly_queue(std::move(o.id_to_familly_queue)),
+              _marker_listener(o._marker_listener)
           {
             memcpy(&_st_offset, &o._st_offset, (uint8_t*)&_end_offset - (uint8_t*)&_st_offset);
             o.vk_device = nullptr;
@@ -141,6 +143,11 @@ namespace neam
           physical_device phys_dev;
           std::map<temp_queue_familly_id_t, std::pair<uint32_t, uint32_t>> id_to_familly_queue;
 
+        public: // advanced
+          /// \brief Listener notified of the begin_marker / end_marker calls of command buffer recorders (used by the gpu profiler)
+          command_buffer_marker_listener* _marker_listener = nullptr;
+
+        private:
           // /////////////////////////////////////////////////////////////////////
           // /// DIRECT VULKAN WRAPPER /// //
           // ////////////////////////////////
@@ -187,6 +194,9 @@ namespace neam
             HYDRA_LOAD_FNC(vkWaitForFences);
             HYDRA_LOAD_FNC(vkCreateSemaphore);
             HYDRA_LOAD_FNC(vkDestroySemaphore);
+            HYDRA_LOAD_FNC(vkGetSemaphoreCounterValue);
+            HYDRA_LOAD_FNC(vkWaitSemaphores);
+            HYDRA_LOAD_FNC(vkSignalSemaphore);
             HYDRA_LOAD_FNC(vkCreateEvent);
             HYDRA_LOAD_FNC(vkDestroyEvent);
             HYDRA_LOAD_FNC(vkGetEventStatus);
@@ -195,6 +205,7 @@ namespace neam
             HYDRA_LOAD_FNC(vkCreateQueryPool);
             HYDRA_LOAD_FNC(vkDestroyQueryPool);
             HYDRA_LOAD_FNC(vkGetQueryPoolResults);
+            HYDRA_LOAD_FNC(vkResetQueryPool);
             HYDRA_LOAD_FNC(vkCreateBuffer);
             HYDRA_LOAD_FNC(vkDestroyBuffer);
             HYDRA_LOAD_FNC(vkCreateBufferView);   // TODO (buffer views)
@@ -279,6 +290,7 @@ namespace neam
             HYDRA_LOAD_FNC(vkCmdResetEvent);
             HYDRA_LOAD_FNC(vkCmdWaitEvents);
             HYDRA_LOAD_FNC(vkCmdPipelineBarrier);
+            HYDRA_LOAD_FNC(vkCmdPipelineBarrier2);
             HYDRA_LOAD_FNC(vkCmdBeginQuery);
             HYDRA_LOAD_FNC(vkCmdEndQuery);
             HYDRA_LOAD_FNC(vkCmdResetQueryPool);
@@ -347,6 +359,9 @@ namespace neam
           HYDRA_VK_DEV_FNC_WRAPPER(vkWaitForFences);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCreateSemaphore);
           HYDRA_VK_DEV_FNC_WRAPPER(vkDestroySemaphore);
+          HYDRA_VK_DEV_FNC_WRAPPER(vkGetSemaphoreCounterValue);
+          HYDRA_VK_DEV_FNC_WRAPPER(vkWaitSemaphores);
+          HYDRA_VK_DEV_FNC_WRAPPER(vkSignalSemaphore);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCreateEvent);
           HYDRA_VK_DEV_FNC_WRAPPER(vkDestroyEvent);
           HYDRA_VK_DEV_FNC_WRAPPER(vkGetEventStatus);
@@ -355,6 +370,7 @@ namespace neam
           HYDRA_VK_DEV_FNC_WRAPPER(vkCreateQueryPool);
           HYDRA_VK_DEV_FNC_WRAPPER(vkDestroyQueryPool);
           HYDRA_VK_DEV_FNC_WRAPPER(vkGetQueryPoolResults);
+          HYDRA_VK_DEV_FNC_WRAPPER(vkResetQueryPool);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCreateBuffer);
           HYDRA_VK_DEV_FNC_WRAPPER(vkDestroyBuffer);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCreateBufferView);
@@ -445,6 +461,7 @@ namespace neam
           HYDRA_VK_DEV_FNC_WRAPPER(vkCmdResetEvent);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCmdWaitEvents);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCmdPipelineBarrier);
+          HYDRA_VK_DEV_FNC_WRAPPER(vkCmdPipelineBarrier2);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCmdBeginQuery);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCmdEndQuery);
           HYDRA_VK_DEV_FNC_WRAPPER(vkCmdResetQueryPool);
@@ -518,6 +535,9 @@ namespace neam
           HYDRA_DECLARE_VK_FNC(vkWaitForFences);
           HYDRA_DECLARE_VK_FNC(vkCreateSemaphore);
           HYDRA_DECLARE_VK_FNC(vkDestroySemaphore);
+          HYDRA_DECLARE_VK_FNC(vkGetSemaphoreCounterValue);
+          HYDRA_DECLARE_VK_FNC(vkWaitSemaphores);
+          HYDRA_DECLARE_VK_FNC(vkSignalSemaphore);
           HYDRA_DECLARE_VK_FNC(vkCreateEvent);
           HYDRA_DECLARE_VK_FNC(vkDestroyEvent);
           HYDRA_DECLARE_VK_FNC(vkGetEventStatus);
@@ -526,6 +546,7 @@ namespace neam
           HYDRA_DECLARE_VK_FNC(vkCreateQueryPool);
           HYDRA_DECLARE_VK_FNC(vkDestroyQueryPool);
           HYDRA_DECLARE_VK_FNC(vkGetQueryPoolResults);
+          HYDRA_DECLARE_VK_FNC(vkResetQueryPool);
           HYDRA_DECLARE_VK_FNC(vkCreateBuffer);
           HYDRA_DECLARE_VK_FNC(vkDestroyBuffer);
           HYDRA_DECLARE_VK_FNC(vkCreateBufferView);
@@ -610,6 +631,7 @@ namespace neam
           HYDRA_DECLARE_VK_FNC(vkCmdResetEvent);
           HYDRA_DECLARE_VK_FNC(vkCmdWaitEvents);
           HYDRA_DECLARE_VK_FNC(vkCmdPipelineBarrier);
+          HYDRA_DECLARE_VK_FNC(vkCmdPipelineBarrier2);
           HYDRA_DECLARE_VK_FNC(vkCmdBeginQuery);
           HYDRA_DECLARE_VK_FNC(vkCmdEndQuery);
           HYDRA_DECLARE_VK_FNC(vkCmdResetQueryPool);
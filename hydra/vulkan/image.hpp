@@ -80,7 +80,8 @@ namespace neam
           image(image &&o)
             : dev(o.dev), vk_image(o.vk_image), image_create_info(o.image_create_info),
               do_not_destroy(o.do_not_destroy),
-              mem_requirements(o.mem_requirements)
+              mem_requirements(o.mem_requirements),
+              sparse_mem_requirements(std::move(o.sparse_mem_requirements))
           {
             o.vk_image = nullptr;
           }
@@ -99,6 +100,7 @@ namespace neam
             image_create_info = o.image_create_info;
             do_not_destroy = o.do_not_destroy;
             mem_requirements = o.mem_requirements;
+            sparse_mem_requirements = std::move(o.sparse_mem_requirements);
 
             o.vk_image = nullptr;
 
@@ -293,12 +295,19 @@ namespace neam
             return glm::uvec3(image_create_info.extent.width, image_create_info.extent.height, image_create_info.extent.depth);
           }
 
+          /// \brief Return the sharing mode of the image (exclusive or concurrent)
+          VkSharingMode get_sharing_mode() const
+          {
+            return image_create_info.sharingMode;
+          }
+
           /// \brief Return the memory requirements of the image
           const VkMemoryRequirements& get_memory_requirements() const
           {
             return mem_requirements;
           }
 
+          /// \brief Return the sparse memory requirements of the image (empty if the image is not a sparse image)
           const std::vector<VkSparseImageMemoryRequirements>& get_sparse_memory_requirements() const
           {
             return sparse_mem_requirements;
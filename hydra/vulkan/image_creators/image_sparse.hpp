@@ -36,6 +36,7 @@ namespace neam::hydra::vk
   /// \brief image creator that indicates the image is to be a sparse image (sparsely bound and sparsely resident image)
   class image_sparse
   {
+    public:
       void update_image_create_info(VkImageCreateInfo& create_info) const
       {
         create_info.flags |= VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
@@ -128,6 +128,12 @@ namespace neam
             return properties.vendorID;
           }
 
+          /// \brief Return the device ID (vendor specific)
+          uint32_t get_device_id() const
+          {
+            return properties.deviceID;
+          }
+
           /// \brief Return the vulkan API version supported by the driver
           uint32_t get_vulkan_api_version() const
           {
@@ -256,7 +256,8 @@ namespace neam
           VkPipelineCreateFlags get_flags() const { return create_info.flags; }
 
           /// \brief Create a new pipeline
-          pipeline create_pipeline(pipeline_cache *cache = nullptr)
+          /// \param feedback If not null, will be filled with the creation feedback (cache hit, duration, ...)
+          pipeline create_pipeline(pipeline_cache *cache = nullptr, VkPipelineCreationFeedback* feedback = nullptr)
           {
             // refresh structs
             pvs.refresh();
@@ -318,11 +319,23 @@ namespace neam
               create_info.basePipelineHandle = nullptr;
             create_info.basePipelineIndex = (int32_t)-1;
 
+            VkPipelineCreationFeedbackCreateInfo feedback_info
+            {
+              .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+              .pNext = create_info.pNext,
+              .pPipelineCreationFeedback = feedback,
+              .pipelineStageCreationFeedbackCount = 0,
+              .pPipelineStageCreationFeedbacks = nullptr,
+            };
+            if (feedback != nullptr)
+              create_info.pNext = &feedback_info;
+
             VkPipeline p;
             VkPipelineCache pcache = nullptr;
             if (cache)
               pcache = cache->get_vk_pipeline_cache();
             check::on_vulkan_error::n_assert_success(dev._vkCreateGraphicsPipelines(pcache, 1, &create_info, nullptr, &p));
+            create_info.pNext = feedback_info.pNext;
 
             return pipeline(dev, p, VK_PIPELINE_BIND_POINT_GRAPHICS);
           }
@@ -420,7 +433,8 @@ namespace neam
           VkPipelineCreateFlags get_flags() const { return create_info.flags; }
 
           /// \brief Create a new pipeline
-          pipeline create_pipeline(pipeline_cache *cache = nullptr)
+          /// \param feedback If not null, will be filled with the creation feedback (cache hit, duration, ...)
+          pipeline create_pipeline(pipeline_cache *cache = nullptr, VkPipelineCreationFeedback* feedback = nullptr)
           {
             // refresh structs
             pss.refresh();
@@ -448,11 +462,22 @@ namespace neam
               create_info.basePipelineHandle = nullptr;
             create_info.basePipelineIndex = (int32_t)-1;
 
+            VkPipelineCreationFeedbackCreateInfo feedback_info
+            {
+              .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+              .pNext = nullptr,
+              .pPipelineCreationFeedback = feedback,
+              .pipelineStageCreationFeedbackCount = 0,
+              .pPipelineStageCreationFeedbacks = nullptr,
+            };
+            create_info.pNext = (feedback != nullptr ? &feedback_info : nullptr);
+
             VkPipeline p;
             VkPipelineCache pcache = nullptr;
             if (cache)
               pcache = cache->get_vk_pipeline_cache();
             check::on_vulkan_error::n_assert_success(dev._vkCreateComputePipelines(pcache, 1, &create_info, nullptr, &p));
+            create_info.pNext = nullptr;
 
             return pipeline(dev, p, VK_PIPELINE_BIND_POINT_COMPUTE);
           }
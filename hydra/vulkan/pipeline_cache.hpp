@@ -87,7 +87,7 @@ namespace neam
 
           ~pipeline_cache()
           {
-            if (!vk_pcache)
+            if (vk_pcache)
               dev._vkDestroyPipelineCache(vk_pcache, nullptr);
           }
 
@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <deque>
+#include <set>
 #include <variant>
 
 #include <vulkan/vulkan.h>
@@ -198,6 +199,18 @@ namespace neam::hydra::vk
         return in_process.load(std::memory_order_acquire) != 0;
       }
 
+      /// \brief Return whether any of the shader modules of the stage is in \p modules
+      bool uses_any_shader_module(const std::set<const shader_module*>& modules) const
+      {
+        std::lock_guard _lg { lock };
+        for (const auto* mod : shader_modules)
+        {
+          if (modules.contains(mod))
+            return true;
+        }
+        return false;
+      }
+
     public: // shader modules reflection ops:
       std::vector<VkPushConstantRange> compute_combined_push_constant_range() const
       {
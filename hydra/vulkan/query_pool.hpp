@@ -0,0 +1,157 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <span>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+#include "../hydra_debug.hpp"
+#include "device.hpp"
+
+namespace neam
+{
+  namespace hydra
+  {
+    namespace vk
+    {
+      /// \brief Wraps a vulkan query pool (timestamps, occlusion, pipeline statistics)
+      /// \note reset() is done from the host and requires the hostQueryReset feature (vulkan 1.2)
+      class query_pool
+      {
+        public: // advanced
+          query_pool(device& _dev, VkQueryPool _vk_query_pool, VkQueryType _type, uint32_t _count)
+            : dev(_dev), vk_query_pool(_vk_query_pool), type(_type), count(_count)
+          {}
+
+        public:
+          /// \brief Create a query pool of \p _count queries
+          /// \param pipeline_statistics only used for VK_QUERY_TYPE_PIPELINE_STATISTICS pools
+          query_pool(device& _dev, VkQueryType _type, uint32_t _count, VkQueryPipelineStatisticFlags pipeline_statistics = 0)
+            : dev(_dev), type(_type), count(_count)
+          {
+            VkQueryPoolCreateInfo create_info
+            {
+              VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+              nullptr,
+              0,
+              type,
+              count,
+              type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? pipeline_statistics : 0,
+            };
+
+            check::on_vulkan_error::n_assert_success(dev._vkCreateQueryPool(&create_info, nullptr, &vk_query_pool));
+          }
+
+          /// \brief Move constructor
+          query_pool(query_pool&& o)
+            : dev(o.dev), vk_query_pool(o.vk_query_pool), type(o.type), count(o.count)
+          {
+            o.vk_query_pool = nullptr;
+            o.count = 0;
+          }
+
+          /// \brief Move operator
+          query_pool& operator = (query_pool&& o)
+          {
+            if (&o == this)
+              return *this;
+
+            check::on_vulkan_error::n_assert(&o.dev == &dev, "can't assign query pools from different vulkan devices");
+
+            if (vk_query_pool)
+              dev._vkDestroyQueryPool(vk_query_pool, nullptr);
+
+            vk_query_pool = o.vk_query_pool;
+            type = o.type;
+            count = o.count;
+            o.vk_query_pool = nullptr;
+            o.count = 0;
+            return *this;
+          }
+
+          ~query_pool()
+          {
+            if (vk_query_pool)
+              dev._vkDestroyQueryPool(vk_query_pool, nullptr);
+          }
+
+          /// \brief Return the number of queries in the pool
+          uint32_t size() const { return count; }
+
+          VkQueryType get_query_type() const { return type; }
+
+          /// \brief Reset all the queries of the pool (from the host)
+          void reset() { reset(0, count); }
+
+          /// \brief Reset a range of queries (from the host)
+          void reset(uint32_t first_query, uint32_t query_count)
+          {
+            check::debug::n_assert(first_query + query_count <= count, "query_pool::reset: out of bound reset ({} + {} > {})", first_query, query_count, count);
+            dev._vkResetQueryPool(vk_query_pool, first_query, query_count);
+          }
+
+          /// \brief Retrieve the results (as 64bit integers) without waiting
+          /// \note With VK_QUERY_RESULT_WITH_AVAILABILITY_BIT, each query writes two values (result, availability)
+          ///       and the available results are valid even if the function returns false.
+          /// \return true if all the results were available
+          bool get_results(uint32_t first_query, uint32_t query_count, std::span<uint64_t> results, VkQueryResultFlags flags = 0) const
+          {
+            const uint32_t values_per_query = (flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) != 0 ? 2 : 1;
+            check::debug::n_assert(first_query + query_count <= count, "query_pool::get_results: out of bound query ({} + {} > {})", first_query, query_count, count);
+            check::debug::n_assert(results.size() >= (size_t)query_count * values_per_query, "query_pool::get_results: result span is too small ({} entries for {} queries)", results.size(), query_count);
+
+            const VkResult res = dev._vkGetQueryPoolResults(vk_query_pool, first_query, query_count,
+                                                             results.size_bytes(), results.data(), sizeof(uint64_t) * values_per_query,
+                                                             flags | VK_QUERY_RESULT_64_BIT);
+            if (res == VK_NOT_READY)
+              return false;
+            check::on_vulkan_error::n_assert_success(res);
+            return true;
+          }
+
+        public: // advanced
+          /// \brief Return the underlying vulkan object
+          VkQueryPool _get_vk_query_pool() const { return vk_query_pool; }
+
+          void _set_debug_name(const std::string& name)
+          {
+            dev._set_object_debug_name((uint64_t)vk_query_pool, VK_OBJECT_TYPE_QUERY_POOL, name);
+          }
+
+        private:
+          device& dev;
+          VkQueryPool vk_query_pool = nullptr;
+          VkQueryType type;
+          uint32_t count;
+      };
+    } // namespace vk
+  } // namespace hydra
+} // namespace neam
+
@@ -30,6 +30,7 @@
 #pragma once
 
 
+#include <atomic>
 #include <cstddef>
 #include <list>
 
@@ -37,6 +38,7 @@
 #include "command_pool.hpp"
 #include "fence.hpp"
 #include "semaphore.hpp"
+#include "timeline_semaphore.hpp"
 #include "swapchain.hpp"
 
 #include <utilities/deferred_queue_execution.hpp>
@@ -51,12 +53,13 @@ namespace neam
     namespace vk
     {
       /// \brief Describe a queue inside a queue familly
-      /// \note because of vulkan, that class can be copied
+      /// Each queue owns a timeline semaphore that is signaled by every submission made via submit_info,
+      /// with a monotonically increasing value. (see get_last_submitted_timeline_value / is_timeline_value_completed)
       class queue
       {
         public: // advanced
           queue(device &_dev, uint32_t _queue_familly_index, uint32_t _queue_index)
-            : dev(_dev), queue_familly_index(_queue_familly_index), queue_index(_queue_index)
+            : dev(_dev), queue_familly_index(_queue_familly_index), queue_index(_queue_index), timeline(_dev, 0, "queue timeline")
           {
             dev._vkGetDeviceQueue(queue_familly_index, queue_index, &vk_queue);
           }
@@ -64,7 +67,7 @@ namespace neam
         public:
           /// \brief Create the queue from a temporary queue_id
           queue(device &_dev, temp_queue_familly_id_t _queue_id)
-            : dev(_dev)
+            : dev(_dev), timeline(_dev, 0, "queue timeline")
           {
             std::pair<uint32_t, uint32_t> nfo = dev._get_queue_info(_queue_id);
             queue_familly_index = nfo.first;
@@ -99,9 +102,7 @@ namespace neam
             check::on_vulkan_error::n_assert_success(dev._vkCreateCommandPool(&cmd_pool_info, nullptr, &cmd_pool));
 
             command_pool ret(dev, cmd_pool);
-#if !N_DISABLE_CHECKS
             ret.queue = vk_queue;
-#endif
             return ret;
           }
 
@@ -119,6 +120,49 @@ namespace neam
             });
           }
 
+          /// \brief Return the timeline semaphore of the queue
+          /// \note Only submit_info should signal it. Waiting on it is fine.
+          [[nodiscard]] const timeline_semaphore& get_timeline() const
+          {
+            return timeline;
+          }
+
+          /// \brief Return the timeline value of the last submission to the queue
+          /// Once that value is reached, all the work previously submitted to the queue is completed.
+          /// \note The value is reserved when the submission is pushed to the deferred queue execution,
+          ///       so the actual vkQueueSubmit call may not have been done yet.
+          [[nodiscard]] uint64_t get_last_submitted_timeline_value() const
+          {
+            return last_submitted_timeline_value.load(std::memory_order_acquire);
+          }
+
+          /// \brief Return the last timeline value that is known to be completed by the device
+          [[nodiscard]] uint64_t get_completed_timeline_value() const
+          {
+            const uint64_t value = timeline.get_counter_value();
+            uint64_t known = last_completed_timeline_value.load(std::memory_order_relaxed);
+            while (known < value && !last_completed_timeline_value.compare_exchange_weak(known, value, std::memory_order_relaxed));
+            return value;
+          }
+
+          /// \brief Return whether the device has completed the timeline value \p value
+          /// \note Does not query the device if the value is already known to be completed
+          [[nodiscard]] bool is_timeline_value_completed(uint64_t value) const
+          {
+            if (value <= last_completed_timeline_value.load(std::memory_order_relaxed))
+              return true;
+            return get_completed_timeline_value() >= value;
+          }
+
+          /// \brief Wait for the device to reach the timeline value \p value
+          void wait_for_timeline_value(uint64_t value) const
+          {
+            if (is_timeline_value_completed(value))
+              return;
+            TRACY_SCOPED_ZONE;
+            timeline.wait(value);
+          }
+
           /// \brief Wait the queue to be idle
           void wait_idle() const
           {
@@ -170,6 +214,15 @@ namespace neam
           void _set_debug_name(const std::string& name)
           {
             dev._set_object_debug_name((uint64_t)vk_queue, VK_OBJECT_TYPE_QUEUE, name);
+            timeline._set_debug_name(fmt::format("{} timeline", name));
+          }
+
+          /// \brief Reserve the next timeline value
+          /// \warning Must be called with the dqe lock held, and the submission that signals it must be deferred
+          ///          via the dqe before the lock is released (values must be signaled in increasing order)
+          [[nodiscard]] uint64_t _reserve_timeline_value()
+          {
+            return last_submitted_timeline_value.fetch_add(1, std::memory_order_acq_rel) + 1;
           }
 
           id_t queue_id = id_t::invalid;
@@ -178,6 +231,10 @@ namespace neam
           uint32_t queue_familly_index;
           uint32_t queue_index;
           VkQueue vk_queue;
+
+          timeline_semaphore timeline;
+          std::atomic<uint64_t> last_submitted_timeline_value = 0;
+          mutable std::atomic<uint64_t> last_completed_timeline_value = 0;
         public:
           spinlock queue_lock;
           friend class submit_info;
@@ -53,6 +53,7 @@ namespace neam
           class parameter
           {
             public:
+              parameter() = default;
               parameter(parameter&& o)
               {
                 size = o.size;
@@ -130,6 +131,23 @@ namespace neam
 
               id_t hash() const { return string_id::_runtime_build_from_string((const char*)get_data(), get_size()); }
 
+              /// \brief Return a copy of the parameter
+              parameter duplicate() const
+              {
+                parameter ret;
+                ret.size = size;
+                if (size <= k_embedded_size)
+                {
+                  ret.value = value;
+                }
+                else
+                {
+                  new (&ret.ext_value) raw_data { raw_data::allocate(size) };
+                  memcpy(ret.ext_value.data.get(), ext_value.data.get(), size);
+                }
+                return ret;
+              }
+
             private:
               // size above which a dyn allocation is necessary
               static constexpr uint32_t k_embedded_size = sizeof(uint64_t) * 3;
@@ -177,6 +195,15 @@ namespace neam
 
           size_t entry_count() const { return parameters.size(); }
 
+          /// \brief Return a copy of the specialization
+          specialization duplicate() const
+          {
+            specialization ret;
+            for (const auto& it : parameters)
+              ret.parameters.emplace(it.first, it.second.duplicate());
+            return ret;
+          }
+
           id_t hash() const
           {
             id_t h = id_t::none;
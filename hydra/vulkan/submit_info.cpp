@@ -44,6 +44,21 @@ namespace neam::hydra::vk
     si.pWaitSemaphores = vk_wait_semas.data();
     si.signalSemaphoreCount = vk_sig_semas.size();
     si.pSignalSemaphores = vk_sig_semas.data();
+
+    if (has_timeline)
+    {
+      timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+      timeline_info.pNext = nullptr;
+      timeline_info.waitSemaphoreValueCount = wait_values.size();
+      timeline_info.pWaitSemaphoreValues = wait_values.data();
+      timeline_info.signalSemaphoreValueCount = sig_values.size();
+      timeline_info.pSignalSemaphoreValues = sig_values.data();
+      si.pNext = &timeline_info;
+    }
+    else
+    {
+      si.pNext = nullptr;
+    }
   }
 
   void submit_info::vk_sbi_vectors::update(VkBindSparseInfo& sbi)
@@ -97,6 +112,21 @@ namespace neam::hydra::vk
     sbi.pWaitSemaphores = vk_wait_semas.data();
     sbi.signalSemaphoreCount = vk_sig_semas.size();
     sbi.pSignalSemaphores = vk_sig_semas.data();
+
+    if (has_timeline)
+    {
+      timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+      timeline_info.pNext = nullptr;
+      timeline_info.waitSemaphoreValueCount = wait_values.size();
+      timeline_info.pWaitSemaphoreValues = wait_values.data();
+      timeline_info.signalSemaphoreValueCount = sig_values.size();
+      timeline_info.pSignalSemaphoreValues = sig_values.data();
+      sbi.pNext = &timeline_info;
+    }
+    else
+    {
+      sbi.pNext = nullptr;
+    }
   }
 
   void submit_info::vk_si_wrapper::update(uint32_t index)
@@ -171,6 +201,24 @@ namespace neam::hydra::vk
     }
   }
 
+  bool submit_info::vk_si_wrapper::has_any_operation() const
+  {
+    if (fence != VK_NULL_HANDLE)
+      return true;
+    for (const auto& it : si_vectors)
+    {
+      if (!it.vk_cmd_bufs.empty() || !it.vk_wait_semas.empty() || !it.vk_sig_semas.empty())
+        return true;
+    }
+    for (const auto& it : sbi_vectors)
+    {
+      if (!it.buffer_sparse_binds.empty() || !it.image_sparse_opaque_binds.empty() || !it.image_sparse_binds.empty()
+          || !it.vk_wait_semas.empty() || !it.vk_sig_semas.empty())
+        return true;
+    }
+    return false;
+  }
+
   void submit_info::vk_si_wrapper::submit(vk_context& vkctx, vk::queue* queue)
   {
     if (vk_submit_infos.empty() && vk_sparse_bind_infos.empty())
@@ -178,6 +226,25 @@ namespace neam::hydra::vk
 
     check::debug::n_assert(queue != nullptr, "submit-info has commands to submit but no queue");
 
+    // signal the queue timeline after the last entry
+    // (a signal operation waits for everything previously submitted on the queue)
+    if (timeline_signal_value != 0)
+    {
+      auto add_queue_timeline_signal = [&](auto& vectors)
+      {
+        vectors.wait_values.resize(vectors.vk_wait_semas.size(), 0);
+        vectors.sig_values.resize(vectors.vk_sig_semas.size(), 0);
+        vectors.vk_sig_semas.push_back(queue->get_timeline()._get_vk_semaphore());
+        vectors.sig_values.push_back(timeline_signal_value);
+        vectors.has_timeline = true;
+      };
+      if (!sparse_bind)
+        add_queue_timeline_signal(si_vectors.back());
+      else
+        add_queue_timeline_signal(sbi_vectors.back());
+      timeline_signal_value = 0;
+    }
+
     // FIXME:
     full_update();
 
@@ -245,6 +312,7 @@ namespace neam::hydra::vk
     current = nullptr;
     current_queue = VK_NULL_HANDLE;
     queues.clear();
+    timeline_values.clear();
   }
 
   submit_info& submit_info::on(vk::queue& q)
@@ -274,8 +342,11 @@ namespace neam::hydra::vk
 #if N_ALLOW_DEBUG
     cr::out().debug(" - si {}: [{}: waiting semaphore]", (void*)this, vkctx.get_queue_name(*current_queue));
 #endif
-    current->queue_submits.back().si_vectors.back().vk_wait_semas.push_back(sem._get_vk_semaphore());
-    current->queue_submits.back().si_vectors.back().wait_dst_stage_mask.push_back(wait_flags);
+    auto& vectors = current->queue_submits.back().si_vectors.back();
+    vectors.vk_wait_semas.push_back(sem._get_vk_semaphore());
+    vectors.wait_dst_stage_mask.push_back(wait_flags);
+    if (vectors.has_timeline)
+      vectors.wait_values.push_back(0);
     return *this;
   }
 
@@ -287,7 +358,47 @@ namespace neam::hydra::vk
 #if N_ALLOW_DEBUG
     cr::out().debug(" - si {}: [{}: waiting semaphore]", (void*)this, vkctx.get_queue_name(*current_queue));
 #endif
-    current->queue_submits.back().sbi_vectors.back().vk_wait_semas.push_back(sem._get_vk_semaphore());
+    auto& vectors = current->queue_submits.back().sbi_vectors.back();
+    vectors.vk_wait_semas.push_back(sem._get_vk_semaphore());
+    if (vectors.has_timeline)
+      vectors.wait_values.push_back(0);
+    return *this;
+  }
+
+  submit_info& submit_info::wait(const timeline_semaphore& sem, uint64_t value, VkPipelineStageFlags wait_flags)
+  {
+    step(operation_t::wait);
+    check::debug::n_assert(!current->queue_submits.back().sparse_bind, "full-wait called on a sparse-bind queue submit");
+
+#if N_ALLOW_DEBUG
+    cr::out().debug(" - si {}: [{}: waiting timeline semaphore (value: {})]", (void*)this, vkctx.get_queue_name(*current_queue), value);
+#endif
+    auto& vectors = current->queue_submits.back().si_vectors.back();
+    vectors.wait_values.resize(vectors.vk_wait_semas.size(), 0);
+    vectors.sig_values.resize(vectors.vk_sig_semas.size(), 0);
+    vectors.has_timeline = true;
+
+    vectors.vk_wait_semas.push_back(sem._get_vk_semaphore());
+    vectors.wait_dst_stage_mask.push_back(wait_flags);
+    vectors.wait_values.push_back(value);
+    return *this;
+  }
+
+  submit_info& submit_info::wait(const timeline_semaphore& sem, uint64_t value)
+  {
+    step(operation_t::wait);
+    check::debug::n_assert(current->queue_submits.back().sparse_bind, "sparse-bind-wait called on a non-sparse-bind queue submit");
+
+#if N_ALLOW_DEBUG
+    cr::out().debug(" - si {}: [{}: waiting timeline semaphore (value: {})]", (void*)this, vkctx.get_queue_name(*current_queue), value);
+#endif
+    auto& vectors = current->queue_submits.back().sbi_vectors.back();
+    vectors.wait_values.resize(vectors.vk_wait_semas.size(), 0);
+    vectors.sig_values.resize(vectors.vk_sig_semas.size(), 0);
+    vectors.has_timeline = true;
+
+    vectors.vk_wait_semas.push_back(sem._get_vk_semaphore());
+    vectors.wait_values.push_back(value);
     return *this;
   }
 
@@ -350,7 +461,7 @@ namespace neam::hydra::vk
       .size = alloc.size(),
       .memory = alloc.mem()->_get_vk_device_memory(),
       .memoryOffset = alloc.offset(),
-      .flags = VK_SPARSE_MEMORY_BIND_METADATA_BIT,
+      .flags = 0,
     });
 
     return *this;
@@ -403,6 +514,30 @@ namespace neam::hydra::vk
     return *this;
   }
 
+  submit_info& submit_info::unbind(const image& img, glm::uvec3 offset, glm::uvec3 extent, const image_subresource& subres)
+  {
+    step(operation_t::cmd_buff_or_bind);
+
+#if N_ALLOW_DEBUG
+    cr::out().debug(" - si {}: [{}: unbind memory from image]", (void*)this, vkctx.get_queue_name(*current_queue));
+#endif
+
+    check::debug::n_assert(current->queue_submits.back().sparse_bind, "unbind called on a non-sparse-bind queue submit");
+
+    auto[it, ins] = current->queue_submits.back().sbi_vectors.back().image_sparse_binds.try_emplace(img.get_vk_image());
+    it->second.push_back
+    ({
+      .subresource = subres,
+      .offset = { (int32_t)offset.x, (int32_t)offset.y, (int32_t)offset.z },
+      .extent = { extent.x, extent.y, extent.z },
+      .memory = VK_NULL_HANDLE,
+      .memoryOffset = 0,
+      .flags = 0,
+    });
+
+    return *this;
+  }
+
   submit_info& submit_info::signal(const semaphore &sem)
   {
     step(operation_t::signal_sema);
@@ -411,10 +546,40 @@ namespace neam::hydra::vk
     cr::out().debug(" - si {}: [{}: signaling semaphore]", (void*)this, vkctx.get_queue_name(*current_queue));
 #endif
 
+    auto push_signal = [&sem](auto& vectors)
+    {
+      vectors.vk_sig_semas.push_back(sem._get_vk_semaphore());
+      if (vectors.has_timeline)
+        vectors.sig_values.push_back(0);
+    };
+    if (!current->queue_submits.back().sparse_bind)
+      push_signal(current->queue_submits.back().si_vectors.back());
+    else
+      push_signal(current->queue_submits.back().sbi_vectors.back());
+    return *this;
+  }
+
+  submit_info& submit_info::signal(const timeline_semaphore& sem, uint64_t value)
+  {
+    step(operation_t::signal_sema);
+
+#if N_ALLOW_DEBUG
+    cr::out().debug(" - si {}: [{}: signaling timeline semaphore (value: {})]", (void*)this, vkctx.get_queue_name(*current_queue), value);
+#endif
+
+    auto push_signal = [&sem, value](auto& vectors)
+    {
+      vectors.wait_values.resize(vectors.vk_wait_semas.size(), 0);
+      vectors.sig_values.resize(vectors.vk_sig_semas.size(), 0);
+      vectors.has_timeline = true;
+
+      vectors.vk_sig_semas.push_back(sem._get_vk_semaphore());
+      vectors.sig_values.push_back(value);
+    };
     if (!current->queue_submits.back().sparse_bind)
-      current->queue_submits.back().si_vectors.back().vk_sig_semas.push_back(sem._get_vk_semaphore());
+      push_signal(current->queue_submits.back().si_vectors.back());
     else
-      current->queue_submits.back().sbi_vectors.back().vk_sig_semas.push_back(sem._get_vk_semaphore());
+      push_signal(current->queue_submits.back().sbi_vectors.back());
     return *this;
   }
 
@@ -494,6 +659,13 @@ namespace neam::hydra::vk
         {
           for (auto& qs_it : si_it.queue_submits)
           {
+            if (!qs_it.has_any_operation())
+              continue;
+
+            // reserve the timeline value now (under the dqe lock) so that values are signaled in order on the queue
+            qs_it.timeline_signal_value = it.first->_reserve_timeline_value();
+            timeline_values.insert_or_assign(it.first, qs_it.timeline_signal_value);
+
             qs_it.update();
             vkctx.dqe.defer_execution_unlocked(it.first->queue_id, [&vkctx = vkctx, queue = it.first, qs_it = std::move(qs_it)] mutable
             {
@@ -38,6 +38,7 @@
 #include "engine/core_context.hpp"
 #include "command_buffer.hpp"
 #include "semaphore.hpp"
+#include "timeline_semaphore.hpp"
 #include "fence.hpp"
 #include "queue.hpp"
 #include "buffer.hpp"
@@ -62,6 +63,9 @@ namespace neam
       /// \note every fences, semaphores and command buffers must be "alive"
       ///       until the object is destructed or a clear() call is done
       ///
+      /// \note Every submission signals the timeline semaphore of its queue with a new value.
+      ///       (see get_timeline_value() and vk::queue::is_timeline_value_completed())
+      ///
       /// \note You have to sumbit datas in that order:
       ///       wait (semaphores) -> execute (command_buffers) | bind (memory) -> signal(semaphores) -> signal (fences)
       ///       You can skip any parts of that chain, or submit multiples elements of the same type.
@@ -95,6 +99,12 @@ namespace neam
             std::mtc_vector<VkSemaphore> vk_wait_semas;
             std::mtc_vector<VkSemaphore> vk_sig_semas;
 
+            // timeline values (0 for binary semaphores). Only chained when has_timeline is true.
+            std::mtc_vector<uint64_t> wait_values;
+            std::mtc_vector<uint64_t> sig_values;
+            VkTimelineSemaphoreSubmitInfo timeline_info;
+            bool has_timeline = false;
+
             void update(VkSubmitInfo& si);
           };
 
@@ -107,6 +117,12 @@ namespace neam
             std::mtc_vector<VkSemaphore> vk_wait_semas;
             std::mtc_vector<VkSemaphore> vk_sig_semas;
 
+            // timeline values (0 for binary semaphores). Only chained when has_timeline is true.
+            std::mtc_vector<uint64_t> wait_values;
+            std::mtc_vector<uint64_t> sig_values;
+            VkTimelineSemaphoreSubmitInfo timeline_info;
+            bool has_timeline = false;
+
             std::mtc_map<VkBuffer, std::mtc_vector<VkSparseMemoryBind>> buffer_sparse_binds;
             std::mtc_map<VkImage, std::mtc_vector<VkSparseMemoryBind>> image_sparse_opaque_binds;
             std::mtc_map<VkImage, std::mtc_vector<VkSparseImageMemoryBind>> image_sparse_binds;
@@ -128,6 +144,9 @@ namespace neam
 
             VkFence fence = VK_NULL_HANDLE;
 
+            // value of the queue timeline to signal after the last entry (0 means no signal)
+            uint64_t timeline_signal_value = 0;
+
             const bool sparse_bind = false;
 
             vk_si_wrapper(bool is_sparse_bind = false) : sparse_bind(is_sparse_bind)
@@ -141,6 +160,9 @@ namespace neam
 
             void add();
 
+            /// \brief Return whether the wrapper has anything to submit (commands, binds, semaphores or fence)
+            bool has_any_operation() const;
+
             void submit(vk_context& vkctx, vk::queue* queue);
           };
 
@@ -153,6 +175,7 @@ namespace neam
             current = o.current;
             current_queue = o.current_queue;
             queues = std::move(o.queues);
+            timeline_values = std::move(o.timeline_values);
             o.current = nullptr;
             o.current_queue = nullptr;
             return *this;
@@ -183,6 +206,20 @@ namespace neam
           /// \warning Only valid on sparse-binding queues. Will assert otherwise.
           submit_info& wait(const semaphore& sem);
 
+          /// \brief Add a timeline semaphore value to wait on
+          submit_info& wait(const timeline_semaphore& sem, uint64_t value, VkPipelineStageFlags wait_flags);
+
+          /// \brief Add a timeline semaphore value to wait on
+          /// \warning Only valid on sparse-binding queues. Will assert otherwise.
+          submit_info& wait(const timeline_semaphore& sem, uint64_t value);
+
+          /// \brief Wait for the queue \p q to reach the timeline value \p value
+          /// (typically obtained from get_timeline_value() or vk::queue::get_last_submitted_timeline_value())
+          submit_info& wait(const vk::queue& q, uint64_t value, VkPipelineStageFlags wait_flags)
+          {
+            return wait(q.get_timeline(), value, wait_flags);
+          }
+
           /// \brief Add a command buffer
           submit_info& execute(const command_buffer &cmdbuf);
 
@@ -198,10 +235,19 @@ namespace neam
           /// \brief Bind a memory area to an image (in the opaque segment)
           submit_info& bind(const image& img, memory_allocation& alloc, glm::uvec3 offset, glm::uvec3 extent, const image_subresource& subres);
 
+          /// \brief Unbind the memory of an image area (the area will then be non-resident)
+          /// \note The memory previously bound must be kept alive until the operation is done
+          submit_info& unbind(const image& img, glm::uvec3 offset, glm::uvec3 extent, const image_subresource& subres);
+
           /// \brief Add a semaphore to signal
           submit_info& signal(const semaphore &sem);
 
+          /// \brief Add a timeline semaphore value to signal
+          /// \note Do not use this to signal a queue timeline, it is already handled
+          submit_info& signal(const timeline_semaphore& sem, uint64_t value);
+
           /// \brief Add a fence to signal
+          /// \note Prefer tracking progress with get_timeline_value(), as no fence is needed
           submit_info& signal(const fence &fnc);
 
           /// \brief Append a \e copy of \p info in the current submit_info
@@ -229,6 +275,16 @@ namespace neam
 
           vk::queue* get_current_queue() const { return current_queue; }
 
+          /// \brief Return the timeline value that the last deferred_submit() call will signal on \p q
+          /// Once the queue timeline reaches that value, everything submitted on \p q via this submit-info is completed.
+          /// \note Returns 0 if nothing was submit on that queue (0 is always completed)
+          uint64_t get_timeline_value(const vk::queue& q) const
+          {
+            if (auto it = timeline_values.find(&q); it != timeline_values.end())
+              return it->second;
+            return 0;
+          }
+
         private:
           void step(operation_t current_op);
           void sparse_bind_ops(bool do_sparse_bind);
@@ -248,6 +304,8 @@ namespace neam
           vk::queue* current_queue = nullptr;
 
           std::mtc_deque<std::mtc_map<vk::queue*, std::mtc_deque<queue_operations_t>>> queues;
+
+          std::mtc_map<const vk::queue*, uint64_t> timeline_values;
       };
 
       using si_debug_marker = debug_marker<submit_info>;
@@ -0,0 +1,190 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+
+#include <vulkan/vulkan.h>
+
+#include "device.hpp"
+#include "../hydra_debug.hpp"
+
+namespace neam
+{
+  namespace hydra
+  {
+    namespace vk
+    {
+      /// \brief Wrap a timeline semaphore
+      /// A timeline semaphore holds a monotonically increasing 64bit counter that can be waited on / signaled
+      /// by both the host and the queues. Unlike binary semaphores, a single timeline can be waited on by multiple
+      /// consumers and can replace fences for host-side progress tracking.
+      /// \note Requires the timelineSemaphore feature (core in vulkan 1.2)
+      class timeline_semaphore
+      {
+        public: // advanced
+          /// \brief Construct a timeline semaphore from a vulkan object
+          timeline_semaphore(device &_dev, VkSemaphore _vk_semaphore)
+           : dev(_dev), vk_semaphore(_vk_semaphore)
+          {
+          }
+
+        public:
+          /// \brief Create a new timeline semaphore object
+          timeline_semaphore(device& _dev, uint64_t initial_value = 0, const std::source_location& sloc = std::source_location::current())
+           : timeline_semaphore(_dev, initial_value, fmt::format("timeline semaphore: {} : {} [{}]", sloc.file_name(), sloc.line(), sloc.function_name()))
+          {}
+
+          /// \brief Create a new timeline semaphore object
+          timeline_semaphore(device &_dev, uint64_t initial_value, const std::string& name)
+            : dev(_dev)
+          {
+            VkSemaphoreTypeCreateInfo stci;
+            stci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            stci.pNext = nullptr;
+            stci.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+            stci.initialValue = initial_value;
+
+            VkSemaphoreCreateInfo sci;
+            sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            sci.pNext = &stci;
+            sci.flags = 0;
+
+            check::on_vulkan_error::n_assert_success(dev._vkCreateSemaphore(&sci, nullptr, &vk_semaphore));
+            _set_debug_name(name);
+          }
+
+          /// \brief Move constructor
+          timeline_semaphore(timeline_semaphore &&o)
+           : dev(o.dev), vk_semaphore(o.vk_semaphore)
+          {
+            o.vk_semaphore = nullptr;
+          }
+
+          timeline_semaphore& operator = (timeline_semaphore &&o)
+          {
+            if (&o == this) return *this;
+
+            check::debug::n_assert(&dev == &o.dev, "Cannot assign timeline semaphore from another device");
+            if (vk_semaphore)
+              dev._vkDestroySemaphore(vk_semaphore, nullptr);
+            vk_semaphore = o.vk_semaphore;
+            o.vk_semaphore = nullptr;
+            return *this;
+          }
+
+          ~timeline_semaphore()
+          {
+            if (vk_semaphore)
+              dev._vkDestroySemaphore(vk_semaphore, nullptr);
+          }
+
+          /// \brief Return the current value of the counter (the last value the device/host has signaled)
+          uint64_t get_counter_value() const
+          {
+            uint64_t value = 0;
+            check::on_vulkan_error::n_assert_success(dev._vkGetSemaphoreCounterValue(vk_semaphore, &value));
+            return value;
+          }
+
+          /// \brief Return whether the counter has reached (or gone past) \p value
+          bool has_reached(uint64_t value) const
+          {
+            return get_counter_value() >= value;
+          }
+
+          /// \brief Wait for the counter to reach \p value
+          void wait(uint64_t value) const
+          {
+            VkResult res;
+            do
+              res = wait_raw(value, 100000000);
+            while (res == VK_TIMEOUT);
+
+#ifndef HYDRA_DISABLE_OPTIONAL_CHECKS
+            check::on_vulkan_error::n_assert_success(forward_result(res) /* from vkWaitSemaphores() */);
+#endif
+          }
+
+          /// \brief Wait for the counter to reach \p value for a specified time.
+          /// \return true if the value has been reached, false on timeout
+          /// \note the timeout is specified in nanoseconds
+          bool wait_for(uint64_t value, uint64_t nanosecond_timeout) const
+          {
+            const VkResult res = wait_raw(value, nanosecond_timeout);
+            if (res == VK_TIMEOUT)
+              return false;
+#ifndef HYDRA_DISABLE_OPTIONAL_CHECKS
+            check::on_vulkan_error::n_assert_success(forward_result(res) /* from vkWaitSemaphores() */);
+#endif
+            return res == VK_SUCCESS;
+          }
+
+          /// \brief Signal the semaphore from the host
+          /// \note value must be greater than the current value and any pending signal operation
+          void signal(uint64_t value)
+          {
+            VkSemaphoreSignalInfo ssi;
+            ssi.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+            ssi.pNext = nullptr;
+            ssi.semaphore = vk_semaphore;
+            ssi.value = value;
+            check::on_vulkan_error::n_assert_success(dev._vkSignalSemaphore(&ssi));
+          }
+
+        public: // advanced
+          /// \brief Return the vulkan object
+          VkSemaphore _get_vk_semaphore() const
+          {
+            return vk_semaphore;
+          }
+
+          void _set_debug_name(const std::string& name)
+          {
+            dev._set_object_debug_name((uint64_t)vk_semaphore, VK_OBJECT_TYPE_SEMAPHORE, name);
+          }
+
+        private:
+          VkResult wait_raw(uint64_t value, uint64_t nanosecond_timeout) const
+          {
+            VkSemaphoreWaitInfo swi;
+            swi.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            swi.pNext = nullptr;
+            swi.flags = 0;
+            swi.semaphoreCount = 1;
+            swi.pSemaphores = &vk_semaphore;
+            swi.pValues = &value;
+            return dev._vkWaitSemaphores(&swi, nanosecond_timeout);
+          }
+
+        private:
+          device &dev;
+          VkSemaphore vk_semaphore;
+      };
+    } // namespace vk
+  } // namespace hydra
+} // namespace neam
+
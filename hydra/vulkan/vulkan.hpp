@@ -43,7 +43,10 @@
 #include "command_buffer_recorder.hpp"
 #include "fence.hpp"
 #include "semaphore.hpp"
+#include "timeline_semaphore.hpp"
 #include "event.hpp"
+#include "query_pool.hpp"
+#include "command_buffer_marker_listener.hpp"
 #include "memory_barrier.hpp"
 #include "image.hpp"
 #include "image_view.hpp"
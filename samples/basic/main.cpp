@@ -23,6 +23,7 @@
 #include <hydra/engine/core_modules/core_module.hpp>
 
 #include <hydra/imgui/utilities/imgui_log_window.hpp>
+#include <hydra/imgui/utilities/imgui_gpu_profiler_window.hpp>
 #include "fs_quad_pass.hpp"
 #include <hydra/ecs/universe.hpp>
 //#include "mesh-render-pass.hpp"
@@ -252,6 +253,10 @@ namespace neam::hydra
         {
           log_window.show_log_window();
         });
+        imgui->register_function("gpu_profiler"_rid, [window = imgui_gpu_profiler_window { hctx->gpu_prof }]() mutable
+        {
+          window.show_gpu_profiler_window();
+        });
         imgui->register_function("stats"_rid, [this]()
         {
           ImGui::Begin("Stats", nullptr, 0);
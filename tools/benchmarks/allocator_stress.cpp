@@ -0,0 +1,330 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <hydra/engine/engine.hpp>
+#include <hydra/utilities/allocator/block_allocator.hpp>
+#include <hydra/utilities/allocator/persistent_pool.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct allocator_stress_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t steps = 200000;
+    uint32_t seed = 42;
+    uint32_t max_allocation_size = 512 * 1024;
+    uint32_t check_interval = 1;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::allocator_stress_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(steps, neam::metadata::info{.description = c_string_t<"Number of allocate / free operations of each phase (grow, churn, shrink).">}),
+    N_MEMBER_DEF(seed, neam::metadata::info{.description = c_string_t<"Seed of the random operations.">}),
+    N_MEMBER_DEF(max_allocation_size, neam::metadata::info{.description = c_string_t
+    <
+      "Maximum size of an allocation (sizes are log-uniform between 1 byte and this value).\n"
+      "Clamped to persistent_pool::k_max_allocation_size."
+    >}),
+    N_MEMBER_DEF(check_interval, neam::metadata::info{.description = c_string_t
+    <
+      "Number of operations between two calls to persistent_pool::_check_consistency() (1: after every operation, 0: never).\n"
+      "The consistency check is slow and is not part of the reported timings."
+    >})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Randomized allocate / free driver for the persistent pool (TLSF).
+// Checks that no two live allocations overlap, that the alignment is respected and that the pool stays consistent,
+// and reports the fragmentation at the end of each phase (grow, churn, shrink).
+// The blocks are real device-memory allocations, so a vulkan device is created (nothing is ever submitted to it).
+
+namespace
+{
+  struct phase_t
+  {
+    const char* name;
+    // probability of an allocation (vs. a free)
+    double allocation_probability;
+  };
+
+  class stress_driver
+  {
+    public:
+      stress_driver(hydra::allocator::persistent_pool& _pool, const allocator_stress_options& _opt)
+        : pool(_pool), opt(_opt), rng(_opt.seed)
+      {
+      }
+
+      ~stress_driver()
+      {
+        for (auto& it : live)
+          it.mem.free();
+      }
+
+      /// \brief Run a phase, return false on failure
+      bool run_phase(const phase_t& phase)
+      {
+        std::bernoulli_distribution is_allocation(phase.allocation_probability);
+        uint64_t allocation_count = 0;
+        uint64_t free_count = 0;
+        double time = 0;
+
+        for (uint32_t step = 0; step < opt.steps; ++step)
+        {
+          if (live.empty() || is_allocation(rng))
+          {
+            const uint32_t size = random_size();
+            const uint32_t alignment = random_alignment();
+
+            const clock::time_point start = clock::now();
+            hydra::memory_allocation mem = pool.allocate(size, alignment);
+            time += get_elapsed(start);
+            ++allocation_count;
+
+            if (!check_allocation(mem, size, alignment))
+              return false;
+            live.push_back({ std::move(mem), size });
+          }
+          else
+          {
+            const uint32_t index = std::uniform_int_distribution<uint32_t>(0, (uint32_t)live.size() - 1)(rng);
+            ranges.erase(get_key(live[index].mem));
+
+            const clock::time_point start = clock::now();
+            live[index].mem.free();
+            time += get_elapsed(start);
+            ++free_count;
+
+            std::swap(live[index], live.back());
+            live.pop_back();
+          }
+
+          if (opt.check_interval > 0 && (step % opt.check_interval) == 0)
+            pool._check_consistency();
+        }
+        pool._check_consistency();
+
+        const hydra::allocator::persistent_pool::stats_t stats = pool.get_stats();
+        if (stats.allocation_count != live.size())
+        {
+          cr::out().error("{}: the pool has {} allocations, {} are alive", phase.name, stats.allocation_count, live.size());
+          return false;
+        }
+
+        const double op_count = double(allocation_count + free_count);
+        cr::out().log("{:6} | {:11} | {:6} | {:10.2f} | {:10.2f} | {:13.2f} | {:6} | {:11.4f} | {:13.4f} | {:6.1f}",
+                      phase.name, live.size(), stats.block_count,
+                      stats.used_memory / (1024.0 * 1024.0), stats.free_memory / (1024.0 * 1024.0), stats.largest_free_range / (1024.0 * 1024.0),
+                      stats.free_range_count, (double)requested_memory() / (double)std::max<uint64_t>(1, stats.used_memory + stats.free_memory),
+                      stats.fragmentation(), time > 0 ? op_count / time / 1'000'000.0 : 0.0);
+        return true;
+      }
+
+      /// \brief Free everything, check that the pool is back to (at most) a single empty block
+      bool free_all()
+      {
+        std::shuffle(live.begin(), live.end(), rng);
+        for (auto& it : live)
+        {
+          ranges.erase(get_key(it.mem));
+          it.mem.free();
+          if (opt.check_interval > 0)
+            pool._check_consistency();
+        }
+        live.clear();
+        pool._check_consistency();
+
+        const hydra::allocator::persistent_pool::stats_t stats = pool.get_stats();
+        if (stats.allocation_count != 0 || stats.used_memory != 0 || stats.block_count > 1 || stats.free_range_count > 1)
+        {
+          cr::out().error("free-all: the pool is not empty (allocations: {}, used memory: {}, blocks: {}, free ranges: {})",
+                          stats.allocation_count, stats.used_memory, stats.block_count, stats.free_range_count);
+          return false;
+        }
+        return true;
+      }
+
+    private:
+      struct live_allocation_t
+      {
+        hydra::memory_allocation mem;
+        uint32_t size;
+      };
+
+      using key_t = std::pair<const hydra::vk::device_memory*, size_t>;
+
+      static key_t get_key(const hydra::memory_allocation& mem) { return { mem.mem(), mem.offset() }; }
+
+      uint32_t random_size()
+      {
+        const uint32_t max_size = std::min(opt.max_allocation_size, hydra::allocator::persistent_pool::k_max_allocation_size);
+        // log-uniform: as many small allocations as big ones
+        std::uniform_real_distribution<double> dist(0.0, std::log2((double)std::max(1u, max_size)));
+        return std::clamp((uint32_t)std::exp2(dist(rng)), 1u, max_size);
+      }
+
+      uint32_t random_alignment()
+      {
+        static constexpr uint32_t k_alignments[] = { 1, 16, 64, 256, 4096 };
+        return k_alignments[std::uniform_int_distribution<uint32_t>(0, std::size(k_alignments) - 1)(rng)];
+      }
+
+      uint64_t requested_memory() const
+      {
+        uint64_t ret = 0;
+        for (const auto& it : live)
+          ret += it.size;
+        return ret;
+      }
+
+      bool check_allocation(const hydra::memory_allocation& mem, uint32_t size, uint32_t alignment)
+      {
+        if (!mem.is_valid() || mem.size() < size)
+        {
+          cr::out().error("allocation of {} bytes (alignment: {}) failed", size, alignment);
+          return false;
+        }
+        if ((mem.offset() % alignment) != 0)
+        {
+          cr::out().error("allocation of {} bytes at offset {} is not aligned to {}", size, mem.offset(), alignment);
+          return false;
+        }
+        if (mem.offset() + mem.size() > mem.mem()->get_size())
+        {
+          cr::out().error("allocation of {} bytes at offset {} is outside of its device-memory ({} bytes)", size, mem.offset(), mem.mem()->get_size());
+          return false;
+        }
+
+        const key_t key = get_key(mem);
+        const size_t end = mem.offset() + mem.size();
+        auto next = ranges.lower_bound(key);
+        if (next != ranges.end() && next->first.first == key.first && next->first.second < end)
+        {
+          cr::out().error("allocation [{}, {}[ overlaps with [{}, {}[", mem.offset(), end, next->first.second, next->second);
+          return false;
+        }
+        if (next != ranges.begin())
+        {
+          auto prev = std::prev(next);
+          if (prev->first.first == key.first && prev->second > mem.offset())
+          {
+            cr::out().error("allocation [{}, {}[ overlaps with [{}, {}[", mem.offset(), end, prev->first.second, prev->second);
+            return false;
+          }
+        }
+        ranges.emplace(key, end);
+        return true;
+      }
+
+    private:
+      hydra::allocator::persistent_pool& pool;
+      const allocator_stress_options& opt;
+      std::mt19937_64 rng;
+
+      std::vector<live_allocation_t> live;
+      // (device-memory, offset) -> end of the live allocations
+      std::map<key_t, size_t> ranges;
+  };
+
+  bool run_stress_test(hydra::vk::device& dev, uint32_t memory_type_index, uint32_t granularity, const allocator_stress_options& opt)
+  {
+    cr::out().log("granularity: {} bytes", granularity);
+    cr::out().log("phase  | allocations | blocks | used (MiB) | free (MiB) | largest (MiB) | ranges | utilization | fragmentation | Mops/s");
+
+    hydra::allocator::block_allocator block { dev, memory_type_index };
+    hydra::allocator::persistent_pool pool { block, granularity };
+
+    static constexpr phase_t k_phases[] =
+    {
+      { .name = "grow", .allocation_probability = 0.7 },
+      { .name = "churn", .allocation_probability = 0.5 },
+      { .name = "shrink", .allocation_probability = 0.3 },
+    };
+
+    stress_driver driver { pool, opt };
+    for (const phase_t& phase : k_phases)
+    {
+      if (!driver.run_phase(phase))
+        return false;
+    }
+    return driver.free_all();
+  }
+
+  int run(int argc, char** argv)
+  {
+    allocator_stress_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+
+    neam::hydra::engine_t engine;
+    if (engine.init(neam::hydra::runtime_mode::vulkan_context | neam::hydra::runtime_mode::offscreen | neam::hydra::runtime_mode::offline
+                    | neam::hydra::runtime_mode::packer_less | neam::hydra::runtime_mode::release) == resources::status::failure)
+    {
+      cr::out().error("failed to create the vulkan device");
+      return 2;
+    }
+    hydra::vk::device& dev = engine.get_vulkan_context().device;
+
+    const uint32_t memory_type_index = (uint32_t)hydra::vk::device_memory::get_memory_type_index(dev, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ~0u);
+    const uint32_t granularity = (uint32_t)dev.get_physical_device().get_limits().bufferImageGranularity;
+
+    // pools with a single kind of resources, then pools with both linear and non-linear resources:
+    bool has_failed = !run_stress_test(dev, memory_type_index, 1, opt);
+    if (!has_failed && granularity > 1)
+      has_failed = !run_stress_test(dev, memory_type_index, granularity, opt);
+
+    if (has_failed)
+    {
+      cr::out().error("persistent pool stress test failed");
+      return 3;
+    }
+    return 0;
+  }
+
+  raii_register_benchmark _register { "allocator_stress", "randomized allocate / free stress test of the persistent pool", &run };
+}
@@ -0,0 +1,195 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include <hydra/resources/compressor.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct compression_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t iterations = 5;
+    uint64_t min_file_size = 256;
+    std::filesystem::path source_folder = std::filesystem::current_path();
+
+    // resources:
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::compression_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(iterations, neam::metadata::info{.description = c_string_t<"Number of times each file is decompressed (the best time is kept).">}),
+    N_MEMBER_DEF(min_file_size, neam::metadata::info{.description = c_string_t<"Files smaller than this are skipped (they would not be compressed by the resource context).">}),
+    N_MEMBER_DEF(source_folder, neam::metadata::info{.description = c_string_t
+    <
+      "Path to the corpus folder. All the files in the folder (and sub-folders) are used.\n"
+      "Pack files (.hpd) should be built with `enable_background_compression` so their content is not already compressed."
+    >})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+namespace
+{
+  struct codec_result_t
+  {
+    uint64_t file_count = 0;
+    uint64_t input_size = 0;
+    uint64_t compressed_size = 0;
+    double compression_time = 0; // seconds
+    double decompression_time = 0; // seconds (best of all the iterations, summed over all the files)
+  };
+
+  raw_data read_file(const std::filesystem::path& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return {};
+    const uint64_t size = std::filesystem::file_size(path);
+    raw_data ret = raw_data::allocate(size);
+    file.read((char*)ret.data.get(), size);
+    if (!file)
+      return {};
+    return ret;
+  }
+
+  double to_mbps(uint64_t size, double time)
+  {
+    return time > 0 ? (double)size / (1024.0 * 1024.0) / time : 0;
+  }
+
+  int run(int argc, char** argv)
+  {
+    compression_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    opt.iterations = std::max(1u, opt.iterations);
+
+    if (!std::filesystem::exists(opt.source_folder) || !std::filesystem::is_directory(opt.source_folder))
+    {
+      cr::out().error("Source folder ({}) is not valid. Refusing to operate.", opt.source_folder.c_str());
+      return 2;
+    }
+
+    std::vector<resources::codec> codecs;
+    for (resources::codec c : { resources::codec::lzma, resources::codec::zstd })
+    {
+      if (resources::is_codec_supported(c))
+        codecs.push_back(c);
+      else
+        cr::out().warn("codec {} is not supported by this build, skipping it", resources::get_codec_name(c));
+    }
+    if (codecs.empty())
+    {
+      cr::out().error("no codec supported by this build (compression is disabled)");
+      return 3;
+    }
+
+    std::vector<codec_result_t> results;
+    results.resize(codecs.size());
+
+    for (const auto& it : std::filesystem::recursive_directory_iterator(opt.source_folder))
+    {
+      if (!it.is_regular_file() || it.file_size() < opt.min_file_size)
+        continue;
+
+      const raw_data data = read_file(it.path());
+      if (data.size == 0)
+      {
+        cr::out().warn("failed to read {}, skipping it", it.path().c_str());
+        continue;
+      }
+
+      for (uint32_t i = 0; i < codecs.size(); ++i)
+      {
+        codec_result_t& res = results[i];
+
+        const clock::time_point compression_start = clock::now();
+        const raw_data compressed = resources::compress(raw_data::duplicate(data), codecs[i]);
+        res.compression_time += get_elapsed(compression_start);
+        if (compressed.size == 0)
+        {
+          cr::out().warn("{}: failed to compress {}, skipping it", resources::get_codec_name(codecs[i]), it.path().c_str());
+          continue;
+        }
+
+        double best_time = std::numeric_limits<double>::max();
+        for (uint32_t j = 0; j < opt.iterations; ++j)
+        {
+          // uncompress consumes its input:
+          raw_data input = raw_data::duplicate(compressed);
+          const clock::time_point decompression_start = clock::now();
+          const raw_data uncompressed = resources::uncompress(std::move(input));
+          best_time = std::min(best_time, get_elapsed(decompression_start));
+
+          if (j == 0 && (uncompressed.size != data.size || memcmp(uncompressed.data.get(), data.data.get(), data.size) != 0))
+            cr::out().error("{}: round-trip failed for {}", resources::get_codec_name(codecs[i]), it.path().c_str());
+        }
+
+        ++res.file_count;
+        res.input_size += data.size;
+        res.compressed_size += compressed.size;
+        res.decompression_time += best_time;
+
+        cr::out().debug("{}: {}: {} -> {} bytes, decode: {:.1f} MB/s", resources::get_codec_name(codecs[i]), it.path().c_str(),
+                        data.size, compressed.size, to_mbps(data.size, best_time));
+      }
+    }
+
+    cr::out().log("codec | files | input size | compressed size | ratio | compression MB/s | decompression MB/s");
+    for (uint32_t i = 0; i < codecs.size(); ++i)
+    {
+      const codec_result_t& res = results[i];
+      cr::out().log("{:5} | {:5} | {:10} | {:15} | {:5.3f} | {:16.2f} | {:18.2f}", resources::get_codec_name(codecs[i]), res.file_count,
+                    res.input_size, res.compressed_size, res.input_size > 0 ? (double)res.compressed_size / (double)res.input_size : 0.0,
+                    to_mbps(res.input_size, res.compression_time), to_mbps(res.input_size, res.decompression_time));
+    }
+
+    return 0;
+  }
+
+  raii_register_benchmark _register { "compression", "ratio and decompression speed of the resource codecs", &run };
+}
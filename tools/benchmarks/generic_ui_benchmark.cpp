@@ -0,0 +1,169 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <vector>
+
+#include <hydra/imgui/generic_ui.hpp>
+#include <ntools/rle/rle.hpp>
+
+#include "harness.hpp"
+#include "generic_ui_types.hpp"
+
+namespace neam::benchmarks
+{
+  struct generic_ui_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t frame_count = 500;
+    uint32_t dynamic_object_count = 64;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::generic_ui_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(frame_count, neam::metadata::info{.description = c_string_t<"Number of frames measured for each type and path.">}),
+    N_MEMBER_DEF(dynamic_object_count, neam::metadata::info{.description = c_string_t<"Number of objects in the container of the dynamic-layout type.">})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Measure the cpu time of generate_ui for big types in a headless imgui context, for the different paths:
+//  - walker: the ui plans are disabled, every frame walks the metadata and re-serializes the data
+//  - plan: generate_ui() replays the cached plan over a copy of the data
+//  - plan in place: generate_ui_in_place() replays the cached plan and patches the data in place
+// The first frame of the plan paths (which compiles the plan) is reported separately.
+// As no input is sent to imgui, the data must not change: this is checked for all the paths.
+
+namespace
+{
+  enum class ui_path
+  {
+    walker,
+    plan,
+    plan_in_place,
+  };
+
+  struct timings_t
+  {
+    double first_frame = 0; // us
+    samples_t times; // us (without the first frame)
+
+    void print(const char* type_name, const char* path_name)
+    {
+      cr::out().log("{:22} | {:14} | {:11.1f} | {:9.1f} | {:9.1f} | {:9.1f}", type_name, path_name, first_frame, times.get_average(),
+                    times.get_percentile(50), times.get_percentile(99));
+    }
+  };
+
+  /// \return whether the data was left untouched
+  bool run_path(const generic_ui_options& opt, const char* type_name, const raw_data& initial, const rle::serialization_metadata& md, ui_path path, const char* path_name)
+  {
+    imgui::_clear_ui_plan_cache();
+    imgui::_set_use_ui_plans(path != ui_path::walker);
+
+    timings_t timings;
+
+    raw_data data = initial.duplicate();
+    bool is_same = true;
+    for (uint32_t frame = 0; frame < opt.frame_count; ++frame)
+    {
+      ImGui::NewFrame();
+      ImGui::SetNextWindowPos({ 0, 0 }, ImGuiCond_Always);
+      ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize, ImGuiCond_Always);
+      ImGui::Begin(type_name);
+
+      const clock::time_point start = clock::now();
+      if (path == ui_path::plan_in_place)
+        imgui::generate_ui_in_place(data, md);
+      else
+        data = imgui::generate_ui(data, md);
+      const double time = get_elapsed(start) * 1e6;
+
+      ImGui::End();
+      ImGui::Render();
+
+      if (frame == 0)
+        timings.first_frame = time;
+      else
+        timings.times.add(time);
+      is_same = is_same && raw_data::is_same(data, initial);
+    }
+
+    timings.print(type_name, path_name);
+    imgui::_set_use_ui_plans(true);
+
+    if (!is_same)
+      cr::out().error("{}: {}: the data was modified without any input", type_name, path_name);
+    return is_same;
+  }
+
+  bool run_type(const generic_ui_options& opt, const char* type_name, const raw_data& data, const rle::serialization_metadata& md)
+  {
+    cr::out().debug("{}: {} bytes of serialized data", type_name, data.size);
+    bool success = true;
+    success = run_path(opt, type_name, data, md, ui_path::walker, "walker") && success;
+    success = run_path(opt, type_name, data, md, ui_path::plan, "plan") && success;
+    success = run_path(opt, type_name, data, md, ui_path::plan_in_place, "plan in place") && success;
+    return success;
+  }
+
+  int run(int argc, char** argv)
+  {
+    generic_ui_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    opt.frame_count = std::max(2u, opt.frame_count);
+
+    headless_imgui_context imgui_context;
+
+    benchmarks::dynamic_scene_t dynamic_scene;
+    dynamic_scene.objects.resize(opt.dynamic_object_count);
+    dynamic_scene.tags = { "benchmark", "generic-ui", "dynamic-layout" };
+
+    cr::out().log("{} frames per path (times in us)", opt.frame_count);
+    cr::out().log("{:22} | {:14} | {:>11} | {:>9} | {:>9} | {:>9}", "type", "path", "first frame", "avg", "p50", "p99");
+    bool has_failed = false;
+    has_failed = !run_type(opt, "object (fixed)", rle::serialize(benchmarks::object_t{}), rle::generate_metadata<benchmarks::object_t>()) || has_failed;
+    has_failed = !run_type(opt, "scene (fixed)", rle::serialize(benchmarks::fixed_scene_t{}), rle::generate_metadata<benchmarks::fixed_scene_t>()) || has_failed;
+    has_failed = !run_type(opt, "scene (dynamic)", rle::serialize(dynamic_scene), rle::generate_metadata<benchmarks::dynamic_scene_t>()) || has_failed;
+    return has_failed ? 2 : 0;
+  }
+
+  raii_register_benchmark _register { "generic_ui", "generate_ui with cached plans against the metadata walker", &run };
+}
@@ -0,0 +1,176 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <hydra_glm.hpp>
+#include <hydra/ecs/transform.hpp>
+#include <ntools/struct_metadata/struct_metadata.hpp>
+
+// Types edited by the benchmark. They are bigger than any configuration of the engine,
+// and are representative of what an editor would display (many nested structs of raw values).
+
+namespace neam::benchmarks
+{
+  struct material_t
+  {
+    glm::vec4 albedo { 1, 1, 1, 1 };
+    float roughness = 0.5f;
+    float metalness = 0.0f;
+    float emissive_strength = 0.0f;
+    uint32_t flags = 0;
+    bool double_sided = false;
+  };
+
+  struct light_t
+  {
+    glm::vec3 position { 0, 0, 0 };
+    glm::vec3 color { 1, 1, 1 };
+    float intensity = 1.0f;
+    float radius = 10.0f;
+    bool cast_shadows = true;
+    uint32_t shadow_resolution = 1024;
+  };
+
+  struct object_t
+  {
+    hydra::transform transform;
+    material_t material;
+    light_t light;
+    bool visible = true;
+    uint32_t layer = 0;
+  };
+
+  struct scene_section_t
+  {
+    object_t object_0;
+    object_t object_1;
+    object_t object_2;
+    object_t object_3;
+    object_t object_4;
+    object_t object_5;
+    object_t object_6;
+    object_t object_7;
+  };
+
+  /// \brief Fixed layout: uses the cached UI plan
+  struct fixed_scene_t
+  {
+    scene_section_t section_0;
+    scene_section_t section_1;
+    scene_section_t section_2;
+    scene_section_t section_3;
+    scene_section_t section_4;
+    scene_section_t section_5;
+    scene_section_t section_6;
+    scene_section_t section_7;
+  };
+
+  /// \brief Dynamic layout (strings, containers): always goes through the walker
+  struct dynamic_scene_t
+  {
+    std::string name = "dynamic scene";
+    std::vector<std::string> tags;
+    std::vector<object_t> objects;
+  };
+}
+
+N_METADATA_STRUCT(neam::benchmarks::material_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(albedo),
+    N_MEMBER_DEF(roughness),
+    N_MEMBER_DEF(metalness),
+    N_MEMBER_DEF(emissive_strength),
+    N_MEMBER_DEF(flags),
+    N_MEMBER_DEF(double_sided)
+  >;
+};
+N_METADATA_STRUCT(neam::benchmarks::light_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(position),
+    N_MEMBER_DEF(color),
+    N_MEMBER_DEF(intensity),
+    N_MEMBER_DEF(radius),
+    N_MEMBER_DEF(cast_shadows),
+    N_MEMBER_DEF(shadow_resolution)
+  >;
+};
+N_METADATA_STRUCT(neam::benchmarks::object_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(transform),
+    N_MEMBER_DEF(material),
+    N_MEMBER_DEF(light),
+    N_MEMBER_DEF(visible),
+    N_MEMBER_DEF(layer)
+  >;
+};
+N_METADATA_STRUCT(neam::benchmarks::scene_section_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(object_0),
+    N_MEMBER_DEF(object_1),
+    N_MEMBER_DEF(object_2),
+    N_MEMBER_DEF(object_3),
+    N_MEMBER_DEF(object_4),
+    N_MEMBER_DEF(object_5),
+    N_MEMBER_DEF(object_6),
+    N_MEMBER_DEF(object_7)
+  >;
+};
+N_METADATA_STRUCT(neam::benchmarks::fixed_scene_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(section_0),
+    N_MEMBER_DEF(section_1),
+    N_MEMBER_DEF(section_2),
+    N_MEMBER_DEF(section_3),
+    N_MEMBER_DEF(section_4),
+    N_MEMBER_DEF(section_5),
+    N_MEMBER_DEF(section_6),
+    N_MEMBER_DEF(section_7)
+  >;
+};
+N_METADATA_STRUCT(neam::benchmarks::dynamic_scene_t)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(name),
+    N_MEMBER_DEF(tags),
+    N_MEMBER_DEF(objects)
+  >;
+};
@@ -0,0 +1,176 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <imgui.h>
+
+#include <ntools/cmdline/cmdline.hpp>
+#include <ntools/logger/logger.hpp>
+#include <ntools/struct_metadata/struct_metadata.hpp>
+
+namespace neam::benchmarks
+{
+  using clock = std::chrono::high_resolution_clock;
+
+  /// \brief Entry point of a benchmark. argv[0] is the name of the benchmark, the options follow.
+  using run_function_t = int (*)(int argc, char** argv);
+
+  struct benchmark_t
+  {
+    std::string_view name;
+    std::string_view description;
+    run_function_t run;
+  };
+
+  /// \brief Return the registered benchmarks
+  std::vector<benchmark_t>& get_benchmarks();
+
+  /// \brief Register a benchmark. Must be a static variable of the benchmark file.
+  struct raii_register_benchmark
+  {
+    raii_register_benchmark(std::string_view name, std::string_view description, run_function_t run)
+    {
+      get_benchmarks().push_back({ name, description, run });
+    }
+  };
+
+  /// \brief Parse the options of a benchmark. Print the usage and return false on failure or when help is requested.
+  /// \note Options must have the help, verbose and parameters members.
+  template<typename Options>
+  bool parse_options(int argc, char** argv, Options& opt, uint32_t positional_count = 0, std::string_view positional_usage = {})
+  {
+    cmdline::parse cmd(argc, argv);
+    bool success;
+    opt = cmd.process<Options>(success, positional_count);
+    if (!success || opt.help || opt.parameters.size() != positional_count)
+    {
+      // output the different options and exit:
+      cr::out().warn("usage: {} [options] {}", argv[0], positional_usage);
+      cr::out().log("possible options:");
+      cmdline::arg_struct<Options>::print_options();
+      return false;
+    }
+    if (opt.verbose)
+      cr::get_global_logger().min_severity = cr::logger::severity::debug;
+    return true;
+  }
+
+  /// \brief Seconds elapsed since start
+  inline double get_elapsed(clock::time_point start)
+  {
+    return std::chrono::duration<double>(clock::now() - start).count();
+  }
+
+  /// \brief Call fnc(iteration) iterations times (at least once), return the best time (in seconds)
+  template<typename Fnc>
+  double get_best_time(uint32_t iterations, Fnc&& fnc)
+  {
+    double ret = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < std::max(1u, iterations); ++i)
+    {
+      const clock::time_point start = clock::now();
+      fnc(i);
+      ret = std::min(ret, get_elapsed(start));
+    }
+    return ret;
+  }
+
+  /// \brief Distribution of timings
+  struct samples_t
+  {
+    std::vector<double> values;
+
+    void add(double value) { values.push_back(value); sorted = false; }
+    bool empty() const { return values.empty(); }
+    uint32_t size() const { return (uint32_t)values.size(); }
+
+    double get_average() const
+    {
+      if (values.empty())
+        return 0;
+      double sum = 0;
+      for (double it : values)
+        sum += it;
+      return sum / (double)values.size();
+    }
+
+    /// \brief percentile in [0, 100]
+    double get_percentile(uint32_t percentile)
+    {
+      if (values.empty())
+        return 0;
+      sort();
+      return values[std::min(values.size() - 1, values.size() * percentile / 100)];
+    }
+
+    double get_max()
+    {
+      if (values.empty())
+        return 0;
+      sort();
+      return values.back();
+    }
+
+    private:
+      void sort()
+      {
+        if (!std::exchange(sorted, true))
+          std::sort(values.begin(), values.end());
+      }
+
+      bool sorted = true;
+  };
+
+  /// \brief Imgui context without any backend (the font atlas is built, nothing is rendered)
+  struct headless_imgui_context
+  {
+    headless_imgui_context()
+    {
+      ImGui::CreateContext();
+      ImGuiIO& io = ImGui::GetIO();
+      io.IniFilename = nullptr;
+      io.DisplaySize = { 1920, 1080 };
+      io.DeltaTime = 1.0f / 60.0f;
+      unsigned char* pixels;
+      int width, height;
+      io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+
+    ~headless_imgui_context()
+    {
+      ImGui::DestroyContext();
+    }
+  };
+}
@@ -0,0 +1,299 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <hydra/engine/engine.hpp>
+#include <hydra/engine/core_modules/core_module.hpp>
+#include <hydra/ecs/universe.hpp>
+#include <hydra/ecs/hierarchy.hpp>
+#include <hydra/ecs/transform.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct hierarchy_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t iterations = 10;
+    uint32_t node_count = 100000;
+    uint32_t seed = 42;
+
+    uint32_t thread_count = std::max(2u, std::thread::hardware_concurrency()) - 2;
+    uint32_t helper_task_count = 0;
+    uint32_t entity_per_task = 32;
+
+    bool incremental = false;
+    bool transform_store = false;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::hierarchy_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(iterations, neam::metadata::info{.description = c_string_t<"Number of times each update is run (the best time is kept).">}),
+    N_MEMBER_DEF(node_count, neam::metadata::info{.description = c_string_t<"Number of entities in each synthetic hierarchy.">}),
+    N_MEMBER_DEF(seed, neam::metadata::info{.description = c_string_t<"Seed of the random hierarchies / transforms.">}),
+
+    N_MEMBER_DEF(thread_count, neam::metadata::info{.description = c_string_t<"Number of worker threads of the task manager.">}),
+    N_MEMBER_DEF(helper_task_count, neam::metadata::info{.description = c_string_t<"max_helper_task_count of the tasked update (0: use the thread count).">}),
+    N_MEMBER_DEF(entity_per_task, neam::metadata::info{.description = c_string_t<"entity_per_task of the tasked update.">}),
+
+    N_MEMBER_DEF(incremental, neam::metadata::info{.description = c_string_t<"Use incremental updates (only ~1% of the transforms are changed between two updates).">}),
+    N_MEMBER_DEF(transform_store, neam::metadata::info{.description = c_string_t<"Use the SoA transform store of the universe.">})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Build synthetic hierarchies of transform components in a universe, then time universe::hierarchical_update_tasked
+// against universe::hierarchical_update_single_thread and check that both produce the same world transforms.
+// The tasked update is level-synchronous, so the hierarchies go from wide (few big levels) to deep (many small levels).
+
+namespace
+{
+  using hierarchy = hydra::ecs::components::hierarchy;
+  using transform = hydra::ecs::components::transform;
+
+  struct tree_desc_t
+  {
+    const char* name;
+    uint32_t depth;
+  };
+
+  hydra::transform random_transform(std::mt19937_64& rng)
+  {
+    std::uniform_real_distribution<double> pos_dist(-1000.0, 1000.0);
+    std::normal_distribution<float> quat_dist(0.0f, 1.0f);
+    std::uniform_real_distribution<float> scale_dist(0.8f, 1.25f);
+
+    hydra::transform ret;
+    ret.translation = { pos_dist(rng), pos_dist(rng), pos_dist(rng) };
+    ret.rotation = glm::normalize(glm::quat { quat_dist(rng), quat_dist(rng), quat_dist(rng), quat_dist(rng) });
+    ret.scale = scale_dist(rng);
+    return ret;
+  }
+
+  class benchmark_tree
+  {
+    public:
+      /// \brief Each level has (roughly) the same number of entities, parents are chosen at random in the previous level
+      benchmark_tree(const hierarchy_options& opt, uint32_t depth, std::mt19937_64& rng)
+      {
+        uni.set_incremental_update(opt.incremental);
+        uni.enable_transform_store(opt.transform_store);
+
+        entities.reserve(opt.node_count);
+        const uint32_t width = std::max(1u, opt.node_count / depth);
+        uint32_t previous_level_begin = 0;
+        for (uint32_t d = 0; d < depth && entities.size() < opt.node_count; ++d)
+        {
+          const uint32_t level_begin = (uint32_t)entities.size();
+          const uint32_t count = (d + 1 == depth) ? std::max(1u, opt.node_count - level_begin) : std::min(width, opt.node_count - level_begin);
+          for (uint32_t i = 0; i < count; ++i)
+          {
+            hierarchy* parent = &uni.get_universe_root();
+            if (d > 0)
+              parent = entities[std::uniform_int_distribution<uint32_t>(previous_level_begin, level_begin - 1)(rng)].get<hierarchy>();
+
+            hydra::ecs::entity& ent = entities.emplace_back(parent->create_child().generate_strong_reference());
+            std::lock_guard _el(spinlock_exclusive_adapter::adapt(ent.get_lock()));
+            ent.add<transform>().update_local_transform() = random_transform(rng);
+          }
+          previous_level_begin = level_begin;
+        }
+        level_count = depth;
+
+        db.apply_component_db_changes();
+        // the first update is not timed (it does the one-time allocations)
+        uni.hierarchical_update_single_thread();
+      }
+
+      /// \brief Best time of the update (and the number of entities updated by the last run)
+      std::pair<double, uint32_t> time_update(hydra::core_context* cctx, const hierarchy_options& opt, std::mt19937_64& rng)
+      {
+        const uint32_t helper_task_count = opt.helper_task_count > 0 ? opt.helper_task_count : std::max(1u, opt.thread_count);
+
+        double best_time = std::numeric_limits<double>::max();
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < opt.iterations; ++i)
+        {
+          if (opt.incremental)
+          {
+            // touch ~1% of the transforms (the values don't change, so the results stay comparable)
+            const uint32_t change_count = std::max(1u, (uint32_t)entities.size() / 100);
+            for (uint32_t j = 0; j < change_count; ++j)
+            {
+              transform* tr = entities[std::uniform_int_distribution<uint32_t>(0, (uint32_t)entities.size() - 1)(rng)].get<transform>();
+              tr->update_local_transform();
+            }
+          }
+
+          const clock::time_point start = clock::now();
+          if (cctx != nullptr)
+            count = uni.hierarchical_update_tasked(*cctx, helper_task_count, opt.entity_per_task);
+          else
+            count = uni.hierarchical_update_single_thread();
+          best_time = std::min(best_time, get_elapsed(start));
+        }
+        return { best_time, count };
+      }
+
+      std::vector<hydra::transform> get_world_transforms()
+      {
+        std::vector<hydra::transform> ret;
+        ret.reserve(entities.size());
+        for (hydra::ecs::entity& it : entities)
+          ret.push_back(it.get<transform>()->get_local_to_world_transform());
+        return ret;
+      }
+
+      uint32_t get_entity_count() const { return (uint32_t)entities.size(); }
+      uint32_t get_level_count() const { return level_count; }
+
+    private:
+      hydra::ecs::database db;
+      hydra::ecs::universe uni { db };
+      std::vector<hydra::ecs::entity> entities;
+      uint32_t level_count = 0;
+  };
+
+  uint32_t count_mismatches(const std::vector<hydra::transform>& a, const std::vector<hydra::transform>& b)
+  {
+    uint32_t ret = 0;
+    for (uint32_t i = 0; i < a.size(); ++i)
+    {
+      // same operations in the same order on both paths: the results must be exactly the same
+      if (a[i].translation != b[i].translation || a[i].rotation != b[i].rotation || a[i].scale != b[i].scale)
+        ++ret;
+    }
+    return ret;
+  }
+
+  bool run_benchmark(hydra::core_context& cctx, const hierarchy_options& opt)
+  {
+    const tree_desc_t trees[] =
+    {
+      { "wide", 2 },
+      { "balanced", 16 },
+      { "deep", 256 },
+      // levels of ~8 entities: below entity_per_task, the tasked update cannot dispatch anything
+      { "very-deep", std::max(1u, opt.node_count / 8) },
+    };
+
+    bool has_failed = false;
+    std::mt19937_64 rng { opt.seed };
+    cr::out().log("{} worker threads, {} update{}", cctx.get_thread_count(), opt.incremental ? "incremental" : "full",
+                  opt.transform_store ? ", transform store" : "");
+    cr::out().log("hierarchy | entities | levels | single-thread (ms) | tasked (ms) | speedup");
+    for (const tree_desc_t& desc : trees)
+    {
+      benchmark_tree tree { opt, desc.depth, rng };
+
+      const auto [st_time, st_count] = tree.time_update(nullptr, opt, rng);
+      const std::vector<hydra::transform> st_results = tree.get_world_transforms();
+      const auto [mt_time, mt_count] = tree.time_update(&cctx, opt, rng);
+      const std::vector<hydra::transform> mt_results = tree.get_world_transforms();
+
+      cr::out().log("{:9} | {:8} | {:6} | {:18.3f} | {:11.3f} | {:7.2f}", desc.name, tree.get_entity_count(), tree.get_level_count(),
+                    st_time * 1000, mt_time * 1000, mt_time > 0 ? st_time / mt_time : 0.0);
+
+      if (!opt.incremental && st_count != mt_count)
+      {
+        cr::out().error("{}: the single-threaded update visited {} entities, the tasked one {}", desc.name, st_count, mt_count);
+        has_failed = true;
+      }
+      if (const uint32_t mismatches = count_mismatches(st_results, mt_results); mismatches > 0)
+      {
+        cr::out().error("{}: {} world transforms differ between the single-threaded and the tasked update", desc.name, mismatches);
+        has_failed = true;
+      }
+    }
+    return !has_failed;
+  }
+
+  int run(int argc, char** argv)
+  {
+    hierarchy_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    if (opt.iterations < 1)
+      opt.iterations = 1;
+    if (opt.node_count < 1)
+      opt.node_count = 1;
+
+    neam::hydra::engine_t engine;
+
+    neam::hydra::engine_settings_t settings = engine.get_engine_settings();
+    settings.thread_count = opt.thread_count;
+    engine.set_engine_settings(settings);
+
+    engine.init(neam::hydra::runtime_mode::core | neam::hydra::runtime_mode::offline | neam::hydra::runtime_mode::packer_less | neam::hydra::runtime_mode::release);
+    hydra::core_context& cctx = engine.get_core_context();
+
+    // the tasked update must be called from a task: run the benchmark in a task of the first frame
+    bool has_succeeded = false;
+    bool has_started = false;
+    auto* core = engine.get_module<hydra::core_module>("core"_rid);
+    cr::event_token_t on_frame_end_tk;
+    on_frame_end_tk = core->on_frame_end.add([&]
+    {
+      if (std::exchange(has_started, true))
+        return;
+      cctx.tm.get_task([&]
+      {
+        // (the next frame cannot end before this task is done)
+        on_frame_end_tk.release();
+        has_succeeded = run_benchmark(cctx, opt);
+        cctx.stop_app();
+      });
+    });
+
+    engine.boot({.mode = neam::hydra::index_boot_parameters_t::init_empty_index, .index_key = "hierarchy_benchmark"_rid, .argv0 = argv[0]});
+
+    // make the main thread participate in the task manager
+    cctx.enroll_main_thread();
+
+    return has_succeeded ? 0 : 1;
+  }
+
+  raii_register_benchmark _register { "hierarchy", "tasked against single-threaded hierarchical update of the universe", &run };
+}
@@ -0,0 +1,270 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include <hydra/engine/engine.hpp>
+#include <hydra/imgui/imgui_geometry_ring.hpp>
+#include <hydra/utilities/transfer_context.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct imgui_geometry_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t frame_count = 500;
+    uint32_t window_count = 24;
+    uint32_t row_count = 64;
+    uint32_t column_count = 6;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::imgui_geometry_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(frame_count, neam::metadata::info{.description = c_string_t<"Number of frames measured for each path.">}),
+    N_MEMBER_DEF(window_count, neam::metadata::info{.description = c_string_t<"Number of windows of the scene.">}),
+    N_MEMBER_DEF(row_count, neam::metadata::info{.description = c_string_t<"Number of rows of the table of each window.">}),
+    N_MEMBER_DEF(column_count, neam::metadata::info{.description = c_string_t<"Number of columns of the table of each window.">})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Build a heavy imgui scene (many windows with text, tables and widgets) in a headless imgui context,
+// then measure the cpu time per frame of getting its geometry in gpu-visible memory:
+//  - ring: the draw lists are written directly in the persistently mapped geometry ring (the current render pass)
+//  - buffers + raw_data + staging ring: two short-lived buffers are created, the draw lists are copied in raw_data,
+//    which are then copied in the staging ring (the render pass before the geometry ring)
+//  - buffers + raw_data + dedicated staging: same, but with a dedicated staging buffer per upload (before the staging ring)
+// The gpu side (the copy commands of the two last paths) is not measured: nothing is submitted.
+// The memory of a frame is kept alive for k_frames_in_flight frames, like the dfe would.
+
+namespace
+{
+  /// \brief Frames kept alive. Leaves one region of the ring free, so the ring never has to grow because of the gpu.
+  constexpr uint32_t k_frames_in_flight = hydra::imgui::geometry_ring::k_region_count - 1;
+
+  enum class geometry_path
+  {
+    ring,
+    buffers_staging_ring,
+    buffers_dedicated_staging,
+  };
+
+  void print_timings(const char* name, samples_t& times)
+  {
+    cr::out().log("{:40} | {:9.1f} | {:9.1f} | {:9.1f} | {:9.1f}", name, times.get_average(), times.get_percentile(50),
+                  times.get_percentile(99), times.get_max());
+  }
+
+  /// \brief What the render pass used to keep alive until the end of the frame
+  struct legacy_frame_t
+  {
+    std::vector<hydra::buffer_holder> buffers;
+    std::vector<hydra::transfer_context::staging_memory> staging;
+  };
+
+  void build_scene(const imgui_geometry_options& opt, uint32_t frame)
+  {
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+    for (uint32_t w = 0; w < opt.window_count; ++w)
+    {
+      // cascade the windows so that most of their content is visible (hidden content does not generate geometry)
+      ImGui::SetNextWindowPos({ (float)(w % 8) * display_size.x / 16, (float)(w / 8 % 4) * display_size.y / 8 }, ImGuiCond_Always);
+      ImGui::SetNextWindowSize({ display_size.x / 2, display_size.y / 2 }, ImGuiCond_Always);
+      char title[32];
+      snprintf(title, sizeof(title), "window #%u", w);
+      if (ImGui::Begin(title))
+      {
+        ImGui::Text("frame %u, window %u: %u rows, %u columns", frame, w, opt.row_count, opt.column_count);
+        ImGui::ProgressBar((float)(frame % 100) / 100.0f);
+        ImGui::Button("button");
+        ImGui::SameLine();
+        ImGui::Button("another button");
+        ImGui::Separator();
+        if (ImGui::BeginTable("table", (int)opt.column_count, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+        {
+          for (uint32_t r = 0; r < opt.row_count; ++r)
+          {
+            ImGui::TableNextRow();
+            for (uint32_t c = 0; c < opt.column_count; ++c)
+            {
+              ImGui::TableNextColumn();
+              ImGui::Text("%u:%u [%u]", r, c, (frame + r * c) % 1000);
+            }
+          }
+          ImGui::EndTable();
+        }
+      }
+      ImGui::End();
+    }
+  }
+
+  const ImDrawData& render_frame(const imgui_geometry_options& opt, uint32_t frame, samples_t& imgui_timings)
+  {
+    const clock::time_point start = clock::now();
+    ImGui::NewFrame();
+    build_scene(opt, frame);
+    ImGui::Render();
+    imgui_timings.add(get_elapsed(start) * 1e6);
+    return *ImGui::GetDrawData();
+  }
+
+  void copy_draw_lists(const ImDrawData& draw_data, ImDrawVert* it_vtx_dst, ImDrawIdx* it_idx_dst)
+  {
+    for (int n = 0; n < draw_data.CmdListsCount; n++)
+    {
+      const ImDrawList* cmd_list = draw_data.CmdLists[n];
+      memcpy(it_vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+      memcpy(it_idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+      it_vtx_dst += cmd_list->VtxBuffer.Size;
+      it_idx_dst += cmd_list->IdxBuffer.Size;
+    }
+  }
+
+  /// \brief What the render pass did before the geometry ring (transfer_context::transfer(buffer, raw_data&&) copies the raw_data in staging memory)
+  legacy_frame_t upload_legacy(hydra::hydra_context& hctx, hydra::transfer_context& tc, const ImDrawData& draw_data)
+  {
+    const size_t vertex_size = draw_data.TotalVtxCount * sizeof(ImDrawVert);
+    const size_t index_size = draw_data.TotalIdxCount * sizeof(ImDrawIdx);
+
+    legacy_frame_t ret;
+    ret.buffers.emplace_back(hctx.allocator, hydra::vk::buffer(hctx.device, vertex_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT), hydra::allocation_type::short_lived);
+    ret.buffers.emplace_back(hctx.allocator, hydra::vk::buffer(hctx.device, index_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT), hydra::allocation_type::short_lived);
+
+    raw_data vtx_dst = raw_data::allocate(vertex_size);
+    raw_data idx_dst = raw_data::allocate(index_size);
+    copy_draw_lists(draw_data, (ImDrawVert*)vtx_dst.get(), (ImDrawIdx*)idx_dst.get());
+
+    for (const raw_data* it : { &vtx_dst, &idx_dst })
+    {
+      hydra::transfer_context::staging_memory& staging = ret.staging.emplace_back(tc.allocate_staging(it->size));
+      memcpy(staging.data().data(), it->get(), it->size);
+    }
+    return ret;
+  }
+
+  void run_path(hydra::hydra_context& hctx, const imgui_geometry_options& opt, geometry_path path, const char* name)
+  {
+    samples_t imgui_timings;
+    samples_t geometry_timings;
+
+    hydra::imgui::geometry_ring ring { hctx };
+    std::deque<hydra::imgui::geometry_ring::allocation> ring_frames;
+
+    hydra::transfer_context tc { hctx };
+    tc.debug_context = "imgui_geometry_benchmark";
+    tc._set_use_staging_ring(path != geometry_path::buffers_dedicated_staging);
+    std::deque<legacy_frame_t> legacy_frames;
+
+    size_t geometry_size = 0;
+    for (uint32_t frame = 0; frame < opt.frame_count; ++frame)
+    {
+      const ImDrawData& draw_data = render_frame(opt, frame, imgui_timings);
+      geometry_size = std::max<size_t>(geometry_size, draw_data.TotalVtxCount * sizeof(ImDrawVert) + draw_data.TotalIdxCount * sizeof(ImDrawIdx));
+
+      // end of the oldest frame:
+      if (ring_frames.size() == k_frames_in_flight)
+      {
+        hydra::imgui::geometry_ring::release(std::move(ring_frames.front()));
+        ring_frames.pop_front();
+      }
+      if (legacy_frames.size() == k_frames_in_flight)
+        legacy_frames.pop_front();
+
+      const clock::time_point start = clock::now();
+      if (path == geometry_path::ring)
+        ring_frames.push_back(ring.write(draw_data));
+      else
+        legacy_frames.push_back(upload_legacy(hctx, tc, draw_data));
+      geometry_timings.add(get_elapsed(start) * 1e6);
+    }
+
+    for (hydra::imgui::geometry_ring::allocation& it : ring_frames)
+      hydra::imgui::geometry_ring::release(std::move(it));
+
+    cr::out().debug("{}: up to {:.1f} KiB of geometry per frame", name, geometry_size / 1024.0);
+    if (path == geometry_path::ring)
+    {
+      cr::out().debug("{}: ring created/grown {} times, {} KiB per region", name, ring.get_growth_count(), ring.get_region_size() / 1024);
+      print_timings("imgui frame (NewFrame -> Render)", imgui_timings);
+    }
+    print_timings(name, geometry_timings);
+  }
+
+  int run(int argc, char** argv)
+  {
+    imgui_geometry_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    opt.frame_count = std::max(1u, opt.frame_count);
+    opt.column_count = std::max(1u, opt.column_count);
+
+    neam::hydra::engine_t engine;
+    if (engine.init(neam::hydra::runtime_mode::hydra_context | neam::hydra::runtime_mode::offscreen | neam::hydra::runtime_mode::offline
+                    | neam::hydra::runtime_mode::packer_less | neam::hydra::runtime_mode::release) == resources::status::failure)
+    {
+      cr::out().error("failed to create the vulkan device");
+      return 2;
+    }
+    hydra::hydra_context& hctx = engine.get_hydra_context();
+
+    headless_imgui_context imgui_context;
+
+    cr::out().log("{} windows, {}x{} tables, {} frames (times in us)", opt.window_count, opt.row_count, opt.column_count, opt.frame_count);
+    cr::out().log("{:40} | {:>9} | {:>9} | {:>9} | {:>9}", "path", "avg", "p50", "p99", "max");
+    run_path(hctx, opt, geometry_path::ring, "ring");
+    run_path(hctx, opt, geometry_path::buffers_staging_ring, "buffers + raw_data + staging ring");
+    run_path(hctx, opt, geometry_path::buffers_dedicated_staging, "buffers + raw_data + dedicated staging");
+
+    const hydra::staging_ring::stats_t stats = hctx.staging.get_stats();
+    if (stats.live_allocations != 0)
+    {
+      cr::out().error("staging ring: {} allocations are still alive after the benchmark", stats.live_allocations);
+      return 1;
+    }
+    return 0;
+  }
+
+  raii_register_benchmark _register { "imgui_geometry", "imgui geometry upload: ring buffer against per-frame buffers", &run };
+}
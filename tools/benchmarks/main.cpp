@@ -0,0 +1,69 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <vector>
+
+#include "harness.hpp"
+
+using namespace neam;
+
+// Runs one of the benchmarks / tests registered with raii_register_benchmark:
+//   hydra_benchmarks [benchmark] [options of the benchmark]
+
+namespace neam::benchmarks
+{
+  std::vector<benchmark_t>& get_benchmarks()
+  {
+    static std::vector<benchmark_t> benchmarks;
+    return benchmarks;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  cr::get_global_logger().min_severity = cr::logger::severity::message;
+  cr::get_global_logger().register_callback(cr::print_log_to_console, nullptr);
+
+  std::vector<benchmarks::benchmark_t>& list = benchmarks::get_benchmarks();
+  std::sort(list.begin(), list.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+
+  const std::string_view name = argc > 1 ? std::string_view { argv[1] } : std::string_view {};
+  const auto it = std::find_if(list.begin(), list.end(), [name](const auto& b) { return b.name == name; });
+  if (it == list.end())
+  {
+    if (!name.empty())
+      cr::out().error("unknown benchmark: {}", name);
+    cr::out().warn("usage: {} [benchmark] [options] (use --help after the name of a benchmark to list its options)", argv[0]);
+    cr::out().log("possible benchmarks:");
+    for (const benchmarks::benchmark_t& b : list)
+      cr::out().log("  {:18}: {}", b.name, b.description);
+    return 1;
+  }
+
+  // the benchmark sees its name as argv[0]:
+  return it->run(argc - 1, argv + 1);
+}
@@ -0,0 +1,237 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <hydra/engine/engine.hpp>
+#include <hydra/resources/network/server.hpp>
+#include <hydra/resources/network/client.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct network_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t port = 43210;
+    uint32_t latency_samples = 1000;
+    uint32_t max_resources = 0;
+    uint32_t thread_count = std::thread::hardware_concurrency();
+
+    std::vector<std::string_view> parameters;
+
+    // extra: (from parameters)
+    id_t index_key = id_t::none;
+    std::filesystem::path index;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::network_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(port, neam::metadata::info{.description = c_string_t<"Loopback port used by the in-process server.">}),
+    N_MEMBER_DEF(latency_samples, neam::metadata::info{.description = c_string_t<"Number of sequential has_resource requests used to measure the latency.">}),
+    N_MEMBER_DEF(max_resources, neam::metadata::info{.description = c_string_t<"Maximum number of resources read for the throughput test (0 for all the data resources of the index).">}),
+    N_MEMBER_DEF(thread_count, neam::metadata::info{.description = c_string_t<"Number of thread the task manager will launch.">})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Boot an in-process resource server and a client connected to it over the loopback,
+// then measure the request latency (sequential has_resource) and the read throughput (pipelined read_raw_resource)
+
+namespace
+{
+  /// \brief Wait for the flag while sending the pending stream packets of the server
+  void wait_for(resources::network::server& srv, const std::atomic<bool>& flag)
+  {
+    while (!flag.load(std::memory_order_acquire))
+    {
+      srv.update();
+      std::this_thread::yield();
+    }
+  }
+
+  double to_mbps(uint64_t size, double time)
+  {
+    return time > 0 ? (double)size / (1024.0 * 1024.0) / time : 0;
+  }
+
+  void run_benchmark(const network_options& opt, hydra::core_context& cctx)
+  {
+    resources::network::server srv { cctx.res };
+    if (!srv.listen((uint16_t)opt.port, "127.0.0.1"))
+      return;
+
+    resources::network::client cl { cctx.io };
+    {
+      std::atomic<bool> done = false;
+      resources::status st = resources::status::failure;
+      cl.connect("127.0.0.1", (uint16_t)opt.port).then([&](resources::status s)
+      {
+        st = s;
+        done.store(true, std::memory_order_release);
+      });
+      wait_for(srv, done);
+      if (st == resources::status::failure)
+      {
+        cr::out().error("failed to connect to the in-process server");
+        return;
+      }
+    }
+
+    std::vector<id_t> resources;
+    cctx.res.get_index().for_each_entry([&](const resources::index::entry& e)
+    {
+      if ((e.flags & resources::flags::type_mask) == resources::flags::type_data)
+        resources.push_back(e.id);
+    });
+    if (opt.max_resources > 0 && resources.size() > opt.max_resources)
+      resources.resize(opt.max_resources);
+    if (resources.empty())
+    {
+      cr::out().error("the index does not contain any data resource");
+      return;
+    }
+
+    // latency:
+    samples_t latencies;
+    for (uint32_t i = 0; i < opt.latency_samples; ++i)
+    {
+      std::atomic<bool> done = false;
+      const clock::time_point start = clock::now();
+      cl.has_resource(resources[i % resources.size()]).then([&](bool)
+      {
+        done.store(true, std::memory_order_release);
+      });
+      wait_for(srv, done);
+      latencies.add(get_elapsed(start) * 1e6);
+    }
+    if (!latencies.empty())
+    {
+      cr::out().log("latency (has_resource, {} samples): avg: {:.1f}us | p50: {:.1f}us | p99: {:.1f}us | max: {:.1f}us",
+                    latencies.size(), latencies.get_average(), latencies.get_percentile(50), latencies.get_percentile(99), latencies.get_max());
+    }
+
+    // throughput (all the requests are pipelined):
+    {
+      std::atomic<uint32_t> remaining = (uint32_t)resources.size();
+      std::atomic<uint32_t> failed = 0;
+      std::atomic<uint64_t> total_size = 0;
+      std::atomic<bool> done = false;
+      const clock::time_point start = clock::now();
+      for (const id_t rid : resources)
+      {
+        cl.read_raw_resource(rid).then([&](raw_data&& data, bool /*is_compressed*/, bool success)
+        {
+          if (!success)
+            ++failed;
+          total_size += data.size;
+          if (--remaining == 0)
+            done.store(true, std::memory_order_release);
+        });
+      }
+      wait_for(srv, done);
+      const double time = get_elapsed(start);
+      cr::out().log("throughput (read_raw_resource, {} resources, {} failed): {:.2f} MiB in {:.3f}s: {:.2f} MiB/s | {:.0f} requests/s",
+                    resources.size(), failed.load(), total_size / (1024.0 * 1024.0), time, to_mbps(total_size, time),
+                    time > 0 ? resources.size() / time : 0.0);
+    }
+
+    const auto cl_stats = cl.get_stats();
+    const auto srv_stats = srv.get_stats();
+    cr::out().log("client: {} requests, {} failed, {} bytes received | server: {} requests, {} failed, {} bytes sent",
+                  cl_stats.request_count, cl_stats.failed_request_count, cl_stats.received_bytes,
+                  srv_stats.request_count, srv_stats.failed_request_count, srv_stats.sent_bytes);
+
+    cl.disconnect();
+    srv.stop();
+  }
+
+  int run(int argc, char** argv)
+  {
+    network_options opt;
+    if (!parse_options(argc, argv, opt, 2, "[index_key] [index_file]"))
+      return 1;
+
+    opt.index_key = string_id::_runtime_build_from_string(opt.parameters[0].data(), opt.parameters[0].size());
+    opt.index = opt.parameters[1].data();
+    if (!std::filesystem::exists(opt.index))
+    {
+      cr::out().error("Specified index {} does not exist", opt.index.c_str());
+      return 2;
+    }
+
+    neam::hydra::engine_t engine;
+
+    neam::hydra::engine_settings_t settings = engine.get_engine_settings();
+    settings.thread_count = std::max(2u, opt.thread_count);
+    engine.set_engine_settings(settings);
+
+    engine.init(neam::hydra::runtime_mode::core | neam::hydra::runtime_mode::packer_less | neam::hydra::runtime_mode::release);
+    hydra::core_context& cctx = engine.get_core_context();
+
+    // the benchmark runs on its own thread, as it waits for the requests to complete
+    std::thread benchmark_thread;
+    engine.boot({.index_key = opt.index_key, .index_file = opt.index, .argv0 = argv[0]})
+    .then([&](resources::status st)
+    {
+      if (st == resources::status::failure)
+      {
+        cr::out().error("failed to load index {}", opt.index.c_str());
+        cctx.stop_app();
+        return;
+      }
+      benchmark_thread = std::thread([&]
+      {
+        run_benchmark(opt, cctx);
+        cctx.stop_app();
+      });
+    });
+
+    // make the main thread participate in the task manager
+    cctx.enroll_main_thread();
+
+    if (benchmark_thread.joinable())
+      benchmark_thread.join();
+    return 0;
+  }
+
+  raii_register_benchmark _register { "network", "loopback throughput and latency of the resource server", &run };
+}
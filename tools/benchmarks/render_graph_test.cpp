@@ -0,0 +1,496 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <hydra/renderer/render_graph_compiler.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct render_graph_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t graph_count = 64;
+    uint32_t pass_count = 48;
+    uint32_t seed = 42;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::render_graph_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(graph_count, neam::metadata::info{.description = c_string_t<"Number of random graphs used to check the placement of the transient resources.">}),
+    N_MEMBER_DEF(pass_count, neam::metadata::info{.description = c_string_t<"Number of passes of each random graph.">}),
+    N_MEMBER_DEF(seed, neam::metadata::info{.description = c_string_t<"Seed of the random graphs.">})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Build small synthetic graphs with the device-independent part of the render graph and check its output:
+//  - culling: passes whose results are not consumed are removed, outputs and side-effects are kept
+//  - barriers: the expected layout transitions / write->read barriers are emitted, redundant ones are elided,
+//    and queue family ownership transfers are generated (with the cross-queue dependencies)
+//  - aliasing: transient resources that share memory have disjoint lifetimes, and the first user of the memory waits for the previous ones
+// No vulkan device is needed.
+
+namespace
+{
+  using compiler_t = hydra::renderer::render_graph_compiler;
+  using hydra::renderer::rg_resource;
+  using hydra::renderer::k_invalid_rg_resource;
+
+  constexpr uint32_t k_graphics_family = 0;
+  constexpr uint32_t k_compute_family = 1;
+
+  const compiler_t::usage_t k_color_write { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+  const compiler_t::usage_t k_fragment_read { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+  const compiler_t::usage_t k_compute_read { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+  const compiler_t::usage_t k_storage_write { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT };
+  const compiler_t::usage_t k_storage_read { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT };
+
+  class test_context
+  {
+    public:
+      template<typename... Args>
+      void check(bool cond, fmt::format_string<Args...> str, Args&&... args)
+      {
+        ++check_count;
+        if (cond)
+          return;
+        ++failure_count;
+        cr::out().error("{}: {}", test_name, fmt::format(str, std::forward<Args>(args)...));
+      }
+
+      void begin(const char* name)
+      {
+        test_name = name;
+        cr::out().debug("running {}...", name);
+      }
+
+      uint32_t check_count = 0;
+      uint32_t failure_count = 0;
+
+    private:
+      const char* test_name = "";
+  };
+
+  const compiler_t::barrier_t* find_barrier(const compiler_t::barrier_list_t& list, rg_resource res)
+  {
+    for (const compiler_t::barrier_t& it : list.images)
+    {
+      if (it.res == res)
+        return &it;
+    }
+    for (const compiler_t::barrier_t& it : list.buffers)
+    {
+      if (it.res == res)
+        return &it;
+    }
+    return nullptr;
+  }
+
+  bool contains(const std::vector<uint32_t>& list, uint32_t value)
+  {
+    return std::find(list.begin(), list.end(), value) != list.end();
+  }
+
+  /// \brief Give the same memory requirements to every used transient resource, and place them
+  compiler_t::transient_heap_t place_all(compiler_t& compiler, size_t size, size_t alignment, uint32_t memory_type_bits)
+  {
+    std::vector<rg_resource> list;
+    for (rg_resource i = 0; i < compiler.get_resource_count(); ++i)
+    {
+      if (!compiler.get_resource(i).is_transient || !compiler.get_resource(i).is_used())
+        continue;
+      compiler.set_memory_requirements(i, { .size = size, .alignment = alignment, .memoryTypeBits = memory_type_bits });
+      list.push_back(i);
+    }
+    return compiler.place_transients(list);
+  }
+
+  void test_culling(test_context& ctx)
+  {
+    ctx.begin("culling");
+    compiler_t compiler;
+    const uint32_t gfx = compiler.add_queue(k_graphics_family);
+
+    const rg_resource unused_a = compiler.add_transient_resource("unused-a", true);
+    const rg_resource unused_b = compiler.add_transient_resource("unused-b", false);
+    const rg_resource output = compiler.add_transient_resource("output", true);
+    const rg_resource side_effect_target = compiler.add_transient_resource("side-effect-target", false);
+    const rg_resource imported = compiler.add_imported_resource("imported", false, false, gfx, { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT });
+    compiler.mark_output(output);
+
+    // chain that nothing consumes
+    const uint32_t chain_0 = compiler.add_pass("chain-0", gfx);
+    compiler.add_access(chain_0, unused_a, k_color_write, true);
+    const uint32_t chain_1 = compiler.add_pass("chain-1", gfx);
+    compiler.add_access(chain_1, unused_a, k_compute_read, false);
+    compiler.add_access(chain_1, unused_b, k_storage_write, true);
+
+    // consumed by a kept pass
+    const uint32_t producer = compiler.add_pass("producer", gfx);
+    compiler.add_access(producer, side_effect_target, k_storage_write, true);
+    const uint32_t write_output = compiler.add_pass("write-output", gfx);
+    compiler.add_access(write_output, side_effect_target, k_storage_read, false);
+    compiler.add_access(write_output, output, k_color_write, true);
+
+    const uint32_t side_effect = compiler.add_pass("side-effect", gfx);
+    compiler.add_access(side_effect, unused_b, k_storage_write, true);
+    compiler.set_has_side_effects(side_effect);
+
+    const uint32_t write_imported = compiler.add_pass("write-imported", gfx);
+    compiler.add_access(write_imported, imported, k_storage_write, true);
+
+    compiler.cull_passes();
+
+    ctx.check(compiler.get_pass(chain_0).culled, "chain-0 should be culled");
+    ctx.check(compiler.get_pass(chain_1).culled, "chain-1 should be culled");
+    ctx.check(!compiler.get_pass(producer).culled, "producer should be kept (read by a kept pass)");
+    ctx.check(!compiler.get_pass(write_output).culled, "write-output should be kept (writes to an output)");
+    ctx.check(!compiler.get_pass(side_effect).culled, "side-effect should be kept (has side effects)");
+    ctx.check(!compiler.get_pass(write_imported).culled, "write-imported should be kept (imported resources are outputs)");
+    ctx.check(compiler.get_stats().culled_pass_count == 2, "expected 2 culled passes, got {}", compiler.get_stats().culled_pass_count);
+
+    // lifetimes only account for the kept passes
+    ctx.check(!compiler.get_resource(unused_a).is_used(), "unused-a should not be used by any kept pass");
+    ctx.check(compiler.get_resource(unused_b).first_pass == side_effect && compiler.get_resource(unused_b).last_pass == side_effect,
+              "unused-b should only live during side-effect");
+    ctx.check(compiler.get_resource(side_effect_target).first_pass == producer && compiler.get_resource(side_effect_target).last_pass == write_output,
+              "side-effect-target should live from producer to write-output");
+  }
+
+  void test_barriers(test_context& ctx)
+  {
+    ctx.begin("barriers");
+    compiler_t compiler;
+    const uint32_t gfx = compiler.add_queue(k_graphics_family);
+
+    const rg_resource image = compiler.add_transient_resource("image", true);
+    const rg_resource buffer = compiler.add_transient_resource("buffer", false);
+
+    const uint32_t write = compiler.add_pass("write", gfx);
+    compiler.add_access(write, image, k_color_write, true);
+    compiler.add_access(write, buffer, k_storage_write, true);
+    const uint32_t read_0 = compiler.add_pass("read-0", gfx);
+    compiler.add_access(read_0, image, k_fragment_read, false);
+    compiler.add_access(read_0, buffer, k_storage_read, false);
+    compiler.set_has_side_effects(read_0);
+    const uint32_t read_1 = compiler.add_pass("read-1", gfx);
+    compiler.add_access(read_1, image, k_fragment_read, false);
+    compiler.add_access(read_1, buffer, k_storage_read, false);
+    compiler.set_has_side_effects(read_1);
+
+    compiler.cull_passes();
+    place_all(compiler, 1024, 256, 1);
+    compiler.generate_barriers();
+    compiler.return_imported_resources();
+
+    // first use: transition from undefined, nothing to wait for
+    const compiler_t::barrier_t* b = find_barrier(compiler.get_pass(write).barriers, image);
+    ctx.check(b != nullptr, "write: missing the initial layout transition of image");
+    if (b != nullptr)
+    {
+      ctx.check(b->old_layout == VK_IMAGE_LAYOUT_UNDEFINED && b->new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                "write: image should go from undefined to color-attachment (got {} -> {})", (int)b->old_layout, (int)b->new_layout);
+      ctx.check(b->src.stage == VK_PIPELINE_STAGE_2_NONE, "write: the initial transition should not wait for anything");
+    }
+    ctx.check(find_barrier(compiler.get_pass(write).barriers, buffer) == nullptr, "write: the first use of a non-aliased buffer does not need a barrier");
+
+    // write -> read
+    b = find_barrier(compiler.get_pass(read_0).barriers, image);
+    ctx.check(b != nullptr, "read-0: missing the write -> read barrier of image");
+    if (b != nullptr)
+    {
+      ctx.check(b->old_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL && b->new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                "read-0: image should go from color-attachment to shader-read-only (got {} -> {})", (int)b->old_layout, (int)b->new_layout);
+      ctx.check(b->src.stage == k_color_write.stage && b->src.access == k_color_write.access, "read-0: image barrier should wait for the color attachment write");
+      ctx.check(b->dst.stage == k_fragment_read.stage && b->dst.access == k_fragment_read.access, "read-0: image barrier should make the write visible to the fragment shader");
+      ctx.check(b->src_family == VK_QUEUE_FAMILY_IGNORED && b->dst_family == VK_QUEUE_FAMILY_IGNORED, "read-0: no ownership transfer on a single queue");
+    }
+    b = find_barrier(compiler.get_pass(read_0).barriers, buffer);
+    ctx.check(b != nullptr, "read-0: missing the write -> read barrier of buffer");
+    if (b != nullptr)
+      ctx.check(b->src.access == k_storage_write.access && b->dst.access == k_storage_read.access, "read-0: buffer barrier has the wrong accesses");
+
+    // the same read again: already visible
+    ctx.check(compiler.get_pass(read_1).barriers.empty(), "read-1: the repeated read should not emit any barrier");
+    ctx.check(compiler.get_stats().elided_barrier_count == 2, "expected 2 elided barriers, got {}", compiler.get_stats().elided_barrier_count);
+    ctx.check(compiler.get_stats().image_barrier_count == 2 && compiler.get_stats().buffer_barrier_count == 1,
+              "expected 2 image barriers and 1 buffer barrier, got {} and {}", compiler.get_stats().image_barrier_count, compiler.get_stats().buffer_barrier_count);
+  }
+
+  void test_queue_ownership(test_context& ctx)
+  {
+    ctx.begin("queue-ownership");
+    compiler_t compiler;
+    const uint32_t gfx = compiler.add_queue(k_graphics_family);
+    const uint32_t compute = compiler.add_queue(k_compute_family);
+
+    const rg_resource image = compiler.add_transient_resource("image", true);
+    const rg_resource imported = compiler.add_imported_resource("imported", false, true, gfx, { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT });
+
+    const uint32_t render = compiler.add_pass("render", gfx);
+    compiler.add_access(render, image, k_color_write, true);
+    const uint32_t process = compiler.add_pass("process", compute);
+    compiler.add_access(process, image, k_compute_read, false);
+    compiler.add_access(process, imported, k_storage_write, true);
+
+    compiler.cull_passes();
+    place_all(compiler, 1024, 256, 1);
+    compiler.generate_barriers();
+    compiler.return_imported_resources();
+
+    ctx.check(!compiler.get_pass(render).culled && !compiler.get_pass(process).culled, "no pass should be culled");
+
+    // transient image: released after render, acquired before process
+    const compiler_t::barrier_t* release = find_barrier(compiler.get_pass(render).release_barriers, image);
+    const compiler_t::barrier_t* acquire = find_barrier(compiler.get_pass(process).barriers, image);
+    ctx.check(release != nullptr, "render: missing the release of image");
+    ctx.check(acquire != nullptr, "process: missing the acquire of image");
+    if (release != nullptr && acquire != nullptr)
+    {
+      ctx.check(release->src_family == k_graphics_family && release->dst_family == k_compute_family, "render: the release of image has the wrong queue families");
+      ctx.check(acquire->src_family == k_graphics_family && acquire->dst_family == k_compute_family, "process: the acquire of image has the wrong queue families");
+      ctx.check(release->old_layout == acquire->old_layout && release->new_layout == acquire->new_layout, "the layouts of the release and the acquire of image must match");
+      ctx.check(release->src.stage == k_color_write.stage && acquire->dst.stage == k_compute_read.stage, "release / acquire of image have the wrong stages");
+    }
+    ctx.check(contains(compiler.get_pass(process).wait_passes, render), "process should wait for render (different queues)");
+
+    // imported buffer: acquired from its owner in a prologue, then given back in an epilogue
+    const auto& prologues = compiler.get_prologues();
+    ctx.check(prologues.contains(gfx) && find_barrier(prologues.at(gfx), imported) != nullptr, "missing the prologue release of imported");
+    ctx.check(contains(compiler.get_pass(process).wait_prologues, gfx), "process should wait for the prologue of the graphics queue");
+    ctx.check(find_barrier(compiler.get_pass(process).barriers, imported) != nullptr, "process: missing the acquire of imported");
+
+    const auto& epilogues = compiler.get_epilogues();
+    ctx.check(find_barrier(compiler.get_pass(process).release_barriers, imported) != nullptr, "process: missing the release of imported to its owner");
+    ctx.check(epilogues.contains(gfx) && find_barrier(epilogues.at(gfx).barriers, imported) != nullptr, "missing the epilogue acquire of imported");
+    ctx.check(epilogues.contains(gfx) && contains(epilogues.at(gfx).wait_passes, process), "the epilogue should wait for process");
+    ctx.check(compiler.get_resource(imported).queue == gfx, "imported should be back on its owner queue");
+
+    ctx.check(compiler.get_stats().queue_ownership_transfer_count == 3, "expected 3 ownership transfers, got {}", compiler.get_stats().queue_ownership_transfer_count);
+  }
+
+  /// \brief Check that the transient resources sharing memory have disjoint lifetimes,
+  /// and that the first use of a resource waits for the previous users of its memory
+  void check_aliasing(test_context& ctx, const compiler_t& compiler, const compiler_t::transient_heap_t& heap)
+  {
+    for (uint32_t i = 0; i < heap.resources.size(); ++i)
+    {
+      const compiler_t::resource_t& a = compiler.get_resource(heap.resources[i]);
+      ctx.check(a.memory_offset % a.requirements.alignment == 0, "{} is not aligned", a.name);
+      ctx.check(a.memory_offset + a.requirements.size <= heap.size, "{} is outside of the heap", a.name);
+
+      for (uint32_t j = i + 1; j < heap.resources.size(); ++j)
+      {
+        const compiler_t::resource_t& b = compiler.get_resource(heap.resources[j]);
+        const bool memory_overlap = a.memory_offset < b.memory_offset + b.requirements.size && b.memory_offset < a.memory_offset + a.requirements.size;
+        const bool lifetime_overlap = a.first_pass <= b.last_pass && b.first_pass <= a.last_pass;
+        ctx.check(!memory_overlap || !lifetime_overlap, "{} [{}, {}] and {} [{}, {}] share memory but their lifetimes overlap",
+                  a.name, a.first_pass, a.last_pass, b.name, b.first_pass, b.last_pass);
+        if (memory_overlap)
+        {
+          const compiler_t::resource_t& first = a.first_pass < b.first_pass ? a : b;
+          const compiler_t::resource_t& second = a.first_pass < b.first_pass ? b : a;
+          const rg_resource first_index = a.first_pass < b.first_pass ? heap.resources[i] : heap.resources[j];
+          ctx.check(contains(second.aliased_resources, first_index), "{} should know that {} previously used its memory", second.name, first.name);
+        }
+      }
+    }
+
+    for (rg_resource i : heap.resources)
+    {
+      const compiler_t::resource_t& res = compiler.get_resource(i);
+      if (res.aliased_resources.empty())
+        continue;
+      const compiler_t::barrier_t* b = find_barrier(compiler.get_pass(res.first_pass).barriers, i);
+      ctx.check(b != nullptr, "{}: missing the barrier on its first use (memory is aliased)", res.name);
+      if (b == nullptr)
+        continue;
+      for (rg_resource o : res.aliased_resources)
+      {
+        const compiler_t::resource_t& other = compiler.get_resource(o);
+        const VkPipelineStageFlags2 stages = other.last_write.stage | other.read_stages;
+        ctx.check((b->src.stage & stages) == stages, "{}: the first use does not wait for the previous user of its memory ({})", res.name, other.name);
+      }
+    }
+  }
+
+  void test_aliasing_chain(test_context& ctx)
+  {
+    ctx.begin("aliasing-chain");
+    compiler_t compiler;
+    const uint32_t gfx = compiler.add_queue(k_graphics_family);
+
+    // ping-pong chain: only two consecutive resources are alive at a given time
+    constexpr uint32_t k_length = 8;
+    rg_resource previous = k_invalid_rg_resource;
+    for (uint32_t i = 0; i < k_length; ++i)
+    {
+      const rg_resource res = compiler.add_transient_resource(fmt::format("chain-{}", i), true);
+      const uint32_t pass = compiler.add_pass(fmt::format("pass-{}", i), gfx);
+      if (previous != k_invalid_rg_resource)
+        compiler.add_access(pass, previous, k_fragment_read, false);
+      compiler.add_access(pass, res, k_color_write, true);
+      previous = res;
+    }
+    compiler.mark_output(previous);
+
+    compiler.cull_passes();
+    const compiler_t::transient_heap_t heap = place_all(compiler, 4096, 256, 0x3);
+    compiler.generate_barriers();
+
+    ctx.check(heap.resources.size() == k_length && heap.dedicated_resources.empty(), "every resource should be in the heap");
+    // (first-fit placement: the exact size depends on the placement order of same-size resources)
+    ctx.check(heap.size <= k_length / 2 * 4096, "the resources of the chain should share memory (got {} bytes)", heap.size);
+    ctx.check(compiler.get_stats().unaliased_transient_memory_size == k_length * 4096, "wrong unaliased memory size");
+    check_aliasing(ctx, compiler, heap);
+  }
+
+  void test_aliasing_random(test_context& ctx, const render_graph_options& opt)
+  {
+    ctx.begin("aliasing-random");
+    std::mt19937_64 rng { opt.seed };
+    size_t total_size = 0;
+    size_t total_unaliased_size = 0;
+
+    for (uint32_t g = 0; g < opt.graph_count; ++g)
+    {
+      compiler_t compiler;
+      const uint32_t gfx = compiler.add_queue(k_graphics_family);
+      const uint32_t compute = compiler.add_queue(k_compute_family);
+
+      std::vector<rg_resource> written;
+      for (uint32_t p = 0; p < opt.pass_count; ++p)
+      {
+        const bool is_compute = std::uniform_int_distribution<uint32_t>(0, 3)(rng) == 0;
+        const uint32_t pass = compiler.add_pass(fmt::format("pass-{}", p), is_compute ? compute : gfx);
+
+        // read a few of the previous results (more likely the recent ones)
+        const uint32_t read_count = written.empty() ? 0 : std::uniform_int_distribution<uint32_t>(0, 2)(rng);
+        for (uint32_t r = 0; r < read_count; ++r)
+        {
+          const uint32_t window = std::min<uint32_t>((uint32_t)written.size(), 6);
+          const rg_resource res = written[written.size() - 1 - std::uniform_int_distribution<uint32_t>(0, window - 1)(rng)];
+          if (compiler.get_resource(res).is_image)
+            compiler.add_access(pass, res, is_compute ? k_compute_read : k_fragment_read, false);
+          else
+            compiler.add_access(pass, res, k_storage_read, false);
+        }
+
+        const bool is_image = !is_compute && std::uniform_int_distribution<uint32_t>(0, 1)(rng) == 0;
+        const rg_resource res = compiler.add_transient_resource(fmt::format("res-{}", p), is_image);
+        compiler.add_access(pass, res, is_image ? k_color_write : k_storage_write, true);
+        written.push_back(res);
+
+        if (std::uniform_int_distribution<uint32_t>(0, 15)(rng) == 0)
+          compiler.set_has_side_effects(pass);
+      }
+      compiler.mark_output(written.back());
+
+      compiler.cull_passes();
+
+      std::vector<rg_resource> list;
+      for (rg_resource i = 0; i < compiler.get_resource_count(); ++i)
+      {
+        if (!compiler.get_resource(i).is_used())
+          continue;
+        const size_t size = size_t(256) << std::uniform_int_distribution<uint32_t>(0, 8)(rng);
+        const size_t alignment = size_t(256) << std::uniform_int_distribution<uint32_t>(0, 4)(rng);
+        // a few resources cannot share the heap memory type
+        const uint32_t memory_type_bits = std::uniform_int_distribution<uint32_t>(0, 31)(rng) == 0 ? 0x4 : 0x3;
+        compiler.set_memory_requirements(i, { .size = size, .alignment = alignment, .memoryTypeBits = memory_type_bits });
+        list.push_back(i);
+      }
+      const compiler_t::transient_heap_t heap = compiler.place_transients(list);
+      compiler.generate_barriers();
+      compiler.return_imported_resources();
+
+      ctx.check(heap.resources.size() + heap.dedicated_resources.size() == list.size(), "graph {}: some resources were not placed", g);
+      for (rg_resource i : heap.dedicated_resources)
+        ctx.check((compiler.get_resource(i).requirements.memoryTypeBits & heap.memory_type_bits) == 0, "graph {}: {} should be in the heap", g, compiler.get_resource(i).name);
+      check_aliasing(ctx, compiler, heap);
+
+      // every kept pass but the last ones must be consumed
+      for (uint32_t p = 0; p < compiler.get_pass_count(); ++p)
+      {
+        const compiler_t::pass_t& pass = compiler.get_pass(p);
+        if (pass.culled || pass.has_side_effects)
+          continue;
+        const compiler_t::resource_t& res = compiler.get_resource(written[p]);
+        ctx.check(res.is_output || res.last_pass > p, "graph {}: {} is kept but nothing reads {}", g, pass.name, res.name);
+      }
+
+      total_size += compiler.get_stats().transient_memory_size;
+      total_unaliased_size += compiler.get_stats().unaliased_transient_memory_size;
+    }
+
+    cr::out().log("aliasing-random: {} graphs: transient memory: {:.2f} MiB (without aliasing: {:.2f} MiB)",
+                  opt.graph_count, total_size / (1024.0 * 1024.0), total_unaliased_size / (1024.0 * 1024.0));
+  }
+
+  int run(int argc, char** argv)
+  {
+    render_graph_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    if (opt.pass_count < 1)
+      opt.pass_count = 1;
+
+    test_context ctx;
+    test_culling(ctx);
+    test_barriers(ctx);
+    test_queue_ownership(ctx);
+    test_aliasing_chain(ctx);
+    test_aliasing_random(ctx, opt);
+
+    if (ctx.failure_count > 0)
+    {
+      cr::out().error("{} / {} checks failed", ctx.failure_count, ctx.check_count);
+      return 1;
+    }
+    cr::out().log("all {} checks passed", ctx.check_count);
+    return 0;
+  }
+
+  raii_register_benchmark _register { "render_graph", "render graph compilation tests (culling, barriers, aliasing)", &run };
+}
@@ -0,0 +1,274 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <hydra/ecs/transform.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct transform_store_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t iterations = 10;
+    uint32_t node_count = 100000;
+    uint32_t seed = 42;
+    double tolerance = 1e-4;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::transform_store_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(iterations, neam::metadata::info{.description = c_string_t<"Number of times each computation is run (the best time is kept).">}),
+    N_MEMBER_DEF(node_count, neam::metadata::info{.description = c_string_t<"Number of transforms in each synthetic hierarchy.">}),
+    N_MEMBER_DEF(seed, neam::metadata::info{.description = c_string_t<"Seed of the random hierarchies / transforms.">}),
+    N_MEMBER_DEF(tolerance, neam::metadata::info{.description = c_string_t
+    <
+      "Maximum relative difference allowed between the AVX2 and the scalar path.\n"
+      "(rotations are stored as floats, so the error grows with the depth of the hierarchy)"
+    >})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Build random hierarchies in a transform_store, then check that the AVX2 path and the scalar path
+// (hydra::transform::multiply / compute_inverse) produce the same world transforms, and time both.
+// The per-node loop the store replaced (AoS transforms, multiply + compute_inverse for each node) is timed too.
+
+namespace
+{
+  struct node_t
+  {
+    hydra::ecs::transform_store::handle_t handle;
+    uint32_t parent; // index in the node list, ~0u for roots
+    hydra::transform local;
+  };
+
+  struct hierarchy_t
+  {
+    const char* name;
+    std::vector<node_t> nodes; // parents are always before their children
+  };
+
+  struct error_t
+  {
+    double translation = 0;
+    double rotation = 0;
+    double scale = 0;
+
+    double max() const { return std::max({translation, rotation, scale}); }
+  };
+
+  hydra::transform random_transform(std::mt19937_64& rng)
+  {
+    std::uniform_real_distribution<double> pos_dist(-1000.0, 1000.0);
+    std::normal_distribution<float> quat_dist(0.0f, 1.0f);
+    std::uniform_real_distribution<float> scale_dist(0.8f, 1.25f);
+
+    hydra::transform ret;
+    ret.translation = { pos_dist(rng), pos_dist(rng), pos_dist(rng) };
+    ret.rotation = glm::normalize(glm::quat { quat_dist(rng), quat_dist(rng), quat_dist(rng), quat_dist(rng) });
+    ret.scale = scale_dist(rng);
+    return ret;
+  }
+
+  /// \brief Each level has (roughly) the same number of nodes, parents are chosen at random in the previous level
+  hierarchy_t make_hierarchy(const char* name, uint32_t node_count, uint32_t depth, std::mt19937_64& rng)
+  {
+    hierarchy_t ret { .name = name };
+    ret.nodes.reserve(node_count);
+
+    const uint32_t width = std::max(1u, node_count / depth);
+    uint32_t previous_level_begin = 0;
+    for (uint32_t d = 0; d < depth; ++d)
+    {
+      const uint32_t level_begin = (uint32_t)ret.nodes.size();
+      const uint32_t count = (d + 1 == depth) ? std::max(1u, node_count - level_begin) : width;
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        uint32_t parent = ~0u;
+        if (d > 0)
+          parent = std::uniform_int_distribution<uint32_t>(previous_level_begin, level_begin - 1)(rng);
+        ret.nodes.push_back({ .parent = parent, .local = random_transform(rng) });
+      }
+      previous_level_begin = level_begin;
+    }
+    return ret;
+  }
+
+  /// \brief Random parents in the whole hierarchy (the depth of the nodes is not controlled)
+  hierarchy_t make_random_hierarchy(const char* name, uint32_t node_count, std::mt19937_64& rng)
+  {
+    hierarchy_t ret { .name = name };
+    ret.nodes.reserve(node_count);
+    for (uint32_t i = 0; i < node_count; ++i)
+    {
+      // ~1% of roots
+      uint32_t parent = ~0u;
+      if (i > 0 && std::uniform_int_distribution<uint32_t>(0, 99)(rng) != 0)
+        parent = std::uniform_int_distribution<uint32_t>(0, i - 1)(rng);
+      ret.nodes.push_back({ .parent = parent, .local = random_transform(rng) });
+    }
+    return ret;
+  }
+
+  void fill_store(hydra::ecs::transform_store& store, hierarchy_t& h)
+  {
+    for (node_t& node : h.nodes)
+    {
+      const hydra::ecs::transform_store::handle_t parent = node.parent == ~0u ? hydra::ecs::transform_store::handle_t{} : h.nodes[node.parent].handle;
+      node.handle = store.allocate(parent.is_valid() ? parent.depth + 1 : 0);
+      store.set_local(node.handle, node.local, parent);
+    }
+  }
+
+  /// \brief Best time of the computation of all the world transforms of the store
+  double time_store(hydra::ecs::transform_store& store, bool force_scalar, uint32_t iterations)
+  {
+    store._set_force_scalar(force_scalar);
+    double best_time = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+      store._mark_all_dirty();
+      const clock::time_point start = clock::now();
+      store.compute_world_transforms();
+      best_time = std::min(best_time, get_elapsed(start));
+    }
+    return best_time;
+  }
+
+  /// \brief Best time of the per-node computation (AoS, in hierarchy order)
+  double time_per_node(const hierarchy_t& h, uint32_t iterations)
+  {
+    std::vector<hydra::transform> world;
+    std::vector<hydra::transform> world_inverse;
+    world.resize(h.nodes.size());
+    world_inverse.resize(h.nodes.size());
+
+    return get_best_time(iterations, [&](uint32_t)
+    {
+      for (uint32_t j = 0; j < h.nodes.size(); ++j)
+      {
+        const node_t& node = h.nodes[j];
+        world[j] = node.parent == ~0u ? node.local : hydra::transform::multiply(world[node.parent], node.local);
+        world_inverse[j] = hydra::transform::compute_inverse(world[j]);
+      }
+    });
+  }
+
+  void accumulate_error(error_t& err, const hydra::transform& a, const hydra::transform& b)
+  {
+    const double magnitude = std::max(1.0, glm::length(a.translation));
+    err.translation = std::max(err.translation, glm::length(a.translation - b.translation) / magnitude);
+    // q and -q are the same rotation:
+    err.rotation = std::max(err.rotation, 1.0 - std::abs((double)glm::dot(a.rotation, b.rotation)));
+    err.scale = std::max(err.scale, std::abs((double)a.scale - (double)b.scale) / std::max(1.0, std::abs((double)a.scale)));
+  }
+
+  std::vector<std::pair<hydra::transform, hydra::transform>> get_results(const hydra::ecs::transform_store& store, const hierarchy_t& h)
+  {
+    std::vector<std::pair<hydra::transform, hydra::transform>> ret;
+    ret.reserve(h.nodes.size());
+    for (const node_t& node : h.nodes)
+      ret.emplace_back(store.get_world(node.handle), store.get_world_inverse(node.handle));
+    return ret;
+  }
+
+  int run(int argc, char** argv)
+  {
+    transform_store_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    if (opt.iterations < 1)
+      opt.iterations = 1;
+    if (opt.node_count < 1)
+      opt.node_count = 1;
+
+    if (!hydra::ecs::transform_store::has_simd_path())
+      cr::out().warn("the AVX2 path of the transform store is not available (not an x86 build, or the CPU does not support AVX2): both paths are the scalar one");
+
+    std::mt19937_64 rng { opt.seed };
+    std::vector<hierarchy_t> hierarchies;
+    hierarchies.push_back(make_hierarchy("wide", opt.node_count, 3, rng));
+    hierarchies.push_back(make_hierarchy("deep", opt.node_count, 64, rng));
+    hierarchies.push_back(make_random_hierarchy("random", opt.node_count, rng));
+
+    bool has_failed = false;
+    cr::out().log("hierarchy | nodes | depth | max world error | max inverse error | avx2 (ms) | scalar (ms) | per-node (ms) | scalar / avx2");
+    for (hierarchy_t& h : hierarchies)
+    {
+      hydra::ecs::transform_store store;
+      fill_store(store, h);
+
+      const double scalar_time = time_store(store, true, opt.iterations);
+      const auto scalar_results = get_results(store, h);
+      const double simd_time = time_store(store, false, opt.iterations);
+      const auto simd_results = get_results(store, h);
+      const double per_node_time = time_per_node(h, opt.iterations);
+
+      error_t world_error;
+      error_t inverse_error;
+      for (uint32_t i = 0; i < h.nodes.size(); ++i)
+      {
+        accumulate_error(world_error, scalar_results[i].first, simd_results[i].first);
+        accumulate_error(inverse_error, scalar_results[i].second, simd_results[i].second);
+      }
+      cr::out().debug("{}: world error: translation: {:.3e}, rotation: {:.3e}, scale: {:.3e}", h.name, world_error.translation, world_error.rotation, world_error.scale);
+      cr::out().debug("{}: inverse error: translation: {:.3e}, rotation: {:.3e}, scale: {:.3e}", h.name, inverse_error.translation, inverse_error.rotation, inverse_error.scale);
+
+      cr::out().log("{:9} | {:5} | {:5} | {:15.3e} | {:17.3e} | {:9.3f} | {:11.3f} | {:13.3f} | {:13.2f}", h.name, h.nodes.size(), store.get_depth_count(),
+                    world_error.max(), inverse_error.max(), simd_time * 1000, scalar_time * 1000, per_node_time * 1000,
+                    simd_time > 0 ? scalar_time / simd_time : 0.0);
+
+      if (world_error.max() > opt.tolerance || inverse_error.max() > opt.tolerance)
+      {
+        cr::out().error("{}: the AVX2 and the scalar paths differ by more than the tolerance ({:.3e})", h.name, opt.tolerance);
+        has_failed = true;
+      }
+    }
+
+    return has_failed ? 2 : 0;
+  }
+
+  raii_register_benchmark _register { "transform_store", "AVX2 against scalar world transform computation of the transform store", &run };
+}
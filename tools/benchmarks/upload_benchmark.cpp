@@ -0,0 +1,198 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <hydra/engine/engine.hpp>
+#include <hydra/utilities/transfer_context.hpp>
+
+#include "harness.hpp"
+
+namespace neam::benchmarks
+{
+  struct upload_options
+  {
+    // options
+    bool verbose = false;
+    bool help = false;
+
+    uint32_t iterations = 10;
+    uint32_t round_size = 32 * 1024 * 1024;
+
+    std::vector<std::string_view> parameters;
+  };
+}
+N_METADATA_STRUCT(neam::benchmarks::upload_options)
+{
+  using member_list = neam::ct::type_list
+  <
+    N_MEMBER_DEF(help, neam::metadata::info{.description = c_string_t<"Print this message and exit.">}),
+    N_MEMBER_DEF(verbose, neam::metadata::info{.description = c_string_t<"Show debug messages. May be extremly verbose.">}),
+
+    N_MEMBER_DEF(iterations, neam::metadata::info{.description = c_string_t<"Number of rounds of each measure (the best time is kept).">}),
+    N_MEMBER_DEF(round_size, neam::metadata::info{.description = c_string_t
+    <
+      "Number of bytes uploaded in a round (the staging memory of a round is released at its end, like a frame would).\n"
+      "Should be smaller than the ring size, or the ring will stall and fallback to dedicated staging buffers."
+    >})
+  >;
+};
+
+using namespace neam;
+using namespace neam::benchmarks;
+
+// Measure the cpu side of the uploads (getting writable staging memory and filling it) for the different transfer_context paths:
+//  - dedicated: the data is read in a raw_data, then copied in a staging buffer created for the upload (the path before the staging ring)
+//  - ring + raw_data: the data is read in a raw_data, then copied in the staging ring (transfer(..., raw_data&&))
+//  - ring direct: the data is written directly in the staging ring (allocate_staging() + transfer(..., staging_memory&&))
+// The gpu side (the copy commands) is the same for all the paths and is not measured: nothing is submitted.
+// The staging memory of a round is released at the end of the round, like the dfe would do at the end of a frame.
+
+namespace
+{
+  enum class upload_path
+  {
+    dedicated,
+    ring_raw_data,
+    ring_direct,
+  };
+
+  struct result_t
+  {
+    double time = 0; // best time of a round
+    uint32_t dedicated_count = 0; // staging memory that did not come from the ring (during the last round)
+  };
+
+  /// \brief Best time of a round of \p count uploads of \p size bytes
+  result_t time_uploads(hydra::transfer_context& tc, upload_path path, const std::vector<uint8_t>& source, uint32_t size, uint32_t count, uint32_t iterations)
+  {
+    tc._set_use_staging_ring(path != upload_path::dedicated);
+
+    result_t ret;
+    std::vector<hydra::transfer_context::staging_memory> uploads;
+    uploads.reserve(count);
+    ret.time = get_best_time(iterations, [&](uint32_t)
+    {
+      ret.dedicated_count = 0;
+      for (uint32_t j = 0; j < count; ++j)
+      {
+        const uint8_t* src = source.data() + (size_t)j * size % (source.size() - size + 1);
+        if (path == upload_path::ring_direct)
+        {
+          // the reader / decompressor writes its output directly in the staging memory
+          hydra::transfer_context::staging_memory& staging = uploads.emplace_back(tc.allocate_staging(size));
+          memcpy(staging.data().data(), src, size);
+        }
+        else
+        {
+          // the reader writes its output in a raw_data, which is then copied in the staging memory
+          raw_data data = raw_data::allocate(size);
+          memcpy(data.get(), src, size);
+          hydra::transfer_context::staging_memory& staging = uploads.emplace_back(tc.allocate_staging(size));
+          memcpy(staging.data().data(), data.get(), size);
+        }
+        if (!uploads.back().is_in_staging_ring())
+          ++ret.dedicated_count;
+      }
+      uploads.clear();
+    });
+    tc._set_use_staging_ring(true);
+    return ret;
+  }
+
+  bool run_benchmark(hydra::hydra_context& hctx, const upload_options& opt)
+  {
+    struct path_desc_t
+    {
+      const char* name;
+      upload_path path;
+    };
+    constexpr path_desc_t paths[] =
+    {
+      { "dedicated", upload_path::dedicated },
+      { "ring + raw_data", upload_path::ring_raw_data },
+      { "ring direct", upload_path::ring_direct },
+    };
+    constexpr uint32_t sizes[] = { 256, 4 * 1024, 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+
+    std::vector<uint8_t> source;
+    source.resize(std::max<size_t>(opt.round_size, sizes[std::size(sizes) - 1]));
+    for (size_t i = 0; i < source.size(); ++i)
+      source[i] = (uint8_t)(i * 2654435761u >> 24);
+
+    hydra::transfer_context tc { hctx };
+    tc.debug_context = "upload_benchmark";
+
+    cr::out().log("upload size | uploads / round | path            | uploads / s | MiB / s  | dedicated staging");
+    for (const uint32_t size : sizes)
+    {
+      const uint32_t count = std::max(1u, opt.round_size / size);
+      for (const path_desc_t& it : paths)
+      {
+        const result_t res = time_uploads(tc, it.path, source, size, count, opt.iterations);
+        cr::out().log("{:>11} | {:15} | {:15} | {:11.0f} | {:8.1f} | {}", size, count, it.name,
+                      count / res.time, (double)count * size / (1024.0 * 1024.0) / res.time, res.dedicated_count);
+      }
+    }
+
+    const hydra::staging_ring::stats_t stats = hctx.staging.get_stats();
+    cr::out().log("staging ring: {} MiB, peak occupancy: {:.1f} MiB, {} allocations, {} stalls, {} oversized requests",
+                  stats.ring_size / (1024 * 1024), stats.peak_used_bytes / (1024.0 * 1024.0), stats.allocation_count,
+                  stats.stall_count, stats.oversized_count);
+    if (stats.live_allocations != 0)
+    {
+      cr::out().error("staging ring: {} allocations are still alive after the benchmark", stats.live_allocations);
+      return false;
+    }
+    return true;
+  }
+
+  int run(int argc, char** argv)
+  {
+    upload_options opt;
+    if (!parse_options(argc, argv, opt))
+      return 1;
+    if (opt.iterations < 1)
+      opt.iterations = 1;
+    if (opt.round_size < 1)
+      opt.round_size = 1;
+
+    neam::hydra::engine_t engine;
+    if (engine.init(neam::hydra::runtime_mode::hydra_context | neam::hydra::runtime_mode::offscreen | neam::hydra::runtime_mode::offline
+                    | neam::hydra::runtime_mode::packer_less | neam::hydra::runtime_mode::release) == resources::status::failure)
+    {
+      cr::out().error("failed to create the vulkan device");
+      return 2;
+    }
+
+    return run_benchmark(engine.get_hydra_context(), opt) ? 0 : 1;
+  }
+
+  raii_register_benchmark _register { "upload", "uploads per second of the staging ring against dedicated staging buffers", &run };
+}
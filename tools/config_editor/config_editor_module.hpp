@@ -189,9 +189,8 @@ namespace neam::hydra
           }
 
           // render the UI:
-          raw_data conf_data = std::move(data.conf.conf_data);
-          data.conf.conf_data = imgui::generate_ui(conf_data, data.conf.get_hconf_metadata());
-          if (auto_save_on_change && !raw_data::is_same(conf_data, data.conf.conf_data))
+          const bool has_changed = imgui::generate_ui_in_place(data.conf.conf_data, data.conf.get_hconf_metadata());
+          if (auto_save_on_change && has_changed)
           {
             data.last_edit = std::chrono::system_clock::now();
             data.changed = true;
@@ -0,0 +1,555 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "bc_encoder.hpp"
+
+namespace neam::hydra::packer::bc
+{
+  namespace
+  {
+    struct block_t
+    {
+      uint8_t texels[16][4];
+
+      // texels outside the image (padding) are encoded, but don't count in the error
+      uint16_t valid_mask;
+    };
+
+    void fetch_block(glm::uvec2 size, const uint8_t* rgba, glm::uvec2 block, block_t& blk)
+    {
+      blk.valid_mask = 0;
+      for (uint32_t y = 0; y < 4; ++y)
+      {
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+          const glm::uvec2 texel = block * 4u + glm::uvec2(x, y);
+          const glm::uvec2 clamped = glm::min(texel, size - 1u);
+          memcpy(blk.texels[y * 4 + x], rgba + (clamped.y * size.x + clamped.x) * 4, 4);
+          if (texel.x < size.x && texel.y < size.y)
+            blk.valid_mask |= (uint16_t)(1u << (y * 4 + x));
+        }
+      }
+    }
+
+    template<glm::length_t N>
+    using vec_t = glm::vec<N, float>;
+
+    template<glm::length_t N>
+    vec_t<N> load_texel(const block_t& blk, uint32_t i)
+    {
+      vec_t<N> ret;
+      for (glm::length_t c = 0; c < N; ++c)
+        ret[c] = blk.texels[i][c];
+      return ret;
+    }
+
+    template<uint32_t ChannelCount>
+    uint32_t squared_distance(const uint8_t* a, const uint8_t* b)
+    {
+      uint32_t ret = 0;
+      for (uint32_t c = 0; c < ChannelCount; ++c)
+        ret += (uint32_t)(((int32_t)a[c] - (int32_t)b[c]) * ((int32_t)a[c] - (int32_t)b[c]));
+      return ret;
+    }
+
+    /// \brief Return the endpoints of the segment that best fits the texels of the block (bounds of the projection on the principal axis)
+    template<glm::length_t N>
+    void get_principal_axis_endpoints(const block_t& blk, vec_t<N>& e0, vec_t<N>& e1)
+    {
+      vec_t<N> mean(0.0f);
+      for (uint32_t i = 0; i < 16; ++i)
+        mean += load_texel<N>(blk, i);
+      mean /= 16.0f;
+
+      float cov[N][N] = {};
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        const vec_t<N> d = load_texel<N>(blk, i) - mean;
+        for (glm::length_t a = 0; a < N; ++a)
+          for (glm::length_t b = 0; b < N; ++b)
+            cov[a][b] += d[a] * d[b];
+      }
+
+      // power iteration:
+      vec_t<N> axis = glm::normalize(vec_t<N>(1.0f));
+      for (uint32_t it = 0; it < 8; ++it)
+      {
+        vec_t<N> next(0.0f);
+        for (glm::length_t a = 0; a < N; ++a)
+          for (glm::length_t b = 0; b < N; ++b)
+            next[a] += cov[a][b] * axis[b];
+        const float len = glm::length(next);
+        if (len < 1e-6f)
+          break;
+        axis = next / len;
+      }
+
+      float min_t = std::numeric_limits<float>::max();
+      float max_t = -std::numeric_limits<float>::max();
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        const float t = glm::dot(load_texel<N>(blk, i) - mean, axis);
+        min_t = std::min(min_t, t);
+        max_t = std::max(max_t, t);
+      }
+      e0 = glm::clamp(mean + axis * min_t, vec_t<N>(0.0f), vec_t<N>(255.0f));
+      e1 = glm::clamp(mean + axis * max_t, vec_t<N>(0.0f), vec_t<N>(255.0f));
+    }
+
+    /// \brief Least-square fit of the endpoints, given the interpolation factor of each texel
+    /// \return false if the system is degenerate (the endpoints are then unchanged)
+    template<glm::length_t N>
+    bool refine_endpoints(const block_t& blk, const float (&t)[16], vec_t<N>& e0, vec_t<N>& e1)
+    {
+      float a = 0, b = 0, c = 0;
+      vec_t<N> x0(0.0f), x1(0.0f);
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        const vec_t<N> p = load_texel<N>(blk, i);
+        a += (1 - t[i]) * (1 - t[i]);
+        b += (1 - t[i]) * t[i];
+        c += t[i] * t[i];
+        x0 += (1 - t[i]) * p;
+        x1 += t[i] * p;
+      }
+      const float det = a * c - b * b;
+      if (std::abs(det) < 1e-6f)
+        return false;
+      e0 = glm::clamp((c * x0 - b * x1) / det, vec_t<N>(0.0f), vec_t<N>(255.0f));
+      e1 = glm::clamp((a * x1 - b * x0) / det, vec_t<N>(0.0f), vec_t<N>(255.0f));
+      return true;
+    }
+
+    // LSB first bit writer (BC7 blocks)
+    struct bit_writer
+    {
+      uint8_t* data;
+      uint32_t bit = 0;
+
+      void write(uint32_t value, uint32_t count)
+      {
+        for (uint32_t i = 0; i < count; ++i, ++bit)
+        {
+          if ((value >> i) & 1)
+            data[bit / 8] |= (uint8_t)(1u << (bit % 8));
+        }
+      }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC1 (color part):
+
+    uint16_t pack_565(const glm::vec3& c)
+    {
+      const uint32_t r = (uint32_t)std::lround(c.r * 31.0f / 255.0f);
+      const uint32_t g = (uint32_t)std::lround(c.g * 63.0f / 255.0f);
+      const uint32_t b = (uint32_t)std::lround(c.b * 31.0f / 255.0f);
+      return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void unpack_565(uint16_t c, uint8_t* out)
+    {
+      const uint32_t r = (c >> 11) & 0x1F;
+      const uint32_t g = (c >> 5) & 0x3F;
+      const uint32_t b = c & 0x1F;
+      out[0] = (uint8_t)((r << 3) | (r >> 2));
+      out[1] = (uint8_t)((g << 2) | (g >> 4));
+      out[2] = (uint8_t)((b << 3) | (b >> 2));
+    }
+
+    /// \brief Encode a color block (always in 4-color mode, as required by BC3)
+    /// \return the error (over RGB) of the valid texels
+    uint64_t try_bc1_endpoints(const block_t& blk, const glm::vec3& e0, const glm::vec3& e1, uint8_t (&out)[8], uint8_t (&indices)[16])
+    {
+      uint16_t c0 = pack_565(e0);
+      uint16_t c1 = pack_565(e1);
+      if (c0 < c1)
+        std::swap(c0, c1);
+
+      uint8_t palette[4][3];
+      unpack_565(c0, palette[0]);
+      unpack_565(c1, palette[1]);
+      for (uint32_t c = 0; c < 3; ++c)
+      {
+        palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+        palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+      }
+      // when c0 == c1, the block is in 3-color mode, index 0 is the only safe one (and is exact)
+      const uint32_t palette_size = (c0 == c1) ? 1 : 4;
+
+      uint64_t error = 0;
+      uint32_t index_bits = 0;
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        uint32_t best_index = 0;
+        uint32_t best_distance = std::numeric_limits<uint32_t>::max();
+        for (uint32_t p = 0; p < palette_size; ++p)
+        {
+          const uint32_t distance = squared_distance<3>(blk.texels[i], palette[p]);
+          if (distance < best_distance)
+          {
+            best_distance = distance;
+            best_index = p;
+          }
+        }
+        indices[i] = (uint8_t)best_index;
+        index_bits |= best_index << (i * 2);
+        if ((blk.valid_mask >> i) & 1)
+          error += best_distance;
+      }
+
+      out[0] = (uint8_t)(c0 & 0xFF);
+      out[1] = (uint8_t)(c0 >> 8);
+      out[2] = (uint8_t)(c1 & 0xFF);
+      out[3] = (uint8_t)(c1 >> 8);
+      memcpy(out + 4, &index_bits, 4);
+      return error;
+    }
+
+    uint64_t encode_bc1_color(const block_t& blk, uint8_t* dst)
+    {
+      glm::vec3 e0, e1;
+      get_principal_axis_endpoints<3>(blk, e0, e1);
+
+      uint8_t block[8];
+      uint8_t indices[16];
+      uint64_t error = try_bc1_endpoints(blk, e1, e0, block, indices);
+      memcpy(dst, block, 8);
+
+      // refine the endpoints from the selected indices:
+      // (the palette is ordered: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1)
+      constexpr float k_index_to_t[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+      float t[16];
+      for (uint32_t i = 0; i < 16; ++i)
+        t[i] = k_index_to_t[indices[i]];
+      if (error > 0 && refine_endpoints<3>(blk, t, e0, e1))
+      {
+        const uint64_t refined_error = try_bc1_endpoints(blk, e0, e1, block, indices);
+        if (refined_error < error)
+        {
+          memcpy(dst, block, 8);
+          error = refined_error;
+        }
+      }
+      return error;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC4 (single channel):
+
+    uint64_t encode_bc4_channel(const block_t& blk, uint32_t channel, uint8_t* dst)
+    {
+      uint8_t min_v = 255;
+      uint8_t max_v = 0;
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        min_v = std::min(min_v, blk.texels[i][channel]);
+        max_v = std::max(max_v, blk.texels[i][channel]);
+      }
+
+      // e0 > e1: 8 values mode
+      const uint8_t e0 = max_v;
+      const uint8_t e1 = min_v;
+      uint8_t palette[8] = { e0, e1 };
+      for (uint32_t i = 2; i < 8; ++i)
+        palette[i] = (uint8_t)(((8 - i) * e0 + (i - 1) * e1) / 7);
+      const uint32_t palette_size = (e0 == e1) ? 1 : 8;
+
+      uint64_t error = 0;
+      uint64_t index_bits = 0;
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        uint32_t best_index = 0;
+        uint32_t best_distance = std::numeric_limits<uint32_t>::max();
+        for (uint32_t p = 0; p < palette_size; ++p)
+        {
+          const int32_t d = (int32_t)blk.texels[i][channel] - (int32_t)palette[p];
+          const uint32_t distance = (uint32_t)(d * d);
+          if (distance < best_distance)
+          {
+            best_distance = distance;
+            best_index = p;
+          }
+        }
+        index_bits |= (uint64_t)best_index << (i * 3);
+        if ((blk.valid_mask >> i) & 1)
+          error += best_distance;
+      }
+
+      dst[0] = e0;
+      dst[1] = e1;
+      for (uint32_t i = 0; i < 6; ++i)
+        dst[2 + i] = (uint8_t)((index_bits >> (i * 8)) & 0xFF);
+      return error;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC7 (mode 6 only: single subset, RGBA 7.7.7.7 endpoints + unique p-bits, 4-bit indices):
+
+    constexpr uint32_t k_bc7_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    /// \brief quantize an endpoint to 7 bits per channel + a p-bit (choosing the p-bit with the lowest error)
+    void quantize_bc7_mode6_endpoint(const glm::vec4& e, uint8_t (&q)[4], uint8_t& p)
+    {
+      float best_error = std::numeric_limits<float>::max();
+      for (uint8_t pbit = 0; pbit < 2; ++pbit)
+      {
+        uint8_t candidate[4];
+        float error = 0;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+          candidate[c] = (uint8_t)std::clamp<long>(std::lround((e[c] - pbit) / 2.0f), 0, 127);
+          const float d = (float)((candidate[c] << 1) | pbit) - e[c];
+          error += d * d;
+        }
+        if (error < best_error)
+        {
+          best_error = error;
+          memcpy(q, candidate, 4);
+          p = pbit;
+        }
+      }
+    }
+
+    uint64_t try_bc7_mode6_endpoints(const block_t& blk, const glm::vec4& e0, const glm::vec4& e1, uint8_t (&out)[16], uint8_t (&indices)[16])
+    {
+      uint8_t q[2][4];
+      uint8_t p[2];
+      quantize_bc7_mode6_endpoint(e0, q[0], p[0]);
+      quantize_bc7_mode6_endpoint(e1, q[1], p[1]);
+
+      uint8_t endpoints[2][4];
+      for (uint32_t e = 0; e < 2; ++e)
+        for (uint32_t c = 0; c < 4; ++c)
+          endpoints[e][c] = (uint8_t)((q[e][c] << 1) | p[e]);
+
+      uint8_t palette[16][4];
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        for (uint32_t c = 0; c < 4; ++c)
+          palette[i][c] = (uint8_t)(((64 - k_bc7_weights4[i]) * endpoints[0][c] + k_bc7_weights4[i] * endpoints[1][c] + 32) >> 6);
+      }
+
+      uint64_t error = 0;
+      for (uint32_t i = 0; i < 16; ++i)
+      {
+        uint32_t best_index = 0;
+        uint32_t best_distance = std::numeric_limits<uint32_t>::max();
+        for (uint32_t j = 0; j < 16; ++j)
+        {
+          const uint32_t distance = squared_distance<4>(blk.texels[i], palette[j]);
+          if (distance < best_distance)
+          {
+            best_distance = distance;
+            best_index = j;
+          }
+        }
+        indices[i] = (uint8_t)best_index;
+        if ((blk.valid_mask >> i) & 1)
+          error += best_distance;
+      }
+
+      // the MSB of the anchor index (texel 0) is implicitly 0: swap the endpoints if it isn't the case
+      if (indices[0] >= 8)
+      {
+        std::swap(q[0], q[1]);
+        std::swap(p[0], p[1]);
+        for (uint32_t i = 0; i < 16; ++i)
+          indices[i] = (uint8_t)(15 - indices[i]);
+      }
+
+      memset(out, 0, sizeof(out));
+      bit_writer bw { out };
+      bw.write(1u << 6, 7); // mode 6
+      for (uint32_t c = 0; c < 4; ++c)
+      {
+        bw.write(q[0][c], 7);
+        bw.write(q[1][c], 7);
+      }
+      bw.write(p[0], 1);
+      bw.write(p[1], 1);
+      bw.write(indices[0], 3);
+      for (uint32_t i = 1; i < 16; ++i)
+        bw.write(indices[i], 4);
+      return error;
+    }
+
+    uint64_t encode_bc7(const block_t& blk, uint8_t* dst)
+    {
+      glm::vec4 e0, e1;
+      get_principal_axis_endpoints<4>(blk, e0, e1);
+
+      uint8_t block[16];
+      uint8_t indices[16];
+      uint64_t error = try_bc7_mode6_endpoints(blk, e0, e1, block, indices);
+      memcpy(dst, block, 16);
+
+      // indices might have been flipped (anchor fix-up), so the refined endpoints are computed in the same space
+      if (error > 0)
+      {
+        float t[16];
+        for (uint32_t i = 0; i < 16; ++i)
+          t[i] = (float)k_bc7_weights4[indices[i]] / 64.0f;
+        if (refine_endpoints<4>(blk, t, e0, e1))
+        {
+          const uint64_t refined_error = try_bc7_mode6_endpoints(blk, e0, e1, block, indices);
+          if (refined_error < error)
+          {
+            memcpy(dst, block, 16);
+            error = refined_error;
+          }
+        }
+      }
+      return error;
+    }
+  }
+
+  bool get_format_from_name(std::string_view name, format& f)
+  {
+    for (format it : { format::none, format::bc1, format::bc3, format::bc4, format::bc5, format::bc7 })
+    {
+      if (name == get_format_name(it))
+      {
+        f = it;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::string_view get_format_name(format f)
+  {
+    switch (f)
+    {
+      case format::none: return "none";
+      case format::bc1: return "bc1";
+      case format::bc3: return "bc3";
+      case format::bc4: return "bc4";
+      case format::bc5: return "bc5";
+      case format::bc7: return "bc7";
+    }
+    return "none";
+  }
+
+  VkFormat get_vk_format(format f)
+  {
+    switch (f)
+    {
+      case format::none: return VK_FORMAT_R8G8B8A8_UNORM;
+      case format::bc1: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+      case format::bc3: return VK_FORMAT_BC3_UNORM_BLOCK;
+      case format::bc4: return VK_FORMAT_BC4_UNORM_BLOCK;
+      case format::bc5: return VK_FORMAT_BC5_UNORM_BLOCK;
+      case format::bc7: return VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+    return VK_FORMAT_R8G8B8A8_UNORM;
+  }
+
+  uint32_t get_block_size(format f)
+  {
+    switch (f)
+    {
+      case format::none: return 4;
+      case format::bc1: return 8;
+      case format::bc4: return 8;
+      case format::bc3: return 16;
+      case format::bc5: return 16;
+      case format::bc7: return 16;
+    }
+    return 4;
+  }
+
+  uint32_t get_channel_count(format f)
+  {
+    switch (f)
+    {
+      case format::none: return 4;
+      case format::bc1: return 3;
+      case format::bc3: return 4;
+      case format::bc4: return 1;
+      case format::bc5: return 2;
+      case format::bc7: return 4;
+    }
+    return 4;
+  }
+
+  uint64_t encode_block_rows(format f, glm::uvec2 size, const uint8_t* rgba, uint32_t first_block_row, uint32_t block_row_count, uint8_t* dst)
+  {
+    const uint32_t block_size = get_block_size(f);
+    const glm::uvec2 block_count = get_block_count(size);
+    const uint32_t end_block_row = std::min(block_count.y, first_block_row + block_row_count);
+
+    uint64_t error = 0;
+    block_t blk;
+    for (glm::uvec2 it { 0, first_block_row }; it.y < end_block_row; ++it.y)
+    {
+      for (it.x = 0; it.x < block_count.x; ++it.x)
+      {
+        fetch_block(size, rgba, it, blk);
+        uint8_t* const out = dst + ((uint64_t)it.y * block_count.x + it.x) * block_size;
+        switch (f)
+        {
+          case format::none:
+            break;
+          case format::bc1:
+            error += encode_bc1_color(blk, out);
+            break;
+          case format::bc3:
+            error += encode_bc4_channel(blk, 3, out);
+            error += encode_bc1_color(blk, out + 8);
+            break;
+          case format::bc4:
+            error += encode_bc4_channel(blk, 0, out);
+            break;
+          case format::bc5:
+            error += encode_bc4_channel(blk, 0, out);
+            error += encode_bc4_channel(blk, 1, out + 8);
+            break;
+          case format::bc7:
+            error += encode_bc7(blk, out);
+            break;
+        }
+      }
+    }
+    return error;
+  }
+
+  double compute_psnr(uint64_t squared_error, glm::uvec2 size, format f)
+  {
+    const uint64_t sample_count = (uint64_t)size.x * size.y * get_channel_count(f);
+    if (squared_error == 0 || sample_count == 0)
+      return std::numeric_limits<double>::infinity();
+    const double mse = (double)squared_error / (double)sample_count;
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+  }
+}
+
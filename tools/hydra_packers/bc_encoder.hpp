@@ -0,0 +1,83 @@
+//
+// created by : Timothée Feuillet
+// date: 2026-10-16
+//
+//
+// Copyright (c) 2026 Timothée Feuillet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include <vulkan/vulkan.h>
+#include <hydra_glm.hpp>
+
+namespace neam::hydra::packer::bc
+{
+  /// \brief Block-compressed formats the image packer can output
+  enum class format : uint8_t
+  {
+    none, // uncompressed (R8G8B8A8)
+
+    bc1, // RGB, 4bpp
+    bc3, // RGBA (BC1 color + BC4 alpha), 8bpp
+    bc4, // R, 4bpp
+    bc5, // RG (two BC4 blocks), 8bpp
+    bc7, // RGBA, 8bpp (only mode 6 is emitted)
+  };
+
+  /// \brief Parse a format name (`none`, `bc1`, ...). Return false if the name is unknown.
+  bool get_format_from_name(std::string_view name, format& f);
+  std::string_view get_format_name(format f);
+
+  /// \brief Return the vulkan format (VK_FORMAT_R8G8B8A8_UNORM for format::none)
+  VkFormat get_vk_format(format f);
+
+  /// \brief Size of a 4x4 block in bytes (or the size of a texel for format::none)
+  uint32_t get_block_size(format f);
+
+  /// \brief Number of channels stored by the format (used to compute the PSNR)
+  uint32_t get_channel_count(format f);
+
+  inline glm::uvec2 get_block_count(glm::uvec2 size) { return (size + 3u) / 4u; }
+
+  /// \brief Size in bytes of an image of the given size, once compressed
+  inline uint64_t get_compressed_size(format f, glm::uvec2 size)
+  {
+    if (f == format::none)
+      return (uint64_t)size.x * size.y * get_block_size(f);
+    const glm::uvec2 block_count = get_block_count(size);
+    return (uint64_t)block_count.x * block_count.y * get_block_size(f);
+  }
+
+  /// \brief Encode a range of block rows of a R8G8B8A8 image
+  /// Blocks that are on the right/bottom border are padded by repeating the border texels.
+  /// \param dst The start of the compressed image (and not of the range). Must be get_compressed_size() bytes.
+  /// \return The sum of the squared errors of the encoded texels (over the channels stored by the format)
+  uint64_t encode_block_rows(format f, glm::uvec2 size, const uint8_t* rgba, uint32_t first_block_row, uint32_t block_row_count, uint8_t* dst);
+
+  /// \brief Compute the PSNR (in dB) from a sum of squared errors. Returns +inf for a lossless encoding.
+  double compute_psnr(uint64_t squared_error, glm::uvec2 size, format f);
+}
+
@@ -25,8 +25,12 @@
 //
 
 #include "image_packer.hpp"
+#include "bc_encoder.hpp"
 
+#include <atomic>
+#include <memory>
 #include <numeric>
+#include <hydra/engine/core_context.hpp>
 #include <glm/gtc/packing.hpp>
 #include <ntools/integer_tools.hpp>
 
@@ -288,7 +292,7 @@ namespace neam::hydra::packer
 
   struct image_packer : resources::packer::packer<assets::image, image_packer>
   {
-    static constexpr id_t packer_hash = "neam/image-packer:0.0.2"_rid;
+    static constexpr id_t packer_hash = "neam/image-packer:0.2.0"_rid;
 
 
     static raw_data compute_next_mip_level(glm::uvec2 size, const raw_data& prev_mip, VkFormat vk_format)
@@ -341,7 +345,30 @@ namespace neam::hydra::packer
     }
 
 
-    static resources::packer::chain pack_resource(hydra::core_context& /*ctx*/, resources::processor::data&& data)
+    /// \brief Select a block-compressed format from the channels that are actually used by the texture
+    /// \note Only formats that sample the same as the uncompressed texture are selected (images carry no swizzle),
+    ///       except bc5 for normal maps, which are documented as requiring Z to be reconstructed in the shader.
+    ///       bc4 is only used when explicitly requested.
+    static bc::format select_compression(const image_metadata& md, const image_packer_input& in)
+    {
+      if (md.normal_map)
+        return bc::format::bc5;
+
+      bool is_opaque = true;
+      const uint8_t* texels = in.texels.get_as<uint8_t>();
+      const uint64_t texel_count = (uint64_t)in.size.x * in.size.y;
+      for (uint64_t i = 0; i < texel_count && is_opaque; ++i)
+      {
+        const uint8_t* texel = texels + i * 4;
+        is_opaque = texel[3] == 0xFF;
+      }
+
+      if (!is_opaque)
+        return bc::format::bc7;
+      return bc::format::bc1;
+    }
+
+    static resources::packer::chain pack_resource(hydra::core_context& ctx, resources::processor::data&& data)
     {
       TRACY_SCOPED_ZONE;
       const id_t root_id = get_root_id(data.resource_id);
@@ -351,9 +378,9 @@ namespace neam::hydra::packer
       // TODO: 1D/2D-layer/3D textures
       // TODO: format conversion/support
 
-//       image_metadata md = { .target_format = VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
-//       data.metadata.try_get("image"_rid, md);
-//       data.metadata.set("image"_rid, md);
+      image_metadata md;
+      data.metadata.try_get(md);
+      data.metadata.set(md);
 
       // cannot be const, data must be moved from
       rle::status rst;
@@ -365,63 +392,137 @@ namespace neam::hydra::packer
         return resources::packer::chain::create_and_complete({}, id_t::invalid, resources::status::failure);
       }
 
+      bc::format compression = bc::format::none;
+      if (md.compression == "auto")
+      {
+        compression = select_compression(md, in);
+      }
+      else if (!bc::get_format_from_name(md.compression, compression))
+      {
+        data.db.warning<image_packer>(root_id, "unknown compression format: {} (falling back to no compression)", md.compression);
+        compression = bc::format::none;
+      }
 
       assets::image root;
       root.size = glm::uvec3(in.size, 1);
-      root.format = VK_FORMAT_R8G8B8A8_UNORM;//md.target_format;
+      root.format = VK_FORMAT_R8G8B8A8_UNORM;
+      // mips are written as raw texels, so the texture_manager can stream them directly into staging memory
+      root.raw_mips = true;
 
-      std::vector<resources::packer::data> ret;
-      ret.emplace_back(); // reserve a space for the header:
+      // generate the mip-chain (always in R8G8B8A8, compression happens after):
+      struct state_t
+      {
+        std::vector<glm::uvec2> sizes;
+        std::vector<raw_data> mips;
+        std::vector<raw_data> encoded;
+        // accumulated by the encoding tasks, per mip
+        std::unique_ptr<std::atomic<uint64_t>[]> errors;
+
+        std::vector<resources::packer::data> res;
+        resources::status status = resources::status::success;
+      };
+      state_t state;
+      {
+        const uint32_t mip_count = static_cast<uint32_t>(std::floor(std::log2(std::max(root.size.x, root.size.y)))) + 1u;
+        glm::uvec2 size { root.size.x, root.size.y };
+        state.sizes.push_back(size);
+        state.mips.push_back(std::move(in.texels));
+        for (uint32_t i = 1; i < mip_count; ++i)
+        {
+          state.mips.push_back(compute_next_mip_level(size, state.mips.back(), root.format));
+          size = glm::max(glm::uvec2{1u, 1u}, (size) / 2u);
+          state.sizes.push_back(size);
+        }
+      }
 
-      resources::status status = resources::status::success;
+      root.format = bc::get_vk_format(compression);
+      state.res.emplace_back(); // reserve a space for the header:
+      for (uint32_t i = 0; i < state.mips.size(); ++i)
+      {
+        const id_t mip_id = parametrize(specialize(root_id, assets::image_mip::type_name), fmt::format("{}", i).c_str());
+        data.db.resource_name(mip_id, fmt::format("{}:{}({})", data.db.resource_name(root_id), assets::image_mip::type_name.str, i));
+        root.mips.push_back(mip_id);
+      }
 
+      if (compression == bc::format::none)
       {
-        raw_data prev_mip = raw_data::duplicate(in.texels);
+        for (uint32_t i = 0; i < state.mips.size(); ++i)
         {
-          const id_t mip_id = parametrize(specialize(root_id, assets::image_mip::type_name), "0");
-          data.db.resource_name(mip_id, fmt::format("{}:{}(0)", data.db.resource_name(root_id), assets::image_mip::type_name.str));
-          root.mips.push_back(mip_id);
-          resources::status st = resources::status::success;
-          ret.emplace_back(resources::packer::data
+          state.res.emplace_back(resources::packer::data
           {
-            .id = mip_id,
-            .data = assets::image_mip::to_raw_data( { .size = root.size, .texels = std::move(in.texels), }, st),
+            .id = root.mips[i],
+            .data = std::move(state.mips[i]),
             .metadata = {}
           });
-          status = resources::worst(status, st);
         }
+
+        resources::status st = resources::status::success;
+        state.res.front() =
         {
-          const uint32_t mip_count = static_cast<uint32_t>(std::floor(std::log2(std::max(root.size.x, root.size.y)))) + 1u;
-          glm::uvec2 size { root.size.x, root.size.y };
-          for (uint32_t i = 1; i < mip_count; ++i)
+          .id = root_id,
+          .data = assets::image::to_raw_data(root, st),
+          .metadata = std::move(data.metadata),
+        };
+        state.status = resources::worst(state.status, st);
+        return resources::packer::chain::create_and_complete(std::move(state.res), root_id, state.status);
+      }
+
+      // block-compress every mip, in parallel (chunks of block rows are dispatched as separate tasks):
+      constexpr uint32_t k_block_rows_per_task = 16;
+      std::vector<async::chain<uint32_t, uint64_t>> encode_chains;
+      state.errors = std::make_unique<std::atomic<uint64_t>[]>(state.mips.size());
+      for (uint32_t i = 0; i < state.mips.size(); ++i)
+      {
+        const glm::uvec2 size = state.sizes[i];
+        state.encoded.push_back(raw_data::allocate(bc::get_compressed_size(compression, size)));
+
+        // raw_data buffers are stable: moving the state around does not change where the texels are
+        const uint8_t* src = state.mips[i].get_as<uint8_t>();
+        uint8_t* dst = state.encoded.back().get_as<uint8_t>();
+
+        const uint32_t block_row_count = bc::get_block_count(size).y;
+        for (uint32_t first_row = 0; first_row < block_row_count; first_row += k_block_rows_per_task)
+        {
+          async::chain<uint32_t, uint64_t> chn;
+          ctx.tm.get_long_duration_task([compression, size, src, dst, i, first_row, state = chn.create_state()] mutable
           {
-            prev_mip = compute_next_mip_level(size, prev_mip, root.format);
-            size = glm::max(glm::uvec2{1u, 1u}, (size) / 2u);
-            const id_t mip_id = parametrize(specialize(root_id, assets::image_mip::type_name), fmt::format("{}", i).c_str());
-            data.db.resource_name(mip_id, fmt::format("{}:{}({})", data.db.resource_name(root_id), assets::image_mip::type_name.str, i));
-            root.mips.push_back(mip_id);
-            resources::status st = resources::status::success;
-            ret.emplace_back(resources::packer::data
-            {
-              .id = mip_id,
-              .data = assets::image_mip::to_raw_data( { .size = {size, 1}, .texels = raw_data::duplicate(prev_mip), }, st),
-              .metadata = {}
-            });
-            status = resources::worst(status, st);
-          }
+            TRACY_SCOPED_ZONE;
+            const uint64_t error = bc::encode_block_rows(compression, size, src, first_row, k_block_rows_per_task, dst);
+            state.complete(i, error);
+          });
+          encode_chains.push_back(std::move(chn));
         }
       }
 
-      resources::status st = resources::status::success;
-      ret.front() =
+      return async::multi_chain<state_t&&>(std::move(state), std::move(encode_chains), [](state_t& state, uint32_t mip_index, uint64_t error)
       {
-        .id = root_id,
-        .data = assets::image::to_raw_data(root, st),
-        .metadata = std::move(data.metadata),
-      };
-      status = resources::worst(status, st);
+        state.errors[mip_index].fetch_add(error, std::memory_order_relaxed);
+      })
+      .then([root_id, compression, root = std::move(root), &db = data.db, metadata = std::move(data.metadata)](state_t&& state) mutable
+      {
+        for (uint32_t i = 0; i < state.encoded.size(); ++i)
+        {
+          db.message<image_packer>(root_id, "mip {} ({}x{}): {} PSNR: {:.2f} dB", i, state.sizes[i].x, state.sizes[i].y,
+                                   bc::get_format_name(compression), bc::compute_psnr(state.errors[i].load(std::memory_order_relaxed), state.sizes[i], compression));
 
-      return resources::packer::chain::create_and_complete(std::move(ret), root_id, status);
+          state.res.emplace_back(resources::packer::data
+          {
+            .id = root.mips[i],
+            .data = std::move(state.encoded[i]),
+            .metadata = {}
+          });
+        }
+
+        resources::status st = resources::status::success;
+        state.res.front() =
+        {
+          .id = root_id,
+          .data = assets::image::to_raw_data(root, st),
+          .metadata = std::move(metadata),
+        };
+        state.status = resources::worst(state.status, st);
+        return resources::packer::chain::create_and_complete(std::move(state.res), root_id, state.status);
+      });
     }
   };
 }
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <string>
+
 #include <ntools/raw_data.hpp>
 #include <ntools/struct_metadata/struct_metadata.hpp>
 #include <hydra/assets/image.hpp>
@@ -49,6 +51,9 @@ namespace neam::hydra::packer
 
     VkFormat target_format = VK_FORMAT_R8G8B8A8_UNORM;
     uint32_t mip_count = 0;
+
+    std::string compression = "auto";
+    bool normal_map = false;
   };
 }
 
@@ -67,7 +72,20 @@ N_METADATA_STRUCT(neam::hydra::packer::image_metadata)
   <
     N_MEMBER_DEF(target_format, N_CUSTOM_HELPER(neam::hydra::packer::image_metadata::target_format)),
     // N_MEMBER_DEF(target_format, neam::metadata::custom_helper { .helper = "neam::hydra::packer::image_metadata::target_format"_rid}),
-    N_MEMBER_DEF(mip_count, neam::metadata::range<uint32_t>{.min = 0, .max = 127, .step = 1})
+    N_MEMBER_DEF(mip_count, neam::metadata::range<uint32_t>{.min = 0, .max = 127, .step = 1}),
+    N_MEMBER_DEF(compression, neam::metadata::info{.description = c_string_t
+    <
+      "Block-compression of the packed texture: auto, none, bc1, bc3, bc4, bc5 or bc7.\n"
+      "auto selects the format from the channels that are used by the texture (and normal_map):\n"
+      "bc5 for normal maps, bc7 if the alpha channel is used and bc1 otherwise.\n"
+      "bc4 (R only) and bc5 (RG only) are sampled as (r, 0, 0, 1) and (r, g, 0, 1): grayscale textures compressed\n"
+      "with bc4 must be sampled as .rrr by the shader, so bc4 is never selected by auto."
+    >}),
+    N_MEMBER_DEF(normal_map, neam::metadata::info{.description = c_string_t
+    <
+      "The texture is a tangent-space normal map. With auto compression, it is compressed as bc5:\n"
+      "only the R and G channels are kept and the shaders sampling it must reconstruct Z (z = sqrt(1 - x*x - y*y))."
+    >})
   >;
 };
 
@@ -26,6 +26,10 @@
 
 #include "static_mesh_packer.hpp"
 
+#include <algorithm>
+#include <memory>
+
+#include <hydra/engine/core_context.hpp>
 #include <meshoptimizer/src/meshoptimizer.h>
 #include <glm/gtc/packing.hpp>
 
@@ -33,270 +37,426 @@ namespace neam::hydra::packer
 {
   struct static_mesh_packer : resources::packer::packer<assets::static_mesh, static_mesh_packer>
   {
-    static constexpr id_t packer_hash = "neam/static-mesh-packer:0.0.1"_rid;
+    static constexpr id_t packer_hash = "neam/static-mesh-packer:0.1.0"_rid;
+
+    static constexpr size_t k_lod_count = 10;
+
+    static constexpr size_t k_max_vertices = 64;
+    static constexpr size_t k_max_triangles = 124;
+    static constexpr float k_cone_weight = 0.25f;
+
+    struct lod_state_t
+    {
+      std::vector<uint32_t> indices;
+      size_t target_index_count = 0;
+
+      // meshlets:
+      size_t meshlet_count = 0;
+      std::vector<meshopt_Meshlet> meshlets;
+      std::vector<uint32_t> meshlet_vertices;
+      std::vector<uint8_t> meshlet_triangles;
+
+      // source index of the vertices that are stored in this LOD
+      std::vector<uint32_t> claimed_vertices;
+
+      assets::static_mesh_lod lod;
+      id_t lod_id = id_t::none;
+    };
+
+    struct state_t
+    {
+      static_mesh_packer_input in;
+      std::vector<lod_state_t> lods;
+
+      std::vector<id_t> lod_ids; // from the coarsest to the finest
+      resources::status status = resources::status::success;
+    };
+
+    using state_chain = async::chain<std::unique_ptr<state_t>&&>;
+
+    /// \brief Run the function in a long-duration task
+    template<typename Fnc>
+    static async::continuation_chain dispatch(hydra::core_context& ctx, Fnc&& fnc)
+    {
+      async::continuation_chain ret;
+      ctx.tm.get_long_duration_task([fnc = std::forward<Fnc>(fnc), state = ret.create_state()] mutable
+      {
+        TRACY_SCOPED_ZONE;
+        fnc();
+        state.complete();
+      });
+      return ret;
+    }
+
+    /// \brief Forward the state once all the chains have completed
+    static state_chain wait_for(std::unique_ptr<state_t>&& state, std::vector<async::continuation_chain>&& chains)
+    {
+      if (chains.empty())
+        return state_chain::create_and_complete(std::move(state));
+      return async::multi_chain<std::unique_ptr<state_t>&&>(std::move(state), std::move(chains), [](std::unique_ptr<state_t>& /*state*/) {});
+    }
+
+    static size_t simplify_lod(const state_t& state, lod_state_t& lod, bool sloppy)
+    {
+      const std::vector<uint32_t>& lod0_indices = state.lods[0].indices;
+      const float target_error = 0.1f;
+      lod.indices.resize(lod0_indices.size(), 0);
+      size_t ret;
+      if (!sloppy)
+      {
+        ret = meshopt_simplify(lod.indices.data(), lod0_indices.data(), lod0_indices.size(),
+                               (const float*)state.in.vertices.data(), state.in.vertices.size(), sizeof(state.in.vertices[0]),
+                               lod.target_index_count, target_error,
+                               0 /* flags */,
+                               nullptr);
+      }
+      else
+      {
+        ret = meshopt_simplifySloppy(lod.indices.data(), lod0_indices.data(), lod0_indices.size(),
+                                     (const float*)state.in.vertices.data(), state.in.vertices.size(), sizeof(state.in.vertices[0]),
+                                     lod.target_index_count, target_error,
+                                     nullptr);
+      }
+      lod.indices.resize(ret);
+      return ret;
+    }
+
+    static void build_meshlets(const state_t& state, lod_state_t& lod)
+    {
+      const size_t max_meshlets = meshopt_buildMeshletsBound(lod.indices.size(), k_max_vertices, k_max_triangles);
+      lod.meshlets.resize(max_meshlets);
+      lod.meshlet_vertices.resize(max_meshlets * k_max_vertices);
+      lod.meshlet_triangles.resize(max_meshlets * k_max_triangles * 3);
+
+      lod.meshlet_count = meshopt_buildMeshlets(lod.meshlets.data(), lod.meshlet_vertices.data(), lod.meshlet_triangles.data(), lod.indices.data(),
+                                                lod.indices.size(), (const float*)state.in.vertices.data(), state.in.vertices.size(), sizeof(state.in.vertices[0]),
+                                                k_max_vertices, k_max_triangles, k_cone_weight);
+
+      const meshopt_Meshlet& last = lod.meshlets[lod.meshlet_count - 1];
+
+      lod.meshlet_vertices.resize(last.vertex_offset + last.vertex_count);
+      lod.meshlet_triangles.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3));
+      lod.meshlets.resize(lod.meshlet_count);
+
+      // compute meshlet info:
+      std::vector<assets::packed_data::meshlet_culling_data> meshlet_culling_data;
+      std::vector<assets::packed_data::meshlet_data> meshlet_data;
+      meshlet_culling_data.reserve(lod.meshlet_count);
+      meshlet_data.reserve(lod.meshlet_count);
+      for (uint32_t meshlet_index = 0; meshlet_index < lod.meshlet_count; ++meshlet_index)
+      {
+        const meshopt_Meshlet& meshlet = lod.meshlets[meshlet_index];
+        const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&lod.meshlet_vertices[meshlet.vertex_offset], &lod.meshlet_triangles[meshlet.triangle_offset],
+                                                                   meshlet.triangle_count, (const float*)state.in.vertices.data(), state.in.vertices.size(), sizeof(state.in.vertices[0]));
+        meshlet_data.push_back(
+        {
+          .vertex_offset = meshlet.vertex_offset,
+          .triangle_offset = meshlet.triangle_offset,
+          .vertex_count = (uint16_t)meshlet.vertex_count,
+          .triangle_count = (uint16_t)meshlet.triangle_count,
+        });
+        meshlet_culling_data.push_back(
+        {
+          .bounding_sphere = glm::vec4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius),
+          .cone_apex = glm::vec4(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2], 0),
+          .cone_axis_and_cutoff = glm::vec4(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2], bounds.cone_cutoff),
+        });
+      }
+      lod.lod.meshlet_culling_data = raw_data::allocate_from(meshlet_culling_data);
+      lod.lod.meshlet_data = raw_data::allocate_from(meshlet_data);
+    }
 
-    static resources::packer::chain pack_resource(hydra::core_context& /*ctx*/, resources::processor::data&& data)
+    /// \brief Repack the vertex buffers (only the vertices claimed by the LOD)
+    static raw_data pack_vertices(const state_t& state, const lod_state_t& lod)
+    {
+      const static_mesh_packer_input& in = state.in;
+      std::vector<assets::packed_data::vertex_data> packed_vertex_data;
+      packed_vertex_data.reserve(lod.claimed_vertices.size());
+      for (const uint32_t src_vertex_index : lod.claimed_vertices)
+      {
+        const vertex_data& vertex = in.vertices[src_vertex_index];
+        packed_vertex_data.push_back(
+        {
+          .position_tbn =
+          {
+            std::bit_cast<glm::uvec3>(vertex.position),
+            std::bit_cast<uint32_t>(glm::pack_tbn(vertex.tangent, vertex.bitangent, vertex.normal))
+          },
+        });
+        assets::packed_data::vertex_data& packed_vertex = packed_vertex_data.back();
+        // write extra colors/uv:
+        uint32_t offset = 0;
+        uint32_t sub_offset = 0;
+        for (uint32_t data_index = 0; data_index < in.data.size() && offset < assets::packed_data::vertex_data::k_data_size; ++data_index)
+        {
+          if (!in.data[data_index].is_vec2)
+          {
+            // FIXME: expects sub_offset to be 0.
+            packed_vertex.data[offset] = glm::packHalf(in.data[data_index].data[src_vertex_index]);
+            ++offset;
+          }
+          else
+          {
+            glm::u16vec2 d = glm::packUnorm<uint16_t>(glm::vec2{in.data[data_index].data[src_vertex_index]});
+            if (sub_offset == 0)
+            {
+              packed_vertex.data[offset].z = d.x;
+              packed_vertex.data[offset].w = d.y;
+              sub_offset += 2;
+            }
+            else
+            {
+              packed_vertex.data[offset].x = d.x;
+              packed_vertex.data[offset].y = d.y;
+              sub_offset = 0;
+              ++offset;
+            }
+          }
+        }
+
+        // write material data:
+        packed_vertex.data[assets::packed_data::vertex_data::k_data_size - 1].w = vertex.material_index;
+      }
+      return raw_data::allocate_from(packed_vertex_data);
+    }
+
+    /// \brief Return an empty raw_data on failure
+    static raw_data encode_vertex_buffer(const raw_data& data, size_t element_size)
+    {
+      const size_t element_count = data.size / element_size;
+      raw_data out = raw_data::allocate(meshopt_encodeVertexBufferBound(element_count, element_size));
+      out.size = meshopt_encodeVertexBuffer((uint8_t*)out.data.get(), out.size, data.data.get(), element_count, element_size);
+      return out;
+    }
+
+    /// \brief Return an empty raw_data on failure
+    static raw_data encode_index_sequence(const raw_data& data)
+    {
+      const size_t index_count = data.size / sizeof(uint32_t);
+      const uint32_t* indices = (const uint32_t*)data.data.get();
+      const uint32_t max_index = index_count > 0 ? *std::max_element(indices, indices + index_count) : 0;
+      raw_data out = raw_data::allocate(meshopt_encodeIndexSequenceBound(index_count, (size_t)max_index + 1));
+      out.size = meshopt_encodeIndexSequence((uint8_t*)out.data.get(), out.size, indices, index_count);
+      return out;
+    }
+
+    /// \brief Encode the buffers of the LOD with the meshoptimizer codecs. The buffers are left untouched on failure.
+    static bool encode_lod(assets::static_mesh_lod& lod)
+    {
+      if ((lod.meshlet_index_data.size % 4) != 0)
+        return false;
+
+      raw_data vertex_data = encode_vertex_buffer(lod.vertex_data, sizeof(assets::packed_data::vertex_data));
+      raw_data vertex_indirection_data = encode_index_sequence(lod.vertex_indirection_data);
+      raw_data meshlet_index_data = encode_vertex_buffer(lod.meshlet_index_data, 4);
+      raw_data meshlet_data = encode_vertex_buffer(lod.meshlet_data, sizeof(assets::packed_data::meshlet_data));
+      raw_data meshlet_culling_data = encode_vertex_buffer(lod.meshlet_culling_data, sizeof(assets::packed_data::meshlet_culling_data));
+      if (vertex_data.size == 0 || vertex_indirection_data.size == 0 || meshlet_index_data.size == 0 || meshlet_data.size == 0 || meshlet_culling_data.size == 0)
+        return false;
+
+      lod.vertex_data = std::move(vertex_data);
+      lod.vertex_indirection_data = std::move(vertex_indirection_data);
+      lod.meshlet_index_data = std::move(meshlet_index_data);
+      lod.meshlet_data = std::move(meshlet_data);
+      lod.meshlet_culling_data = std::move(meshlet_culling_data);
+      lod.codec = assets::static_mesh_lod_codec::meshopt;
+      return true;
+    }
+
+    static resources::packer::chain pack_resource(hydra::core_context& ctx, resources::processor::data&& data)
     {
       TRACY_SCOPED_ZONE;
       const id_t root_id = get_root_id(data.resource_id);
       data.db.resource_name(root_id, get_root_name(data.db, data.resource_id));
 
-      // final resources:
-      assets::static_mesh root;
-      std::vector<assets::static_mesh_lod> lods;
-      resources::status status = resources::status::success;
-
-      // generate the lods + meshlets:
+      // the state is heap-allocated so that the tasks can reference it while it's moved along the chains
+      std::unique_ptr<state_t> state = std::make_unique<state_t>();
       {
-        static_mesh_packer_input in;
-        const rle::status rst = rle::in_place_deserialize(std::move(data.data), in);
+        const rle::status rst = rle::in_place_deserialize(std::move(data.data), state->in);
         if (rst == rle::status::failure)
         {
           data.db.error<static_mesh_packer>(root_id, "failed to deserialize processor data");
           return resources::packer::chain::create_and_complete({}, id_t::invalid, resources::status::failure);
         }
+      }
 
-        root.bounding_sphere = in.bounding_sphere,
-
-        data.db.message<static_mesh_packer>(root_id, "LOD {}: {} tri", 0, in.indices.size() / 3);
+      data.db.message<static_mesh_packer>(root_id, "LOD {}: {} tri", 0, state->in.indices.size() / 3);
 
-        std::vector<std::vector<uint32_t>> lod_indices;
+      // push LOD 0
+      state->lods.resize(k_lod_count);
+      state->lods[0].indices = std::move(state->in.indices);
+      state->lods[0].target_index_count = state->lods[0].indices.size();
 
-        // push LOD 0
-        lod_indices.emplace_back(std::move(in.indices));
+      // generate LODs: (all of them are generated from LOD 0, so they can be done in parallel)
+      std::vector<async::continuation_chain> chains;
+      const size_t lod0_index_count = state->lods[0].indices.size();
+      for (uint32_t lod_index = 1; lod_index < k_lod_count; ++lod_index)
+      {
+        state->lods[lod_index].target_index_count = lod0_index_count - (lod0_index_count / k_lod_count) * lod_index;
+        chains.push_back(dispatch(ctx, [st = state.get(), lod_index]
+        {
+          simplify_lod(*st, st->lods[lod_index], false);
+        }));
+      }
 
-        // generate LODs:
-        constexpr size_t k_lod_count = 10;
+      return wait_for(std::move(state), std::move(chains))
+      .then([&ctx, &db = data.db, root_id](std::unique_ptr<state_t>&& state)
+      {
+        // when the simplifier stops making progress, switch to the sloppy simplifier for this LOD and the following ones
+        std::vector<async::continuation_chain> chains;
         bool use_sloppy_simplifier = false;
-        size_t previous_index_count = lod_indices[0].size();
         for (uint32_t lod_index = 1; lod_index < k_lod_count; ++lod_index)
         {
-          std::vector<uint32_t>& new_indices = lod_indices.emplace_back();
-          new_indices.resize(lod_indices[0].size(), 0);
-          const size_t target_index_count = lod_indices[0].size() - (lod_indices[0].size() / k_lod_count) * lod_index;
-          const float target_error = 0.1f;
-          size_t ret = 0;
-          if (!use_sloppy_simplifier)
+          if (!use_sloppy_simplifier && state->lods[lod_index].indices.size() == state->lods[lod_index - 1].indices.size())
           {
-            ret = meshopt_simplify(new_indices.data(), lod_indices[0].data(), lod_indices[0].size(),
-                                          (const float*)in.vertices.data(), in.vertices.size(), sizeof(in.vertices[0]),
-                                          target_index_count, target_error,
-                                          0 /* flags */,
-                                          nullptr);
-            if (ret == previous_index_count)
-            {
-              data.db.warning<static_mesh_packer>(root_id, "LOD {}: failed to generate LOD, switching to sloppy simplifier", lod_index);
-              use_sloppy_simplifier = true;
-            }
-            previous_index_count = ret;
+            db.warning<static_mesh_packer>(root_id, "LOD {}: failed to generate LOD, switching to sloppy simplifier", lod_index);
+            use_sloppy_simplifier = true;
           }
           if (use_sloppy_simplifier)
           {
-            ret = meshopt_simplifySloppy(new_indices.data(), lod_indices[0].data(), lod_indices[0].size(),
-                                          (const float*)in.vertices.data(), in.vertices.size(), sizeof(in.vertices[0]),
-                                          target_index_count, target_error,
-                                          nullptr);
+            chains.push_back(dispatch(ctx, [st = state.get(), lod_index]
+            {
+              simplify_lod(*st, st->lods[lod_index], true);
+            }));
           }
-
-          new_indices.resize(ret);
-          data.db.message<static_mesh_packer>(root_id, "LOD {}: {} tri (target: {})", lod_index, ret / 3, target_index_count / 3);
         }
-
-        // vertex data optim: (TODO!)
-        // might not be necessary, but should help a bit the meshlets
+        return wait_for(std::move(state), std::move(chains));
+      })
+      .then([&ctx, &db = data.db, root_id](std::unique_ptr<state_t>&& state)
+      {
+        // generate the meshlets:
+        std::vector<async::continuation_chain> chains;
+        for (uint32_t lod_index = 0; lod_index < k_lod_count; ++lod_index)
         {
-          // std::vector<uint32_t> com;
-          // for (uint32_t rev_lod_index = 0; rev_lod_index < k_lod_count; ++rev_lod_index)
-          // {
-          //   const uint32_t lod_index = rev_lod_index - k_lod_count - 1;
-          //   meshopt_optimizeVertexCache(lod_indices[lod_index].data(), lod_indices[lod_index].data(), lod_indices[lod_index].size(), in.vertices.size());
-          //
-          // }
+          if (lod_index > 0)
+          {
+            db.message<static_mesh_packer>(root_id, "LOD {}: {} tri (target: {})", lod_index,
+                                           state->lods[lod_index].indices.size() / 3, state->lods[lod_index].target_index_count / 3);
+          }
+          // skip invalid LODs
+          if (state->lods[lod_index].indices.size() == 0)
+            continue;
+          chains.push_back(dispatch(ctx, [st = state.get(), lod_index]
+          {
+            build_meshlets(*st, st->lods[lod_index]);
+          }));
         }
-
+        return wait_for(std::move(state), std::move(chains));
+      })
+      .then([&ctx, &db = data.db, root_id](std::unique_ptr<state_t>&& state)
+      {
+        // repack vertex buffers (only store vertices that aren't present in any other LOD), repack index buffer (reference to vertices from other LODs)
+        // The claim of the vertices is done from the coarsest to the finest LOD, so it cannot be parallelized,
+        // but the packing/encoding of the vertices can.
+        std::vector<async::continuation_chain> chains;
         std::vector<uint32_t> vertex_indirection;
-        vertex_indirection.resize(in.vertices.size(), ~0u);
+        vertex_indirection.resize(state->in.vertices.size(), ~0u);
         for (uint32_t rev_lod_index = 0; rev_lod_index < k_lod_count; ++rev_lod_index)
         {
           const uint32_t lod_index = k_lod_count - rev_lod_index - 1;
+          lod_state_t& lod = state->lods[lod_index];
           // skip invalid LODs
-          if (lod_indices[lod_index].size() == 0)
+          if (lod.indices.size() == 0)
             continue;
 
-          constexpr size_t max_vertices = 64;
-          constexpr size_t max_triangles = 124;
-          constexpr float cone_weight = 0.25f;
-
-          // generate meshlets
-          const size_t max_meshlets = meshopt_buildMeshletsBound(lod_indices[lod_index].size(), max_vertices, max_triangles);
-          std::vector<meshopt_Meshlet> meshlets(max_meshlets);
-          std::vector<uint32_t> meshlet_vertices(max_meshlets * max_vertices);
-          std::vector<uint8_t> meshlet_triangles(max_meshlets * max_triangles * 3);
-
-          const size_t meshlet_count = meshopt_buildMeshlets(meshlets.data(), meshlet_vertices.data(), meshlet_triangles.data(), lod_indices[lod_index].data(),
-          lod_indices[lod_index].size(), (const float*)in.vertices.data(), in.vertices.size(), sizeof(in.vertices[0]), max_vertices, max_triangles, cone_weight);
-
-          const meshopt_Meshlet& last = meshlets[meshlet_count - 1];
-
-          meshlet_vertices.resize(last.vertex_offset + last.vertex_count);
-          meshlet_triangles.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3));
-          meshlets.resize(meshlet_count);
-
-
           // Push/create LOD entry:
-          const id_t lod_id = parametrize(specialize(root_id, assets::static_mesh_lod::type_name), fmt::to_string(lod_index));
-          data.db.resource_name(lod_id, fmt::format("{}:{}({})", data.db.resource_name(root_id), assets::static_mesh_lod::type_name.str, lod_index));
+          lod.lod_id = parametrize(specialize(root_id, assets::static_mesh_lod::type_name), fmt::to_string(lod_index));
+          db.resource_name(lod.lod_id, fmt::format("{}:{}({})", db.resource_name(root_id), assets::static_mesh_lod::type_name.str, lod_index));
 
-          assets::static_mesh_lod& lod = lods.emplace_back();
-          root.lods.push_back(lod_id);
+          // index of the LOD in root.lods (used by the vertex indirection)
+          const uint32_t lod_position = (uint32_t)state->lod_ids.size();
+          state->lod_ids.push_back(lod.lod_id);
 
-          // compute meshlet info:
+          for (uint32_t i = 0; i < lod.meshlet_vertices.size(); ++i)
           {
-            std::vector<assets::packed_data::meshlet_culling_data> meshlet_culling_data;
-            std::vector<assets::packed_data::meshlet_data> meshlet_data;
-            for (uint32_t meshlet_index = 0; meshlet_index < meshlet_count; ++meshlet_index)
-            {
-              const meshopt_Meshlet& meshlet = meshlets[meshlet_index];
-              const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshlet_vertices[meshlet.vertex_offset], &meshlet_triangles[meshlet.triangle_offset],
-                                                meshlet.triangle_count, (float*)in.vertices.data(), in.vertices.size(), sizeof(in.vertices[0]));
-              meshlet_data.push_back(
-              {
-                .vertex_offset = meshlet.vertex_offset,
-                .triangle_offset = meshlet.triangle_offset,
-                .vertex_count = (uint16_t)meshlet.vertex_count,
-                .triangle_count = (uint16_t)meshlet.triangle_count,
-              });
-              meshlet_culling_data.push_back(
-              {
-                .bounding_sphere = glm::vec4(bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius),
-                .cone_apex = glm::vec4(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2], 0),
-                .cone_axis_and_cutoff = glm::vec4(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2], bounds.cone_cutoff),
-              });
-            }
-            lod.meshlet_culling_data = raw_data::allocate_from(meshlet_culling_data);
-            lod.meshlet_data = raw_data::allocate_from(meshlet_data);
-          }
-
-          // repack vertex buffers (only store vertices that aren't present in any other LOD), repack index buffer (reference to vertices from other LODs)
-          // (done last, so we can use the meshlet_vertices where it's needed)
-          std::vector<vertex_data> lod_vertices;
-          std::vector<vertex_data_stream> lod_data;
-          lod_data.resize(in.data.size());
-          for (uint32_t i = 0; i < meshlet_vertices.size(); ++i)
-          {
-            const uint32_t vertex_index = meshlet_vertices[i];
+            const uint32_t vertex_index = lod.meshlet_vertices[i];
             // We are the first to claim this vertex
             if (vertex_indirection[vertex_index] == ~0u)
             {
               // Claim the vertex
-              vertex_indirection[vertex_index] = lod_index << 24 | (uint32_t)lod_vertices.size();
-
-              // Add the vertex to this LOD
-              lod_vertices.emplace_back(in.vertices[vertex_index]);
-              for (uint32_t data_index = 0; data_index < lod_data.size(); ++data_index)
-                lod_data[data_index].data.emplace_back(in.data[data_index].data[vertex_index]);
+              vertex_indirection[vertex_index] = lod_position << 24 | (uint32_t)lod.claimed_vertices.size();
+              lod.claimed_vertices.push_back(vertex_index);
             }
 
             // use the generic vertex indirection
-            meshlet_vertices[i] = vertex_indirection[vertex_index];
+            lod.meshlet_vertices[i] = vertex_indirection[vertex_index];
           }
 
           // TODO: cpu-side add counts (in root), so we can pre-size the buffers correctly while the data is loading?
 
-          lod.meshlet_index_data = raw_data::allocate_from(meshlet_triangles);
-          lod.vertex_indirection_data = raw_data::allocate_from(meshlet_vertices);
-
-          lod.lod_data = raw_data::duplicate(assets::packed_data::lod_data
-          {
-            .meshlet_count = (uint32_t)meshlet_count
-          });
-
-          // compress the vertex data:
+          chains.push_back(dispatch(ctx, [st = state.get(), lod_index, &db, root_id]
           {
-            std::vector<assets::packed_data::vertex_data> packed_vertex_data;
-            packed_vertex_data.reserve(lod_vertices.size());
-            for (uint32_t vertex_index = 0; vertex_index < lod_vertices.size(); ++vertex_index)
+            lod_state_t& lod = st->lods[lod_index];
+            lod.lod.meshlet_index_data = raw_data::allocate_from(lod.meshlet_triangles);
+            lod.lod.vertex_indirection_data = raw_data::allocate_from(lod.meshlet_vertices);
+            lod.lod.lod_data = raw_data::duplicate(assets::packed_data::lod_data
             {
-              const vertex_data& vertex = lod_vertices[vertex_index];
-              packed_vertex_data.push_back(
-              {
-                .position_tbn =
-                {
-                  std::bit_cast<glm::uvec3>(lod_vertices[vertex_index].position),
-                  std::bit_cast<uint32_t>(glm::pack_tbn(vertex.tangent, vertex.bitangent, vertex.normal))
-                },
-              });
-              assets::packed_data::vertex_data& packed_vertex = packed_vertex_data.back();
-              // write extra colors/uv:
-              uint32_t offset = 0;
-              uint32_t sub_offset = 0;
-              for (uint32_t data_index = 0; data_index < in.data.size() && offset < assets::packed_data::vertex_data::k_data_size; ++data_index)
-              {
-                if (!in.data[data_index].is_vec2)
-                {
-                  // FIXME: expects sub_offset to be 0.
-                  packed_vertex.data[offset] = glm::packHalf(lod_data[data_index].data[vertex_index]);
-                  ++offset;
-                }
-                else
-                {
-                  glm::u16vec2 d = glm::packUnorm<uint16_t>(glm::vec2{lod_data[data_index].data[vertex_index]});
-                  if (sub_offset == 0)
-                  {
-                    packed_vertex.data[offset].z = d.x;
-                    packed_vertex.data[offset].w = d.y;
-                    sub_offset += 2;
-                  }
-                  else
-                  {
-                    packed_vertex.data[offset].x = d.x;
-                    packed_vertex.data[offset].y = d.y;
-                    sub_offset = 0;
-                    ++offset;
-                  }
-                }
-              }
-
-              // write material data:
-              packed_vertex.data[assets::packed_data::vertex_data::k_data_size - 1].w = vertex.material_index;
-            }
-            lod.vertex_data = raw_data::allocate_from(packed_vertex_data);
-          }
-
-          data.db.message<static_mesh_packer>(root_id, "LOD {}: {} meshlets, {} vertices, memory size: {:.3f}Mib",
-                                              lod_index, meshlet_count, lod_vertices.size(),
-                                              lod.total_memory_size() / 1024.0f / 1024.0f);
+              .meshlet_count = (uint32_t)lod.meshlet_count
+            });
+            lod.lod.vertex_data = pack_vertices(*st, lod);
+
+            lod.lod.vertex_count = (uint32_t)lod.claimed_vertices.size();
+            lod.lod.vertex_indirection_count = (uint32_t)lod.meshlet_vertices.size();
+            lod.lod.meshlet_index_size = (uint32_t)lod.meshlet_triangles.size();
+            lod.lod.meshlet_count = (uint32_t)lod.meshlet_count;
+
+            const size_t raw_size = lod.lod.total_memory_size();
+            if (!encode_lod(lod.lod))
+              db.warning<static_mesh_packer>(root_id, "LOD {}: failed to encode the LOD buffers, storing them as-is", lod_index);
+
+            db.message<static_mesh_packer>(root_id, "LOD {}: {} meshlets, {} vertices, memory size: {:.3f}Mib (encoded: {:.3f}Mib)",
+                                           lod_index, lod.meshlet_count, lod.claimed_vertices.size(),
+                                           raw_size / 1024.0f / 1024.0f, lod.lod.total_memory_size() / 1024.0f / 1024.0f);
+
+            // free-up the memory a bit
+            lod.indices = {};
+            lod.meshlets = {};
+            lod.meshlet_vertices = {};
+            lod.meshlet_triangles = {};
+            lod.claimed_vertices = {};
+          }));
         }
-
-        // all the temp data is freed there
-      }
-
-      // serialize everything + create sub-resources
-      std::vector<resources::packer::data> ret;
+        return wait_for(std::move(state), std::move(chains));
+      })
+      .then([root_id, metadata = std::move(data.metadata)](std::unique_ptr<state_t>&& state) mutable
       {
-        resources::status st = resources::status::success;
-        ret.emplace_back(resources::packer::data
+        // final resources:
+        assets::static_mesh root
         {
-          .id = root_id,
-          .data = assets::static_mesh::to_raw_data(root, st),
-          .metadata = std::move(data.metadata),
-        });
-        status = resources::worst(status, st);
-      }
-      for (uint32_t i = 0; i < lods.size(); ++i)
-      {
-        resources::status st = resources::status::success;
-        ret.emplace_back(resources::packer::data
+          .lods = std::move(state->lod_ids),
+          .bounding_sphere = state->in.bounding_sphere,
+        };
+
+        // serialize everything + create sub-resources
+        std::vector<resources::packer::data> ret;
         {
-          .id = root.lods[i],
-          .data = assets::static_mesh_lod::to_raw_data(lods[i], st),
-          .metadata = {},
-        });
-        lods[i] = {}; // free-up the memory a bit
-        status = resources::worst(status, st);
-      }
-      return resources::packer::chain::create_and_complete(std::move(ret), root_id, status);
+          resources::status st = resources::status::success;
+          ret.emplace_back(resources::packer::data
+          {
+            .id = root_id,
+            .data = assets::static_mesh::to_raw_data(root, st),
+            .metadata = std::move(metadata),
+          });
+          state->status = resources::worst(state->status, st);
+        }
+        // root.lods is from the coarsest to the finest LOD
+        for (uint32_t rev_lod_index = 0; rev_lod_index < k_lod_count; ++rev_lod_index)
+        {
+          lod_state_t& lod = state->lods[k_lod_count - rev_lod_index - 1];
+          if (lod.lod_id == id_t::none)
+            continue;
+          resources::status st = resources::status::success;
+          ret.emplace_back(resources::packer::data
+          {
+            .id = lod.lod_id,
+            .data = assets::static_mesh_lod::to_raw_data(lod.lod, st),
+            .metadata = {},
+          });
+          lod.lod = {}; // free-up the memory a bit
+          state->status = resources::worst(state->status, st);
+        }
+        return resources::packer::chain::create_and_complete(std::move(ret), root_id, state->status);
+      });
     }
   };
 }
-
@@ -47,6 +47,7 @@ namespace neam
     bool ui = true;
     bool print_source_name = false;
     uint32_t watch_delay = 2;
+    uint32_t listen_port = 0;
     uint32_t thread_count = std::thread::hardware_concurrency() + 4;
 
     std::vector<std::string_view> parameters;
@@ -74,6 +75,7 @@ N_METADATA_STRUCT(neam::global_options)
     N_MEMBER_DEF(ui, neam::metadata::info{.description = c_string_t<"Launch in graphical mode.\nWill only open the window after imgui shaders are successfuly packed.">}),
     N_MEMBER_DEF(print_source_name, neam::metadata::info{.description = c_string_t<"Will print file names that are being imported.">}),
     N_MEMBER_DEF(watch_delay, neam::metadata::info{.description = c_string_t<"Sleep duration when no changes are detected.">}),
+    N_MEMBER_DEF(listen_port, neam::metadata::info{.description = c_string_t<"Serve the resources over the network on this port (0 to disable).\nGame clients can then use resources::context::connect instead of a local index.">}),
     N_MEMBER_DEF(thread_count, neam::metadata::info{.description = c_string_t<"Number of thread the task manager will launch.">})
   >;
 };
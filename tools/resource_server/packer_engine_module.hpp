@@ -30,6 +30,7 @@
 #include <ntools/event.hpp>
 
 #include <hydra/resources/resources.hpp>
+#include <hydra/resources/network/server.hpp>
 #include <hydra/hydra_debug.hpp>
 #include <hydra/engine/engine.hpp>
 #include <hydra/engine/engine_module.hpp>
@@ -95,8 +96,35 @@ namespace neam::hydra
 
       void on_engine_boot_complete() override
       {
+        // watch the source folder, so we don't have to scan it every time
+        if (packer_options.watch)
+        {
+          source_watch = cctx->fsw.watch_directory(packer_options.source_folder, [this](std::vector<fs_watcher::event_t>&& events)
+          {
+            on_source_changes(std::move(events));
+          }, true /* recursive */);
+        }
+
+        if (packer_options.listen_port != 0)
+        {
+          res_server = std::make_unique<resources::network::server>(cctx->res);
+          if (!res_server->listen((uint16_t)packer_options.listen_port))
+            res_server.reset();
+
+          // clients have to know when resources have changed
+          on_index_saved_tk = on_index_saved.add([this](resources::status)
+          {
+            if (res_server)
+              res_server->broadcast_index_reloaded();
+          });
+        }
+
         cctx->tm.set_start_task_group_callback("pack"_rid, [this]
         {
+          // send the pending parts of the big responses
+          if (res_server)
+            res_server->update();
+
           // update configuration:
           engine->get_module<io_module>("io"_rid)->wait_for_submit_queries = stall_task_manager;
 //           cctx->io.force_deferred_execution(&cctx->tm, /*threading::k_non_transient_task_group*/cctx->tm.get_group_id("io"_rid));
@@ -115,6 +143,59 @@ namespace neam::hydra
       {
       }
 
+      void on_start_shutdown() override
+      {
+        if (res_server)
+          res_server->stop();
+      }
+
+      void on_shutdown() override
+      {
+        cctx->fsw.remove_watch(source_watch);
+        source_watch = id_t::invalid;
+        on_index_saved_tk.release();
+        res_server.reset();
+      }
+
+      void on_source_changes(std::vector<fs_watcher::event_t>&& events)
+      {
+        // remove path and everything under it (directories)
+        const auto erase_path = [](std::set<std::filesystem::path>& set, const std::filesystem::path& path)
+        {
+          for (auto it = set.lower_bound(path); it != set.end();)
+          {
+            if (std::mismatch(path.begin(), path.end(), it->begin(), it->end()).first != path.end())
+              break;
+            it = set.erase(it);
+          }
+        };
+
+        std::lock_guard _l(source_changes_lock);
+        for (auto& it : events)
+        {
+          switch (it.type)
+          {
+            case fs_watcher::event_type::overflow:
+              need_full_scan = true;
+              break;
+            case fs_watcher::event_type::removed:
+              erase_path(known_sources, it.path);
+              erase_path(changed_sources, it.path);
+              has_removed_sources = true;
+              break;
+            case fs_watcher::event_type::created:
+            case fs_watcher::event_type::modified:
+              // the content of new directories is reported separately
+              if (!it.is_directory)
+              {
+                known_sources.insert(it.path);
+                changed_sources.insert(std::move(it.path));
+              }
+              break;
+          }
+        }
+      }
+
       void queue_import_resource(uint32_t index)
       {
         if (index >= state.to_import.size())
@@ -153,6 +234,26 @@ namespace neam::hydra
         if (chrono.get_accumulated_time() < packer_options.watch_delay && !packer_options.force && !initial_round)
           return;
 
+        // grab the changes reported by the fs watcher. Only scan the whole source folder when necessary.
+        bool do_full_scan = initial_round || packer_options.force || source_watch == id_t::invalid;
+        std::set<std::filesystem::path> changed_files;
+        std::deque<std::filesystem::path> known_files;
+        {
+          std::lock_guard _l(source_changes_lock);
+          do_full_scan = do_full_scan || need_full_scan;
+          if (!do_full_scan && changed_sources.empty() && !has_removed_sources)
+          {
+            // nothing to be done
+            cctx->stall_all_threads_except(2);
+            return;
+          }
+          need_full_scan = false;
+          has_removed_sources = false;
+          changed_files.swap(changed_sources);
+          if (!do_full_scan)
+            known_files.assign(known_sources.begin(), known_sources.end());
+        }
+
         std::set<std::filesystem::path> packer_proc_dirty_files;
         if (initial_round)
           packer_proc_dirty_files = cctx->res.get_sources_needing_reimport();
@@ -166,7 +267,20 @@ namespace neam::hydra
         index_file_id = cctx->io.map_unprefixed_file(packer_options.index);
 
 
-        std::deque<std::filesystem::path> all_files = neam::fs_tools::get_all_files(packer_options.source_folder);
+        std::deque<std::filesystem::path> all_files;
+        if (do_full_scan)
+        {
+          all_files = neam::fs_tools::get_all_files(packer_options.source_folder);
+
+          std::lock_guard _l(source_changes_lock);
+          known_sources = std::set<std::filesystem::path>(all_files.begin(), all_files.end());
+          // keep the files that have been reported during the scan (they will be handled in the next round)
+          known_sources.insert(changed_sources.begin(), changed_sources.end());
+        }
+        else
+        {
+          all_files = std::move(known_files);
+        }
 
         // filter mod files
         std::deque<std::filesystem::path> mod_files;
@@ -179,8 +293,10 @@ namespace neam::hydra
 
         if (do_force)
           mod_files = all_files;
-        else
+        else if (do_full_scan)
           mod_files = neam::fs_tools::filter_files_newer_than(all_files, packer_options.source_folder, fs_tools::get_oldest_timestamp(packer_options.ts_file, packer_options.index));
+        else
+          mod_files.assign(changed_files.begin(), changed_files.end());
 
         if (!do_force)
         {
@@ -311,6 +427,13 @@ namespace neam::hydra
           async::multi_chain(std::move(state.gbl_chains))
           .then([this]
           {
+            if (const resources::build_cache& cache = cctx->res.get_build_cache(); cache.is_enabled())
+            {
+              const resources::build_cache::stats_t stats = cache.get_stats();
+              cr::out().log("build cache: hit ratio: {:.1f}% ({} hits, {} misses), saved time: {:.3f}s",
+                            stats.hit_ratio() * 100, stats.hit_count, stats.miss_count, stats.saved_time);
+            }
+
             if (state.need_save)
             {
               // Assign the metadata types from this binary to the rel-db
@@ -368,6 +491,17 @@ namespace neam::hydra
       cr::chrono chrono;
       bool initial_round = true;
 
+      // source folder watch:
+      id_t source_watch = id_t::invalid;
+      spinlock source_changes_lock;
+      std::set<std::filesystem::path> known_sources; // all the files in the source folder (relative to it)
+      std::set<std::filesystem::path> changed_sources; // created / modified since the last pack
+      bool has_removed_sources = false;
+      bool need_full_scan = false;
+
+      std::unique_ptr<resources::network::server> res_server;
+      cr::event_token_t on_index_saved_tk;
+
       struct packer_state_t
       {
         bool in_progress = false;
@@ -182,13 +182,8 @@ namespace neam::hydra
           {
             if (resource_ctx_conf.is_loaded())
             {
-              const raw_data& initial_rd = resource_ctx_conf.conf_data;
-              raw_data new_rd = imgui::generate_ui(initial_rd, rle::deserialize<rle::serialization_metadata>(resource_ctx_conf.get_hconf_metadata()));
-              if (!raw_data::is_same(initial_rd, new_rd))
-              {
-                resource_ctx_conf.conf_data = std::move(new_rd);
+              if (imgui::generate_ui_in_place(resource_ctx_conf.conf_data, resource_ctx_conf.get_hconf_metadata()))
                 cctx->hconf.write_conf(resource_ctx_conf);
-              }
             }
             else
             {
@@ -292,6 +287,19 @@ namespace neam::hydra
               ImGui::PopStyleColor();
             }
 
+            if (const resources::build_cache& cache = cctx->res.get_build_cache(); cache.is_enabled())
+            {
+              const resources::build_cache::stats_t stats = cache.get_stats();
+              ImGui::Text("build cache: hit ratio: %.1f%% (%u hits, %u misses), saved time: %.3fs",
+                          stats.hit_ratio() * 100, (uint32_t)stats.hit_count, (uint32_t)stats.miss_count, stats.saved_time);
+              ImGui::Text("build cache: read: %.3f Mb, written: %.3f Mb (%u entries stored)",
+                          stats.read_bytes / 1024.0f / 1024.0f, stats.written_bytes / 1024.0f / 1024.0f, (uint32_t)stats.store_count);
+            }
+            else
+            {
+              ImGui::TextUnformatted("build cache: disabled");
+            }
+
             if (ImGui::BeginChildFrame(ImGui::GetID("log frame"), ImVec2(-1, -1), ImGuiWindowFlags_AlwaysHorizontalScrollbar))
             {
               std::lock_guard _l(res_lock);